@@ -24,6 +24,8 @@
 #include "bolt/countof.h"
 #include "bolt/cl/reduce.h"
 
+#include <boost/scoped_array.hpp>
+
 const std::streamsize colWidth = 26;
 #define BOLT_BENCHMARK_DEBUG 1
 
@@ -57,6 +59,8 @@ int _tmain( int argc, _TCHAR* argv[] )
     bool runTBB = false;
     bool runBOLT = false;
     bool runSTL = false;
+    bool numaAware = false;
+    int threads = 0;
     /******************************************************************************
     * Parameter parsing                                                           *
     ******************************************************************************/
@@ -76,6 +80,9 @@ int _tmain( int argc, _TCHAR* argv[] )
             ( "tbb,T",          "Benchmark TBB MULTICORE CPU Code" )
             ( "bolt,B",         "Benchmark Bolt OpenCL Libray" )
             ( "serial,E",       "Benchmark Serial Code STL Libray" )
+            ( "numa,N",         "Run the TBB MULTICORE CPU path NUMA-aware; host vectors are first-touched per node" )
+            ( "threads,t",      po::value< int >( &threads )->default_value( 0 ),
+                "Number of TBB threads; 0 uses every hardware thread.  Sweep it to see scaling across sockets" )
             ( "platform,p",     po::value< cl_uint >( &userPlatform )->default_value( 0 ), 
                                 "Specify the platform under test using the index reported by -q flag" )
             ( "device,d",       po::value< cl_uint >( &userDevice )->default_value( 0 ), 
@@ -148,6 +155,10 @@ int _tmain( int argc, _TCHAR* argv[] )
         {
             runSTL = true;
         }
+        if( vm.count( "numa" ) )
+        {
+            numaAware = true;
+        }
     }
     catch( std::exception& e )
     {
@@ -242,7 +253,28 @@ int _tmain( int argc, _TCHAR* argv[] )
 
         bolt::cl::control ctl = bolt::cl::control::getDefault();
         ctl.setForceRunMode(bolt::cl::control::MultiCoreCpu);
-        if( systemMemory )
+        ctl.setTbbConcurrency( threads );
+        ctl.setNumaAware( numaAware );
+        if( systemMemory && numaAware )
+        {
+#if defined( ENABLE_TBB )
+            std::cout << "Benchmarking TBB Host, NUMA-aware\n"; 
+            //  std::vector would touch every page from this thread; let each node write the part it later reduces
+            boost::scoped_array< int > input1( new int[ length ] );
+            bolt::cl::detail::numa_first_touch_fill( ctl, input1.get( ), length, 1 );
+
+            for( unsigned i = 0; i < iterations; ++i )
+            {
+                myTimer.Start( testId );
+                int result = bolt::cl::reduce( ctl, input1.get( ), input1.get( ) + length, 0);
+                myTimer.Stop( testId );
+            }
+#else
+            std::cout << "The NUMA-aware benchmark requires TBB" << std::endl;
+            return 1;
+#endif
+        }
+        else if( systemMemory )
         {
             std::cout << "Benchmarking TBB Host\n"; 
             std::vector< int > input1( length, 1 );
@@ -257,7 +289,7 @@ int _tmain( int argc, _TCHAR* argv[] )
         else if(deviceMemory)
         {
             std::cout << "Benchmarking TBB Device\n"; 
-            bolt::cl::device_vector< int > input1( length, 1 );
+            bolt::cl::device_vector< int > input1( length, 1, CL_MEM_READ_WRITE, true, ctl );
 
             for( unsigned i = 0; i < iterations; ++i )
             {
@@ -309,6 +341,11 @@ int _tmain( int argc, _TCHAR* argv[] )
 
     bolt::tout << std::left;
     bolt::tout << std::setw( colWidth ) << _T( "Test profile: " ) << _T( "[" ) << iterations-pruned << _T( "] samples" ) << std::endl;
+    if( runTBB )
+    {
+        bolt::tout << std::setw( colWidth ) << _T( "    TBB threads: " ) << threads
+            << ( numaAware ? _T( " (NUMA-aware)" ) : _T( "" ) ) << std::endl;
+    }
     bolt::tout << std::setw( colWidth ) << _T( "    Size (MB): " ) << testMB << std::endl;
     bolt::tout << std::setw( colWidth ) << _T( "    Time (ms): " ) << testTime*1000.0 << std::endl;
     bolt::tout << std::setw( colWidth ) << _T( "    Speed (GB/s): " ) << testGB / testTime << std::endl;
@@ -40,6 +40,51 @@ struct SaxpyFunctor
 };
 );  // end BOLT_FUNCTOR
 
+/******************************************************************************
+* Times bolt::cl::sort of float keys on a device_vector for every length of the sweep
+* Lengths are 2^k - 1, 2^k and 2^k + 1 up to maxLength, so the cost of lengths that are
+* not a power of 2 shows up right next to the power of 2 they round to
+******************************************************************************/
+void sortSizeSweep( bolt::cl::control& ctl, size_t maxLength, size_t iterations )
+{
+    std::vector< size_t > lengths;
+    for( size_t pow2 = 1024; pow2 <= maxLength; pow2 <<= 1 )
+    {
+        lengths.push_back( pow2 - 1 );
+        lengths.push_back( pow2 );
+        lengths.push_back( pow2 + 1 );
+    }
+    if( 1000001 <= maxLength )
+        lengths.push_back( 1000001 );
+    std::sort( lengths.begin( ), lengths.end( ) );
+
+    bolt::statTimer& sweepTimer = bolt::statTimer::getInstance( );
+    sweepTimer.Reserve( lengths.size( ), iterations );
+
+    std::vector< float > backup( maxLength + 1 );
+    for( size_t i = 0; i < backup.size( ); ++i )
+        backup[ i ] = static_cast< float >( rand( ) ) / RAND_MAX;
+
+    bolt::tout << std::left;
+    bolt::tout << std::setw( colWidth ) << _T( "Length" ) << std::setw( colWidth ) << _T( "Time (s)" )
+               << _T( "Speed (MKeys/s)" ) << std::endl;
+    for( size_t l = 0; l < lengths.size( ); ++l )
+    {
+        size_t sweepId = sweepTimer.getUniqueID( _T( "sweep" ), static_cast< unsigned int >( l ) );
+        for( size_t i = 0; i < iterations; ++i )
+        {
+            bolt::cl::device_vector< float > dvInput( backup.begin( ), backup.begin( ) + lengths[ l ],
+                                                      CL_MEM_READ_WRITE, ctl );
+            sweepTimer.Start( sweepId );
+            bolt::cl::sort( ctl, dvInput.begin( ), dvInput.end( ) );
+            sweepTimer.Stop( sweepId );
+        }
+        sweepTimer.pruneOutliers( sweepId, 1.0 );
+        double sweepTime = sweepTimer.getAverageTime( sweepId );
+        bolt::tout << std::setw( colWidth ) << lengths[ l ] << std::setw( colWidth ) << sweepTime
+                   << ( lengths[ l ] / ( 1024.0 * 1024.0 ) ) / sweepTime << std::endl;
+    }
+}
 
 
 int _tmain( int argc, _TCHAR* argv[] )
@@ -57,6 +102,7 @@ int _tmain( int argc, _TCHAR* argv[] )
     bool runTBB = false;
     bool runBOLT = false;
     bool runSTL = false;
+    bool runSweep = false;
     /******************************************************************************
     * Parameter parsing                                                           *
     ******************************************************************************/
@@ -76,6 +122,7 @@ int _tmain( int argc, _TCHAR* argv[] )
             ( "tbb,T",          "Benchmark TBB MULTICORE CPU Code" )
             ( "bolt,B",         "Benchmark Bolt OpenCL Libray" )
             ( "serial,E",       "Benchmark Serial Code STL Libray" )
+            ( "sweep,w",        "Benchmark Bolt sort of float keys on device memory over power of 2 and odd lengths up to --length" )
             ( "platform,p",     po::value< cl_uint >( &userPlatform )->default_value( 0 ), 
                                 "Specify the platform under test using the index reported by -q flag" )
             ( "device,d",       po::value< cl_uint >( &userDevice )->default_value( 0 ), 
@@ -148,6 +195,10 @@ int _tmain( int argc, _TCHAR* argv[] )
         {
             runSTL = true;
         }
+        if( vm.count( "sweep" ) )
+        {
+            runSweep = true;
+        }
     }
     catch( std::exception& e )
     {
@@ -192,6 +243,12 @@ int _tmain( int argc, _TCHAR* argv[] )
     // Control setup:
 	bolt::cl::control::getDefault().setWaitMode(bolt::cl::control::BusyWait);
 
+    if( runSweep )
+    {
+        sortSizeSweep( bolt::cl::control::getDefault( ), length, iterations );
+        return 0;
+    }
+
     /******************************************************************************
     * Benchmark logic                                                             *
     ******************************************************************************/
@@ -73,6 +73,25 @@ void sortTest( bolt::statTimer& statTimer, size_t length, size_t iter )
         }
 }
 
+//  The same sort with std::stable_sort, as the baseline for --compare
+void stdSortTest( bolt::statTimer& statTimer, size_t length, size_t iter )
+{
+        size_t stdId   = statTimer.getUniqueID( _T( "std::stable_sort" ), 0 );
+
+        std::vector< unsigned int > input( length );
+        std::vector< unsigned int > backup( length );
+        std::generate( backup.begin( ), backup.end( ), rand );
+
+        for( size_t i = 0; i < iter; ++i )
+        {
+            input = backup;
+
+            statTimer.Start( stdId );
+            std::stable_sort( input.begin( ), input.end( ) );
+            statTimer.Stop( stdId );
+        }
+}
+
 int main( int argc, char* argv[] )
 {
     /******************************************************************************
@@ -93,6 +112,7 @@ int main( int argc, char* argv[] )
     bool runSTL = false;
     bool validate = false;
     bool compareSerial = false;
+    bool compareStd = false;
     std::string filename;
     size_t numThrowAway = 10;
     bolt::cl::control& ctrl = bolt::cl::control::getDefault();
@@ -126,6 +146,7 @@ int main( int argc, char* argv[] )
             ( "iterations,i",   po::value< size_t >( &iterations )->default_value( 1 ),
                 "Number of samples in timing loop" )
             ( "validate,v",     "Validate Bolt sort against serial CPU sort" )
+            ( "compare,C",      "Also time std::stable_sort on the same length, and report the speedup over it" )
             //( "serial",         "Use the STL std::sort" )
             ( "filename,f",     po::value< std::string >( &filename )->default_value( "bench.xml" ),
                 "Name of output file" )
@@ -203,6 +224,10 @@ int main( int argc, char* argv[] )
         {
             validate = true;
         }
+        if( vm.count( "compare" ) )
+        {
+            compareStd = true;
+        }
     }
     catch( std::exception& e )
     {
@@ -250,7 +275,7 @@ int main( int argc, char* argv[] )
 
     bolt::statTimer& myTimer = bolt::statTimer::getInstance( );
     double sortGB = 0;
-    myTimer.Reserve( 1, iterations );
+    myTimer.Reserve( compareStd ? 2 : 1, iterations );
     size_t sortId   = myTimer.getUniqueID( _T( "sort" ), 0 );
 
     std::vector< unsigned int > input( length );
@@ -329,6 +354,11 @@ int main( int argc, char* argv[] )
         std::cout <<"Invalid SORT algorithm specified\n";
     }
 
+    if( compareStd )
+    {
+        stdSortTest( myTimer, length, iterations );
+    }
+
     //  Remove all timings that are outside of 2 stddev (keep 65% of samples); we ignore outliers to get a more consistent result
     double MKeys = input.size( ) / ( 1024.0 * 1024.0 );
     size_t pruned = myTimer.pruneOutliers( 1.0 );
@@ -344,5 +374,15 @@ int main( int argc, char* argv[] )
     bolt::tout << std::setw( colWidth ) << _T( "    Speed (MKeys/s): " ) << MKeys / sortTime << std::endl;
     bolt::tout << std::endl;
 
+    if( compareStd )
+    {
+        double stdTime = myTimer.getAverageTime( myTimer.getUniqueID( _T( "std::stable_sort" ), 0 ) );
+        bolt::tout << std::setw( colWidth ) << _T( "std::stable_sort profile: " ) << std::endl;
+        bolt::tout << std::setw( colWidth ) << _T( "    Time (s): " ) << stdTime << std::endl;
+        bolt::tout << std::setw( colWidth ) << _T( "    Speed (MKeys/s): " ) << MKeys / stdTime << std::endl;
+        bolt::tout << std::setw( colWidth ) << _T( "    Speedup: " ) << stdTime / sortTime << std::endl;
+        bolt::tout << std::endl;
+    }
+
     return 0;
 }
\ No newline at end of file
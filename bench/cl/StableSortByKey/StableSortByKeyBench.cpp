@@ -20,7 +20,7 @@
 #include "bolt/unicode.h"
 #include "bolt/statisticalTimer.h"
 #include "bolt/countof.h"
-#include "bolt/cl/stablesort.h"
+#include "bolt/cl/stablesort_by_key.h"
 #define cNTiles 64
 
 const std::streamsize colWidth = 26;
@@ -55,6 +55,8 @@ void sortTest( bolt::statTimer& statTimer, size_t length, size_t iter )
             //}
         }
 
+        container values( length );
+
         for( size_t i = 0; i < iter; ++i )
         {
             input = backup;
@@ -64,7 +66,7 @@ void sortTest( bolt::statTimer& statTimer, size_t length, size_t iter )
             //}
 
             statTimer.Start( sortId );
-            bolt::cl::stable_sort( input.begin( ), input.end( ) );
+            bolt::cl::stable_sort_by_key( input.begin( ), input.end( ), values.begin( ) );
             statTimer.Stop( sortId );
 
             //{
@@ -73,6 +75,31 @@ void sortTest( bolt::statTimer& statTimer, size_t length, size_t iter )
         }
 }
 
+//  The same sort with std::stable_sort, on key/value pairs ordered by key
+bool lessKey( const std::pair< unsigned int, unsigned int >& lhs, const std::pair< unsigned int, unsigned int >& rhs )
+{
+    return lhs.first < rhs.first;
+}
+
+void stdSortTest( bolt::statTimer& statTimer, size_t length, size_t iter )
+{
+        size_t stdId   = statTimer.getUniqueID( _T( "std::stable_sort" ), 0 );
+
+        std::vector< std::pair< unsigned int, unsigned int > > input( length );
+        std::vector< std::pair< unsigned int, unsigned int > > backup( length );
+        for( size_t i = 0; i < length; ++i )
+            backup[ i ] = std::make_pair( static_cast< unsigned int >( rand( ) ), 0u );
+
+        for( size_t i = 0; i < iter; ++i )
+        {
+            input = backup;
+
+            statTimer.Start( stdId );
+            std::stable_sort( input.begin( ), input.end( ), lessKey );
+            statTimer.Stop( stdId );
+        }
+}
+
 int main( int argc, char* argv[] )
 {
     /******************************************************************************
@@ -93,6 +120,7 @@ int main( int argc, char* argv[] )
     bool runSTL = false;
     bool validate = false;
     bool compareSerial = false;
+    bool compareStd = false;
     std::string filename;
     size_t numThrowAway = 10;
     bolt::cl::control& ctrl = bolt::cl::control::getDefault();
@@ -126,6 +154,7 @@ int main( int argc, char* argv[] )
             ( "iterations,i",   po::value< size_t >( &iterations )->default_value( 1 ),
                 "Number of samples in timing loop" )
             ( "validate,v",     "Validate Bolt sort against serial CPU sort" )
+            ( "compare,C",      "Also time std::stable_sort on the same length, and report the speedup over it" )
             //( "serial",         "Use the STL std::sort" )
             ( "filename,f",     po::value< std::string >( &filename )->default_value( "bench.xml" ),
                 "Name of output file" )
@@ -203,6 +232,10 @@ int main( int argc, char* argv[] )
         {
             validate = true;
         }
+        if( vm.count( "compare" ) )
+        {
+            compareStd = true;
+        }
     }
     catch( std::exception& e )
     {
@@ -250,7 +283,7 @@ int main( int argc, char* argv[] )
 
     bolt::statTimer& myTimer = bolt::statTimer::getInstance( );
     double sortGB = 0;
-    myTimer.Reserve( 1, iterations );
+    myTimer.Reserve( compareStd ? 2 : 1, iterations );
     size_t sortId   = myTimer.getUniqueID( _T( "sort" ), 0 );
 
     std::vector< unsigned int > input( length );
@@ -329,6 +362,11 @@ int main( int argc, char* argv[] )
         std::cout <<"Invalid SORT algorithm specified\n";
     }
 
+    if( compareStd )
+    {
+        stdSortTest( myTimer, length, iterations );
+    }
+
     //  Remove all timings that are outside of 2 stddev (keep 65% of samples); we ignore outliers to get a more consistent result
     double MKeys = input.size( ) / ( 1024.0 * 1024.0 );
     size_t pruned = myTimer.pruneOutliers( 1.0 );
@@ -336,7 +374,7 @@ int main( int argc, char* argv[] )
     //double sortGB = ( input.size( ) * sizeof( int ) ) / (1024.0 * 1024.0 * 1024.0);
 
     bolt::tout << std::left;
-    bolt::tout << std::setw( colWidth ) << _T( "Stable Sort profile: " ) << _T( "[" ) << iterations-pruned << _T( "] samples" ) << std::endl;
+    bolt::tout << std::setw( colWidth ) << _T( "Stable Sort By Key profile: " ) << _T( "[" ) << iterations-pruned << _T( "] samples" ) << std::endl;
     bolt::tout << std::setw( colWidth ) << _T( "    Size (MKeys): " ) << MKeys << std::endl;
     bolt::tout << std::setw( colWidth ) << _T( "    Size (GB): " ) << sortGB << std::endl;
     bolt::tout << std::setw( colWidth ) << _T( "    Time (s): " ) << sortTime << std::endl;
@@ -344,5 +382,15 @@ int main( int argc, char* argv[] )
     bolt::tout << std::setw( colWidth ) << _T( "    Speed (MKeys/s): " ) << MKeys / sortTime << std::endl;
     bolt::tout << std::endl;
 
+    if( compareStd )
+    {
+        double stdTime = myTimer.getAverageTime( myTimer.getUniqueID( _T( "std::stable_sort" ), 0 ) );
+        bolt::tout << std::setw( colWidth ) << _T( "std::stable_sort profile: " ) << std::endl;
+        bolt::tout << std::setw( colWidth ) << _T( "    Time (s): " ) << stdTime << std::endl;
+        bolt::tout << std::setw( colWidth ) << _T( "    Speed (MKeys/s): " ) << MKeys / stdTime << std::endl;
+        bolt::tout << std::setw( colWidth ) << _T( "    Speedup: " ) << stdTime / sortTime << std::endl;
+        bolt::tout << std::endl;
+    }
+
     return 0;
 }
\ No newline at end of file
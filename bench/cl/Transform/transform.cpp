@@ -23,6 +23,8 @@
 #include "bolt/cl/transform.h"
 #include "bolt/cl/functional.h"
 
+#include <boost/scoped_array.hpp>
+
 const std::streamsize colWidth = 26;
 
 BOLT_FUNCTOR( SaxpyFunctor,
@@ -57,6 +59,8 @@ int main( int argc, char* argv[] )
     bool runTBB = false;
     bool runBOLT = false;
     bool runSTL = false;
+    bool numaAware = false;
+    int threads = 0;
 
     std::string filename;
     size_t numThrowAway = 10;
@@ -81,6 +85,9 @@ int main( int argc, char* argv[] )
             ( "tbb,T",          "Benchmark TBB MULTICORE CPU Code" )
             ( "bolt,B",         "Benchmark Bolt OpenCL Libray" )
             ( "serial,E",       "Benchmark Serial Code STL Libray" )
+            ( "numa,N",         "Run the TBB MULTICORE CPU path NUMA-aware; host vectors are first-touched per node" )
+            ( "threads,t",      po::value< int >( &threads )->default_value( 0 ),
+                "Number of TBB threads; 0 uses every hardware thread.  Sweep it to see scaling across sockets" )
             ( "platform,p",     po::value< cl_uint >( &userPlatform )->default_value( 0 ),
                 "Specify the platform under test using the index reported by -q flag" )
             ( "device,d",       po::value< cl_uint >( &userDevice )->default_value( 0 ),
@@ -159,6 +166,10 @@ int main( int argc, char* argv[] )
         {
             runSTL = true;
         }
+        if( vm.count( "numa" ) )
+        {
+            numaAware = true;
+        }
     }
     catch( std::exception& e )
     {
@@ -181,6 +192,8 @@ int main( int argc, char* argv[] )
     if( runTBB )
     {
         ctrl.setForceRunMode( bolt::cl::control::MultiCoreCpu );  // choose tbb tbb::parallel_scan
+        ctrl.setTbbConcurrency( threads );
+        ctrl.setNumaAware( numaAware );
     }
 
     // Platform vector contains all available platforms on system
@@ -211,7 +224,29 @@ int main( int argc, char* argv[] )
 
     SaxpyFunctor s(100.0);
 
-    if( systemMemory )
+    if( systemMemory && numaAware )
+    {
+#if defined( ENABLE_TBB )
+        //  std::vector would touch every page from this thread; let each node write the part it later transforms
+        boost::scoped_array< int > input1( new int[ length ] );
+        boost::scoped_array< int > input2( new int[ length ] );
+        boost::scoped_array< int > output( new int[ length ] );
+        bolt::cl::detail::numa_first_touch_fill( ctrl, input1.get( ), length, 1 );
+        bolt::cl::detail::numa_first_touch_fill( ctrl, input2.get( ), length, 1 );
+        bolt::cl::detail::numa_first_touch_fill( ctrl, output.get( ), length, 0 );
+
+        for( unsigned i = 0; i < iterations; ++i )
+        {
+            myTimer.Start( timerId );
+            bolt::cl::transform( input1.get( ), input1.get( ) + length, input2.get( ), output.get( ), s );
+            myTimer.Stop( timerId );
+        }
+#else
+        std::cout << "The NUMA-aware benchmark requires TBB" << std::endl;
+        return 1;
+#endif
+    }
+    else if( systemMemory )
     {
         std::vector< int > input1( length, 1 );
         std::vector< int > input2( length, 1 );
@@ -241,12 +276,18 @@ int main( int argc, char* argv[] )
     //  Remove all timings that are outside of 2 stddev (keep 65% of samples); we ignore outliers to get a more consistent result
     size_t pruned = myTimer.pruneOutliers( 1.0 );
     double testTime = myTimer.getAverageTime( timerId );
-    double testMB = ( length * sizeof( int ) ) / ( 1024.0 * 1024.0);
+    //  Two inputs are read and one output is written per element
+    double testMB = ( 3 * length * sizeof( int ) ) / ( 1024.0 * 1024.0);
     double testGB = testMB/ 1024.0;
     double MKeys = length / ( 1024.0 * 1024.0 );
 
     bolt::tout << std::left;
     bolt::tout << std::setw( colWidth ) << _T( "Transform profile: " ) << _T( "[" ) << iterations-pruned << _T( "] samples" ) << std::endl;
+    if( runTBB )
+    {
+        bolt::tout << std::setw( colWidth ) << _T( "    TBB threads: " ) << threads
+            << ( numaAware ? _T( " (NUMA-aware)" ) : _T( "" ) ) << std::endl;
+    }
     bolt::tout << std::setw( colWidth ) << _T( "    Size (MKeys): " ) << MKeys << std::endl;
     bolt::tout << std::setw( colWidth ) << _T( "    Size (MB): " ) << testMB << std::endl;
     bolt::tout << std::setw( colWidth ) << _T( "    Time (ms): " ) << testTime*1000.0 << std::endl;
@@ -25,6 +25,8 @@
 #include <vector>
 #include <set>
 
+#include <boost/chrono.hpp>
+
 #include "bolt/cl/bolt.h"
 #include "bolt/unicode.h"
 
@@ -37,13 +39,16 @@
 #include "bolt/min_element_kernels.hpp"
 #include "bolt/reduce_kernels.hpp"
 #include "bolt/reduce_by_key_kernels.hpp"
+#include "bolt/reduce_multi_kernels.hpp"
 #include "bolt/scan_kernels.hpp"
-#include "bolt/scan_by_key_kernels.hpp"
+#include "bolt/scan_lookback_kernels.hpp"
 #include "bolt/sort_kernels.hpp"
-#include "bolt/sort_uint_kernels.hpp"
+#include "bolt/sort_radix_kernels.hpp"
 #include "bolt/sort_by_key_kernels.hpp"
 #include "bolt/stablesort_kernels.hpp"
 #include "bolt/stablesort_by_key_kernels.hpp"
+#include "bolt/segmented_scan_kernels.hpp"
+#include "bolt/segmented_sort_kernels.hpp"
 #include "bolt/transform_kernels.hpp"
 #include "bolt/transform_reduce_kernels.hpp"
 #include "bolt/transform_scan_kernels.hpp"
@@ -394,7 +399,76 @@ namespace bolt {
         cl_int * err = NULL);
 
 
-    void wait(const bolt::cl::control &ctl, ::cl::Event &e) 
+    /**************************************************************************
+     * BalancedWait history
+     * A running average, per algorithm, of how long wait() had to block before
+     * the event completed.  BalancedWait spins for a budget derived from that
+     * average and only falls back to an OS wait once the budget is exhausted.
+     *************************************************************************/
+    // Longest spin BalancedWait will ever do, in microseconds; waits that historically take longer block immediately
+    static const double balancedMaxSpinUs = 1000.0;
+    // Shortest spin budget, in microseconds, so that timer jitter does not force every call into an OS wait
+    static const double balancedMinSpinUs = 10.0;
+    // Spin budget for an algorithm that has not been waited on yet, in microseconds
+    static const double balancedInitialSpinUs = 100.0;
+    // The spin budget is this multiple of the average wait observed for the algorithm
+    static const double balancedSpinFactor = 2.0;
+    // Weight of the newest sample in the exponential moving average
+    static const double balancedHistoryWeight = 0.25;
+
+    static boost::mutex waitHistoryMutex;
+    static std::map< std::string, double > waitHistory;
+
+    static void balancedWait( const bolt::cl::control &ctl, ::cl::Event &e, const std::string& waitName )
+    {
+        typedef boost::chrono::high_resolution_clock waitClock;
+        typedef boost::chrono::duration< double, boost::micro > waitMicroseconds;
+
+        double spinBudget = balancedInitialSpinUs;
+        {
+            boost::lock_guard< boost::mutex > lock( waitHistoryMutex );
+            std::map< std::string, double >::const_iterator iter = waitHistory.find( waitName );
+            if( iter != waitHistory.end( ) )
+                spinBudget = std::max( balancedMinSpinUs, balancedSpinFactor * iter->second );
+        }
+
+        const waitClock::time_point start = waitClock::now( );
+        ctl.getCommandQueue( ).flush( );
+
+        cl_int status = CL_QUEUED;
+        if( spinBudget <= balancedMaxSpinUs )
+        {
+            // spin here for fast completion detection, but only for as long as this algorithm usually takes
+            do
+            {
+                status = e.getInfo< CL_EVENT_COMMAND_EXECUTION_STATUS >( );
+            } while( ( status > CL_COMPLETE ) &&
+                     ( waitMicroseconds( waitClock::now( ) - start ).count( ) < spinBudget ) );
+        }
+
+        if( status > CL_COMPLETE )
+        {
+            // The budget ran out; give the core back and let the OpenCL runtime wake us up
+            cl_int l_Error = e.wait( );
+            V_OPENCL( l_Error, "wait call failed" );
+        }
+        else if( status < CL_COMPLETE )
+        {
+            V_OPENCL( status, "event terminated abnormally" );
+        }
+
+        const double elapsed = waitMicroseconds( waitClock::now( ) - start ).count( );
+        {
+            boost::lock_guard< boost::mutex > lock( waitHistoryMutex );
+            std::map< std::string, double >::iterator iter = waitHistory.find( waitName );
+            if( iter == waitHistory.end( ) )
+                waitHistory.insert( std::make_pair( waitName, elapsed ) );
+            else
+                iter->second = ( 1.0 - balancedHistoryWeight ) * iter->second + balancedHistoryWeight * elapsed;
+        }
+    }
+
+    void wait(const bolt::cl::control &ctl, ::cl::Event &e, const std::string& waitName) 
     {
         const bolt::cl::control::e_WaitMode waitMode = ctl.getWaitMode();
         if (waitMode == bolt::cl::control::BusyWait) {
@@ -403,7 +477,9 @@ namespace bolt {
             while (e.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() != CL_COMPLETE) {
                 // spin here for fast completion detection...
             };
-        } else if ((waitMode == bolt::cl::control::NiceWait) || (waitMode == bolt::cl::control::BalancedWait)) {
+        } else if (waitMode == bolt::cl::control::BalancedWait) {
+            balancedWait( ctl, e, waitName );
+        } else if (waitMode == bolt::cl::control::NiceWait) {
             cl_int l_Error = e.wait();
             V_OPENCL( l_Error, "wait call failed" );
         } else if (waitMode == bolt::cl::control::ClFinish) {
@@ -454,6 +530,13 @@ namespace bolt {
     {
         std::string completeKernelString;
 
+        // (0) index type, 32 bit unless the options ask for 64 bit indices; see detail/index_type.inl
+        completeKernelString += "\n// Index Type\n"
+            "#if !defined( BOLT_INDEX_TYPE )\n"
+            "#define BOLT_INDEX_TYPE uint\n"
+            "#endif\n"
+            "typedef BOLT_INDEX_TYPE indexType;\n";
+
         // (1) raw kernel
         completeKernelString += "\n// Raw Kernel\n\n" + kernelString;
 
@@ -616,6 +699,9 @@ namespace bolt {
         // externed in bolt.h
         boost::mutex programMapMutex;
         ProgramMap programMap;
+
+        // externed in control.h; guards the MultiCoreCpu task arenas cached in control
+        boost::mutex tbbArenaMutex;
         
 
     }; //namespace bolt::cl
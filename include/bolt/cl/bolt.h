@@ -75,13 +75,16 @@ namespace bolt {
         extern const std::string min_element_kernels;
         extern const std::string reduce_kernels;
         extern const std::string reduce_by_key_kernels;
+        extern const std::string reduce_multi_kernels;
         extern const std::string scan_kernels;
-        extern const std::string scan_by_key_kernels;
+        extern const std::string scan_lookback_kernels;
         extern const std::string sort_kernels;
         extern const std::string stablesort_kernels;
         extern const std::string stablesort_by_key_kernels;
-        extern const std::string sort_uint_kernels;
+        extern const std::string sort_radix_kernels;
         extern const std::string sort_by_key_kernels;
+        extern const std::string segmented_scan_kernels;
+        extern const std::string segmented_sort_kernels;
         extern const std::string transform_kernels;
         extern const std::string transform_reduce_kernels;
         extern const std::string transform_scan_kernels;
@@ -185,7 +188,13 @@ namespace bolt {
         }
         #define V_OPENCL( status, message ) V_OpenCL( status, message, __LINE__ )
 
-        void wait( const bolt::cl::control &ctl, ::cl::Event &e );
+        /*! \brief Block until the event completes, using the wait mode selected in the control structure
+        *  \param ctl The control structure that selects the wait mode and the command queue to flush
+        *  \param e The event to wait on
+        *  \param waitName Identifies the calling algorithm; BalancedWait keeps a separate completion-time
+        *  history for each name to size its spin budget
+        */
+        void wait( const bolt::cl::control &ctl, ::cl::Event &e, const std::string& waitName = "" );
 
         /******************************************************************
          * Program Map - so each kernel is only compiled once
@@ -283,6 +292,10 @@ BOLT_CREATE_TYPENAME( unsigned int );
 BOLT_CREATE_TYPENAME( float );
 BOLT_CREATE_TYPENAME( double );
 
+//  64 bit element counts and indices; the kernels know the host name of the type from its typedef
+BOLT_CREATE_TYPENAME( cl_ulong );
+BOLT_CREATE_CLCODE( cl_ulong, "typedef ulong cl_ulong;\n" );
+
 ////  Pre-define standard primitives that are likely to be used in a variety of OpenCL kernels
 //BOLT_CREATE_TYPENAME( cl_int );
 //BOLT_CREATE_CLCODE( cl_int, "int" );
@@ -25,8 +25,10 @@
 #include <bolt/cl/bolt.h>
 #include <string>
 #include <map>
+#include <vector>
 
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
 #include <boost/shared_ptr.hpp>
 
 /*! \file control.h
@@ -36,6 +38,13 @@
 namespace bolt {
     namespace cl {
 
+        // declared in bolt.cpp; guards the task arenas cached in control
+        extern boost::mutex tbbArenaMutex;
+
+        namespace detail {
+            struct tbbArenaAccess;  // the MultiCoreCpu arena cache of a control; see detail/tbb_arena.inl
+        };
+
         /*! \addtogroup miscellaneous
         */
 
@@ -101,7 +110,8 @@ namespace bolt {
             enum e_RunMode     {Automatic,
                                 SerialCpu,   
                                 MultiCoreCpu, 
-                                OpenCL };
+                                OpenCL,
+                                Heterogeneous };  // Split the range across several OpenCL devices and, with UseHost, the host; see setHeterogeneousQueues()
 
             enum e_AutoTuneMode{NoAutoTune=0x0, 
                                 AutoTuneDevice=0x1, 
@@ -116,12 +126,25 @@ namespace bolt {
                 static const unsigned AutoTune = 0x10;
             };
 
-            enum e_WaitMode {BalancedWait,	// Balance of Busy and Nice: tries to use Busy for short-running kernels.  \todo: Balanced currently maps to nice.
+            enum e_WaitMode {BalancedWait,	// Balance of Busy and Nice: spins for a budget learned from recent waits of the same algorithm, then blocks like Nice.
                              NiceWait,		// Use an OS semaphore to detect completion status.
                              BusyWait,		// Busy a CPU core continuously monitoring results.  Lowest-latency, but requires a dedicated core.
                              ClFinish,      // Call clFinish on the queue.
             };		
 
+            //! Partitioning strategy used by the MultiCoreCpu (TBB) paths when splitting a range into tasks.
+            enum e_TbbPartitioner {AutoPartitioner,      // tbb::auto_partitioner; splits adaptively down to the grain size.
+                                   SimplePartitioner,    // tbb::simple_partitioner; splits until a chunk reaches the grain size.
+                                   AffinityPartitioner   // tbb::affinity_partitioner; falls back to Auto for parallel_scan.
+            };
+
+            //! Partitioner and grain size pair; see setTbbPartitioner()
+            struct tbbPartitionDesc
+            {
+                e_TbbPartitioner partitioner;
+                size_t grainSize;
+            };
+
         public:
 
             // Construct a new control structure, copying from default control for arguments that are not overridden.
@@ -140,7 +163,14 @@ namespace bolt {
                 m_compileOptions(getDefault().m_compileOptions),
                 m_compileForAllDevices(getDefault().m_compileForAllDevices),
                 m_waitMode(getDefault().m_waitMode),
-                m_unroll(getDefault().m_unroll)
+                m_unroll(getDefault().m_unroll),
+                m_tbbConcurrency(getDefault().m_tbbConcurrency),
+                m_tbbPinThreads(getDefault().m_tbbPinThreads),
+                m_numaAware(getDefault().m_numaAware),
+                m_tbbPartition(getDefault().m_tbbPartition),
+                m_tbbAlgorithmPartition(getDefault().m_tbbAlgorithmPartition),
+                m_heteroQueues(getDefault().m_heteroQueues),
+                m_heteroChunkSize(getDefault().m_heteroChunkSize)
             {};
 
 
@@ -155,15 +185,24 @@ namespace bolt {
                 m_compileOptions(ref.m_compileOptions),
                 m_compileForAllDevices(ref.m_compileForAllDevices),
                 m_waitMode(ref.m_waitMode),
-                m_unroll(ref.m_unroll)
+                m_unroll(ref.m_unroll),
+                m_tbbConcurrency(ref.m_tbbConcurrency),
+                m_tbbPinThreads(ref.m_tbbPinThreads),
+                m_numaAware(ref.m_numaAware),
+                m_tbbPartition(ref.m_tbbPartition),
+                m_tbbAlgorithmPartition(ref.m_tbbAlgorithmPartition),
+                m_heteroQueues(ref.m_heteroQueues),
+                m_heteroChunkSize(ref.m_heteroChunkSize)
             {
+                boost::lock_guard< boost::mutex > lock( tbbArenaMutex );
+                m_tbbArena = ref.m_tbbArena;
                 //printf("control::copy construcor\n");
             };
 
             //setters:
             //! Set the OpenCL command queue (and associated device) for Bolt algorithms to use.  
-            //! Only one command-queue can be specified for each call; Bolt does not load-balance across
-            //! multiple command queues.  Bolt also uses the specified command queue to determine the OpenCL context and
+            //! Only one command-queue can be specified for each call; Bolt only load-balances across
+            //! multiple command queues in the Heterogeneous run mode, see setHeterogeneousQueues().  Bolt also uses the specified command queue to determine the OpenCL context and
             //! device.
             void setCommandQueue(::cl::CommandQueue commandQueue) { m_commandQueue = commandQueue; };
 
@@ -197,12 +236,75 @@ namespace bolt {
                 the optimal point for a given algorithm and device; typically 8-12 will deliver good results */
             void setWGPerComputeUnit(int wgPerComputeUnit) { m_wgPerComputeUnit = wgPerComputeUnit; }; 
 
-            /*! Set the method used to detect completion at the end of a Bolt routine. */
+            /*! Set the method used to detect completion at the end of a Bolt routine.  The default is BalancedWait,
+                which keeps the low latency of BusyWait for short-running kernels without dedicating a core to
+                long-running ones. */
             void setWaitMode(e_WaitMode waitMode) { m_waitMode = waitMode; };
 
             /*! unroll assignment */
             void setUnroll(int unroll) { m_unroll = unroll; };
 
+            /*! Cap the number of threads the MultiCoreCpu paths use, including the calling thread.  0 (the default)
+                lets TBB pick the number of hardware threads.  The threads live in a task arena owned by the
+                \p control structure, so they are created once and reused across Bolt calls. */
+            void setTbbConcurrency(int concurrency)
+            {
+                boost::lock_guard< boost::mutex > lock( tbbArenaMutex );
+                m_tbbConcurrency = concurrency;
+                m_tbbArena.reset( );
+            };
+
+            /*! If enabled, every worker thread of the MultiCoreCpu task arena is pinned to its own logical CPU while it
+                works there.  The thread calling Bolt is left where it is.  Useful when Bolt shares the host with other
+                latency-sensitive work; off by default. */
+            void setTbbPinThreads(bool pinThreads)
+            {
+                boost::lock_guard< boost::mutex > lock( tbbArenaMutex );
+                m_tbbPinThreads = pinThreads;
+                m_tbbArena.reset( );
+            };
+
+            /*! If enabled, the MultiCoreCpu paths of transform and reduce split their range across the NUMA nodes of the
+                host, each part running in a task arena whose threads are bound to that node.  device_vector objects
+                created on a CPU device with such a \p control are first-touched with the same split, so each node
+                reads local memory.  Off by default; on a single-node host it behaves like a regular arena. */
+            void setNumaAware(bool numaAware)
+            {
+                boost::lock_guard< boost::mutex > lock( tbbArenaMutex );
+                m_numaAware = numaAware;
+                m_tbbArena.reset( );
+            };
+
+            /*! Command queues that share the work when the run mode is Heterogeneous.  Each queue is a separate worker,
+                so several queues on sub-devices of one CPU device also work.  With an empty list, which is the default,
+                every device in the context of the control's command queue takes part.  When getUseHost() is UseHost
+                the host joins as one more worker, running the MultiCoreCpu path if it is built, or the SerialCpu path. */
+            void setHeterogeneousQueues(const ::std::vector< ::cl::CommandQueue >& queues) { m_heteroQueues = queues; };
+
+            /*! Number of elements in each chunk that a Heterogeneous worker claims at a time.  Faster workers claim more
+                chunks.  Smaller chunks balance better at the end of the range, while larger ones cost fewer launches. */
+            void setHeterogeneousChunkSize(size_t chunkSize) { m_heteroChunkSize = chunkSize ? chunkSize : 1; };
+
+            /*! Select the TBB partitioner and grain size used by the MultiCoreCpu paths.  With an empty
+                \p algorithm name this sets the default for every algorithm; otherwise it overrides the default for
+                the named algorithm only ("transform", "reduce", "transform_reduce", "count", "scan",
+                "scan_by_key").
+                * \code
+                * bolt::cl::control myControl;
+                * myControl.setTbbPartitioner( bolt::cl::control::SimplePartitioner, 4096, "reduce" );
+                * \endcode
+            */
+            void setTbbPartitioner(e_TbbPartitioner partitioner, size_t grainSize = 1, const ::std::string& algorithm = "")
+            {
+                tbbPartitionDesc desc;
+                desc.partitioner = partitioner;
+                desc.grainSize = grainSize > 0 ? grainSize : 1;
+                if( algorithm.empty( ) )
+                    m_tbbPartition = desc;
+                else
+                    m_tbbAlgorithmPartition[ algorithm ] = desc;
+            };
+
             //! 
             //! Specify the compile options passed to the OpenCL(TM) compiler.
             void setCompileOptions(std::string &compileOptions) { m_compileOptions = compileOptions; }; 
@@ -221,6 +323,18 @@ namespace bolt {
             e_WaitMode                  getWaitMode() const { return m_waitMode; };
             int                         getUnroll() const { return m_unroll; };
             bool                        getCompileForAllDevices() const { return m_compileForAllDevices; };
+            int                         getTbbConcurrency() const { return m_tbbConcurrency; };
+            bool                        getTbbPinThreads() const { return m_tbbPinThreads; };
+            bool                        getNumaAware() const { return m_numaAware; };
+            const ::std::vector< ::cl::CommandQueue >& getHeterogeneousQueues() const { return m_heteroQueues; };
+            size_t                      getHeterogeneousChunkSize() const { return m_heteroChunkSize; };
+
+            //! Return the partitioner settings for \p algorithm, or the default if it has no override.
+            tbbPartitionDesc getTbbPartitioner(const ::std::string& algorithm = "") const
+            {
+                ::std::map< ::std::string, tbbPartitionDesc >::const_iterator it = m_tbbAlgorithmPartition.find( algorithm );
+                return ( it != m_tbbAlgorithmPartition.end( ) ) ? it->second : m_tbbPartition;
+            };
 
             /*!
               * Return default default \p control structure.  This is used for Bolt API calls when the user
@@ -268,6 +382,7 @@ namespace bolt {
             void freeBuffers( );
 
         private:
+            friend struct detail::tbbArenaAccess;
 
             // This is the private constructor is only used to create the initial default control structure.
             control(bool createGlobal) :
@@ -277,9 +392,22 @@ namespace bolt {
                 m_autoTune(AutoTuneAll),
                 m_wgPerComputeUnit(8),
                 m_compileForAllDevices(true),
-                m_waitMode(BusyWait),
-                m_unroll(1)
+                m_waitMode(BalancedWait),
+                m_unroll(1),
+                m_tbbConcurrency(0),
+                m_tbbPinThreads(false),
+                m_numaAware(false),
+                m_heteroChunkSize(1 << 18)
             {
+                m_tbbPartition.partitioner = AutoPartitioner;
+                m_tbbPartition.grainSize = 1;
+
+                // transform has always split on 1024-element chunks with the simple partitioner
+                tbbPartitionDesc transformDesc;
+                transformDesc.partitioner = SimplePartitioner;
+                transformDesc.grainSize = 1024;
+                m_tbbAlgorithmPartition[ "transform" ] = transformDesc;
+
                 ::cl_device_type dType = CL_DEVICE_TYPE_CPU;
                 if(m_commandQueue() != NULL)
                 {
@@ -317,6 +445,16 @@ namespace bolt {
             bool                m_compileForAllDevices;  // compile for all devices in the context.  False means to only compile for specified device.
             e_WaitMode          m_waitMode;
             int                 m_unroll;
+            int                 m_tbbConcurrency;  // 0 means let TBB decide
+            bool                m_tbbPinThreads;
+            bool                m_numaAware;
+            tbbPartitionDesc    m_tbbPartition;
+            ::std::map< ::std::string, tbbPartitionDesc > m_tbbAlgorithmPartition;
+            //  The task arenas of the MultiCoreCpu paths, created on first use and shared with copies of this control;
+            //  type-erased, as the library itself is built without TBB.  Guarded by tbbArenaMutex.
+            mutable boost::shared_ptr< void > m_tbbArena;
+            ::std::vector< ::cl::CommandQueue > m_heteroQueues;  // empty means every device in the context
+            size_t              m_heteroChunkSize;
 
             struct descBufferKey
             {
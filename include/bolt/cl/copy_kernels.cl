@@ -21,11 +21,11 @@ __kernel
 void copy_I(
     global iType * restrict src,
     global oType * restrict dst,
-    const uint numElements,
-    const uint srcOffset,
-    const uint dstOffset)
+    const indexType numElements,
+    const indexType srcOffset,
+    const indexType dstOffset)
 {
-    size_t gloIdx = get_global_id( 0 );
+    indexType gloIdx = get_global_id( 0 );
     if( gloIdx >= numElements) return; // on SI this doesn't mess-up barriers
 
     dst[ dstOffset + gloIdx ] = src[ srcOffset + gloIdx ];
@@ -23,11 +23,13 @@
 #define BURST_SIZE 4
 #endif
 
+#include <algorithm>
 #include <boost/thread/once.hpp>
 #include <boost/bind.hpp>
 #include <type_traits> 
 
 #include "bolt/cl/bolt.h"
+#include "bolt/cl/detail/index_type.inl"
 
 // bumps dividend up (if needed) to be evenly divisible by divisor
 // returns whether dividend changed
@@ -79,7 +81,7 @@ template<typename InputIterator, typename OutputIterator>
 OutputIterator copy(const bolt::cl::control &ctrl,  InputIterator first, InputIterator last, OutputIterator result, 
             const std::string& user_code)
 {
-    int n = static_cast<int>( std::distance( first, last ) );
+    typename std::iterator_traits< InputIterator >::difference_type n = std::distance( first, last );
     return detail::copy_detect_random_access( ctrl, first, n, result, user_code, std::iterator_traits< InputIterator >::iterator_category( ) );
 }
 
@@ -88,7 +90,7 @@ template<typename InputIterator, typename OutputIterator>
 OutputIterator copy( InputIterator first, InputIterator last, OutputIterator result, 
             const std::string& user_code)
 {
-    int n = static_cast<int>( std::distance( first, last ) );
+    typename std::iterator_traits< InputIterator >::difference_type n = std::distance( first, last );
             return detail::copy_detect_random_access( control::getDefault(), first, n, result, user_code, 
                 std::iterator_traits< InputIterator >::iterator_category( ) );
 }
@@ -145,9 +147,9 @@ class Copy_KernelTemplateSpecializer : public KernelTemplateSpecializer
             "__kernel void " + name(0) + "(\n"
             "global " + typeNames[copy_iType] + " * restrict src,\n"
             "global " + typeNames[copy_oType] + " * restrict dst,\n"
-            "const uint numElements,\n"
-            "const uint srcOffset,\n"
-            "const uint dstOffset\n"
+            "const indexType numElements,\n"
+            "const indexType srcOffset,\n"
+            "const indexType dstOffset\n"
             ");\n\n"
 
             "// Dynamic specialization of generic template definition, using user supplied types\n"
@@ -304,7 +306,7 @@ typename std::enable_if< std::is_same< typename std::iterator_traits<DVInputIter
                         NULL,
                         &copyEvent);
     // wait for results
-    bolt::cl::wait(ctrl, copyEvent);
+    bolt::cl::wait(ctrl, copyEvent, "copy");
 }
 
 template< typename DVInputIterator, typename Size, typename DVOutputIterator > 
@@ -336,9 +338,10 @@ typename std::enable_if< !std::is_same< typename std::iterator_traits<DVInputIte
     const size_t numWorkGroupsPerComputeUnit = 10; //ctrl.wgPerComputeUnit( );
     const size_t numWorkGroups = numComputeUnits * numWorkGroupsPerComputeUnit;
     
-    const cl_uint numThreadsIdeal = static_cast<cl_uint>( numWorkGroups * workGroupSize );
-    cl_uint numElementsPerThread = n / numThreadsIdeal;
-    cl_uint numThreadsRUP = n;
+    const size_t numThreadsIdeal = numWorkGroups * workGroupSize;
+    size_t numThreadsRUP = static_cast< size_t >( n );
+    size_t indexSpan = std::max( static_cast< size_t >( first.m_Index ), static_cast< size_t >( result.m_Index ) ) +
+        static_cast< size_t >( n );
     size_t mod = (n & (workGroupSize-1));
     int doBoundaryCheck = 0;
     if( mod )
@@ -355,6 +358,7 @@ typename std::enable_if< !std::is_same< typename std::iterator_traits<DVInputIte
     std::ostringstream oss;
     oss << " -DBURST_SIZE=" << BURST_SIZE;
     oss << " -DBOUNDARY_CHECK=" << doBoundaryCheck;
+    oss << index_compile_options( indexSpan );
     compileOptions = oss.str();
 
     /**********************************************************************************
@@ -377,7 +381,7 @@ typename std::enable_if< !std::is_same< typename std::iterator_traits<DVInputIte
     try
     {
         int whichKernel = 0;
-        cl_uint numThreadsChosen;
+        size_t numThreadsChosen;
         cl_uint workGroupSizeChosen = workGroupSize;
         switch( whichKernel )
             {
@@ -398,9 +402,9 @@ typename std::enable_if< !std::is_same< typename std::iterator_traits<DVInputIte
 
         V_OPENCL( kernels[whichKernel].setArg( 0, first.getBuffer()), "Error setArg kernels[ 0 ]" ); // Input keys
         V_OPENCL( kernels[whichKernel].setArg( 1, result.getBuffer()),"Error setArg kernels[ 0 ]" ); // Input buffer
-        V_OPENCL( kernels[whichKernel].setArg( 2, static_cast<cl_uint>( n ) ),     "Error setArg kernels[ 0 ]" ); // Size of buffer
-        V_OPENCL( kernels[whichKernel].setArg( 3, first.m_Index ),                 "Error setArg kernels[ 0 ]" ); // Size of buffer
-        V_OPENCL( kernels[whichKernel].setArg( 4, result.m_Index ),                "Error setArg kernels[ 0 ]" ); // Size of buffer
+        V_OPENCL( index_set_arg( kernels[whichKernel], 2, n, indexSpan ),              "Error setArg kernels[ 0 ]" ); // Size of buffer
+        V_OPENCL( index_set_arg( kernels[whichKernel], 3, first.m_Index, indexSpan ),  "Error setArg kernels[ 0 ]" ); // Offset of input
+        V_OPENCL( index_set_arg( kernels[whichKernel], 4, result.m_Index, indexSpan ), "Error setArg kernels[ 0 ]" ); // Offset of output
         l_Error = ctrl.getCommandQueue( ).enqueueNDRangeKernel(
             kernels[whichKernel],
             ::cl::NullRange,
@@ -419,7 +423,7 @@ typename std::enable_if< !std::is_same< typename std::iterator_traits<DVInputIte
     }
 
     // wait for results
-    bolt::cl::wait(ctrl, kernelEvent);
+    bolt::cl::wait(ctrl, kernelEvent, "copy");
 
 
     // profiling
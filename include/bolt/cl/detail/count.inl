@@ -20,17 +20,20 @@
 #pragma once
 
 #include <algorithm>
+#include <numeric>
 
 #include <boost/thread/once.hpp>
 #include <boost/bind.hpp>
 
 #include "bolt/cl/bolt.h"
 #include "bolt/cl/functional.h"
+#include "bolt/cl/detail/heterogeneous.inl"
+#include "bolt/cl/detail/index_type.inl"
 #ifdef ENABLE_TBB
 //TBB Includes
 #include "tbb/parallel_reduce.h"
 #include "tbb/blocked_range.h"
-#include "tbb/task_scheduler_init.h"
+#include "bolt/cl/detail/tbb_arena.inl"
 #endif
 
 
@@ -154,6 +157,8 @@ namespace bolt {
                 const std::string& cl_code )
             {
                 typedef typename std::iterator_traits< DVInputIterator >::value_type iType;
+                index_require_32( static_cast< size_t >( first.distance_to( last ) ),
+                    "The OpenCL path of count() takes ranges of fewer than 2^31 elements" );
 
                 std::vector<std::string> typeNames( count_end);
                 typeNames[count_iValueType] = TypeName< iType >::get( );
@@ -234,7 +239,7 @@ namespace bolt {
                 bolt::cl::minimum<size_t>  count_size_t;
                 size_t numTailReduce = count_size_t( ceilNumWG, numWG );
 
-                bolt::cl::wait(ctl, l_mapEvent);
+                bolt::cl::wait(ctl, l_mapEvent, "count");
 
                 int count =  h_result[0] ;
                 for(int i = 1; i < numTailReduce; ++i)
@@ -247,6 +252,27 @@ namespace bolt {
                 return count;
             }
 
+            //  Chunk body for the Heterogeneous run mode; the per-chunk counts are summed afterwards
+            template<typename InputIterator, typename Predicate>
+            struct heteroCountChunk
+            {
+                heteroCountChunk( const InputIterator& first, const Predicate& predicate, const std::string& cl_code,
+                    std::vector< int >& partials ):
+                    m_first( first ), m_predicate( predicate ), m_code( cl_code ), m_partials( partials )
+                {}
+
+                void operator( )( control& worker, size_t chunk, size_t first, size_t last )
+                {
+                    m_partials[ chunk ] = static_cast< int >( bolt::cl::count_if( worker, m_first + first,
+                        m_first + last, m_predicate, m_code ) );
+                }
+
+                InputIterator m_first;
+                Predicate m_predicate;
+                std::string m_code;
+                std::vector< int >& m_partials;
+            };
+
             template<typename InputIterator, typename Predicate>
             int count_detect_random_access(bolt::cl::control &ctl,
                 const InputIterator& first,
@@ -298,16 +324,24 @@ namespace bolt {
                 {
                     runMode = ctl.getDefaultPathToRun();
                 }
-                if (runMode == bolt::cl::control::SerialCpu)
+                if (runMode == bolt::cl::control::Heterogeneous)
+                {
+                    std::vector< int > partials( hetero_num_chunks( ctl, szElements ) );
+                    heteroCountChunk< InputIterator, Predicate > body( first, predicate, cl_code, partials );
+                    hetero_for( ctl, szElements, body );
+                    return std::accumulate( partials.begin( ), partials.end( ), 0 );
+                }
+                else if (runMode == bolt::cl::control::SerialCpu)
                 {
                       return (int) std::count_if(first,last,predicate);
                 }
                 else if (runMode == bolt::cl::control::MultiCoreCpu) {
 
 #ifdef ENABLE_TBB
-                    tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
+                    control::tbbPartitionDesc part = ctl.getTbbPartitioner( "count" );
                     Count<iType,Predicate> count_op(predicate);
-                    tbb::parallel_reduce( tbb::blocked_range<iType*>( &*first, (iType*)&*(last-1) + 1), count_op );
+                    detail::tbb_parallel_reduce( ctl, tbb::blocked_range<iType*>( &*first, (iType*)&*(last-1) + 1, part.grainSize ),
+                        count_op, part.partitioner );
                     return (int)count_op.value;
 #else
                     //std::cout << "The MultiCoreCpu version of count function is not enabled." << std ::endl;
@@ -364,9 +398,10 @@ namespace bolt {
                    iType *countInputBuffer = (iType*)ctl.getCommandQueue().enqueueMapBuffer(first.getBuffer(), false, CL_MAP_READ,0, sizeof(iType) * szElements,
                                                NULL, &multiCoreCPUEvent, &l_Error );
                     multiCoreCPUEvent.wait();
-                    tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
+                    control::tbbPartitionDesc part = ctl.getTbbPartitioner( "count" );
                     Count<iType, Predicate> count_op(predicate);
-                    tbb::parallel_reduce( tbb::blocked_range<iType*>( countInputBuffer, countInputBuffer + szElements), count_op );
+                    detail::tbb_parallel_reduce( ctl, tbb::blocked_range<iType*>( countInputBuffer, countInputBuffer + szElements,
+                        part.grainSize ), count_op, part.partitioner );
                     return (int)count_op.value;
 #else
                     //std::cout << "The MultiCoreCpu version of count is not enabled. " << std ::endl;
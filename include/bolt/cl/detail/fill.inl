@@ -25,6 +25,8 @@
 #include <type_traits>
 
 #include "bolt/cl/bolt.h"
+#include "bolt/cl/detail/heterogeneous.inl"
+#include "bolt/cl/detail/index_type.inl"
 
 namespace bolt {
     namespace cl {
@@ -107,7 +109,7 @@ namespace bolt {
                     "__kernel void " + name(0) + "(\n"
                     "const " + typeNames[fill_T] + " src,\n"
                     "global " + typeNames[fill_Type] + " * dst,\n"
-                    "const uint numElements\n"
+                    "const indexType numElements\n"
                     ");\n\n";
     
                 return templateSpecializationString;
@@ -137,6 +139,24 @@ namespace bolt {
             }
 
 
+            //  Chunk body for the Heterogeneous run mode; each chunk is a regular fill on the worker's control
+            template<typename ForwardIterator, typename T>
+            struct heteroFillChunk
+            {
+                heteroFillChunk( const ForwardIterator& first, const T& value, const std::string& cl_code ):
+                    m_first( first ), m_value( value ), m_code( cl_code )
+                {}
+
+                void operator( )( control& worker, size_t chunk, size_t first, size_t last )
+                {
+                    bolt::cl::fill( worker, m_first + first, m_first + last, m_value, m_code );
+                }
+
+                ForwardIterator m_first;
+                T m_value;
+                std::string m_code;
+            };
+
             /*****************************************************************************
              * Pick Iterator
              ****************************************************************************/
@@ -161,7 +181,12 @@ namespace bolt {
                      runMode = ctl.getDefaultPathToRun();
                 }
               
-                if( runMode == bolt::cl::control::SerialCpu || runMode == bolt::cl::control::MultiCoreCpu )
+                if( runMode == bolt::cl::control::Heterogeneous )
+                {
+                    heteroFillChunk< ForwardIterator, T > body( first, value, user_code );
+                    hetero_for( ctl, sz, body );
+                }
+                else if( runMode == bolt::cl::control::SerialCpu || runMode == bolt::cl::control::MultiCoreCpu )
                 {
                   return std::fill(first, last, value );
                 }
@@ -217,7 +242,7 @@ namespace bolt {
                 const T & val, const std::string& cl_code)
             {
                 // how many elements to fill
-                cl_uint sz = static_cast< cl_uint >( std::distance( first, last ) );
+                size_t sz = static_cast< size_t >( std::distance( first, last ) );
                 if (sz < 1)
                     return;
 
@@ -243,9 +268,9 @@ namespace bolt {
                 const size_t numWorkGroupsPerComputeUnit = ctl.getWGPerComputeUnit( );
                 const size_t numWorkGroups = numComputeUnits * numWorkGroupsPerComputeUnit;
                 
-                const cl_uint numThreadsIdeal = static_cast<cl_uint>( numWorkGroups * workGroupSize );
-                cl_uint numElementsPerThread = sz/ numThreadsIdeal;
-                cl_uint numThreadsRUP = sz;
+                const size_t numThreadsIdeal = numWorkGroups * workGroupSize;
+                size_t numElementsPerThread = sz/ numThreadsIdeal;
+                size_t numThreadsRUP = sz;
                 size_t mod = (sz& (workGroupSize-1));
                 int doBoundaryCheck = 0;
                 if( mod )
@@ -261,6 +286,7 @@ namespace bolt {
                 std::string compileOptions;
                 std::ostringstream oss;
                 oss << " -DBOUNDARY_CHECK=" << doBoundaryCheck;
+                oss << index_compile_options( sz );
                 compileOptions = oss.str();
             
                 /**********************************************************************************
@@ -281,15 +307,15 @@ namespace bolt {
                 ::cl::Event kernelEvent;
                 try
                 {
-                    cl_uint numThreadsChosen;
-                    cl_uint workGroupSizeChosen = workGroupSize;
+                    size_t numThreadsChosen;
+                    size_t workGroupSizeChosen = workGroupSize;
                     numThreadsChosen = numThreadsRUP;
             
                     //std::cout << "NumElem: " << sz<< "; NumThreads: " << numThreadsChosen << "; NumWorkGroups: " << numThreadsChosen/workGroupSizeChosen << std::endl;
             
                     V_OPENCL( kernels[0].setArg( 0, val), "Error setArg kernels[ 0 ]" ); // Input Value
                     V_OPENCL( kernels[0].setArg( 1, first.getBuffer()),"Error setArg kernels[ 0 ]" ); // Fill buffer
-                    V_OPENCL( kernels[0].setArg( 2, static_cast<cl_uint>( sz) ), "Error setArg kernels[ 0 ]" ); // Size of buffer
+                    V_OPENCL( index_set_arg( kernels[0], 2, sz, sz ), "Error setArg kernels[ 0 ]" ); // Size of buffer
             
                     l_Error = ctl.getCommandQueue( ).enqueueNDRangeKernel(
                         kernels[0],
@@ -309,7 +335,7 @@ namespace bolt {
                 }
             
                 // wait for results
-                bolt::cl::wait(ctl, kernelEvent);
+                bolt::cl::wait(ctl, kernelEvent, "fill");
             
             
                 // profiling
@@ -24,6 +24,8 @@
 #include <type_traits> 
 
 #include "bolt/cl/bolt.h"
+#include "bolt/cl/detail/heterogeneous.inl"
+#include "bolt/cl/detail/index_type.inl"
 
 #define BURST 1
 
@@ -95,7 +97,7 @@ class Generate_KernelTemplateSpecializer : public KernelTemplateSpecializer
                 "template __attribute__((mangled_name("+name(0)+"Instantiated)))\n"
                 "kernel void "+name(0)+"(\n"
                 "global " + typeNames[gen_oType] + " * restrict dst,\n"
-                "const int numElements,\n"
+                "const indexType numElements,\n"
                 "global " + typeNames[gen_genType] + " * restrict genPtr);\n\n"
 
                         "// Host generates this instantiation string with user-specified value type and generator\n"
@@ -141,6 +143,33 @@ void generate_detect_random_access( bolt::cl::control &ctrl, const ForwardIterat
             }
            
 
+            //  Chunk body for the Heterogeneous run mode.  The OpenCL path of generate does not look at the run mode,
+            //  so the host worker generates its chunks itself.
+            template<typename ForwardIterator, typename Generator>
+            struct heteroGenerateChunk
+            {
+                heteroGenerateChunk( const ForwardIterator& first, const Generator& gen, const std::string& cl_code ):
+                    m_first( first ), m_gen( gen ), m_code( cl_code )
+                {}
+
+                void operator( )( control& worker, size_t chunk, size_t first, size_t last )
+                {
+                    if( worker.getForceRunMode( ) == bolt::cl::control::OpenCL )
+                    {
+                        bolt::cl::generate( worker, m_first + first, m_first + last, m_gen, m_code );
+                    }
+                    else
+                    {
+                        Generator gen( m_gen );
+                        std::generate( m_first + first, m_first + last, gen );
+                    }
+                }
+
+                ForwardIterator m_first;
+                Generator m_gen;
+                std::string m_code;
+            };
+
 /*****************************************************************************
              * Pick Iterator
              ****************************************************************************/
@@ -159,6 +188,13 @@ void generate_detect_random_access( bolt::cl::control &ctrl, const ForwardIterat
                 if (sz < 1)
                     return;
 
+                if( ctrl.getForceRunMode( ) == bolt::cl::control::Heterogeneous )
+                {
+                    heteroGenerateChunk< ForwardIterator, Generator > body( first, gen, user_code );
+                    detail::hetero_for( ctrl, sz, body );
+                    return;
+                }
+
                 // Use host pointers memory since these arrays are only write once - no benefit to copying.
                 // Map the forward iterator to a device_vector
     device_vector< Type > range( first, sz, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY, false, ctrl );
@@ -225,7 +261,7 @@ aProfiler.set(AsyncProfiler::device, control::SerialCpu);
     /**********************************************************************************
      * Number of Threads
      *********************************************************************************/
-    const cl_uint numElements = static_cast< cl_uint >( std::distance( first, last ) );
+    const size_t numElements = static_cast< size_t >( std::distance( first, last ) );
     if (numElements < 1) return;
     const size_t workGroupSize  = 256;
     const size_t numComputeUnits = ctrl.getDevice( ).getInfo< CL_DEVICE_MAX_COMPUTE_UNITS >( ); // = 28
@@ -233,7 +269,7 @@ aProfiler.set(AsyncProfiler::device, control::SerialCpu);
     const size_t numWorkGroupsIdeal = numComputeUnits * numWorkGroupsPerComputeUnit;
     const cl_uint numThreadsIdeal = static_cast<cl_uint>( numWorkGroupsIdeal * workGroupSize );
     int doBoundaryCheck = 0;
-    cl_uint numThreadsRUP = numElements;
+    size_t numThreadsRUP = numElements;
     size_t mod = (numElements & (workGroupSize-1));
     if( mod )
             {
@@ -249,6 +285,7 @@ aProfiler.set(AsyncProfiler::device, control::SerialCpu);
     std::ostringstream oss;
     oss << " -DBURST=" << BURST;
     oss << " -DBOUNDARY_CHECK=" << doBoundaryCheck;
+    oss << index_compile_options( numThreadsRUP );
     compileOptions = oss.str();
 
     /**********************************************************************************
@@ -285,8 +322,8 @@ aProfiler.set(AsyncProfiler::device, control::SerialCpu);
 #endif
                 
     int whichKernel = 0;
-    cl_uint numThreadsChosen;
-    cl_uint workGroupSizeChosen = workGroupSize;
+    size_t numThreadsChosen;
+    size_t workGroupSizeChosen = workGroupSize;
     switch( whichKernel )
     {
     case 0: // I: thread per element
@@ -302,7 +339,7 @@ aProfiler.set(AsyncProfiler::device, control::SerialCpu);
 
 
     V_OPENCL( kernels[whichKernel].setArg( 0, first.getBuffer()),  "Error setArg kernels[ 0 ]" ); // Input keys
-    V_OPENCL( kernels[whichKernel].setArg( 1, numElements),         "Error setArg kernels[ 0 ]" ); // Input buffer
+    V_OPENCL( index_set_arg( kernels[whichKernel], 1, numElements, numThreadsRUP ), "Error setArg kernels[ 0 ]" ); // Input buffer
     V_OPENCL( kernels[whichKernel].setArg( 2, *userGenerator ),     "Error setArg kernels[ 0 ]" ); // Size of buffer
 
 #ifdef BOLT_ENABLE_PROFILING
@@ -329,7 +366,7 @@ aProfiler.set(AsyncProfiler::memory, 1*numElements*sizeof(oType)
                 V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for generate() kernel" );
 
                 // wait to kernel completion
-    bolt::cl::wait(ctrl, generateEvent);
+    bolt::cl::wait(ctrl, generateEvent, "generate");
 #if 0
 #ifdef BOLT_ENABLE_PROFILING
 aProfiler.nextStep();
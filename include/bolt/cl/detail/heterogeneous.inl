@@ -0,0 +1,230 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+/*  Dispatcher for the Heterogeneous run mode.  The range is cut into fixed-size chunks, and every worker (one per
+ *  OpenCL command queue, plus the host when the control allows it) claims the next unclaimed chunk whenever it
+ *  finishes one, so faster devices end up with more of the range.  Each chunk is handed to the regular algorithm
+ *  with a control that forces the worker's own path, so a chunk runs exactly like a call on a single device.
+ */
+
+#if !defined( BOLT_CL_HETEROGENEOUS_INL )
+#define BOLT_CL_HETEROGENEOUS_INL
+#pragma once
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+#include "bolt/cl/bolt.h"
+
+namespace bolt {
+namespace cl {
+namespace detail {
+
+    //  The run mode used by the host worker
+    inline control::e_RunMode hetero_host_mode( )
+    {
+#if defined( ENABLE_TBB )
+        return control::MultiCoreCpu;
+#else
+        return control::SerialCpu;
+#endif
+    }
+
+    /*! \brief Builds one control per worker of a Heterogeneous dispatch; the host worker, if any, is last
+     *  \details Without explicit queues, every device in the context of the control's queue takes part, and the
+     *  control's own queue is reused for its device.
+     */
+    inline std::vector< boost::shared_ptr< control > > hetero_workers( const control& ctl )
+    {
+        std::vector< ::cl::CommandQueue > queues = ctl.getHeterogeneousQueues( );
+        if( queues.empty( ) && ctl.getCommandQueue( )( ) != NULL )
+        {
+            ::cl::Context context = ctl.getContext( );
+            ::cl::Device ctlDevice = ctl.getDevice( );
+
+            cl_int l_Error = CL_SUCCESS;
+            std::vector< ::cl::Device > devices = context.getInfo< CL_CONTEXT_DEVICES >( &l_Error );
+            V_OPENCL( l_Error, "Context::getInfo< CL_CONTEXT_DEVICES > failed" );
+
+            for( std::vector< ::cl::Device >::iterator dev = devices.begin( ); dev != devices.end( ); ++dev )
+            {
+                if( ( *dev )( ) == ctlDevice( ) )
+                {
+                    queues.push_back( ctl.getCommandQueue( ) );
+                }
+                else
+                {
+                    queues.push_back( ::cl::CommandQueue( context, *dev, 0, &l_Error ) );
+                    V_OPENCL( l_Error, "CommandQueue() failed for a Heterogeneous worker" );
+                }
+            }
+        }
+
+        std::vector< boost::shared_ptr< control > > workers;
+        for( std::vector< ::cl::CommandQueue >::iterator q = queues.begin( ); q != queues.end( ); ++q )
+        {
+            boost::shared_ptr< control > worker( new control( ctl ) );
+            worker->setCommandQueue( *q );
+            worker->setForceRunMode( control::OpenCL );
+            workers.push_back( worker );
+        }
+
+        //  With no device at all, the host does the work even if the control asked not to use it
+        if( ctl.getUseHost( ) == control::UseHost || workers.empty( ) )
+        {
+            boost::shared_ptr< control > host( new control( ctl ) );
+            host->setForceRunMode( hetero_host_mode( ) );
+            workers.push_back( host );
+        }
+
+        return workers;
+    }
+
+    //  The chunks of a range, handed out in order to whichever worker asks next
+    class heteroChunkQueue
+    {
+    public:
+        heteroChunkQueue( size_t n, size_t chunkSize ): m_size( n ), m_chunkSize( chunkSize ), m_next( 0 ), m_failed( false )
+        {}
+
+        size_t numChunks( ) const { return ( m_size + m_chunkSize - 1 ) / m_chunkSize; }
+
+        //  Returns false once every chunk has been claimed, or after a worker failed
+        bool claim( size_t& chunk, size_t& first, size_t& last )
+        {
+            boost::lock_guard< boost::mutex > lock( m_guard );
+            if( m_failed || m_next >= numChunks( ) )
+                return false;
+
+            chunk = m_next++;
+            first = chunk * m_chunkSize;
+            last = std::min( first + m_chunkSize, m_size );
+            return true;
+        }
+
+        //  Records the first failure; the other workers stop after their current chunk
+        void fail( cl_int status, const std::string& message )
+        {
+            boost::lock_guard< boost::mutex > lock( m_guard );
+            if( !m_failed )
+            {
+                m_failed = true;
+                m_status = status;
+                m_message = message;
+            }
+        }
+
+        void rethrow( ) const
+        {
+            if( m_failed )
+                V_OPENCL( m_status, "Heterogeneous worker failed: " + m_message );
+        }
+
+    private:
+        size_t m_size;
+        size_t m_chunkSize;
+        size_t m_next;
+        bool m_failed;
+        cl_int m_status;
+        std::string m_message;
+        boost::mutex m_guard;
+    };
+
+    template< typename ChunkBody >
+    class heteroWorker
+    {
+    public:
+        heteroWorker( control& ctl, heteroChunkQueue& chunks, ChunkBody& body ):
+            m_ctl( ctl ), m_chunks( chunks ), m_body( body )
+        {}
+
+        void operator( )( )
+        {
+            try
+            {
+                size_t chunk, first, last;
+                while( m_chunks.claim( chunk, first, last ) )
+                    m_body( m_ctl, chunk, first, last );
+            }
+            catch( const ::cl::Error& e )
+            {
+                m_chunks.fail( e.err( ) != CL_SUCCESS ? e.err( ) : CL_INVALID_OPERATION, e.what( ) ? e.what( ) : "" );
+            }
+            catch( const std::exception& e )
+            {
+                m_chunks.fail( CL_INVALID_OPERATION, e.what( ) );
+            }
+        }
+
+    private:
+        control& m_ctl;
+        heteroChunkQueue& m_chunks;
+        ChunkBody& m_body;
+    };
+
+    /*! \brief Runs \p body over [0, \p n) on every worker of \p ctl, one chunk at a time
+     *  \details \p body is called as body( workerControl, chunkIndex, first, last ) from several threads at once,
+     *  always with disjoint chunks.  Each OpenCL worker gets a thread of its own to enqueue and wait on; the host
+     *  worker runs on the calling thread.  The first exception thrown by any worker is rethrown as a ::cl::Error.
+     *  Callers that keep a result per chunk size their storage with hetero_num_chunks().
+     */
+    template< typename ChunkBody >
+    void hetero_for( const control& ctl, size_t n, ChunkBody& body )
+    {
+        std::vector< boost::shared_ptr< control > > workers = hetero_workers( ctl );
+        heteroChunkQueue chunks( n, ctl.getHeterogeneousChunkSize( ) );
+
+        bool hostWorker = workers.back( )->getForceRunMode( ) != control::OpenCL;
+        size_t numDeviceWorkers = hostWorker ? workers.size( ) - 1 : workers.size( );
+
+        boost::thread_group threads;
+        for( size_t w = 0; w < numDeviceWorkers; ++w )
+            threads.create_thread( heteroWorker< ChunkBody >( *workers[ w ], chunks, body ) );
+
+        if( hostWorker )
+            heteroWorker< ChunkBody >( *workers.back( ), chunks, body )( );
+
+        threads.join_all( );
+        chunks.rethrow( );
+    }
+
+    //  Number of chunks hetero_for cuts a range of \p n elements into
+    inline size_t hetero_num_chunks( const control& ctl, size_t n )
+    {
+        return ( n + ctl.getHeterogeneousChunkSize( ) - 1 ) / ctl.getHeterogeneousChunkSize( );
+    }
+
+    /*! \brief Combines per-chunk results in range order, so a non-commutative operator still gives the serial answer
+     */
+    template< typename T, typename BinaryFunction >
+    T hetero_combine( const T& init, const std::vector< T >& partials, BinaryFunction op )
+    {
+        T result = init;
+        for( typename std::vector< T >::const_iterator p = partials.begin( ); p != partials.end( ); ++p )
+            result = op( result, *p );
+        return result;
+    }
+
+}
+}
+}
+
+#endif
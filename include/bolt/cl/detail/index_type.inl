@@ -0,0 +1,91 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+/*  Width of the element counts and indices the kernels are specialized for.  getKernels( ) declares indexType in
+ *  every program, as uint unless the compile options define BOLT_INDEX_TYPE; a range too large for 32 bit indices
+ *  compiles a second program with ulong ones, so the common case keeps its 32 bit arithmetic.
+ */
+
+#if !defined( BOLT_CL_INDEX_TYPE_INL )
+#define BOLT_CL_INDEX_TYPE_INL
+#pragma once
+
+#include <string>
+#include "bolt/cl/bolt.h"
+
+/* \brief - Largest range indexed with 32 bits; the headroom covers global sizes rounded up to a work group and
+ *  the signed arithmetic some kernels still do */
+#define BOLT_INDEX_32_MAX 0x7FFFFFFFu
+
+namespace bolt {
+namespace cl {
+namespace detail {
+
+//  Whether index_force_64( ) is set
+inline bool& index_forced_64( )
+{
+    static bool forced = false;
+    return forced;
+}
+
+/*! \brief Test hook: while set, every range is indexed with 64 bits, so the ulong kernels are covered without
+ *  allocating 2^31 elements
+ */
+inline void index_force_64( bool force )
+{
+    index_forced_64( ) = force;
+}
+
+inline bool index_fits_32( size_t indexSpan )
+{
+    return indexSpan <= BOLT_INDEX_32_MAX && !index_forced_64( );
+}
+
+//  Compile options selecting the index width for indices below indexSpan
+inline std::string index_compile_options( size_t indexSpan )
+{
+    return index_fits_32( indexSpan ) ? std::string( ) : std::string( " -DBOLT_INDEX_TYPE=ulong" );
+}
+
+//  Bytes of an indexType element in a buffer, for indices below indexSpan
+inline size_t index_size( size_t indexSpan )
+{
+    return index_fits_32( indexSpan ) ? sizeof( cl_uint ) : sizeof( cl_ulong );
+}
+
+/*! \brief Throws CL_INVALID_BUFFER_SIZE for indices past BOLT_INDEX_32_MAX, in the algorithms whose kernels still
+ *  take 32 bit counts and offsets; message must be a string literal, as ::cl::Error keeps the pointer
+ */
+inline void index_require_32( size_t indexSpan, const char* message )
+{
+    if( indexSpan > BOLT_INDEX_32_MAX )
+        throw ::cl::Error( CL_INVALID_BUFFER_SIZE, message );
+}
+
+//  Sets an indexType argument of a kernel compiled with index_compile_options( indexSpan )
+inline cl_int index_set_arg( ::cl::Kernel& kernel, cl_uint argIndex, size_t value, size_t indexSpan )
+{
+    if( index_fits_32( indexSpan ) )
+        return kernel.setArg( argIndex, static_cast< cl_uint >( value ) );
+    return kernel.setArg( argIndex, static_cast< cl_ulong >( value ) );
+}
+
+}
+}
+}
+
+#endif
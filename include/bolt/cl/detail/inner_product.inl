@@ -254,7 +254,7 @@ namespace bolt {
                 bolt::cl::minimum< size_t >  min_size_t;
                 size_t numTailReduce = min_size_t( ceilNumWG, numWG );
 
-                bolt::cl::wait(ctl, l_mapEvent);
+                bolt::cl::wait(ctl, l_mapEvent, "inner_product");
 
                 OutputType acc = static_cast< OutputType >( init );
                 for(int i = 0; i < numTailReduce; ++i)
@@ -270,14 +270,14 @@ namespace bolt {
                 typedef std::iterator_traits<DVInputIterator>::value_type iType;
                 ::cl::Event innerproductEvent;
 
-                cl_uint distVec = static_cast< cl_uint >( std::distance( first1, last1 ) );
+                size_t distVec = static_cast< size_t >( std::distance( first1, last1 ) );
                 if( distVec == 0 )
                     return -1;
 
                 device_vector< iType > tempDV( distVec, 0, CL_MEM_READ_WRITE, false, ctl );
                 detail::transform_enqueue( ctl, first1, last1, first2, tempDV.begin() ,f2,cl_code);
                 return detail::reduce_enqueue( ctl, tempDV.begin(), tempDV.end(), init, f1, cl_code);
-                bolt::cl::wait(ctl, innerproductEvent);
+                bolt::cl::wait(ctl, innerproductEvent, "inner_product");
 
             };
 
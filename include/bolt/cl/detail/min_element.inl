@@ -15,18 +15,26 @@
 
 ***************************************************************************/
 
-#if !defined( REDUCE_INL )
-#define REDUCE_INL
+#if !defined( MIN_ELEMENT_INL )
+#define MIN_ELEMENT_INL
 #pragma once
 
 #include <algorithm>
+#include <utility>
 
 #include <boost/thread/once.hpp>
 #include <boost/bind.hpp>
 
 #include "bolt/cl/bolt.h"
 #include "bolt/cl/functional.h"
+#include "bolt/cl/detail/index_type.inl"
 
+#ifdef ENABLE_TBB
+//TBB Includes
+#include "tbb/parallel_reduce.h"
+#include "tbb/blocked_range.h"
+#include "bolt/cl/detail/tbb_arena.inl"
+#endif
 
 namespace bolt {
     namespace cl {
@@ -71,17 +79,8 @@ namespace bolt {
             BinaryPredicate binary_op,
             const std::string& cl_code)
         {
-            bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
-            if(runMode == bolt::cl::control::Automatic)
-            {
-                   runMode = ctl.getDefaultPathToRun();
-            }
-			if (runMode == bolt::cl::control::SerialCpu) {
-                return std::min_element(first, last, binary_op);
-            } else {
-                return detail::min_element_detect_random_access(ctl, first, last, binary_op, cl_code,
-                    std::iterator_traits< ForwardIterator >::iterator_category( ) );
-            }
+            return detail::min_element_detect_random_access(ctl, first, last, binary_op, cl_code,
+                std::iterator_traits< ForwardIterator >::iterator_category( ) );
         };
 
     }
@@ -131,17 +130,57 @@ namespace bolt {
             BinaryPredicate binary_op,
             const std::string& cl_code)
         {
-            bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
-            if(runMode == bolt::cl::control::Automatic)
-            {
-                  runMode = ctl.getDefaultPathToRun();
-            }
-			if (runMode == bolt::cl::control::SerialCpu) {
-                return std::min_element(first, last, binary_op);
-            } else {
-                return detail::min_element_detect_random_access(ctl, first, last, binary_op, cl_code,
-                    std::iterator_traits< ForwardIterator >::iterator_category( ) );
-            }
+            return detail::min_element_detect_random_access(ctl, first, last, binary_op, cl_code,
+                std::iterator_traits< ForwardIterator >::iterator_category( ) );
+        };
+
+    }
+
+};
+
+namespace bolt {
+    namespace cl {
+
+        template<typename ForwardIterator>
+        std::pair<ForwardIterator, ForwardIterator> minmax_element(ForwardIterator first,
+            ForwardIterator last,
+            const std::string& cl_code)
+        {
+            typedef typename std::iterator_traits<ForwardIterator>::value_type T;
+            return minmax_element(bolt::cl::control::getDefault(), first, last, bolt::cl::less<T>(), cl_code);
+        };
+
+
+        template<typename ForwardIterator,typename BinaryPredicate>
+        std::pair<ForwardIterator, ForwardIterator> minmax_element(ForwardIterator first,
+            ForwardIterator last,
+            BinaryPredicate binary_op,
+            const std::string& cl_code)
+        {
+            return minmax_element(bolt::cl::control::getDefault(), first, last, binary_op, cl_code);
+        };
+
+
+        template<typename ForwardIterator>
+        std::pair<ForwardIterator, ForwardIterator> minmax_element(bolt::cl::control &ctl,
+            ForwardIterator first,
+            ForwardIterator last,
+            const std::string& cl_code)
+        {
+            typedef typename std::iterator_traits<ForwardIterator>::value_type T;
+            return minmax_element(ctl, first, last, bolt::cl::less<T>(),cl_code);
+        };
+
+        // This template is called by all other "convenience" version of minmax_element.
+        template<typename ForwardIterator, typename BinaryPredicate>
+        std::pair<ForwardIterator, ForwardIterator> minmax_element(bolt::cl::control &ctl,
+            ForwardIterator first,
+            ForwardIterator last,
+            BinaryPredicate binary_op,
+            const std::string& cl_code)
+        {
+            return detail::minmax_element_detect_random_access(ctl, first, last, binary_op, cl_code,
+                std::iterator_traits< ForwardIterator >::iterator_category( ) );
         };
 
     }
@@ -157,6 +196,211 @@ namespace bolt {
 
         enum MineleTypes {min_iValueType, min_iIterType, min_BinaryPredicate, min_end };
 
+        ///////////////////////////////////////////////////////////////////////
+        //CPU versions
+        ///////////////////////////////////////////////////////////////////////
+
+        //  The first smallest and the last largest of [first, first + szElements), as indices, as
+        //  std::minmax_element finds them
+        template<typename InputIterator, typename BinaryPredicate>
+        std::pair<size_t, size_t> minmax_element_serial(const InputIterator& first,
+            size_t szElements,
+            const BinaryPredicate& binary_op)
+        {
+            typedef typename std::iterator_traits<InputIterator>::value_type iType;
+
+            size_t minIndex = 0, maxIndex = 0;
+            iType minValue = first[0];
+            iType maxValue = minValue;
+            for(size_t i = 1; i < szElements; ++i)
+            {
+                iType value = first[i];
+                if(binary_op(value, minValue))
+                {
+                    minValue = value;
+                    minIndex = i;
+                }
+                if(!binary_op(value, maxValue))
+                {
+                    maxValue = value;
+                    maxIndex = i;
+                }
+            }
+            return std::make_pair(minIndex, maxIndex);
+        }
+
+#ifdef ENABLE_TBB
+        //  tbb::parallel_reduce body keeping the index of the first smallest element next to its value.  TBB hands a
+        //  body its ranges in order and joins it only with bodies of ranges to its right, so a tie keeps the index
+        //  the body already has.
+        template<typename InputIterator, typename BinaryPredicate>
+        struct MinElement_tbb
+        {
+            typedef typename std::iterator_traits<InputIterator>::value_type iType;
+
+            InputIterator first;
+            BinaryPredicate binary_op;
+            iType value;
+            size_t index;
+            bool empty;
+
+            MinElement_tbb(const InputIterator& _first, const BinaryPredicate& _binary_op) :
+                first(_first), binary_op(_binary_op), index(0), empty(true)
+            {}
+
+            MinElement_tbb(MinElement_tbb& s, tbb::split) :
+                first(s.first), binary_op(s.binary_op), index(0), empty(true)
+            {}
+
+            void operator()(const tbb::blocked_range<size_t>& r)
+            {
+                size_t i = r.begin();
+                if(empty)
+                {
+                    value = first[i];
+                    index = i;
+                    empty = false;
+                    ++i;
+                }
+                for(; i < r.end(); ++i)
+                {
+                    iType element = first[i];
+                    if(binary_op(element, value))
+                    {
+                        value = element;
+                        index = i;
+                    }
+                }
+            }
+
+            void join(const MinElement_tbb& rhs)
+            {
+                if(rhs.empty)
+                    return;
+                if(empty || binary_op(rhs.value, value))
+                {
+                    value = rhs.value;
+                    index = rhs.index;
+                    empty = false;
+                }
+            }
+        };
+
+        //  tbb::parallel_reduce body of minmax_element; the smallest and the largest are tracked in the same pass,
+        //  with ties going left for the smallest and right for the largest, as in minmax_element_serial
+        template<typename InputIterator, typename BinaryPredicate>
+        struct MinMaxElement_tbb
+        {
+            typedef typename std::iterator_traits<InputIterator>::value_type iType;
+
+            InputIterator first;
+            BinaryPredicate binary_op;
+            iType minValue, maxValue;
+            size_t minIndex, maxIndex;
+            bool empty;
+
+            MinMaxElement_tbb(const InputIterator& _first, const BinaryPredicate& _binary_op) :
+                first(_first), binary_op(_binary_op), minIndex(0), maxIndex(0), empty(true)
+            {}
+
+            MinMaxElement_tbb(MinMaxElement_tbb& s, tbb::split) :
+                first(s.first), binary_op(s.binary_op), minIndex(0), maxIndex(0), empty(true)
+            {}
+
+            void operator()(const tbb::blocked_range<size_t>& r)
+            {
+                size_t i = r.begin();
+                if(empty)
+                {
+                    minValue = maxValue = first[i];
+                    minIndex = maxIndex = i;
+                    empty = false;
+                    ++i;
+                }
+                for(; i < r.end(); ++i)
+                {
+                    iType element = first[i];
+                    if(binary_op(element, minValue))
+                    {
+                        minValue = element;
+                        minIndex = i;
+                    }
+                    if(!binary_op(element, maxValue))
+                    {
+                        maxValue = element;
+                        maxIndex = i;
+                    }
+                }
+            }
+
+            void join(const MinMaxElement_tbb& rhs)
+            {
+                if(rhs.empty)
+                    return;
+                if(empty)
+                {
+                    *this = rhs;
+                    return;
+                }
+                if(binary_op(rhs.minValue, minValue))
+                {
+                    minValue = rhs.minValue;
+                    minIndex = rhs.minIndex;
+                }
+                if(!binary_op(rhs.maxValue, maxValue))
+                {
+                    maxValue = rhs.maxValue;
+                    maxIndex = rhs.maxIndex;
+                }
+            }
+        };
+#endif
+
+        //  Index of the first smallest element of a non empty range, for the SerialCpu and MultiCoreCpu modes
+        template<typename InputIterator, typename BinaryPredicate>
+        size_t min_element_cpu(bolt::cl::control &ctl,
+            bolt::cl::control::e_RunMode runMode,
+            const InputIterator& first,
+            size_t szElements,
+            const BinaryPredicate& binary_op)
+        {
+            if (runMode == bolt::cl::control::SerialCpu)
+                return static_cast< size_t >( std::min_element(first, first + szElements, binary_op) - first );
+
+#ifdef ENABLE_TBB
+            control::tbbPartitionDesc part = ctl.getTbbPartitioner( "min_element" );
+            MinElement_tbb<InputIterator, BinaryPredicate> body(first, binary_op);
+            detail::tbb_parallel_reduce( ctl, tbb::blocked_range<size_t>( 0, szElements, part.grainSize ), body,
+                part.partitioner );
+            return body.index;
+#else
+            throw ::cl::Error( CL_INVALID_OPERATION, "The MultiCoreCpu version of min_element is not enabled to be built." );
+#endif
+        }
+
+        //  Indices of the first smallest and the last largest elements of a non empty range, for the SerialCpu and
+        //  MultiCoreCpu modes
+        template<typename InputIterator, typename BinaryPredicate>
+        std::pair<size_t, size_t> minmax_element_cpu(bolt::cl::control &ctl,
+            bolt::cl::control::e_RunMode runMode,
+            const InputIterator& first,
+            size_t szElements,
+            const BinaryPredicate& binary_op)
+        {
+            if (runMode == bolt::cl::control::SerialCpu)
+                return minmax_element_serial(first, szElements, binary_op);
+
+#ifdef ENABLE_TBB
+            control::tbbPartitionDesc part = ctl.getTbbPartitioner( "min_element" );
+            MinMaxElement_tbb<InputIterator, BinaryPredicate> body(first, binary_op);
+            detail::tbb_parallel_reduce( ctl, tbb::blocked_range<size_t>( 0, szElements, part.grainSize ), body,
+                part.partitioner );
+            return std::make_pair(body.minIndex, body.maxIndex);
+#else
+            throw ::cl::Error( CL_INVALID_OPERATION, "The MultiCoreCpu version of minmax_element is not enabled to be built." );
+#endif
+        }
+
         ///////////////////////////////////////////////////////////////////////
         //Kernel Template Specializer
         ///////////////////////////////////////////////////////////////////////
@@ -200,6 +444,8 @@ namespace bolt {
                 const std::string& cl_code )
             {
                 typedef typename std::iterator_traits< DVInputIterator >::value_type iType;
+                index_require_32( static_cast< size_t >( std::distance( first, last ) ),
+                    "The OpenCL path of min_element() and max_element() takes ranges of fewer than 2^31 elements" );
 
                 std::vector<std::string> typeNames( min_end);
                 typeNames[min_iValueType] = TypeName< iType >::get( );
@@ -282,7 +528,7 @@ namespace bolt {
                 bolt::cl::minimum<size_t>  min_size_t;
                 size_t numTailReduce = min_size_t( ceilNumWG, numWG );
 
-                bolt::cl::wait(ctl, l_mapEvent);
+                bolt::cl::wait(ctl, l_mapEvent, "min_element");
 
                 int minele_indx =  h_result[0] ;
                 iType minele =  *(first + h_result[0]) ;
@@ -350,16 +596,8 @@ namespace bolt {
                 {
                     runMode = ctl.getDefaultPathToRun();
                 }
-                if (runMode == bolt::cl::control::SerialCpu) {
-                    //std::cout << "The SerialCpu version of reduce is not implemented yet." << std ::endl;
-                    throw ::cl::Error( CL_INVALID_OPERATION, "The SerialCpu version of reduce is not implemented yet." );
-                    return last;
-                } else if (runMode == bolt::cl::control::MultiCoreCpu) {
-
-                    //std::cout << "The MultiCoreCpu version of reduce is not enabled. " << std ::endl;
-                    throw ::cl::Error( CL_INVALID_OPERATION, "The MultiCoreCpu version of reduce is not enabled to be built." );
-                    return last;
-
+                if (runMode == bolt::cl::control::SerialCpu || runMode == bolt::cl::control::MultiCoreCpu) {
+                    return first + min_element_cpu( ctl, runMode, first, szElements, binary_op );
                 } else {
                 device_vector< iType > dvInput( first, last, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, ctl );
                 int  dvminele = min_element_enqueue( ctl, dvInput.begin(), dvInput.end(), binary_op, cl_code);
@@ -388,15 +626,10 @@ namespace bolt {
                 {
                     runMode = ctl.getDefaultPathToRun();
                 }
-                if (runMode == bolt::cl::control::SerialCpu) {
-                    //std::cout << "The SerialCpu version of min_element is not implemented yet." << std ::endl;
-                    throw ::cl::Error( CL_INVALID_OPERATION, "The SerialCpu version of min_element is not implemented yet." );
-                    return last;
-                } else if (runMode == bolt::cl::control::MultiCoreCpu) {
-                    /*TODO - ASK  - should we copy the device_vector to host memory, process the result and then store back the result into the device_vector.*/
-                    //std::cout << "The MultiCoreCpu version of min_element on device_vector is not supported." << std ::endl;
-                    throw ::cl::Error( CL_INVALID_OPERATION, "The MultiCoreCpu version of min_element on device_vector is not supported." );
-                    return last;
+                if (runMode == bolt::cl::control::SerialCpu || runMode == bolt::cl::control::MultiCoreCpu) {
+                    typedef typename std::iterator_traits<DVInputIterator>::value_type iType;
+                    typename bolt::cl::device_vector< iType >::pointer inputPtr = first.getContainer( ).data( );
+                    return first + min_element_cpu( ctl, runMode, &inputPtr[ first.m_Index ], szElements, binary_op );
                 } else {
                 int pos =  min_element_enqueue( ctl, first, last,  binary_op, cl_code);
                 return first+pos;
@@ -413,10 +646,263 @@ namespace bolt {
                 const std::string& cl_code,
                 bolt::cl::fancy_iterator_tag )
             {
+                size_t szElements = (size_t)(last - first);
+                if (szElements == 0)
+                    return last;
+
+                bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();
+                if(runMode == bolt::cl::control::Automatic)
+                {
+                    runMode = ctl.getDefaultPathToRun();
+                }
+                //  Fancy iterators compute their elements, on the host as well
+                if (runMode == bolt::cl::control::SerialCpu || runMode == bolt::cl::control::MultiCoreCpu)
+                    return first + min_element_cpu( ctl, runMode, first, szElements, binary_op );
+
                 int pos = min_element_enqueue( ctl, first, last,  binary_op, cl_code);
                 return first+pos;
             }
 
+            ///////////////////////////////////////////////////////////////////////
+            //minmax_element
+            ///////////////////////////////////////////////////////////////////////
+
+            enum MinMaxTypes {minmax_iValueType, minmax_iIterType, minmax_BinaryPredicate, minmax_end };
+
+            class MinMax_KernelTemplateSpecializer : public KernelTemplateSpecializer
+            {
+            public:
+
+            MinMax_KernelTemplateSpecializer() : KernelTemplateSpecializer()
+                {
+                    addKernelName( "minmax_elementTemplate" );
+                }
+
+            const ::std::string operator() ( const ::std::vector<::std::string>& typeNames ) const
+            {
+                const std::string templateSpecializationString =
+                        "// Host generates this instantiation string with user-specified value type and functor\n"
+                        "template __attribute__((mangled_name(" + name(0) + "Instantiated)))\n"
+                        "__attribute__((reqd_work_group_size(64,1,1)))\n"
+                        "kernel void " + name(0) + "(\n"
+                        "global " + typeNames[minmax_iValueType] + "* input_ptr,\n"
+                         + typeNames[minmax_iIterType] + " input_iter,\n"
+                        "const int length,\n"
+                        "global " + typeNames[minmax_BinaryPredicate] + "* userFunctor,\n"
+                        "global int *result,\n"
+                        "local " + typeNames[minmax_iValueType] + "* scratch_min,\n"
+                        "local int *scratch_min_index,\n"
+                        "local " + typeNames[minmax_iValueType] + "* scratch_max,\n"
+                        "local int *scratch_max_index\n"
+                        ");\n\n";
+
+                return templateSpecializationString;
+            }
+            };
+
+            //  Every work group of minmax_elementTemplate writes the indices of its smallest and largest elements;
+            //  the host picks among those.  Returns the indices of the first smallest and the last largest element.
+            template<typename DVInputIterator, typename BinaryPredicate>
+            std::pair<int, int> minmax_element_enqueue(bolt::cl::control &ctl,
+                const DVInputIterator& first,
+                const DVInputIterator& last,
+                const BinaryPredicate& binary_op,
+                const std::string& cl_code )
+            {
+                typedef typename std::iterator_traits< DVInputIterator >::value_type iType;
+                index_require_32( static_cast< size_t >( std::distance( first, last ) ),
+                    "The OpenCL path of minmax_element() takes ranges of fewer than 2^31 elements" );
+
+                std::vector<std::string> typeNames( minmax_end );
+                typeNames[minmax_iValueType] = TypeName< iType >::get( );
+                typeNames[minmax_iIterType] = TypeName< DVInputIterator >::get( );
+                typeNames[minmax_BinaryPredicate] = TypeName< BinaryPredicate >::get();
+
+                std::vector<std::string> typeDefinitions;
+                if( !cl_code.empty( ) )
+                    typeDefinitions.push_back( cl_code );
+                PUSH_BACK_UNIQUE( typeDefinitions, ClCode< iType >::get() )
+                PUSH_BACK_UNIQUE( typeDefinitions, ClCode< DVInputIterator >::get() )
+                PUSH_BACK_UNIQUE( typeDefinitions, ClCode< BinaryPredicate  >::get() )
+
+                MinMax_KernelTemplateSpecializer mm_kts;
+                std::vector< ::cl::Kernel > kernels = bolt::cl::getKernels(
+                    ctl,
+                    typeNames,
+                    &mm_kts,
+                    typeDefinitions,
+                    min_element_kernels,
+                    std::string( ) );
+
+                //  The reduction steps of the kernel are unrolled for the work group size it requires
+                const size_t wgSize = 64;
+                cl_uint computeUnits = ctl.getDevice().getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
+                size_t numWG = computeUnits * ctl.getWGPerComputeUnit();
+
+                cl_int szElements = static_cast< cl_int >( first.distance_to( last ) );
+                size_t ceilNumWG = ( szElements + wgSize - 1 ) / wgSize;
+                numWG = std::min( numWG, ceilNumWG );
+
+                ALIGNED( 256 ) BinaryPredicate aligned_binary( binary_op );
+                control::buffPointer userFunctor = ctl.acquireBuffer( sizeof( aligned_binary ),
+                    CL_MEM_COPY_HOST_PTR|CL_MEM_READ_ONLY, &aligned_binary );
+                control::buffPointer result = ctl.acquireBuffer( sizeof( int ) * 2 * numWG,
+                    CL_MEM_ALLOC_HOST_PTR|CL_MEM_WRITE_ONLY );
+
+                V_OPENCL( kernels[0].setArg(0, first.getBuffer( ) ), "Error setting kernel argument" );
+                V_OPENCL( kernels[0].setArg(1, first.gpuPayloadSize( ), &first.gpuPayload( ) ), "Error setting a kernel argument" );
+                V_OPENCL( kernels[0].setArg(2, szElements), "Error setting kernel argument" );
+                V_OPENCL( kernels[0].setArg(3, *userFunctor), "Error setting kernel argument" );
+                V_OPENCL( kernels[0].setArg(4, *result), "Error setting kernel argument" );
+
+                ::cl::LocalSpaceArg values, indices;
+                values.size_ = wgSize*sizeof(iType);
+                indices.size_ = wgSize*sizeof(int);
+                V_OPENCL( kernels[0].setArg(5, values), "Error setting kernel argument" );
+                V_OPENCL( kernels[0].setArg(6, indices), "Error setting kernel argument" );
+                V_OPENCL( kernels[0].setArg(7, values), "Error setting kernel argument" );
+                V_OPENCL( kernels[0].setArg(8, indices), "Error setting kernel argument" );
+
+                cl_int l_Error = ctl.getCommandQueue().enqueueNDRangeKernel(
+                    kernels[0],
+                    ::cl::NullRange,
+                    ::cl::NDRange(numWG * wgSize),
+                    ::cl::NDRange(wgSize));
+                V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for minmax_element() kernel" );
+
+                ::cl::Event l_mapEvent;
+                int *h_result = (int*)ctl.getCommandQueue().enqueueMapBuffer(*result, false, CL_MAP_READ, 0,
+                    sizeof(int) * 2 * numWG, NULL, &l_mapEvent, &l_Error );
+                V_OPENCL( l_Error, "Error calling map on the result buffer" );
+                bolt::cl::wait(ctl, l_mapEvent, "minmax_element");
+
+                //  Ties go to the lower index for the smallest and to the higher index for the largest
+                int minIndex = h_result[0], maxIndex = h_result[1];
+                iType minValue = *(first + minIndex);
+                iType maxValue = *(first + maxIndex);
+                for(size_t i = 1; i < numWG; ++i)
+                {
+                    int index = h_result[2 * i];
+                    iType value = *(first + index);
+                    if( binary_op(value, minValue) || (!binary_op(minValue, value) && index < minIndex) )
+                    {
+                        minValue = value;
+                        minIndex = index;
+                    }
+                    index = h_result[2 * i + 1];
+                    value = *(first + index);
+                    if( binary_op(maxValue, value) || (!binary_op(value, maxValue) && index > maxIndex) )
+                    {
+                        maxValue = value;
+                        maxIndex = index;
+                    }
+                }
+
+                ::cl::Event l_unmapEvent;
+                V_OPENCL( ctl.getCommandQueue().enqueueUnmapMemObject(*result, h_result, NULL, &l_unmapEvent ),
+                    "Error calling unmap on the result buffer" );
+                bolt::cl::wait(ctl, l_unmapEvent, "minmax_element");
+
+                return std::make_pair(minIndex, maxIndex);
+            }
+
+            template<typename ForwardIterator, typename BinaryPredicate>
+            std::pair<ForwardIterator, ForwardIterator> minmax_element_detect_random_access(bolt::cl::control &ctl,
+                const ForwardIterator& first,
+                const ForwardIterator& last,
+                const BinaryPredicate& binary_op,
+                const std::string& cl_code,
+                std::input_iterator_tag)
+            {
+                static_assert( false, "Bolt only supports random access iterator types" );
+            }
+
+            template<typename ForwardIterator, typename BinaryPredicate>
+            std::pair<ForwardIterator, ForwardIterator> minmax_element_detect_random_access(bolt::cl::control &ctl,
+                const ForwardIterator& first,
+                const ForwardIterator& last,
+                const BinaryPredicate& binary_op,
+                const std::string& cl_code,
+                std::random_access_iterator_tag)
+            {
+                if (first == last)
+                    return std::make_pair(last, last);
+
+                bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();
+                if(runMode == bolt::cl::control::Automatic)
+                {
+                    runMode = ctl.getDefaultPathToRun();
+                }
+                return minmax_element_pick_iterator( ctl, runMode, first, last, binary_op, cl_code,
+                    std::iterator_traits< ForwardIterator >::iterator_category( ) );
+            }
+
+            // This is called strictly for any non-device_vector iterator
+            template<typename ForwardIterator, typename BinaryPredicate>
+            std::pair<ForwardIterator, ForwardIterator> minmax_element_pick_iterator(bolt::cl::control &ctl,
+                bolt::cl::control::e_RunMode runMode,
+                const ForwardIterator& first,
+                const ForwardIterator& last,
+                const BinaryPredicate& binary_op,
+                const std::string& cl_code,
+                std::random_access_iterator_tag )
+            {
+                typedef typename std::iterator_traits<ForwardIterator>::value_type iType;
+                size_t szElements = (size_t)(last - first);
+
+                std::pair<size_t, size_t> indices;
+                if (runMode == bolt::cl::control::SerialCpu || runMode == bolt::cl::control::MultiCoreCpu) {
+                    indices = minmax_element_cpu( ctl, runMode, first, szElements, binary_op );
+                } else {
+                    device_vector< iType > dvInput( first, last, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, ctl );
+                    indices = minmax_element_enqueue( ctl, dvInput.begin(), dvInput.end(), binary_op, cl_code );
+                }
+                return std::make_pair( first + indices.first, first + indices.second );
+            }
+
+            // This is called strictly for iterators that are derived from device_vector< T >::iterator
+            template<typename DVInputIterator, typename BinaryPredicate>
+            std::pair<DVInputIterator, DVInputIterator> minmax_element_pick_iterator(bolt::cl::control &ctl,
+                bolt::cl::control::e_RunMode runMode,
+                const DVInputIterator& first,
+                const DVInputIterator& last,
+                const BinaryPredicate& binary_op,
+                const std::string& cl_code,
+                bolt::cl::device_vector_tag )
+            {
+                typedef typename std::iterator_traits<DVInputIterator>::value_type iType;
+                size_t szElements = (size_t)(last - first);
+
+                std::pair<size_t, size_t> indices;
+                if (runMode == bolt::cl::control::SerialCpu || runMode == bolt::cl::control::MultiCoreCpu) {
+                    typename bolt::cl::device_vector< iType >::pointer inputPtr = first.getContainer( ).data( );
+                    indices = minmax_element_cpu( ctl, runMode, &inputPtr[ first.m_Index ], szElements, binary_op );
+                } else {
+                    indices = minmax_element_enqueue( ctl, first, last, binary_op, cl_code );
+                }
+                return std::make_pair( first + indices.first, first + indices.second );
+            }
+
+            // Fancy iterators compute their elements, on the host as well
+            template<typename DVInputIterator, typename BinaryPredicate>
+            std::pair<DVInputIterator, DVInputIterator> minmax_element_pick_iterator(bolt::cl::control &ctl,
+                bolt::cl::control::e_RunMode runMode,
+                const DVInputIterator& first,
+                const DVInputIterator& last,
+                const BinaryPredicate& binary_op,
+                const std::string& cl_code,
+                bolt::cl::fancy_iterator_tag )
+            {
+                size_t szElements = (size_t)(last - first);
+
+                std::pair<size_t, size_t> indices;
+                if (runMode == bolt::cl::control::SerialCpu || runMode == bolt::cl::control::MultiCoreCpu)
+                    indices = minmax_element_cpu( ctl, runMode, first, szElements, binary_op );
+                else
+                    indices = minmax_element_enqueue( ctl, first, last, binary_op, cl_code );
+                return std::make_pair( first + indices.first, first + indices.second );
+            }
+
 
         }
     }
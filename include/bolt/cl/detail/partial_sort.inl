@@ -0,0 +1,582 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#if !defined( OCL_PARTIAL_SORT_INL )
+#define OCL_PARTIAL_SORT_INL
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+
+#include "bolt/cl/functional.h"
+#include "bolt/cl/device_vector.h"
+#include "bolt/cl/sort.h"
+#include "bolt/cl/detail/radix_select.inl"
+#ifdef ENABLE_TBB
+#include "bolt/cl/detail/tbb_select.inl"
+#endif
+
+namespace bolt {
+namespace cl {
+
+    template<typename RandomAccessIterator>
+    void nth_element(control &ctl,
+        RandomAccessIterator first,
+        RandomAccessIterator nth,
+        RandomAccessIterator last,
+        const std::string& cl_code)
+    {
+        typedef typename std::iterator_traits< RandomAccessIterator >::value_type T;
+
+        detail::select_detect_random_access( ctl, first, nth, last, less< T >( ), false, cl_code,
+                                             std::iterator_traits< RandomAccessIterator >::iterator_category( ) );
+    }
+
+    template<typename RandomAccessIterator>
+    void nth_element(RandomAccessIterator first,
+        RandomAccessIterator nth,
+        RandomAccessIterator last,
+        const std::string& cl_code)
+    {
+        typedef typename std::iterator_traits< RandomAccessIterator >::value_type T;
+
+        detail::select_detect_random_access( control::getDefault( ), first, nth, last, less< T >( ), false, cl_code,
+                                             std::iterator_traits< RandomAccessIterator >::iterator_category( ) );
+    }
+
+    template<typename RandomAccessIterator, typename StrictWeakOrdering>
+    void nth_element(control &ctl,
+        RandomAccessIterator first,
+        RandomAccessIterator nth,
+        RandomAccessIterator last,
+        StrictWeakOrdering comp,
+        const std::string& cl_code)
+    {
+        detail::select_detect_random_access( ctl, first, nth, last, comp, false, cl_code,
+                                             std::iterator_traits< RandomAccessIterator >::iterator_category( ) );
+    }
+
+    template<typename RandomAccessIterator, typename StrictWeakOrdering>
+    void nth_element(RandomAccessIterator first,
+        RandomAccessIterator nth,
+        RandomAccessIterator last,
+        StrictWeakOrdering comp,
+        const std::string& cl_code)
+    {
+        detail::select_detect_random_access( control::getDefault( ), first, nth, last, comp, false, cl_code,
+                                             std::iterator_traits< RandomAccessIterator >::iterator_category( ) );
+    }
+
+    template<typename RandomAccessIterator>
+    void partial_sort(control &ctl,
+        RandomAccessIterator first,
+        RandomAccessIterator middle,
+        RandomAccessIterator last,
+        const std::string& cl_code)
+    {
+        typedef typename std::iterator_traits< RandomAccessIterator >::value_type T;
+
+        if( middle == first )
+            return;
+        detail::select_detect_random_access( ctl, first, middle - 1, last, less< T >( ), true, cl_code,
+                                             std::iterator_traits< RandomAccessIterator >::iterator_category( ) );
+    }
+
+    template<typename RandomAccessIterator>
+    void partial_sort(RandomAccessIterator first,
+        RandomAccessIterator middle,
+        RandomAccessIterator last,
+        const std::string& cl_code)
+    {
+        typedef typename std::iterator_traits< RandomAccessIterator >::value_type T;
+
+        if( middle == first )
+            return;
+        detail::select_detect_random_access( control::getDefault( ), first, middle - 1, last, less< T >( ), true,
+                                             cl_code,
+                                             std::iterator_traits< RandomAccessIterator >::iterator_category( ) );
+    }
+
+    template<typename RandomAccessIterator, typename StrictWeakOrdering>
+    void partial_sort(control &ctl,
+        RandomAccessIterator first,
+        RandomAccessIterator middle,
+        RandomAccessIterator last,
+        StrictWeakOrdering comp,
+        const std::string& cl_code)
+    {
+        if( middle == first )
+            return;
+        detail::select_detect_random_access( ctl, first, middle - 1, last, comp, true, cl_code,
+                                             std::iterator_traits< RandomAccessIterator >::iterator_category( ) );
+    }
+
+    template<typename RandomAccessIterator, typename StrictWeakOrdering>
+    void partial_sort(RandomAccessIterator first,
+        RandomAccessIterator middle,
+        RandomAccessIterator last,
+        StrictWeakOrdering comp,
+        const std::string& cl_code)
+    {
+        if( middle == first )
+            return;
+        detail::select_detect_random_access( control::getDefault( ), first, middle - 1, last, comp, true, cl_code,
+                                             std::iterator_traits< RandomAccessIterator >::iterator_category( ) );
+    }
+
+    template<typename RandomAccessIterator, typename OutputIterator>
+    OutputIterator top_k(control &ctl,
+        RandomAccessIterator first,
+        RandomAccessIterator last,
+        size_t k,
+        OutputIterator result,
+        const std::string& cl_code)
+    {
+        typedef typename std::iterator_traits< RandomAccessIterator >::value_type T;
+
+        return detail::top_k_detect_random_access( ctl, first, last, k, result, less< T >( ), cl_code,
+                                                   std::iterator_traits< RandomAccessIterator >::iterator_category( ) );
+    }
+
+    template<typename RandomAccessIterator, typename OutputIterator>
+    OutputIterator top_k(RandomAccessIterator first,
+        RandomAccessIterator last,
+        size_t k,
+        OutputIterator result,
+        const std::string& cl_code)
+    {
+        typedef typename std::iterator_traits< RandomAccessIterator >::value_type T;
+
+        return detail::top_k_detect_random_access( control::getDefault( ), first, last, k, result, less< T >( ),
+                                                   cl_code,
+                                                   std::iterator_traits< RandomAccessIterator >::iterator_category( ) );
+    }
+
+    template<typename RandomAccessIterator, typename OutputIterator, typename StrictWeakOrdering>
+    OutputIterator top_k(control &ctl,
+        RandomAccessIterator first,
+        RandomAccessIterator last,
+        size_t k,
+        OutputIterator result,
+        StrictWeakOrdering comp,
+        const std::string& cl_code)
+    {
+        return detail::top_k_detect_random_access( ctl, first, last, k, result, comp, cl_code,
+                                                   std::iterator_traits< RandomAccessIterator >::iterator_category( ) );
+    }
+
+    template<typename RandomAccessIterator, typename OutputIterator, typename StrictWeakOrdering>
+    OutputIterator top_k(RandomAccessIterator first,
+        RandomAccessIterator last,
+        size_t k,
+        OutputIterator result,
+        StrictWeakOrdering comp,
+        const std::string& cl_code)
+    {
+        return detail::top_k_detect_random_access( control::getDefault( ), first, last, k, result, comp, cl_code,
+                                                   std::iterator_traits< RandomAccessIterator >::iterator_category( ) );
+    }
+
+namespace detail {
+
+    /**************************************************************************
+     * OpenCL paths
+     *************************************************************************/
+
+    /*! \brief Puts the element of rank nth - first at nth, with the lesser elements before it; when sortFront is
+     *  set, the elements up to and including nth are sorted as well
+     *  \details Radix select for arithmetic keys with less or greater.  The elements before the first one equal to
+     *  the pivot are the only ones left to sort, since the rest of [first, nth] are all equal.
+     */
+    template< typename DVRandomAccessIterator, typename StrictWeakOrdering >
+    typename std::enable_if< radix_sort_enabled< typename std::iterator_traits< DVRandomAccessIterator >::value_type,
+                                                 StrictWeakOrdering
+                                               >::value
+                           >::type
+    select_enqueue( control &ctl, const DVRandomAccessIterator& first, const DVRandomAccessIterator& nth,
+                    const DVRandomAccessIterator& last, const StrictWeakOrdering& comp, bool sortFront,
+                    const std::string& cl_code )
+    {
+        typedef typename std::iterator_traits< DVRandomAccessIterator >::value_type T;
+        cl_int l_Error = CL_SUCCESS;
+        size_t szElements = static_cast< size_t >( std::distance( first, last ) );
+        size_t rank = static_cast< size_t >( std::distance( first, nth ) );
+        bool descending = std::is_same< StrictWeakOrdering, bolt::cl::greater< T > >::value;
+
+        radixSelection selection = radix_select_enqueue< T >( ctl, first.getBuffer( ), first.m_Index, szElements,
+                                                              rank, descending );
+
+        ::cl::Buffer partitioned( ctl.getContext( ), CL_MEM_READ_WRITE, sizeof( T ) * szElements, NULL, &l_Error );
+        V_OPENCL( l_Error, "Error creating the nth_element partition buffer" );
+        radix_select_partition_enqueue< T >( ctl, first.getBuffer( ), first.m_Index, szElements, selection,
+                                             selection.equalCount, true, descending, partitioned, 0 );
+        V_OPENCL( ctl.getCommandQueue( ).enqueueCopyBuffer( partitioned, first.getBuffer( ), 0,
+                                                            first.m_Index * sizeof( T ), sizeof( T ) * szElements ),
+                  "Error copying the partitioned elements back into the range" );
+
+        if( sortFront && selection.lessCount > 1 )
+            sort_enqueue( ctl, first, first + static_cast< std::ptrdiff_t >( selection.lessCount ), comp, cl_code );
+
+        ::cl::Event selectEvent;
+        V_OPENCL( ctl.getCommandQueue( ).clEnqueueBarrierWithWaitList( NULL, &selectEvent ),
+                  "Error calling clEnqueueBarrierWithWaitList on the command queue" );
+        bolt::cl::wait( ctl, selectEvent, sortFront ? "partial_sort" : "nth_element" );
+    }
+
+    //  Any other type or comparator: a sorted range satisfies both nth_element and partial_sort
+    template< typename DVRandomAccessIterator, typename StrictWeakOrdering >
+    typename std::enable_if<
+        !radix_sort_enabled< typename std::iterator_traits< DVRandomAccessIterator >::value_type,
+                             StrictWeakOrdering >::value
+                           >::type
+    select_enqueue( control &ctl, const DVRandomAccessIterator& first, const DVRandomAccessIterator& nth,
+                    const DVRandomAccessIterator& last, const StrictWeakOrdering& comp, bool sortFront,
+                    const std::string& cl_code )
+    {
+        sort_enqueue( ctl, first, last, comp, cl_code );
+    }
+
+    /*! \brief Writes the k first elements of [first, last) in the order of comp, sorted, to result
+     *  \details Radix select for arithmetic keys with less or greater.  The partition writes only the k selected
+     *  elements, straight to the output.
+     */
+    template< typename DVRandomAccessIterator, typename DVOutputIterator, typename StrictWeakOrdering >
+    typename std::enable_if< radix_sort_enabled< typename std::iterator_traits< DVRandomAccessIterator >::value_type,
+                                                 StrictWeakOrdering
+                                               >::value
+                           >::type
+    top_k_enqueue( control &ctl, const DVRandomAccessIterator& first, const DVRandomAccessIterator& last, size_t k,
+                   const DVOutputIterator& result, const StrictWeakOrdering& comp, const std::string& cl_code )
+    {
+        typedef typename std::iterator_traits< DVRandomAccessIterator >::value_type T;
+        size_t szElements = static_cast< size_t >( std::distance( first, last ) );
+        bool descending = std::is_same< StrictWeakOrdering, bolt::cl::greater< T > >::value;
+
+        radixSelection selection = radix_select_enqueue< T >( ctl, first.getBuffer( ), first.m_Index, szElements,
+                                                              k - 1, descending );
+        radix_select_partition_enqueue< T >( ctl, first.getBuffer( ), first.m_Index, szElements, selection,
+                                             k - selection.lessCount, false, descending, result.getBuffer( ),
+                                             result.m_Index );
+
+        if( selection.lessCount > 1 )
+            sort_enqueue( ctl, result, result + static_cast< std::ptrdiff_t >( selection.lessCount ), comp, cl_code );
+
+        ::cl::Event topKEvent;
+        V_OPENCL( ctl.getCommandQueue( ).clEnqueueBarrierWithWaitList( NULL, &topKEvent ),
+                  "Error calling clEnqueueBarrierWithWaitList on the command queue" );
+        bolt::cl::wait( ctl, topKEvent, "top_k" );
+    }
+
+    //  Any other type or comparator: sorts a copy of the input, and copies the first k elements of it out
+    template< typename DVRandomAccessIterator, typename DVOutputIterator, typename StrictWeakOrdering >
+    typename std::enable_if<
+        !radix_sort_enabled< typename std::iterator_traits< DVRandomAccessIterator >::value_type,
+                             StrictWeakOrdering >::value
+                           >::type
+    top_k_enqueue( control &ctl, const DVRandomAccessIterator& first, const DVRandomAccessIterator& last, size_t k,
+                   const DVOutputIterator& result, const StrictWeakOrdering& comp, const std::string& cl_code )
+    {
+        typedef typename std::iterator_traits< DVRandomAccessIterator >::value_type T;
+        size_t szElements = static_cast< size_t >( std::distance( first, last ) );
+
+        device_vector< T > sorted( szElements, T( ), CL_MEM_READ_WRITE, false, ctl );
+        V_OPENCL( ctl.getCommandQueue( ).enqueueCopyBuffer( first.getBuffer( ), sorted.begin( ).getBuffer( ),
+                                                            first.m_Index * sizeof( T ), 0, sizeof( T ) * szElements ),
+                  "Error copying the input of top_k" );
+        sort_enqueue( ctl, sorted.begin( ), sorted.end( ), comp, cl_code );
+        V_OPENCL( ctl.getCommandQueue( ).enqueueCopyBuffer( sorted.begin( ).getBuffer( ), result.getBuffer( ), 0,
+                                                            result.m_Index * sizeof( T ), sizeof( T ) * k ),
+                  "Error copying the result of top_k" );
+
+        ::cl::Event topKEvent;
+        V_OPENCL( ctl.getCommandQueue( ).clEnqueueBarrierWithWaitList( NULL, &topKEvent ),
+                  "Error calling clEnqueueBarrierWithWaitList on the command queue" );
+        bolt::cl::wait( ctl, topKEvent, "top_k" );
+    }
+
+    /**************************************************************************
+     * nth_element and partial_sort dispatch
+     *************************************************************************/
+
+    //  The CPU paths; sortFront selects partial_sort of [first, nth]
+    template< typename T, typename StrictWeakOrdering >
+    void select_cpu( control &ctl, bolt::cl::control::e_RunMode runMode, T* first, T* nth, T* last,
+                     const StrictWeakOrdering& comp, bool sortFront )
+    {
+        if( runMode == bolt::cl::control::SerialCpu )
+        {
+            if( sortFront )
+                std::partial_sort( first, nth + 1, last, comp );
+            else
+                std::nth_element( first, nth, last, comp );
+        }
+        else
+        {
+#ifdef ENABLE_TBB
+            if( sortFront )
+                tbb_parallel_partial_sort( ctl, first, nth + 1, last, comp );
+            else
+                tbb_parallel_nth_element( ctl, first, nth, last, comp );
+#else
+            throw ::cl::Error( CL_INVALID_OPERATION, sortFront ?
+                               "The MultiCoreCpu version of partial_sort is not enabled to be built." :
+                               "The MultiCoreCpu version of nth_element is not enabled to be built." );
+#endif
+        }
+    }
+
+    template< typename RandomAccessIterator, typename StrictWeakOrdering >
+    void select_detect_random_access( control &ctl, const RandomAccessIterator& first,
+                                      const RandomAccessIterator& nth, const RandomAccessIterator& last,
+                                      const StrictWeakOrdering& comp, bool sortFront, const std::string& cl_code,
+                                      std::input_iterator_tag )
+    {
+        static_assert( false, "Bolt only supports random access iterator types" );
+    }
+
+    template< typename RandomAccessIterator, typename StrictWeakOrdering >
+    void select_detect_random_access( control &ctl, const RandomAccessIterator& first,
+                                      const RandomAccessIterator& nth, const RandomAccessIterator& last,
+                                      const StrictWeakOrdering& comp, bool sortFront, const std::string& cl_code,
+                                      std::random_access_iterator_tag )
+    {
+        //  An nth at last selects nothing
+        if( std::distance( first, nth ) >= std::distance( first, last ) )
+            return;
+        select_pick_iterator( ctl, first, nth, last, comp, sortFront, cl_code,
+                              std::iterator_traits< RandomAccessIterator >::iterator_category( ) );
+    }
+
+    template< typename DVRandomAccessIterator, typename StrictWeakOrdering >
+    void select_pick_iterator( control &ctl, const DVRandomAccessIterator& first,
+                               const DVRandomAccessIterator& nth, const DVRandomAccessIterator& last,
+                               const StrictWeakOrdering& comp, bool sortFront, const std::string& cl_code,
+                               bolt::cl::fancy_iterator_tag )
+    {
+        static_assert( false, "It is not possible to reorder fancy iterators. They are not mutable" );
+    }
+
+    template< typename RandomAccessIterator, typename StrictWeakOrdering >
+    void select_pick_iterator( control &ctl, const RandomAccessIterator& first,
+                               const RandomAccessIterator& nth, const RandomAccessIterator& last,
+                               const StrictWeakOrdering& comp, bool sortFront, const std::string& cl_code,
+                               std::random_access_iterator_tag )
+    {
+        typedef typename std::iterator_traits< RandomAccessIterator >::value_type T;
+        size_t szElements = static_cast< size_t >( last - first );
+
+        bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode( );
+        if( runMode == bolt::cl::control::Automatic )
+        {
+            runMode = ctl.getDefaultPathToRun( );
+        }
+
+        if( runMode == bolt::cl::control::SerialCpu || runMode == bolt::cl::control::MultiCoreCpu
+            || szElements < BITONIC_SORT_WGSIZE )
+        {
+            if( szElements < BITONIC_SORT_WGSIZE )
+                runMode = bolt::cl::control::SerialCpu;
+            T* rangeFirst = &*first;
+            select_cpu( ctl, runMode, rangeFirst, rangeFirst + ( nth - first ), rangeFirst + szElements, comp,
+                        sortFront );
+        }
+        else
+        {
+            device_vector< T > dvInputOutput( first, last, CL_MEM_USE_HOST_PTR | CL_MEM_READ_WRITE, ctl );
+            select_enqueue( ctl, dvInputOutput.begin( ), dvInputOutput.begin( ) + ( nth - first ),
+                            dvInputOutput.end( ), comp, sortFront, cl_code );
+            dvInputOutput.data( );
+        }
+    }
+
+    template< typename DVRandomAccessIterator, typename StrictWeakOrdering >
+    void select_pick_iterator( control &ctl, const DVRandomAccessIterator& first,
+                               const DVRandomAccessIterator& nth, const DVRandomAccessIterator& last,
+                               const StrictWeakOrdering& comp, bool sortFront, const std::string& cl_code,
+                               bolt::cl::device_vector_tag )
+    {
+        typedef typename std::iterator_traits< DVRandomAccessIterator >::value_type T;
+        size_t szElements = static_cast< size_t >( std::distance( first, last ) );
+
+        bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode( );
+        if( runMode == bolt::cl::control::Automatic )
+        {
+            runMode = ctl.getDefaultPathToRun( );
+        }
+
+        if( runMode == bolt::cl::control::SerialCpu || runMode == bolt::cl::control::MultiCoreCpu )
+        {
+            typename bolt::cl::device_vector< T >::pointer firstPtr = first.getContainer( ).data( );
+            T* rangeFirst = &firstPtr[ first.m_Index ];
+            select_cpu( ctl, runMode, rangeFirst, rangeFirst + std::distance( first, nth ), rangeFirst + szElements,
+                        comp, sortFront );
+        }
+        else
+        {
+            select_enqueue( ctl, first, nth, last, comp, sortFront, cl_code );
+        }
+    }
+
+    /**************************************************************************
+     * top_k dispatch
+     *************************************************************************/
+
+    template< typename T, typename StrictWeakOrdering >
+    void top_k_cpu( control &ctl, bolt::cl::control::e_RunMode runMode, const T* first, const T* last, size_t k,
+                    T* result, const StrictWeakOrdering& comp )
+    {
+        if( runMode == bolt::cl::control::SerialCpu )
+        {
+            std::partial_sort_copy( first, last, result, result + k, comp );
+        }
+        else
+        {
+#ifdef ENABLE_TBB
+            tbb_parallel_top_k( ctl, first, last, k, result, comp );
+#else
+            throw ::cl::Error( CL_INVALID_OPERATION, "The MultiCoreCpu version of top_k is not enabled to be built." );
+#endif
+        }
+    }
+
+    template< typename RandomAccessIterator, typename OutputIterator, typename StrictWeakOrdering >
+    OutputIterator top_k_detect_random_access( control &ctl, const RandomAccessIterator& first,
+                                               const RandomAccessIterator& last, size_t k,
+                                               const OutputIterator& result, const StrictWeakOrdering& comp,
+                                               const std::string& cl_code, std::input_iterator_tag )
+    {
+        static_assert( false, "Bolt only supports random access iterator types" );
+        return result;
+    }
+
+    template< typename RandomAccessIterator, typename OutputIterator, typename StrictWeakOrdering >
+    OutputIterator top_k_detect_random_access( control &ctl, const RandomAccessIterator& first,
+                                               const RandomAccessIterator& last, size_t k,
+                                               const OutputIterator& result, const StrictWeakOrdering& comp,
+                                               const std::string& cl_code, std::random_access_iterator_tag )
+    {
+        k = std::min( k, static_cast< size_t >( std::distance( first, last ) ) );
+        if( k == 0 )
+            return result;
+
+        top_k_pick_iterator( ctl, first, last, k, result, comp, cl_code,
+                             std::iterator_traits< RandomAccessIterator >::iterator_category( ),
+                             std::iterator_traits< OutputIterator >::iterator_category( ) );
+        return result + static_cast< std::ptrdiff_t >( k );
+    }
+
+    template< typename RandomAccessIterator, typename OutputIterator, typename StrictWeakOrdering,
+              typename OutputTag >
+    void top_k_pick_iterator( control &ctl, const RandomAccessIterator& first, const RandomAccessIterator& last,
+                              size_t k, const OutputIterator& result, const StrictWeakOrdering& comp,
+                              const std::string& cl_code, bolt::cl::fancy_iterator_tag, OutputTag )
+    {
+        static_assert( false, "top_k of fancy iterators is not supported yet" );
+    }
+
+    template< typename RandomAccessIterator, typename OutputIterator, typename StrictWeakOrdering >
+    void top_k_pick_iterator( control &ctl, const RandomAccessIterator& first, const RandomAccessIterator& last,
+                              size_t k, const OutputIterator& result, const StrictWeakOrdering& comp,
+                              const std::string& cl_code, std::random_access_iterator_tag,
+                              std::random_access_iterator_tag )
+    {
+        typedef typename std::iterator_traits< RandomAccessIterator >::value_type T;
+        size_t szElements = static_cast< size_t >( last - first );
+
+        bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode( );
+        if( runMode == bolt::cl::control::Automatic )
+        {
+            runMode = ctl.getDefaultPathToRun( );
+        }
+
+        if( runMode == bolt::cl::control::SerialCpu || runMode == bolt::cl::control::MultiCoreCpu
+            || szElements < BITONIC_SORT_WGSIZE )
+        {
+            if( szElements < BITONIC_SORT_WGSIZE )
+                runMode = bolt::cl::control::SerialCpu;
+            const T* rangeFirst = &*first;
+            top_k_cpu( ctl, runMode, rangeFirst, rangeFirst + szElements, k, &*result, comp );
+        }
+        else
+        {
+            device_vector< T > dvInput( first, last, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, ctl );
+            device_vector< T > dvResult( result, k, CL_MEM_USE_HOST_PTR | CL_MEM_READ_WRITE, false, ctl );
+            top_k_enqueue( ctl, dvInput.begin( ), dvInput.end( ), k, dvResult.begin( ), comp, cl_code );
+            dvResult.data( );
+        }
+    }
+
+    template< typename DVRandomAccessIterator, typename DVOutputIterator, typename StrictWeakOrdering >
+    void top_k_pick_iterator( control &ctl, const DVRandomAccessIterator& first, const DVRandomAccessIterator& last,
+                              size_t k, const DVOutputIterator& result, const StrictWeakOrdering& comp,
+                              const std::string& cl_code, bolt::cl::device_vector_tag, bolt::cl::device_vector_tag )
+    {
+        typedef typename std::iterator_traits< DVRandomAccessIterator >::value_type T;
+        size_t szElements = static_cast< size_t >( std::distance( first, last ) );
+
+        bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode( );
+        if( runMode == bolt::cl::control::Automatic )
+        {
+            runMode = ctl.getDefaultPathToRun( );
+        }
+
+        if( runMode == bolt::cl::control::SerialCpu || runMode == bolt::cl::control::MultiCoreCpu )
+        {
+            typename bolt::cl::device_vector< T >::pointer firstPtr = first.getContainer( ).data( );
+            typename bolt::cl::device_vector< T >::pointer resultPtr = result.getContainer( ).data( );
+            const T* rangeFirst = &firstPtr[ first.m_Index ];
+            top_k_cpu( ctl, runMode, rangeFirst, rangeFirst + szElements, k, &resultPtr[ result.m_Index ], comp );
+        }
+        else
+        {
+            top_k_enqueue( ctl, first, last, k, result, comp, cl_code );
+        }
+    }
+
+    //  A device_vector input with a host output, or the other way around, goes through the host
+    template< typename RandomAccessIterator, typename OutputIterator, typename StrictWeakOrdering >
+    void top_k_pick_iterator( control &ctl, const RandomAccessIterator& first, const RandomAccessIterator& last,
+                              size_t k, const OutputIterator& result, const StrictWeakOrdering& comp,
+                              const std::string& cl_code, bolt::cl::device_vector_tag,
+                              std::random_access_iterator_tag )
+    {
+        typedef typename std::iterator_traits< RandomAccessIterator >::value_type T;
+
+        device_vector< T > dvResult( result, k, CL_MEM_USE_HOST_PTR | CL_MEM_READ_WRITE, false, ctl );
+        top_k_pick_iterator( ctl, first, last, k, dvResult.begin( ), comp, cl_code, bolt::cl::device_vector_tag( ),
+                             bolt::cl::device_vector_tag( ) );
+        dvResult.data( );
+    }
+
+    template< typename RandomAccessIterator, typename OutputIterator, typename StrictWeakOrdering >
+    void top_k_pick_iterator( control &ctl, const RandomAccessIterator& first, const RandomAccessIterator& last,
+                              size_t k, const OutputIterator& result, const StrictWeakOrdering& comp,
+                              const std::string& cl_code, std::random_access_iterator_tag,
+                              bolt::cl::device_vector_tag )
+    {
+        typedef typename std::iterator_traits< RandomAccessIterator >::value_type T;
+
+        device_vector< T > dvInput( first, last, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, ctl );
+        top_k_pick_iterator( ctl, dvInput.begin( ), dvInput.end( ), k, result, comp, cl_code,
+                             bolt::cl::device_vector_tag( ), bolt::cl::device_vector_tag( ) );
+    }
+
+}//namespace bolt::cl::detail
+}//namespace bolt::cl
+}//namespace bolt
+
+#endif
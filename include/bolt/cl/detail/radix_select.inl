@@ -0,0 +1,234 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+/*  MSD radix select of arithmetic keys, for nth_element, partial_sort and top_k.  The kernels are in
+ *  sort_radix_kernels.cl, next to the radix sort they share the ordering of the key bits with.  Finding the key of
+ *  a rank reads the keys once per digit and moves none of them; the host reads back one histogram of RADIX_SORT_BITS
+ *  digits per pass to choose the next digit.  A single partition pass then writes the keys before the pivot, and as
+ *  many after it as are wanted.
+ */
+
+#if !defined( BOLT_CL_RADIX_SELECT_INL )
+#define BOLT_CL_RADIX_SELECT_INL
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include "bolt/cl/bolt.h"
+#include "bolt/cl/detail/radix_sort.inl"
+#include "bolt/cl/detail/index_type.inl"
+
+namespace bolt {
+namespace cl {
+namespace detail {
+
+class RadixSelect_KernelTemplateSpecializer : public KernelTemplateSpecializer
+{
+public:
+    RadixSelect_KernelTemplateSpecializer() : KernelTemplateSpecializer()
+    {
+        addKernelName("radixSelectHistogramTemplate");
+        addKernelName("radixSelectPartitionTemplate");
+    }
+
+    const ::std::string operator() ( const ::std::vector<::std::string>& typeNames ) const
+    {
+        const std::string templateSpecializationString =
+
+            "// Host generates this instantiation string with the unsigned type that holds the bits of a key\n"
+            "template __attribute__((mangled_name(" + name(0) + "Instantiated)))\n"
+            "kernel void radixSelectHistogramTemplate(global const " + typeNames[0] + "* keys,\n"
+            "uint first,\n"
+            "uint length,\n"
+            + typeNames[0] + " prefix,\n"
+            + typeNames[0] + " prefixMask,\n"
+            "uint shiftCount,\n"
+            "uint keyKind,\n"
+            "uint descending,\n"
+            "global uint* histogram\n"
+            ");\n\n"
+            "template __attribute__((mangled_name(" + name(1) + "Instantiated)))\n"
+            "kernel void radixSelectPartitionTemplate(global const " + typeNames[0] + "* keys,\n"
+            "uint first,\n"
+            "uint length,\n"
+            + typeNames[0] + " pivot,\n"
+            "uint keyKind,\n"
+            "uint descending,\n"
+            "uint lessCount,\n"
+            "uint keepEqual,\n"
+            "uint keepGreater,\n"
+            "global uint* cursors,\n"
+            "uint outputFirst,\n"
+            "global " + typeNames[0] + "* output\n"
+            ");\n\n";
+        return templateSpecializationString;
+    }
+};
+
+//  Where radix_select_enqueue found the key of a rank
+struct radixSelection
+{
+    cl_ulong pivot;     // the key, in the ordered bits of radixKeyOrdered
+    size_t lessCount;   // keys ordered before it
+    size_t equalCount;  // keys equal to it, itself included
+};
+
+template< typename T >
+std::vector< ::cl::Kernel > radix_select_kernels( const control &ctl )
+{
+    std::vector<std::string> typeNames( 1, radix_key_bits< sizeof( T ) >::name( ) );
+    std::vector<std::string> typeDefinitions;
+    std::string compileOptions;
+
+    RadixSelect_KernelTemplateSpecializer rs_kts;
+    return bolt::cl::getKernels(
+        ctl,
+        typeNames,
+        &rs_kts,
+        typeDefinitions,
+        sort_radix_kernels,
+        compileOptions);
+}
+
+//  Work groups of the radix select kernels; like the radix sort, a fixed number that each walk many tiles
+inline size_t radix_select_groups( const control &ctl, size_t szElements )
+{
+    size_t computeUnits = ctl.getDevice( ).getInfo< CL_DEVICE_MAX_COMPUTE_UNITS >( );
+    size_t numTiles = ( szElements + RADIX_SORT_WGSIZE - 1 ) / RADIX_SORT_WGSIZE;
+    return std::max< size_t >( 1, std::min( numTiles, computeUnits * RADIX_SORT_GROUPS_PER_CU ) );
+}
+
+/*! \brief Finds the key of the given rank among szElements keys of type T, starting keysIndex elements into the
+ *  buffer keys, in ascending order or in descending order
+ *  \details Takes one pass per digit of the key, each of which reads the keys and moves none of them.
+ */
+template< typename T >
+radixSelection radix_select_enqueue( const control &ctl, const ::cl::Buffer& keys, size_t keysIndex,
+                                     size_t szElements, size_t rank, bool descending )
+{
+    typedef typename radix_key_bits< sizeof( T ) >::type K;
+    index_require_32( keysIndex + szElements,
+        "The OpenCL path of nth_element(), partial_sort() and top_k() takes ranges of fewer than 2^31 elements" );
+    const size_t RADICES = (1 << RADIX_SORT_BITS);
+    cl_int l_Error = CL_SUCCESS;
+
+    std::vector< ::cl::Kernel > kernels = radix_select_kernels< T >( ctl );
+    ::cl::Kernel histogramKernel = kernels[0];
+
+    size_t numGroups = radix_select_groups( ctl, szElements );
+    ::cl::NDRange globalSize( numGroups * RADIX_SORT_WGSIZE );
+    ::cl::NDRange localSize( RADIX_SORT_WGSIZE );
+
+    std::vector< cl_uint > histogram( RADICES, 0 );
+    const std::vector< cl_uint > zeros( RADICES, 0 );
+    ::cl::Buffer clHistogram( ctl.getContext( ), CL_MEM_READ_WRITE, sizeof( cl_uint ) * RADICES, NULL, &l_Error );
+    V_OPENCL( l_Error, "Error creating the radix select histogram buffer" );
+
+    V_OPENCL( histogramKernel.setArg(0, keys), "Error setting a kernel argument" );
+    V_OPENCL( histogramKernel.setArg(1, static_cast< cl_uint >( keysIndex )), "Error setting a kernel argument" );
+    V_OPENCL( histogramKernel.setArg(2, static_cast< cl_uint >( szElements )), "Error setting a kernel argument" );
+    V_OPENCL( histogramKernel.setArg(6, static_cast< cl_uint >( radix_key< T >::kind )),
+              "Error setting a kernel argument" );
+    V_OPENCL( histogramKernel.setArg(7, static_cast< cl_uint >( descending ? 1 : 0 )),
+              "Error setting a kernel argument" );
+    V_OPENCL( histogramKernel.setArg(8, clHistogram), "Error setting a kernel argument" );
+
+    radixSelection selection = { 0, 0, 0 };
+    cl_ulong prefixMask = 0;
+    for( int bits = static_cast< int >( sizeof( T ) * 8 ) - RADIX_SORT_BITS; bits >= 0; bits -= RADIX_SORT_BITS )
+    {
+        V_OPENCL( ctl.getCommandQueue( ).enqueueWriteBuffer( clHistogram, CL_FALSE, 0, sizeof( cl_uint ) * RADICES,
+                                                             &zeros[ 0 ] ),
+                  "Error clearing the radix select histogram buffer" );
+        V_OPENCL( histogramKernel.setArg(3, static_cast< K >( selection.pivot )), "Error setting a kernel argument" );
+        V_OPENCL( histogramKernel.setArg(4, static_cast< K >( prefixMask )), "Error setting a kernel argument" );
+        V_OPENCL( histogramKernel.setArg(5, static_cast< cl_uint >( bits )), "Error setting a kernel argument" );
+        l_Error = ctl.getCommandQueue().enqueueNDRangeKernel( histogramKernel, ::cl::NullRange, globalSize, localSize );
+        V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for the radix select histogram kernel" );
+        V_OPENCL( ctl.getCommandQueue( ).enqueueReadBuffer( clHistogram, CL_TRUE, 0, sizeof( cl_uint ) * RADICES,
+                                                            &histogram[ 0 ] ),
+                  "Error reading the radix select histogram buffer" );
+
+        //  The digit of the key of the rank is the one whose keys the rank falls among
+        size_t digit = 0;
+        size_t before = 0;
+        while( before + histogram[ digit ] <= rank )
+            before += histogram[ digit++ ];
+
+        rank -= before;
+        selection.lessCount += before;
+        selection.equalCount = histogram[ digit ];
+        selection.pivot |= static_cast< cl_ulong >( digit ) << bits;
+        prefixMask |= static_cast< cl_ulong >( RADICES - 1 ) << bits;
+    }
+
+    return selection;
+}
+
+/*! \brief Writes the keys ordered before the pivot of selection to the buffer output, from outputIndex, followed
+ *  by keepEqual of the keys equal to it, and by the keys ordered after it when keepGreater is set
+ *  \details The order of the keys within each of the three parts is not kept.
+ */
+template< typename T >
+void radix_select_partition_enqueue( const control &ctl, const ::cl::Buffer& keys, size_t keysIndex,
+                                     size_t szElements, const radixSelection& selection, size_t keepEqual,
+                                     bool keepGreater, bool descending, const ::cl::Buffer& output,
+                                     size_t outputIndex )
+{
+    typedef typename radix_key_bits< sizeof( T ) >::type K;
+    index_require_32( std::max( keysIndex, outputIndex ) + szElements,
+        "The OpenCL path of nth_element(), partial_sort() and top_k() takes ranges of fewer than 2^31 elements" );
+    cl_int l_Error = CL_SUCCESS;
+
+    std::vector< ::cl::Kernel > kernels = radix_select_kernels< T >( ctl );
+    ::cl::Kernel partitionKernel = kernels[1];
+
+    size_t numGroups = radix_select_groups( ctl, szElements );
+
+    cl_uint cursors[ 3 ] = { 0, 0, 0 };
+    ::cl::Buffer clCursors( ctl.getContext( ), CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, sizeof( cursors ), cursors,
+                            &l_Error );
+    V_OPENCL( l_Error, "Error creating the radix select cursor buffer" );
+
+    V_OPENCL( partitionKernel.setArg(0, keys), "Error setting a kernel argument" );
+    V_OPENCL( partitionKernel.setArg(1, static_cast< cl_uint >( keysIndex )), "Error setting a kernel argument" );
+    V_OPENCL( partitionKernel.setArg(2, static_cast< cl_uint >( szElements )), "Error setting a kernel argument" );
+    V_OPENCL( partitionKernel.setArg(3, static_cast< K >( selection.pivot )), "Error setting a kernel argument" );
+    V_OPENCL( partitionKernel.setArg(4, static_cast< cl_uint >( radix_key< T >::kind )),
+              "Error setting a kernel argument" );
+    V_OPENCL( partitionKernel.setArg(5, static_cast< cl_uint >( descending ? 1 : 0 )),
+              "Error setting a kernel argument" );
+    V_OPENCL( partitionKernel.setArg(6, static_cast< cl_uint >( selection.lessCount )),
+              "Error setting a kernel argument" );
+    V_OPENCL( partitionKernel.setArg(7, static_cast< cl_uint >( keepEqual )), "Error setting a kernel argument" );
+    V_OPENCL( partitionKernel.setArg(8, static_cast< cl_uint >( keepGreater ? 1 : 0 )),
+              "Error setting a kernel argument" );
+    V_OPENCL( partitionKernel.setArg(9, clCursors), "Error setting a kernel argument" );
+    V_OPENCL( partitionKernel.setArg(10, static_cast< cl_uint >( outputIndex )), "Error setting a kernel argument" );
+    V_OPENCL( partitionKernel.setArg(11, output), "Error setting a kernel argument" );
+
+    l_Error = ctl.getCommandQueue().enqueueNDRangeKernel( partitionKernel, ::cl::NullRange,
+                                                          ::cl::NDRange( numGroups * RADIX_SORT_WGSIZE ),
+                                                          ::cl::NDRange( RADIX_SORT_WGSIZE ) );
+    V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for the radix select partition kernel" );
+}
+
+}
+}
+}
+
+#endif
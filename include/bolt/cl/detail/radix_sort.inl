@@ -0,0 +1,405 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+/*  LSD radix sort of arithmetic keys, shared by sort, sort_by_key and stable_sort_by_key.  The kernels are in
+ *  sort_radix_kernels.cl.  A sort by key does not move the values on every pass: the downsweep carries the original
+ *  position of every key as a 32-bit index, and the values are gathered once after the last pass, so the cost per
+ *  pass does not depend on the size of the value type.
+ */
+
+#if !defined( BOLT_CL_RADIX_SORT_INL )
+#define BOLT_CL_RADIX_SORT_INL
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+#include "bolt/cl/bolt.h"
+#include "bolt/cl/functional.h"
+#include "bolt/cl/detail/index_type.inl"
+
+/* \brief - Bits per radix sort pass, and the work group size of the radix kernels; these match sort_radix_kernels.cl */
+#define RADIX_SORT_BITS 8
+#define RADIX_SORT_WGSIZE 256
+/* \brief - Radix sort work groups per compute unit; each one walks a contiguous run of tiles */
+#define RADIX_SORT_GROUPS_PER_CU 8
+
+namespace bolt {
+namespace cl {
+namespace detail {
+
+class RadixSort_Key_KernelTemplateSpecializer : public KernelTemplateSpecializer
+{
+public:
+    RadixSort_Key_KernelTemplateSpecializer() : KernelTemplateSpecializer()
+    {
+        addKernelName("radixKeyDifferenceTemplate");
+        addKernelName("radixKeyUpsweepTemplate");
+        addKernelName("radixKeySpineTemplate");
+        addKernelName("radixKeyDownsweepTemplate");
+        addKernelName("radixKeyDownsweepByKeyTemplate");
+    }
+
+    const ::std::string operator() ( const ::std::vector<::std::string>& typeNames ) const
+    {
+        const std::string templateSpecializationString =
+
+            "// Host generates this instantiation string with the unsigned type that holds the bits of a key\n"
+            "template __attribute__((mangled_name(" + name(0) + "Instantiated)))\n"
+            "kernel void radixKeyDifferenceTemplate(global const " + typeNames[0] + "* keys,\n"
+            "global uint* differentBits,\n"
+            "uint keyKind,\n"
+            "uint descending,\n"
+            "uint length\n"
+            ");\n\n"
+            "template __attribute__((mangled_name(" + name(1) + "Instantiated)))\n"
+            "kernel void radixKeyUpsweepTemplate(global const " + typeNames[0] + "* unsortedData,\n"
+            "global uint* counts,\n"
+            "uint shiftCount,\n"
+            "uint keyKind,\n"
+            "uint descending,\n"
+            "uint length,\n"
+            "uint elementsPerGroup\n"
+            ");\n\n"
+            "template __attribute__((mangled_name(" + name(2) + "Instantiated)))\n"
+            "kernel void radixKeySpineTemplate< " + typeNames[0] + " >(global uint* counts,\n"
+            "uint numGroups\n"
+            ");\n\n"
+            "template __attribute__((mangled_name(" + name(3) + "Instantiated)))\n"
+            "kernel void radixKeyDownsweepTemplate(global const " + typeNames[0] + "* unsortedData,\n"
+            "global const uint* counts,\n"
+            "uint shiftCount,\n"
+            "uint keyKind,\n"
+            "uint descending,\n"
+            "uint length,\n"
+            "uint elementsPerGroup,\n"
+            "uint numGroups,\n"
+            "global " + typeNames[0] + "* sortedData\n"
+            ");\n\n"
+            "template __attribute__((mangled_name(" + name(4) + "Instantiated)))\n"
+            "kernel void radixKeyDownsweepByKeyTemplate(global const " + typeNames[0] + "* unsortedData,\n"
+            "global const uint* unsortedIndices,\n"
+            "global const uint* counts,\n"
+            "uint shiftCount,\n"
+            "uint keyKind,\n"
+            "uint descending,\n"
+            "uint length,\n"
+            "uint elementsPerGroup,\n"
+            "uint numGroups,\n"
+            "uint indexMode,\n"
+            "global " + typeNames[0] + "* sortedData,\n"
+            "global uint* sortedIndices\n"
+            ");\n\n";
+        return templateSpecializationString;
+    }
+};
+
+class RadixGather_KernelTemplateSpecializer : public KernelTemplateSpecializer
+{
+public:
+    RadixGather_KernelTemplateSpecializer() : KernelTemplateSpecializer()
+    {
+        addKernelName("radixGatherTemplate");
+    }
+
+    const ::std::string operator() ( const ::std::vector<::std::string>& typeNames ) const
+    {
+        const std::string templateSpecializationString =
+
+            "// Host generates this instantiation string with the user-specified value type\n"
+            "template __attribute__((mangled_name(" + name(0) + "Instantiated)))\n"
+            "kernel void radixGatherTemplate(global const " + typeNames[0] + "* unsortedValues,\n"
+            "global const uint* permutation,\n"
+            "uint length,\n"
+            "uint valueOffset,\n"
+            "global " + typeNames[0] + "* sortedValues\n"
+            ");\n\n";
+        return templateSpecializationString;
+    }
+};
+
+//  How the radix kernels order the bits of a key; matches RADIX_KEY_* in sort_radix_kernels.cl
+enum radixKeyKind { radixKeyUnsigned, radixKeySigned, radixKeyFloating };
+
+//  The unsigned OpenCL type the radix kernels read a key of the given width as
+template< size_t Bytes > struct radix_key_bits;
+template< > struct radix_key_bits< 1 > { typedef cl_uchar type;  static std::string name( ) { return "uchar"; } };
+template< > struct radix_key_bits< 2 > { typedef cl_ushort type; static std::string name( ) { return "ushort"; } };
+template< > struct radix_key_bits< 4 > { typedef cl_uint type;   static std::string name( ) { return "uint"; } };
+template< > struct radix_key_bits< 8 > { typedef cl_ulong type;  static std::string name( ) { return "ulong"; } };
+
+//  Arithmetic types of 8, 16, 32 or 64 bits can be radix sorted by their bits
+template< typename T >
+struct radix_key
+{
+    static const bool sortable = ( std::is_integral< T >::value || std::is_floating_point< T >::value )
+        && !std::is_same< T, bool >::value && !std::is_same< T, long double >::value
+        && ( sizeof( T ) == 1 || sizeof( T ) == 2 || sizeof( T ) == 4 || sizeof( T ) == 8 );
+
+    static const cl_uint kind = std::is_floating_point< T >::value ? radixKeyFloating :
+                                ( std::is_signed< T >::value ? radixKeySigned : radixKeyUnsigned );
+};
+
+/*! \brief True when a sort of T with StrictWeakOrdering is done with the radix sort
+ *  \details Only the bolt::cl::less and bolt::cl::greater comparators are known to order keys by value; any other
+ *  comparator goes through the bitonic sort.
+ */
+template< typename T, typename StrictWeakOrdering >
+struct radix_sort_enabled
+{
+    static const bool value = radix_key< T >::sortable
+        && ( std::is_same< StrictWeakOrdering, bolt::cl::less< T > >::value
+          || std::is_same< StrictWeakOrdering, bolt::cl::greater< T > >::value );
+};
+
+/*! \brief Sorts szElements keys of type T, starting keysIndex elements into the buffer keys, in place
+ *  \details When permutation is not NULL, it receives a buffer of szElements uints holding, for every position of
+ *  the sorted range, the position the key there had before the sort.  It is left as a null buffer if the keys were
+ *  already in order, because no pass had anything to sort.  The sort is stable.
+ */
+template< typename T >
+void radix_sort_enqueue( const control &ctl, const ::cl::Buffer& keys, size_t keysIndex, size_t szElements,
+                         bool descending, ::cl::Buffer* permutation )
+{
+    typedef radix_key_bits< sizeof( T ) > keyBits;
+    index_require_32( keysIndex + szElements,
+        "The OpenCL radix sort behind sort() and sort_by_key() takes ranges of fewer than 2^31 elements" );
+    const size_t RADICES = (1 << RADIX_SORT_BITS);
+    cl_int l_Error = CL_SUCCESS;
+
+    std::vector<std::string> typeNames( 1, keyBits::name( ) );
+    std::vector<std::string> typeDefinitions;
+    std::string compileOptions;
+
+    RadixSort_Key_KernelTemplateSpecializer ts_kts;
+    std::vector< ::cl::Kernel > kernels = bolt::cl::getKernels(
+        ctl,
+        typeNames,
+        &ts_kts,
+        typeDefinitions,
+        sort_radix_kernels,
+        compileOptions);
+    ::cl::Kernel differenceKernel = kernels[0];
+    ::cl::Kernel upsweepKernel = kernels[1];
+    ::cl::Kernel spineKernel = kernels[2];
+    ::cl::Kernel downsweepKernel = permutation ? kernels[4] : kernels[3];
+
+    // A fixed number of work groups each walk a contiguous run of whole tiles, so the spine only has to scan
+    // numGroups rows of counts however long the input is.
+    size_t computeUnits = ctl.getDevice( ).getInfo< CL_DEVICE_MAX_COMPUTE_UNITS >( );
+    size_t numTiles = ( szElements + RADIX_SORT_WGSIZE - 1 ) / RADIX_SORT_WGSIZE;
+    size_t numGroups = std::min( numTiles, computeUnits * RADIX_SORT_GROUPS_PER_CU );
+    size_t elementsPerGroup = ( ( numTiles + numGroups - 1 ) / numGroups ) * RADIX_SORT_WGSIZE;
+    numGroups = ( szElements + elementsPerGroup - 1 ) / elementsPerGroup;
+    ::cl::NDRange globalSize( numGroups * RADIX_SORT_WGSIZE );
+    ::cl::NDRange localSize( RADIX_SORT_WGSIZE );
+
+    // The kernels address keys from the start of a buffer, so a range that starts inside its buffer is sorted in a
+    // copy
+    ::cl::Buffer clKeys = keys;
+    size_t rangeOffset = keysIndex * sizeof( T );
+    if( rangeOffset != 0 )
+    {
+        clKeys = ::cl::Buffer( ctl.getContext( ), CL_MEM_READ_WRITE, sizeof( T ) * szElements, NULL, &l_Error );
+        V_OPENCL( l_Error, "Error creating the radix sort key buffer" );
+        V_OPENCL( ctl.getCommandQueue( ).enqueueCopyBuffer( keys, clKeys, rangeOffset, 0, sizeof( T ) * szElements ),
+                  "Error copying the range into the radix sort key buffer" );
+    }
+
+    cl_uint keyKind = radix_key< T >::kind;
+    cl_uint descendingArg = descending ? 1 : 0;
+    cl_uint length = static_cast< cl_uint >( szElements );
+
+    // Find the digits that are the same for every key; sorting on them would not move anything
+    cl_uint differentBits[ 2 ] = { 0, 0 };
+    ::cl::Buffer clDifferentBits( ctl.getContext( ), CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, sizeof( differentBits ),
+                                  differentBits, &l_Error );
+    V_OPENCL( l_Error, "Error creating the radix sort difference buffer" );
+    V_OPENCL( differenceKernel.setArg(0, clKeys), "Error setting a kernel argument" );
+    V_OPENCL( differenceKernel.setArg(1, clDifferentBits), "Error setting a kernel argument" );
+    V_OPENCL( differenceKernel.setArg(2, keyKind), "Error setting a kernel argument" );
+    V_OPENCL( differenceKernel.setArg(3, descendingArg), "Error setting a kernel argument" );
+    V_OPENCL( differenceKernel.setArg(4, length), "Error setting a kernel argument" );
+    l_Error = ctl.getCommandQueue().enqueueNDRangeKernel( differenceKernel, ::cl::NullRange, globalSize, localSize );
+    V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for the radix sort difference kernel" );
+    V_OPENCL( ctl.getCommandQueue( ).enqueueReadBuffer( clDifferentBits, CL_TRUE, 0, sizeof( differentBits ),
+                                                        differentBits ),
+              "Error reading the radix sort difference buffer" );
+    cl_ulong differentMask = ( static_cast< cl_ulong >( differentBits[ 1 ] ) << 32 ) | differentBits[ 0 ];
+
+    if( permutation )
+        *permutation = ::cl::Buffer( );
+    if( differentMask == 0 )
+        return;
+
+    // counts holds a row of RADICES per group, followed by the first output position of every digit
+    ::cl::Buffer swapBuffer( ctl.getContext( ), CL_MEM_READ_WRITE, sizeof( T ) * szElements, NULL, &l_Error );
+    V_OPENCL( l_Error, "Error creating the radix sort swap buffer" );
+    ::cl::Buffer clCounts( ctl.getContext( ), CL_MEM_READ_WRITE, sizeof( cl_uint ) * ( numGroups + 1 ) * RADICES,
+                           NULL, &l_Error );
+    V_OPENCL( l_Error, "Error creating the radix sort count buffer" );
+
+    // The two index buffers of a sort by key ping-pong along with the keys
+    ::cl::Buffer clSrcIndices, clDstIndices;
+    if( permutation )
+    {
+        clSrcIndices = ::cl::Buffer( ctl.getContext( ), CL_MEM_READ_WRITE, sizeof( cl_uint ) * szElements, NULL,
+                                     &l_Error );
+        V_OPENCL( l_Error, "Error creating the radix sort index buffer" );
+        clDstIndices = ::cl::Buffer( ctl.getContext( ), CL_MEM_READ_WRITE, sizeof( cl_uint ) * szElements, NULL,
+                                     &l_Error );
+        V_OPENCL( l_Error, "Error creating the radix sort index buffer" );
+    }
+
+    // The by key downsweep takes the indices after each of the plain downsweep's buffer arguments
+    const cl_uint countsArg = permutation ? 2 : 1;
+    const cl_uint shiftArg = countsArg + 1;
+    const cl_uint dstArg = permutation ? 10 : 8;
+
+    V_OPENCL( upsweepKernel.setArg(1, clCounts), "Error setting a kernel argument" );
+    V_OPENCL( upsweepKernel.setArg(3, keyKind), "Error setting a kernel argument" );
+    V_OPENCL( upsweepKernel.setArg(4, descendingArg), "Error setting a kernel argument" );
+    V_OPENCL( upsweepKernel.setArg(5, length), "Error setting a kernel argument" );
+    V_OPENCL( upsweepKernel.setArg(6, static_cast< cl_uint >( elementsPerGroup )), "Error setting a kernel argument" );
+    V_OPENCL( spineKernel.setArg(0, clCounts), "Error setting a kernel argument" );
+    V_OPENCL( spineKernel.setArg(1, static_cast< cl_uint >( numGroups )), "Error setting a kernel argument" );
+    V_OPENCL( downsweepKernel.setArg(countsArg, clCounts), "Error setting a kernel argument" );
+    V_OPENCL( downsweepKernel.setArg(shiftArg + 1, keyKind), "Error setting a kernel argument" );
+    V_OPENCL( downsweepKernel.setArg(shiftArg + 2, descendingArg), "Error setting a kernel argument" );
+    V_OPENCL( downsweepKernel.setArg(shiftArg + 3, length), "Error setting a kernel argument" );
+    V_OPENCL( downsweepKernel.setArg(shiftArg + 4, static_cast< cl_uint >( elementsPerGroup )),
+              "Error setting a kernel argument" );
+    V_OPENCL( downsweepKernel.setArg(shiftArg + 5, static_cast< cl_uint >( numGroups )),
+              "Error setting a kernel argument" );
+
+    ::cl::Buffer clSrc = clKeys;
+    ::cl::Buffer clDst = swapBuffer;
+    bool firstPass = true;
+    for(cl_uint bits = 0; bits < sizeof(T) * 8; bits += RADIX_SORT_BITS)
+    {
+        if( ( ( differentMask >> bits ) & ( RADICES - 1 ) ) == 0 )
+            continue;
+
+        V_OPENCL( upsweepKernel.setArg(0, clSrc), "Error setting a kernel argument" );
+        V_OPENCL( upsweepKernel.setArg(2, bits), "Error setting a kernel argument" );
+        l_Error = ctl.getCommandQueue().enqueueNDRangeKernel( upsweepKernel, ::cl::NullRange, globalSize, localSize );
+        V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for the radix sort upsweep kernel" );
+
+        l_Error = ctl.getCommandQueue().enqueueNDRangeKernel( spineKernel, ::cl::NullRange, localSize, localSize );
+        V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for the radix sort spine kernel" );
+
+        V_OPENCL( downsweepKernel.setArg(0, clSrc), "Error setting a kernel argument" );
+        V_OPENCL( downsweepKernel.setArg(shiftArg, bits), "Error setting a kernel argument" );
+        V_OPENCL( downsweepKernel.setArg(dstArg, clDst), "Error setting a kernel argument" );
+        if( permutation )
+        {
+            // The first pass numbers the keys itself, and never reads its source indices
+            cl_uint indexMode = firstPass ? 1 : 2;
+            V_OPENCL( downsweepKernel.setArg(1, clSrcIndices), "Error setting a kernel argument" );
+            V_OPENCL( downsweepKernel.setArg(9, indexMode), "Error setting a kernel argument" );
+            V_OPENCL( downsweepKernel.setArg(11, clDstIndices), "Error setting a kernel argument" );
+        }
+        l_Error = ctl.getCommandQueue().enqueueNDRangeKernel( downsweepKernel, ::cl::NullRange, globalSize, localSize );
+        V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for the radix sort downsweep kernel" );
+
+        std::swap( clSrc, clDst );
+        std::swap( clSrcIndices, clDstIndices );
+        firstPass = false;
+    }
+
+    if( permutation )
+        *permutation = clSrcIndices;
+
+    // With skipped passes the sorted keys can end up in the swap buffer
+    if( clSrc( ) != clKeys( ) )
+    {
+        V_OPENCL( ctl.getCommandQueue( ).enqueueCopyBuffer( clSrc, clKeys, 0, 0, sizeof( T ) * szElements ),
+                  "Error copying the sorted keys out of the swap buffer" );
+    }
+    if( rangeOffset != 0 )
+    {
+        V_OPENCL( ctl.getCommandQueue( ).enqueueCopyBuffer( clKeys, keys, 0, rangeOffset, sizeof( T ) * szElements ),
+                  "Error copying the sorted keys back into the range" );
+    }
+}
+
+/*! \brief Sorts the keys of a device range with the radix sort, and moves the values along with them
+ *  \details The sort is stable, so this serves both sort_by_key and stable_sort_by_key.
+ */
+template< typename DVRandomAccessIterator1, typename DVRandomAccessIterator2 >
+void radix_sort_by_key_enqueue( const control &ctl, const DVRandomAccessIterator1& keys_first,
+                                const DVRandomAccessIterator1& keys_last, const DVRandomAccessIterator2& values_first,
+                                bool descending )
+{
+    typedef typename std::iterator_traits< DVRandomAccessIterator1 >::value_type T_keys;
+    typedef typename std::iterator_traits< DVRandomAccessIterator2 >::value_type T_values;
+    cl_int l_Error = CL_SUCCESS;
+    size_t szElements = static_cast< size_t >( std::distance( keys_first, keys_last ) );
+
+    ::cl::Buffer clPermutation;
+    radix_sort_enqueue< T_keys >( ctl, keys_first.getBuffer( ), keys_first.m_Index, szElements, descending,
+                                  &clPermutation );
+
+    // Keys that were already in order leave the values where they are
+    if( clPermutation( ) != NULL )
+    {
+        std::vector<std::string> typeNames( 1, TypeName< T_values >::get( ) );
+        std::vector<std::string> typeDefinitions;
+        PUSH_BACK_UNIQUE( typeDefinitions, ClCode< T_values >::get() )
+        std::string compileOptions;
+
+        RadixGather_KernelTemplateSpecializer gather_kts;
+        std::vector< ::cl::Kernel > kernels = bolt::cl::getKernels(
+            ctl,
+            typeNames,
+            &gather_kts,
+            typeDefinitions,
+            sort_radix_kernels,
+            compileOptions);
+
+        // The gather cannot work in place, so it reads from a copy of the values
+        ::cl::Buffer clValues = values_first.getBuffer( );
+        size_t valueOffset = values_first.m_Index * sizeof( T_values );
+        ::cl::Buffer clUnsortedValues( ctl.getContext( ), CL_MEM_READ_WRITE, sizeof( T_values ) * szElements, NULL,
+                                       &l_Error );
+        V_OPENCL( l_Error, "Error creating the radix sort value buffer" );
+        V_OPENCL( ctl.getCommandQueue( ).enqueueCopyBuffer( clValues, clUnsortedValues, valueOffset, 0,
+                                                            sizeof( T_values ) * szElements ),
+                  "Error copying the values into the radix sort value buffer" );
+
+        size_t numGroups = ( szElements + RADIX_SORT_WGSIZE - 1 ) / RADIX_SORT_WGSIZE;
+        V_OPENCL( kernels[0].setArg(0, clUnsortedValues), "Error setting a kernel argument" );
+        V_OPENCL( kernels[0].setArg(1, clPermutation), "Error setting a kernel argument" );
+        V_OPENCL( kernels[0].setArg(2, static_cast< cl_uint >( szElements )), "Error setting a kernel argument" );
+        V_OPENCL( kernels[0].setArg(3, static_cast< cl_uint >( values_first.m_Index )),
+                  "Error setting a kernel argument" );
+        V_OPENCL( kernels[0].setArg(4, clValues), "Error setting a kernel argument" );
+        l_Error = ctl.getCommandQueue().enqueueNDRangeKernel( kernels[0], ::cl::NullRange,
+                                                              ::cl::NDRange( numGroups * RADIX_SORT_WGSIZE ),
+                                                              ::cl::NDRange( RADIX_SORT_WGSIZE ) );
+        V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for the radix sort gather kernel" );
+    }
+
+    ::cl::Event radixSortEvent;
+    V_OPENCL( ctl.getCommandQueue().clEnqueueBarrierWithWaitList(NULL, &radixSortEvent) , "Error calling clEnqueueBarrierWithWaitList on the command queue" );
+    bolt::cl::wait(ctl, radixSortEvent, "sort_by_key");
+}
+
+}
+}
+}
+
+#endif
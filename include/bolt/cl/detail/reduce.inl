@@ -20,18 +20,26 @@
 #pragma once
 
 #include <algorithm>
+#include <limits>
+#include <sstream>
+#include <type_traits>
 
 #include <boost/thread/once.hpp>
 #include <boost/bind.hpp>
 #include "bolt/cl/bolt.h"
 #include "bolt/cl/functional.h"
+#include "bolt/cl/detail/heterogeneous.inl"
+#include "bolt/cl/detail/index_type.inl"
 #ifdef ENABLE_TBB
 //TBB Includes
 #include "tbb/parallel_reduce.h"
 #include "tbb/blocked_range.h"
-#include "tbb/task_scheduler_init.h"
+#include "bolt/cl/detail/tbb_arena.inl"
 #endif
 
+/* \brief Work items in a work group of the vectorized first stage of reduce */
+#define REDUCE_VECTOR_WGSIZE 256
+
 
 namespace bolt {
     namespace cl {
@@ -114,6 +122,30 @@ namespace bolt {
             }
         }
 
+        template<typename InputIterator, typename OutputIterator, typename T, typename BinaryFunction>
+        void reduce_into(bolt::cl::control &ctl,
+            InputIterator first,
+            InputIterator last,
+            OutputIterator result,
+            T init,
+            BinaryFunction binary_op,
+            const std::string& cl_code)
+        {
+            detail::reduce_into_pick_output( ctl, first, last, result, init, binary_op, cl_code,
+                std::iterator_traits< OutputIterator >::iterator_category( ) );
+        }
+
+        template<typename InputIterator, typename OutputIterator, typename T, typename BinaryFunction>
+        void reduce_into(InputIterator first,
+            InputIterator last,
+            OutputIterator result,
+            T init,
+            BinaryFunction binary_op,
+            const std::string& cl_code)
+        {
+            reduce_into(bolt::cl::control::getDefault(), first, last, result, init, binary_op, cl_code);
+        }
+
     }
 
 };
@@ -125,7 +157,8 @@ namespace bolt {
 
             ///////////////
 
-        enum ReduceTypes {reduce_iValueType, reduce_iIterType, reduce_BinaryFunction, reduce_end };
+        enum ReduceTypes {reduce_iValueType, reduce_iIterType, reduce_BinaryFunction, reduce_rValueType, reduce_vValueType,
+                          reduce_end };
 
         ///////////////////////////////////////////////////////////////////////
         //Kernel Template Specializer
@@ -137,6 +170,7 @@ namespace bolt {
             Reduce_KernelTemplateSpecializer() : KernelTemplateSpecializer()
                 {
                     addKernelName( "reduceTemplate" );
+                    addKernelName( "reduceFinal" );
                 }
 
             const ::std::string operator() ( const ::std::vector<::std::string>& typeNames ) const
@@ -148,15 +182,164 @@ namespace bolt {
                         "kernel void reduceTemplate(\n"
                         "global " + typeNames[reduce_iValueType] + "* input_ptr,\n"
                          + typeNames[reduce_iIterType] + " output_iter,\n"
-                        "const int length,\n"
+                        "const indexType length,\n"
                         "global " + typeNames[reduce_BinaryFunction] + "* userFunctor,\n"
                         "global " + typeNames[reduce_iValueType] + "* result,\n"
                         "local " + typeNames[reduce_iValueType] + "* scratch\n"
+                        ");\n\n"
+
+                        "// Host generates this instantiation string with user-specified value type and functor\n"
+                        "template __attribute__((mangled_name(" + name(1) + "Instantiated)))\n"
+                        "__attribute__((reqd_work_group_size(64,1,1)))\n"
+                        "kernel void reduceFinal(\n"
+                        "global " + typeNames[reduce_iValueType] + "* partials,\n"
+                        "const int numPartials,\n"
+                        "const " + typeNames[reduce_iValueType] + " init,\n"
+                        "global " + typeNames[reduce_BinaryFunction] + "* userFunctor,\n"
+                        "global " + typeNames[reduce_rValueType] + "* result,\n"
+                        "const indexType resultIndex,\n"
+                        "local " + typeNames[reduce_iValueType] + "* scratch\n"
                         ");\n\n";
 
                 return templateSpecializationString;
             }
             };
+        //  The vectorized first stage, for the built-in scalar types and operators of reduce_vector_enabled
+        class ReduceVector_KernelTemplateSpecializer : public KernelTemplateSpecializer
+            {
+            public:
+
+            ReduceVector_KernelTemplateSpecializer() : KernelTemplateSpecializer()
+                {
+                    addKernelName( "reduceVector" );
+                    addKernelName( "reduceFinal" );
+                }
+
+            const ::std::string operator() ( const ::std::vector<::std::string>& typeNames ) const
+            {
+                const std::string templateSpecializationString =
+                        "// Host generates this instantiation string with user-specified value type and functor\n"
+                        "template __attribute__((mangled_name(" + name(0) + "Instantiated)))\n"
+                        "__attribute__((reqd_work_group_size(REDUCE_VECTOR_WGSIZE,1,1)))\n"
+                        "kernel void reduceVector< " + typeNames[reduce_iValueType] + ", " +
+                            typeNames[reduce_vValueType] + " >(\n"
+                        "global " + typeNames[reduce_iValueType] + "* input_ptr,\n"
+                        "const indexType offset,\n"
+                        "const indexType length,\n"
+                        "const " + typeNames[reduce_iValueType] + " identity,\n"
+                        "global " + typeNames[reduce_iValueType] + "* result,\n"
+                        "local " + typeNames[reduce_iValueType] + "* scratch\n"
+                        ");\n\n"
+
+                        "// Host generates this instantiation string with user-specified value type and functor\n"
+                        "template __attribute__((mangled_name(" + name(1) + "Instantiated)))\n"
+                        "__attribute__((reqd_work_group_size(64,1,1)))\n"
+                        "kernel void reduceFinal(\n"
+                        "global " + typeNames[reduce_iValueType] + "* partials,\n"
+                        "const int numPartials,\n"
+                        "const " + typeNames[reduce_iValueType] + " init,\n"
+                        "global " + typeNames[reduce_BinaryFunction] + "* userFunctor,\n"
+                        "global " + typeNames[reduce_rValueType] + "* result,\n"
+                        "const indexType resultIndex,\n"
+                        "local " + typeNames[reduce_iValueType] + "* scratch\n"
+                        ");\n\n";
+
+                return templateSpecializationString;
+            }
+            };
+
+        /*! \brief The built-in operators the vectorized reduction knows, by the macro that selects them in
+         *  reduce_kernels.cl, with their identity
+         */
+        template< typename BinaryFunction >
+        struct reduce_vector_op
+        {
+            static const bool supported = false;
+        };
+
+        template< typename T >
+        struct reduce_vector_op< bolt::cl::plus< T > >
+        {
+            static const bool supported = true;
+            static const char* define( ) { return "REDUCE_VECTOR_PLUS"; }
+            static T identity( ) { return T( 0 ); }
+        };
+
+        template< typename T >
+        struct reduce_vector_op< bolt::cl::multiplies< T > >
+        {
+            static const bool supported = true;
+            static const char* define( ) { return "REDUCE_VECTOR_MULTIPLIES"; }
+            static T identity( ) { return T( 1 ); }
+        };
+
+        template< typename T >
+        struct reduce_vector_op< bolt::cl::maximum< T > >
+        {
+            static const bool supported = true;
+            static const char* define( ) { return "REDUCE_VECTOR_MAXIMUM"; }
+            static T identity( )
+            {
+                if( std::numeric_limits< T >::is_integer )
+                    return std::numeric_limits< T >::min( );
+                return std::numeric_limits< T >::has_infinity ? -std::numeric_limits< T >::infinity( )
+                                                              : -std::numeric_limits< T >::max( );
+            }
+        };
+
+        template< typename T >
+        struct reduce_vector_op< bolt::cl::minimum< T > >
+        {
+            static const bool supported = true;
+            static const char* define( ) { return "REDUCE_VECTOR_MINIMUM"; }
+            static T identity( )
+            {
+                return std::numeric_limits< T >::has_infinity ? std::numeric_limits< T >::infinity( )
+                                                              : std::numeric_limits< T >::max( );
+            }
+        };
+
+        /*! \brief The four-wide OpenCL vector type the vectorized first stage loads T as; vTypePtr of reduceVector
+         *  cannot be deduced from the kernel arguments, so the instantiation names it explicitly
+         */
+        template< typename T >
+        struct reduce_vector_type;
+
+        template< >
+        struct reduce_vector_type< int >
+        {
+            static const char* name( ) { return "int4"; }
+        };
+
+        template< >
+        struct reduce_vector_type< unsigned int >
+        {
+            static const char* name( ) { return "uint4"; }
+        };
+
+        template< >
+        struct reduce_vector_type< float >
+        {
+            static const char* name( ) { return "float4"; }
+        };
+
+        /*! \brief Whether a reduction to T of DVInputIterator with BinaryFunction can take the vectorized first stage:
+         *  a device_vector of int, unsigned int or float, reduced in that same type with plus, multiplies, maximum or
+         *  minimum of it
+         */
+        template< typename T, typename DVInputIterator, typename BinaryFunction >
+        struct reduce_vector_enabled
+        {
+            typedef typename std::iterator_traits< DVInputIterator >::value_type iType;
+            static const bool value =
+                ( std::is_same< T, int >::value || std::is_same< T, unsigned int >::value ||
+                  std::is_same< T, float >::value )
+                && std::is_same< iType, T >::value
+                && std::is_same< typename std::iterator_traits< DVInputIterator >::iterator_category,
+                                 bolt::cl::device_vector_tag >::value
+                && reduce_vector_op< BinaryFunction >::supported;
+        };
+
 #ifdef ENABLE_TBB
             /*For documentation on the reduce object see below link
              *http://threadingbuildingblocks.org/docs/help/reference/algorithms/parallel_reduce_func.htm
@@ -195,6 +378,113 @@ namespace bolt {
                 }
             };
 #endif
+            //  Chunk body for the Heterogeneous run mode.  Each chunk is seeded with its own first element, so no
+            //  identity value is needed; the partial results are combined with init in range order afterwards.
+            template<typename InputIterator, typename T, typename BinaryFunction>
+            struct heteroReduceChunk
+            {
+                heteroReduceChunk( const InputIterator& first, const BinaryFunction& binary_op,
+                    const std::string& cl_code, std::vector< T >& partials ):
+                    m_first( first ), m_op( binary_op ), m_code( cl_code ), m_partials( partials )
+                {}
+
+                void operator( )( control& worker, size_t chunk, size_t first, size_t last )
+                {
+                    T seed = *( m_first + first );
+                    m_partials[ chunk ] = bolt::cl::reduce( worker, m_first + first + 1, m_first + last, seed, m_op,
+                        m_code );
+                }
+
+                InputIterator m_first;
+                BinaryFunction m_op;
+                std::string m_code;
+                std::vector< T >& m_partials;
+            };
+
+            //  reduce_into with a host result: reduce, then store the value
+            template<typename InputIterator, typename OutputIterator, typename T, typename BinaryFunction>
+            void reduce_into_pick_output(bolt::cl::control &ctl,
+                const InputIterator& first,
+                const InputIterator& last,
+                const OutputIterator& result,
+                const T& init,
+                const BinaryFunction& binary_op,
+                const std::string& cl_code,
+                std::random_access_iterator_tag )
+            {
+                *result = bolt::cl::reduce( ctl, first, last, init, binary_op, cl_code );
+            }
+
+            //  reduce_into with a device_vector result: on the OpenCL device the result is written by the second stage
+            //  of the reduction and never read back
+            template<typename InputIterator, typename DVOutputIterator, typename T, typename BinaryFunction>
+            void reduce_into_pick_output(bolt::cl::control &ctl,
+                const InputIterator& first,
+                const InputIterator& last,
+                const DVOutputIterator& result,
+                const T& init,
+                const BinaryFunction& binary_op,
+                const std::string& cl_code,
+                bolt::cl::device_vector_tag )
+            {
+                bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
+                if(runMode == bolt::cl::control::Automatic)
+                {
+                    runMode = ctl.getDefaultPathToRun();
+                }
+                if( first == last || runMode != bolt::cl::control::OpenCL )
+                {
+                    *result = bolt::cl::reduce( ctl, first, last, init, binary_op, cl_code );
+                    return;
+                }
+                reduce_into_pick_input( ctl, first, last, result, init, binary_op, cl_code,
+                    std::iterator_traits< InputIterator >::iterator_category( ) );
+            }
+
+            //  The host input is only borrowed by the device, so the reduction completes before returning
+            template<typename InputIterator, typename DVOutputIterator, typename T, typename BinaryFunction>
+            void reduce_into_pick_input(bolt::cl::control &ctl,
+                const InputIterator& first,
+                const InputIterator& last,
+                const DVOutputIterator& result,
+                const T& init,
+                const BinaryFunction& binary_op,
+                const std::string& cl_code,
+                std::random_access_iterator_tag )
+            {
+                typedef typename std::iterator_traits<InputIterator>::value_type iType;
+                device_vector< iType > dvInput( first, last, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, ctl );
+                ::cl::Event reduceEvent = reduce_enqueue_into( ctl, dvInput.begin(), dvInput.end(), init, binary_op,
+                    result, cl_code );
+                bolt::cl::wait( ctl, reduceEvent, "reduce" );
+            }
+
+            template<typename DVInputIterator, typename DVOutputIterator, typename T, typename BinaryFunction>
+            void reduce_into_pick_input(bolt::cl::control &ctl,
+                const DVInputIterator& first,
+                const DVInputIterator& last,
+                const DVOutputIterator& result,
+                const T& init,
+                const BinaryFunction& binary_op,
+                const std::string& cl_code,
+                bolt::cl::device_vector_tag )
+            {
+                reduce_enqueue_into( ctl, first, last, init, binary_op, result, cl_code );
+            }
+
+            template<typename DVInputIterator, typename DVOutputIterator, typename T, typename BinaryFunction>
+            void reduce_into_pick_input(bolt::cl::control &ctl,
+                const DVInputIterator& first,
+                const DVInputIterator& last,
+                const DVOutputIterator& result,
+                const T& init,
+                const BinaryFunction& binary_op,
+                const std::string& cl_code,
+                bolt::cl::fancy_iterator_tag )
+            {
+                reduce_enqueue_into( ctl, first, last, init, binary_op, result, cl_code );
+            }
+
             template<typename T, typename DVInputIterator, typename BinaryFunction>
             T reduce_detect_random_access(bolt::cl::control &ctl,
                 const DVInputIterator& first,
@@ -244,13 +534,22 @@ namespace bolt {
                 {
                     runMode = ctl.getDefaultPathToRun();
                 }
-                if (runMode == bolt::cl::control::SerialCpu) {
+                if (runMode == bolt::cl::control::Heterogeneous) {
+                    std::vector< T > partials( hetero_num_chunks( ctl, szElements ) );
+                    heteroReduceChunk< InputIterator, T, BinaryFunction > body( first, binary_op, cl_code, partials );
+                    hetero_for( ctl, szElements, body );
+                    return hetero_combine( init, partials, binary_op );
+                } else if (runMode == bolt::cl::control::SerialCpu) {
                     return std::accumulate(first, last, init,binary_op) ;
                 } else if (runMode == bolt::cl::control::MultiCoreCpu) {
 #ifdef ENABLE_TBB
-                    tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
+                    control::tbbPartitionDesc part = ctl.getTbbPartitioner( "reduce" );
                     Reduce<iType, BinaryFunction> reduce_op(binary_op, init);
-                    tbb::parallel_reduce( tbb::blocked_range<iType*>( &*first, (iType*)&*(last-1) + 1), reduce_op );
+                    if( ctl.getNumaAware( ) )
+                        detail::tbb_numa_parallel_reduce( ctl, (iType*)&*first, (iType*)&*(last-1) + 1, reduce_op, part );
+                    else
+                        detail::tbb_parallel_reduce( ctl, tbb::blocked_range<iType*>( &*first, (iType*)&*(last-1) + 1, part.grainSize ),
+                            reduce_op, part.partitioner );
                     return reduce_op.value;
 #else
                     //std::cout << "The MultiCoreCpu version of reduce is not enabled. " << std ::endl;
@@ -303,9 +602,13 @@ namespace bolt {
                    iType *reduceInputBuffer = (iType*)ctl.getCommandQueue().enqueueMapBuffer(first.getBuffer(), false, CL_MAP_READ,0, sizeof(iType) * szElements,
                                                NULL, &multiCoreCPUEvent, &l_Error );
                     multiCoreCPUEvent.wait();
-                    tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
+                    control::tbbPartitionDesc part = ctl.getTbbPartitioner( "reduce" );
                     Reduce<iType, BinaryFunction> reduce_op(binary_op, init);
-                    tbb::parallel_reduce( tbb::blocked_range<iType*>( reduceInputBuffer, reduceInputBuffer + szElements), reduce_op );
+                    if( ctl.getNumaAware( ) )
+                        detail::tbb_numa_parallel_reduce( ctl, reduceInputBuffer, reduceInputBuffer + szElements, reduce_op, part );
+                    else
+                        detail::tbb_parallel_reduce( ctl, tbb::blocked_range<iType*>( reduceInputBuffer, reduceInputBuffer + szElements,
+                            part.grainSize ), reduce_op, part.partitioner );
                     /*Unmap the device buffer back to device memory. This will copy the host modified buffer back to the device*/
                     ctl.getCommandQueue().enqueueUnmapMemObject(first.getBuffer(), reduceInputBuffer);
                     return reduce_op.value;
@@ -334,32 +637,40 @@ namespace bolt {
 
             //----
             // This is the base implementation of reduction that is called by all of the convenience wrappers below.
-            // first and last must be iterators from a DeviceVector
-            template<typename T, typename DVInputIterator, typename BinaryFunction>
-            T reduce_enqueue(bolt::cl::control &ctl,
+            // first and last must be iterators from a DeviceVector.  Both stages of the reduction are enqueued and
+            // the value is written to result; the returned event is that of the second stage.
+            template<typename T, typename DVInputIterator, typename BinaryFunction, typename DVOutputIterator>
+            ::cl::Event reduce_generic_enqueue_into(bolt::cl::control &ctl,
                 const DVInputIterator& first,
                 const DVInputIterator& last,
                 const T& init,
                 const BinaryFunction& binary_op,
+                const DVOutputIterator& result,
                 const std::string& cl_code )
             {
                 typedef typename std::iterator_traits< DVInputIterator >::value_type iType;
+                typedef typename std::iterator_traits< DVOutputIterator >::value_type rType;
 
 
                 std::vector<std::string> typeNames( reduce_end);
                 typeNames[reduce_iValueType] = TypeName< T >::get( );
                 typeNames[reduce_iIterType] = TypeName< DVInputIterator >::get( );
                 typeNames[reduce_BinaryFunction] = TypeName< BinaryFunction >::get();
+                typeNames[reduce_rValueType] = TypeName< rType >::get( );
 
                 std::vector<std::string> typeDefinitions;
                 PUSH_BACK_UNIQUE( typeDefinitions, ClCode< T >::get() )
                 PUSH_BACK_UNIQUE( typeDefinitions, ClCode< DVInputIterator >::get() )
                 PUSH_BACK_UNIQUE( typeDefinitions, ClCode< BinaryFunction  >::get() )
+                PUSH_BACK_UNIQUE( typeDefinitions, ClCode< rType >::get() )
 
                 //bool cpuDevice = ctl.device().getInfo<CL_DEVICE_TYPE>() == CL_DEVICE_TYPE_CPU;
                 /*\TODO - Do CPU specific kernel work group size selection here*/
                 //const size_t kernel0_WgSize = (cpuDevice) ? 1 : WAVESIZE*KERNEL02WAVES;
-                std::string compileOptions;
+                size_t szElements = static_cast< size_t >( first.distance_to( last ) );
+                size_t resultIndex = static_cast< size_t >( result.m_Index );
+                size_t indexSpan = std::max( szElements, resultIndex + 1 );
+                std::string compileOptions = index_compile_options( indexSpan );
                 //std::ostringstream oss;
                 //oss << " -DKERNEL0WORKGROUPSIZE=" << kernel0_WgSize;
 
@@ -385,27 +696,23 @@ namespace bolt {
                     ctl.getDevice( ), &l_Error );
                 V_OPENCL( l_Error, "Error querying kernel for CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE" );
 
-                // Create buffer wrappers so we can access the host functors, for read or writing in the kernel
+                // The functor is copied into its buffer, because the kernels may run after this function returns
                 ALIGNED( 256 ) BinaryFunction aligned_reduce( binary_op );
-                //::cl::Buffer userFunctor(ctl.context(), CL_MEM_USE_HOST_PTR|CL_MEM_READ_ONLY, sizeof( aligned_reduce ),
-                //  &aligned_reduce );
-                control::buffPointer userFunctor = ctl.acquireBuffer( sizeof( aligned_reduce ),
-                    CL_MEM_USE_HOST_PTR|CL_MEM_READ_ONLY, &aligned_reduce );
-
-                // ::cl::Buffer result(ctl.context(), CL_MEM_ALLOC_HOST_PTR|CL_MEM_WRITE_ONLY, sizeof( iType ) * numWG);
-                control::buffPointer result = ctl.acquireBuffer( sizeof( iType ) * numWG,
-                    CL_MEM_ALLOC_HOST_PTR|CL_MEM_WRITE_ONLY );
+                ::cl::Buffer userFunctor( ctl.getContext( ), CL_MEM_COPY_HOST_PTR|CL_MEM_READ_ONLY,
+                    sizeof( aligned_reduce ), &aligned_reduce, &l_Error );
+                V_OPENCL( l_Error, "Error creating the functor buffer of reduce()" );
 
-                cl_uint szElements = static_cast< cl_uint >( first.distance_to(last ) );
+                // One partial result per work group, read by the second stage
+                control::buffPointer partials = ctl.acquireBuffer( sizeof( T ) * numWG, CL_MEM_READ_WRITE );
 
                 V_OPENCL( kernels[0].setArg(0, first.getBuffer( ) ), "Error setting kernel argument" );
                 V_OPENCL( kernels[0].setArg(1, first.gpuPayloadSize( ), &first.gpuPayload( ) ), "Error setting a kernel argument" );
-                V_OPENCL( kernels[0].setArg(2, szElements), "Error setting kernel argument" );
-                V_OPENCL( kernels[0].setArg(3, *userFunctor), "Error setting kernel argument" );
-                V_OPENCL( kernels[0].setArg(4, *result), "Error setting kernel argument" );
+                V_OPENCL( index_set_arg( kernels[0], 2, szElements, indexSpan ), "Error setting kernel argument" );
+                V_OPENCL( kernels[0].setArg(3, userFunctor), "Error setting kernel argument" );
+                V_OPENCL( kernels[0].setArg(4, *partials), "Error setting kernel argument" );
 
                 ::cl::LocalSpaceArg loc;
-                loc.size_ = wgSize*sizeof(iType);
+                loc.size_ = wgSize*sizeof(T);
                 V_OPENCL( kernels[0].setArg(5, loc), "Error setting kernel argument" );
 
                 l_Error = ctl.getCommandQueue().enqueueNDRangeKernel(
@@ -415,24 +722,186 @@ namespace bolt {
                     ::cl::NDRange(wgSize));
                 V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for reduce() kernel" );
 
-                ::cl::Event l_mapEvent;
-                iType *h_result = (iType*)ctl.getCommandQueue().enqueueMapBuffer(*result, false, CL_MAP_READ, 0,
-                    sizeof(iType)*numWG, NULL, &l_mapEvent, &l_Error );
-                V_OPENCL( l_Error, "Error calling map on the result buffer" );
-
-                //  Finish the tail end of the reduction on host side; the compute device reduces within the workgroups,
-                //  with one result per workgroup
-                size_t ceilNumWG = static_cast< size_t >( std::ceil( static_cast< float >( szElements ) / wgSize) );
+                //  Finish the tail end of the reduction in a single work group; the first kernel reduces within the
+                //  workgroups, with one result per workgroup
+                size_t ceilNumWG = ( szElements + wgSize - 1 ) / wgSize;
                 bolt::cl::minimum<size_t>  min_size_t;
-                size_t numTailReduce = min_size_t( ceilNumWG, numWG );
+                cl_int numTailReduce = static_cast< cl_int >( min_size_t( ceilNumWG, numWG ) );
 
-                bolt::cl::wait(ctl, l_mapEvent);
+                V_OPENCL( kernels[1].setArg(0, *partials), "Error setting kernel argument" );
+                V_OPENCL( kernels[1].setArg(1, numTailReduce), "Error setting kernel argument" );
+                V_OPENCL( kernels[1].setArg(2, init), "Error setting kernel argument" );
+                V_OPENCL( kernels[1].setArg(3, userFunctor), "Error setting kernel argument" );
+                V_OPENCL( kernels[1].setArg(4, result.getBuffer( ) ), "Error setting kernel argument" );
+                V_OPENCL( index_set_arg( kernels[1], 5, resultIndex, indexSpan ), "Error setting kernel argument" );
 
-                iType acc = static_cast< iType >( init );
-                for(int i = 0; i < numTailReduce; ++i)
-                {
-                    acc = binary_op(acc, h_result[i]);
-                }
+                ::cl::LocalSpaceArg finalLoc;
+                finalLoc.size_ = 64*sizeof(T);
+                V_OPENCL( kernels[1].setArg(6, finalLoc), "Error setting kernel argument" );
+
+                ::cl::Event finalEvent;
+                l_Error = ctl.getCommandQueue().enqueueNDRangeKernel(
+                    kernels[1],
+                    ::cl::NullRange,
+                    ::cl::NDRange(64),
+                    ::cl::NDRange(64),
+                    NULL,
+                    &finalEvent);
+                V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for the final reduce() kernel" );
+
+                return finalEvent;
+            };
+
+            //  The vectorized first stage loads four elements at a time, with control::getUnroll( ) loads in flight
+            //  per work item, and reduces with the operator itself rather than through the functor
+            template<typename T, typename DVInputIterator, typename BinaryFunction, typename DVOutputIterator>
+            ::cl::Event reduce_vector_enqueue_into(bolt::cl::control &ctl,
+                const DVInputIterator& first,
+                const DVInputIterator& last,
+                const T& init,
+                const BinaryFunction& binary_op,
+                const DVOutputIterator& result,
+                const std::string& cl_code )
+            {
+                typedef typename std::iterator_traits< DVOutputIterator >::value_type rType;
+                typedef reduce_vector_op< BinaryFunction > vectorOp;
+
+                const ::cl::Device& device = ctl.getDevice( );
+                if( device.getInfo< CL_DEVICE_MAX_WORK_GROUP_SIZE >( ) < REDUCE_VECTOR_WGSIZE )
+                    return reduce_generic_enqueue_into( ctl, first, last, init, binary_op, result, cl_code );
+
+                std::vector<std::string> typeNames( reduce_end );
+                typeNames[reduce_iValueType] = TypeName< T >::get( );
+                typeNames[reduce_iIterType] = TypeName< DVInputIterator >::get( );
+                typeNames[reduce_BinaryFunction] = TypeName< BinaryFunction >::get();
+                typeNames[reduce_rValueType] = TypeName< rType >::get( );
+                typeNames[reduce_vValueType] = reduce_vector_type< T >::name( );
+
+                std::vector<std::string> typeDefinitions;
+                PUSH_BACK_UNIQUE( typeDefinitions, ClCode< T >::get() )
+                PUSH_BACK_UNIQUE( typeDefinitions, ClCode< BinaryFunction  >::get() )
+                PUSH_BACK_UNIQUE( typeDefinitions, ClCode< rType >::get() )
+
+                size_t szElements = static_cast< size_t >( first.distance_to( last ) );
+                size_t offset = static_cast< size_t >( first.m_Index );
+                size_t resultIndex = static_cast< size_t >( result.m_Index );
+                size_t indexSpan = std::max( offset + szElements, resultIndex + 1 );
+
+                int unroll = std::max( 1, std::min( ctl.getUnroll( ), 16 ) );
+                std::ostringstream oss;
+                oss << " -D" << vectorOp::define( );
+                oss << " -DREDUCE_UNROLL=" << unroll;
+                oss << " -DREDUCE_VECTOR_WGSIZE=" << REDUCE_VECTOR_WGSIZE;
+                oss << index_compile_options( indexSpan );
+
+                ReduceVector_KernelTemplateSpecializer ts_kts;
+                std::vector< ::cl::Kernel > kernels = bolt::cl::getKernels(
+                    ctl,
+                    typeNames,
+                    &ts_kts,
+                    typeDefinitions,
+                    reduce_kernels,
+                    oss.str( ) );
+
+                //  No more work groups than it takes for every work item to load all its vectors
+                size_t perWorkGroup = REDUCE_VECTOR_WGSIZE * 4 * unroll;
+                size_t numWG = device.getInfo< CL_DEVICE_MAX_COMPUTE_UNITS >( ) * ctl.getWGPerComputeUnit( );
+                numWG = std::max< size_t >( 1, std::min( numWG, ( szElements + perWorkGroup - 1 ) / perWorkGroup ) );
+
+                cl_int l_Error = CL_SUCCESS;
+                ALIGNED( 256 ) BinaryFunction aligned_reduce( binary_op );
+                ::cl::Buffer userFunctor( ctl.getContext( ), CL_MEM_COPY_HOST_PTR|CL_MEM_READ_ONLY,
+                    sizeof( aligned_reduce ), &aligned_reduce, &l_Error );
+                V_OPENCL( l_Error, "Error creating the functor buffer of reduce()" );
+                control::buffPointer partials = ctl.acquireBuffer( sizeof( T ) * numWG, CL_MEM_READ_WRITE );
+
+                V_OPENCL( kernels[0].setArg(0, first.getBuffer( ) ), "Error setting kernel argument" );
+                V_OPENCL( index_set_arg( kernels[0], 1, offset, indexSpan ), "Error setting kernel argument" );
+                V_OPENCL( index_set_arg( kernels[0], 2, szElements, indexSpan ), "Error setting kernel argument" );
+                V_OPENCL( kernels[0].setArg(3, vectorOp::identity( ) ), "Error setting kernel argument" );
+                V_OPENCL( kernels[0].setArg(4, *partials), "Error setting kernel argument" );
+                V_OPENCL( kernels[0].setArg(5, REDUCE_VECTOR_WGSIZE * sizeof( T ), NULL ), "Error setting kernel argument" );
+
+                l_Error = ctl.getCommandQueue().enqueueNDRangeKernel(
+                    kernels[0],
+                    ::cl::NullRange,
+                    ::cl::NDRange(numWG * REDUCE_VECTOR_WGSIZE),
+                    ::cl::NDRange(REDUCE_VECTOR_WGSIZE));
+                V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for the vectorized reduce() kernel" );
+
+                cl_int numPartials = static_cast< cl_int >( numWG );
+                V_OPENCL( kernels[1].setArg(0, *partials), "Error setting kernel argument" );
+                V_OPENCL( kernels[1].setArg(1, numPartials), "Error setting kernel argument" );
+                V_OPENCL( kernels[1].setArg(2, init), "Error setting kernel argument" );
+                V_OPENCL( kernels[1].setArg(3, userFunctor), "Error setting kernel argument" );
+                V_OPENCL( kernels[1].setArg(4, result.getBuffer( ) ), "Error setting kernel argument" );
+                V_OPENCL( index_set_arg( kernels[1], 5, resultIndex, indexSpan ), "Error setting kernel argument" );
+                V_OPENCL( kernels[1].setArg(6, 64 * sizeof( T ), NULL ), "Error setting kernel argument" );
+
+                ::cl::Event finalEvent;
+                l_Error = ctl.getCommandQueue().enqueueNDRangeKernel(
+                    kernels[1],
+                    ::cl::NullRange,
+                    ::cl::NDRange(64),
+                    ::cl::NDRange(64),
+                    NULL,
+                    &finalEvent);
+                V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for the final reduce() kernel" );
+
+                return finalEvent;
+            };
+
+            template<typename T, typename DVInputIterator, typename BinaryFunction, typename DVOutputIterator>
+            typename std::enable_if< reduce_vector_enabled< T, DVInputIterator, BinaryFunction >::value,
+                                     ::cl::Event >::type
+            reduce_enqueue_into(bolt::cl::control &ctl,
+                const DVInputIterator& first,
+                const DVInputIterator& last,
+                const T& init,
+                const BinaryFunction& binary_op,
+                const DVOutputIterator& result,
+                const std::string& cl_code )
+            {
+                return reduce_vector_enqueue_into( ctl, first, last, init, binary_op, result, cl_code );
+            }
+
+            template<typename T, typename DVInputIterator, typename BinaryFunction, typename DVOutputIterator>
+            typename std::enable_if< !reduce_vector_enabled< T, DVInputIterator, BinaryFunction >::value,
+                                     ::cl::Event >::type
+            reduce_enqueue_into(bolt::cl::control &ctl,
+                const DVInputIterator& first,
+                const DVInputIterator& last,
+                const T& init,
+                const BinaryFunction& binary_op,
+                const DVOutputIterator& result,
+                const std::string& cl_code )
+            {
+                return reduce_generic_enqueue_into( ctl, first, last, init, binary_op, result, cl_code );
+            }
+
+            template<typename T, typename DVInputIterator, typename BinaryFunction>
+            T reduce_enqueue(bolt::cl::control &ctl,
+                const DVInputIterator& first,
+                const DVInputIterator& last,
+                const T& init,
+                const BinaryFunction& binary_op,
+                const std::string& cl_code )
+            {
+                if( first.distance_to( last ) == 0 )
+                    return init;
+
+                control::buffPointer resultBuffer = ctl.acquireBuffer( sizeof( T ),
+                    CL_MEM_ALLOC_HOST_PTR|CL_MEM_READ_WRITE );
+                device_vector< T > dvResult( *resultBuffer, ctl );
+                reduce_enqueue_into( ctl, first, last, init, binary_op, dvResult.begin( ), cl_code );
+
+                //  Only the final value is read back
+                T acc;
+                ::cl::Event l_readEvent;
+                cl_int l_Error = ctl.getCommandQueue().enqueueReadBuffer( *resultBuffer, CL_FALSE, 0, sizeof( T ),
+                    &acc, NULL, &l_readEvent );
+                V_OPENCL( l_Error, "Error reading the result of reduce()" );
+                bolt::cl::wait(ctl, l_readEvent, "reduce");
 
                 return acc;
             };
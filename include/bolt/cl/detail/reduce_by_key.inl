@@ -18,15 +18,22 @@
 #define KERNEL1WAVES 4
 #define WAVESIZE 64
 
-#define LENGTH_TEST 10
-#define ENABLE_PRINTS 0
-
 #include <iostream>
-#include <fstream>
+#include <vector>
+
+#ifdef ENABLE_TBB
+#include "tbb/blocked_range.h"
+#include "bolt/cl/detail/tbb_arena.inl"
+#endif
+
+/* \brief - Fewest elements in a chunk of the MultiCoreCpu reduce_by_key */
+#define TBB_REDUCE_BY_KEY_MIN_CHUNK 4096
 
 #if !defined( REDUCE_BY_KEY_INL )
 #define REDUCE_BY_KEY_INL
 
+#include "bolt/cl/detail/segmented_scan.inl"
+
 
 namespace bolt
 {
@@ -263,9 +270,6 @@ class ReduceByKey_KernelTemplateSpecializer : public KernelTemplateSpecializer
 
     ReduceByKey_KernelTemplateSpecializer() : KernelTemplateSpecializer()
     {
-        addKernelName("perBlockScanByKey");
-        addKernelName("intraBlockInclusiveScanByKey");
-        addKernelName("perBlockAdditionByKey");
         addKernelName("keyValueMapping");
     }
     
@@ -274,68 +278,250 @@ class ReduceByKey_KernelTemplateSpecializer : public KernelTemplateSpecializer
         const std::string templateSpecializationString = 
             "// Dynamic specialization of generic template definition, using user supplied types\n"
             "template __attribute__((mangled_name(" + name(0) + "Instantiated)))\n"
-            "__attribute__((reqd_work_group_size(KERNEL0WORKGROUPSIZE,1,1)))\n"
+            "__attribute__((reqd_work_group_size(SEGMENTED_WGSIZE,1,1)))\n"
             "__kernel void " + name(0) + "(\n"
-            "global " + typeNames[e_kType] + "* keys,\n"
-            "global " + typeNames[e_vType] + "* vals,\n"
-            "global " + typeNames[e_voType] + "* output,\n"
-            "global int * output2,\n"
-            "const uint vecSize,\n"
-            "local "  + typeNames[e_kType] + "* ldsKeys,\n"
-            "local "  + typeNames[e_voType] + "* ldsVals,\n"
-            "global " + typeNames[e_BinaryPredicate] + "* binaryPred,\n"
-            "global " + typeNames[e_BinaryFunction]  + "* binaryFunct,\n"
-            "global " + typeNames[e_kType] + "* keyBuffer,\n"
-            "global " + typeNames[e_voType] + "* valBuffer\n"
-            ");\n\n"
-            
-            "// Dynamic specialization of generic template definition, using user supplied types\n"
-            "template __attribute__((mangled_name(" + name(1) + "Instantiated)))\n"
-            "__attribute__((reqd_work_group_size(KERNEL1WORKGROUPSIZE,1,1)))\n"
-            "__kernel void " + name(1) + "(\n"
-            "global " + typeNames[e_kType] + "* keySumArray,\n"
-            "global " + typeNames[e_voType] + "* preSumArray,\n"
-            "global " + typeNames[e_voType] + "* postSumArray,\n"
-            "const uint vecSize,\n"
-            "local "  + typeNames[e_kType] + "* ldsKeys,\n"
-            "local "  + typeNames[e_voType] + "* ldsVals,\n"
-            "const uint workPerThread,\n"
-            "global " + typeNames[e_BinaryPredicate] + "* binaryPred,\n"
-            "global " + typeNames[e_BinaryFunction] + "* binaryFunct\n"
-            ");\n\n"
-    
-
-            "// Dynamic specialization of generic template definition, using user supplied types\n"
-            "template __attribute__((mangled_name(" + name(2) + "Instantiated)))\n"
-            "__attribute__((reqd_work_group_size(KERNEL2WORKGROUPSIZE,1,1)))\n"
-            "__kernel void " + name(2) + "(\n"
-            "global " + typeNames[e_kType] + "* keySumArray,\n"
-            "global " + typeNames[e_voType] + "* postSumArray,\n"
-            "global " + typeNames[e_kType] + "* keys,\n"
-            "global int * output2,\n"
-            "global " + typeNames[e_voType] + "* output,\n"
-            "const uint vecSize,\n"
-            "global " + typeNames[e_BinaryPredicate] + "* binaryPred,\n"
-            "global " + typeNames[e_BinaryFunction] + "* binaryFunct\n"
-            ");\n\n"
-
-            "// Dynamic specialization of generic template definition, using user supplied types\n"
-            "template __attribute__((mangled_name(" + name(3) + "Instantiated)))\n"
-            "__attribute__((reqd_work_group_size(KERNEL0WORKGROUPSIZE,1,1)))\n"
-            "__kernel void " + name(3) + "(\n"
             "global " + typeNames[e_kType] + "*keys,\n"
+            "const indexType keyOffset,\n"
             "global " + typeNames[e_koType] + "*keys_output,\n"
+            "const indexType keyOutOffset,\n"
             "global " + typeNames[e_voType] + "*vals_output,\n"
-            "global int *offsetArray,\n"
-            "global " + typeNames[e_voType] + "*offsetValArray,\n"
-            "const uint vecSize,\n"
-            "const int numSections\n"
+            "const indexType valOutOffset,\n"
+            "global uint *flags,\n"
+            "global indexType *segmentCounts,\n"
+            "global " + typeNames[e_voType] + "*scanned,\n"
+            "const indexType vecSize\n"
             ");\n\n";            
     
         return templateSpecializationString;
     }
 };
 
+/***********************************************************************************************************************
+ * CPU Paths
+ **********************************************************************************************************************/
+/*!
+* \brief Reduces the runs of consecutive keys that binary_pred finds equal, in order; returns the number of runs
+*/
+template<
+    typename kType,
+    typename vType,
+    typename koType,
+    typename voType,
+    typename BinaryPredicate,
+    typename BinaryFunction >
+size_t
+reduce_by_key_serial(
+    const kType* keys,
+    const vType* values,
+    size_t numElements,
+    koType* keys_output,
+    voType* values_output,
+    const BinaryPredicate& binary_pred,
+    const BinaryFunction& binary_op )
+{
+    size_t count = 0;
+    size_t i = 0;
+    while( i != numElements )
+    {
+        keys_output[ count ] = keys[ i ];
+        voType value = values[ i ];
+        for( ++i; i != numElements && binary_pred( keys[ i - 1 ], keys[ i ] ); ++i )
+            value = binary_op( value, values[ i ] );
+        values_output[ count++ ] = value;
+    }
+    return count;
+}
+
+#ifdef ENABLE_TBB
+/*!
+* \brief Counts the segment heads of every chunk; the first element of the range is always a head
+*/
+template< typename kType, typename BinaryPredicate >
+struct tbbReduceByKeyCount
+{
+    const kType* keys;
+    size_t length;
+    size_t chunkSize;
+    size_t* heads;
+    BinaryPredicate binary_pred;
+
+    tbbReduceByKeyCount( const kType* _keys, size_t _length, size_t _chunkSize, size_t* _heads,
+                         const BinaryPredicate& _binary_pred ):
+        keys( _keys ), length( _length ), chunkSize( _chunkSize ), heads( _heads ), binary_pred( _binary_pred )
+    {}
+
+    void operator( )( const tbb::blocked_range< size_t >& chunks ) const
+    {
+        BinaryPredicate localPred( binary_pred );
+        for( size_t chunk = chunks.begin( ); chunk != chunks.end( ); ++chunk )
+        {
+            size_t begin = chunk * chunkSize;
+            size_t end = std::min( begin + chunkSize, length );
+            size_t count = 0;
+            for( size_t i = begin; i != end; ++i )
+            {
+                if( i == 0 || !localPred( keys[ i - 1 ], keys[ i ] ) )
+                    ++count;
+            }
+            heads[ chunk ] = count;
+        }
+    }
+};
+
+/*!
+* \brief Reduces the segments of every chunk
+* \details The segments that start in a chunk are written from the chunk's offset on; the last of them may go on
+* into the next chunks, and is only reduced up to the end of this one.  The values in front of the first head of a
+* chunk belong to a segment of an earlier chunk; their reduction is left in carries, for the fix-up.
+*/
+template< typename kType, typename vType, typename koType, typename voType, typename BinaryPredicate,
+          typename BinaryFunction >
+struct tbbReduceByKeySegments
+{
+    const kType* keys;
+    const vType* values;
+    size_t length;
+    size_t chunkSize;
+    const size_t* offsets;
+    koType* keys_output;
+    voType* values_output;
+    voType* carries;
+    char* hasCarry;
+    BinaryPredicate binary_pred;
+    BinaryFunction binary_op;
+
+    tbbReduceByKeySegments( const kType* _keys, const vType* _values, size_t _length, size_t _chunkSize,
+                            const size_t* _offsets, koType* _keys_output, voType* _values_output, voType* _carries,
+                            char* _hasCarry, const BinaryPredicate& _binary_pred, const BinaryFunction& _binary_op ):
+        keys( _keys ), values( _values ), length( _length ), chunkSize( _chunkSize ), offsets( _offsets ),
+        keys_output( _keys_output ), values_output( _values_output ), carries( _carries ), hasCarry( _hasCarry ),
+        binary_pred( _binary_pred ), binary_op( _binary_op )
+    {}
+
+    void operator( )( const tbb::blocked_range< size_t >& chunks ) const
+    {
+        BinaryPredicate localPred( binary_pred );
+        BinaryFunction localOp( binary_op );
+        for( size_t chunk = chunks.begin( ); chunk != chunks.end( ); ++chunk )
+        {
+            size_t i = chunk * chunkSize;
+            size_t end = std::min( i + chunkSize, length );
+            size_t out = offsets[ chunk ];
+
+            hasCarry[ chunk ] = ( i != 0 && localPred( keys[ i - 1 ], keys[ i ] ) );
+            if( hasCarry[ chunk ] )
+            {
+                voType carry = values[ i ];
+                for( ++i; i != end && localPred( keys[ i - 1 ], keys[ i ] ); ++i )
+                    carry = localOp( carry, values[ i ] );
+                carries[ chunk ] = carry;
+            }
+
+            while( i != end )
+            {
+                keys_output[ out ] = keys[ i ];
+                voType value = values[ i ];
+                for( ++i; i != end && localPred( keys[ i - 1 ], keys[ i ] ); ++i )
+                    value = localOp( value, values[ i ] );
+                values_output[ out++ ] = value;
+            }
+        }
+    }
+};
+
+/*!
+* \brief Parallel segmented reduction: the chunks count their heads, an exclusive scan of the counts gives every
+* chunk its place in the output, the chunks reduce their segments, and the carries of the segments that cross
+* chunks are folded into their outputs, in order, at the end
+*/
+template<
+    typename kType,
+    typename vType,
+    typename koType,
+    typename voType,
+    typename BinaryPredicate,
+    typename BinaryFunction >
+size_t
+tbb_reduce_by_key(
+    control& ctl,
+    const kType* keys,
+    const vType* values,
+    size_t numElements,
+    koType* keys_output,
+    voType* values_output,
+    const BinaryPredicate& binary_pred,
+    const BinaryFunction& binary_op )
+{
+    control::tbbPartitionDesc part = ctl.getTbbPartitioner( "reduce_by_key" );
+    size_t chunkSize = std::max< size_t >( part.grainSize, TBB_REDUCE_BY_KEY_MIN_CHUNK );
+    if( numElements <= chunkSize )
+        return reduce_by_key_serial( keys, values, numElements, keys_output, values_output, binary_pred, binary_op );
+
+    size_t numChunks = ( numElements + chunkSize - 1 ) / chunkSize;
+    std::vector< size_t > offsets( numChunks );
+    detail::tbb_parallel_for( ctl, tbb::blocked_range< size_t >( 0, numChunks ),
+        tbbReduceByKeyCount< kType, BinaryPredicate >( keys, numElements, chunkSize, &offsets[ 0 ], binary_pred ),
+        part.partitioner );
+
+    size_t count = 0;
+    for( size_t chunk = 0; chunk < numChunks; ++chunk )
+    {
+        size_t heads = offsets[ chunk ];
+        offsets[ chunk ] = count;
+        count += heads;
+    }
+
+    std::vector< voType > carries( numChunks );
+    std::vector< char > hasCarry( numChunks );
+    detail::tbb_parallel_for( ctl, tbb::blocked_range< size_t >( 0, numChunks ),
+        tbbReduceByKeySegments< kType, vType, koType, voType, BinaryPredicate, BinaryFunction >( keys, values,
+            numElements, chunkSize, &offsets[ 0 ], keys_output, values_output, &carries[ 0 ], &hasCarry[ 0 ],
+            binary_pred, binary_op ),
+        part.partitioner );
+
+    //  A carry goes to the last segment that started before its chunk, which is just in front of the chunk's offset
+    for( size_t chunk = 1; chunk < numChunks; ++chunk )
+    {
+        if( hasCarry[ chunk ] )
+        {
+            voType& segment = values_output[ offsets[ chunk ] - 1 ];
+            segment = binary_op( segment, carries[ chunk ] );
+        }
+    }
+
+    return count;
+}
+#endif
+
+template<
+    typename kType,
+    typename vType,
+    typename koType,
+    typename voType,
+    typename BinaryPredicate,
+    typename BinaryFunction >
+size_t
+reduce_by_key_cpu(
+    control& ctl,
+    bolt::cl::control::e_RunMode runMode,
+    const kType* keys,
+    const vType* values,
+    size_t numElements,
+    koType* keys_output,
+    voType* values_output,
+    const BinaryPredicate& binary_pred,
+    const BinaryFunction& binary_op )
+{
+    if( runMode == bolt::cl::control::SerialCpu )
+        return reduce_by_key_serial( keys, values, numElements, keys_output, values_output, binary_pred, binary_op );
+
+#ifdef ENABLE_TBB
+    return tbb_reduce_by_key( ctl, keys, values, numElements, keys_output, values_output, binary_pred, binary_op );
+#else
+    throw ::cl::Error( CL_INVALID_OPERATION, "The MultiCoreCpu version of reduce_by_key is not enabled to be built." );
+#endif
+}
+
 /***********************************************************************************************************************
  * Detect Random Access
  **********************************************************************************************************************/
@@ -427,17 +613,26 @@ reduce_by_key_pick_iterator(
     typedef typename std::iterator_traits< OutputIterator2 >::value_type voType;
     static_assert( std::is_convertible< vType, voType >::value, "InputValue and Output iterators are incompatible" );
 
-    unsigned int numElements = static_cast< unsigned int >( std::distance( keys_first, keys_last ) );
-    if( numElements == 1 )
-        return bolt::cl::make_pair( keys_last, values_first+numElements );
+    size_t numElements = static_cast< size_t >( std::distance( keys_first, keys_last ) );
+    if( numElements == 0 )
+        return bolt::cl::make_pair( keys_output, values_output );
 
      bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
      if(runMode == bolt::cl::control::Automatic)
      {
            runMode = ctl.getDefaultPathToRun();
      }
-    unsigned int sizeOfOut;
+    //  A single segment is not worth a kernel launch
+    if( numElements == 1 )
+        runMode = bolt::cl::control::SerialCpu;
+    size_t sizeOfOut;
 
+    if( runMode == bolt::cl::control::SerialCpu || runMode == bolt::cl::control::MultiCoreCpu )
+    {
+        sizeOfOut = reduce_by_key_cpu( ctl, runMode, &*keys_first, &*values_first, numElements, &*keys_output,
+            &*values_output, binary_pred, binary_op );
+    }
+    else
     {
 
         // Map the input iterator to a device_vector
@@ -447,7 +642,7 @@ reduce_by_key_pick_iterator(
         device_vector< voType > dvVOutput( values_output, numElements, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY, false, ctl );
 
         //Now call the actual cl algorithm
-        sizeOfOut = reduce_by_key_enqueue( ctl, dvKeys.begin( ), dvKeys.end( ), dvValues.begin(), dvKOutput.begin( ),dvVOutput.end( ), binary_pred, binary_op, user_code);
+        sizeOfOut = reduce_by_key_enqueue( ctl, dvKeys.begin( ), dvKeys.end( ), dvValues.begin(), dvKOutput.begin( ),dvVOutput.begin( ), binary_pred, binary_op, user_code);
 
         // This should immediately map/unmap the buffer
         dvKOutput.data( );
@@ -495,26 +690,32 @@ reduce_by_key_pick_iterator(
     typedef typename std::iterator_traits< DVOutputIterator2 >::value_type voType;
     static_assert( std::is_convertible< vType, voType >::value, "InputValue and Output iterators are incompatible" );
 
-    unsigned int numElements = static_cast< unsigned int >( std::distance( keys_first, keys_last ) );
+    size_t numElements = static_cast< size_t >( std::distance( keys_first, keys_last ) );
     if( numElements < 1 )
-        return void;
+        return bolt::cl::make_pair( keys_output, values_output );
 
-    const bolt::cl::control::e_RunMode runMode = ctl.forceRunMode( );  // could be dynamic choice some day.
-    if( runMode == bolt::cl::control::SerialCpu )
+    bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode( );  // could be dynamic choice some day.
+    if( runMode == bolt::cl::control::Automatic )
     {
-        //  TODO:  Need access to the device_vector .data method to get a host pointer
-        throw ::cl::Error( CL_INVALID_DEVICE, "ReduceByKey device_vector CPU device not implemented" );
-        return void;
+        runMode = ctl.getDefaultPathToRun( );
     }
-    else if( runMode == bolt::cl::control::MultiCoreCpu )
+    if( runMode == bolt::cl::control::SerialCpu || runMode == bolt::cl::control::MultiCoreCpu )
     {
-        //  TODO:  Need access to the device_vector .data method to get a host pointer
-        throw ::cl::Error( CL_INVALID_DEVICE, "ReduceByKey device_vector CPU device not implemented" );
-        return void;
+        //  Every buffer is mapped once for the whole reduction, and unmapped when its pointer goes out of scope
+        typename device_vector< kType >::pointer keysPtr = keys_first.getContainer( ).data( );
+        typename device_vector< vType >::pointer valuesPtr = values_first.getContainer( ).data( );
+        typename device_vector< koType >::pointer keysOutputPtr = keys_output.getContainer( ).data( );
+        typename device_vector< voType >::pointer valuesOutputPtr = values_output.getContainer( ).data( );
+
+        size_t sizeOfOut = reduce_by_key_cpu( ctl, runMode, &keysPtr[ keys_first.m_Index ],
+            &valuesPtr[ values_first.m_Index ], numElements, &keysOutputPtr[ keys_output.m_Index ],
+            &valuesOutputPtr[ values_output.m_Index ], binary_pred, binary_op );
+
+        return bolt::cl::make_pair( keys_output + sizeOfOut, values_output + sizeOfOut );
     }
 
     //Now call the actual cl algorithm
-    unsigned int sizeOfOut = reduce_by_key_enqueue( ctl, keys_first, keys_last, values_first, keys_output,
+    size_t sizeOfOut = reduce_by_key_enqueue( ctl, keys_first, keys_last, values_first, keys_output,
             values_output, binary_pred, binary_op, user_code);
 
     
@@ -522,6 +723,26 @@ reduce_by_key_pick_iterator(
 }
 
 
+//  Numbers the segments with the inclusive scan of the head counts, of the kernels' indexType, in place
+template< typename indexType >
+void reduce_by_key_number_segments( control& ctl, const ::cl::Buffer& counts, size_t flagWords )
+{
+    device_vector< indexType > dvCounts( counts, ctl );
+    scan_enqueue( ctl, dvCounts.begin( ), dvCounts.begin( ) + flagWords, dvCounts.begin( ), indexType( 0 ),
+                  bolt::cl::plus< indexType >( ), true );
+}
+
+//  Reads the number of segments back from the last word of the numbered head counts
+template< typename indexType >
+size_t reduce_by_key_segment_count( control& ctl, const ::cl::Buffer& counts, size_t flagWords )
+{
+    indexType count = 0;
+    V_OPENCL( ctl.getCommandQueue( ).enqueueReadBuffer( counts, CL_TRUE, ( flagWords - 1 ) * sizeof( indexType ),
+                                                         sizeof( indexType ), &count ),
+              "Error reading the reduce_by_key segment count" );
+    return static_cast< size_t >( count );
+}
+
 //  All calls to reduce_by_key end up here, unless an exception was thrown
 //  This is the function that sets up the kernels to compile (once only) and execute
 template<
@@ -531,7 +752,7 @@ template<
     typename DVOutputIterator2,
     typename BinaryPredicate,
     typename BinaryFunction >
-unsigned int
+size_t
 reduce_by_key_enqueue(
     control& ctl,
     const DVInputIterator1& keys_first,
@@ -543,7 +764,16 @@ reduce_by_key_enqueue(
     const BinaryFunction& binary_op,
     const std::string& user_code)
 {
-    cl_int l_Error;
+    size_t numElements = static_cast< size_t >( std::distance( keys_first, keys_last ) );
+    if( numElements == 0 )
+        return 0;
+
+    size_t keyOffset = static_cast< size_t >( keys_first.m_Index );
+    size_t valueOffset = static_cast< size_t >( values_first.m_Index );
+    size_t keyOutOffset = static_cast< size_t >( keys_output.m_Index );
+    size_t valOutOffset = static_cast< size_t >( values_output.m_Index );
+    size_t indexSpan = std::max( std::max( keyOffset, valueOffset ), std::max( keyOutOffset, valOutOffset ) ) +
+                       numElements;
 
     /**********************************************************************************
      * Type Names - used in KernelTemplateSpecializer
@@ -584,21 +814,6 @@ reduce_by_key_enqueue(
     PUSH_BACK_UNIQUE( typeDefs, ClCode< BinaryPredicate >::get() )
     PUSH_BACK_UNIQUE( typeDefs, ClCode< BinaryFunction  >::get() )
 
-    /**********************************************************************************
-     * Compile Options
-     *********************************************************************************/
-    bool cpuDevice = ctl.getDevice().getInfo<CL_DEVICE_TYPE>() == CL_DEVICE_TYPE_CPU;
-    //std::cout << "Device is CPU: " << (cpuDevice?"TRUE":"FALSE") << std::endl;
-    const size_t kernel0_WgSize = (cpuDevice) ? 1 : WAVESIZE*KERNEL02WAVES;
-    const size_t kernel1_WgSize = (cpuDevice) ? 1 : WAVESIZE*KERNEL1WAVES;
-    const size_t kernel2_WgSize = (cpuDevice) ? 1 : WAVESIZE*KERNEL02WAVES;
-    std::string compileOptions;
-    std::ostringstream oss;
-    oss << " -DKERNEL0WORKGROUPSIZE=" << kernel0_WgSize;
-    oss << " -DKERNEL1WORKGROUPSIZE=" << kernel1_WgSize;
-    oss << " -DKERNEL2WORKGROUPSIZE=" << kernel2_WgSize;
-    compileOptions = oss.str();
-    
     /**********************************************************************************
      * Request Compiled Kernels
      *********************************************************************************/
@@ -609,336 +824,53 @@ reduce_by_key_enqueue(
         &ts_kts,
         typeDefs,
         reduce_by_key_kernels,
-        compileOptions);
+        segmented_compile_options( indexSpan ));
     // kernels returned in same order as added in KernelTemplaceSpecializer constructor
 
-    // for profiling
-    ::cl::Event kernel0Event, kernel1Event, kernel2Event, kernelAEvent, kernel3Event;
-
-    // Set up shape of launch grid and buffers:
-    int computeUnits     = ctl.getDevice( ).getInfo< CL_DEVICE_MAX_COMPUTE_UNITS >( );
-    int wgPerComputeUnit =  ctl.getWGPerComputeUnit( );
-    int resultCnt = computeUnits * wgPerComputeUnit;
-
-    //  Ceiling function to bump the size of input to the next whole wavefront size
-    cl_uint numElements = static_cast< cl_uint >( std::distance( keys_first, keys_last ) );
-    device_vector< kType >::size_type sizeInputBuff = numElements;
-    size_t modWgSize = (sizeInputBuff & (kernel0_WgSize-1));
-    if( modWgSize )
-    {
-        sizeInputBuff &= ~modWgSize;
-        sizeInputBuff += kernel0_WgSize;
-    }
-    cl_uint numWorkGroupsK0 = static_cast< cl_uint >( sizeInputBuff / kernel0_WgSize );
-
-    //  Ceiling function to bump the size of the sum array to the next whole wavefront size
-    device_vector< kType >::size_type sizeScanBuff = numWorkGroupsK0;
-    modWgSize = (sizeScanBuff & (kernel0_WgSize-1));
-    if( modWgSize )
-    {
-        sizeScanBuff &= ~modWgSize;
-        sizeScanBuff += kernel0_WgSize;
-    }
-
-    // Create buffer wrappers so we can access the host functors, for read or writing in the kernel
-    
-    ALIGNED( 256 ) BinaryPredicate aligned_binary_pred( binary_pred );
-    control::buffPointer binaryPredicateBuffer = ctl.acquireBuffer( sizeof( aligned_binary_pred ),
-        CL_MEM_USE_HOST_PTR|CL_MEM_READ_ONLY, &aligned_binary_pred );
-     ALIGNED( 256 ) BinaryFunction aligned_binary_op( binary_op );
-    control::buffPointer binaryFunctionBuffer = ctl.acquireBuffer( sizeof( aligned_binary_op ),
-        CL_MEM_USE_HOST_PTR|CL_MEM_READ_ONLY, &aligned_binary_op );
-
-    control::buffPointer keySumArray  = ctl.acquireBuffer( sizeScanBuff*sizeof( kType ) );
-    control::buffPointer preSumArray  = ctl.acquireBuffer( sizeScanBuff*sizeof( voType ) );
-    control::buffPointer postSumArray = ctl.acquireBuffer( sizeScanBuff*sizeof( voType ) );
-    control::buffPointer offsetArray  = ctl.acquireBuffer( numElements *sizeof( int ) );
-    control::buffPointer offsetValArray  = ctl.acquireBuffer( numElements *sizeof( voType ) );
-    cl_uint ldsKeySize, ldsValueSize;
-
-    //Fill the buffer with zeros
-    ::cl::Event fillEvent;
-    ctl.getCommandQueue().enqueueFillBuffer( *offsetArray, 0, 0, numElements *sizeof( int ), NULL, &fillEvent);
-    bolt::cl::wait(ctl, fillEvent);
-
-
-    /**********************************************************************************
-     *  Kernel 0
-     *********************************************************************************/
-    try
-    {
-    ldsKeySize   = static_cast< cl_uint >( kernel0_WgSize * sizeof( kType ) );
-    ldsValueSize = static_cast< cl_uint >( kernel0_WgSize * sizeof( voType ) );
-    V_OPENCL( kernels[0].setArg( 0, keys_first.getBuffer()), "Error setArg kernels[ 0 ]" ); // Input keys
-    V_OPENCL( kernels[0].setArg( 1, values_first.getBuffer()),"Error setArg kernels[ 0 ]" ); // Input values
-    V_OPENCL( kernels[0].setArg( 2, *offsetValArray ), "Error setArg kernels[ 0 ]" ); // Output values
-    V_OPENCL( kernels[0].setArg( 3, *offsetArray  ), "Error setArg kernels[ 0 ]" ); // Output keys
-    V_OPENCL( kernels[0].setArg( 4, numElements ), "Error setArg kernels[ 0 ]" ); // vecSize
-    V_OPENCL( kernels[0].setArg( 5, ldsKeySize, NULL ),     "Error setArg kernels[ 0 ]" ); // Scratch buffer
-    V_OPENCL( kernels[0].setArg( 6, ldsValueSize, NULL ),   "Error setArg kernels[ 0 ]" ); // Scratch buffer
-    V_OPENCL( kernels[0].setArg( 7, *binaryPredicateBuffer),"Error setArg kernels[ 0 ]" ); // User provided functor
-    V_OPENCL( kernels[0].setArg( 8, *binaryFunctionBuffer ),"Error setArg kernels[ 0 ]" ); // User provided functor
-    V_OPENCL( kernels[0].setArg( 9, *keySumArray ),         "Error setArg kernels[ 0 ]" ); // Output per block sum
-    V_OPENCL( kernels[0].setArg( 10, *preSumArray ),         "Error setArg kernels[ 0 ]" ); // Output per block sum
-    
-    l_Error = ctl.getCommandQueue( ).enqueueNDRangeKernel(
-        kernels[0],
-        ::cl::NullRange,
-        ::cl::NDRange( sizeInputBuff ),
-        ::cl::NDRange( kernel0_WgSize ),
-        NULL,
-        &kernel0Event);
-    V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for kernel[0]" );
-    }
-    catch( const ::cl::Error& e)
-    {
-        std::cerr << "::cl::enqueueNDRangeKernel( 0 ) in bolt::cl::reduce_by_key_enqueue()" << std::endl;
-        std::cerr << "Error Code:   " << clErrorStringA(e.err()) << " (" << e.err() << ")" << std::endl;
-        std::cerr << "File:         " << __FILE__ << ", line " << __LINE__ << std::endl;
-        std::cerr << "Error String: " << e.what() << std::endl;
-    }
-
-    /**********************************************************************************
-     *  Kernel 1
-     *********************************************************************************/
-    cl_uint workPerThread = static_cast< cl_uint >( sizeScanBuff / kernel1_WgSize );
-    V_OPENCL( kernels[1].setArg( 0, *keySumArray ),         "Error setArg kernels[ 1 ]" ); // Input keys
-    V_OPENCL( kernels[1].setArg( 1, *preSumArray ),         "Error setArg kernels[ 1 ]" ); // Input buffer
-    V_OPENCL( kernels[1].setArg( 2, *postSumArray ),        "Error setArg kernels[ 1 ]" ); // Output buffer
-    V_OPENCL( kernels[1].setArg( 3, numWorkGroupsK0 ),      "Error setArg kernels[ 1 ]" ); // Size of scratch buffer
-    V_OPENCL( kernels[1].setArg( 4, ldsKeySize, NULL ),     "Error setArg kernels[ 1 ]" ); // Scratch buffer
-    V_OPENCL( kernels[1].setArg( 5, ldsValueSize, NULL ),   "Error setArg kernels[ 1 ]" ); // Scratch buffer
-    V_OPENCL( kernels[1].setArg( 6, workPerThread ),        "Error setArg kernels[ 1 ]" ); // Work Per Thread
-    V_OPENCL( kernels[1].setArg( 7, *binaryPredicateBuffer ),"Error setArg kernels[ 1 ]" ); // User provided functor
-    V_OPENCL( kernels[1].setArg( 8, *binaryFunctionBuffer ),"Error setArg kernels[ 1 ]" ); // User provided functor
-
-    try
-    {
-    l_Error = ctl.getCommandQueue( ).enqueueNDRangeKernel(
-        kernels[1],
-        ::cl::NullRange,
-        ::cl::NDRange( kernel1_WgSize ), // only 1 work-group
-        ::cl::NDRange( kernel1_WgSize ),
-        NULL,
-        &kernel1Event);
-    V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for kernel[1]" );
-    }
-    catch( const ::cl::Error& e)
-    {
-        std::cerr << "::cl::enqueueNDRangeKernel( 1 ) in bolt::cl::reduce_by_key_enqueue()" << std::endl;
-        std::cerr << "Error Code:   " << clErrorStringA(e.err()) << " (" << e.err() << ")" << std::endl;
-        std::cerr << "File:         " << __FILE__ << ", line " << __LINE__ << std::endl;
-        std::cerr << "Error String: " << e.what() << std::endl;
-    }
-
-#if ENABLE_PRINTS
-    //delete this code -start
-    bolt::cl::wait(ctl, kernel0Event); 
-    bolt::cl::wait(ctl, kernel1Event); 
-    ::cl::Event l_mapEvent_k1;
-    voType *post_sum_k1= (voType*)ctl.commandQueue().enqueueMapBuffer( *postSumArray,
-                                                                    false,
-                                                                    CL_MAP_READ,
-                                                                    0,
-                                                                    sizeof(voType)*sizeScanBuff,
-                                                                    NULL,
-                                                                    &l_mapEvent_k1,
-                                                                    &l_Error );
-    V_OPENCL( l_Error, "Error calling map on the result buffer" );
-    std::cout<<"Myval-------------------------starts"<<std::endl;
-    std::ofstream postsum("postsum.txt");
-    for(unsigned int i = 0; i < sizeScanBuff ; i++)
-    {
-        postsum<<post_sum_k1[i]<<std::endl;
-    }
-    postsum.close();
-    std::cout<<"Myval-------------------------ends"<<std::endl;
-    bolt::cl::wait(ctl, l_mapEvent_k1); 
-    //delete this code -end
-
-#endif
-
-    /**********************************************************************************
-     *  Kernel 2
-     *********************************************************************************/
-    V_OPENCL( kernels[2].setArg( 0, *keySumArray ),         "Error setArg kernels[ 2 ]" ); // Input buffer
-    V_OPENCL( kernels[2].setArg( 1, *postSumArray ),        "Error setArg kernels[ 2 ]" ); // Input buffer
-    V_OPENCL( kernels[2].setArg( 2, keys_first.getBuffer()), "Error setArg kernels[ 2 ]" ); // Output buffer
-    V_OPENCL( kernels[2].setArg( 3, *offsetArray), "Error setArg kernels[ 2 ]" ); // Output buffer
-    V_OPENCL( kernels[2].setArg( 4, *offsetValArray),   "Error setArg kernels[ 2 ]" ); // Output buffer
-    V_OPENCL( kernels[2].setArg( 5, numElements ),          "Error setArg kernels[ 2 ]" ); // Size of scratch buffer
-    V_OPENCL( kernels[2].setArg( 6, *binaryPredicateBuffer ),"Error setArg kernels[ 2 ]" ); // User provided functor
-    V_OPENCL( kernels[2].setArg( 7, *binaryFunctionBuffer ),"Error setArg kernels[ 2 ]" ); // User provided functor
-
-    try
-    {
-    l_Error = ctl.getCommandQueue( ).enqueueNDRangeKernel(
-        kernels[2],
-        ::cl::NullRange,
-        ::cl::NDRange( sizeInputBuff ),
-        ::cl::NDRange( kernel2_WgSize ),
-        NULL,
-        &kernel2Event );
-    V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for kernel[2]" );
-    }
-    catch( const ::cl::Error& e)
-    {
-        std::cerr << "::cl::enqueueNDRangeKernel( 2 ) in bolt::cl::reduce_by_key_enqueue()" << std::endl;
-        std::cerr << "Error Code:   " << clErrorStringA(e.err()) << " (" << e.err() << ")" << std::endl;
-        std::cerr << "File:         " << __FILE__ << ", line " << __LINE__ << std::endl;
-        std::cerr << "Error String: " << e.what() << std::endl;
-    }
-
-    // wait for results
-    l_Error = kernel2Event.wait( );
-    V_OPENCL( l_Error, "post-kernel[2] failed wait" );
-
     //
-    // Now take the output keys and increment each non-zero value from previous value.
-    // This is done serially. It doesn't look GPU friendly.
+    //  The keys are compared once, into a bitmap of segment heads with the number of heads in every word of it, and
+    //  the values are scanned by segment under the bitmap.  The last element of every segment then holds its
+    //  reduction.
     //
+    size_t flagWords = segmented_flag_words( numElements );
+    control::buffPointer flags  = ctl.acquireBuffer( flagWords * sizeof( cl_uint ) );
+    control::buffPointer counts = ctl.acquireBuffer( flagWords * index_size( indexSpan ) );
+    control::buffPointer scannedValues = ctl.acquireBuffer( numElements * sizeof( voType ) );
 
-    ::cl::Event l_mapEvent;
-    int *h_result = (int*)ctl.getCommandQueue().enqueueMapBuffer( *offsetArray,
-                                                                    false,
-                                                                    CL_MAP_READ | CL_MAP_WRITE,
-                                                                    0,
-                                                                    sizeof(int)*numElements,
-                                                                    NULL,
-                                                                    &l_mapEvent,
-                                                                    &l_Error );
-    V_OPENCL( l_Error, "Error calling map on the result buffer" );
-
-    bolt::cl::wait(ctl, l_mapEvent);
-    
-#if ENABLE_PRINTS
-    //delete this code -start
-    ::cl::Event l_mapEvent2;
-    voType *v_result = (voType*)ctl.commandQueue().enqueueMapBuffer( *offsetValArray,
-                                                                    false,
-                                                                    CL_MAP_READ,
-                                                                    0,
-                                                                    sizeof(voType)*numElements,
-                                                                    NULL,
-                                                                    &l_mapEvent2,
-                                                                    &l_Error );
-    V_OPENCL( l_Error, "Error calling map on the result buffer" );
-    std::cout<<"Myval-------------------------starts"<<std::endl;
-    std::ofstream val_result("offsetValArray.txt");
-    val_result<<numElements<<std::endl;
-    for(unsigned int i = 0; i < LENGTH_TEST ; i++)
-    {
-        val_result<<v_result[i]<<std::endl;
-    }
-    val_result.close();
-    std::cout<<"Myval-------------------------ends"<<std::endl;
-    bolt::cl::wait(ctl, l_mapEvent2); 
-    //delete this code -end
-    std::ofstream result_b4_ser("result_b4_ser.txt");
-    for(unsigned int i = 0; i < LENGTH_TEST ; i++)
-    {
-        //std::cout<<h_result[i]<<std::endl;
-        
-        result_b4_ser<<h_result[i]<<std::endl;
-    }
-    result_b4_ser.close();
+    segmented_head_flags_enqueue< kType >( ctl, keys_first.getBuffer( ), keyOffset, numElements, binary_pred,
+        user_code, *flags, *counts, indexSpan );
+    segmented_scan_enqueue< vType, voType >( ctl, values_first.getBuffer( ), valueOffset, numElements, *flags,
+        *scannedValues, 0, voType( ), binary_op, user_code, true, indexSpan );
 
-#endif
-
-    // Doing this serially; Performance killer!!
-    unsigned int count_number_of_sections = 0;
-    //h_result [ numElements - 1 ] = 1;  //This is a quick fix!
-    for( unsigned int i = 0; i < numElements; i++ )
-    {        
-        if(h_result[i]>0)
-        {
-            h_result[i] = count_number_of_sections;
-            count_number_of_sections++;
-        }
-    }
-    
-
-#if ENABLE_PRINTS
-    std::cout<<count_number_of_sections<<std::endl;
-    std::ofstream result_file("offsetArray.txt");
-    for(unsigned int i = 0; i < LENGTH_TEST ; i++)
-    {
-        result_file<<h_result[i]<<std::endl;
-    }
-    result_file.close();
-
-#endif
     //
-    // Now unmap it. We map the indices back to keys_output using "keys_output"
+    //  The inclusive scan of the head counts numbers the segments on the device, a word of 32 elements at a time;
+    //  the last word holds the segment count.
     //
-
-    ::cl::Event l_unmapEvent;
-    cl_int l_unmapError = CL_SUCCESS;
-    l_unmapError = ctl.getCommandQueue().enqueueUnmapMemObject( *offsetArray , h_result, NULL, &l_unmapEvent );
-    V_OPENCL( l_unmapError, "device_vector failed to unmap host memory back to device memory" );
-    //V_OPENCL( l_unmapEvent.wait( ), "failed to wait for unmap event" );
-
-    bolt::cl::wait(ctl, l_unmapEvent);
+    if( index_fits_32( indexSpan ) )
+        reduce_by_key_number_segments< cl_uint >( ctl, *counts, flagWords );
+    else
+        reduce_by_key_number_segments< cl_ulong >( ctl, *counts, flagWords );
 
     /**********************************************************************************
-     *  Kernel 3
+     *  Kernel 0
      *********************************************************************************/
-    V_OPENCL( kernels[3].setArg( 0, keys_first.getBuffer()),    "Error setArg kernels[ 3 ]" ); // Input buffer
-    V_OPENCL( kernels[3].setArg( 1, keys_output.getBuffer() ),  "Error setArg kernels[ 3 ]" ); // Output buffer
-    V_OPENCL( kernels[3].setArg( 2, values_output.getBuffer()), "Error setArg kernels[ 3 ]" ); // Output buffer
-    V_OPENCL( kernels[3].setArg( 3, *offsetArray),                "Error setArg kernels[ 3 ]" ); // Input buffer
-    V_OPENCL( kernels[3].setArg( 4, *offsetValArray),             "Error setArg kernels[ 3 ]"  );
-    V_OPENCL( kernels[3].setArg( 5, numElements ),               "Error setArg kernels[ 3 ]" ); // Size of scratch buffer
-    V_OPENCL( kernels[3].setArg( 6, count_number_of_sections),               "Error setArg kernels[ 3 ]" ); // Size of scratch buffer
-
-
-    try
-    {
-    l_Error = ctl.getCommandQueue( ).enqueueNDRangeKernel(
-        kernels[3],
-        ::cl::NullRange,
-        ::cl::NDRange( sizeInputBuff ),
-        ::cl::NDRange( kernel0_WgSize ),
-        NULL,
-        &kernel3Event );
-    V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for kernel[3]" );
-    }
-    catch( const ::cl::Error& e)
-    {
-        std::cerr << "::cl::enqueueNDRangeKernel( 3 ) in bolt::cl::reduce_by_key_enqueue()" << std::endl;
-        std::cerr << "Error Code:   " << clErrorStringA(e.err()) << " (" << e.err() << ")" << std::endl;
-        std::cerr << "File:         " << __FILE__ << ", line " << __LINE__ << std::endl;
-        std::cerr << "Error String: " << e.what() << std::endl;
-    }
-    // wait for results
-    l_Error = kernel3Event.wait( );
-    V_OPENCL( l_Error, "post-kernel[3] failed wait" );
-
-#if ENABLE_PRINTS
-    //delete this code -start
-    ::cl::Event l_mapEvent3;
-    voType *v_result2 = (voType*)ctl.commandQueue().enqueueMapBuffer( *offsetValArray,
-                                                                    false,
-                                                                    CL_MAP_READ,
-                                                                    0,
-                                                                    sizeof(voType)*numElements,
-                                                                    NULL,
-                                                                    &l_mapEvent3,
-                                                                    &l_Error );
-    V_OPENCL( l_Error, "Error calling map on the result buffer" );
-    std::cout<<"Myval-------------------------starts"<<std::endl;
-    std::ofstream result_val_after_launch("result_val_after_launch.txt");
-    for(unsigned int i = 0; i < LENGTH_TEST ; i++)
-    {
-        result_val_after_launch<<v_result2[i]<<std::endl;
-    }
-    result_val_after_launch.close();
-    std::cout<<"Myval-------------------------ends"<<std::endl;
-    bolt::cl::wait(ctl, l_mapEvent3); 
-    //delete this code -end
-
-#endif
-    return count_number_of_sections;
+    V_OPENCL( kernels[0].setArg( 0, keys_first.getBuffer()),    "Error setArg kernels[ 0 ]" ); // Input keys
+    V_OPENCL( index_set_arg( kernels[0], 1, keyOffset, indexSpan ),    "Error setArg kernels[ 0 ]" );
+    V_OPENCL( kernels[0].setArg( 2, keys_output.getBuffer() ),  "Error setArg kernels[ 0 ]" ); // Output keys
+    V_OPENCL( index_set_arg( kernels[0], 3, keyOutOffset, indexSpan ), "Error setArg kernels[ 0 ]" );
+    V_OPENCL( kernels[0].setArg( 4, values_output.getBuffer()), "Error setArg kernels[ 0 ]" ); // Output values
+    V_OPENCL( index_set_arg( kernels[0], 5, valOutOffset, indexSpan ), "Error setArg kernels[ 0 ]" );
+    V_OPENCL( kernels[0].setArg( 6, *flags ),                   "Error setArg kernels[ 0 ]" ); // Head flags
+    V_OPENCL( kernels[0].setArg( 7, *counts ),                  "Error setArg kernels[ 0 ]" ); // Segment numbers
+    V_OPENCL( kernels[0].setArg( 8, *scannedValues ),           "Error setArg kernels[ 0 ]" ); // Scanned values
+    V_OPENCL( index_set_arg( kernels[0], 9, numElements, indexSpan ),  "Error setArg kernels[ 0 ]" );
+
+    segmented_run( ctl, kernels[0], segmented_blocks( numElements ), "enqueueNDRangeKernel() failed for kernel[0]" );
+
+    //  The segment count is the only data read back; the blocking read follows the mapping in the queue
+    if( index_fits_32( indexSpan ) )
+        return reduce_by_key_segment_count< cl_uint >( ctl, *counts, flagWords );
+    return reduce_by_key_segment_count< cl_ulong >( ctl, *counts, flagWords );
     }   //end of reduce_by_key_enqueue( )
 
     /*!   \}  */
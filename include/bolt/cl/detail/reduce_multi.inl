@@ -0,0 +1,493 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#if !defined( OCL_REDUCE_MULTI_INL )
+#define OCL_REDUCE_MULTI_INL
+#pragma once
+
+#define REDUCE_MULTI_WGSIZE 64
+
+#include <string>
+#include <sstream>
+#include <tuple>
+
+#include "bolt/cl/bolt.h"
+#include "bolt/cl/detail/index_type.inl"
+
+#ifdef ENABLE_TBB
+#include "tbb/parallel_reduce.h"
+#include "tbb/blocked_range.h"
+#include "bolt/cl/detail/tbb_arena.inl"
+#endif
+
+namespace bolt {
+namespace cl {
+
+namespace detail {
+
+    //  Mirrors reduceMultiValue in reduce_multi_kernels.cl: one field per reduction
+    template< typename T0, typename T1, typename T2, typename T3 >
+    struct reduceMultiValue
+    {
+        T0 v0;
+        T1 v1;
+        T2 v2;
+        T3 v3;
+    };
+
+    //  Mirrors reduceMultiOps in reduce_multi_kernels.cl, so that all the functors go to the device in one buffer
+    template< typename R0, typename R1, typename R2, typename R3 >
+    struct reduceMultiOps
+    {
+        typedef reduceMultiValue< typename R0::value_type, typename R1::value_type, typename R2::value_type,
+            typename R3::value_type > value_type;
+
+        reduceMultiOps( const R0& r0, const R1& r1, const R2& r2, const R3& r3 ):
+            transform0( r0.transform_op ), reduce0( r0.reduce_op ), transform1( r1.transform_op ),
+            reduce1( r1.reduce_op ), transform2( r2.transform_op ), reduce2( r2.reduce_op ),
+            transform3( r3.transform_op ), reduce3( r3.reduce_op )
+        {}
+
+        typename R0::transform_type transform0;
+        typename R0::reduce_type reduce0;
+        typename R1::transform_type transform1;
+        typename R1::reduce_type reduce1;
+        typename R2::transform_type transform2;
+        typename R2::reduce_type reduce2;
+        typename R3::transform_type transform3;
+        typename R3::reduce_type reduce3;
+    };
+
+    template< typename R0, typename R1, typename R2, typename R3 >
+    typename reduceMultiOps< R0, R1, R2, R3 >::value_type reduce_multi_init( const R0& r0, const R1& r1,
+        const R2& r2, const R3& r3 )
+    {
+        typename reduceMultiOps< R0, R1, R2, R3 >::value_type init;
+        init.v0 = r0.init;
+        init.v1 = r1.init;
+        init.v2 = r2.init;
+        init.v3 = r3.init;
+        return init;
+    }
+
+    //  The host side of reduceMultiTransform and reduceMultiCombine; slots past Slots hold padding and are skipped
+    template< int Slots, typename Ops, typename iType >
+    typename Ops::value_type reduce_multi_transform( const Ops& ops, const iType& element )
+    {
+        typename Ops::value_type result;
+        result.v0 = ops.transform0( element );
+        result.v1 = ops.transform1( element );
+        if( Slots > 2 )
+            result.v2 = ops.transform2( element );
+        if( Slots > 3 )
+            result.v3 = ops.transform3( element );
+        return result;
+    }
+
+    template< int Slots, typename Ops >
+    typename Ops::value_type reduce_multi_combine( const Ops& ops, const typename Ops::value_type& lhs,
+        const typename Ops::value_type& rhs )
+    {
+        typename Ops::value_type result;
+        result.v0 = ops.reduce0( lhs.v0, rhs.v0 );
+        result.v1 = ops.reduce1( lhs.v1, rhs.v1 );
+        if( Slots > 2 )
+            result.v2 = ops.reduce2( lhs.v2, rhs.v2 );
+        if( Slots > 3 )
+            result.v3 = ops.reduce3( lhs.v3, rhs.v3 );
+        return result;
+    }
+
+    template< int Slots, typename iType, typename Ops >
+    typename Ops::value_type reduce_multi_serial( const iType* first, const iType* last, const Ops& ops,
+        const typename Ops::value_type& init )
+    {
+        typename Ops::value_type acc = init;
+        for( ; first != last; ++first )
+            acc = reduce_multi_combine< Slots >( ops, acc, reduce_multi_transform< Slots >( ops, *first ) );
+        return acc;
+    }
+
+#ifdef ENABLE_TBB
+    /*  The imperative form of parallel_reduce, as in Transform_Reduce, with every reduction in one body.
+     *  Split bodies are seeded with their first element, so the initial values are combined once only.
+     */
+    template< int Slots, typename iType, typename Ops >
+    struct Reduce_Multi
+    {
+        typename Ops::value_type value;
+        Ops ops;
+        bool flag;
+
+        Reduce_Multi( const Ops& _ops, const typename Ops::value_type& init ): value( init ), ops( _ops ),
+            flag( false ) {}
+        Reduce_Multi( Reduce_Multi& s, tbb::split ): ops( s.ops ), flag( true ) {}
+
+        void operator()( const tbb::blocked_range< const iType* >& r )
+        {
+            for( const iType* a = r.begin( ); a != r.end( ); ++a )
+            {
+                typename Ops::value_type element = reduce_multi_transform< Slots >( ops, *a );
+                if( flag )
+                {
+                    value = element;
+                    flag = false;
+                }
+                else
+                    value = reduce_multi_combine< Slots >( ops, value, element );
+            }
+        }
+
+        void join( Reduce_Multi& rhs )
+        {
+            value = reduce_multi_combine< Slots >( ops, value, rhs.value );
+        }
+    };
+#endif
+
+    //  Reduces the elements of a host array on the CPU, serially or with TBB
+    template< int Slots, typename iType, typename Ops >
+    typename Ops::value_type reduce_multi_cpu( control& ctl, bolt::cl::control::e_RunMode runMode,
+        const iType* first, const iType* last, const Ops& ops, const typename Ops::value_type& init )
+    {
+        if( runMode == bolt::cl::control::SerialCpu )
+            return reduce_multi_serial< Slots >( first, last, ops, init );
+
+#ifdef ENABLE_TBB
+        control::tbbPartitionDesc part = ctl.getTbbPartitioner( "reduce_multi" );
+        Reduce_Multi< Slots, iType, Ops > body( ops, init );
+        detail::tbb_parallel_reduce( ctl, tbb::blocked_range< const iType* >( first, last, part.grainSize ), body,
+            part.partitioner );
+        return body.value;
+#else
+        throw ::cl::Error( CL_INVALID_OPERATION, "The MultiCoreCpu version of reduce_multi is not enabled to be built." );
+#endif
+    }
+
+    enum reduceMultiTypes { rm_iType, rm_iIterType, rm_valueType, rm_opsType, rm_end };
+
+    class ReduceMulti_KernelTemplateSpecializer : public KernelTemplateSpecializer
+    {
+    public:
+        ReduceMulti_KernelTemplateSpecializer() : KernelTemplateSpecializer()
+        {
+            addKernelName("reduceMultiTemplate");
+            addKernelName("reduceMultiFinal");
+        }
+
+        const ::std::string operator() ( const ::std::vector<::std::string>& typeNames ) const
+        {
+            const std::string templateSpecializationString =
+                "// Host generates this instantiation string with user-specified value types and functors\n"
+                "template __attribute__((mangled_name("+name(0)+"Instantiated)))\n"
+                "__attribute__((reqd_work_group_size(64,1,1)))\n"
+                "kernel void "+name(0)+"(\n"
+                "global " + typeNames[rm_iType] + "* input_ptr,\n"
+                + typeNames[rm_iIterType] + " iIter,\n"
+                "const int length,\n"
+                "global " + typeNames[rm_opsType] + "* opsPtr,\n"
+                "global " + typeNames[rm_valueType] + "* partials,\n"
+                "local " + typeNames[rm_valueType] + "* scratch\n"
+                ");\n\n"
+
+                "// Host generates this instantiation string with user-specified value types and functors\n"
+                "template __attribute__((mangled_name("+name(1)+"Instantiated)))\n"
+                "__attribute__((reqd_work_group_size(64,1,1)))\n"
+                "kernel void "+name(1)+"(\n"
+                "global " + typeNames[rm_valueType] + "* partials,\n"
+                "const int numPartials,\n"
+                "const " + typeNames[rm_valueType] + " init,\n"
+                "global " + typeNames[rm_opsType] + "* opsPtr,\n"
+                "global " + typeNames[rm_valueType] + "* result,\n"
+                "local " + typeNames[rm_valueType] + "* scratch\n"
+                ");\n\n";
+            return templateSpecializationString;
+        }
+    };
+
+    //  Runs both kernels of reduce_multi_kernels.cl over a device_vector range and reads back the accumulator
+    template< int Slots, typename DVInputIterator, typename R0, typename R1, typename R2, typename R3 >
+    typename reduceMultiOps< R0, R1, R2, R3 >::value_type reduce_multi_enqueue( control& ctl,
+        const DVInputIterator& first, const DVInputIterator& last, const reduceMultiOps< R0, R1, R2, R3 >& ops,
+        const typename reduceMultiOps< R0, R1, R2, R3 >::value_type& init, const std::string& user_code )
+    {
+        typedef typename std::iterator_traits< DVInputIterator >::value_type iType;
+        typedef typename reduceMultiOps< R0, R1, R2, R3 >::value_type valueType;
+        index_require_32( static_cast< size_t >( std::distance( first, last ) ),
+            "The OpenCL path of reduce_multi() takes ranges of fewer than 2^31 elements" );
+
+        /**********************************************************************************
+         * Type Names - used in KernelTemplateSpecializer
+         *********************************************************************************/
+        std::vector< std::string > typeNames( rm_end );
+        typeNames[ rm_iType ] = TypeName< iType >::get( );
+        typeNames[ rm_iIterType ] = TypeName< DVInputIterator >::get( );
+        typeNames[ rm_valueType ] = "reduceMultiValue< " +
+            TypeName< typename R0::value_type >::get( ) + ", " + TypeName< typename R1::value_type >::get( ) + ", " +
+            TypeName< typename R2::value_type >::get( ) + ", " + TypeName< typename R3::value_type >::get( ) + " >";
+        typeNames[ rm_opsType ] = "reduceMultiOps< " +
+            TypeName< typename R0::transform_type >::get( ) + ", " + TypeName< typename R0::reduce_type >::get( ) + ", " +
+            TypeName< typename R1::transform_type >::get( ) + ", " + TypeName< typename R1::reduce_type >::get( ) + ", " +
+            TypeName< typename R2::transform_type >::get( ) + ", " + TypeName< typename R2::reduce_type >::get( ) + ", " +
+            TypeName< typename R3::transform_type >::get( ) + ", " + TypeName< typename R3::reduce_type >::get( ) + " >";
+
+        /**********************************************************************************
+         * Type Definitions - directly concatenated into kernel string
+         *********************************************************************************/
+        std::vector< std::string > typeDefinitions;
+        if( !user_code.empty( ) )
+            typeDefinitions.push_back( user_code );
+        PUSH_BACK_UNIQUE( typeDefinitions, ClCode< iType >::get( ) )
+        PUSH_BACK_UNIQUE( typeDefinitions, ClCode< DVInputIterator >::get( ) )
+        PUSH_BACK_UNIQUE( typeDefinitions, ClCode< typename R0::value_type >::get( ) )
+        PUSH_BACK_UNIQUE( typeDefinitions, ClCode< typename R1::value_type >::get( ) )
+        PUSH_BACK_UNIQUE( typeDefinitions, ClCode< typename R2::value_type >::get( ) )
+        PUSH_BACK_UNIQUE( typeDefinitions, ClCode< typename R3::value_type >::get( ) )
+        PUSH_BACK_UNIQUE( typeDefinitions, ClCode< typename R0::transform_type >::get( ) )
+        PUSH_BACK_UNIQUE( typeDefinitions, ClCode< typename R0::reduce_type >::get( ) )
+        PUSH_BACK_UNIQUE( typeDefinitions, ClCode< typename R1::transform_type >::get( ) )
+        PUSH_BACK_UNIQUE( typeDefinitions, ClCode< typename R1::reduce_type >::get( ) )
+        PUSH_BACK_UNIQUE( typeDefinitions, ClCode< typename R2::transform_type >::get( ) )
+        PUSH_BACK_UNIQUE( typeDefinitions, ClCode< typename R2::reduce_type >::get( ) )
+        PUSH_BACK_UNIQUE( typeDefinitions, ClCode< typename R3::transform_type >::get( ) )
+        PUSH_BACK_UNIQUE( typeDefinitions, ClCode< typename R3::reduce_type >::get( ) )
+
+        /**********************************************************************************
+         * Compile Options
+         *********************************************************************************/
+        std::ostringstream oss;
+        oss << " -DREDUCE_MULTI_SLOTS=" << Slots;
+
+        /**********************************************************************************
+         * Request Compiled Kernels
+         *********************************************************************************/
+        ReduceMulti_KernelTemplateSpecializer rm_kts;
+        std::vector< ::cl::Kernel > kernels = bolt::cl::getKernels(
+            ctl,
+            typeNames,
+            &rm_kts,
+            typeDefinitions,
+            reduce_multi_kernels,
+            oss.str( ) );
+        // kernels returned in same order as added in KernelTemplaceSpecializer constructor
+
+        /**********************************************************************************
+         * Calculate Work Size
+         *********************************************************************************/
+        const size_t wgSize = REDUCE_MULTI_WGSIZE;
+        cl_uint szElements = static_cast< cl_uint >( std::distance( first, last ) );
+        int computeUnits = ctl.getDevice( ).getInfo< CL_DEVICE_MAX_COMPUTE_UNITS >( );
+        int numWG = computeUnits * ctl.getWGPerComputeUnit( );
+        int requiredWorkGroups = static_cast< int >( ( szElements + wgSize - 1 ) / wgSize );
+        if( requiredWorkGroups < numWG )
+            numWG = requiredWorkGroups;
+
+        cl_int l_Error = CL_SUCCESS;
+        ALIGNED( 256 ) reduceMultiOps< R0, R1, R2, R3 > aligned_ops( ops );
+        ::cl::Buffer opsBuffer( ctl.getContext( ), CL_MEM_COPY_HOST_PTR|CL_MEM_READ_ONLY, sizeof( aligned_ops ),
+            &aligned_ops, &l_Error );
+        V_OPENCL( l_Error, "Error creating the functor buffer of reduce_multi()" );
+
+        control::buffPointer partials = ctl.acquireBuffer( sizeof( valueType ) * numWG, CL_MEM_READ_WRITE );
+        control::buffPointer result = ctl.acquireBuffer( sizeof( valueType ),
+            CL_MEM_ALLOC_HOST_PTR|CL_MEM_READ_WRITE );
+
+        ::cl::LocalSpaceArg loc;
+        loc.size_ = wgSize * sizeof( valueType );
+
+        V_OPENCL( kernels[0].setArg( 0, first.getBuffer( ) ), "Error setting kernel argument" );
+        V_OPENCL( kernels[0].setArg( 1, first.gpuPayloadSize( ), &first.gpuPayload( ) ), "Error setting kernel argument" );
+        V_OPENCL( kernels[0].setArg( 2, szElements ), "Error setting kernel argument" );
+        V_OPENCL( kernels[0].setArg( 3, opsBuffer ), "Error setting kernel argument" );
+        V_OPENCL( kernels[0].setArg( 4, *partials ), "Error setting kernel argument" );
+        V_OPENCL( kernels[0].setArg( 5, loc ), "Error setting kernel argument" );
+
+        l_Error = ctl.getCommandQueue( ).enqueueNDRangeKernel(
+            kernels[0],
+            ::cl::NullRange,
+            ::cl::NDRange( numWG * wgSize ),
+            ::cl::NDRange( wgSize ) );
+        V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for reduce_multi() kernel" );
+
+        cl_int numPartials = numWG;
+        V_OPENCL( kernels[1].setArg( 0, *partials ), "Error setting kernel argument" );
+        V_OPENCL( kernels[1].setArg( 1, numPartials ), "Error setting kernel argument" );
+        V_OPENCL( kernels[1].setArg( 2, init ), "Error setting kernel argument" );
+        V_OPENCL( kernels[1].setArg( 3, opsBuffer ), "Error setting kernel argument" );
+        V_OPENCL( kernels[1].setArg( 4, *result ), "Error setting kernel argument" );
+        V_OPENCL( kernels[1].setArg( 5, loc ), "Error setting kernel argument" );
+
+        l_Error = ctl.getCommandQueue( ).enqueueNDRangeKernel(
+            kernels[1],
+            ::cl::NullRange,
+            ::cl::NDRange( wgSize ),
+            ::cl::NDRange( wgSize ) );
+        V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for the final reduce_multi() kernel" );
+
+        //  Only the final accumulator is read back
+        valueType acc;
+        ::cl::Event l_readEvent;
+        l_Error = ctl.getCommandQueue( ).enqueueReadBuffer( *result, CL_FALSE, 0, sizeof( valueType ), &acc, NULL,
+            &l_readEvent );
+        V_OPENCL( l_Error, "Error reading the result of reduce_multi()" );
+        bolt::cl::wait( ctl, l_readEvent, "reduce_multi" );
+
+        return acc;
+    }
+
+    template< int Slots, typename InputIterator, typename Ops >
+    typename Ops::value_type reduce_multi_pick_iterator( control& ctl, const InputIterator& first,
+        const InputIterator& last, const Ops& ops, const typename Ops::value_type& init, const std::string& user_code,
+        std::random_access_iterator_tag )
+    {
+        typedef typename std::iterator_traits< InputIterator >::value_type iType;
+        size_t szElements = static_cast< size_t >( last - first );
+        if( szElements == 0 )
+            return init;
+
+        bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode( );
+        if( runMode == bolt::cl::control::Automatic )
+        {
+            runMode = ctl.getDefaultPathToRun( );
+        }
+        if( runMode == bolt::cl::control::SerialCpu || runMode == bolt::cl::control::MultiCoreCpu )
+        {
+            const iType* firstPtr = &*first;
+            return reduce_multi_cpu< Slots >( ctl, runMode, firstPtr, firstPtr + szElements, ops, init );
+        }
+
+        device_vector< iType > dvInput( first, last, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, ctl );
+        return reduce_multi_enqueue< Slots >( ctl, dvInput.begin( ), dvInput.end( ), ops, init, user_code );
+    }
+
+    template< int Slots, typename DVInputIterator, typename Ops >
+    typename Ops::value_type reduce_multi_pick_iterator( control& ctl, const DVInputIterator& first,
+        const DVInputIterator& last, const Ops& ops, const typename Ops::value_type& init, const std::string& user_code,
+        bolt::cl::device_vector_tag )
+    {
+        typedef typename std::iterator_traits< DVInputIterator >::value_type iType;
+        size_t szElements = static_cast< size_t >( std::distance( first, last ) );
+        if( szElements == 0 )
+            return init;
+
+        bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode( );
+        if( runMode == bolt::cl::control::Automatic )
+        {
+            runMode = ctl.getDefaultPathToRun( );
+        }
+        if( runMode == bolt::cl::control::SerialCpu || runMode == bolt::cl::control::MultiCoreCpu )
+        {
+            typename bolt::cl::device_vector< iType >::pointer inputPtr = first.getContainer( ).data( );
+            const iType* firstPtr = &inputPtr[ first.m_Index ];
+            return reduce_multi_cpu< Slots >( ctl, runMode, firstPtr, firstPtr + szElements, ops, init );
+        }
+
+        return reduce_multi_enqueue< Slots >( ctl, first, last, ops, init, user_code );
+    }
+
+    template< int Slots, typename InputIterator, typename Ops >
+    typename Ops::value_type reduce_multi_detect_random_access( control& ctl, const InputIterator& first,
+        const InputIterator& last, const Ops& ops, const typename Ops::value_type& init, const std::string& user_code,
+        std::input_iterator_tag )
+    {
+        static_assert( false, "Bolt only supports random access iterator types" );
+    }
+
+    template< int Slots, typename InputIterator, typename Ops >
+    typename Ops::value_type reduce_multi_detect_random_access( control& ctl, const InputIterator& first,
+        const InputIterator& last, const Ops& ops, const typename Ops::value_type& init, const std::string& user_code,
+        std::random_access_iterator_tag )
+    {
+        return reduce_multi_pick_iterator< Slots >( ctl, first, last, ops, init, user_code,
+            typename std::iterator_traits< InputIterator >::iterator_category( ) );
+    }
+
+    //  Unused slots are padded with the first reduction, whose functors and value type are already in the kernel
+    template< int Slots, typename InputIterator, typename R0, typename R1, typename R2, typename R3 >
+    typename reduceMultiOps< R0, R1, R2, R3 >::value_type reduce_multi_slots( control& ctl,
+        const InputIterator& first, const InputIterator& last, const R0& r0, const R1& r1, const R2& r2,
+        const R3& r3, const std::string& user_code )
+    {
+        return reduce_multi_detect_random_access< Slots >( ctl, first, last, reduceMultiOps< R0, R1, R2, R3 >( r0, r1,
+            r2, r3 ), reduce_multi_init( r0, r1, r2, r3 ), user_code,
+            typename std::iterator_traits< InputIterator >::iterator_category( ) );
+    }
+
+}// end of namespace detail
+
+    template< typename InputIterator, typename Reduction0, typename Reduction1 >
+    std::tuple< typename Reduction0::value_type, typename Reduction1::value_type >
+        reduce_multi( control& ctl, InputIterator first, InputIterator last, const Reduction0& r0,
+        const Reduction1& r1, const std::string& cl_code )
+    {
+        typename detail::reduceMultiOps< Reduction0, Reduction1, Reduction0, Reduction0 >::value_type acc =
+            detail::reduce_multi_slots< 2 >( ctl, first, last, r0, r1, r0, r0, cl_code );
+        return std::make_tuple( acc.v0, acc.v1 );
+    }
+
+    template< typename InputIterator, typename Reduction0, typename Reduction1 >
+    std::tuple< typename Reduction0::value_type, typename Reduction1::value_type >
+        reduce_multi( InputIterator first, InputIterator last, const Reduction0& r0, const Reduction1& r1,
+        const std::string& cl_code )
+    {
+        return reduce_multi( control::getDefault( ), first, last, r0, r1, cl_code );
+    }
+
+    template< typename InputIterator, typename Reduction0, typename Reduction1, typename Reduction2 >
+    std::tuple< typename Reduction0::value_type, typename Reduction1::value_type, typename Reduction2::value_type >
+        reduce_multi( control& ctl, InputIterator first, InputIterator last, const Reduction0& r0,
+        const Reduction1& r1, const Reduction2& r2, const std::string& cl_code )
+    {
+        typename detail::reduceMultiOps< Reduction0, Reduction1, Reduction2, Reduction0 >::value_type acc =
+            detail::reduce_multi_slots< 3 >( ctl, first, last, r0, r1, r2, r0, cl_code );
+        return std::make_tuple( acc.v0, acc.v1, acc.v2 );
+    }
+
+    template< typename InputIterator, typename Reduction0, typename Reduction1, typename Reduction2 >
+    std::tuple< typename Reduction0::value_type, typename Reduction1::value_type, typename Reduction2::value_type >
+        reduce_multi( InputIterator first, InputIterator last, const Reduction0& r0, const Reduction1& r1,
+        const Reduction2& r2, const std::string& cl_code )
+    {
+        return reduce_multi( control::getDefault( ), first, last, r0, r1, r2, cl_code );
+    }
+
+    template< typename InputIterator, typename Reduction0, typename Reduction1, typename Reduction2,
+        typename Reduction3 >
+    std::tuple< typename Reduction0::value_type, typename Reduction1::value_type, typename Reduction2::value_type,
+        typename Reduction3::value_type >
+        reduce_multi( control& ctl, InputIterator first, InputIterator last, const Reduction0& r0,
+        const Reduction1& r1, const Reduction2& r2, const Reduction3& r3, const std::string& cl_code )
+    {
+        typename detail::reduceMultiOps< Reduction0, Reduction1, Reduction2, Reduction3 >::value_type acc =
+            detail::reduce_multi_slots< 4 >( ctl, first, last, r0, r1, r2, r3, cl_code );
+        return std::make_tuple( acc.v0, acc.v1, acc.v2, acc.v3 );
+    }
+
+    template< typename InputIterator, typename Reduction0, typename Reduction1, typename Reduction2,
+        typename Reduction3 >
+    std::tuple< typename Reduction0::value_type, typename Reduction1::value_type, typename Reduction2::value_type,
+        typename Reduction3::value_type >
+        reduce_multi( InputIterator first, InputIterator last, const Reduction0& r0, const Reduction1& r1,
+        const Reduction2& r2, const Reduction3& r3, const std::string& cl_code )
+    {
+        return reduce_multi( control::getDefault( ), first, last, r0, r1, r2, r3, cl_code );
+    }
+
+}// end of namespace cl
+}// end of namespace bolt
+
+#endif
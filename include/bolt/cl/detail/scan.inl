@@ -47,13 +47,15 @@
 #include <algorithm>
 #include <type_traits>
 #include "bolt/cl/bolt.h"
+#include "bolt/cl/detail/index_type.inl"
+#include "bolt/cl/detail/scan_lookback.inl"
 
 
 #ifdef ENABLE_TBB
 //TBB Includes
 #include "tbb/parallel_scan.h"
 #include "tbb/blocked_range.h"
-#include "tbb/task_scheduler_init.h"
+#include "bolt/cl/detail/tbb_arena.inl"
 #endif
 
 
@@ -236,7 +238,7 @@ oType*
 Serial_scan(
     vType *values,
     oType *result,
-    unsigned int  num,
+    size_t num,
     const BinaryFunction binary_op,
     const bool Incl,
     const T &init)
@@ -250,7 +252,7 @@ Serial_scan(
        *result = (oType)init;
        sum = binary_op( *result, *values);
     }
-    for ( unsigned int i= 1; i<num; i++)
+    for ( size_t i= 1; i<num; i++)
     {
         oType currentValue = *(values + i); // convertible
         if (Incl)
@@ -324,7 +326,7 @@ public:
             "global " + typeNames[scan_iValueType] + "* input,\n"
             ""        + typeNames[scan_iIterType] + " input_iter,\n"
             ""        + typeNames[scan_initType] + " identity,\n"
-            "const uint vecSize,\n"
+            "const indexType vecSize,\n"
             "local "  + typeNames[scan_oValueType] + "* lds,\n"
             "global " + typeNames[scan_BinaryFunction] + "* binaryOp,\n"
             "global " + typeNames[scan_oValueType] + "* scanBuffer,\n"
@@ -338,7 +340,7 @@ public:
             "global " + typeNames[scan_oValueType] + "* postSumArray,\n"
             "global " + typeNames[scan_oValueType] + "* preSumArray,\n"
             ""        + typeNames[scan_initType]+" identity,\n"
-            "const uint vecSize,\n"
+            "const indexType vecSize,\n"
             "local " + typeNames[scan_oValueType] + "* lds,\n"
             "const uint workPerThread,\n"
             "global " + typeNames[scan_BinaryFunction] + "* binaryOp\n"
@@ -351,7 +353,7 @@ public:
             "global " + typeNames[scan_oValueType] + "* output_ptr,\n"
             ""        + typeNames[scan_oIterType] + " output_iter,\n"
             "global " + typeNames[scan_oValueType] + "* postSumArray,\n"
-            "const uint vecSize,\n"
+            "const indexType vecSize,\n"
             "global " + typeNames[scan_BinaryFunction] + "* binaryOp\n"
             ");\n\n";
 #endif
@@ -359,6 +361,38 @@ public:
             }
 };
 
+//  The single pass scan of scan_lookback_kernels.cl, for devices where scan_lookback_enabled holds
+class ScanLookback_KernelTemplateSpecializer : public KernelTemplateSpecializer
+{
+public:
+    ScanLookback_KernelTemplateSpecializer() : KernelTemplateSpecializer()
+    {
+        addKernelName("singlePassScan");
+    }
+
+    const ::std::string operator() ( const ::std::vector<::std::string>& typeNames ) const
+    {
+        const std::string templateSpecializationString =
+            "// Template specialization\n"
+            "template __attribute__((mangled_name(" + name(0) + "Instantiated)))\n"
+            "__attribute__((reqd_work_group_size(SCAN_LOOKBACK_WGSIZE,1,1)))\n"
+            "kernel void " + name(0) + "(\n"
+            "global " + typeNames[scan_oValueType] + "* output_ptr,\n"
+            ""        + typeNames[scan_oIterType] + " output_iter,\n"
+            "global " + typeNames[scan_iValueType] + "* input_ptr,\n"
+            ""        + typeNames[scan_iIterType] + " input_iter,\n"
+            ""        + typeNames[scan_initType] + " identity,\n"
+            "const uint vecSize,\n"
+            "local "  + typeNames[scan_oValueType] + "* lds,\n"
+            "global " + typeNames[scan_BinaryFunction] + "* binaryOp,\n"
+            "global uint* tileStatus,\n"
+            "global " + typeNames[scan_oValueType] + "* tileValues,\n"
+            "int exclusive\n"
+            ");\n\n";
+        return templateSpecializationString;
+    }
+};
+
 
 #ifdef ENABLE_TBB
       template <typename T, typename BinaryFunction, typename InputIterator, typename OutputIterator>
@@ -377,9 +411,9 @@ public:
                     const bool &_incl ,const T &init) : x(_x), y(_y), scan_op(_opr),inclusive(_incl),start(init),flag(TRUE){}
           T get_sum() const {return sum;}
           template<typename Tag>
-          void operator()( const tbb::blocked_range<int>& r, Tag ) {
+          void operator()( const tbb::blocked_range<size_t>& r, Tag ) {
              T temp = sum;
-             for(int i=r.begin(); i<r.end(); ++i ) {
+             for(size_t i=r.begin(); i<r.end(); ++i ) {
                  if(Tag::is_final_scan()){
                      if(!inclusive){
                         if(i==0 ) {
@@ -468,7 +502,7 @@ public:
             typedef typename std::iterator_traits< OutputIterator >::value_type oType;
             static_assert( std::is_convertible< iType, oType >::value, "Input and Output iterators are incompatible" );
 
-            unsigned int numElements = static_cast< unsigned int >( std::distance( first, last ) );
+            size_t numElements = static_cast< size_t >( std::distance( first, last ) );
             if( numElements < 1 )
                 return result;
 
@@ -498,10 +532,11 @@ aProfiler.stopTrial();
             else if( runMode == bolt::cl::control::MultiCoreCpu )
             {
 #ifdef ENABLE_TBB
-               tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
+               control::tbbPartitionDesc part = ctrl.getTbbPartitioner( "scan" );
                Scan_tbb<iType, BinaryFunction, InputIterator, OutputIterator> tbb_scan((InputIterator &)first,(OutputIterator &)
                                                                          result,binary_op,inclusive,init);
-               tbb::parallel_scan( tbb::blocked_range<int>(  0, static_cast< int >( std::distance( first, last ))), tbb_scan, tbb::auto_partitioner());
+               detail::tbb_parallel_scan( ctrl, tbb::blocked_range<size_t>(  0, numElements, part.grainSize ), tbb_scan,
+                   part.partitioner );
                return result + numElements;
 #else
                //std::cout << "The MultiCoreCpu version of Scan is not ebabled" << std ::endl;
@@ -550,7 +585,7 @@ aProfiler.set(AsyncProfiler::memory, numElements*sizeof(iType));
             typedef typename std::iterator_traits< DVOutputIterator >::value_type oType;
             static_assert( std::is_convertible< iType, oType >::value, "Input and Output iterators are incompatible" );
 
-            unsigned int numElements = static_cast< unsigned int >( std::distance( first, last ) );
+            size_t numElements = static_cast< size_t >( std::distance( first, last ) );
             if( numElements < 1 )
                 return result;
 
@@ -587,9 +622,10 @@ aProfiler.set(AsyncProfiler::memory, numElements*sizeof(iType));
                 oType *scanResultBuffer = (oType*)ctrl.getCommandQueue().enqueueMapBuffer(result.getBuffer(), false,
                                    CL_MAP_READ|CL_MAP_WRITE, 0, sizeof(oType) * numElements, NULL, &multiCoreCPUEvent, &l_Error );
                 multiCoreCPUEvent.wait();
-                tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
+                control::tbbPartitionDesc part = ctrl.getTbbPartitioner( "scan" );
                 Scan_tbb<iType, BinaryFunction, iType*, oType*> tbb_scan(scanInputBuffer, scanResultBuffer, binary_op, inclusive, init);
-                tbb::parallel_scan( tbb::blocked_range<int>(  0, numElements), tbb_scan, tbb::auto_partitioner());
+                detail::tbb_parallel_scan( ctrl, tbb::blocked_range<size_t>(  0, numElements, part.grainSize ), tbb_scan,
+                    part.partitioner );
                 ctrl.getCommandQueue().enqueueUnmapMemObject(first.getBuffer(), scanInputBuffer);
                 ctrl.getCommandQueue().enqueueUnmapMemObject(result.getBuffer(), scanResultBuffer);
                 return result + numElements;
@@ -619,11 +655,11 @@ aProfiler.set(AsyncProfiler::memory, numElements*sizeof(iType));
             typedef typename std::iterator_traits< OutputIterator >::value_type oType;
             static_assert( std::is_convertible< iType, oType >::value, "Input and Output iterators are incompatible" );
 
-            unsigned int numElements = static_cast< unsigned int >( std::distance( fancyFirst, fancyLast ) );
+            size_t numElements = static_cast< size_t >( std::distance( fancyFirst, fancyLast ) );
             if( numElements == 0 )
                 return result;
 
-            bolt::cl::control::e_RunMode runMode = ctrl.getForceRunMode( );
+            bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode( );
 
             if( runMode == bolt::cl::control::Automatic )
             {
@@ -638,10 +674,11 @@ aProfiler.set(AsyncProfiler::memory, numElements*sizeof(iType));
             else if( runMode == bolt::cl::control::MultiCoreCpu )
             {
 #ifdef ENABLE_TBB
-               tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
+               control::tbbPartitionDesc part = ctl.getTbbPartitioner( "scan" );
                Scan_tbb<iType, BinaryFunction, InputIterator, OutputIterator> tbb_scan((InputIterator &)fancyFirst,(OutputIterator &)
                                                                          result,binary_op,inclusive,init);
-               tbb::parallel_scan( tbb::blocked_range<int>(  0, static_cast< int >( std::distance( first, last ))), tbb_scan, tbb::auto_partitioner());
+               detail::tbb_parallel_scan( ctl, tbb::blocked_range<size_t>(  0, numElements, part.grainSize ),
+                   tbb_scan, part.partitioner );
                return result + numElements;
 #else
                //std::cout << "The MultiCoreCpu version of Scan is not implemented yet." << std ::endl;
@@ -710,6 +747,52 @@ aProfiler.set(AsyncProfiler::device, control::SerialCpu);
     PUSH_BACK_UNIQUE( typeDefinitions, ClCode< T >::get() )
     PUSH_BACK_UNIQUE( typeDefinitions, ClCode< BinaryFunction  >::get() )
 
+    /**********************************************************************************
+     * Single Pass Scan
+     *********************************************************************************/
+    size_t numElements = static_cast< size_t >( std::distance( first, last ) );
+    if( index_fits_32( numElements ) && scan_lookback_enabled( ctrl, sizeof( oType ) ) )
+    {
+        cl_uint vecSize = static_cast< cl_uint >( numElements );
+        if( vecSize == 0 )
+            return;
+        cl_uint numTiles = scan_lookback_tiles( vecSize );
+
+        ScanLookback_KernelTemplateSpecializer lookback_kts;
+        std::vector< ::cl::Kernel > lookbackKernels = bolt::cl::getKernels(
+            ctrl,
+            typeNames,
+            &lookback_kts,
+            typeDefinitions,
+            scan_lookback_kernels,
+            scan_lookback_compile_options( ) );
+
+        ALIGNED( 256 ) BinaryFunction aligned_binary( binary_op );
+        control::buffPointer userFunctor = ctrl.acquireBuffer( sizeof( aligned_binary ),
+            CL_MEM_USE_HOST_PTR|CL_MEM_READ_ONLY, &aligned_binary );
+        control::buffPointer tileStatus = scan_lookback_status( ctrl, numTiles );
+        control::buffPointer tileValues = ctrl.acquireBuffer( 2 * numTiles * sizeof( oType ) );
+        cl_uint ldsSize = static_cast< cl_uint >( scan_lookback_lds_size( sizeof( oType ) ) );
+
+        ::cl::Kernel& lookbackKernel = lookbackKernels[ 0 ];
+        V_OPENCL( lookbackKernel.setArg( 0, result.getBuffer( ) ), "Error setting a kernel argument" );
+        V_OPENCL( lookbackKernel.setArg( 1, result.gpuPayloadSize( ), &result.gpuPayload( ) ),
+                  "Error setting a kernel argument" );
+        V_OPENCL( lookbackKernel.setArg( 2, first.getBuffer( ) ), "Error setting a kernel argument" );
+        V_OPENCL( lookbackKernel.setArg( 3, first.gpuPayloadSize( ), &first.gpuPayload( ) ),
+                  "Error setting a kernel argument" );
+        V_OPENCL( lookbackKernel.setArg( 4, init_T ), "Error setting a kernel argument" );
+        V_OPENCL( lookbackKernel.setArg( 5, vecSize ), "Error setting a kernel argument" );
+        V_OPENCL( lookbackKernel.setArg( 6, ldsSize, NULL ), "Error setting a kernel argument" );
+        V_OPENCL( lookbackKernel.setArg( 7, *userFunctor ), "Error setting a kernel argument" );
+        V_OPENCL( lookbackKernel.setArg( 8, *tileStatus ), "Error setting a kernel argument" );
+        V_OPENCL( lookbackKernel.setArg( 9, *tileValues ), "Error setting a kernel argument" );
+        V_OPENCL( lookbackKernel.setArg( 10, doExclusiveScan ), "Error setting a kernel argument" );
+
+        scan_lookback_run( ctrl, lookbackKernel, numTiles, "scan" );
+        return;
+    }
+
     /**********************************************************************************
      * Compile Options
      *********************************************************************************/
@@ -725,6 +808,7 @@ aProfiler.set(AsyncProfiler::device, control::SerialCpu);
     oss << " -DKERNEL2WORKGROUPSIZE=" << kernel2_WgSize;
 
     oss << " -DUSE_AMD_HSA=" << USE_AMD_HSA;
+    oss << index_compile_options( numElements );
     compileOptions = oss.str();
 
     /**********************************************************************************
@@ -750,8 +834,6 @@ aProfiler.set(AsyncProfiler::device, control::SerialCpu);
      * Round Up Number of Elements
      *********************************************************************************/
     //  Ceiling function to bump the size of input to the next whole wavefront size
-    cl_uint numElements = static_cast< cl_uint >( std::distance( first, last ) );
-
     size_t numElementsRUP = numElements;
     size_t modWgSize = (numElementsRUP & (kernel0_WgSize-1));
                 if( modWgSize )
@@ -760,7 +842,7 @@ aProfiler.set(AsyncProfiler::device, control::SerialCpu);
         numElementsRUP += kernel0_WgSize;
     }
 
-    cl_uint numWorkGroupsK0 = static_cast< cl_uint >( numElementsRUP / kernel0_WgSize );
+    size_t numWorkGroupsK0 = numElementsRUP / kernel0_WgSize;
 
 
     // Create buffer wrappers so we can access the host functors, for read or writing in the kernel
@@ -832,7 +914,7 @@ aProfiler.set(AsyncProfiler::device, control::SerialCpu);
     V_OPENCL( kernels[ 0 ].setArg( 0, result->getBuffer( ) ),   "Error: Output Buffer" );
     V_OPENCL( kernels[ 0 ].setArg( 1, first->getBuffer( ) ),    "Error: Input Buffer" );
     V_OPENCL( kernels[ 0 ].setArg( 2, init_T ),                 "Error: Initial Value" );
-    V_OPENCL( kernels[ 0 ].setArg( 3, numElements ),            "Error: Number of Elements" );
+    V_OPENCL( kernels[ 0 ].setArg( 3, static_cast< cl_uint >( numElements ) ), "Error: Number of Elements" );
     V_OPENCL( kernels[ 0 ].setArg( 4, numIterations ),          "Error: Number of Iterations" );
     V_OPENCL( kernels[ 0 ].setArg( 5, ldsSize, NULL ),          "Error: Local Memory" );
     V_OPENCL( kernels[ 0 ].setArg( 6, *userFunctor ),           "Error: Binary Function" );
@@ -972,7 +1054,7 @@ aProfiler.set(AsyncProfiler::device, control::SerialCpu);
     V_OPENCL( kernels[ 0 ].setArg( 2, first.getBuffer( ) ),    "Error setting argument for kernels[ 0 ]" ); // Input buffer
     V_OPENCL( kernels[ 0 ].setArg( 3, first.gpuPayloadSize( ), &first.gpuPayload( ) ), "Error setting a kernel argument" );
     V_OPENCL( kernels[ 0 ].setArg( 4, init_T ),                 "Error setting argument for kernels[ 0 ]" ); // Initial value used for exclusive scan
-    V_OPENCL( kernels[ 0 ].setArg( 5, numElements ),            "Error setting argument for kernels[ 0 ]" ); // Size of scratch buffer
+    V_OPENCL( index_set_arg( kernels[ 0 ], 5, numElements, numElements ), "Error setting argument for kernels[ 0 ]" ); // Size of scratch buffer
     V_OPENCL( kernels[ 0 ].setArg( 6, ldsSize, NULL ),          "Error setting argument for kernels[ 0 ]" ); // Scratch buffer
     V_OPENCL( kernels[ 0 ].setArg( 7, *userFunctor ),           "Error setting argument for kernels[ 0 ]" ); // User provided functor class
     V_OPENCL( kernels[ 0 ].setArg( 8, *preSumArray ),           "Error setting argument for kernels[ 0 ]" ); // Output per block sum buffer
@@ -1012,7 +1094,7 @@ aProfiler.set(AsyncProfiler::memory, 2*numElements*sizeof(iType) + 1*sizeScanBuf
     V_OPENCL( kernels[ 1 ].setArg( 0, *postSumArray ),  "Error setting 0th argument for kernels[ 1 ]" );          // Output buffer
     V_OPENCL( kernels[ 1 ].setArg( 1, *preSumArray ),   "Error setting 1st argument for kernels[ 1 ]" );            // Input buffer
     V_OPENCL( kernels[ 1 ].setArg( 2, init_T ),         "Error setting     argument for kernels[ 1 ]" );   // Initial value used for exclusive scan
-    V_OPENCL( kernels[ 1 ].setArg( 3, numWorkGroupsK0 ),"Error setting 2nd argument for kernels[ 1 ]" );            // Size of scratch buffer
+    V_OPENCL( index_set_arg( kernels[ 1 ], 3, numWorkGroupsK0, numElements ), "Error setting 2nd argument for kernels[ 1 ]" ); // Size of scratch buffer
     V_OPENCL( kernels[ 1 ].setArg( 4, ldsSize, NULL ),  "Error setting 3rd argument for kernels[ 1 ]" );  // Scratch buffer
     V_OPENCL( kernels[ 1 ].setArg( 5, workPerThread ),  "Error setting 4th argument for kernels[ 1 ]" );           // User provided functor class
     V_OPENCL( kernels[ 1 ].setArg( 6, *userFunctor ),   "Error setting 5th argument for kernels[ 1 ]" );           // User provided functor class
@@ -1046,7 +1128,7 @@ aProfiler.set(AsyncProfiler::memory, 4*sizeScanBuff*sizeof(oType));
     V_OPENCL( kernels[ 2 ].setArg( 0, result.getBuffer( ) ), "Error setting 0th argument for scanKernels[ 2 ]" );          // Output buffer
     V_OPENCL( kernels[ 2 ].setArg( 1, result.gpuPayloadSize( ), &result.gpuPayload( ) ), "Error setting a kernel argument" );
     V_OPENCL( kernels[ 2 ].setArg( 2, *postSumArray ), "Error setting 1st argument for scanKernels[ 2 ]" );            // Input buffer
-    V_OPENCL( kernels[ 2 ].setArg( 3, numElements ), "Error setting 2nd argument for scanKernels[ 2 ]" );   // Size of scratch buffer
+    V_OPENCL( index_set_arg( kernels[ 2 ], 3, numElements, numElements ), "Error setting 2nd argument for scanKernels[ 2 ]" ); // Size of scratch buffer
     V_OPENCL( kernels[ 2 ].setArg( 4, *userFunctor ), "Error setting 3rd argument for scanKernels[ 2 ]" );           // User provided functor class
 
 #ifdef BOLT_PROFILER_ENABLED
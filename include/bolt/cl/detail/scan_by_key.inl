@@ -22,11 +22,14 @@
 #if !defined( SCAN_BY_KEY_INL )
 #define SCAN_BY_KEY_INL
 
+#include "bolt/cl/detail/scan_lookback.inl"
+#include "bolt/cl/detail/segmented_scan.inl"
+
 #ifdef ENABLE_TBB
 //TBB Includes
 #include "tbb/parallel_scan.h"
 #include "tbb/blocked_range.h"
-#include "tbb/task_scheduler_init.h"
+#include "bolt/cl/detail/tbb_arena.inl"
 #endif
 #ifdef BOLT_ENABLE_PROFILING
 #include "bolt/AsyncProfiler.h"
@@ -255,14 +258,14 @@ Serial_inclusive_scan_by_key(
     kType *firstKey,
     vType *values,
     oType *result,
-    unsigned int  num,
+    size_t  num,
     const BinaryPredicate binary_pred,
     const BinaryFunction binary_op)
 {
     // do zeroeth element
     *result = *values; // assign value
     // scan oneth element and beyond
-    for ( unsigned int i=1; i< num;  i++)
+    for ( size_t i=1; i< num;  i++)
     {
         // load keys
         kType currentKey  = *(firstKey+i);
@@ -575,7 +578,7 @@ Serial_exclusive_scan_by_key(
     kType *firstKey,
     vType *values,
     oType *result,
-    unsigned int  num,
+    size_t  num,
     const BinaryPredicate binary_pred,
     const BinaryFunction binary_op,
     const T &init)
@@ -584,7 +587,7 @@ Serial_exclusive_scan_by_key(
     //*result = *values; // assign value
     *result = (vType)init;
     // scan oneth element and beyond
-    for ( unsigned int i= 1; i<num; i++)
+    for ( size_t i= 1; i<num; i++)
     {
         // load keys
         kType currentKey  = *(firstKey + i);
@@ -620,18 +623,14 @@ namespace detail
 */
     enum  {scanByKey_kType, scanByKey_vType, scanByKey_oType, scanByKey_initType, scanByKey_BinaryPredicate, scanByKey_BinaryFunction};
 
-/***********************************************************************************************************************
- * Kernel Template Specializer
- **********************************************************************************************************************/
-class ScanByKey_KernelTemplateSpecializer : public KernelTemplateSpecializer
+//  The single pass scan by key of scan_lookback_kernels.cl, for devices where scan_lookback_enabled holds
+class ScanByKeyLookback_KernelTemplateSpecializer : public KernelTemplateSpecializer
 {
     public:
 
-    ScanByKey_KernelTemplateSpecializer() : KernelTemplateSpecializer()
+    ScanByKeyLookback_KernelTemplateSpecializer() : KernelTemplateSpecializer()
     {
-        addKernelName("perBlockScanByKey");
-        addKernelName("intraBlockInclusiveScanByKey");
-        addKernelName("perBlockAdditionByKey");
+        addKernelName("singlePassScanByKey");
     }
 
     const ::std::string operator() ( const ::std::vector<::std::string>& typeNames ) const
@@ -639,50 +638,19 @@ class ScanByKey_KernelTemplateSpecializer : public KernelTemplateSpecializer
         const std::string templateSpecializationString =
             "// Dynamic specialization of generic template definition, using user supplied types\n"
             "template __attribute__((mangled_name(" + name(0) + "Instantiated)))\n"
-            "__attribute__((reqd_work_group_size(KERNEL0WORKGROUPSIZE,1,1)))\n"
+            "__attribute__((reqd_work_group_size(SCAN_LOOKBACK_WGSIZE,1,1)))\n"
             "__kernel void " + name(0) + "(\n"
             "global " + typeNames[scanByKey_kType] + "* keys,\n"
             "global " + typeNames[scanByKey_vType] + "* vals,\n"
             "global " + typeNames[scanByKey_oType] + "* output,\n"
             ""        + typeNames[scanByKey_initType] + " init,\n"
             "const uint vecSize,\n"
-            "local "  + typeNames[scanByKey_kType] + "* ldsKeys,\n"
-            "local "  + typeNames[scanByKey_oType] + "* ldsVals,\n"
+            "local scanLookbackSegment< " + typeNames[scanByKey_oType] + " >* lds,\n"
             "global " + typeNames[scanByKey_BinaryPredicate] + "* binaryPred,\n"
             "global " + typeNames[scanByKey_BinaryFunction]  + "* binaryFunct,\n"
-            "global " + typeNames[scanByKey_kType] + "* keyBuffer,\n"
-            "global " + typeNames[scanByKey_oType] + "* valBuffer,\n"
+            "global uint* tileStatus,\n"
+            "global scanLookbackSegment< " + typeNames[scanByKey_oType] + " >* tileValues,\n"
             "int exclusive\n"
-            ");\n\n"
-
-
-            "// Dynamic specialization of generic template definition, using user supplied types\n"
-            "template __attribute__((mangled_name(" + name(1) + "Instantiated)))\n"
-            "__attribute__((reqd_work_group_size(KERNEL1WORKGROUPSIZE,1,1)))\n"
-            "__kernel void " + name(1) + "(\n"
-            "global " + typeNames[scanByKey_kType] + "* keySumArray,\n"
-            "global " + typeNames[scanByKey_oType] + "* preSumArray,\n"
-            "global " + typeNames[scanByKey_oType] + "* postSumArray,\n"
-            "const uint vecSize,\n"
-            "local "  + typeNames[scanByKey_kType] + "* ldsKeys,\n"
-            "local "  + typeNames[scanByKey_oType] + "* ldsVals,\n"
-            "const uint workPerThread,\n"
-            "global " + typeNames[scanByKey_BinaryPredicate] + "* binaryPred,\n"
-            "global " + typeNames[scanByKey_BinaryFunction] + "* binaryFunct\n"
-            ");\n\n"
-
-
-            "// Dynamic specialization of generic template definition, using user supplied types\n"
-            "template __attribute__((mangled_name(" + name(2) + "Instantiated)))\n"
-            "__attribute__((reqd_work_group_size(KERNEL2WORKGROUPSIZE,1,1)))\n"
-            "__kernel void " + name(2) + "(\n"
-            "global " + typeNames[scanByKey_kType] + "* keySumArray,\n"
-            "global " + typeNames[scanByKey_oType] + "* postSumArray,\n"
-            "global " + typeNames[scanByKey_kType] + "* keys,\n"
-            "global " + typeNames[scanByKey_oType] + "* output,\n"
-            "const uint vecSize,\n"
-            "global " + typeNames[scanByKey_BinaryPredicate] + "* binaryPred,\n"
-            "global " + typeNames[scanByKey_BinaryFunction] + "* binaryFunct\n"
             ");\n\n";
 
         return templateSpecializationString;
@@ -716,10 +684,10 @@ class ScanByKey_KernelTemplateSpecializer : public KernelTemplateSpecializer
                              inclusive(_incl), start(init), flag(FALSE), pre_flag(TRUE){}
           oType get_sum() const {return sum;}
           template<typename Tag>
-          void operator()( const tbb::blocked_range<int>& r, Tag ) {
+          void operator()( const tbb::blocked_range<size_t>& r, Tag ) {
               oType temp = sum;
               flag=FALSE;
-              for( int i=r.begin(); i<r.end(); ++i ) {
+              for( size_t i=r.begin(); i<r.end(); ++i ) {
                  if( Tag::is_final_scan() ) {
                      if(!inclusive){
                           if( i==0){
@@ -870,7 +838,7 @@ scan_by_key_pick_iterator(
     typedef typename std::iterator_traits< OutputIterator >::value_type oType;
     static_assert( std::is_convertible< vType, oType >::value, "InputValue and Output iterators are incompatible" );
 
-    unsigned int numElements = static_cast< unsigned int >( std::distance( firstKey, lastKey ) );
+    size_t numElements = static_cast< size_t >( std::distance( firstKey, lastKey ) );
     if( numElements < 1 )
         return result;
 
@@ -896,10 +864,11 @@ scan_by_key_pick_iterator(
   else if(runMode == bolt::cl::control::MultiCoreCpu)
   {
 #ifdef ENABLE_TBB
-        tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
+        control::tbbPartitionDesc part = ctl.getTbbPartitioner( "scan_by_key" );
         ScanKey_tbb<T, InputIterator1, InputIterator2, OutputIterator, BinaryFunction, BinaryPredicate> tbbkey_scan((InputIterator1 &)firstKey,
             (InputIterator2&) firstValue,(OutputIterator &)result, binary_funct, binary_pred, inclusive, init);
-        tbb::parallel_scan( tbb::blocked_range<int>(  0, static_cast< int >( std::distance( firstKey, lastKey ))), tbbkey_scan, tbb::auto_partitioner());
+        detail::tbb_parallel_scan( ctl, tbb::blocked_range<size_t>(  0, numElements, part.grainSize ), tbbkey_scan,
+            part.partitioner );
         return result + numElements;
 #else
         //std::cout << "The MultiCoreCpu version of Scan by key is not enabled." << std ::endl;
@@ -962,7 +931,7 @@ scan_by_key_pick_iterator(
     typedef typename std::iterator_traits< DVOutputIterator >::value_type oType;
     static_assert( std::is_convertible< vType, oType >::value, "InputValue and Output iterators are incompatible" );
 
-    unsigned int numElements = static_cast< unsigned int >( std::distance( firstKey, lastKey ) );
+    size_t numElements = static_cast< size_t >( std::distance( firstKey, lastKey ) );
     if( numElements < 1 )
         return result;
 
@@ -1012,9 +981,10 @@ scan_by_key_pick_iterator(
                                    CL_MAP_READ|CL_MAP_WRITE, 0, sizeof(oType) * numElements, NULL, &multiCoreCPUEvent, &l_Error );
                 multiCoreCPUEvent.wait();
 
-                tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
+                control::tbbPartitionDesc part = ctl.getTbbPartitioner( "scan_by_key" );
                 ScanKey_tbb<T, kType*, vType*, oType*, BinaryFunction, BinaryPredicate> tbbkey_scan(scanInputkey, scanInputBuffer, scanResultBuffer, binary_funct, binary_pred, inclusive, init);
-                tbb::parallel_scan( tbb::blocked_range<int>(  0, numElements), tbbkey_scan, tbb::auto_partitioner());
+                detail::tbb_parallel_scan( ctl, tbb::blocked_range<size_t>(  0, numElements, part.grainSize ), tbbkey_scan,
+                    part.partitioner );
 
                 ctl.getCommandQueue().enqueueUnmapMemObject(firstKey.getBuffer(), scanInputkey);
                 ctl.getCommandQueue().enqueueUnmapMemObject(firstValue.getBuffer(), scanInputBuffer);
@@ -1065,7 +1035,6 @@ aProfiler.startTrial();
 aProfiler.setStepName("Setup");
 aProfiler.set(AsyncProfiler::device, control::SerialCpu);
 
-size_t k0_stepNum, k1_stepNum, k2_stepNum;
 #endif
 
     /**********************************************************************************
@@ -1094,277 +1063,80 @@ size_t k0_stepNum, k1_stepNum, k2_stepNum;
     PUSH_BACK_UNIQUE( typeDefs, ClCode< BinaryFunction  >::get() )
 
     /**********************************************************************************
-     * Compile Options
+     * Single Pass Scan
      *********************************************************************************/
-    bool cpuDevice = ctl.getDevice().getInfo<CL_DEVICE_TYPE>() == CL_DEVICE_TYPE_CPU;
-    //std::cout << "Device is CPU: " << (cpuDevice?"TRUE":"FALSE") << std::endl;
-    const size_t kernel0_WgSize = (cpuDevice) ? 1 : WAVESIZE*KERNEL02WAVES;
-    const size_t kernel1_WgSize = (cpuDevice) ? 1 : WAVESIZE*KERNEL1WAVES;
-    const size_t kernel2_WgSize = (cpuDevice) ? 1 : WAVESIZE*KERNEL02WAVES;
-    std::string compileOptions;
-    std::ostringstream oss;
-    oss << " -DKERNEL0WORKGROUPSIZE=" << kernel0_WgSize;
-    oss << " -DKERNEL1WORKGROUPSIZE=" << kernel1_WgSize;
-    oss << " -DKERNEL2WORKGROUPSIZE=" << kernel2_WgSize;
-    compileOptions = oss.str();
-
-    /**********************************************************************************
-     * Request Compiled Kernels
-     *********************************************************************************/
-    ScanByKey_KernelTemplateSpecializer ts_kts;
-    std::vector< ::cl::Kernel > kernels = bolt::cl::getKernels(
-        ctl,
-        typeNames,
-        &ts_kts,
-        typeDefs,
-        scan_by_key_kernels,
-        compileOptions);
-    // kernels returned in same order as added in KernelTemplaceSpecializer constructor
-
-    // for profiling
-    ::cl::Event kernel0Event, kernel1Event, kernel2Event, kernelAEvent;
-    cl_uint doExclusiveScan = inclusive ? 0 : 1;
-    // Set up shape of launch grid and buffers:
-    int computeUnits     = ctl.getDevice( ).getInfo< CL_DEVICE_MAX_COMPUTE_UNITS >( );
-    int wgPerComputeUnit =  ctl.getWGPerComputeUnit( );
-    int resultCnt = computeUnits * wgPerComputeUnit;
-
-    //  Ceiling function to bump the size of input to the next whole wavefront size
-    cl_uint numElements = static_cast< cl_uint >( std::distance( firstKey, lastKey ) );
-    device_vector< kType >::size_type sizeInputBuff = numElements;
-    size_t modWgSize = (sizeInputBuff & (kernel0_WgSize-1));
-    if( modWgSize )
-    {
-        sizeInputBuff &= ~modWgSize;
-        sizeInputBuff += kernel0_WgSize;
-    }
-    cl_uint numWorkGroupsK0 = static_cast< cl_uint >( sizeInputBuff / kernel0_WgSize );
-
-    //  Ceiling function to bump the size of the sum array to the next whole wavefront size
-    device_vector< kType >::size_type sizeScanBuff = numWorkGroupsK0;
-    modWgSize = (sizeScanBuff & (kernel0_WgSize-1));
-    if( modWgSize )
-    {
-        sizeScanBuff &= ~modWgSize;
-        sizeScanBuff += kernel0_WgSize;
-    }
-
-    // Create buffer wrappers so we can access the host functors, for read or writing in the kernel
-
-    ALIGNED( 256 ) BinaryPredicate aligned_binary_pred( binary_pred );
-    control::buffPointer binaryPredicateBuffer = ctl.acquireBuffer( sizeof( aligned_binary_pred ),
-        CL_MEM_USE_HOST_PTR|CL_MEM_READ_ONLY, &aligned_binary_pred );
-     ALIGNED( 256 ) BinaryFunction aligned_binary_funct( binary_funct );
-    control::buffPointer binaryFunctionBuffer = ctl.acquireBuffer( sizeof( aligned_binary_funct ),
-        CL_MEM_USE_HOST_PTR|CL_MEM_READ_ONLY, &aligned_binary_funct );
-
-    control::buffPointer keySumArray  = ctl.acquireBuffer( sizeScanBuff*sizeof( kType ) );
-    control::buffPointer preSumArray  = ctl.acquireBuffer( sizeScanBuff*sizeof( oType ) );
-    control::buffPointer postSumArray = ctl.acquireBuffer( sizeScanBuff*sizeof( oType ) );
-    cl_uint ldsKeySize, ldsValueSize;
-
-
-    /**********************************************************************************
-     *  Kernel 0
-     *********************************************************************************/
-#ifdef BOLT_ENABLE_PROFILING
-aProfiler.nextStep();
-aProfiler.setStepName("Setup Kernel 0");
-aProfiler.set(AsyncProfiler::getDevice, control::SerialCpu);
-#endif
-    try
-    {
-    ldsKeySize   = static_cast< cl_uint >( kernel0_WgSize * sizeof( kType ) );
-    ldsValueSize = static_cast< cl_uint >( kernel0_WgSize * sizeof( oType ) );
-    V_OPENCL( kernels[0].setArg( 0, firstKey.getBuffer()), "Error setArg kernels[ 0 ]" ); // Input keys
-    V_OPENCL( kernels[0].setArg( 1, firstValue.getBuffer()),"Error setArg kernels[ 0 ]" ); // Input buffer
-    V_OPENCL( kernels[0].setArg( 2, result.getBuffer( ) ), "Error setArg kernels[ 0 ]" ); // Output buffer
-    V_OPENCL( kernels[0].setArg( 3, init ),                 "Error setArg kernels[ 0 ]" ); // Initial value exclusive
-    V_OPENCL( kernels[0].setArg( 4, numElements ),          "Error setArg kernels[ 0 ]" ); // Size of scratch buffer
-    V_OPENCL( kernels[0].setArg( 5, ldsKeySize, NULL ),     "Error setArg kernels[ 0 ]" ); // Scratch buffer
-    V_OPENCL( kernels[0].setArg( 6, ldsValueSize, NULL ),   "Error setArg kernels[ 0 ]" ); // Scratch buffer
-    V_OPENCL( kernels[0].setArg( 7, *binaryPredicateBuffer),"Error setArg kernels[ 0 ]" ); // User provided functor
-    V_OPENCL( kernels[0].setArg( 8, *binaryFunctionBuffer ),"Error setArg kernels[ 0 ]" ); // User provided functor
-    V_OPENCL( kernels[0].setArg( 9, *keySumArray ),         "Error setArg kernels[ 0 ]" ); // Output per block sum
-    V_OPENCL( kernels[0].setArg(10, *preSumArray ),         "Error setArg kernels[ 0 ]" ); // Output per block sum
-    V_OPENCL( kernels[0].setArg(11, doExclusiveScan ),      "Error setArg kernels[ 0 ]" ); // Exclusive scan?
-
-#ifdef BOLT_ENABLE_PROFILING
-aProfiler.nextStep();
-k0_stepNum = aProfiler.getStepNum();
-aProfiler.setStepName("Kernel 0");
-aProfiler.set(AsyncProfiler::getDevice, ctl.forceRunMode());
-aProfiler.set(AsyncProfiler::flops, 2*numElements);
-aProfiler.set(AsyncProfiler::memory, 2*numElements*(sizeof(vType)+sizeof(kType)) + 1*sizeScanBuff*(sizeof(vType)+sizeof(kType)) );
-#endif
-
-    l_Error = ctl.getCommandQueue( ).enqueueNDRangeKernel(
-        kernels[0],
-        ::cl::NullRange,
-        ::cl::NDRange( sizeInputBuff ),
-        ::cl::NDRange( kernel0_WgSize ),
-        NULL,
-        &kernel0Event);
-    V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for kernel[0]" );
-    }
-    catch( const ::cl::Error& e)
-    {
-        std::cerr << "::cl::enqueueNDRangeKernel( 0 ) in bolt::cl::scan_by_key_enqueue()" << std::endl;
-        std::cerr << "Error Code:   " << clErrorStringA(e.err()) << " (" << e.err() << ")" << std::endl;
-        std::cerr << "File:         " << __FILE__ << ", line " << __LINE__ << std::endl;
-        std::cerr << "Error String: " << e.what() << std::endl;
-    }
-
-    /**********************************************************************************
-     *  Kernel 1
-     *********************************************************************************/
-#ifdef BOLT_ENABLE_PROFILING
-aProfiler.nextStep();
-aProfiler.setStepName("Setup Kernel 1");
-aProfiler.set(AsyncProfiler::device, control::SerialCpu);
-#endif
-
-    cl_uint workPerThread = static_cast< cl_uint >( sizeScanBuff / kernel1_WgSize );
-    V_OPENCL( kernels[1].setArg( 0, *keySumArray ),         "Error setArg kernels[ 1 ]" ); // Input keys
-    V_OPENCL( kernels[1].setArg( 1, *preSumArray ),         "Error setArg kernels[ 1 ]" ); // Input buffer
-    V_OPENCL( kernels[1].setArg( 2, *postSumArray ),        "Error setArg kernels[ 1 ]" ); // Output buffer
-    V_OPENCL( kernels[1].setArg( 3, numWorkGroupsK0 ),      "Error setArg kernels[ 1 ]" ); // Size of scratch buffer
-    V_OPENCL( kernels[1].setArg( 4, ldsKeySize, NULL ),     "Error setArg kernels[ 1 ]" ); // Scratch buffer
-    V_OPENCL( kernels[1].setArg( 5, ldsValueSize, NULL ),   "Error setArg kernels[ 1 ]" ); // Scratch buffer
-    V_OPENCL( kernels[1].setArg( 6, workPerThread ),        "Error setArg kernels[ 1 ]" ); // User provided functor
-    V_OPENCL( kernels[1].setArg( 7, *binaryPredicateBuffer ),"Error setArg kernels[ 1 ]" ); // User provided functor
-    V_OPENCL( kernels[1].setArg( 8, *binaryFunctionBuffer ),"Error setArg kernels[ 1 ]" ); // User provided functor
-
-#ifdef BOLT_ENABLE_PROFILING
-aProfiler.nextStep();
-k1_stepNum = aProfiler.getStepNum();
-aProfiler.setStepName("Kernel 1");
-aProfiler.set(AsyncProfiler::device, ctl.forceRunMode());
-aProfiler.set(AsyncProfiler::flops, 2*sizeScanBuff);
-aProfiler.set(AsyncProfiler::memory, 4*sizeScanBuff*(sizeof(kType)+sizeof(vType)));
-#endif
+    //  The single pass scan indexes with 32 bits; larger ranges take the segmented scan
+    size_t numElements = static_cast< size_t >( std::distance( firstKey, lastKey ) );
+    if( numElements == 0 )
+        return;
 
-    try
-    {
-    l_Error = ctl.getCommandQueue( ).enqueueNDRangeKernel(
-        kernels[1],
-        ::cl::NullRange,
-        ::cl::NDRange( kernel1_WgSize ), // only 1 work-group
-        ::cl::NDRange( kernel1_WgSize ),
-        NULL,
-        &kernel1Event);
-    V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for kernel[1]" );
-    }
-    catch( const ::cl::Error& e)
+    typedef scanLookbackSegment< oType > segType;
+    if( index_fits_32( numElements ) && scan_lookback_enabled( ctl, sizeof( segType ) ) )
     {
-        std::cerr << "::cl::enqueueNDRangeKernel( 1 ) in bolt::cl::scan_by_key_enqueue()" << std::endl;
-        std::cerr << "Error Code:   " << clErrorStringA(e.err()) << " (" << e.err() << ")" << std::endl;
-        std::cerr << "File:         " << __FILE__ << ", line " << __LINE__ << std::endl;
-        std::cerr << "Error String: " << e.what() << std::endl;
+        cl_uint vecSize = static_cast< cl_uint >( numElements );
+        cl_uint numTiles = scan_lookback_tiles( vecSize );
+
+        ScanByKeyLookback_KernelTemplateSpecializer lookback_kts;
+        std::vector< ::cl::Kernel > lookbackKernels = bolt::cl::getKernels(
+            ctl,
+            typeNames,
+            &lookback_kts,
+            typeDefs,
+            scan_lookback_kernels,
+            scan_lookback_compile_options( ) );
+
+        ALIGNED( 256 ) BinaryPredicate aligned_binary_pred( binary_pred );
+        control::buffPointer binaryPredicateBuffer = ctl.acquireBuffer( sizeof( aligned_binary_pred ),
+            CL_MEM_USE_HOST_PTR|CL_MEM_READ_ONLY, &aligned_binary_pred );
+        ALIGNED( 256 ) BinaryFunction aligned_binary_funct( binary_funct );
+        control::buffPointer binaryFunctionBuffer = ctl.acquireBuffer( sizeof( aligned_binary_funct ),
+            CL_MEM_USE_HOST_PTR|CL_MEM_READ_ONLY, &aligned_binary_funct );
+        control::buffPointer tileStatus = scan_lookback_status( ctl, numTiles );
+        control::buffPointer tileValues = ctl.acquireBuffer( 2 * numTiles * sizeof( segType ) );
+        cl_uint ldsSize = static_cast< cl_uint >( scan_lookback_lds_size( sizeof( segType ) ) );
+        cl_uint doExclusiveScan = inclusive ? 0 : 1;
+
+        ::cl::Kernel& lookbackKernel = lookbackKernels[ 0 ];
+        V_OPENCL( lookbackKernel.setArg( 0, firstKey.getBuffer( ) ),   "Error setArg lookbackKernel" ); // Input keys
+        V_OPENCL( lookbackKernel.setArg( 1, firstValue.getBuffer( ) ), "Error setArg lookbackKernel" ); // Input values
+        V_OPENCL( lookbackKernel.setArg( 2, result.getBuffer( ) ),     "Error setArg lookbackKernel" ); // Output
+        V_OPENCL( lookbackKernel.setArg( 3, init ),                    "Error setArg lookbackKernel" );
+        V_OPENCL( lookbackKernel.setArg( 4, vecSize ),                 "Error setArg lookbackKernel" );
+        V_OPENCL( lookbackKernel.setArg( 5, ldsSize, NULL ),           "Error setArg lookbackKernel" );
+        V_OPENCL( lookbackKernel.setArg( 6, *binaryPredicateBuffer ),  "Error setArg lookbackKernel" );
+        V_OPENCL( lookbackKernel.setArg( 7, *binaryFunctionBuffer ),   "Error setArg lookbackKernel" );
+        V_OPENCL( lookbackKernel.setArg( 8, *tileStatus ),             "Error setArg lookbackKernel" );
+        V_OPENCL( lookbackKernel.setArg( 9, *tileValues ),             "Error setArg lookbackKernel" );
+        V_OPENCL( lookbackKernel.setArg( 10, doExclusiveScan ),        "Error setArg lookbackKernel" );
+
+        scan_lookback_run( ctl, lookbackKernel, numTiles, "scan_by_key" );
+        return;
     }
 
     /**********************************************************************************
-     *  Kernel 2
+     * Segmented Scan
      *********************************************************************************/
-#ifdef BOLT_ENABLE_PROFILING
-aProfiler.nextStep();
-aProfiler.setStepName("Setup Kernel 2");
-aProfiler.set(AsyncProfiler::device, control::SerialCpu);
-#endif
-
-    V_OPENCL( kernels[2].setArg( 0, *keySumArray ),         "Error setArg kernels[ 2 ]" ); // Input buffer
-    V_OPENCL( kernels[2].setArg( 1, *postSumArray ),        "Error setArg kernels[ 2 ]" ); // Input buffer
-    V_OPENCL( kernels[2].setArg( 2, firstKey.getBuffer()), "Error setArg kernels[ 2 ]" ); // Output buffer
-    V_OPENCL( kernels[2].setArg( 3, result.getBuffer()),   "Error setArg kernels[ 2 ]" ); // Output buffer
-    V_OPENCL( kernels[2].setArg( 4, numElements ),          "Error setArg kernels[ 2 ]" ); // Size of scratch buffer
-    V_OPENCL( kernels[2].setArg( 5, *binaryPredicateBuffer ),"Error setArg kernels[ 2 ]" ); // User provided functor
-    V_OPENCL( kernels[2].setArg( 6, *binaryFunctionBuffer ),"Error setArg kernels[ 2 ]" ); // User provided functor
-
-#ifdef BOLT_ENABLE_PROFILING
-aProfiler.nextStep();
-k2_stepNum = aProfiler.getStepNum();
-aProfiler.setStepName("Kernel 2");
-aProfiler.set(AsyncProfiler::device, ctl.forceRunMode());
-aProfiler.set(AsyncProfiler::flops, numElements);
-aProfiler.set(
-    AsyncProfiler::memory,
-    2*numElements*sizeof(vType)+numElements*sizeof(kType)+1*sizeScanBuff*(sizeof(kType)+sizeof(vType)));
-#endif
-
-    try
-    {
-    l_Error = ctl.getCommandQueue( ).enqueueNDRangeKernel(
-        kernels[2],
-        ::cl::NullRange,
-        ::cl::NDRange( sizeInputBuff ),
-        ::cl::NDRange( kernel2_WgSize ),
-        NULL,
-        &kernel2Event );
-    V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for kernel[2]" );
-    }
-    catch( const ::cl::Error& e)
-    {
-        std::cerr << "::cl::enqueueNDRangeKernel( 2 ) in bolt::cl::scan_by_key_enqueue()" << std::endl;
-        std::cerr << "Error Code:   " << clErrorStringA(e.err()) << " (" << e.err() << ")" << std::endl;
-        std::cerr << "File:         " << __FILE__ << ", line " << __LINE__ << std::endl;
-        std::cerr << "Error String: " << e.what() << std::endl;
-    }
+    //  The keys are compared once, into a bitmap of segment heads, and the values are scanned under it
+    size_t keyOffset = static_cast< size_t >( firstKey.m_Index );
+    size_t valueOffset = static_cast< size_t >( firstValue.m_Index );
+    size_t outputOffset = static_cast< size_t >( result.m_Index );
+    size_t indexSpan = std::max( std::max( keyOffset, valueOffset ), outputOffset ) + numElements;
+    size_t flagWords = segmented_flag_words( numElements );
+    control::buffPointer flags = ctl.acquireBuffer( flagWords * sizeof( cl_uint ) );
+    control::buffPointer counts = ctl.acquireBuffer( flagWords * index_size( indexSpan ) );
+
+    segmented_head_flags_enqueue< kType >( ctl, firstKey.getBuffer( ), keyOffset, numElements, binary_pred,
+        user_code, *flags, *counts, indexSpan );
+    segmented_scan_enqueue< vType, oType >( ctl, firstValue.getBuffer( ), valueOffset, numElements, *flags,
+        result.getBuffer( ), outputOffset, init, binary_funct, user_code, inclusive, indexSpan );
 
     // wait for results
-    l_Error = kernel2Event.wait( );
+    l_Error = ctl.getCommandQueue( ).finish( );
     V_OPENCL( l_Error, "post-kernel[2] failed wait" );
 
 #ifdef BOLT_ENABLE_PROFILING
-aProfiler.nextStep();
-aProfiler.setStepName("Querying Kernel Times");
-aProfiler.set(AsyncProfiler::device, control::SerialCpu);
-
 aProfiler.setDataSize(numElements*sizeof(oType));
-std::string strDeviceName = ctl.getDevice().getInfo< CL_DEVICE_NAME >( &l_Error );
-bolt::cl::V_OPENCL( l_Error, "Device::getInfo< CL_DEVICE_NAME > failed" );
-aProfiler.setArchitecture(strDeviceName);
-
-    try
-    {
-        cl_ulong k0_start, k0_stop, k1_stop, k2_stop;
-
-        l_Error = kernel0Event.getProfilingInfo<cl_ulong>(CL_PROFILING_COMMAND_START, &k0_start);
-        V_OPENCL( l_Error, "failed on getProfilingInfo<CL_PROFILING_COMMAND_QUEUED>()");
-        l_Error = kernel0Event.getProfilingInfo<cl_ulong>(CL_PROFILING_COMMAND_END, &k0_stop);
-        V_OPENCL( l_Error, "failed on getProfilingInfo<CL_PROFILING_COMMAND_END>()");
-
-        //l_Error = kernel1Event.getProfilingInfo<cl_ulong>(CL_PROFILING_COMMAND_START, &k1_start);
-        //V_OPENCL( l_Error, "failed on getProfilingInfo<CL_PROFILING_COMMAND_START>()");
-        l_Error = kernel1Event.getProfilingInfo<cl_ulong>(CL_PROFILING_COMMAND_END, &k1_stop);
-        V_OPENCL( l_Error, "failed on getProfilingInfo<CL_PROFILING_COMMAND_END>()");
-
-        //l_Error = kernel2Event.getProfilingInfo<cl_ulong>(CL_PROFILING_COMMAND_START, &k2_start);
-        //V_OPENCL( l_Error, "failed on getProfilingInfo<CL_PROFILING_COMMAND_START>()");
-        l_Error = kernel2Event.getProfilingInfo<cl_ulong>(CL_PROFILING_COMMAND_END, &k2_stop);
-        V_OPENCL( l_Error, "failed on getProfilingInfo<CL_PROFILING_COMMAND_END>()");
-
-        size_t k0_start_cpu = aProfiler.get(k0_stepNum, AsyncProfiler::startTime);
-        size_t shift = k0_start - k0_start_cpu;
-        //size_t shift = k0_start_cpu - k0_start;
-
-        //std::cout << "setting step " << k0_stepNum << " attribute " << AsyncProfiler::stopTime << " to " << k0_stop-shift << std::endl;
-        aProfiler.set(k0_stepNum, AsyncProfiler::stopTime,  static_cast<size_t>(k0_stop-shift) );
-
-        aProfiler.set(k1_stepNum, AsyncProfiler::startTime, static_cast<size_t>(k0_stop-shift) );
-        aProfiler.set(k1_stepNum, AsyncProfiler::stopTime,  static_cast<size_t>(k1_stop-shift) );
-
-        aProfiler.set(k2_stepNum, AsyncProfiler::startTime, static_cast<size_t>(k1_stop-shift) );
-        aProfiler.set(k2_stepNum, AsyncProfiler::stopTime,  static_cast<size_t>(k2_stop-shift) );
-
-    }
-    catch( ::cl::Error& e )
-    {
-        std::cout << ( "Scan Benchmark error condition reported:" ) << std::endl << e.what() << std::endl;
-        return;
-    }
-
 aProfiler.stopTrial();
-
 #endif
 
 }   //end of scan_by_key_enqueue( )
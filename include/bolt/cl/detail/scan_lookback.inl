@@ -0,0 +1,137 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+/*  Host side of the single pass scans in scan_lookback_kernels.cl, shared by scan, transform_scan and scan_by_key.
+ *  One launch reads the input once and writes the output once, against the three kernels of the default path that
+ *  read the input once and the output twice.  A work group waits on the groups that took the tiles before it, which
+ *  is only safe where those groups keep running while it spins and where global atomics and fences order the
+ *  published values between work groups, so the single pass is used on GPU devices only.
+ */
+
+#if !defined( BOLT_CL_SCAN_LOOKBACK_INL )
+#define BOLT_CL_SCAN_LOOKBACK_INL
+#pragma once
+
+#include <string>
+#include <sstream>
+#include "bolt/cl/bolt.h"
+
+/* \brief - Set to 0 to always scan with the three kernel path */
+#if !defined( BOLT_SCAN_LOOKBACK )
+#define BOLT_SCAN_LOOKBACK 1
+#endif
+
+/* \brief - Work items in a work group of the single pass scans */
+#define SCAN_LOOKBACK_WGSIZE 256
+/* \brief - Elements every work item scans */
+#define SCAN_LOOKBACK_ITEMS 4
+
+namespace bolt {
+namespace cl {
+namespace detail {
+
+//  Mirrors scanLookbackSegment in scan_lookback_kernels.cl, to size its buffers
+template< typename T >
+struct scanLookbackSegment
+{
+    cl_uint head;
+    T value;
+};
+
+inline size_t scan_lookback_tile( )
+{
+    return SCAN_LOOKBACK_WGSIZE * SCAN_LOOKBACK_ITEMS;
+}
+
+/*! \brief Whether the device can run the single pass scan of elements of valueSize bytes
+ *  \details The tile, the work item totals and the tile prefix must fit in local memory.
+ */
+inline bool scan_lookback_enabled( const control &ctl, size_t valueSize )
+{
+#if BOLT_SCAN_LOOKBACK
+    const ::cl::Device& device = ctl.getDevice( );
+    if( device.getInfo< CL_DEVICE_TYPE >( ) != CL_DEVICE_TYPE_GPU )
+        return false;
+
+    //  Global 32 bit atomics are core from OpenCL 1.1 on
+    std::string version = device.getInfo< CL_DEVICE_VERSION >( );
+    std::string extensions = device.getInfo< CL_DEVICE_EXTENSIONS >( );
+    if( version.compare( 0, 10, "OpenCL 1.0" ) == 0 &&
+        extensions.find( "cl_khr_global_int32_base_atomics" ) == std::string::npos )
+        return false;
+
+    if( device.getInfo< CL_DEVICE_MAX_WORK_GROUP_SIZE >( ) < SCAN_LOOKBACK_WGSIZE )
+        return false;
+
+    size_t ldsSize = ( scan_lookback_tile( ) + SCAN_LOOKBACK_WGSIZE + 1 ) * valueSize + sizeof( cl_uint );
+    return ldsSize <= device.getInfo< CL_DEVICE_LOCAL_MEM_SIZE >( );
+#else
+    return false;
+#endif
+}
+
+inline std::string scan_lookback_compile_options( )
+{
+    std::ostringstream oss;
+    oss << " -DSCAN_LOOKBACK_WGSIZE=" << SCAN_LOOKBACK_WGSIZE;
+    oss << " -DSCAN_LOOKBACK_ITEMS=" << SCAN_LOOKBACK_ITEMS;
+    return oss.str( );
+}
+
+//  Tiles, and so work groups, of a single pass scan of szElements elements
+inline cl_uint scan_lookback_tiles( size_t szElements )
+{
+    return static_cast< cl_uint >( ( szElements + scan_lookback_tile( ) - 1 ) / scan_lookback_tile( ) );
+}
+
+//  The tile counter and the status of every tile, cleared; the queue is in order, so the scan sees them cleared
+inline control::buffPointer scan_lookback_status( control &ctl, cl_uint numTiles )
+{
+    size_t statusSize = ( numTiles + 1 ) * sizeof( cl_uint );
+    control::buffPointer tileStatus = ctl.acquireBuffer( statusSize );
+    V_OPENCL( ctl.getCommandQueue( ).enqueueFillBuffer( *tileStatus, static_cast< cl_uint >( 0 ), 0, statusSize ),
+              "Error clearing the single pass scan tile status" );
+    return tileStatus;
+}
+
+//  Local memory of a single pass scan: the tile, the work item totals and the tile prefix
+inline size_t scan_lookback_lds_size( size_t valueSize )
+{
+    return ( scan_lookback_tile( ) + SCAN_LOOKBACK_WGSIZE + 1 ) * valueSize;
+}
+
+//  Launches kernel over numTiles work groups and waits for it
+inline void scan_lookback_run( control &ctl, ::cl::Kernel& kernel, cl_uint numTiles, const std::string& waitName )
+{
+    ::cl::Event scanEvent;
+    cl_int l_Error = ctl.getCommandQueue( ).enqueueNDRangeKernel(
+        kernel,
+        ::cl::NullRange,
+        ::cl::NDRange( numTiles * SCAN_LOOKBACK_WGSIZE ),
+        ::cl::NDRange( SCAN_LOOKBACK_WGSIZE ),
+        NULL,
+        &scanEvent );
+    V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for the single pass scan kernel" );
+
+    bolt::cl::wait( ctl, scanEvent, waitName );
+}
+
+}
+}
+}
+
+#endif
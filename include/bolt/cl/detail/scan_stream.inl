@@ -0,0 +1,586 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#pragma once
+#if !defined( BOLT_CL_SCAN_STREAM_INL )
+#define BOLT_CL_SCAN_STREAM_INL
+
+#include <vector>
+#include <type_traits>
+
+#include "bolt/cl/bolt.h"
+#include "bolt/cl/functional.h"
+#include "bolt/cl/device_vector.h"
+#include "bolt/cl/detail/segmented_scan.inl"
+
+#ifdef ENABLE_TBB
+#include "tbb/parallel_scan.h"
+#include "tbb/blocked_range.h"
+#include "bolt/cl/detail/tbb_arena.inl"
+#endif
+
+namespace bolt {
+namespace cl {
+namespace detail {
+
+#ifdef ENABLE_TBB
+    /*! \brief tbb::parallel_scan body of a stream chunk on the MultiCoreCpu path, which continues the carry of the
+     *  chunk before
+     *  \details An element heads a segment when its key does not continue the key before it, the last key of the
+     *  chunk before for element 0; without keys, only element 0 of the first chunk is a head.  The carry is the value
+     *  left of element 0, so it seeds the body whose range starts there.  sum holds the scan of the elements the
+     *  body has seen, empty until it has seen one, and head whether one of them heads a segment, in which case the
+     *  sums left of them do not reach sum.  An exclusive scan starts every segment from init.
+     */
+    template< typename kType, typename T, typename BinaryPredicate, typename BinaryFunction >
+    struct ScanStream_tbb
+    {
+        const kType* keys;
+        const T* values;
+        T* output;
+        const kType& prevKey;
+        bool hasCarry;
+        T carry;
+        T init;
+        bool inclusive;
+        BinaryPredicate binary_pred;
+        BinaryFunction binary_op;
+        T sum;
+        bool empty;
+        bool head;
+
+        ScanStream_tbb( const kType* _keys, const T* _values, T* _output, const kType& _prevKey, bool _hasCarry,
+                        const T& _carry, const T& _init, bool _inclusive, const BinaryPredicate& _binary_pred,
+                        const BinaryFunction& _binary_op ):
+            keys( _keys ), values( _values ), output( _output ), prevKey( _prevKey ), hasCarry( _hasCarry ),
+            carry( _carry ), init( _init ), inclusive( _inclusive ), binary_pred( _binary_pred ),
+            binary_op( _binary_op ), sum( _init ), empty( true ), head( false )
+        {}
+
+        ScanStream_tbb( ScanStream_tbb& b, tbb::split ):
+            keys( b.keys ), values( b.values ), output( b.output ), prevKey( b.prevKey ), hasCarry( b.hasCarry ),
+            carry( b.carry ), init( b.init ), inclusive( b.inclusive ), binary_pred( b.binary_pred ),
+            binary_op( b.binary_op ), sum( b.init ), empty( true ), head( false )
+        {}
+
+        bool isHead( size_t i ) const
+        {
+            if( !keys )
+                return i == 0 && !hasCarry;
+            if( i == 0 )
+                return !( hasCarry && binary_pred( keys[ 0 ], prevKey ) );
+            return !binary_pred( keys[ i ], keys[ i - 1 ] );
+        }
+
+        template< typename Tag >
+        void operator( )( const tbb::blocked_range< size_t >& r, Tag )
+        {
+            T temp = sum;
+            bool tempEmpty = empty;
+            bool tempHead = head;
+            if( tempEmpty && hasCarry && r.begin( ) == 0 )
+            {
+                temp = carry;
+                tempEmpty = false;
+            }
+
+            for( size_t i = r.begin( ); i < r.end( ); ++i )
+            {
+                bool h = isHead( i );
+                T value = values[ i ];
+                T total = h ? ( inclusive ? value : binary_op( init, value ) )
+                            : ( tempEmpty ? value : binary_op( temp, value ) );
+                if( Tag::is_final_scan( ) )
+                    output[ i ] = inclusive ? total : ( h ? init : temp );
+                temp = total;
+                tempEmpty = false;
+                tempHead = tempHead || h;
+            }
+            sum = temp;
+            empty = tempEmpty;
+            head = tempHead;
+        }
+
+        //  a holds the elements left of this body's
+        void reverse_join( ScanStream_tbb& a )
+        {
+            if( !a.empty )
+            {
+                if( empty )
+                    sum = a.sum;
+                else if( !head )
+                    sum = binary_op( a.sum, sum );
+            }
+            empty = empty && a.empty;
+            head = head || a.head;
+        }
+
+        void assign( ScanStream_tbb& b )
+        {
+            sum = b.sum;
+            empty = b.empty;
+            head = b.head;
+        }
+    };
+#endif
+
+    /*! \brief The state a stream keeps between chunks: the carry, the last key, and on the OpenCL path the kernels and
+     *  the temporary buffers
+     *  \details The run mode is fixed when the stream is made, so the carry lives either on the host or on the device.
+     *  On the device, a chunk takes the carry in at its first element, and a last kernel writes the carry the next
+     *  chunk takes; the queue is in order, so the host never reads it between chunks.  The buffers grow to the
+     *  largest chunk seen and are kept, and the kernels index with 32 bits until a chunk needs 64.
+     */
+    template< typename kType, typename T, typename BinaryPredicate, typename BinaryFunction >
+    class scanStreamState
+    {
+    public:
+        scanStreamState( control& ctl, bool keyed, bool inclusive, const T& init, const BinaryPredicate& binary_pred,
+                         const BinaryFunction& binary_op, const std::string& cl_code ):
+            m_ctl( ctl ), m_keyed( keyed ), m_inclusive( inclusive ), m_init( init ), m_binary_pred( binary_pred ),
+            m_binary_op( binary_op ), m_cl_code( cl_code ), m_hasCarry( false ), m_hostCarry( init ),
+            m_capacity( 0 ), m_indexSpan( 0 )
+        {
+            m_runMode = m_ctl.getForceRunMode( );
+            if( m_runMode == bolt::cl::control::Automatic )
+            {
+                m_runMode = m_ctl.getDefaultPathToRun( );
+            }
+        }
+
+        bool onHost( ) const
+        {
+            return m_runMode == bolt::cl::control::SerialCpu || m_runMode == bolt::cl::control::MultiCoreCpu;
+        }
+
+        control& getControl( )
+        {
+            return m_ctl;
+        }
+
+        void reset( )
+        {
+            m_hasCarry = false;
+            m_hostCarry = m_init;
+        }
+
+        T carry( )
+        {
+            if( !m_hasCarry )
+                return m_init;
+            if( onHost( ) )
+                return m_hostCarry;
+
+            T value;
+            V_OPENCL( m_ctl.getCommandQueue( ).enqueueReadBuffer( *m_carry, CL_TRUE, 0, sizeof( T ), &value ),
+                      "Error reading the scan_stream carry" );
+            return value;
+        }
+
+        //  Scans a chunk of numElements values on the host, with TBB on the MultiCoreCpu path; keys is NULL for a
+        //  stream without keys
+        void host( const kType* keys, const T* values, size_t numElements, T* output )
+        {
+            if( m_runMode == bolt::cl::control::SerialCpu )
+            {
+                serial( keys, values, numElements, output );
+                return;
+            }
+
+#ifdef ENABLE_TBB
+            control::tbbPartitionDesc part = m_ctl.getTbbPartitioner( m_keyed ? "scan_by_key" : "scan" );
+            ScanStream_tbb< kType, T, BinaryPredicate, BinaryFunction > body( keys, values, output, m_hostKey,
+                m_hasCarry, m_hostCarry, m_init, m_inclusive, m_binary_pred, m_binary_op );
+            detail::tbb_parallel_scan( m_ctl, tbb::blocked_range< size_t >( 0, numElements, part.grainSize ), body,
+                part.partitioner );
+
+            m_hostCarry = body.sum;
+            if( keys )
+                m_hostKey = keys[ numElements - 1 ];
+            m_hasCarry = true;
+#else
+            throw ::cl::Error( CL_INVALID_OPERATION, "The MultiCoreCpu version of scan_stream is not enabled to be built." );
+#endif
+        }
+
+        //  Enqueues the scan of a chunk of numElements values on the device; keys is NULL for a stream without keys
+        void enqueue( const ::cl::Buffer* keys, size_t keyOffset, const ::cl::Buffer& values, size_t valueOffset,
+                      size_t numElements, const ::cl::Buffer& output, size_t outputOffset )
+        {
+            reserve( numElements, std::max( std::max( keyOffset, valueOffset ), outputOffset ) + numElements );
+            ::cl::CommandQueue& queue = m_ctl.getCommandQueue( );
+            size_t flagWords = segmented_flag_words( numElements );
+
+            if( keys )
+            {
+                segmented_head_flags_run( m_ctl, m_flagsKernel, *keys, keyOffset, numElements, *m_binaryPredicate,
+                    *m_flags, *m_counts, m_hasCarry ? &*m_lastKey : NULL, m_indexSpan );
+                V_OPENCL( queue.enqueueCopyBuffer( *keys, *m_lastKey, ( keyOffset + numElements - 1 ) * sizeof( kType ),
+                                                   0, sizeof( kType ) ),
+                          "Error saving the last key of the scan_stream chunk" );
+            }
+            else
+            {
+                //  One segment, continuing the chunk before if there is one
+                V_OPENCL( queue.enqueueFillBuffer( *m_flags, static_cast< cl_uint >( 0 ), 0,
+                                                   flagWords * sizeof( cl_uint ) ),
+                          "Error clearing the scan_stream head flags" );
+                if( !m_hasCarry )
+                    V_OPENCL( queue.enqueueFillBuffer( *m_flags, static_cast< cl_uint >( 1 ), 0, sizeof( cl_uint ) ),
+                              "Error setting the scan_stream head flags" );
+            }
+
+            //  An exclusive scan hands on its last value too, which the scan may overwrite in place
+            if( !m_inclusive )
+                V_OPENCL( queue.enqueueCopyBuffer( values, *m_lastValue, ( valueOffset + numElements - 1 ) * sizeof( T ),
+                                                   0, sizeof( T ) ),
+                          "Error saving the last value of the scan_stream chunk" );
+
+            segmented_scan_run< T >( m_ctl, m_scanKernels, *m_binaryFunction, values, valueOffset, numElements,
+                *m_flags, output, outputOffset, m_init, *m_blockVals, *m_blockFlags, *m_blockFirstHead,
+                *m_blockBoundaries, m_hasCarry ? &*m_carry : NULL, m_inclusive, m_indexSpan );
+            segmented_scan_carry_out( m_ctl, m_scanKernels, *m_binaryFunction, output, outputOffset, numElements,
+                *m_lastValue, *m_carry, m_inclusive, m_indexSpan );
+            m_hasCarry = true;
+        }
+
+    private:
+        //  The SerialCpu path of host( )
+        void serial( const kType* keys, const T* values, size_t numElements, T* output )
+        {
+            for( size_t i = 0; i < numElements; ++i )
+            {
+                bool head;
+                if( keys )
+                {
+                    const kType& preKey = i ? keys[ i - 1 ] : m_hostKey;
+                    head = !( ( i || m_hasCarry ) && m_binary_pred( keys[ i ], preKey ) );
+                }
+                else
+                {
+                    head = !( i || m_hasCarry );
+                }
+
+                T value = values[ i ];
+                T total = head ? ( m_inclusive ? value : m_binary_op( m_init, value ) )
+                               : m_binary_op( m_hostCarry, value );
+                output[ i ] = m_inclusive ? total : ( head ? m_init : m_hostCarry );
+                m_hostCarry = total;
+            }
+
+            if( keys )
+                m_hostKey = keys[ numElements - 1 ];
+            m_hasCarry = true;
+        }
+
+        //  Builds the kernels and the buffers that do not depend on the chunk on the first chunk, and grows the
+        //  others to numElements; a chunk indexing past 32 bits rebuilds the kernels, and the head counts, wider
+        void reserve( size_t numElements, size_t indexSpan )
+        {
+            bool widen = !index_fits_32( indexSpan ) && index_fits_32( m_indexSpan );
+            m_indexSpan = std::max( m_indexSpan, indexSpan );
+
+            if( m_scanKernels.empty( ) )
+            {
+                m_scanKernels = segmented_scan_get_kernels< T, T, T, BinaryFunction >( m_ctl, m_cl_code, m_indexSpan );
+                if( m_keyed )
+                {
+                    m_flagsKernel = segmented_head_flags_get_kernel< kType, BinaryPredicate >( m_ctl, m_cl_code,
+                        m_indexSpan );
+
+                    ALIGNED( 256 ) BinaryPredicate aligned_binary_pred( m_binary_pred );
+                    m_binaryPredicate = m_ctl.acquireBuffer( sizeof( aligned_binary_pred ),
+                        CL_MEM_COPY_HOST_PTR|CL_MEM_READ_ONLY, &aligned_binary_pred );
+                    m_lastKey = m_ctl.acquireBuffer( sizeof( kType ) );
+                }
+
+                ALIGNED( 256 ) BinaryFunction aligned_binary_op( m_binary_op );
+                m_binaryFunction = m_ctl.acquireBuffer( sizeof( aligned_binary_op ),
+                    CL_MEM_COPY_HOST_PTR|CL_MEM_READ_ONLY, &aligned_binary_op );
+                m_carry = m_ctl.acquireBuffer( sizeof( T ) );
+                m_lastValue = m_ctl.acquireBuffer( sizeof( T ) );
+            }
+            else if( widen )
+            {
+                m_scanKernels = segmented_scan_get_kernels< T, T, T, BinaryFunction >( m_ctl, m_cl_code, m_indexSpan );
+                if( m_keyed )
+                    m_flagsKernel = segmented_head_flags_get_kernel< kType, BinaryPredicate >( m_ctl, m_cl_code,
+                        m_indexSpan );
+                m_capacity = 0;
+            }
+
+            if( numElements > m_capacity )
+            {
+                size_t flagWords = segmented_flag_words( numElements );
+                size_t numBlocks = segmented_blocks( numElements );
+                m_flags = m_ctl.acquireBuffer( flagWords * sizeof( cl_uint ) );
+                m_counts = m_ctl.acquireBuffer( flagWords * index_size( m_indexSpan ) );
+                m_blockVals = m_ctl.acquireBuffer( numBlocks * sizeof( T ) );
+                m_blockFlags = m_ctl.acquireBuffer( numBlocks * sizeof( cl_uint ) );
+                m_blockFirstHead = m_ctl.acquireBuffer( numBlocks * sizeof( cl_uint ) );
+                m_blockBoundaries = m_ctl.acquireBuffer( numBlocks * sizeof( T ) );
+                m_capacity = numElements;
+            }
+        }
+
+        control& m_ctl;
+        control::e_RunMode m_runMode;
+        bool m_keyed;
+        bool m_inclusive;
+        T m_init;
+        BinaryPredicate m_binary_pred;
+        BinaryFunction m_binary_op;
+        std::string m_cl_code;
+
+        bool m_hasCarry;
+        T m_hostCarry;
+        kType m_hostKey;
+
+        std::vector< ::cl::Kernel > m_scanKernels;
+        ::cl::Kernel m_flagsKernel;
+        control::buffPointer m_binaryFunction;
+        control::buffPointer m_binaryPredicate;
+        control::buffPointer m_carry;
+        control::buffPointer m_lastValue;
+        control::buffPointer m_lastKey;
+        size_t m_capacity;
+        size_t m_indexSpan;
+        control::buffPointer m_flags;
+        control::buffPointer m_counts;
+        control::buffPointer m_blockVals;
+        control::buffPointer m_blockFlags;
+        control::buffPointer m_blockFirstHead;
+        control::buffPointer m_blockBoundaries;
+    };
+
+    /**************************************************************************
+     * Chunks
+     *************************************************************************/
+
+    template< typename State, typename InputIterator, typename OutputIterator >
+    void scan_stream_chunk( State& state, const InputIterator& first, const InputIterator& last,
+                            const OutputIterator& result, std::random_access_iterator_tag )
+    {
+        typedef typename std::iterator_traits< InputIterator >::value_type T;
+        size_t numElements = static_cast< size_t >( std::distance( first, last ) );
+
+        if( state.onHost( ) )
+        {
+            state.host( NULL, &*first, numElements, &*result );
+        }
+        else
+        {
+            control& ctl = state.getControl( );
+            device_vector< T > dvInput( first, numElements, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, true, ctl );
+            device_vector< T > dvOutput( result, numElements, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY, false, ctl );
+            state.enqueue( NULL, 0, dvInput.begin( ).getBuffer( ), 0, numElements, dvOutput.begin( ).getBuffer( ), 0 );
+
+            // This should immediately map/unmap the buffer
+            dvOutput.data( );
+        }
+    }
+
+    template< typename State, typename DVInputIterator, typename DVOutputIterator >
+    void scan_stream_chunk( State& state, const DVInputIterator& first, const DVInputIterator& last,
+                            const DVOutputIterator& result, bolt::cl::device_vector_tag )
+    {
+        typedef typename std::iterator_traits< DVInputIterator >::value_type T;
+        size_t numElements = static_cast< size_t >( std::distance( first, last ) );
+
+        if( state.onHost( ) )
+        {
+            typename bolt::cl::device_vector< T >::pointer firstPtr = first.getContainer( ).data( );
+            if( first.getBuffer( )( ) == result.getBuffer( )( ) )
+            {
+                state.host( NULL, &firstPtr[ first.m_Index ], numElements, &firstPtr[ result.m_Index ] );
+            }
+            else
+            {
+                typename bolt::cl::device_vector< T >::pointer resultPtr = result.getContainer( ).data( );
+                state.host( NULL, &firstPtr[ first.m_Index ], numElements, &resultPtr[ result.m_Index ] );
+            }
+        }
+        else
+        {
+            state.enqueue( NULL, 0, first.getBuffer( ), static_cast< size_t >( first.m_Index ), numElements,
+                           result.getBuffer( ), static_cast< size_t >( result.m_Index ) );
+        }
+    }
+
+    template< typename State, typename InputIterator1, typename InputIterator2, typename OutputIterator >
+    void scan_by_key_stream_chunk( State& state, const InputIterator1& keys_first, const InputIterator1& keys_last,
+                                   const InputIterator2& values_first, const OutputIterator& result,
+                                   std::random_access_iterator_tag )
+    {
+        typedef typename std::iterator_traits< InputIterator1 >::value_type kType;
+        typedef typename std::iterator_traits< InputIterator2 >::value_type T;
+        size_t numElements = static_cast< size_t >( std::distance( keys_first, keys_last ) );
+
+        if( state.onHost( ) )
+        {
+            state.host( &*keys_first, &*values_first, numElements, &*result );
+        }
+        else
+        {
+            control& ctl = state.getControl( );
+            device_vector< kType > dvKeys( keys_first, numElements, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, true,
+                                           ctl );
+            device_vector< T > dvValues( values_first, numElements, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, true,
+                                         ctl );
+            device_vector< T > dvOutput( result, numElements, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY, false, ctl );
+            ::cl::Buffer keys = dvKeys.begin( ).getBuffer( );
+            state.enqueue( &keys, 0, dvValues.begin( ).getBuffer( ), 0, numElements, dvOutput.begin( ).getBuffer( ),
+                           0 );
+
+            // This should immediately map/unmap the buffer
+            dvOutput.data( );
+        }
+    }
+
+    template< typename State, typename DVInputIterator1, typename DVInputIterator2, typename DVOutputIterator >
+    void scan_by_key_stream_chunk( State& state, const DVInputIterator1& keys_first,
+                                   const DVInputIterator1& keys_last, const DVInputIterator2& values_first,
+                                   const DVOutputIterator& result, bolt::cl::device_vector_tag )
+    {
+        typedef typename std::iterator_traits< DVInputIterator1 >::value_type kType;
+        typedef typename std::iterator_traits< DVInputIterator2 >::value_type T;
+        size_t numElements = static_cast< size_t >( std::distance( keys_first, keys_last ) );
+
+        if( state.onHost( ) )
+        {
+            typename bolt::cl::device_vector< kType >::pointer keysPtr = keys_first.getContainer( ).data( );
+            typename bolt::cl::device_vector< T >::pointer valuesPtr = values_first.getContainer( ).data( );
+            if( values_first.getBuffer( )( ) == result.getBuffer( )( ) )
+            {
+                state.host( &keysPtr[ keys_first.m_Index ], &valuesPtr[ values_first.m_Index ], numElements,
+                              &valuesPtr[ result.m_Index ] );
+            }
+            else
+            {
+                typename bolt::cl::device_vector< T >::pointer resultPtr = result.getContainer( ).data( );
+                state.host( &keysPtr[ keys_first.m_Index ], &valuesPtr[ values_first.m_Index ], numElements,
+                              &resultPtr[ result.m_Index ] );
+            }
+        }
+        else
+        {
+            ::cl::Buffer keys = keys_first.getBuffer( );
+            state.enqueue( &keys, static_cast< size_t >( keys_first.m_Index ), values_first.getBuffer( ),
+                           static_cast< size_t >( values_first.m_Index ), numElements, result.getBuffer( ),
+                           static_cast< size_t >( result.m_Index ) );
+        }
+    }
+
+}   // namespace detail
+
+    /**************************************************************************
+     * scan_stream
+     *************************************************************************/
+
+    template< typename T, typename BinaryFunction >
+    scan_stream< T, BinaryFunction >::scan_stream( bool inclusive, const T& init, const BinaryFunction& binary_op,
+                                                   const std::string& cl_code ):
+        m_state( control::getDefault( ), false, inclusive, init, bolt::cl::equal_to< int >( ), binary_op, cl_code )
+    {}
+
+    template< typename T, typename BinaryFunction >
+    scan_stream< T, BinaryFunction >::scan_stream( control& ctl, bool inclusive, const T& init,
+                                                   const BinaryFunction& binary_op, const std::string& cl_code ):
+        m_state( ctl, false, inclusive, init, bolt::cl::equal_to< int >( ), binary_op, cl_code )
+    {}
+
+    template< typename T, typename BinaryFunction >
+    template< typename InputIterator, typename OutputIterator >
+    OutputIterator scan_stream< T, BinaryFunction >::operator( )( InputIterator first, InputIterator last,
+                                                                  OutputIterator result )
+    {
+        static_assert( std::is_same< typename std::iterator_traits< InputIterator >::value_type, T >::value,
+                       "scan_stream chunks must hold values of the stream's type" );
+
+        size_t numElements = static_cast< size_t >( std::distance( first, last ) );
+        if( numElements == 0 )
+            return result;
+
+        detail::scan_stream_chunk( m_state, first, last, result,
+                                   std::iterator_traits< InputIterator >::iterator_category( ) );
+        return result + numElements;
+    }
+
+    template< typename T, typename BinaryFunction >
+    T scan_stream< T, BinaryFunction >::carry( )
+    {
+        return m_state.carry( );
+    }
+
+    template< typename T, typename BinaryFunction >
+    void scan_stream< T, BinaryFunction >::reset( )
+    {
+        m_state.reset( );
+    }
+
+    /**************************************************************************
+     * scan_by_key_stream
+     *************************************************************************/
+
+    template< typename K, typename T, typename BinaryPredicate, typename BinaryFunction >
+    scan_by_key_stream< K, T, BinaryPredicate, BinaryFunction >::scan_by_key_stream( bool inclusive, const T& init,
+        const BinaryPredicate& binary_pred, const BinaryFunction& binary_op, const std::string& cl_code ):
+        m_state( control::getDefault( ), true, inclusive, init, binary_pred, binary_op, cl_code )
+    {}
+
+    template< typename K, typename T, typename BinaryPredicate, typename BinaryFunction >
+    scan_by_key_stream< K, T, BinaryPredicate, BinaryFunction >::scan_by_key_stream( control& ctl, bool inclusive,
+        const T& init, const BinaryPredicate& binary_pred, const BinaryFunction& binary_op,
+        const std::string& cl_code ):
+        m_state( ctl, true, inclusive, init, binary_pred, binary_op, cl_code )
+    {}
+
+    template< typename K, typename T, typename BinaryPredicate, typename BinaryFunction >
+    template< typename InputIterator1, typename InputIterator2, typename OutputIterator >
+    OutputIterator scan_by_key_stream< K, T, BinaryPredicate, BinaryFunction >::operator( )(
+        InputIterator1 keys_first, InputIterator1 keys_last, InputIterator2 values_first, OutputIterator result )
+    {
+        static_assert( std::is_same< typename std::iterator_traits< InputIterator1 >::value_type, K >::value,
+                       "scan_by_key_stream chunks must hold keys of the stream's key type" );
+        static_assert( std::is_same< typename std::iterator_traits< InputIterator2 >::value_type, T >::value,
+                       "scan_by_key_stream chunks must hold values of the stream's type" );
+
+        size_t numElements = static_cast< size_t >( std::distance( keys_first, keys_last ) );
+        if( numElements == 0 )
+            return result;
+
+        detail::scan_by_key_stream_chunk( m_state, keys_first, keys_last, values_first, result,
+                                          std::iterator_traits< InputIterator1 >::iterator_category( ) );
+        return result + numElements;
+    }
+
+    template< typename K, typename T, typename BinaryPredicate, typename BinaryFunction >
+    T scan_by_key_stream< K, T, BinaryPredicate, BinaryFunction >::carry( )
+    {
+        return m_state.carry( );
+    }
+
+    template< typename K, typename T, typename BinaryPredicate, typename BinaryFunction >
+    void scan_by_key_stream< K, T, BinaryPredicate, BinaryFunction >::reset( )
+    {
+        m_state.reset( );
+    }
+
+}   // namespace cl
+}   // namespace bolt
+
+#endif
@@ -0,0 +1,466 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#pragma once
+#if !defined( BOLT_CL_SEGMENTED_REDUCE_INL )
+#define BOLT_CL_SEGMENTED_REDUCE_INL
+
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+#include "bolt/cl/bolt.h"
+#include "bolt/cl/functional.h"
+#include "bolt/cl/device_vector.h"
+#include "bolt/cl/detail/segmented_scan.inl"
+#ifdef ENABLE_TBB
+#include "tbb/parallel_for.h"
+#include "tbb/blocked_range.h"
+#include "bolt/cl/detail/tbb_arena.inl"
+#endif
+
+namespace bolt {
+namespace cl {
+
+    template<typename InputIterator, typename OffsetIterator, typename OutputIterator, typename T,
+             typename BinaryFunction>
+    OutputIterator segmented_reduce(control &ctl,
+        InputIterator first,
+        InputIterator last,
+        OffsetIterator offsets_first,
+        OffsetIterator offsets_last,
+        OutputIterator result,
+        T init,
+        BinaryFunction binary_op,
+        const std::string& cl_code)
+    {
+        return detail::segmented_reduce_detect_random_access( ctl, first, last, offsets_first, offsets_last, result,
+                                                              init, binary_op, cl_code,
+                                                              std::iterator_traits< InputIterator >::iterator_category( ) );
+    }
+
+    template<typename InputIterator, typename OffsetIterator, typename OutputIterator, typename T,
+             typename BinaryFunction>
+    OutputIterator segmented_reduce(InputIterator first,
+        InputIterator last,
+        OffsetIterator offsets_first,
+        OffsetIterator offsets_last,
+        OutputIterator result,
+        T init,
+        BinaryFunction binary_op,
+        const std::string& cl_code)
+    {
+        return detail::segmented_reduce_detect_random_access( control::getDefault( ), first, last, offsets_first,
+                                                              offsets_last, result, init, binary_op, cl_code,
+                                                              std::iterator_traits< InputIterator >::iterator_category( ) );
+    }
+
+    template<typename InputIterator, typename OffsetIterator, typename OutputIterator>
+    OutputIterator segmented_reduce(control &ctl,
+        InputIterator first,
+        InputIterator last,
+        OffsetIterator offsets_first,
+        OffsetIterator offsets_last,
+        OutputIterator result,
+        const std::string& cl_code)
+    {
+        typedef typename std::iterator_traits< InputIterator >::value_type iType;
+
+        return detail::segmented_reduce_detect_random_access( ctl, first, last, offsets_first, offsets_last, result,
+                                                              iType( ), plus< iType >( ), cl_code,
+                                                              std::iterator_traits< InputIterator >::iterator_category( ) );
+    }
+
+    template<typename InputIterator, typename OffsetIterator, typename OutputIterator>
+    OutputIterator segmented_reduce(InputIterator first,
+        InputIterator last,
+        OffsetIterator offsets_first,
+        OffsetIterator offsets_last,
+        OutputIterator result,
+        const std::string& cl_code)
+    {
+        typedef typename std::iterator_traits< InputIterator >::value_type iType;
+
+        return detail::segmented_reduce_detect_random_access( control::getDefault( ), first, last, offsets_first,
+                                                              offsets_last, result, iType( ), plus< iType >( ),
+                                                              cl_code,
+                                                              std::iterator_traits< InputIterator >::iterator_category( ) );
+    }
+
+namespace detail {
+
+    enum segmentedReduceTypes { segReduce_oType, segReduce_initType, segReduce_BinaryFunction, segReduce_end };
+
+    class SegmentedReduce_KernelTemplateSpecializer : public KernelTemplateSpecializer
+    {
+    public:
+        SegmentedReduce_KernelTemplateSpecializer( ) : KernelTemplateSpecializer( )
+        {
+            addKernelName( "segmentedReduceGather" );
+        }
+
+        const ::std::string operator( ) ( const ::std::vector< ::std::string >& typeNames ) const
+        {
+            const std::string templateSpecializationString =
+                "// Dynamic specialization of generic template definition, using user supplied types\n"
+                "template __attribute__((mangled_name(" + name( 0 ) + "Instantiated)))\n"
+                "__attribute__((reqd_work_group_size(SEGMENTED_WGSIZE,1,1)))\n"
+                "__kernel void " + name( 0 ) + "(\n"
+                "global " + typeNames[ segReduce_oType ] + "* scanned,\n"
+                "global indexType* offsets,\n"
+                "const indexType numSegments,\n"
+                ""        + typeNames[ segReduce_initType ] + " init,\n"
+                "global " + typeNames[ segReduce_BinaryFunction ] + "* binaryFunct,\n"
+                "global " + typeNames[ segReduce_oType ] + "* output,\n"
+                "const indexType outOffset\n"
+                ");\n\n";
+
+            return templateSpecializationString;
+        }
+    };
+
+    /**************************************************************************
+     * Segments
+     *************************************************************************/
+
+    //  Reads the user's offsets into offsets; a device_vector is mapped once rather than read element by element
+    template< typename OffsetIterator >
+    void segmented_reduce_read_offsets( OffsetIterator offsets_first, OffsetIterator offsets_last,
+                                        std::vector< size_t >& offsets, std::random_access_iterator_tag )
+    {
+        offsets.assign( offsets_first, offsets_last );
+    }
+
+    template< typename OffsetIterator >
+    void segmented_reduce_read_offsets( OffsetIterator offsets_first, OffsetIterator offsets_last,
+                                        std::vector< size_t >& offsets, bolt::cl::fancy_iterator_tag )
+    {
+        offsets.assign( offsets_first, offsets_last );
+    }
+
+    template< typename OffsetIterator >
+    void segmented_reduce_read_offsets( OffsetIterator offsets_first, OffsetIterator offsets_last,
+                                        std::vector< size_t >& offsets, bolt::cl::device_vector_tag )
+    {
+        typedef typename std::iterator_traits< OffsetIterator >::value_type oType;
+        size_t numOffsets = static_cast< size_t >( offsets_last - offsets_first );
+        if( numOffsets == 0 )
+            return;
+
+        typename bolt::cl::device_vector< oType >::pointer offsetsPtr = offsets_first.getContainer( ).data( );
+        oType* rangeFirst = &offsetsPtr[ offsets_first.m_Index ];
+        offsets.assign( rangeFirst, rangeFirst + numOffsets );
+    }
+
+    /*! \brief The start of every segment of a range of \p length elements, followed by \p length
+     *  \details Throws if the offsets are not in ascending order or run past the range.
+     */
+    template< typename OffsetIterator >
+    std::vector< size_t > segmented_reduce_offsets( OffsetIterator offsets_first, OffsetIterator offsets_last,
+                                                     size_t length )
+    {
+        std::vector< size_t > offsets;
+        segmented_reduce_read_offsets( offsets_first, offsets_last, offsets,
+                                       std::iterator_traits< OffsetIterator >::iterator_category( ) );
+        offsets.push_back( length );
+
+        for( size_t s = 1; s < offsets.size( ); ++s )
+        {
+            if( offsets[ s ] < offsets[ s - 1 ] )
+                throw ::cl::Error( CL_INVALID_VALUE,
+                                   "segmented_reduce offsets must be ascending and within the reduced range" );
+        }
+        return offsets;
+    }
+
+    /**************************************************************************
+     * CPU Paths
+     *************************************************************************/
+
+    //  Reduces segments [segFirst, segLast) of the range at first into result
+    template< typename InputIterator, typename OutputIterator, typename T, typename BinaryFunction >
+    void segmented_reduce_serial( InputIterator first, const size_t* offsets, size_t segFirst, size_t segLast,
+                                  OutputIterator result, const T& init, const BinaryFunction& binary_op )
+    {
+        typedef typename std::iterator_traits< OutputIterator >::value_type oType;
+
+        for( size_t s = segFirst; s != segLast; ++s )
+        {
+            oType value = init;
+            for( size_t i = offsets[ s ]; i != offsets[ s + 1 ]; ++i )
+                value = binary_op( value, first[ i ] );
+            result[ s ] = value;
+        }
+    }
+
+#ifdef ENABLE_TBB
+    template< typename InputIterator, typename OutputIterator, typename T, typename BinaryFunction >
+    struct tbbSegmentedReduce
+    {
+        InputIterator first;
+        const size_t* offsets;
+        OutputIterator result;
+        T init;
+        BinaryFunction binary_op;
+
+        tbbSegmentedReduce( InputIterator _first, const size_t* _offsets, OutputIterator _result, const T& _init,
+                            const BinaryFunction& _binary_op ):
+            first( _first ), offsets( _offsets ), result( _result ), init( _init ), binary_op( _binary_op )
+        {}
+
+        void operator( )( const tbb::blocked_range< size_t >& segments ) const
+        {
+            segmented_reduce_serial( first, offsets, segments.begin( ), segments.end( ), result, init, binary_op );
+        }
+    };
+#endif
+
+    //  Reduces every segment on the host, serially or in the arena of ctl
+    template< typename InputIterator, typename OutputIterator, typename T, typename BinaryFunction >
+    void segmented_reduce_cpu( control& ctl, control::e_RunMode runMode, InputIterator first,
+                               const std::vector< size_t >& offsets, OutputIterator result, const T& init,
+                               const BinaryFunction& binary_op )
+    {
+        size_t numSegments = offsets.size( ) - 1;
+        if( runMode == bolt::cl::control::SerialCpu )
+        {
+            segmented_reduce_serial( first, &offsets[ 0 ], 0, numSegments, result, init, binary_op );
+        }
+        else
+        {
+#ifdef ENABLE_TBB
+            control::tbbPartitionDesc part = ctl.getTbbPartitioner( "segmented_reduce" );
+            tbb_parallel_for( ctl, tbb::blocked_range< size_t >( 0, numSegments, part.grainSize ),
+                              tbbSegmentedReduce< InputIterator, OutputIterator, T, BinaryFunction >(
+                                  first, &offsets[ 0 ], result, init, binary_op ),
+                              part.partitioner );
+#else
+            throw ::cl::Error( CL_INVALID_OPERATION,
+                               "The MultiCoreCpu version of segmented_reduce is not enabled to be built." );
+#endif
+        }
+    }
+
+    /**************************************************************************
+     * OpenCL Path
+     *************************************************************************/
+
+    //  Copies the offsets into a buffer of the kernels' indexType
+    template< typename indexType >
+    control::buffPointer segmented_reduce_offsets_buffer( control& ctl, const std::vector< size_t >& offsets )
+    {
+        std::vector< indexType > indices( offsets.size( ) );
+        for( size_t s = 0; s < offsets.size( ); ++s )
+            indices[ s ] = static_cast< indexType >( offsets[ s ] );
+        return ctl.acquireBuffer( indices.size( ) * sizeof( indexType ), CL_MEM_COPY_HOST_PTR|CL_MEM_READ_ONLY,
+                                  &indices[ 0 ] );
+    }
+
+    /*! \brief Enqueues the reduction of every segment of [first, last) into result
+     *  \details The segment heads are set in a bitmap on the host, the values are scanned by segment under it, and
+     *  a segment's reduction is then its init combined with the scan at its last element.
+     */
+    template< typename DVInputIterator, typename DVOutputIterator, typename T, typename BinaryFunction >
+    void segmented_reduce_enqueue( control& ctl, const DVInputIterator& first, const DVInputIterator& last,
+                                   const std::vector< size_t >& offsets, const DVOutputIterator& result,
+                                   const T& init, const BinaryFunction& binary_op, const std::string& cl_code )
+    {
+        typedef typename std::iterator_traits< DVInputIterator >::value_type iType;
+        typedef typename std::iterator_traits< DVOutputIterator >::value_type oType;
+
+        size_t numElements = static_cast< size_t >( std::distance( first, last ) );
+        size_t numSegments = offsets.size( ) - 1;
+        size_t inputOffset = static_cast< size_t >( first.m_Index );
+        size_t resultOffset = static_cast< size_t >( result.m_Index );
+        size_t indexSpan = std::max( inputOffset + numElements, resultOffset + numSegments + 1 );
+
+        //  Empty segments share their head with the segment after them; elements before the first segment are
+        //  scanned, but no segment reads them
+        std::vector< cl_uint > flags( segmented_flag_words( numElements ) + 1, 0 );
+        for( size_t s = 0; s < numSegments; ++s )
+        {
+            if( offsets[ s ] < offsets[ s + 1 ] )
+                flags[ offsets[ s ] >> 5 ] |= 1u << ( offsets[ s ] & 31 );
+        }
+
+        control::buffPointer flagsBuffer = ctl.acquireBuffer( flags.size( ) * sizeof( cl_uint ),
+            CL_MEM_COPY_HOST_PTR|CL_MEM_READ_ONLY, &flags[ 0 ] );
+        control::buffPointer offsetsBuffer = index_fits_32( indexSpan ) ?
+            segmented_reduce_offsets_buffer< cl_uint >( ctl, offsets ) :
+            segmented_reduce_offsets_buffer< cl_ulong >( ctl, offsets );
+        control::buffPointer scanned = ctl.acquireBuffer( ( numElements ? numElements : 1 ) * sizeof( oType ) );
+
+        if( numElements )
+            segmented_scan_enqueue< iType, oType >( ctl, first.getBuffer( ), inputOffset, numElements, *flagsBuffer,
+                *scanned, 0, init, binary_op, cl_code, true, indexSpan );
+
+        std::vector< std::string > typeNames( segReduce_end );
+        typeNames[ segReduce_oType ] = TypeName< oType >::get( );
+        typeNames[ segReduce_initType ] = TypeName< T >::get( );
+        typeNames[ segReduce_BinaryFunction ] = TypeName< BinaryFunction >::get( );
+
+        std::vector< std::string > typeDefs;
+        if( !cl_code.empty( ) )
+            typeDefs.push_back( cl_code );
+        PUSH_BACK_UNIQUE( typeDefs, ClCode< oType >::get( ) )
+        PUSH_BACK_UNIQUE( typeDefs, ClCode< T >::get( ) )
+        PUSH_BACK_UNIQUE( typeDefs, ClCode< BinaryFunction >::get( ) )
+
+        SegmentedReduce_KernelTemplateSpecializer gather_kts;
+        std::vector< ::cl::Kernel > kernels = bolt::cl::getKernels(
+            ctl,
+            typeNames,
+            &gather_kts,
+            typeDefs,
+            segmented_scan_kernels,
+            segmented_compile_options( indexSpan ) );
+
+        ALIGNED( 256 ) BinaryFunction aligned_binary_op( binary_op );
+        control::buffPointer binaryFunctionBuffer = ctl.acquireBuffer( sizeof( aligned_binary_op ),
+            CL_MEM_COPY_HOST_PTR|CL_MEM_READ_ONLY, &aligned_binary_op );
+
+        V_OPENCL( kernels[ 0 ].setArg( 0, *scanned ),              "Error setArg segmentedReduceGather" );
+        V_OPENCL( kernels[ 0 ].setArg( 1, *offsetsBuffer ),        "Error setArg segmentedReduceGather" );
+        V_OPENCL( index_set_arg( kernels[ 0 ], 2, numSegments, indexSpan ), "Error setArg segmentedReduceGather" );
+        V_OPENCL( kernels[ 0 ].setArg( 3, init ),                  "Error setArg segmentedReduceGather" );
+        V_OPENCL( kernels[ 0 ].setArg( 4, *binaryFunctionBuffer ), "Error setArg segmentedReduceGather" );
+        V_OPENCL( kernels[ 0 ].setArg( 5, result.getBuffer( ) ),   "Error setArg segmentedReduceGather" );
+        V_OPENCL( index_set_arg( kernels[ 0 ], 6, resultOffset, indexSpan ), "Error setArg segmentedReduceGather" );
+
+        segmented_run( ctl, kernels[ 0 ], segmented_blocks( numSegments ),
+                       "enqueueNDRangeKernel() failed for segmentedReduceGather" );
+
+        V_OPENCL( ctl.getCommandQueue( ).finish( ), "segmented_reduce failed to wait for the reductions" );
+    }
+
+    /**************************************************************************
+     * Dispatch
+     *************************************************************************/
+
+    template< typename InputIterator, typename OffsetIterator, typename OutputIterator, typename T,
+              typename BinaryFunction >
+    OutputIterator segmented_reduce_detect_random_access( control& ctl, const InputIterator& first,
+        const InputIterator& last, const OffsetIterator& offsets_first, const OffsetIterator& offsets_last,
+        const OutputIterator& result, const T& init, const BinaryFunction& binary_op, const std::string& cl_code,
+        std::input_iterator_tag )
+    {
+        static_assert( false, "Bolt only supports random access iterator types" );
+    }
+
+    template< typename InputIterator, typename OffsetIterator, typename OutputIterator, typename T,
+              typename BinaryFunction >
+    OutputIterator segmented_reduce_detect_random_access( control& ctl, const InputIterator& first,
+        const InputIterator& last, const OffsetIterator& offsets_first, const OffsetIterator& offsets_last,
+        const OutputIterator& result, const T& init, const BinaryFunction& binary_op, const std::string& cl_code,
+        std::random_access_iterator_tag )
+    {
+        size_t length = static_cast< size_t >( std::distance( first, last ) );
+        std::vector< size_t > offsets = segmented_reduce_offsets( offsets_first, offsets_last, length );
+        size_t numSegments = offsets.size( ) - 1;
+        if( numSegments == 0 )
+            return result;
+
+        segmented_reduce_pick_iterator( ctl, first, last, offsets, result, init, binary_op, cl_code,
+                                        std::iterator_traits< InputIterator >::iterator_category( ) );
+        return result + numSegments;
+    }
+
+    //  Fancy iterators are read into a vector on the host first
+    template< typename InputIterator, typename OutputIterator, typename T, typename BinaryFunction >
+    void segmented_reduce_pick_iterator( control& ctl, const InputIterator& first, const InputIterator& last,
+                                         const std::vector< size_t >& offsets, const OutputIterator& result,
+                                         const T& init, const BinaryFunction& binary_op, const std::string& cl_code,
+                                         bolt::cl::fancy_iterator_tag )
+    {
+        typedef typename std::iterator_traits< InputIterator >::value_type iType;
+
+        std::vector< iType > input( first, last );
+        segmented_reduce_pick_iterator( ctl, input.begin( ), input.end( ), offsets, result, init, binary_op, cl_code,
+                                        std::random_access_iterator_tag( ) );
+    }
+
+    template< typename InputIterator, typename OutputIterator, typename T, typename BinaryFunction >
+    void segmented_reduce_pick_iterator( control& ctl, const InputIterator& first, const InputIterator& last,
+                                         const std::vector< size_t >& offsets, const OutputIterator& result,
+                                         const T& init, const BinaryFunction& binary_op, const std::string& cl_code,
+                                         std::random_access_iterator_tag )
+    {
+        typedef typename std::iterator_traits< InputIterator >::value_type iType;
+        typedef typename std::iterator_traits< OutputIterator >::value_type oType;
+
+        bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode( );
+        if( runMode == bolt::cl::control::Automatic )
+        {
+            runMode = ctl.getDefaultPathToRun( );
+        }
+
+        size_t numElements = static_cast< size_t >( std::distance( first, last ) );
+        size_t numSegments = offsets.size( ) - 1;
+        if( runMode == bolt::cl::control::SerialCpu || runMode == bolt::cl::control::MultiCoreCpu )
+        {
+            segmented_reduce_cpu( ctl, runMode, first, offsets, result, init, binary_op );
+        }
+        else if( numElements == 0 )
+        {
+            std::fill( result, result + numSegments, static_cast< oType >( init ) );
+        }
+        else
+        {
+            device_vector< iType > dvInput( first, numElements, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, true, ctl );
+            device_vector< oType > dvResult( result, numSegments, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY, false,
+                                             ctl );
+            segmented_reduce_enqueue( ctl, dvInput.begin( ), dvInput.end( ), offsets, dvResult.begin( ), init,
+                                      binary_op, cl_code );
+
+            // This should immediately map/unmap the buffer
+            dvResult.data( );
+        }
+    }
+
+    template< typename DVInputIterator, typename DVOutputIterator, typename T, typename BinaryFunction >
+    void segmented_reduce_pick_iterator( control& ctl, const DVInputIterator& first, const DVInputIterator& last,
+                                         const std::vector< size_t >& offsets, const DVOutputIterator& result,
+                                         const T& init, const BinaryFunction& binary_op, const std::string& cl_code,
+                                         bolt::cl::device_vector_tag )
+    {
+        typedef typename std::iterator_traits< DVInputIterator >::value_type iType;
+        typedef typename std::iterator_traits< DVOutputIterator >::value_type oType;
+
+        bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode( );
+        if( runMode == bolt::cl::control::Automatic )
+        {
+            runMode = ctl.getDefaultPathToRun( );
+        }
+
+        if( runMode == bolt::cl::control::SerialCpu || runMode == bolt::cl::control::MultiCoreCpu )
+        {
+            typename bolt::cl::device_vector< iType >::pointer firstPtr = first.getContainer( ).data( );
+            typename bolt::cl::device_vector< oType >::pointer resultPtr = result.getContainer( ).data( );
+            segmented_reduce_cpu( ctl, runMode, &firstPtr[ first.m_Index ], offsets, &resultPtr[ result.m_Index ],
+                                  init, binary_op );
+        }
+        else
+        {
+            segmented_reduce_enqueue( ctl, first, last, offsets, result, init, binary_op, cl_code );
+        }
+    }
+
+}   // namespace detail
+}   // namespace cl
+}   // namespace bolt
+
+#endif
@@ -0,0 +1,471 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+/*  Host side of the segmented scan engine in segmented_scan_kernels.cl, shared by scan_by_key, reduce_by_key and
+ *  segmented_reduce.  The segments are a bitmap of head flags, one bit an element, computed once from the keys by
+ *  segmented_head_flags_enqueue or on the host from offsets; segmented_scan_enqueue then scans any values under it
+ *  without reading a key.  Buffers are passed with the element offset of the range in them.  indexSpan bounds every
+ *  index the kernels form, offsets included, and picks the width of their indexType and of the head counts.
+ */
+
+#if !defined( BOLT_CL_SEGMENTED_SCAN_INL )
+#define BOLT_CL_SEGMENTED_SCAN_INL
+#pragma once
+
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include "bolt/cl/bolt.h"
+#include "bolt/cl/detail/index_type.inl"
+
+/* \brief - Work items in a work group of the segmented scan kernels, and elements in a block of the scan */
+#define SEGMENTED_WGSIZE 256
+
+namespace bolt {
+namespace cl {
+namespace detail {
+
+//  Words of the head flag bitmap of numElements elements
+inline size_t segmented_flag_words( size_t numElements )
+{
+    return ( numElements + 31 ) / 32;
+}
+
+inline size_t segmented_blocks( size_t numElements )
+{
+    return ( numElements + SEGMENTED_WGSIZE - 1 ) / SEGMENTED_WGSIZE;
+}
+
+inline std::string segmented_compile_options( size_t indexSpan )
+{
+    std::ostringstream oss;
+    oss << " -DSEGMENTED_WGSIZE=" << SEGMENTED_WGSIZE;
+    oss << index_compile_options( indexSpan );
+    return oss.str( );
+}
+
+//  Launches kernel over numGroups work groups of SEGMENTED_WGSIZE work items, in order after the work before it
+inline void segmented_run( control &ctl, ::cl::Kernel& kernel, size_t numGroups, const char* errorString )
+{
+    cl_int l_Error = ctl.getCommandQueue( ).enqueueNDRangeKernel(
+        kernel,
+        ::cl::NullRange,
+        ::cl::NDRange( numGroups * SEGMENTED_WGSIZE ),
+        ::cl::NDRange( SEGMENTED_WGSIZE ) );
+    V_OPENCL( l_Error, errorString );
+}
+
+enum segmentedFlagsTypes { segFlags_kType, segFlags_BinaryPredicate, segFlags_end };
+
+class SegmentedHeadFlags_KernelTemplateSpecializer : public KernelTemplateSpecializer
+{
+public:
+    SegmentedHeadFlags_KernelTemplateSpecializer() : KernelTemplateSpecializer()
+    {
+        addKernelName("segmentedHeadFlags");
+    }
+
+    const ::std::string operator() ( const ::std::vector<::std::string>& typeNames ) const
+    {
+        const std::string templateSpecializationString =
+            "// Dynamic specialization of generic template definition, using user supplied types\n"
+            "template __attribute__((mangled_name(" + name(0) + "Instantiated)))\n"
+            "__attribute__((reqd_work_group_size(SEGMENTED_WGSIZE,1,1)))\n"
+            "__kernel void " + name(0) + "(\n"
+            "global " + typeNames[segFlags_kType] + "* keys,\n"
+            "const indexType keyOffset,\n"
+            "const indexType vecSize,\n"
+            "global " + typeNames[segFlags_BinaryPredicate] + "* binaryPred,\n"
+            "global uint* flags,\n"
+            "global indexType* counts,\n"
+            "global " + typeNames[segFlags_kType] + "* prevKey,\n"
+            "int hasPrevKey\n"
+            ");\n\n";
+
+        return templateSpecializationString;
+    }
+};
+
+enum segmentedScanTypes { segScan_vType, segScan_oType, segScan_initType, segScan_BinaryFunction, segScan_end };
+
+class SegmentedScan_KernelTemplateSpecializer : public KernelTemplateSpecializer
+{
+public:
+    SegmentedScan_KernelTemplateSpecializer() : KernelTemplateSpecializer()
+    {
+        addKernelName("segmentedScanPerBlock");
+        addKernelName("segmentedScanBlocks");
+        addKernelName("segmentedScanAddition");
+        addKernelName("segmentedScanCarryOut");
+        addKernelName("segmentedScanBoundaries");
+    }
+
+    const ::std::string operator() ( const ::std::vector<::std::string>& typeNames ) const
+    {
+        const std::string templateSpecializationString =
+            "// Dynamic specialization of generic template definition, using user supplied types\n"
+            "template __attribute__((mangled_name(" + name(0) + "Instantiated)))\n"
+            "__attribute__((reqd_work_group_size(SEGMENTED_WGSIZE,1,1)))\n"
+            "__kernel void " + name(0) + "(\n"
+            "global " + typeNames[segScan_vType] + "* vals,\n"
+            "const indexType valOffset,\n"
+            "global uint* flags,\n"
+            "global " + typeNames[segScan_oType] + "* output,\n"
+            "const indexType outOffset,\n"
+            ""        + typeNames[segScan_initType] + " init,\n"
+            "const indexType vecSize,\n"
+            "local "  + typeNames[segScan_oType] + "* ldsVals,\n"
+            "global " + typeNames[segScan_BinaryFunction] + "* binaryFunct,\n"
+            "global " + typeNames[segScan_oType] + "* blockVals,\n"
+            "global uint* blockFlags,\n"
+            "global uint* blockFirstHead,\n"
+            "int exclusive,\n"
+            "global " + typeNames[segScan_oType] + "* carry,\n"
+            "int hasCarry,\n"
+            "global " + typeNames[segScan_vType] + "* blockBoundaries\n"
+            ");\n\n"
+
+            "// Dynamic specialization of generic template definition, using user supplied types\n"
+            "template __attribute__((mangled_name(" + name(1) + "Instantiated)))\n"
+            "__attribute__((reqd_work_group_size(SEGMENTED_WGSIZE,1,1)))\n"
+            "__kernel void " + name(1) + "(\n"
+            "global " + typeNames[segScan_oType] + "* blockVals,\n"
+            "global uint* blockFlags,\n"
+            "const indexType numBlocks,\n"
+            "const indexType workPerThread,\n"
+            "local "  + typeNames[segScan_oType] + "* ldsVals,\n"
+            "global " + typeNames[segScan_BinaryFunction] + "* binaryFunct\n"
+            ");\n\n"
+
+            "// Dynamic specialization of generic template definition, using user supplied types\n"
+            "template __attribute__((mangled_name(" + name(2) + "Instantiated)))\n"
+            "__attribute__((reqd_work_group_size(SEGMENTED_WGSIZE,1,1)))\n"
+            "__kernel void " + name(2) + "(\n"
+            "global " + typeNames[segScan_oType] + "* output,\n"
+            "const indexType outOffset,\n"
+            "const indexType vecSize,\n"
+            "global " + typeNames[segScan_oType] + "* blockVals,\n"
+            "global uint* blockFirstHead,\n"
+            "global " + typeNames[segScan_BinaryFunction] + "* binaryFunct\n"
+            ");\n\n"
+
+            "// Dynamic specialization of generic template definition, using user supplied types\n"
+            "template __attribute__((mangled_name(" + name(3) + "Instantiated)))\n"
+            "__kernel void " + name(3) + "(\n"
+            "global " + typeNames[segScan_oType] + "* output,\n"
+            "const indexType outOffset,\n"
+            "const indexType vecSize,\n"
+            "global " + typeNames[segScan_vType] + "* lastValue,\n"
+            "global " + typeNames[segScan_BinaryFunction] + "* binaryFunct,\n"
+            "global " + typeNames[segScan_oType] + "* carry,\n"
+            "int exclusive\n"
+            ");\n\n"
+
+            "// Dynamic specialization of generic template definition, using user supplied types\n"
+            "template __attribute__((mangled_name(" + name(4) + "Instantiated)))\n"
+            "__attribute__((reqd_work_group_size(SEGMENTED_WGSIZE,1,1)))\n"
+            "__kernel void " + name(4) + "(\n"
+            "global " + typeNames[segScan_vType] + "* vals,\n"
+            "const indexType valOffset,\n"
+            "const indexType numBlocks,\n"
+            "global " + typeNames[segScan_vType] + "* blockBoundaries\n"
+            ");\n\n";
+
+        return templateSpecializationString;
+    }
+};
+
+//  The head flags kernel for keys of kType compared with binary_pred
+template< typename kType, typename BinaryPredicate >
+::cl::Kernel segmented_head_flags_get_kernel( control &ctl, const std::string& user_code, size_t indexSpan )
+{
+    std::vector< std::string > typeNames( segFlags_end );
+    typeNames[ segFlags_kType ] = TypeName< kType >::get( );
+    typeNames[ segFlags_BinaryPredicate ] = TypeName< BinaryPredicate >::get( );
+
+    std::vector< std::string > typeDefs;
+    if( !user_code.empty( ) )
+        typeDefs.push_back( user_code );
+    PUSH_BACK_UNIQUE( typeDefs, ClCode< kType >::get( ) )
+    PUSH_BACK_UNIQUE( typeDefs, ClCode< BinaryPredicate >::get( ) )
+
+    SegmentedHeadFlags_KernelTemplateSpecializer flags_kts;
+    std::vector< ::cl::Kernel > kernels = bolt::cl::getKernels(
+        ctl,
+        typeNames,
+        &flags_kts,
+        typeDefs,
+        segmented_scan_kernels,
+        segmented_compile_options( indexSpan ) );
+    return kernels[ 0 ];
+}
+
+/*! \brief Enqueues kernel, from segmented_head_flags_get_kernel, over numElements keys from keyOffset in keys
+ *  \details prevKey, when not NULL, holds the last key of a chunk before, which the first key may continue.
+ */
+inline void segmented_head_flags_run(
+    control &ctl,
+    ::cl::Kernel& kernel,
+    const ::cl::Buffer& keys,
+    size_t keyOffset,
+    size_t numElements,
+    const ::cl::Buffer& binaryPredicateBuffer,
+    const ::cl::Buffer& flags,
+    const ::cl::Buffer& counts,
+    const ::cl::Buffer* prevKey,
+    size_t indexSpan )
+{
+    cl_int hasPrevKey = prevKey ? 1 : 0;
+
+    V_OPENCL( kernel.setArg( 0, keys ),                       "Error setArg segmentedHeadFlags" );
+    V_OPENCL( index_set_arg( kernel, 1, keyOffset, indexSpan ),   "Error setArg segmentedHeadFlags" );
+    V_OPENCL( index_set_arg( kernel, 2, numElements, indexSpan ), "Error setArg segmentedHeadFlags" );
+    V_OPENCL( kernel.setArg( 3, binaryPredicateBuffer ),      "Error setArg segmentedHeadFlags" );
+    V_OPENCL( kernel.setArg( 4, flags ),                      "Error setArg segmentedHeadFlags" );
+    V_OPENCL( kernel.setArg( 5, counts ),                     "Error setArg segmentedHeadFlags" );
+    V_OPENCL( kernel.setArg( 6, prevKey ? *prevKey : keys ),  "Error setArg segmentedHeadFlags" );
+    V_OPENCL( kernel.setArg( 7, hasPrevKey ),                 "Error setArg segmentedHeadFlags" );
+
+    segmented_run( ctl, kernel, segmented_blocks( numElements ),
+        "enqueueNDRangeKernel() failed for segmentedHeadFlags" );
+}
+
+/*! \brief Enqueues the head flags of numElements keys from keyOffset in keys
+ *  \details flags and counts hold segmented_flag_words( numElements ) words each, of 32 bits in flags and of
+ *  index_size( indexSpan ) bytes in counts; counts gets the number of heads in every word of flags.  Each key is
+ *  compared with binary_pred( key, key before it ) once.
+ */
+template< typename kType, typename BinaryPredicate >
+void segmented_head_flags_enqueue(
+    control &ctl,
+    const ::cl::Buffer& keys,
+    size_t keyOffset,
+    size_t numElements,
+    const BinaryPredicate& binary_pred,
+    const std::string& user_code,
+    const ::cl::Buffer& flags,
+    const ::cl::Buffer& counts,
+    size_t indexSpan )
+{
+    ::cl::Kernel kernel = segmented_head_flags_get_kernel< kType, BinaryPredicate >( ctl, user_code, indexSpan );
+
+    ALIGNED( 256 ) BinaryPredicate aligned_binary_pred( binary_pred );
+    control::buffPointer binaryPredicateBuffer = ctl.acquireBuffer( sizeof( aligned_binary_pred ),
+        CL_MEM_COPY_HOST_PTR|CL_MEM_READ_ONLY, &aligned_binary_pred );
+
+    segmented_head_flags_run( ctl, kernel, keys, keyOffset, numElements, *binaryPredicateBuffer, flags, counts,
+        NULL, indexSpan );
+}
+
+//  The segmented scan kernels, in the order of SegmentedScan_KernelTemplateSpecializer
+template< typename vType, typename oType, typename T, typename BinaryFunction >
+std::vector< ::cl::Kernel > segmented_scan_get_kernels( control &ctl, const std::string& user_code, size_t indexSpan )
+{
+    std::vector< std::string > typeNames( segScan_end );
+    typeNames[ segScan_vType ] = TypeName< vType >::get( );
+    typeNames[ segScan_oType ] = TypeName< oType >::get( );
+    typeNames[ segScan_initType ] = TypeName< T >::get( );
+    typeNames[ segScan_BinaryFunction ] = TypeName< BinaryFunction >::get( );
+
+    std::vector< std::string > typeDefs;
+    if( !user_code.empty( ) )
+        typeDefs.push_back( user_code );
+    PUSH_BACK_UNIQUE( typeDefs, ClCode< vType >::get( ) )
+    PUSH_BACK_UNIQUE( typeDefs, ClCode< oType >::get( ) )
+    PUSH_BACK_UNIQUE( typeDefs, ClCode< T >::get( ) )
+    PUSH_BACK_UNIQUE( typeDefs, ClCode< BinaryFunction >::get( ) )
+
+    SegmentedScan_KernelTemplateSpecializer scan_kts;
+    return bolt::cl::getKernels(
+        ctl,
+        typeNames,
+        &scan_kts,
+        typeDefs,
+        segmented_scan_kernels,
+        segmented_compile_options( indexSpan ) );
+}
+
+/*! \brief Enqueues the segmented scan kernels from segmented_scan_get_kernels
+ *  \details blockVals, blockFlags, blockFirstHead and blockBoundaries hold segmented_blocks( numElements ) elements
+ *  each, blockBoundaries of the value type; an exclusive scan saves the last value of every block there first, so
+ *  the output may be the values themselves.  carry, when not NULL, holds the total of a chunk scanned before, which a
+ *  first element that is not a head continues.
+ */
+template< typename oType, typename T >
+void segmented_scan_run(
+    control &ctl,
+    std::vector< ::cl::Kernel >& kernels,
+    const ::cl::Buffer& binaryFunctionBuffer,
+    const ::cl::Buffer& values,
+    size_t valueOffset,
+    size_t numElements,
+    const ::cl::Buffer& flags,
+    const ::cl::Buffer& output,
+    size_t outputOffset,
+    const T& init,
+    const ::cl::Buffer& blockVals,
+    const ::cl::Buffer& blockFlags,
+    const ::cl::Buffer& blockFirstHead,
+    const ::cl::Buffer& blockBoundaries,
+    const ::cl::Buffer* carry,
+    bool inclusive,
+    size_t indexSpan )
+{
+    size_t numBlocks = segmented_blocks( numElements );
+    ::cl::LocalSpaceArg ldsVals;
+    ldsVals.size_ = SEGMENTED_WGSIZE * sizeof( oType );
+    cl_int doExclusiveScan = inclusive ? 0 : 1;
+    cl_int hasCarry = carry ? 1 : 0;
+
+    /**********************************************************************************
+     *  Kernel 4, the values the first element of every block shifts in
+     *********************************************************************************/
+    if( !inclusive && numBlocks > 1 )
+    {
+        V_OPENCL( kernels[4].setArg( 0, values ),             "Error setArg kernels[ 4 ]" );
+        V_OPENCL( index_set_arg( kernels[4], 1, valueOffset, indexSpan ), "Error setArg kernels[ 4 ]" );
+        V_OPENCL( index_set_arg( kernels[4], 2, numBlocks, indexSpan ),   "Error setArg kernels[ 4 ]" );
+        V_OPENCL( kernels[4].setArg( 3, blockBoundaries ),    "Error setArg kernels[ 4 ]" );
+        segmented_run( ctl, kernels[4], segmented_blocks( numBlocks ), "enqueueNDRangeKernel() failed for kernel[4]" );
+    }
+
+    /**********************************************************************************
+     *  Kernel 0
+     *********************************************************************************/
+    V_OPENCL( kernels[0].setArg( 0, values ),                 "Error setArg kernels[ 0 ]" ); // Input values
+    V_OPENCL( index_set_arg( kernels[0], 1, valueOffset, indexSpan ),  "Error setArg kernels[ 0 ]" );
+    V_OPENCL( kernels[0].setArg( 2, flags ),                  "Error setArg kernels[ 0 ]" ); // Head flags
+    V_OPENCL( kernels[0].setArg( 3, output ),                 "Error setArg kernels[ 0 ]" ); // Output
+    V_OPENCL( index_set_arg( kernels[0], 4, outputOffset, indexSpan ), "Error setArg kernels[ 0 ]" );
+    V_OPENCL( kernels[0].setArg( 5, init ),                   "Error setArg kernels[ 0 ]" ); // Initial value exclusive
+    V_OPENCL( index_set_arg( kernels[0], 6, numElements, indexSpan ),  "Error setArg kernels[ 0 ]" );
+    V_OPENCL( kernels[0].setArg( 7, ldsVals ),                "Error setArg kernels[ 0 ]" ); // Scratch buffer
+    V_OPENCL( kernels[0].setArg( 8, binaryFunctionBuffer ),   "Error setArg kernels[ 0 ]" ); // User provided functor
+    V_OPENCL( kernels[0].setArg( 9, blockVals ),              "Error setArg kernels[ 0 ]" ); // Output per block sum
+    V_OPENCL( kernels[0].setArg( 10, blockFlags ),            "Error setArg kernels[ 0 ]" ); // Output per block flag
+    V_OPENCL( kernels[0].setArg( 11, blockFirstHead ),        "Error setArg kernels[ 0 ]" );
+    V_OPENCL( kernels[0].setArg( 12, doExclusiveScan ),       "Error setArg kernels[ 0 ]" ); // Exclusive scan?
+    V_OPENCL( kernels[0].setArg( 13, carry ? *carry : blockVals ), "Error setArg kernels[ 0 ]" ); // Carry in
+    V_OPENCL( kernels[0].setArg( 14, hasCarry ),              "Error setArg kernels[ 0 ]" );
+    V_OPENCL( kernels[0].setArg( 15, blockBoundaries ),       "Error setArg kernels[ 0 ]" ); // Saved block boundaries
+    segmented_run( ctl, kernels[0], numBlocks, "enqueueNDRangeKernel() failed for kernel[0]" );
+
+    //  A single block has nothing to carry between blocks
+    if( numBlocks == 1 )
+        return;
+
+    /**********************************************************************************
+     *  Kernel 1
+     *********************************************************************************/
+    size_t workPerThread = ( numBlocks + SEGMENTED_WGSIZE - 1 ) / SEGMENTED_WGSIZE;
+    V_OPENCL( kernels[1].setArg( 0, blockVals ),              "Error setArg kernels[ 1 ]" ); // Block sums, in place
+    V_OPENCL( kernels[1].setArg( 1, blockFlags ),             "Error setArg kernels[ 1 ]" );
+    V_OPENCL( index_set_arg( kernels[1], 2, numBlocks, indexSpan ),     "Error setArg kernels[ 1 ]" );
+    V_OPENCL( index_set_arg( kernels[1], 3, workPerThread, indexSpan ), "Error setArg kernels[ 1 ]" );
+    V_OPENCL( kernels[1].setArg( 4, ldsVals ),                "Error setArg kernels[ 1 ]" ); // Scratch buffer
+    V_OPENCL( kernels[1].setArg( 5, binaryFunctionBuffer ),   "Error setArg kernels[ 1 ]" ); // User provided functor
+    segmented_run( ctl, kernels[1], 1, "enqueueNDRangeKernel() failed for kernel[1]" );
+
+    /**********************************************************************************
+     *  Kernel 2
+     *********************************************************************************/
+    V_OPENCL( kernels[2].setArg( 0, output ),                 "Error setArg kernels[ 2 ]" ); // Output
+    V_OPENCL( index_set_arg( kernels[2], 1, outputOffset, indexSpan ), "Error setArg kernels[ 2 ]" );
+    V_OPENCL( index_set_arg( kernels[2], 2, numElements, indexSpan ),  "Error setArg kernels[ 2 ]" );
+    V_OPENCL( kernels[2].setArg( 3, blockVals ),              "Error setArg kernels[ 2 ]" ); // Scanned block sums
+    V_OPENCL( kernels[2].setArg( 4, blockFirstHead ),         "Error setArg kernels[ 2 ]" );
+    V_OPENCL( kernels[2].setArg( 5, binaryFunctionBuffer ),   "Error setArg kernels[ 2 ]" ); // User provided functor
+    segmented_run( ctl, kernels[2], numBlocks, "enqueueNDRangeKernel() failed for kernel[2]" );
+}
+
+/*! \brief Enqueues the total a scanned chunk of numElements elements hands on to the next into carry
+ *  \details lastValue holds a copy of the chunk's last value, read by an exclusive scan only.
+ */
+inline void segmented_scan_carry_out(
+    control &ctl,
+    std::vector< ::cl::Kernel >& kernels,
+    const ::cl::Buffer& binaryFunctionBuffer,
+    const ::cl::Buffer& output,
+    size_t outputOffset,
+    size_t numElements,
+    const ::cl::Buffer& lastValue,
+    const ::cl::Buffer& carry,
+    bool inclusive,
+    size_t indexSpan )
+{
+    cl_int doExclusiveScan = inclusive ? 0 : 1;
+
+    V_OPENCL( kernels[3].setArg( 0, output ),                 "Error setArg kernels[ 3 ]" );
+    V_OPENCL( index_set_arg( kernels[3], 1, outputOffset, indexSpan ), "Error setArg kernels[ 3 ]" );
+    V_OPENCL( index_set_arg( kernels[3], 2, numElements, indexSpan ),  "Error setArg kernels[ 3 ]" );
+    V_OPENCL( kernels[3].setArg( 3, lastValue ),              "Error setArg kernels[ 3 ]" );
+    V_OPENCL( kernels[3].setArg( 4, binaryFunctionBuffer ),   "Error setArg kernels[ 3 ]" );
+    V_OPENCL( kernels[3].setArg( 5, carry ),                  "Error setArg kernels[ 3 ]" );
+    V_OPENCL( kernels[3].setArg( 6, doExclusiveScan ),        "Error setArg kernels[ 3 ]" );
+
+    cl_int l_Error = ctl.getCommandQueue( ).enqueueNDRangeKernel(
+        kernels[3],
+        ::cl::NullRange,
+        ::cl::NDRange( 1 ),
+        ::cl::NDRange( 1 ) );
+    V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for segmentedScanCarryOut" );
+}
+
+/*! \brief Enqueues the segmented scan of numElements values from valueOffset in values, into output from outputOffset
+ *  \details The segments are those of flags, a bitmap of segmented_flag_words( numElements ) words.  An exclusive
+ *  scan starts every segment with init, and an inclusive one ignores init.  The output may be the values themselves.
+ *  Every block of SEGMENTED_WGSIZE elements is scanned on its own, the block totals are scanned by one work group,
+ *  and the elements of a block before its first head then take the total of the blocks before them.
+ */
+template< typename vType, typename oType, typename T, typename BinaryFunction >
+void segmented_scan_enqueue(
+    control &ctl,
+    const ::cl::Buffer& values,
+    size_t valueOffset,
+    size_t numElements,
+    const ::cl::Buffer& flags,
+    const ::cl::Buffer& output,
+    size_t outputOffset,
+    const T& init,
+    const BinaryFunction& binary_funct,
+    const std::string& user_code,
+    bool inclusive,
+    size_t indexSpan )
+{
+    std::vector< ::cl::Kernel > kernels =
+        segmented_scan_get_kernels< vType, oType, T, BinaryFunction >( ctl, user_code, indexSpan );
+
+    size_t numBlocks = segmented_blocks( numElements );
+
+    ALIGNED( 256 ) BinaryFunction aligned_binary_funct( binary_funct );
+    control::buffPointer binaryFunctionBuffer = ctl.acquireBuffer( sizeof( aligned_binary_funct ),
+        CL_MEM_COPY_HOST_PTR|CL_MEM_READ_ONLY, &aligned_binary_funct );
+    control::buffPointer blockVals = ctl.acquireBuffer( numBlocks * sizeof( oType ) );
+    control::buffPointer blockFlags = ctl.acquireBuffer( numBlocks * sizeof( cl_uint ) );
+    control::buffPointer blockFirstHead = ctl.acquireBuffer( numBlocks * sizeof( cl_uint ) );
+    control::buffPointer blockBoundaries = ctl.acquireBuffer( numBlocks * sizeof( vType ) );
+
+    segmented_scan_run< oType >( ctl, kernels, *binaryFunctionBuffer, values, valueOffset, numElements, flags,
+        output, outputOffset, init, *blockVals, *blockFlags, *blockFirstHead, *blockBoundaries, NULL, inclusive,
+        indexSpan );
+}
+
+}
+}
+}
+
+#endif
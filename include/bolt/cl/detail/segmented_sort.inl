@@ -0,0 +1,831 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#pragma once
+#if !defined( BOLT_CL_SEGMENTED_SORT_INL )
+#define BOLT_CL_SEGMENTED_SORT_INL
+
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+#include "bolt/cl/bolt.h"
+#include "bolt/cl/functional.h"
+#include "bolt/cl/device_vector.h"
+#include "bolt/cl/sort.h"
+#include "bolt/cl/sort_by_key.h"
+#include "bolt/cl/detail/index_type.inl"
+#ifdef ENABLE_TBB
+#include "bolt/cl/detail/tbb_arena.inl"
+#include "bolt/cl/detail/tbb_merge_sort.inl"
+#endif
+
+/* \brief - Largest work group of the segmented sort kernels; a work group sorts a tile of twice as many elements */
+#define SEGMENTED_SORT_WGSIZE 256
+/* \brief - On the MultiCoreCpu path, segments at least this long get the parallel sort to themselves */
+#define SEGMENTED_SORT_CPU_LARGE 16384
+
+namespace bolt {
+namespace cl {
+
+    template<typename RandomAccessIterator, typename OffsetIterator>
+    void segmented_sort(control &ctl,
+        RandomAccessIterator first,
+        RandomAccessIterator last,
+        OffsetIterator offsets_first,
+        OffsetIterator offsets_last,
+        const std::string& cl_code)
+    {
+        typedef typename std::iterator_traits< RandomAccessIterator >::value_type T;
+
+        detail::segmented_sort_detect_random_access( ctl, first, last, offsets_first, offsets_last, less< T >( ),
+                                                     cl_code,
+                                                     std::iterator_traits< RandomAccessIterator >::iterator_category( ) );
+    }
+
+    template<typename RandomAccessIterator, typename OffsetIterator>
+    void segmented_sort(RandomAccessIterator first,
+        RandomAccessIterator last,
+        OffsetIterator offsets_first,
+        OffsetIterator offsets_last,
+        const std::string& cl_code)
+    {
+        typedef typename std::iterator_traits< RandomAccessIterator >::value_type T;
+
+        detail::segmented_sort_detect_random_access( control::getDefault( ), first, last, offsets_first, offsets_last,
+                                                     less< T >( ), cl_code,
+                                                     std::iterator_traits< RandomAccessIterator >::iterator_category( ) );
+    }
+
+    template<typename RandomAccessIterator, typename OffsetIterator, typename StrictWeakOrdering>
+    void segmented_sort(control &ctl,
+        RandomAccessIterator first,
+        RandomAccessIterator last,
+        OffsetIterator offsets_first,
+        OffsetIterator offsets_last,
+        StrictWeakOrdering comp,
+        const std::string& cl_code)
+    {
+        detail::segmented_sort_detect_random_access( ctl, first, last, offsets_first, offsets_last, comp, cl_code,
+                                                     std::iterator_traits< RandomAccessIterator >::iterator_category( ) );
+    }
+
+    template<typename RandomAccessIterator, typename OffsetIterator, typename StrictWeakOrdering>
+    void segmented_sort(RandomAccessIterator first,
+        RandomAccessIterator last,
+        OffsetIterator offsets_first,
+        OffsetIterator offsets_last,
+        StrictWeakOrdering comp,
+        const std::string& cl_code)
+    {
+        detail::segmented_sort_detect_random_access( control::getDefault( ), first, last, offsets_first, offsets_last,
+                                                     comp, cl_code,
+                                                     std::iterator_traits< RandomAccessIterator >::iterator_category( ) );
+    }
+
+    template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OffsetIterator>
+    void segmented_sort_by_key(const control &ctl,
+        RandomAccessIterator1 keys_first,
+        RandomAccessIterator1 keys_last,
+        RandomAccessIterator2 values_first,
+        OffsetIterator offsets_first,
+        OffsetIterator offsets_last,
+        const std::string& cl_code)
+    {
+        typedef typename std::iterator_traits< RandomAccessIterator1 >::value_type T;
+
+        detail::segmented_sort_by_key_detect_random_access( ctl, keys_first, keys_last, values_first,
+                                                            offsets_first, offsets_last, less< T >( ), cl_code,
+                                                            std::iterator_traits< RandomAccessIterator1 >::iterator_category( ) );
+    }
+
+    template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OffsetIterator>
+    void segmented_sort_by_key(RandomAccessIterator1 keys_first,
+        RandomAccessIterator1 keys_last,
+        RandomAccessIterator2 values_first,
+        OffsetIterator offsets_first,
+        OffsetIterator offsets_last,
+        const std::string& cl_code)
+    {
+        typedef typename std::iterator_traits< RandomAccessIterator1 >::value_type T;
+
+        detail::segmented_sort_by_key_detect_random_access( control::getDefault( ), keys_first, keys_last,
+                                                            values_first, offsets_first, offsets_last, less< T >( ),
+                                                            cl_code,
+                                                            std::iterator_traits< RandomAccessIterator1 >::iterator_category( ) );
+    }
+
+    template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OffsetIterator,
+             typename StrictWeakOrdering>
+    void segmented_sort_by_key(const control &ctl,
+        RandomAccessIterator1 keys_first,
+        RandomAccessIterator1 keys_last,
+        RandomAccessIterator2 values_first,
+        OffsetIterator offsets_first,
+        OffsetIterator offsets_last,
+        StrictWeakOrdering comp,
+        const std::string& cl_code)
+    {
+        detail::segmented_sort_by_key_detect_random_access( ctl, keys_first, keys_last, values_first,
+                                                            offsets_first, offsets_last, comp, cl_code,
+                                                            std::iterator_traits< RandomAccessIterator1 >::iterator_category( ) );
+    }
+
+    template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OffsetIterator,
+             typename StrictWeakOrdering>
+    void segmented_sort_by_key(RandomAccessIterator1 keys_first,
+        RandomAccessIterator1 keys_last,
+        RandomAccessIterator2 values_first,
+        OffsetIterator offsets_first,
+        OffsetIterator offsets_last,
+        StrictWeakOrdering comp,
+        const std::string& cl_code)
+    {
+        detail::segmented_sort_by_key_detect_random_access( control::getDefault( ), keys_first, keys_last,
+                                                            values_first, offsets_first, offsets_last, comp, cl_code,
+                                                            std::iterator_traits< RandomAccessIterator1 >::iterator_category( ) );
+    }
+
+namespace detail {
+
+    enum segmentedSortTypes { segSort_kValueType, segSort_kIterType, segSort_StrictWeakOrdering, segSort_end };
+
+    class SegmentedSort_KernelTemplateSpecializer : public KernelTemplateSpecializer
+    {
+    public:
+        SegmentedSort_KernelTemplateSpecializer() : KernelTemplateSpecializer()
+        {
+            addKernelName( "segmentedSortTemplate" );
+        }
+
+        const ::std::string operator() ( const ::std::vector< ::std::string >& typeNames ) const
+        {
+            const std::string templateSpecializationString =
+                "// Host generates this instantiation string with user-specified value type and functor\n"
+                "template __attribute__((mangled_name(" + name(0) + "Instantiated)))\n"
+                "kernel void " + name(0) + "(\n"
+                "global " + typeNames[segSort_kValueType] + "* keys_ptr,\n"
+                ""        + typeNames[segSort_kIterType] + " keys_iter,\n"
+                "global uint* offsets,\n"
+                "global uint* tiles,\n"
+                "global " + typeNames[segSort_StrictWeakOrdering] + " * userComp,\n"
+                "local " + typeNames[segSort_kValueType] + "* tileKeys,\n"
+                "local uint* tileSegments\n"
+                ");\n\n";
+            return templateSpecializationString;
+        }
+    };
+
+    enum segmentedSortByKeyTypes { segSortByKey_kValueType, segSortByKey_kIterType, segSortByKey_vValueType,
+                                   segSortByKey_vIterType, segSortByKey_StrictWeakOrdering, segSortByKey_end };
+
+    class SegmentedSortByKey_KernelTemplateSpecializer : public KernelTemplateSpecializer
+    {
+    public:
+        SegmentedSortByKey_KernelTemplateSpecializer() : KernelTemplateSpecializer()
+        {
+            addKernelName( "segmentedSortByKeyTemplate" );
+        }
+
+        const ::std::string operator() ( const ::std::vector< ::std::string >& typeNames ) const
+        {
+            const std::string templateSpecializationString =
+                "// Host generates this instantiation string with user-specified value type and functor\n"
+                "template __attribute__((mangled_name(" + name(0) + "Instantiated)))\n"
+                "kernel void " + name(0) + "(\n"
+                "global " + typeNames[segSortByKey_kValueType] + "* keys_ptr,\n"
+                ""        + typeNames[segSortByKey_kIterType] + " keys_iter,\n"
+                "global " + typeNames[segSortByKey_vValueType] + "* values_ptr,\n"
+                ""        + typeNames[segSortByKey_vIterType] + " values_iter,\n"
+                "global uint* offsets,\n"
+                "global uint* tiles,\n"
+                "global " + typeNames[segSortByKey_StrictWeakOrdering] + " * userComp,\n"
+                "local " + typeNames[segSortByKey_kValueType] + "* tileKeys,\n"
+                "local " + typeNames[segSortByKey_vValueType] + "* tileValues,\n"
+                "local uint* tileSegments\n"
+                ");\n\n";
+            return templateSpecializationString;
+        }
+    };
+
+    /**************************************************************************
+     * Segments
+     *************************************************************************/
+
+    //  Reads the user's offsets into offsets; a device_vector is mapped once rather than read element by element
+    template< typename OffsetIterator >
+    void segmented_sort_read_offsets( OffsetIterator offsets_first, OffsetIterator offsets_last,
+                                      std::vector< cl_uint >& offsets, std::random_access_iterator_tag )
+    {
+        offsets.assign( offsets_first, offsets_last );
+    }
+
+    template< typename OffsetIterator >
+    void segmented_sort_read_offsets( OffsetIterator offsets_first, OffsetIterator offsets_last,
+                                      std::vector< cl_uint >& offsets, bolt::cl::fancy_iterator_tag )
+    {
+        offsets.assign( offsets_first, offsets_last );
+    }
+
+    template< typename OffsetIterator >
+    void segmented_sort_read_offsets( OffsetIterator offsets_first, OffsetIterator offsets_last,
+                                      std::vector< cl_uint >& offsets, bolt::cl::device_vector_tag )
+    {
+        typedef typename std::iterator_traits< OffsetIterator >::value_type oType;
+        size_t numOffsets = static_cast< size_t >( offsets_last - offsets_first );
+        if( numOffsets == 0 )
+            return;
+
+        typename bolt::cl::device_vector< oType >::pointer offsetsPtr = offsets_first.getContainer( ).data( );
+        oType* rangeFirst = &offsetsPtr[ offsets_first.m_Index ];
+        offsets.assign( rangeFirst, rangeFirst + numOffsets );
+    }
+
+    /*! \brief The start of every segment of a range of \p length elements, followed by \p length
+     *  \details A segment starting at 0 is added if the first offset is past it.  Throws if the offsets are not in
+     *  ascending order or run past the range, or if the range is too long for the 32 bit offsets.
+     */
+    template< typename OffsetIterator >
+    std::vector< cl_uint > segmented_sort_offsets( OffsetIterator offsets_first, OffsetIterator offsets_last,
+                                                   size_t length )
+    {
+        index_require_32( length, "segmented_sort() takes ranges of fewer than 2^31 elements" );
+
+        std::vector< cl_uint > offsets;
+        segmented_sort_read_offsets( offsets_first, offsets_last, offsets,
+                                     std::iterator_traits< OffsetIterator >::iterator_category( ) );
+
+        if( offsets.empty( ) || offsets.front( ) != 0 )
+            offsets.insert( offsets.begin( ), 0 );
+        offsets.push_back( static_cast< cl_uint >( length ) );
+
+        for( size_t s = 1; s < offsets.size( ); ++s )
+        {
+            if( offsets[ s ] < offsets[ s - 1 ] )
+                throw ::cl::Error( CL_INVALID_VALUE,
+                                   "segmented_sort offsets must be ascending and within the sorted range" );
+        }
+        return offsets;
+    }
+
+    /*! \brief Packs the segments into tiles for the local kernel
+     *  \details Consecutive segments of at most tileSize elements in total share a tile; tiles holds the first and
+     *  the end segment of each.  Longer segments are listed in largeSegments for the regular device sort.  Tiles
+     *  with fewer than two elements are dropped, since there is nothing to sort in them.
+     */
+    struct segmentedSortPlan
+    {
+        std::vector< cl_uint > tiles;
+        std::vector< size_t > largeSegments;
+
+        segmentedSortPlan( const std::vector< cl_uint >& offsets, size_t tileSize )
+        {
+            size_t numSegments = offsets.size( ) - 1;
+            size_t tileFirst = 0;
+            size_t tileLength = 0;
+            for( size_t s = 0; s < numSegments; ++s )
+            {
+                size_t segLength = offsets[ s + 1 ] - offsets[ s ];
+                if( segLength > tileSize )
+                {
+                    closeTile( tileFirst, s, tileLength );
+                    largeSegments.push_back( s );
+                    tileFirst = s + 1;
+                    tileLength = 0;
+                }
+                else if( tileLength + segLength > tileSize )
+                {
+                    closeTile( tileFirst, s, tileLength );
+                    tileFirst = s;
+                    tileLength = segLength;
+                }
+                else
+                {
+                    tileLength += segLength;
+                }
+            }
+            closeTile( tileFirst, numSegments, tileLength );
+        }
+
+        size_t numTiles( ) const { return tiles.size( ) / 2; }
+
+    private:
+        void closeTile( size_t segFirst, size_t segLast, size_t tileLength )
+        {
+            if( tileLength < 2 )
+                return;
+            tiles.push_back( static_cast< cl_uint >( segFirst ) );
+            tiles.push_back( static_cast< cl_uint >( segLast ) );
+        }
+    };
+
+    //  Work group size of the local kernel: a tile of 2 * wgSize elements of elementSize bytes, with their segments,
+    //  has to fit the device's local memory
+    inline size_t segmented_sort_wg_size( const control& ctl, const ::cl::Kernel& kernel, size_t elementSize )
+    {
+        cl_int l_Error = CL_SUCCESS;
+        size_t maxWgSize = kernel.getWorkGroupInfo< CL_KERNEL_WORK_GROUP_SIZE >( ctl.getDevice( ), &l_Error );
+        V_OPENCL( l_Error, "Error querying kernel for CL_KERNEL_WORK_GROUP_SIZE" );
+        cl_ulong localMemSize = ctl.getDevice( ).getInfo< CL_DEVICE_LOCAL_MEM_SIZE >( &l_Error );
+        V_OPENCL( l_Error, "Error querying device for CL_DEVICE_LOCAL_MEM_SIZE" );
+
+        size_t wgSize = SEGMENTED_SORT_WGSIZE;
+        while( wgSize > 1 && ( wgSize > maxWgSize || 2 * wgSize * ( elementSize + sizeof( cl_uint ) ) > localMemSize ) )
+            wgSize >>= 1;
+        return wgSize;
+    }
+
+    /**************************************************************************
+     * CPU paths
+     *************************************************************************/
+
+    template< typename T, typename StrictWeakOrdering >
+    void serial_segmented_sort( T* first, const std::vector< cl_uint >& offsets, const StrictWeakOrdering& comp )
+    {
+        for( size_t s = 0; s + 1 < offsets.size( ); ++s )
+            std::sort( first + offsets[ s ], first + offsets[ s + 1 ], comp );
+    }
+
+    template< typename Key, typename Value, typename StrictWeakOrdering >
+    void serial_segmented_sort_by_key( Key* keys, Value* values, const std::vector< cl_uint >& offsets,
+                                       const StrictWeakOrdering& comp )
+    {
+        for( size_t s = 0; s + 1 < offsets.size( ); ++s )
+            serial_sort_by_key( keys + offsets[ s ], keys + offsets[ s + 1 ], values + offsets[ s ], comp );
+    }
+
+#ifdef ENABLE_TBB
+    //  Sorts the segments of a range of segment indices, leaving the ones at least SEGMENTED_SORT_CPU_LARGE long
+    template< typename Key, typename Value, typename StrictWeakOrdering >
+    struct tbbSegmentedSort
+    {
+        Key* keys;
+        Value* values;
+        const cl_uint* offsets;
+        StrictWeakOrdering comp;
+
+        tbbSegmentedSort( Key* _keys, Value* _values, const cl_uint* _offsets, const StrictWeakOrdering& _comp ):
+            keys( _keys ), values( _values ), offsets( _offsets ), comp( _comp )
+        {}
+
+        void operator( )( const tbb::blocked_range< size_t >& segments ) const
+        {
+            StrictWeakOrdering localComp( comp );
+            for( size_t s = segments.begin( ); s != segments.end( ); ++s )
+            {
+                if( offsets[ s + 1 ] - offsets[ s ] >= SEGMENTED_SORT_CPU_LARGE )
+                    continue;
+                if( values )
+                    serial_sort_by_key( keys + offsets[ s ], keys + offsets[ s + 1 ], values + offsets[ s ], localComp );
+                else
+                    std::sort( keys + offsets[ s ], keys + offsets[ s + 1 ], localComp );
+            }
+        }
+    };
+
+    /*! \brief Sorts every segment in the arena of \p ctl; \p values is NULL for a sort without values
+     *  \details Short segments are shared out among the workers; each long one is sorted by all of them in turn.
+     */
+    template< typename Key, typename Value, typename StrictWeakOrdering >
+    void tbb_segmented_sort( const control& ctl, Key* keys, Value* values, const std::vector< cl_uint >& offsets,
+                             const StrictWeakOrdering& comp )
+    {
+        size_t numSegments = offsets.size( ) - 1;
+        control::tbbPartitionDesc part = ctl.getTbbPartitioner( "segmented_sort" );
+        tbb_parallel_for( ctl, tbb::blocked_range< size_t >( 0, numSegments, part.grainSize ),
+                          tbbSegmentedSort< Key, Value, StrictWeakOrdering >( keys, values, &offsets[ 0 ], comp ),
+                          part.partitioner );
+
+        for( size_t s = 0; s < numSegments; ++s )
+        {
+            if( offsets[ s + 1 ] - offsets[ s ] < SEGMENTED_SORT_CPU_LARGE )
+                continue;
+            if( values )
+                tbb_parallel_sort_by_key( ctl, keys + offsets[ s ], keys + offsets[ s + 1 ], values + offsets[ s ], comp );
+            else
+                tbb_parallel_sort( ctl, keys + offsets[ s ], keys + offsets[ s + 1 ], comp );
+        }
+    }
+#endif
+
+    /**************************************************************************
+     * OpenCL paths
+     *************************************************************************/
+
+    template< typename DVRandomAccessIterator, typename StrictWeakOrdering >
+    void segmented_sort_enqueue( control& ctl, const DVRandomAccessIterator& first, const DVRandomAccessIterator& last,
+                                 const std::vector< cl_uint >& offsets, const StrictWeakOrdering& comp,
+                                 const std::string& cl_code )
+    {
+        typedef typename std::iterator_traits< DVRandomAccessIterator >::value_type T;
+
+        std::vector< std::string > typeNames( segSort_end );
+        typeNames[ segSort_kValueType ] = TypeName< T >::get( );
+        typeNames[ segSort_kIterType ] = TypeName< DVRandomAccessIterator >::get( );
+        typeNames[ segSort_StrictWeakOrdering ] = TypeName< StrictWeakOrdering >::get( );
+
+        std::vector< std::string > typeDefinitions;
+        PUSH_BACK_UNIQUE( typeDefinitions, ClCode< T >::get( ) )
+        PUSH_BACK_UNIQUE( typeDefinitions, ClCode< DVRandomAccessIterator >::get( ) )
+        PUSH_BACK_UNIQUE( typeDefinitions, ClCode< StrictWeakOrdering >::get( ) )
+
+        std::string compileOptions;
+        SegmentedSort_KernelTemplateSpecializer ss_kts;
+        std::vector< ::cl::Kernel > kernels = bolt::cl::getKernels(
+            ctl,
+            typeNames,
+            &ss_kts,
+            typeDefinitions,
+            segmented_sort_kernels + cl_code,
+            compileOptions );
+
+        size_t wgSize = segmented_sort_wg_size( ctl, kernels[ 0 ], sizeof( T ) );
+        segmentedSortPlan plan( offsets, 2 * wgSize );
+
+        //  Every short segment, in one launch
+        if( plan.numTiles( ) > 0 )
+        {
+            cl_int l_Error = CL_SUCCESS;
+            ::cl::Buffer offsetsBuffer( ctl.getContext( ), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                        offsets.size( ) * sizeof( cl_uint ), const_cast< cl_uint* >( &offsets[ 0 ] ),
+                                        &l_Error );
+            V_OPENCL( l_Error, "Error creating the segmented_sort offsets buffer" );
+            ::cl::Buffer tilesBuffer( ctl.getContext( ), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                      plan.tiles.size( ) * sizeof( cl_uint ), &plan.tiles[ 0 ], &l_Error );
+            V_OPENCL( l_Error, "Error creating the segmented_sort tiles buffer" );
+
+            ALIGNED( 256 ) StrictWeakOrdering aligned_comp( comp );
+            control::buffPointer userFunctor = ctl.acquireBuffer( sizeof( aligned_comp ),
+                                                                  CL_MEM_USE_HOST_PTR|CL_MEM_READ_ONLY, &aligned_comp );
+
+            V_OPENCL( kernels[ 0 ].setArg( 0, first.getBuffer( ) ), "Error setting a kernel argument" );
+            V_OPENCL( kernels[ 0 ].setArg( 1, first.gpuPayloadSize( ), &first.gpuPayload( ) ),
+                      "Error setting a kernel argument" );
+            V_OPENCL( kernels[ 0 ].setArg( 2, offsetsBuffer ), "Error setting a kernel argument" );
+            V_OPENCL( kernels[ 0 ].setArg( 3, tilesBuffer ), "Error setting a kernel argument" );
+            V_OPENCL( kernels[ 0 ].setArg( 4, *userFunctor ), "Error setting a kernel argument" );
+            V_OPENCL( kernels[ 0 ].setArg( 5, 2 * wgSize * sizeof( T ), NULL ), "Error setting a kernel argument" );
+            V_OPENCL( kernels[ 0 ].setArg( 6, 2 * wgSize * sizeof( cl_uint ), NULL ), "Error setting a kernel argument" );
+
+            l_Error = ctl.getCommandQueue( ).enqueueNDRangeKernel( kernels[ 0 ], ::cl::NullRange,
+                                                                   ::cl::NDRange( plan.numTiles( ) * wgSize ),
+                                                                   ::cl::NDRange( wgSize ), NULL, NULL );
+            V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for segmented_sort() kernel" );
+        }
+
+        //  Segments longer than a tile amortize the launches of a sort of their own
+        for( size_t l = 0; l < plan.largeSegments.size( ); ++l )
+        {
+            size_t s = plan.largeSegments[ l ];
+            sort_enqueue( ctl, first + static_cast< std::ptrdiff_t >( offsets[ s ] ),
+                          first + static_cast< std::ptrdiff_t >( offsets[ s + 1 ] ), comp, cl_code );
+        }
+
+        ::cl::Event segmentedSortEvent;
+        V_OPENCL( ctl.getCommandQueue( ).clEnqueueBarrierWithWaitList( NULL, &segmentedSortEvent ),
+                  "Error calling clEnqueueBarrierWithWaitList on the command queue" );
+        bolt::cl::wait( ctl, segmentedSortEvent, "segmented_sort" );
+    }
+
+    template< typename DVRandomAccessIterator1, typename DVRandomAccessIterator2, typename StrictWeakOrdering >
+    void segmented_sort_by_key_enqueue( const control& ctl, const DVRandomAccessIterator1& keys_first,
+                                        const DVRandomAccessIterator1& keys_last,
+                                        const DVRandomAccessIterator2& values_first,
+                                        const std::vector< cl_uint >& offsets, const StrictWeakOrdering& comp,
+                                        const std::string& cl_code )
+    {
+        typedef typename std::iterator_traits< DVRandomAccessIterator1 >::value_type T_keys;
+        typedef typename std::iterator_traits< DVRandomAccessIterator2 >::value_type T_values;
+
+        std::vector< std::string > typeNames( segSortByKey_end );
+        typeNames[ segSortByKey_kValueType ] = TypeName< T_keys >::get( );
+        typeNames[ segSortByKey_kIterType ] = TypeName< DVRandomAccessIterator1 >::get( );
+        typeNames[ segSortByKey_vValueType ] = TypeName< T_values >::get( );
+        typeNames[ segSortByKey_vIterType ] = TypeName< DVRandomAccessIterator2 >::get( );
+        typeNames[ segSortByKey_StrictWeakOrdering ] = TypeName< StrictWeakOrdering >::get( );
+
+        std::vector< std::string > typeDefinitions;
+        PUSH_BACK_UNIQUE( typeDefinitions, ClCode< T_keys >::get( ) )
+        PUSH_BACK_UNIQUE( typeDefinitions, ClCode< T_values >::get( ) )
+        PUSH_BACK_UNIQUE( typeDefinitions, ClCode< DVRandomAccessIterator1 >::get( ) )
+        PUSH_BACK_UNIQUE( typeDefinitions, ClCode< DVRandomAccessIterator2 >::get( ) )
+        PUSH_BACK_UNIQUE( typeDefinitions, ClCode< StrictWeakOrdering >::get( ) )
+
+        std::string compileOptions;
+        SegmentedSortByKey_KernelTemplateSpecializer ss_kts;
+        std::vector< ::cl::Kernel > kernels = bolt::cl::getKernels(
+            ctl,
+            typeNames,
+            &ss_kts,
+            typeDefinitions,
+            segmented_sort_kernels + cl_code,
+            compileOptions );
+
+        size_t wgSize = segmented_sort_wg_size( ctl, kernels[ 0 ], sizeof( T_keys ) + sizeof( T_values ) );
+        segmentedSortPlan plan( offsets, 2 * wgSize );
+
+        if( plan.numTiles( ) > 0 )
+        {
+            cl_int l_Error = CL_SUCCESS;
+            ::cl::Buffer offsetsBuffer( ctl.getContext( ), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                        offsets.size( ) * sizeof( cl_uint ), const_cast< cl_uint* >( &offsets[ 0 ] ),
+                                        &l_Error );
+            V_OPENCL( l_Error, "Error creating the segmented_sort_by_key offsets buffer" );
+            ::cl::Buffer tilesBuffer( ctl.getContext( ), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                      plan.tiles.size( ) * sizeof( cl_uint ), &plan.tiles[ 0 ], &l_Error );
+            V_OPENCL( l_Error, "Error creating the segmented_sort_by_key tiles buffer" );
+            ::cl::Buffer userFunctor( ctl.getContext( ), CL_MEM_USE_HOST_PTR, sizeof( comp ), (void*)&comp );
+
+            V_OPENCL( kernels[ 0 ].setArg( 0, keys_first.getBuffer( ) ), "Error setting a kernel argument" );
+            V_OPENCL( kernels[ 0 ].setArg( 1, keys_first.gpuPayloadSize( ), &keys_first.gpuPayload( ) ),
+                      "Error setting a kernel argument" );
+            V_OPENCL( kernels[ 0 ].setArg( 2, values_first.getBuffer( ) ), "Error setting a kernel argument" );
+            V_OPENCL( kernels[ 0 ].setArg( 3, values_first.gpuPayloadSize( ), &values_first.gpuPayload( ) ),
+                      "Error setting a kernel argument" );
+            V_OPENCL( kernels[ 0 ].setArg( 4, offsetsBuffer ), "Error setting a kernel argument" );
+            V_OPENCL( kernels[ 0 ].setArg( 5, tilesBuffer ), "Error setting a kernel argument" );
+            V_OPENCL( kernels[ 0 ].setArg( 6, userFunctor ), "Error setting a kernel argument" );
+            V_OPENCL( kernels[ 0 ].setArg( 7, 2 * wgSize * sizeof( T_keys ), NULL ), "Error setting a kernel argument" );
+            V_OPENCL( kernels[ 0 ].setArg( 8, 2 * wgSize * sizeof( T_values ), NULL ), "Error setting a kernel argument" );
+            V_OPENCL( kernels[ 0 ].setArg( 9, 2 * wgSize * sizeof( cl_uint ), NULL ), "Error setting a kernel argument" );
+
+            l_Error = ctl.getCommandQueue( ).enqueueNDRangeKernel( kernels[ 0 ], ::cl::NullRange,
+                                                                   ::cl::NDRange( plan.numTiles( ) * wgSize ),
+                                                                   ::cl::NDRange( wgSize ), NULL, NULL );
+            V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for segmented_sort_by_key() kernel" );
+        }
+
+        for( size_t l = 0; l < plan.largeSegments.size( ); ++l )
+        {
+            size_t s = plan.largeSegments[ l ];
+            sort_by_key_enqueue( ctl, keys_first + static_cast< std::ptrdiff_t >( offsets[ s ] ),
+                                 keys_first + static_cast< std::ptrdiff_t >( offsets[ s + 1 ] ),
+                                 values_first + static_cast< std::ptrdiff_t >( offsets[ s ] ), comp, cl_code );
+        }
+
+        ::cl::Event segmentedSortEvent;
+        V_OPENCL( ctl.getCommandQueue( ).clEnqueueBarrierWithWaitList( NULL, &segmentedSortEvent ),
+                  "Error calling clEnqueueBarrierWithWaitList on the command queue" );
+        bolt::cl::wait( ctl, segmentedSortEvent, "segmented_sort_by_key" );
+    }
+
+    /**************************************************************************
+     * Dispatch
+     *************************************************************************/
+
+    template< typename RandomAccessIterator, typename OffsetIterator, typename StrictWeakOrdering >
+    void segmented_sort_detect_random_access( control& ctl, const RandomAccessIterator& first,
+                                              const RandomAccessIterator& last, const OffsetIterator& offsets_first,
+                                              const OffsetIterator& offsets_last, const StrictWeakOrdering& comp,
+                                              const std::string& cl_code, std::input_iterator_tag )
+    {
+        static_assert( false, "Bolt only supports random access iterator types" );
+    }
+
+    template< typename RandomAccessIterator, typename OffsetIterator, typename StrictWeakOrdering >
+    void segmented_sort_detect_random_access( control& ctl, const RandomAccessIterator& first,
+                                              const RandomAccessIterator& last, const OffsetIterator& offsets_first,
+                                              const OffsetIterator& offsets_last, const StrictWeakOrdering& comp,
+                                              const std::string& cl_code, std::random_access_iterator_tag )
+    {
+        size_t length = static_cast< size_t >( std::distance( first, last ) );
+        if( length < 2 )
+            return;
+
+        std::vector< cl_uint > offsets = segmented_sort_offsets( offsets_first, offsets_last, length );
+        segmented_sort_pick_iterator( ctl, first, last, offsets, comp, cl_code,
+                                      std::iterator_traits< RandomAccessIterator >::iterator_category( ) );
+    }
+
+    template< typename DVRandomAccessIterator, typename StrictWeakOrdering >
+    void segmented_sort_pick_iterator( control& ctl, const DVRandomAccessIterator& first,
+                                       const DVRandomAccessIterator& last, const std::vector< cl_uint >& offsets,
+                                       const StrictWeakOrdering& comp, const std::string& cl_code,
+                                       bolt::cl::fancy_iterator_tag )
+    {
+        static_assert( false, "It is not possible to sort fancy iterators. They are not mutable" );
+    }
+
+    template< typename RandomAccessIterator, typename StrictWeakOrdering >
+    void segmented_sort_pick_iterator( control& ctl, const RandomAccessIterator& first,
+                                       const RandomAccessIterator& last, const std::vector< cl_uint >& offsets,
+                                       const StrictWeakOrdering& comp, const std::string& cl_code,
+                                       std::random_access_iterator_tag )
+    {
+        typedef typename std::iterator_traits< RandomAccessIterator >::value_type T;
+
+        bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode( );
+        if( runMode == bolt::cl::control::Automatic )
+        {
+            runMode = ctl.getDefaultPathToRun( );
+        }
+
+        if( runMode == bolt::cl::control::SerialCpu )
+        {
+            serial_segmented_sort( &*first, offsets, comp );
+        }
+        else if( runMode == bolt::cl::control::MultiCoreCpu )
+        {
+#ifdef ENABLE_TBB
+            tbb_segmented_sort( ctl, &*first, static_cast< T* >( NULL ), offsets, comp );
+#else
+            throw ::cl::Error( CL_INVALID_OPERATION,
+                               "The MultiCoreCpu version of segmented_sort is not enabled to be built." );
+#endif
+        }
+        else
+        {
+            device_vector< T > dvInputOutput( first, last, CL_MEM_USE_HOST_PTR | CL_MEM_READ_WRITE, ctl );
+            segmented_sort_enqueue( ctl, dvInputOutput.begin( ), dvInputOutput.end( ), offsets, comp, cl_code );
+            dvInputOutput.data( );
+        }
+    }
+
+    template< typename DVRandomAccessIterator, typename StrictWeakOrdering >
+    void segmented_sort_pick_iterator( control& ctl, const DVRandomAccessIterator& first,
+                                       const DVRandomAccessIterator& last, const std::vector< cl_uint >& offsets,
+                                       const StrictWeakOrdering& comp, const std::string& cl_code,
+                                       bolt::cl::device_vector_tag )
+    {
+        typedef typename std::iterator_traits< DVRandomAccessIterator >::value_type T;
+
+        bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode( );
+        if( runMode == bolt::cl::control::Automatic )
+        {
+            runMode = ctl.getDefaultPathToRun( );
+        }
+
+        if( runMode == bolt::cl::control::SerialCpu || runMode == bolt::cl::control::MultiCoreCpu )
+        {
+            typename bolt::cl::device_vector< T >::pointer firstPtr = first.getContainer( ).data( );
+            T* rangeFirst = &firstPtr[ first.m_Index ];
+
+            if( runMode == bolt::cl::control::SerialCpu )
+            {
+                serial_segmented_sort( rangeFirst, offsets, comp );
+            }
+            else
+            {
+#ifdef ENABLE_TBB
+                tbb_segmented_sort( ctl, rangeFirst, static_cast< T* >( NULL ), offsets, comp );
+#else
+                throw ::cl::Error( CL_INVALID_OPERATION,
+                                   "The MultiCoreCpu version of segmented_sort is not enabled to be built." );
+#endif
+            }
+        }
+        else
+        {
+            segmented_sort_enqueue( ctl, first, last, offsets, comp, cl_code );
+        }
+    }
+
+    template< typename RandomAccessIterator1, typename RandomAccessIterator2, typename OffsetIterator,
+              typename StrictWeakOrdering >
+    void segmented_sort_by_key_detect_random_access( const control& ctl, const RandomAccessIterator1& keys_first,
+                                                     const RandomAccessIterator1& keys_last,
+                                                     const RandomAccessIterator2& values_first,
+                                                     const OffsetIterator& offsets_first,
+                                                     const OffsetIterator& offsets_last,
+                                                     const StrictWeakOrdering& comp, const std::string& cl_code,
+                                                     std::input_iterator_tag )
+    {
+        static_assert( false, "Bolt only supports random access iterator types" );
+    }
+
+    template< typename RandomAccessIterator1, typename RandomAccessIterator2, typename OffsetIterator,
+              typename StrictWeakOrdering >
+    void segmented_sort_by_key_detect_random_access( const control& ctl, const RandomAccessIterator1& keys_first,
+                                                     const RandomAccessIterator1& keys_last,
+                                                     const RandomAccessIterator2& values_first,
+                                                     const OffsetIterator& offsets_first,
+                                                     const OffsetIterator& offsets_last,
+                                                     const StrictWeakOrdering& comp, const std::string& cl_code,
+                                                     std::random_access_iterator_tag )
+    {
+        size_t length = static_cast< size_t >( std::distance( keys_first, keys_last ) );
+        if( length < 2 )
+            return;
+
+        std::vector< cl_uint > offsets = segmented_sort_offsets( offsets_first, offsets_last, length );
+        segmented_sort_by_key_pick_iterator( ctl, keys_first, keys_last, values_first, offsets, comp, cl_code,
+                                             std::iterator_traits< RandomAccessIterator1 >::iterator_category( ) );
+    }
+
+    template< typename DVRandomAccessIterator1, typename DVRandomAccessIterator2, typename StrictWeakOrdering >
+    void segmented_sort_by_key_pick_iterator( const control& ctl, const DVRandomAccessIterator1& keys_first,
+                                              const DVRandomAccessIterator1& keys_last,
+                                              const DVRandomAccessIterator2& values_first,
+                                              const std::vector< cl_uint >& offsets,
+                                              const StrictWeakOrdering& comp, const std::string& cl_code,
+                                              bolt::cl::fancy_iterator_tag )
+    {
+        static_assert( false, "It is not possible to sort fancy iterators. They are not mutable" );
+    }
+
+    template< typename RandomAccessIterator1, typename RandomAccessIterator2, typename StrictWeakOrdering >
+    void segmented_sort_by_key_pick_iterator( const control& ctl, const RandomAccessIterator1& keys_first,
+                                              const RandomAccessIterator1& keys_last,
+                                              const RandomAccessIterator2& values_first,
+                                              const std::vector< cl_uint >& offsets,
+                                              const StrictWeakOrdering& comp, const std::string& cl_code,
+                                              std::random_access_iterator_tag )
+    {
+        typedef typename std::iterator_traits< RandomAccessIterator1 >::value_type T_keys;
+        typedef typename std::iterator_traits< RandomAccessIterator2 >::value_type T_values;
+        size_t length = static_cast< size_t >( keys_last - keys_first );
+
+        bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode( );
+        if( runMode == bolt::cl::control::Automatic )
+        {
+            runMode = ctl.getDefaultPathToRun( );
+        }
+
+        if( runMode == bolt::cl::control::SerialCpu )
+        {
+            serial_segmented_sort_by_key( &*keys_first, &*values_first, offsets, comp );
+        }
+        else if( runMode == bolt::cl::control::MultiCoreCpu )
+        {
+#ifdef ENABLE_TBB
+            tbb_segmented_sort( ctl, &*keys_first, &*values_first, offsets, comp );
+#else
+            throw ::cl::Error( CL_INVALID_OPERATION,
+                               "The MultiCoreCpu version of segmented_sort_by_key is not enabled to be built." );
+#endif
+        }
+        else
+        {
+            device_vector< T_keys > dvKeys( keys_first, keys_last, CL_MEM_USE_HOST_PTR | CL_MEM_READ_WRITE, ctl );
+            device_vector< T_values > dvValues( values_first, length, CL_MEM_USE_HOST_PTR | CL_MEM_READ_WRITE, true,
+                                                ctl );
+            segmented_sort_by_key_enqueue( ctl, dvKeys.begin( ), dvKeys.end( ), dvValues.begin( ), offsets, comp,
+                                           cl_code );
+            dvKeys.data( );
+            dvValues.data( );
+        }
+    }
+
+    template< typename DVRandomAccessIterator1, typename DVRandomAccessIterator2, typename StrictWeakOrdering >
+    void segmented_sort_by_key_pick_iterator( const control& ctl, const DVRandomAccessIterator1& keys_first,
+                                              const DVRandomAccessIterator1& keys_last,
+                                              const DVRandomAccessIterator2& values_first,
+                                              const std::vector< cl_uint >& offsets,
+                                              const StrictWeakOrdering& comp, const std::string& cl_code,
+                                              bolt::cl::device_vector_tag )
+    {
+        typedef typename std::iterator_traits< DVRandomAccessIterator1 >::value_type T_keys;
+        typedef typename std::iterator_traits< DVRandomAccessIterator2 >::value_type T_values;
+
+        bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode( );
+        if( runMode == bolt::cl::control::Automatic )
+        {
+            runMode = ctl.getDefaultPathToRun( );
+        }
+
+        if( runMode == bolt::cl::control::SerialCpu || runMode == bolt::cl::control::MultiCoreCpu )
+        {
+            typename bolt::cl::device_vector< T_keys >::pointer keysPtr = keys_first.getContainer( ).data( );
+            typename bolt::cl::device_vector< T_values >::pointer valuesPtr = values_first.getContainer( ).data( );
+            T_keys* keysRangeFirst = &keysPtr[ keys_first.m_Index ];
+            T_values* valuesRangeFirst = &valuesPtr[ values_first.m_Index ];
+
+            if( runMode == bolt::cl::control::SerialCpu )
+            {
+                serial_segmented_sort_by_key( keysRangeFirst, valuesRangeFirst, offsets, comp );
+            }
+            else
+            {
+#ifdef ENABLE_TBB
+                tbb_segmented_sort( ctl, keysRangeFirst, valuesRangeFirst, offsets, comp );
+#else
+                throw ::cl::Error( CL_INVALID_OPERATION,
+                                   "The MultiCoreCpu version of segmented_sort_by_key is not enabled to be built." );
+#endif
+            }
+        }
+        else
+        {
+            segmented_sort_by_key_enqueue( ctl, keys_first, keys_last, values_first, offsets, comp, cl_code );
+        }
+    }
+
+}//namespace bolt::cl::detail
+}//namespace bolt::cl
+}//namespace bolt
+
+#endif
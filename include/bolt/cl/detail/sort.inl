@@ -25,17 +25,16 @@
 #include "bolt/cl/scan.h"
 #include "bolt/cl/functional.h"
 #include "bolt/cl/device_vector.h"
+#include "bolt/cl/detail/radix_sort.inl"
+#include "bolt/cl/detail/index_type.inl"
 #ifdef ENABLE_TBB
 #include "tbb/parallel_sort.h"
-#include "tbb/task_scheduler_init.h"
+#include "bolt/cl/detail/tbb_arena.inl"
 #endif
 
-#define BOLT_UINT_MAX 0xFFFFFFFFU
-#define BOLT_UINT_MIN 0x0U
-#define BOLT_INT_MAX 0x7FFFFFFF
-#define BOLT_INT_MIN 0x80000000
-
 #define BITONIC_SORT_WGSIZE 64
+/* \brief - Largest work group of the local memory bitonic kernel; it sorts tiles of twice this many elements */
+#define BITONIC_SORT_LOCAL_WGSIZE 256
 /* \brief - SORT_CPU_THRESHOLD should be atleast 2 times the BITONIC_SORT_WGSIZE*/
 #define SORT_CPU_THRESHOLD 128
 
@@ -112,6 +111,7 @@ public:
     BitonicSort_KernelTemplateSpecializer() : KernelTemplateSpecializer()
     {
         addKernelName("BitonicSortTemplate");
+        addKernelName("BitonicSortLocalTemplate");
     }
 
     const ::std::string operator() ( const ::std::vector<::std::string>& typeNames ) const
@@ -125,186 +125,53 @@ public:
             ""        + typeNames[sort_iIterType]  + " input_iter,\n"
             "const uint stage,\n"
             "const uint passOfStage,\n"
+            "const uint length,\n"
             "global " + typeNames[sort_StrictWeakOrdering] + " * userComp\n"
-            ");\n\n";
-            return templateSpecializationString;
-        }
-};
-
-class SelectionSort_KernelTemplateSpecializer : public KernelTemplateSpecializer
-{
-public:
-    SelectionSort_KernelTemplateSpecializer() : KernelTemplateSpecializer()
-    {
-        addKernelName("selectionSortLocalTemplate");
-        addKernelName("selectionSortFinalTemplate");
-    }
-
-    const ::std::string operator() ( const ::std::vector<::std::string>& typeNames ) const
-    {
-        const std::string templateSpecializationString =
-
-            "\n// Host generates this instantiation string with user-specified value type and functor\n"
-            "template __attribute__((mangled_name(" + name(0) + "Instantiated)))\n"
-            "kernel void selectionSortLocalTemplate(\n"
-            "global const " + typeNames[sort_iValueType] + " * in,\n"
-            "global " + typeNames[sort_iValueType] + " * out,\n"
-            "global " + typeNames[sort_StrictWeakOrdering] + " * userComp,\n"
-            "local  " + typeNames[sort_iValueType] + " * scratch,\n"
-            "const int buffSize\n"
             ");\n\n"
-            "\n// Host generates this instantiation string with user-specified value type and functor\n"
+            "// Host generates this instantiation string with user-specified value type and functor\n"
             "template __attribute__((mangled_name(" + name(1) + "Instantiated)))\n"
-            "kernel void selectionSortFinalTemplate(\n"
-            "global const " + typeNames[sort_iValueType] + " * in,\n"
-            "global " + typeNames[sort_iValueType] + " * out,\n"
+            "kernel void BitonicSortLocalTemplate(\n"
+            "global " + typeNames[sort_iValueType] + "* A,\n"
+            ""        + typeNames[sort_iIterType]  + " input_iter,\n"
+            "const uint stage,\n"
+            "const uint passOfStage,\n"
+            "const uint lastStage,\n"
+            "const uint length,\n"
             "global " + typeNames[sort_StrictWeakOrdering] + " * userComp,\n"
-            "local  " + typeNames[sort_iValueType] + " * scratch,\n"
-            "const int buffSize\n"
-            ");\n\n";
-        return templateSpecializationString;
-    }
-};
-
-class RadixSort_Int_KernelTemplateSpecializer : public KernelTemplateSpecializer
-{
-private:
-    int _radix;
-public:
-    RadixSort_Int_KernelTemplateSpecializer(int radix) : KernelTemplateSpecializer()
-    {
-        _radix = radix;
-        addKernelName("histogramAscendingRadixNTemplate");
-        addKernelName("histogramDescendingRadixNTemplate");
-        addKernelName("permuteAscendingRadixNTemplate");
-        addKernelName("permuteDescendingRadixNTemplate");
-        addKernelName("histogramSignedDescendingRadixNTemplate");
-        addKernelName("histogramSignedAscendingRadixNTemplate");
-        addKernelName("permuteSignedDescendingRadixNTemplate");
-        addKernelName("permuteSignedAscendingRadixNTemplate");
-    }
-
-    const ::std::string operator() ( const ::std::vector<::std::string>& typeNames ) const
-    {
-        std::stringstream radixStream;
-        radixStream << _radix;
-        const std::string templateSpecializationString =
-
-            "// Host generates this instantiation string with user-specified value type and functor\n"
-            "\ntemplate __attribute__((mangled_name(" + name(0) + "Instantiated)))\n"
-            "void histogramAscendingRadixNTemplate< " +radixStream.str()+ " >(__global uint* unsortedData,\n"
-            "global uint* buckets,\n"
-            "uint shiftCount\n"
-            ");\n"
-            "\n"
-            "\n"
-            "template __attribute__((mangled_name(" + name(2) + "Instantiated)))\n"
-            "void permuteAscendingRadixNTemplate< " +radixStream.str()+ " >(__global uint* unsortedData,\n"
-            "global uint* scanedBuckets,\n"
-            "uint shiftCount,\n"
-            "global uint* sortedData\n"
-            ");\n"
-            "\n"
-            "\n"
-            "\ntemplate __attribute__((mangled_name(" + name(4) + "Instantiated)))\n"
-            "void histogramSignedDescendingRadixNTemplate< " +radixStream.str()+ " >(__global uint* unsortedData,\n"
-            "global uint* buckets,\n"
-            "uint shiftCount\n"
-            ");\n"
-            "\n"
-            "\n"
-            "template __attribute__((mangled_name(" + name(6) + "Instantiated)))\n"
-            "void permuteSignedDescendingRadixNTemplate< " +radixStream.str()+ " >(__global uint* unsortedData,\n"
-            "global uint* scanedBuckets,\n"
-            "uint shiftCount,\n"
-            "global uint* sortedData\n"
-            ");\n\n"
-            "// Host generates this instantiation string with user-specified value type and functor\n"
-            "\ntemplate __attribute__((mangled_name(" + name(1) + "Instantiated)))\n"
-            "void histogramDescendingRadixNTemplate< " +radixStream.str()+ " >(__global uint* unsortedData,\n"
-            "global uint* buckets,\n"
-            "uint shiftCount\n"
-            ");\n"
-            "\n"
-            "\n"
-            "template __attribute__((mangled_name(" + name(3) + "Instantiated)))\n"
-            "void permuteDescendingRadixNTemplate< " +radixStream.str()+ " >(__global uint* unsortedData,\n"
-            "global uint* scanedBuckets,\n"
-            "uint shiftCount,\n"
-            "global uint* sortedData\n"
-            ");\n\n"
-            "\n"
-            "\n"
-            "\ntemplate __attribute__((mangled_name(" + name(5) + "Instantiated)))\n"
-            "void histogramSignedAscendingRadixNTemplate< " +radixStream.str()+ " >(__global uint* unsortedData,\n"
-            "global uint* buckets,\n"
-            "uint shiftCount\n"
-            ");\n"
-            "\n"
-            "\n"
-            "template __attribute__((mangled_name(" + name(7) + "Instantiated)))\n"
-            "void permuteSignedAscendingRadixNTemplate< " +radixStream.str()+ " >(__global uint* unsortedData,\n"
-            "global uint* scanedBuckets,\n"
-            "uint shiftCount,\n"
-            "global uint* sortedData\n"
+            "local " + typeNames[sort_iValueType] + "* tile\n"
             ");\n\n";
-        return templateSpecializationString;
-    }
+            return templateSpecializationString;
+        }
 };
 
-class RadixSort_Uint_KernelTemplateSpecializer : public KernelTemplateSpecializer
+/*! \brief Launch shape of the bitonic network over paddedSize elements of elementSize bytes
+ *  \details The local kernel sorts tiles of 2 * localWgSize elements, as large as the device's local memory and the
+ *  kernel's work group limit allow, so that as many passes as possible run in local memory.
+ */
+struct bitonicSortShape
 {
-private:
-    int _radix;
-public:
-    RadixSort_Uint_KernelTemplateSpecializer(int radix) : KernelTemplateSpecializer()
-    {
-        _radix = radix;
-        addKernelName("histogramAscendingRadixNTemplate");
-        addKernelName("histogramDescendingRadixNTemplate");
-        addKernelName("permuteAscendingRadixNTemplate");
-        addKernelName("permuteDescendingRadixNTemplate");
-    }
+    size_t wgSize;
+    size_t localWgSize;
+    size_t globalSize;
+    unsigned int tileStages;
 
-    const ::std::string operator() ( const ::std::vector<::std::string>& typeNames ) const
+    bitonicSortShape( const control& ctl, const ::cl::Kernel& localKernel, size_t paddedSize, size_t elementSize )
     {
-        std::stringstream radixStream;
-        radixStream << _radix;
-        const std::string templateSpecializationString =
-
-            "// Host generates this instantiation string with user-specified value type and functor\n"
-            "\ntemplate __attribute__((mangled_name(" + name(0) + "Instantiated)))\n"
-            "void histogramAscendingRadixNTemplate< " +radixStream.str()+ " >(__global uint* unsortedData,\n"
-            "global uint* buckets,\n"
-            "uint shiftCount\n"
-            ");\n"
-            "\n"
-            "\n"
-            "template __attribute__((mangled_name(" + name(2) + "Instantiated)))\n"
-            "void permuteAscendingRadixNTemplate< " +radixStream.str()+ " >(__global uint* unsortedData,\n"
-            "global uint* scanedBuckets,\n"
-            "uint shiftCount,\n"
-            "global uint* sortedData\n"
-            ");\n"
-            "\n"
-            "\n"
-            "// Host generates this instantiation string with user-specified value type and functor\n"
-            "\ntemplate __attribute__((mangled_name(" + name(1) + "Instantiated)))\n"
-            "void histogramDescendingRadixNTemplate< " +radixStream.str()+ " >(__global uint* unsortedData,\n"
-            "global uint* buckets,\n"
-            "uint shiftCount\n"
-            ");\n"
-            "\n"
-            "\n"
-            "template __attribute__((mangled_name(" + name(3) + "Instantiated)))\n"
-            "void permuteDescendingRadixNTemplate< " +radixStream.str()+ " >(__global uint* unsortedData,\n"
-            "global uint* scanedBuckets,\n"
-            "uint shiftCount,\n"
-            "global uint* sortedData\n"
-            ");\n\n"
-            "\n"
-            "\n";
-        return templateSpecializationString;
+        cl_int l_Error = CL_SUCCESS;
+        size_t maxWgSize = localKernel.getWorkGroupInfo< CL_KERNEL_WORK_GROUP_SIZE >( ctl.getDevice( ), &l_Error );
+        V_OPENCL( l_Error, "Error querying kernel for CL_KERNEL_WORK_GROUP_SIZE" );
+        cl_ulong localMemSize = ctl.getDevice( ).getInfo< CL_DEVICE_LOCAL_MEM_SIZE >( &l_Error );
+        V_OPENCL( l_Error, "Error querying device for CL_DEVICE_LOCAL_MEM_SIZE" );
+
+        globalSize = paddedSize / 2;
+        wgSize = std::min< size_t >( BITONIC_SORT_WGSIZE, globalSize );
+        localWgSize = std::min< size_t >( BITONIC_SORT_LOCAL_WGSIZE, globalSize );
+        while( localWgSize > 1 && ( localWgSize > maxWgSize || 2 * localWgSize * elementSize > localMemSize ) )
+            localWgSize >>= 1;
+
+        tileStages = 0;
+        for( size_t tile = 2 * localWgSize; tile > 1; tile >>= 1 )
+            ++tileStages;
     }
 };
 
@@ -376,8 +243,7 @@ void sort_pick_iterator( control &ctl,
                                                                      NULL, &multiCoreCPUEvent, &l_Error );
         multiCoreCPUEvent.wait();
         //Compute parallel sort using TBB
-        tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
-        tbb::parallel_sort(sortInputBuffer,sortInputBuffer+szElements, comp);
+        detail::tbb_parallel_sort(ctl, sortInputBuffer, sortInputBuffer+szElements, comp);
         /*Unmap the device buffer back to device memory. This will copy the host modified buffer back to the device*/
         ctl.getCommandQueue().enqueueUnmapMemObject(first.getBuffer(), sortInputBuffer);
         return;
@@ -428,8 +294,7 @@ void sort_pick_iterator( control &ctl,
     } else if (runMode == bolt::cl::control::MultiCoreCpu) {
 #ifdef ENABLE_TBB
         //std::cout << "The MultiCoreCpu version of sort is enabled with TBB. " << std ::endl;
-        tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
-        tbb::parallel_sort(first,last, comp);
+        detail::tbb_parallel_sort(ctl, first, last, comp);
 #else
         //std::cout << "The MultiCoreCpu version of sort is not enabled. " << std ::endl;
         throw ::cl::Error( CL_INVALID_OPERATION, "The MultiCoreCpu version of sort is not enabled to be built." );
@@ -444,425 +309,34 @@ void sort_pick_iterator( control &ctl,
     }
 }
 
-/****** sort_enqueue specailization for unsigned int data types. ******
- * THE FOLLOWING CODE IMPLEMENTS THE RADIX SORT ALGORITHM FOR unsigned integers
+/****** sort_enqueue specialization for arithmetic types with less / greater. ******
+ * LSD radix sort on the bits of the key, see radix_sort.inl
  *********************************************************************/
-
 template<typename DVRandomAccessIterator, typename StrictWeakOrdering>
-typename std::enable_if< std::is_same< typename std::iterator_traits<DVRandomAccessIterator >::value_type,
-                                       unsigned int
-                                     >::value
-                       >::type  /*If enabled then this typename will be evaluated to void*/
-sort_enqueue(control &ctl,
-             DVRandomAccessIterator first, DVRandomAccessIterator last,
-             StrictWeakOrdering comp, const std::string& cl_code)
-{
-    typedef typename std::iterator_traits< DVRandomAccessIterator >::value_type T;
-    const int RADIX = 4; //Now you cannot replace this with Radix 8 since there is a
-                         //local array of 16 elements in the histogram kernel.
-    const int RADICES = (1 << RADIX);	//Values handeled by each work-item?
-    size_t orig_szElements = static_cast<size_t>(std::distance(first, last));
-    size_t szElements = orig_szElements;
-
-    bool  newBuffer = false;
-    ::cl::Buffer *pLocalBuffer;
-    int computeUnits     = ctl.getDevice().getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
-    cl_int l_Error = CL_SUCCESS;
-
-    static std::vector< ::cl::Kernel > radixSortUintKernels;
-    std::vector<std::string> typeNames( sort_end );
-    typeNames[sort_iValueType]         = TypeName< T >::get( );
-    typeNames[sort_iIterType]          = TypeName< DVRandomAccessIterator >::get( );
-    typeNames[sort_StrictWeakOrdering] = TypeName< StrictWeakOrdering >::get();
-
-    std::vector<std::string> typeDefinitions;
-    PUSH_BACK_UNIQUE( typeDefinitions, ClCode< T >::get() )
-    PUSH_BACK_UNIQUE( typeDefinitions, ClCode< DVRandomAccessIterator >::get() )
-    PUSH_BACK_UNIQUE( typeDefinitions, ClCode< StrictWeakOrdering  >::get() )
-
-    bool cpuDevice = ctl.getDevice().getInfo<CL_DEVICE_TYPE>() == CL_DEVICE_TYPE_CPU;
-    /*\TODO - Do CPU specific kernel work group size selection here*/
-
-    std::string compileOptions;
-    //std::ostringstream oss;
-    RadixSort_Uint_KernelTemplateSpecializer ts_kts(RADIX);
-    std::vector< ::cl::Kernel > kernels = bolt::cl::getKernels(
-        ctl,
-        typeNames,
-        &ts_kts,
-        typeDefinitions,
-        sort_uint_kernels,
-        compileOptions);
-
-    size_t groupSize  = RADICES;
-
-    int i = 0;
-    size_t mulFactor = groupSize * RADICES;
-    size_t numGroups;
-
-    if(orig_szElements%mulFactor != 0)
-    {
-        ::cl::Event copyEvent;
-        szElements  = ((szElements + mulFactor) /mulFactor) * mulFactor;
-        pLocalBuffer = new ::cl::Buffer(ctl.getContext(),CL_MEM_READ_WRITE| CL_MEM_ALLOC_HOST_PTR, sizeof(T) * szElements);
-
-        ctl.getCommandQueue().enqueueCopyBuffer( first.getBuffer( ),
-                                              *pLocalBuffer, 0, 0,
-                                              orig_szElements*sizeof(T), NULL, &copyEvent );
-        copyEvent.wait();
-        newBuffer = true;
-    }
-    else
-    {
-        pLocalBuffer = new ::cl::Buffer(first.getBuffer( ) );
-        newBuffer = false;
-    }
-    numGroups = szElements / mulFactor;
-    device_vector< T > dvSwapInputData( szElements, 0, CL_MEM_READ_WRITE, false, ctl);
-    device_vector< T > dvHistogramBins( (numGroups* groupSize * RADICES), 0, CL_MEM_READ_WRITE, false, ctl);
-    //This can be avoided if we do a inplace scan.
-    device_vector< T > dvHistogramBinsDest( (numGroups* groupSize * RADICES), 0, CL_MEM_READ_WRITE, false, ctl);
-
-    ALIGNED( 256 ) StrictWeakOrdering aligned_comp( comp );
-
-    control::buffPointer userFunctor = ctl.acquireBuffer( sizeof( aligned_comp ),
-                                                          CL_MEM_USE_HOST_PTR|CL_MEM_READ_ONLY,
-                                                          &aligned_comp );
-    ::cl::Buffer clInputData = *pLocalBuffer;
-    ::cl::Buffer clSwapData = dvSwapInputData.begin( ).getBuffer( );
-    ::cl::Buffer clHistData = dvHistogramBins.begin( ).getBuffer( );
-    ::cl::Buffer clHistDataDest = dvHistogramBinsDest.begin( ).getBuffer( );
-
-    ::cl::Kernel histKernel;
-    ::cl::Kernel permuteKernel;
-
-    if(comp(2,3))
-    {
-        /*Ascending Sort*/
-        histKernel = kernels[0];
-        permuteKernel = kernels[2];
-        if(newBuffer == true)
-        {
-            cl_buffer_region clBR;
-            ::cl::Event fillEvent;
-            clBR.origin = orig_szElements* sizeof(T);
-            clBR.size  = (szElements * sizeof(T)) - orig_szElements* sizeof(T);
-            ctl.getCommandQueue().enqueueFillBuffer(clInputData, (unsigned int)BOLT_UINT_MAX, clBR.origin, clBR.size, NULL, &fillEvent);
-            fillEvent.wait();
-        }
-    }
-    else
-    {
-        /*Descending Sort*/
-        histKernel = kernels[1];
-        permuteKernel = kernels[3];
-        if(newBuffer == true)
-        {
-            cl_buffer_region clBR;
-            ::cl::Event fillEvent;
-            clBR.origin = orig_szElements* sizeof(T);
-            clBR.size  = (szElements * sizeof(T)) - orig_szElements* sizeof(T);
-            ctl.getCommandQueue().enqueueFillBuffer(clInputData, (unsigned int)BOLT_UINT_MIN, clBR.origin, clBR.size, NULL, &fillEvent);
-            fillEvent.wait();
-        }
-    }
-
-    int swap = 0;
-    for(int bits = 0; bits < (sizeof(T) * 8)/*Bits per Byte*/; bits += RADIX)
-    {
-        //Do a histogram pass locally
-        if (swap == 0)
-            V_OPENCL( histKernel.setArg(0, clInputData), "Error setting a kernel argument" );
-        else
-            V_OPENCL( histKernel.setArg(0, clSwapData), "Error setting a kernel argument" );
-
-        V_OPENCL( histKernel.setArg(1, clHistData), "Error setting a kernel argument" );
-        V_OPENCL( histKernel.setArg(2, bits), "Error setting a kernel argument" );
-
-        l_Error = ctl.getCommandQueue().enqueueNDRangeKernel(
-                            histKernel,
-                            ::cl::NullRange,
-                            ::cl::NDRange(szElements/RADICES),
-                            ::cl::NDRange(groupSize),
-                            NULL,
-                            NULL);
-        //V_OPENCL( ctl.getCommandQueue().finish(), "Error calling finish on the command queue" );
-
-        //Perform a global scan
-        detail::scan_enqueue(ctl, dvHistogramBins.begin(), dvHistogramBins.end(), dvHistogramBinsDest.begin(), 0, plus< T >( ), false);
-
-        if (swap == 0)
-            V_OPENCL( permuteKernel.setArg(0, clInputData), "Error setting kernel argument" );
-        else
-            V_OPENCL( permuteKernel.setArg(0, clSwapData), "Error setting kernel argument" );
-        V_OPENCL( permuteKernel.setArg(1, clHistDataDest), "Error setting a kernel argument" );
-        V_OPENCL( permuteKernel.setArg(2, bits), "Error setting a kernel argument" );
-
-        if (swap == 0)
-            V_OPENCL( permuteKernel.setArg(3, clSwapData), "Error setting kernel argument" );
-        else
-            V_OPENCL( permuteKernel.setArg(3, clInputData), "Error setting kernel argument" );
-        l_Error = ctl.getCommandQueue().enqueueNDRangeKernel(
-                            permuteKernel,
-                            ::cl::NullRange,
-                            ::cl::NDRange(szElements/RADICES),
-                            ::cl::NDRange(groupSize),
-                            NULL,
-                            NULL);
-        V_OPENCL( ctl.getCommandQueue().finish(), "Error calling finish on the command queue" );
-        /*For swapping the buffers*/
-        swap = swap? 0: 1;
-    }
-    ::cl::Event uintRadixSortEvent;
-    V_OPENCL( ctl.getCommandQueue().clEnqueueBarrierWithWaitList(NULL, &uintRadixSortEvent) , "Error calling clEnqueueBarrierWithWaitList on the command queue" );
-    bolt::cl::wait(ctl, uintRadixSortEvent);
-
-    if(newBuffer == true)
-    {
-        ::cl::Event copyBackEvent;
-        ctl.getCommandQueue().enqueueCopyBuffer( clInputData, first.getBuffer( ), 0, 0, sizeof(T)*orig_szElements, NULL, &copyBackEvent );
-        copyBackEvent.wait();
-    }
-    delete pLocalBuffer;
-    return;
-}
-
-
-/****** sort_enqueue specailization for signed int data types. ******
- * THE FOLLOWING CODE IMPLEMENTS THE RADIX SORT ALGORITHM FOR signed integers
- *********************************************************************/
-template<typename DVRandomAccessIterator, typename StrictWeakOrdering>
-typename std::enable_if< std::is_same< typename std::iterator_traits<DVRandomAccessIterator >::value_type,
-                                       int
-                                     >::value
-                       >::type   /*If enabled then this typename will be evaluated to void*/
+typename std::enable_if< radix_sort_enabled< typename std::iterator_traits<DVRandomAccessIterator >::value_type,
+                                             StrictWeakOrdering
+                                           >::value
+                       >::type
 sort_enqueue(control &ctl,
-             DVRandomAccessIterator first, DVRandomAccessIterator last,
-             StrictWeakOrdering comp, const std::string& cl_code)
+             const DVRandomAccessIterator& first, const DVRandomAccessIterator& last,
+             const StrictWeakOrdering& comp, const std::string& cl_code)
 {
     typedef typename std::iterator_traits< DVRandomAccessIterator >::value_type T;
-    const int RADIX = 4; //Now you cannot replace this with Radix 8 since there is a
-                         //local array of 16 elements in the histogram kernel.
-    const int RADICES = (1 << RADIX);	//Values handeled by each work-item?
-    cl_int l_Error = CL_SUCCESS;
-    size_t orig_szElements = static_cast<size_t>(std::distance(first, last));
-    size_t szElements = orig_szElements;
-    bool  newBuffer = false;
-    ::cl::Buffer *pLocalBuffer;
-
-    int computeUnits     = ctl.getDevice().getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
-
-    std::vector<std::string> typeNames( sort_end );
-    typeNames[sort_iValueType] = TypeName< T >::get( );
-    typeNames[sort_iIterType] = TypeName< DVRandomAccessIterator >::get( );
-    typeNames[sort_StrictWeakOrdering] = TypeName< StrictWeakOrdering >::get();
-
-    std::vector<std::string> typeDefinitions;
-    PUSH_BACK_UNIQUE( typeDefinitions, ClCode< T >::get() )
-    PUSH_BACK_UNIQUE( typeDefinitions, ClCode< DVRandomAccessIterator >::get() )
-    PUSH_BACK_UNIQUE( typeDefinitions, ClCode< StrictWeakOrdering  >::get() )
-
-    bool cpuDevice = ctl.getDevice().getInfo<CL_DEVICE_TYPE>() == CL_DEVICE_TYPE_CPU;
-    /*\TODO - Do CPU specific kernel work group size selection here*/
-    //const size_t kernel0_WgSize = (cpuDevice) ? 1 : WAVESIZE*KERNEL02WAVES;
-
-    std::string compileOptions;
-    //std::ostringstream oss;
-
-    RadixSort_Int_KernelTemplateSpecializer ts_kts(RADIX);
-    std::vector< ::cl::Kernel > kernels = bolt::cl::getKernels(
-        ctl,
-        typeNames,
-        &ts_kts,
-        typeDefinitions,
-        sort_uint_kernels,
-        compileOptions);
-
-    unsigned int groupSize  = RADICES;
-
-    int i = 0;
-    size_t mulFactor = groupSize * RADICES;
-
-    if(orig_szElements%mulFactor != 0)
-    {
-        ::cl::Event copyEvent;
-        szElements  = ((szElements + mulFactor) /mulFactor) * mulFactor;
-        pLocalBuffer = new ::cl::Buffer(ctl.getContext(),CL_MEM_READ_WRITE| CL_MEM_ALLOC_HOST_PTR, sizeof(T) * szElements);
-
-        ctl.getCommandQueue().enqueueCopyBuffer( first.getBuffer( ),
-                                              *pLocalBuffer, 0, 0,
-                                              orig_szElements*sizeof(T), NULL, &copyEvent );
-        copyEvent.wait();
-        newBuffer = true;
-    }
-    else
-    {
-        pLocalBuffer = new ::cl::Buffer(first.getBuffer( ) );
-        newBuffer = false;
-    }
-    size_t numGroups = szElements / mulFactor;
-    device_vector< T > dvSwapInputData( szElements, 0, CL_MEM_READ_WRITE, true, ctl);
-    device_vector< T > dvHistogramBins( (numGroups* groupSize * RADICES), 0, CL_MEM_READ_WRITE, true, ctl);
-    //This can be avoided if we do an inplace scan and probaly will get better performance
-    device_vector< T > dvHistogramBinsDest( (numGroups* groupSize * RADICES), 0, CL_MEM_READ_WRITE, false, ctl);
-
-    ALIGNED( 256 ) StrictWeakOrdering aligned_comp( comp );
-
-    control::buffPointer userFunctor = ctl.acquireBuffer( sizeof( aligned_comp ), CL_MEM_USE_HOST_PTR|CL_MEM_READ_ONLY, &aligned_comp );
-    ::cl::Buffer clInputData = *pLocalBuffer;
-    ::cl::Buffer clSwapData = dvSwapInputData.begin( ).getBuffer( );
-    ::cl::Buffer clHistData = dvHistogramBins.begin( ).getBuffer( );
-    ::cl::Buffer clHistDataDest = dvHistogramBinsDest.begin( ).getBuffer( );
-
-    ::cl::Kernel histKernel, histSignedKernel;
-    ::cl::Kernel permuteKernel, permuteSignedKernel;
-    if(comp(2,3))
-    {
-        /*Ascending Sort*/
-        histKernel = kernels[0];
-        //scanLocalKernel = kernels[2];
-        permuteKernel = kernels[2];
-        if(newBuffer == true)
-        {
-            cl_buffer_region clBR;
-            clBR.origin = orig_szElements* sizeof(T);
-            clBR.size  = (szElements * sizeof(T)) - orig_szElements* sizeof(T);
-            ctl.getCommandQueue().enqueueFillBuffer(clInputData, BOLT_INT_MAX, clBR.origin, clBR.size, NULL, NULL);
-        }
-    }
-    else
-    {
-        /*Descending Sort*/
-        histKernel = kernels[1];
-        //scanLocalKernel = kernels[2];
-        permuteKernel = kernels[3];
-        if(newBuffer == true)
-        {
-            cl_buffer_region clBR;
-            clBR.origin = orig_szElements* sizeof(T);
-            clBR.size  = (szElements * sizeof(T)) - orig_szElements* sizeof(T);
-            ctl.getCommandQueue().enqueueFillBuffer(clInputData, BOLT_INT_MIN, clBR.origin, clBR.size, NULL, NULL);
-        }
-    }
-
-    ::cl::LocalSpaceArg localScanArray;
-    localScanArray.size_ = 2*RADICES* sizeof(cl_uint);
-    int swap = 0;
-    int bits;
-    for(bits = 0; bits < (sizeof(T) * 8 - RADIX)/*Bits per Byte*/; bits += RADIX)
-    {
-        //Do a histogram pass locally
-        if (swap == 0)
-            V_OPENCL( histKernel.setArg(0, clInputData), "Error setting a kernel argument" );
-        else
-            V_OPENCL( histKernel.setArg(0, clSwapData), "Error setting a kernel argument" );
-
-        V_OPENCL( histKernel.setArg(1, clHistData), "Error setting a kernel argument" );
-        //V_OPENCL( histKernel.setArg(2, clHistScanData), "Error setting a kernel argument" );
-        V_OPENCL( histKernel.setArg(2, bits), "Error setting a kernel argument" );
-        //V_OPENCL( histKernel.setArg(4, loc), "Error setting kernel argument" );
-
-        l_Error = ctl.getCommandQueue().enqueueNDRangeKernel(
-                            histKernel,
-                            ::cl::NullRange,
-                            ::cl::NDRange(szElements/RADICES),
-                            ::cl::NDRange(groupSize),
-                            NULL,
-                            NULL);
-        //V_OPENCL( ctl.getCommandQueue().finish(), "Error calling finish on the command queue" );
-
-        //Perform a global scan
-
-        detail::scan_enqueue(ctl, dvHistogramBins.begin(), dvHistogramBins.end(),
-                                  dvHistogramBinsDest.begin(), 0, plus< T >( ), false);
-
-        if (swap == 0)
-            V_OPENCL( permuteKernel.setArg(0, clInputData), "Error setting kernel argument" );
-        else
-            V_OPENCL( permuteKernel.setArg(0, clSwapData), "Error setting kernel argument" );
-        V_OPENCL( permuteKernel.setArg(1, clHistDataDest), "Error setting a kernel argument" );
-        V_OPENCL( permuteKernel.setArg(2, bits), "Error setting a kernel argument" );
-        //V_OPENCL( permuteKernel.setArg(3, loc), "Error setting kernel argument" );
-
-        if (swap == 0)
-            V_OPENCL( permuteKernel.setArg(3, clSwapData), "Error setting kernel argument" );
-        else
-            V_OPENCL( permuteKernel.setArg(3, clInputData), "Error setting kernel argument" );
-        l_Error = ctl.getCommandQueue().enqueueNDRangeKernel(
-                            permuteKernel,
-                            ::cl::NullRange,
-                            ::cl::NDRange(szElements/RADICES),
-                            ::cl::NDRange(groupSize),
-                            NULL,
-                            NULL);
-        //V_OPENCL( ctl.getCommandQueue().finish(), "Error calling finish on the command queue" );
-
-            /*For swapping the buffers*/
-            swap = swap? 0: 1;
-    }
-
-    if(comp(2,3))
-    {
-        /*Ascending Sort*/
-        histSignedKernel = kernels[4];
-        permuteSignedKernel = kernels[6];
-    }
-    else
-    {
-        histSignedKernel = kernels[5];
-        permuteSignedKernel = kernels[7];
-    }
-        //Do a histogram pass locally
-            V_OPENCL( histSignedKernel.setArg(0, clSwapData), "Error setting a kernel argument" );
-            V_OPENCL( histSignedKernel.setArg(1, clHistData), "Error setting a kernel argument" );
-            //V_OPENCL( histSignedKernel.setArg(2, clHistScanData), "Error setting a kernel argument" );
-            V_OPENCL( histSignedKernel.setArg(2, bits), "Error setting a kernel argument" );
-            //V_OPENCL( histKernel.setArg(4, loc), "Error setting kernel argument" );
-
-            l_Error = ctl.getCommandQueue().enqueueNDRangeKernel(
-                                histSignedKernel,
-                                ::cl::NullRange,
-                                ::cl::NDRange(szElements/RADICES),
-                                ::cl::NDRange(groupSize),
-                                NULL,
-                                NULL);
-            //V_OPENCL( ctl.getCommandQueue().finish(), "Error calling finish on the command queue" );
-
-            //Perform a global scan
-            detail::scan_enqueue(ctl, dvHistogramBins.begin(), dvHistogramBins.end(), dvHistogramBinsDest.begin(), 0, plus< T >( ), false);
-
-            V_OPENCL( permuteSignedKernel.setArg(0, clSwapData), "Error setting kernel argument" );
-            V_OPENCL( permuteSignedKernel.setArg(1, clHistDataDest), "Error setting a kernel argument" );
-            V_OPENCL( permuteSignedKernel.setArg(2, bits), "Error setting a kernel argument" );
-            V_OPENCL( permuteSignedKernel.setArg(3, clInputData), "Error setting kernel argument" );
-            l_Error = ctl.getCommandQueue().enqueueNDRangeKernel(
-                                permuteSignedKernel,
-                                ::cl::NullRange,
-                                ::cl::NDRange(szElements/RADICES),
-                                ::cl::NDRange(groupSize),
-                                NULL,
-                                NULL);
+    size_t szElements = static_cast< size_t >( std::distance( first, last ) );
+    bool descending = std::is_same< StrictWeakOrdering, bolt::cl::greater< T > >::value;
 
-    ::cl::Event intRadixSortEvent;
-    V_OPENCL( ctl.getCommandQueue().clEnqueueBarrierWithWaitList(NULL, &intRadixSortEvent) , "Error calling clEnqueueBarrierWithWaitList on the command queue" );
-    bolt::cl::wait(ctl, intRadixSortEvent);
+    radix_sort_enqueue< T >( ctl, first.getBuffer( ), first.m_Index, szElements, descending, NULL );
 
-    if(newBuffer == true)
-    {
-        ::cl::Event copyBackEvent;
-        ctl.getCommandQueue().enqueueCopyBuffer( clInputData, first.getBuffer( ), 0, 0, sizeof(T)*orig_szElements, NULL, &copyBackEvent );
-        copyBackEvent.wait();
-    }
-    delete pLocalBuffer;
+    ::cl::Event radixSortEvent;
+    V_OPENCL( ctl.getCommandQueue().clEnqueueBarrierWithWaitList(NULL, &radixSortEvent) , "Error calling clEnqueueBarrierWithWaitList on the command queue" );
+    bolt::cl::wait(ctl, radixSortEvent, "sort");
     return;
 }
 
 
 template<typename DVRandomAccessIterator, typename StrictWeakOrdering>
 typename std::enable_if<
-    !(std::is_same< typename std::iterator_traits<DVRandomAccessIterator >::value_type, unsigned int >::value
-   || std::is_same< typename std::iterator_traits<DVRandomAccessIterator >::value_type,          int >::value
-    )
+    !radix_sort_enabled< typename std::iterator_traits<DVRandomAccessIterator >::value_type, StrictWeakOrdering >::value
                        >::type
 sort_enqueue(control &ctl,
              const DVRandomAccessIterator& first, const DVRandomAccessIterator& last,
@@ -871,11 +345,7 @@ sort_enqueue(control &ctl,
     cl_int l_Error = CL_SUCCESS;
     typedef typename std::iterator_traits< DVRandomAccessIterator >::value_type T;
     size_t szElements = static_cast< size_t >( std::distance( first, last ) );
-    if(((szElements-1) & (szElements)) != 0)
-    {
-        sort_enqueue_non_powerOf2(ctl,first,last,comp,cl_code);
-        return;
-    }
+    index_require_32( szElements, "The OpenCL path of sort() takes ranges of fewer than 2^31 elements" );
 
     std::vector<std::string> typeNames( sort_end );
     typeNames[sort_iValueType] = TypeName< T >::get( );
@@ -887,14 +357,7 @@ sort_enqueue(control &ctl,
     PUSH_BACK_UNIQUE( typeDefinitions, ClCode< DVRandomAccessIterator >::get() )
     PUSH_BACK_UNIQUE( typeDefinitions, ClCode< StrictWeakOrdering  >::get() )
 
-    bool cpuDevice = ctl.getDevice().getInfo<CL_DEVICE_TYPE>() == CL_DEVICE_TYPE_CPU;
-    /*\TODO - Do CPU specific kernel work group size selection here*/
-    //const size_t kernel0_WgSize = (cpuDevice) ? 1 : WAVESIZE*KERNEL02WAVES;
     std::string compileOptions;
-    //std::ostringstream oss;
-    //oss << " -DKERNEL0WORKGROUPSIZE=" << kernel0_WgSize;
-
-    size_t temp;
 
     BitonicSort_KernelTemplateSpecializer ts_kts;
     std::vector< ::cl::Kernel > kernels = bolt::cl::getKernels(
@@ -904,157 +367,87 @@ sort_enqueue(control &ctl,
         typeDefinitions,
         sort_kernels,
         compileOptions);
-    //Power of 2 buffer size
     // For user-defined types, the user must create a TypeName trait which returns the name of the class -
     // Note use of TypeName<>::get to retreive the name here.
 
-
-    size_t wgSize  = BITONIC_SORT_WGSIZE;
-
-    if((szElements/2) < BITONIC_SORT_WGSIZE)
-    {
-        wgSize = (int)szElements/2;
-    }
-    unsigned int stage,passOfStage;
+    // The network is built for the next power of 2; the positions past the end of the buffer are treated as
+    // virtual elements that compare greater than everything, so they are never loaded or stored.
     unsigned int numStages = 0;
-    for(temp = szElements; temp > 1; temp >>= 1)
+    size_t paddedSize = 1;
+    while( paddedSize < szElements )
+    {
+        paddedSize <<= 1;
         ++numStages;
+    }
+    if( numStages == 0 )
+        return;
+
+    bitonicSortShape shape( ctl, kernels[1], paddedSize, sizeof( T ) );
 
     //::cl::Buffer A = first.getBuffer( );
     ALIGNED( 256 ) StrictWeakOrdering aligned_comp( comp );
     control::buffPointer userFunctor = ctl.acquireBuffer( sizeof( aligned_comp ),
                                                           CL_MEM_USE_HOST_PTR|CL_MEM_READ_ONLY, &aligned_comp );
+    ::cl::LocalSpaceArg loc;
+    loc.size_ = shape.localWgSize * 2 * sizeof( T );
 
     V_OPENCL( kernels[0].setArg(0, first.getBuffer( )), "Error setting 0th kernel argument" );
     V_OPENCL( kernels[0].setArg(1, first.gpuPayloadSize( ), &first.gpuPayload( )), "Error setting 1st kernel argument" );
-    V_OPENCL( kernels[0].setArg(4, *userFunctor), "Error setting 4th kernel argument" );
-    for(stage = 0; stage < numStages; ++stage)
+    V_OPENCL( kernels[0].setArg(4, static_cast< cl_uint >( szElements )), "Error setting 4th kernel argument" );
+    V_OPENCL( kernels[0].setArg(5, *userFunctor), "Error setting 5th kernel argument" );
+    V_OPENCL( kernels[1].setArg(0, first.getBuffer( )), "Error setting 0th kernel argument" );
+    V_OPENCL( kernels[1].setArg(1, first.gpuPayloadSize( ), &first.gpuPayload( )), "Error setting 1st kernel argument" );
+    V_OPENCL( kernels[1].setArg(5, static_cast< cl_uint >( szElements )), "Error setting 5th kernel argument" );
+    V_OPENCL( kernels[1].setArg(6, *userFunctor), "Error setting 6th kernel argument" );
+    V_OPENCL( kernels[1].setArg(7, loc), "Error setting 7th kernel argument" );
+
+    /*
+     * The passes whose pairs fit in a tile run in local memory: the first tileStages stages in one launch, then
+     * the last tileStages passes of every later stage in one launch each.  Only the passes in between, whose pairs
+     * are a tile or more apart, go through global memory one launch at a time.  Each thread compares and exchanges
+     * one pair of the padded network, so the number of threads (global) is half the padded length.
+     */
+    for(unsigned int stage = 0; stage < numStages; ++stage)
     {
-        // stage of the algorithm
-        V_OPENCL( kernels[0].setArg(2, stage), "Error setting 2nd kernel argument" );
-        // Every stage has stage + 1 passes
-        for(passOfStage = 0; passOfStage < stage + 1; ++passOfStage) {
-            // pass of the current stage
-            V_OPENCL( kernels[0].setArg(3, passOfStage), "Error setting 3rd kernel argument" );
-            /*
-             * Enqueue a kernel run call.
-             * Each thread writes a sorted pair.
-             * So, the number of  threads (global) should be half the length of the input buffer.
-             */
-            l_Error = ctl.getCommandQueue().enqueueNDRangeKernel(
-                                            kernels[0],
-                                            ::cl::NullRange,
-                                            ::cl::NDRange(szElements/2),
-                                            ::cl::NDRange(BITONIC_SORT_WGSIZE),
-                                            NULL,
-                                            NULL);
-
-            V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for sort() kernel" );
-            //V_OPENCL( ctl.getCommandQueue().finish(), "Error calling finish on the command queue" );
-        }//end of for passStage = 0:stage-1
-    }//end of for stage = 0:numStage-1
-    ::cl::Event bitonicSortEvent;
-    V_OPENCL( ctl.getCommandQueue().clEnqueueBarrierWithWaitList(NULL, &bitonicSortEvent) ,
-                        "Error calling clEnqueueBarrierWithWaitList on the command queue" );
-    l_Error = bitonicSortEvent.wait( );
-    V_OPENCL( l_Error, "bitonicSortEvent failed to wait" );
-    //V_OPENCL( ctl.getCommandQueue().finish(), "Error calling finish on the command queue" );
-    return;
-}// END of sort_enqueue
-
-
-template<typename DVRandomAccessIterator, typename StrictWeakOrdering>
-void sort_enqueue_non_powerOf2(control &ctl,
-                               const DVRandomAccessIterator& first, const DVRandomAccessIterator& last,
-                               const StrictWeakOrdering& comp, const std::string& cl_code)
-{
-    typedef typename std::iterator_traits< DVRandomAccessIterator >::value_type T;
-
-    cl_int l_Error;
-    size_t szElements = (size_t)(last - first);
-
-    std::vector<std::string> typeNames( sort_end );
-    typeNames[sort_iValueType] = TypeName< T >::get( );
-    typeNames[sort_iIterType] = TypeName< DVRandomAccessIterator >::get( );
-    typeNames[sort_StrictWeakOrdering] = TypeName< StrictWeakOrdering >::get();
-    // Power of 2 buffer size
-    // For user-defined types, the user must create a TypeName trait which returns the name of the class -
-    // Note use of TypeName<>::get to retreive the name here.
-
-    std::vector<std::string> typeDefinitions;
-    PUSH_BACK_UNIQUE( typeDefinitions, ClCode< T >::get() )
-    PUSH_BACK_UNIQUE( typeDefinitions, ClCode< DVRandomAccessIterator >::get() )
-    PUSH_BACK_UNIQUE( typeDefinitions, ClCode< StrictWeakOrdering  >::get() )
-
-    bool cpuDevice = ctl.getDevice().getInfo<CL_DEVICE_TYPE>() == CL_DEVICE_TYPE_CPU;
-    /*\TODO - Do CPU specific kernel work group size selection here*/
-    //const size_t kernel0_WgSize = (cpuDevice) ? 1 : WAVESIZE*KERNEL02WAVES;
-    std::string compileOptions;
-    //std::ostringstream oss;
-    //oss << " -DKERNEL0WORKGROUPSIZE=" << kernel0_WgSize;
-
-    SelectionSort_KernelTemplateSpecializer ts_kts;
-    std::vector< ::cl::Kernel > kernels = bolt::cl::getKernels(
-        ctl,
-        typeNames,
-        &ts_kts,
-        typeDefinitions,
-        sort_kernels,
-        compileOptions);
-
-    size_t wgSize  = kernels[0].getWorkGroupInfo< CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE >( ctl.getDevice( ), &l_Error );
-
-    size_t totalWorkGroups = (szElements + wgSize)/wgSize;
-    size_t globalSize = totalWorkGroups * wgSize;
-    V_OPENCL( l_Error, "Error querying kernel for CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE" );
-
-    const ::cl::Buffer& in = first.getBuffer( );
-    control::buffPointer out = ctl.acquireBuffer( sizeof(T)*szElements );
-
-    ALIGNED( 256 ) StrictWeakOrdering aligned_comp( comp );
-    control::buffPointer userFunctor = ctl.acquireBuffer( sizeof( aligned_comp ),
-                                                          CL_MEM_USE_HOST_PTR|CL_MEM_READ_ONLY, &aligned_comp );
-
-    ::cl::LocalSpaceArg loc;
-    loc.size_ = wgSize*sizeof(T);
-
-    V_OPENCL( kernels[0].setArg(0, in), "Error setting a kernel argument in" );
-    V_OPENCL( kernels[0].setArg(1, *out), "Error setting a kernel argument out" );
-    V_OPENCL( kernels[0].setArg(2, *userFunctor), "Error setting a kernel argument userFunctor" );
-    V_OPENCL( kernels[0].setArg(3, loc), "Error setting kernel argument loc" );
-    V_OPENCL( kernels[0].setArg(4, static_cast<cl_uint> (szElements)), "Error setting kernel argument szElements" );
-    {
-        l_Error = ctl.getCommandQueue().enqueueNDRangeKernel(
-                                        kernels[0],
-                                        ::cl::NullRange,
-                                        ::cl::NDRange(globalSize),
-                                        ::cl::NDRange(wgSize),
-                                        NULL,
-                                        NULL);
-        V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for sort() kernel" );
-        V_OPENCL( ctl.getCommandQueue().finish(), "Error calling finish on the command queue" );
-    }
-
-    wgSize  = kernels[1].getWorkGroupInfo< CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE >( ctl.getDevice( ), &l_Error );
+        unsigned int passOfStage = 0;
+        if( stage >= shape.tileStages )
+        {
+            V_OPENCL( kernels[0].setArg(2, stage), "Error setting 2nd kernel argument" );
+            for( ; stage - passOfStage >= shape.tileStages; ++passOfStage )
+            {
+                V_OPENCL( kernels[0].setArg(3, passOfStage), "Error setting 3rd kernel argument" );
+                l_Error = ctl.getCommandQueue().enqueueNDRangeKernel(
+                                                kernels[0],
+                                                ::cl::NullRange,
+                                                ::cl::NDRange(shape.globalSize),
+                                                ::cl::NDRange(shape.wgSize),
+                                                NULL,
+                                                NULL);
+                V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for sort() kernel" );
+            }
+        }
 
-    V_OPENCL( kernels[1].setArg(0, *out), "Error setting a kernel argument in" );
-    V_OPENCL( kernels[1].setArg(1, in), "Error setting a kernel argument out" );
-    V_OPENCL( kernels[1].setArg(2, *userFunctor), "Error setting a kernel argument userFunctor" );
-    V_OPENCL( kernels[1].setArg(3, loc), "Error setting kernel argument loc" );
-    V_OPENCL( kernels[1].setArg(4, static_cast<cl_uint> (szElements)), "Error setting kernel argument szElements" );
-    {
+        unsigned int lastStage = ( stage < shape.tileStages ) ? std::min( numStages, shape.tileStages ) - 1 : stage;
+        V_OPENCL( kernels[1].setArg(2, stage), "Error setting 2nd kernel argument" );
+        V_OPENCL( kernels[1].setArg(3, passOfStage), "Error setting 3rd kernel argument" );
+        V_OPENCL( kernels[1].setArg(4, lastStage), "Error setting 4th kernel argument" );
         l_Error = ctl.getCommandQueue().enqueueNDRangeKernel(
                                         kernels[1],
                                         ::cl::NullRange,
-                                        ::cl::NDRange(globalSize),
-                                        ::cl::NDRange(wgSize),
+                                        ::cl::NDRange(shape.globalSize),
+                                        ::cl::NDRange(shape.localWgSize),
                                         NULL,
                                         NULL);
         V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for sort() kernel" );
-        V_OPENCL( ctl.getCommandQueue().finish(), "Error calling finish on the command queue" );
+        stage = lastStage;
     }
+    ::cl::Event bitonicSortEvent;
+    V_OPENCL( ctl.getCommandQueue().clEnqueueBarrierWithWaitList(NULL, &bitonicSortEvent) ,
+                        "Error calling clEnqueueBarrierWithWaitList on the command queue" );
+    l_Error = bitonicSortEvent.wait( );
+    V_OPENCL( l_Error, "bitonicSortEvent failed to wait" );
     return;
-}// END of sort_enqueue_non_powerOf2
+}// END of sort_enqueue
 
 }//namespace bolt::cl::detail
 }//namespace bolt::cl
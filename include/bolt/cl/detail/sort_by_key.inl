@@ -19,6 +19,8 @@
 #if !defined( SORT_BY_KEY_INL )
 #define SORT_BY_KEY_INL
 
+#include <vector>
+#include <utility>
 #include <algorithm>
 #include <type_traits>
 
@@ -29,9 +31,13 @@
 #include "bolt/cl/scan.h"
 #include "bolt/cl/functional.h"
 #include "bolt/cl/device_vector.h"
+#include "bolt/cl/sort.h"
+#include "bolt/cl/detail/radix_sort.inl"
+#include "bolt/cl/detail/index_type.inl"
+#ifdef ENABLE_TBB
+#include "bolt/cl/detail/tbb_merge_sort.inl"
+#endif
 
-
-#define BITONIC_SORT_WGSIZE 64
 #define DEBUG 1
 namespace bolt {
     namespace cl {
@@ -125,6 +131,7 @@ public:
     BitonicSortByKey_KernelTemplateSpecializer() : KernelTemplateSpecializer()
     {
         addKernelName("BitonicSortByKeyTemplate");
+        addKernelName("BitonicSortByKeyLocalTemplate");
     }
 
     const ::std::string operator() ( const ::std::vector<::std::string>& typeNames ) const
@@ -140,13 +147,62 @@ public:
             ""        + typeNames[sort_by_key_valueIterType] + " values_iter,\n"
             "const uint stage,\n"
             "const uint passOfStage,\n"
+            "const uint length,\n"
             "global " + typeNames[sort_by_key_StrictWeakOrdering] + " * userComp\n"
+            ");\n\n"
+            "// Host generates this instantiation string with user-specified value type and functor\n"
+            "template __attribute__((mangled_name(" + name(1) + "Instantiated)))\n"
+            "kernel void BitonicSortByKeyLocalTemplate(\n"
+            "global " + typeNames[sort_by_key_keyValueType] + "* A,\n"
+            ""        + typeNames[sort_by_key_keyIterType]  + " input_iter,\n"
+            "global " + typeNames[sort_by_key_valueValueType] + "* values_ptr,\n"
+            ""        + typeNames[sort_by_key_valueIterType] + " values_iter,\n"
+            "const uint stage,\n"
+            "const uint passOfStage,\n"
+            "const uint lastStage,\n"
+            "const uint length,\n"
+            "global " + typeNames[sort_by_key_StrictWeakOrdering] + " * userComp,\n"
+            "local " + typeNames[sort_by_key_keyValueType] + "* tileKeys,\n"
+            "local " + typeNames[sort_by_key_valueValueType] + "* tileValues\n"
             ");\n\n";
             return templateSpecializationString;
         }
 };
 
+    //  Orders key/value pairs by their keys only
+    template< typename Key, typename Value, typename StrictWeakOrdering >
+    struct serialSortByKeyCompare
+    {
+        StrictWeakOrdering comp;
+
+        serialSortByKeyCompare( const StrictWeakOrdering& _comp ): comp( _comp )
+        {}
+
+        bool operator( )( const std::pair< Key, Value >& lhs, const std::pair< Key, Value >& rhs )
+        {
+            return comp( lhs.first, rhs.first );
+        }
+    };
 
+    /*! \brief Sorts the keys in [keysFirst, keysLast) with std::sort, moving the values with them
+     *  \details The keys and values are zipped into pairs for the sort and unzipped afterwards.
+     */
+    template< typename Key, typename Value, typename StrictWeakOrdering >
+    void serial_sort_by_key( Key* keysFirst, Key* keysLast, Value* valuesFirst, const StrictWeakOrdering& comp )
+    {
+        size_t length = static_cast< size_t >( keysLast - keysFirst );
+        std::vector< std::pair< Key, Value > > pairs( length );
+        for( size_t i = 0; i < length; ++i )
+            pairs[ i ] = std::make_pair( keysFirst[ i ], valuesFirst[ i ] );
+
+        std::sort( pairs.begin( ), pairs.end( ), serialSortByKeyCompare< Key, Value, StrictWeakOrdering >( comp ) );
+
+        for( size_t i = 0; i < length; ++i )
+        {
+            keysFirst[ i ] = pairs[ i ].first;
+            valuesFirst[ i ] = pairs[ i ].second;
+        }
+    }
 
     // Wrapper that uses default control class, iterator interface
     template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename StrictWeakOrdering>
@@ -195,13 +251,24 @@ public:
         {
             runMode = ctl.getDefaultPathToRun( );
         }
-        if (runMode == bolt::cl::control::SerialCpu) {
-            //  TODO:  Need access to the device_vector .data method to get a host pointer
-            throw ::cl::Error( CL_INVALID_DEVICE, "Sort of device_vector CPU device not implemented" );
-            return;
-        } else if (runMode == bolt::cl::control::MultiCoreCpu) {
-            //std::cout << "The MultiCoreCpu version of device_vector sort is not implemented yet." << std ::endl;
-            throw std::exception( "The MultiCoreCpu version of Sort_by_key is not enabled to be built with TBB." );
+        if (runMode == bolt::cl::control::SerialCpu || runMode == bolt::cl::control::MultiCoreCpu) {
+            typedef typename std::iterator_traits< DVRandomAccessIterator1 >::value_type T_keys;
+            typedef typename std::iterator_traits< DVRandomAccessIterator2 >::value_type T_values;
+            typename bolt::cl::device_vector< T_keys >::pointer keysPtr = keys_first.getContainer( ).data( );
+            typename bolt::cl::device_vector< T_values >::pointer valuesPtr = values_first.getContainer( ).data( );
+            T_keys* keysRangeFirst = &keysPtr[ keys_first.m_Index ];
+            T_values* valuesRangeFirst = &valuesPtr[ values_first.m_Index ];
+
+            if (runMode == bolt::cl::control::SerialCpu) {
+                serial_sort_by_key( keysRangeFirst, keysRangeFirst + szElements, valuesRangeFirst, comp );
+            } else {
+#ifdef ENABLE_TBB
+                tbb_parallel_sort_by_key( ctl, keysRangeFirst, keysRangeFirst + szElements, valuesRangeFirst, comp );
+#else
+                throw ::cl::Error( CL_INVALID_OPERATION,
+                                   "The MultiCoreCpu version of sort_by_key is not enabled to be built." );
+#endif
+            }
         } else {
             sort_by_key_enqueue(ctl, keys_first, keys_last, values_first, comp, cl_code);
         }
@@ -230,12 +297,15 @@ public:
         {
             runMode = ctl.getDefaultPathToRun( );
         }
-        if ((runMode == bolt::cl::control::SerialCpu) /*|| (szElements < WGSIZE) */) {
-            //std::cout << "The SerialCpu version of sort is not implemented yet." << std ::endl;
-            std::sort(keys_first, keys_last);
+        if (runMode == bolt::cl::control::SerialCpu) {
+            serial_sort_by_key( &*keys_first, &*( keys_last - 1 ) + 1, &*values_first, comp );
         } else if (runMode == bolt::cl::control::MultiCoreCpu) {
-            //std::cout << "The MultiCoreCpu version of sort is not implemented yet." << std ::endl;
-            throw std::exception( "The MultiCoreCpu version of Sort_by_key is not enabled to be built with TBB." );
+#ifdef ENABLE_TBB
+            tbb_parallel_sort_by_key( ctl, &*keys_first, &*( keys_last - 1 ) + 1, &*values_first, comp );
+#else
+            throw ::cl::Error( CL_INVALID_OPERATION,
+                               "The MultiCoreCpu version of sort_by_key is not enabled to be built." );
+#endif
         } else {
             device_vector< T_values > dvInputValues( values_first, szElements,
                                                      CL_MEM_USE_HOST_PTR | CL_MEM_READ_WRITE, true, ctl );
@@ -251,24 +321,36 @@ public:
     }
 
 
+    /****** sort_by_key_enqueue specialization for arithmetic keys with less / greater. ******
+     * Radix sort of the keys, then one gather of the values; see radix_sort.inl
+     *********************************************************************/
     template<typename DVRandomAccessIterator1, typename DVRandomAccessIterator2, typename StrictWeakOrdering>
-    void sort_by_key_enqueue(const control &ctl, const DVRandomAccessIterator1& keys_first,
+    typename std::enable_if< radix_sort_enabled< typename std::iterator_traits< DVRandomAccessIterator1 >::value_type,
+                                                 StrictWeakOrdering
+                                               >::value
+                           >::type
+    sort_by_key_enqueue(const control &ctl, const DVRandomAccessIterator1& keys_first,
+                             const DVRandomAccessIterator1& keys_last, const DVRandomAccessIterator2& values_first,
+                             const StrictWeakOrdering& comp, const std::string& cl_code)
+    {
+        typedef typename std::iterator_traits< DVRandomAccessIterator1 >::value_type T_keys;
+        bool descending = std::is_same< StrictWeakOrdering, bolt::cl::greater< T_keys > >::value;
+        radix_sort_by_key_enqueue( ctl, keys_first, keys_last, values_first, descending );
+        return;
+    }
+
+    template<typename DVRandomAccessIterator1, typename DVRandomAccessIterator2, typename StrictWeakOrdering>
+    typename std::enable_if<
+        !radix_sort_enabled< typename std::iterator_traits< DVRandomAccessIterator1 >::value_type, StrictWeakOrdering >::value
+                           >::type
+    sort_by_key_enqueue(const control &ctl, const DVRandomAccessIterator1& keys_first,
                              const DVRandomAccessIterator1& keys_last, const DVRandomAccessIterator2& values_first,
                              const StrictWeakOrdering& comp, const std::string& cl_code)
     {
             typedef typename std::iterator_traits< DVRandomAccessIterator1 >::value_type T_keys;
             typedef typename std::iterator_traits< DVRandomAccessIterator2 >::value_type T_values;
             size_t szElements = (size_t)(keys_last - keys_first);
-            if(((szElements-1) & (szElements)) != 0)
-            {
-                // sort_by_key_enqueue_non_powerOf2(ctl,keys_first,keys_last,values_first,comp,cl_code);
-                //std::cout << "There is no use supporting selection sort for the sort_by_key routine.\n";
-                //std::cout << " Hence only power of 2 buffer sizes work.\n";
-                //std::cout << "non power of 2 buffer sizes will be supported once radix-sort is working\n";
-                throw ::cl::Error( CL_INVALID_BUFFER_SIZE,
-                    "Currently the sort_by_key routine supports only power of 2 buffer size" );
-                return;
-            }
+            index_require_32( szElements, "The OpenCL path of sort_by_key() takes ranges of fewer than 2^31 elements" );
 
             std::vector<std::string> typeNames( sort_by_key_end );
             typeNames[sort_by_key_keyValueType] = TypeName< T_keys >::get( );
@@ -300,69 +382,86 @@ public:
                 sort_by_key_kernels,
                 compileOptions);
 
-            size_t temp;
-
-            // Set up shape of launch grid and buffers:
-            int computeUnits     = ctl.getDevice().getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
-            int wgPerComputeUnit =  ctl.getWGPerComputeUnit();
-            int resultCnt = computeUnits * wgPerComputeUnit;
-            cl_int l_Error = CL_SUCCESS;
-
-            size_t wgSize  = kernels[0].getWorkGroupInfo< CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE >
-                                                                                ( ctl.getDevice( ), &l_Error );
-            V_OPENCL( l_Error, "Error querying kernel for CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE" );
-            if((szElements/2) < wgSize)
+            // The network is built for the next power of 2; the positions past the end of the range are treated as
+            // virtual keys that compare greater than everything, so they are never loaded or stored.
+            unsigned int numStages = 0;
+            size_t paddedSize = 1;
+            while( paddedSize < szElements )
             {
-                wgSize = (int)szElements/2;
+                paddedSize <<= 1;
+                ++numStages;
             }
-            unsigned int numStages,stage,passOfStage;
+            if( numStages == 0 )
+                return;
+
+            cl_int l_Error = CL_SUCCESS;
+            bitonicSortShape shape( ctl, kernels[1], paddedSize, sizeof( T_keys ) + sizeof( T_values ) );
 
             ::cl::Buffer Keys = keys_first.getBuffer( );
             ::cl::Buffer Values = values_first.getBuffer( );
             ::cl::Buffer userFunctor(ctl.getContext(), CL_MEM_USE_HOST_PTR, sizeof(comp), (void*)&comp );
+            ::cl::LocalSpaceArg locKeys, locValues;
+            locKeys.size_ = shape.localWgSize * 2 * sizeof( T_keys );
+            locValues.size_ = shape.localWgSize * 2 * sizeof( T_values );
 
-            numStages = 0;
-            for(temp = szElements; temp > 1; temp >>= 1)
-                ++numStages;
-            V_OPENCL( kernels[0].setArg(0, Keys), "Error setting a kernel argument" );
-            V_OPENCL( kernels[0].setArg(1, keys_first.gpuPayloadSize( ), &keys_first.gpuPayload( ) ),
-                                                  "Error setting a kernel argument" );
-            V_OPENCL( kernels[0].setArg(2, Values), "Error setting a kernel argument" );
-            V_OPENCL( kernels[0].setArg(3, values_first.gpuPayloadSize( ), &values_first.gpuPayload( ) ),
-                                                  "Error setting a kernel argument" );
-            V_OPENCL( kernels[0].setArg(6, userFunctor), "Error setting a kernel argument" );
-            for(stage = 0; stage < numStages; ++stage)
+            for( size_t k = 0; k < kernels.size( ); ++k )
             {
-                // stage of the algorithm
-                V_OPENCL( kernels[0].setArg(4, stage), "Error setting a kernel argument" );
-                // Every stage has stage + 1 passes
-                for(passOfStage = 0; passOfStage < stage + 1; ++passOfStage)
+                V_OPENCL( kernels[k].setArg(0, Keys), "Error setting a kernel argument" );
+                V_OPENCL( kernels[k].setArg(1, keys_first.gpuPayloadSize( ), &keys_first.gpuPayload( ) ),
+                                                      "Error setting a kernel argument" );
+                V_OPENCL( kernels[k].setArg(2, Values), "Error setting a kernel argument" );
+                V_OPENCL( kernels[k].setArg(3, values_first.gpuPayloadSize( ), &values_first.gpuPayload( ) ),
+                                                      "Error setting a kernel argument" );
+            }
+            V_OPENCL( kernels[0].setArg(6, static_cast< cl_uint >( szElements )), "Error setting a kernel argument" );
+            V_OPENCL( kernels[0].setArg(7, userFunctor), "Error setting a kernel argument" );
+            V_OPENCL( kernels[1].setArg(7, static_cast< cl_uint >( szElements )), "Error setting a kernel argument" );
+            V_OPENCL( kernels[1].setArg(8, userFunctor), "Error setting a kernel argument" );
+            V_OPENCL( kernels[1].setArg(9, locKeys), "Error setting a kernel argument" );
+            V_OPENCL( kernels[1].setArg(10, locValues), "Error setting a kernel argument" );
+
+            // As in sort_enqueue: the passes whose pairs fit in a tile run in local memory, one launch for the first
+            // tileStages stages and one for the tail of every later stage; the rest go through global memory.
+            for(unsigned int stage = 0; stage < numStages; ++stage)
+            {
+                unsigned int passOfStage = 0;
+                if( stage >= shape.tileStages )
                 {
-                    // pass of the current stage
-                    V_OPENCL( kernels[0].setArg(5, passOfStage), "Error setting a kernel argument" );
-                    /*
-                        * Enqueue a kernel run call.
-                        * Each thread writes a sorted pair.
-                        * So, the number of  threads (global) should be half the length of the input buffer.
-                        */
-                    l_Error = ctl.getCommandQueue().enqueueNDRangeKernel(
-                            kernels[0],
-                            ::cl::NullRange,
-                            ::cl::NDRange(szElements/2),
-                            ::cl::NDRange(wgSize),
-                            NULL,
-                            NULL);
-                    V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for sort() kernel" );
-                    V_OPENCL( ctl.getCommandQueue().finish(), "Error calling finish on the command queue" );
-                }//end of for passStage = 0:stage-1
-            }//end of for stage = 0:numStage-1
-            //Map the buffer back to the host
-            //ctl.commandQueue().enqueueMapBuffer(Keys, true, CL_MAP_READ | CL_MAP_WRITE, 0/*offset*/,
-            //    sizeof(T_keys) * szElements, NULL, NULL, &l_Error );
-            //ctl.commandQueue().enqueueMapBuffer(Values, true, CL_MAP_READ | CL_MAP_WRITE, 0/*offset*/,
-            //   sizeof(T_values) * szElements, NULL, NULL, &l_Error );
-            V_OPENCL( ctl.getCommandQueue().finish(), "Error calling finish on the command queue" );
-            V_OPENCL( l_Error, "Error calling map on the result buffer" );
+                    V_OPENCL( kernels[0].setArg(4, stage), "Error setting a kernel argument" );
+                    for( ; stage - passOfStage >= shape.tileStages; ++passOfStage )
+                    {
+                        V_OPENCL( kernels[0].setArg(5, passOfStage), "Error setting a kernel argument" );
+                        l_Error = ctl.getCommandQueue().enqueueNDRangeKernel(
+                                kernels[0],
+                                ::cl::NullRange,
+                                ::cl::NDRange(shape.globalSize),
+                                ::cl::NDRange(shape.wgSize),
+                                NULL,
+                                NULL);
+                        V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for sort_by_key() kernel" );
+                    }
+                }
+
+                unsigned int lastStage = ( stage < shape.tileStages ) ? std::min( numStages, shape.tileStages ) - 1
+                                                                      : stage;
+                V_OPENCL( kernels[1].setArg(4, stage), "Error setting a kernel argument" );
+                V_OPENCL( kernels[1].setArg(5, passOfStage), "Error setting a kernel argument" );
+                V_OPENCL( kernels[1].setArg(6, lastStage), "Error setting a kernel argument" );
+                l_Error = ctl.getCommandQueue().enqueueNDRangeKernel(
+                        kernels[1],
+                        ::cl::NullRange,
+                        ::cl::NDRange(shape.globalSize),
+                        ::cl::NDRange(shape.localWgSize),
+                        NULL,
+                        NULL);
+                V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for sort_by_key() kernel" );
+                stage = lastStage;
+            }
+
+            ::cl::Event bitonicSortEvent;
+            V_OPENCL( ctl.getCommandQueue().clEnqueueBarrierWithWaitList(NULL, &bitonicSortEvent) ,
+                                "Error calling clEnqueueBarrierWithWaitList on the command queue" );
+            bolt::cl::wait(ctl, bitonicSortEvent, "sort_by_key");
             return;
     }// END of sort_enqueue
 
@@ -376,6 +475,7 @@ public:
             typedef typename std::iterator_traits< DVRandomAccessIterator2 >::value_type T_values;
             static boost::once_flag initOnlyOnce;
             size_t szElements = (size_t)(keys_last - keys_first);
+            index_require_32( szElements, "The OpenCL path of sort_by_key() takes ranges of fewer than 2^31 elements" );
 
             // Set up shape of launch grid and buffers:
             int computeUnits     = ctl.device().getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
@@ -29,8 +29,15 @@
 #include "bolt/cl/bolt.h"
 #include "bolt/cl/functional.h"
 #include "bolt/cl/device_vector.h"
+#include "bolt/cl/detail/index_type.inl"
+#ifdef ENABLE_TBB
+#include "bolt/cl/detail/tbb_merge_sort.inl"
+#endif
 
 #define BOLT_CL_STABLESORT_CPU_THRESHOLD 64
+/* \brief - Largest work group of the stable sort kernels, and how many elements of a tile each item handles */
+#define BOLT_CL_STABLESORT_WGSIZE 128
+#define BOLT_CL_STABLESORT_ITEMS_PER_THREAD 4
 
 namespace bolt {
 namespace cl {
@@ -101,7 +108,7 @@ namespace detail
     public:
         StableSort_KernelTemplateSpecializer() : KernelTemplateSpecializer( )
         {
-            addKernelName( "blockInsertionSort" );
+            addKernelName( "blockSort" );
             addKernelName( "merge" );
         }
 
@@ -113,7 +120,9 @@ namespace detail
                 "global " + typeNames[stableSort_iValueType] + "* data_ptr,\n"
                 ""        + typeNames[stableSort_iIterType] + " data_iter,\n"
                 "const uint vecSize,\n"
+                "const uint itemsPerThread,\n"
                 "local "  + typeNames[stableSort_iValueType] + "* lds,\n"
+                "local uint* ldsIndex,\n"
                 "global " + typeNames[stableSort_lessFunction] + " * lessOp\n"
                 ");\n\n"
 
@@ -125,7 +134,9 @@ namespace detail
                 ""        + typeNames[stableSort_iIterType] + " result_iter,\n"
                 "const uint srcVecSize,\n"
                 "const uint srcBlockSize,\n"
+                "const uint itemsPerThread,\n"
                 "local "  + typeNames[stableSort_iValueType] + "* lds,\n"
+                "local uint* coRank,\n"
                 "global " + typeNames[stableSort_lessFunction] + " * lessOp\n"
                 ");\n\n";
 
@@ -133,6 +144,56 @@ namespace detail
         }
     };
 
+    /*! \brief Launch shape of the stable sort of vecSize elements of elementSize bytes
+     *  \details Both kernels work on tiles of wgSize * itemsPerThread elements, a power of 2.  The merge holds two
+     *  tiles in local memory and the block sort one tile with its indices, so the tile shrinks until the larger of
+     *  the two fits the device's local memory.
+     */
+    struct stableSortShape
+    {
+        size_t wgSize;
+        size_t itemsPerThread;
+        size_t tileSize;
+        size_t numTiles;
+
+        stableSortShape( const control& ctl, const std::vector< ::cl::Kernel >& kernels, size_t vecSize,
+                         size_t elementSize )
+        {
+            cl_int l_Error = CL_SUCCESS;
+            size_t maxWgSize = BOLT_CL_STABLESORT_WGSIZE;
+            for( size_t k = 0; k < kernels.size( ); ++k )
+            {
+                size_t kernelWgSize = kernels[ k ].getWorkGroupInfo< CL_KERNEL_WORK_GROUP_SIZE >( ctl.getDevice( ),
+                                                                                                   &l_Error );
+                V_OPENCL( l_Error, "Error querying kernel for CL_KERNEL_WORK_GROUP_SIZE" );
+                maxWgSize = std::min( maxWgSize, kernelWgSize );
+            }
+            cl_ulong localMemSize = ctl.getDevice( ).getInfo< CL_DEVICE_LOCAL_MEM_SIZE >( &l_Error );
+            V_OPENCL( l_Error, "Error querying device for CL_DEVICE_LOCAL_MEM_SIZE" );
+
+            wgSize = BOLT_CL_STABLESORT_WGSIZE;
+            while( wgSize > 1 && wgSize > maxWgSize )
+                wgSize >>= 1;
+            itemsPerThread = BOLT_CL_STABLESORT_ITEMS_PER_THREAD;
+            while( wgSize * itemsPerThread > 2 && localBytes( wgSize * itemsPerThread, elementSize ) > localMemSize )
+            {
+                if( wgSize > 1 )
+                    wgSize >>= 1;
+                else
+                    itemsPerThread >>= 1;
+            }
+
+            tileSize = wgSize * itemsPerThread;
+            numTiles = ( vecSize + tileSize - 1 ) / tileSize;
+        }
+
+        static cl_ulong localBytes( size_t tileSize, size_t elementSize )
+        {
+            return std::max( tileSize * ( elementSize + sizeof( cl_uint ) ),
+                             2 * tileSize * elementSize + 2 * sizeof( cl_uint ) );
+        }
+    };
+
 // Wrapper that uses default control class, iterator interface
 template<typename RandomAccessIterator, typename StrictWeakOrdering> 
 void stablesort_detect_random_access( control &ctl, 
@@ -194,7 +255,11 @@ void stablesort_pick_iterator( control &ctl, const RandomAccessIterator& first,
     }
     else if( runMode == bolt::cl::control::MultiCoreCpu )
     {
-        throw ::cl::Error( CL_INVALID_OPERATION, "stable_sort not implemented yet for MultiCoreCpu" );
+#ifdef ENABLE_TBB
+        detail::tbb_parallel_stable_sort( ctl, &*first, &*( last - 1 ) + 1, comp );
+#else
+        throw ::cl::Error( CL_INVALID_OPERATION, "The MultiCoreCpu version of stable_sort is not enabled to be built." );
+#endif
         return;
     } 
     else 
@@ -233,13 +298,21 @@ void stablesort_pick_iterator( control &ctl,
     if( runMode == bolt::cl::control::SerialCpu )
     {
         bolt::cl::device_vector< Type >::pointer firstPtr =  first.getContainer( ).data( );
+        Type* rangeFirst = &firstPtr[ first.m_Index ];
 
-        std::stable_sort( &firstPtr[ first.m_Index ], &firstPtr[ vecSize-1 ], comp );
+        std::stable_sort( rangeFirst, rangeFirst + vecSize, comp );
         return;
     }
     else if( runMode == bolt::cl::control::MultiCoreCpu )
     {
-        throw ::cl::Error( CL_INVALID_OPERATION, "stable_sort not implemented yet for MultiCoreCpu" );
+#ifdef ENABLE_TBB
+        bolt::cl::device_vector< Type >::pointer firstPtr =  first.getContainer( ).data( );
+        Type* rangeFirst = &firstPtr[ first.m_Index ];
+
+        detail::tbb_parallel_stable_sort( ctl, rangeFirst, rangeFirst + vecSize, comp );
+#else
+        throw ::cl::Error( CL_INVALID_OPERATION, "The MultiCoreCpu version of stable_sort is not enabled to be built." );
+#endif
         return;
     } 
     else 
@@ -255,6 +328,8 @@ void stablesort_enqueue(control& ctrl, const DVRandomAccessIterator& first, cons
              const StrictWeakOrdering& comp, const std::string& cl_code)
 {
     cl_int l_Error;
+    index_require_32( static_cast< size_t >( std::distance( first, last ) ),
+        "The OpenCL path of stable_sort() takes ranges of fewer than 2^31 elements" );
     cl_uint vecSize = static_cast< cl_uint >( std::distance( first, last ) );
 
     /**********************************************************************************
@@ -275,18 +350,6 @@ void stablesort_enqueue(control& ctrl, const DVRandomAccessIterator& first, cons
     PUSH_BACK_UNIQUE( typeDefinitions, ClCode< DVRandomAccessIterator >::get( ) )
     PUSH_BACK_UNIQUE( typeDefinitions, ClCode< StrictWeakOrdering  >::get( ) )
 
-    /**********************************************************************************
-     * Compile Options
-     *********************************************************************************/
-    bool cpuDevice = ctrl.getDevice( ).getInfo< CL_DEVICE_TYPE >( ) == CL_DEVICE_TYPE_CPU;
-    //std::cout << "Device is CPU: " << (cpuDevice?"TRUE":"FALSE") << std::endl;
-    //const size_t kernel0_localRange = ( cpuDevice ) ? 1 : localRange*4;
-    //std::ostringstream oss;
-    //oss << " -DKERNEL0WORKGROUPSIZE=" << kernel0_localRange;
-
-    //oss << " -DUSE_AMD_HSA=" << USE_AMD_HSA;
-    //compileOptions = oss.str();
-
     /**********************************************************************************
      * Request Compiled Kernels
      *********************************************************************************/
@@ -302,70 +365,54 @@ void stablesort_enqueue(control& ctrl, const DVRandomAccessIterator& first, cons
         compileOptions );
     // kernels returned in same order as added in KernelTemplaceSpecializer constructor
 
-    size_t localRange  = kernels[ 0 ].getWorkGroupInfo< CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE >( ctrl.getDevice( ), &l_Error );
-    V_OPENCL( l_Error, "Error querying kernel for CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE" );
-
-
-    //  Make sure that globalRange is a multiple of localRange
-    size_t globalRange = vecSize;
-    size_t modlocalRange = ( globalRange & ( localRange-1 ) );
-    if( modlocalRange )
-    {
-        globalRange &= ~modlocalRange;
-        globalRange += localRange;
-    }
+    stableSortShape shape( ctrl, kernels, vecSize, sizeof( iType ) );
+    size_t globalRange = shape.numTiles * shape.wgSize;
+    cl_uint itemsPerThread = static_cast< cl_uint >( shape.itemsPerThread );
 
     ALIGNED( 256 ) StrictWeakOrdering aligned_comp( comp );
     control::buffPointer userFunctor = ctrl.acquireBuffer( sizeof( aligned_comp ), CL_MEM_USE_HOST_PTR|CL_MEM_READ_ONLY, &aligned_comp );
 
-    //  kernels[ 0 ] sorts values within a workgroup, in parallel across the entire vector
-    //  kernels[ 0 ] reads and writes to the same vector
-    cl_uint ldsSize  = static_cast< cl_uint >( localRange * sizeof( iType ) );
+    //  kernels[ 0 ] stably sorts every tile in local memory, in place
     V_OPENCL( kernels[ 0 ].setArg( 0, first.getBuffer( ) ),    "Error setting argument for kernels[ 0 ]" ); // Input buffer
     V_OPENCL( kernels[ 0 ].setArg( 1, first.gpuPayloadSize( ), &first.gpuPayload( ) ), "Error setting a kernel argument" );
-    V_OPENCL( kernels[ 0 ].setArg( 2, vecSize ),            "Error setting argument for kernels[ 0 ]" ); // Size of scratch buffer
-    V_OPENCL( kernels[ 0 ].setArg( 3, ldsSize, NULL ),          "Error setting argument for kernels[ 0 ]" ); // Scratch buffer
-    V_OPENCL( kernels[ 0 ].setArg( 4, *userFunctor ),           "Error setting argument for kernels[ 0 ]" ); // User provided functor class
+    V_OPENCL( kernels[ 0 ].setArg( 2, vecSize ),            "Error setting argument for kernels[ 0 ]" ); // Size of the input
+    V_OPENCL( kernels[ 0 ].setArg( 3, itemsPerThread ),     "Error setting argument for kernels[ 0 ]" ); // Elements per work item
+    V_OPENCL( kernels[ 0 ].setArg( 4, shape.tileSize * sizeof( iType ), NULL ), "Error setting argument for kernels[ 0 ]" ); // Tile
+    V_OPENCL( kernels[ 0 ].setArg( 5, shape.tileSize * sizeof( cl_uint ), NULL ), "Error setting argument for kernels[ 0 ]" ); // Tile indices
+    V_OPENCL( kernels[ 0 ].setArg( 6, *userFunctor ),           "Error setting argument for kernels[ 0 ]" ); // User provided functor class
 
     ::cl::CommandQueue& myCQ = ctrl.getCommandQueue( );
 
     ::cl::Event blockSortEvent;
     l_Error = myCQ.enqueueNDRangeKernel( kernels[ 0 ], ::cl::NullRange,
-            ::cl::NDRange( globalRange ), ::cl::NDRange( localRange ), NULL, &blockSortEvent );
-    V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for perBlockInclusiveScan kernel" );
+            ::cl::NDRange( globalRange ), ::cl::NDRange( shape.wgSize ), NULL, &blockSortEvent );
+    V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for blockSortTemplate kernel" );
 
     //  Early exit for the case of no merge passes, values are already in destination vector
-    if( vecSize <= localRange )
+    if( vecSize <= shape.tileSize )
     {
-        wait( ctrl, blockSortEvent );
+        wait( ctrl, blockSortEvent, "stable_sort" );
         return;
     };
 
-    //  An odd number of elements requires an extra merge pass to sort
+    //  Each merge pass doubles the width of the sorted runs, starting from one tile
     size_t numMerges = 0;
-
-    //  Calculate the log2 of vecSize, taking into account our block size from kernel 1 is 64
-    //  this is how many merge passes we want
-    size_t log2BlockSize = vecSize >> 6;
-    for( ; log2BlockSize > 1; log2BlockSize >>= 1 )
+    for( size_t runWidth = shape.tileSize; runWidth < vecSize; runWidth <<= 1 )
     {
         ++numMerges;
     }
 
-    //  Check to see if the input vector size is a power of 2, if not we will need last merge pass
-    size_t vecPow2 = (vecSize & (vecSize-1));
-    numMerges += vecPow2? 1: 0;
-
-    //{
-    //    device_vector< iType >::pointer myData = first.getContainer( ).data( );
-    //    myData.reset( );
-    //}
+    //  Allocate a flipflop buffer because the merge passes are out of place.  It holds just the range, so its
+    //  iterator payload starts at index 0
+    control::buffPointer tmpBuffer = ctrl.acquireBuffer( vecSize * sizeof( iType ) );
+    typename DVRandomAccessIterator::Payload tmpPayload = first.gpuPayload( );
+    tmpPayload.m_Index = 0;
 
-    //  Allocate a flipflop buffer because the merge passes are out of place
-    control::buffPointer tmpBuffer = ctrl.acquireBuffer( globalRange * sizeof( iType ) );
-    V_OPENCL( kernels[ 1 ].setArg( 4, vecSize ),            "Error setting argument for kernels[ 0 ]" ); // Size of scratch buffer
-    V_OPENCL( kernels[ 1 ].setArg( 6, ldsSize, NULL ),          "Error setting argument for kernels[ 0 ]" ); // Scratch buffer
-    V_OPENCL( kernels[ 1 ].setArg( 7, *userFunctor ),           "Error setting argument for kernels[ 0 ]" ); // User provided functor class
+    V_OPENCL( kernels[ 1 ].setArg( 4, vecSize ),            "Error setting argument for kernels[ 1 ]" ); // Size of the input
+    V_OPENCL( kernels[ 1 ].setArg( 6, itemsPerThread ),     "Error setting argument for kernels[ 1 ]" ); // Elements per work item
+    V_OPENCL( kernels[ 1 ].setArg( 7, 2 * shape.tileSize * sizeof( iType ), NULL ), "Error setting argument for kernels[ 1 ]" ); // Input and merged tiles
+    V_OPENCL( kernels[ 1 ].setArg( 8, 2 * sizeof( cl_uint ), NULL ), "Error setting argument for kernels[ 1 ]" ); // Merge path of the tile ends
+    V_OPENCL( kernels[ 1 ].setArg( 9, *userFunctor ),           "Error setting argument for kernels[ 1 ]" ); // User provided functor class
 
     ::cl::Event kernelEvent;
     for( size_t pass = 1; pass <= numMerges; ++pass )
@@ -373,84 +420,25 @@ void stablesort_enqueue(control& ctrl, const DVRandomAccessIterator& first, cons
         //  For each pass, flip the input-output buffers 
         if( pass & 0x1 )
         {
-            V_OPENCL( kernels[ 1 ].setArg( 0, first.getBuffer( ) ),    "Error setting argument for kernels[ 0 ]" ); // Input buffer
+            V_OPENCL( kernels[ 1 ].setArg( 0, first.getBuffer( ) ),    "Error setting argument for kernels[ 1 ]" ); // Input buffer
             V_OPENCL( kernels[ 1 ].setArg( 1, first.gpuPayloadSize( ), &first.gpuPayload( ) ), "Error setting a kernel argument" );
-            V_OPENCL( kernels[ 1 ].setArg( 2, *tmpBuffer ),    "Error setting argument for kernels[ 0 ]" ); // Input buffer
-            V_OPENCL( kernels[ 1 ].setArg( 3, first.gpuPayloadSize( ), &first.gpuPayload( ) ), "Error setting a kernel argument" );
+            V_OPENCL( kernels[ 1 ].setArg( 2, *tmpBuffer ),    "Error setting argument for kernels[ 1 ]" ); // Output buffer
+            V_OPENCL( kernels[ 1 ].setArg( 3, first.gpuPayloadSize( ), &tmpPayload ), "Error setting a kernel argument" );
         }
         else
         {
-            V_OPENCL( kernels[ 1 ].setArg( 0, *tmpBuffer ),    "Error setting argument for kernels[ 0 ]" ); // Input buffer
-            V_OPENCL( kernels[ 1 ].setArg( 1, first.gpuPayloadSize( ), &first.gpuPayload( ) ), "Error setting a kernel argument" );
-            V_OPENCL( kernels[ 1 ].setArg( 2, first.getBuffer( ) ),    "Error setting argument for kernels[ 0 ]" ); // Input buffer
+            V_OPENCL( kernels[ 1 ].setArg( 0, *tmpBuffer ),    "Error setting argument for kernels[ 1 ]" ); // Input buffer
+            V_OPENCL( kernels[ 1 ].setArg( 1, first.gpuPayloadSize( ), &tmpPayload ), "Error setting a kernel argument" );
+            V_OPENCL( kernels[ 1 ].setArg( 2, first.getBuffer( ) ),    "Error setting argument for kernels[ 1 ]" ); // Output buffer
             V_OPENCL( kernels[ 1 ].setArg( 3, first.gpuPayloadSize( ), &first.gpuPayload( ) ), "Error setting a kernel argument" );
         }
         //  For each pass, the merge window doubles
-        unsigned srcLogicalBlockSize = static_cast< unsigned >( localRange << (pass-1) );
-        V_OPENCL( kernels[ 1 ].setArg( 5, static_cast< unsigned >( srcLogicalBlockSize ) ),            "Error setting argument for kernels[ 0 ]" ); // Size of scratch buffer
-
-        if( pass == numMerges )
-        {
-            //  Grab the event to wait on from the last enqueue call
-            l_Error = myCQ.enqueueNDRangeKernel( kernels[ 1 ], ::cl::NullRange, ::cl::NDRange( globalRange ),
-                    ::cl::NDRange( localRange ), NULL, &kernelEvent );
-            V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for mergeTemplate kernel" );
-        }
-        else
-        {
-            l_Error = myCQ.enqueueNDRangeKernel( kernels[ 1 ], ::cl::NullRange, ::cl::NDRange( globalRange ),
-                    ::cl::NDRange( localRange ), NULL, NULL );
-            V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for mergeTemplate kernel" );
-        }
+        cl_uint srcLogicalBlockSize = static_cast< cl_uint >( shape.tileSize << (pass-1) );
+        V_OPENCL( kernels[ 1 ].setArg( 5, srcLogicalBlockSize ),            "Error setting argument for kernels[ 1 ]" ); // Width of the input runs
 
-        ///  Debug code to examine input/output buffers on every pass
-        //myCQ.finish( );
-        //std::cout << "BlockSize[ " << srcLogicalBlockSize << " ] " << std::endl;
-        //if( pass & 0x1 )
-        //{
-        //    //  Debug mapping, to look at result vector in memory
-        //    iType* dev2Host = static_cast< iType* >( myCQ.enqueueMapBuffer( *tmpBuffer, CL_TRUE, CL_MAP_READ, 0,
-        //        globalRange * sizeof( iType ), NULL, NULL, &l_Error) );
-        //    V_OPENCL( l_Error, "Error: Mapping Device->Host Buffer." );
-
-        //    for( unsigned i = 0; i < globalRange/srcLogicalBlockSize; ++i )
-        //    {
-        //        unsigned blockIndex = i * srcLogicalBlockSize;
-        //        unsigned endIndex = bolt::cl::minimum< unsigned >()( blockIndex+(srcLogicalBlockSize-1), vecSize ) - 1;
-        //        for( unsigned j = blockIndex; j < endIndex; ++j )
-        //        {
-        //            if( !(comp)( dev2Host[ j ], dev2Host[ j + 1 ] ) && (dev2Host[ j ] != dev2Host[ j + 1 ]) )
-        //            {
-        //                std::cout << " Element[ " << j+1 << " ] out of sequence Block[ " << i << " ] Index[ " << j+1-blockIndex << " ]" << std::endl;
-        //            }
-        //        }
-        //    }
-
-        //    myCQ.enqueueUnmapMemObject( *tmpBuffer, dev2Host );
-        //}
-        //else
-        //{
-        //    //  Debug mapping, to look at result vector in memory
-        //    iType* dev2Host = static_cast< iType* >( myCQ.enqueueMapBuffer( first.getBuffer( ), CL_TRUE, CL_MAP_READ, 0,
-        //        bolt::cl::minimum< size_t >()( globalRange, vecSize ) * sizeof( iType ), NULL, NULL, &l_Error) );
-        //    V_OPENCL( l_Error, "Error: Mapping Device->Host Buffer." );
-
-        //    for( unsigned i = 0; i < globalRange/srcLogicalBlockSize; ++i )
-        //    {
-        //        unsigned blockIndex = i * srcLogicalBlockSize;
-        //        unsigned endIndex = bolt::cl::minimum< unsigned >()( blockIndex+(srcLogicalBlockSize-1), vecSize ) - 1;
-        //        for( unsigned j = blockIndex; j < endIndex; ++j )
-        //        {
-        //            if( !(comp)( dev2Host[ j ], dev2Host[ j + 1 ] ) && (dev2Host[ j ] != dev2Host[ j + 1 ]) )
-        //            {
-        //                std::cout << "Block[ " << i << " ] Element[ " << j << " ] out of sequence" << std::endl;
-        //            }
-        //        }
-        //    }
-
-        //    myCQ.enqueueUnmapMemObject( first.getBuffer( ), dev2Host );
-        //}
-        //std::cout << std::endl;
+        l_Error = myCQ.enqueueNDRangeKernel( kernels[ 1 ], ::cl::NullRange, ::cl::NDRange( globalRange ),
+                ::cl::NDRange( shape.wgSize ), NULL, ( pass == numMerges ) ? &kernelEvent : NULL );
+        V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for mergeTemplate kernel" );
     }
 
     //  If there are an odd number of merges, then the output data is sitting in the temp buffer.  We need to copy
@@ -462,11 +450,11 @@ void stablesort_enqueue(control& ctrl, const DVRandomAccessIterator& first, cons
         l_Error = myCQ.enqueueCopyBuffer( *tmpBuffer, first.getBuffer( ), 0, first.m_Index * sizeof( iType ), 
             vecSize * sizeof( iType ), NULL, &copyEvent );
         V_OPENCL( l_Error, "device_vector failed to copy data inside of operator=()" );
-        wait( ctrl, copyEvent );
+        wait( ctrl, copyEvent, "stable_sort" );
     }
     else
     {
-        wait( ctrl, kernelEvent );
+        wait( ctrl, kernelEvent, "stable_sort" );
     }
 
     return;
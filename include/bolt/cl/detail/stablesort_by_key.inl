@@ -29,6 +29,11 @@
 #include "bolt/cl/bolt.h"
 #include "bolt/cl/functional.h"
 #include "bolt/cl/device_vector.h"
+#include "bolt/cl/detail/radix_sort.inl"
+#include "bolt/cl/detail/index_type.inl"
+#ifdef ENABLE_TBB
+#include "bolt/cl/detail/tbb_merge_sort.inl"
+#endif
 
 #define BOLT_CL_STABLESORT_BY_KEY_CPU_THRESHOLD 64
 
@@ -214,7 +219,12 @@ namespace detail
         }
         else if( runMode == bolt::cl::control::MultiCoreCpu )
         {
-            throw ::cl::Error( CL_INVALID_OPERATION, "stable_sort_by_key not implemented yet for MultiCoreCpu" );
+#ifdef ENABLE_TBB
+            detail::tbb_parallel_stable_sort_by_key( ctl, &*keys_first, &*( keys_last - 1 ) + 1, &*values_first, comp );
+#else
+            throw ::cl::Error( CL_INVALID_OPERATION,
+                               "The MultiCoreCpu version of stable_sort_by_key is not enabled to be built." );
+#endif
             return;
         } 
         else 
@@ -242,7 +252,7 @@ namespace detail
     {
         typedef typename std::iterator_traits< DVRandomAccessIterator1 >::value_type keyType;
 
-        size_t vecSize = std::distance( first, last ); 
+        size_t vecSize = std::distance( keys_first, keys_last ); 
         if( vecSize < 2 )
             return;
 
@@ -260,7 +270,18 @@ namespace detail
         }
         else if( runMode == bolt::cl::control::MultiCoreCpu )
         {
-            throw ::cl::Error( CL_INVALID_OPERATION, "stable_sort_by_key not implemented yet for MultiCoreCpu" );
+#ifdef ENABLE_TBB
+            typedef typename std::iterator_traits< DVRandomAccessIterator2 >::value_type valType;
+            typename bolt::cl::device_vector< keyType >::pointer keysPtr = keys_first.getContainer( ).data( );
+            typename bolt::cl::device_vector< valType >::pointer valuesPtr = values_first.getContainer( ).data( );
+            keyType* keysRangeFirst = &keysPtr[ keys_first.m_Index ];
+
+            detail::tbb_parallel_stable_sort_by_key( ctl, keysRangeFirst, keysRangeFirst + vecSize,
+                                                     &valuesPtr[ values_first.m_Index ], comp );
+#else
+            throw ::cl::Error( CL_INVALID_OPERATION,
+                               "The MultiCoreCpu version of stable_sort_by_key is not enabled to be built." );
+#endif
             return;
         } 
         else
@@ -271,13 +292,37 @@ namespace detail
         return;
     }
 
+    /****** stablesort_by_key_enqueue specialization for arithmetic keys with less / greater. ******
+     * The radix sort is stable, so it serves here as well; see radix_sort.inl
+     *********************************************************************/
+    template< typename DVRandomAccessIterator1, typename DVRandomAccessIterator2, typename StrictWeakOrdering >
+    typename std::enable_if< radix_sort_enabled< typename std::iterator_traits< DVRandomAccessIterator1 >::value_type,
+                                                 StrictWeakOrdering
+                                               >::value
+                           >::type
+    stablesort_by_key_enqueue( control& ctrl, 
+                                    const DVRandomAccessIterator1 keys_first, const DVRandomAccessIterator1 keys_last, 
+                                    const DVRandomAccessIterator2 values_first,
+                                    const StrictWeakOrdering& comp, const std::string& cl_code )
+    {
+        typedef typename std::iterator_traits< DVRandomAccessIterator1 >::value_type keyType;
+        bool descending = std::is_same< StrictWeakOrdering, bolt::cl::greater< keyType > >::value;
+        radix_sort_by_key_enqueue( ctrl, keys_first, keys_last, values_first, descending );
+        return;
+    }
+
     template< typename DVRandomAccessIterator1, typename DVRandomAccessIterator2, typename StrictWeakOrdering >
-    void stablesort_by_key_enqueue( control& ctrl, 
+    typename std::enable_if<
+        !radix_sort_enabled< typename std::iterator_traits< DVRandomAccessIterator1 >::value_type, StrictWeakOrdering >::value
+                           >::type
+    stablesort_by_key_enqueue( control& ctrl, 
                                     const DVRandomAccessIterator1 keys_first, const DVRandomAccessIterator1 keys_last, 
                                     const DVRandomAccessIterator2 values_first,
                                     const StrictWeakOrdering& comp, const std::string& cl_code )
     {
         cl_int l_Error;
+        index_require_32( static_cast< size_t >( std::distance( keys_first, keys_last ) ),
+            "The OpenCL path of stable_sort_by_key() takes ranges of fewer than 2^31 elements" );
         cl_uint vecSize = static_cast< cl_uint >( std::distance( keys_first, keys_last ) );
 
         /**********************************************************************************
@@ -369,7 +414,7 @@ namespace detail
         //  Early exit for the case of no merge passes, values are already in destination vector
         if( vecSize <= localRange )
         {
-            wait( ctrl, blockSortEvent );
+            wait( ctrl, blockSortEvent, "stable_sort_by_key" );
             return;
         };
 
@@ -509,11 +554,11 @@ namespace detail
                 vecSize * sizeof( keyType ), NULL, &copyEvent );
             V_OPENCL( l_Error, "device_vector failed to copy data inside of operator=()" );
 
-            wait( ctrl, copyEvent );
+            wait( ctrl, copyEvent, "stable_sort_by_key" );
         }
         else
         {
-            wait( ctrl, kernelEvent );
+            wait( ctrl, kernelEvent, "stable_sort_by_key" );
         }
 
         return;
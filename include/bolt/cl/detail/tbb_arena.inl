@@ -0,0 +1,683 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+/*  Helpers shared by the MultiCoreCpu paths of the algorithms.  All TBB work runs inside a task arena that is owned
+ *  by the control structure, so worker threads are created once instead of on every call, and the concurrency,
+ *  thread pinning and partitioner can be configured through the control.  In NUMA-aware mode the control owns
+ *  one arena per NUMA node instead, and ranges are split across the nodes.  Requires TBB 4.3 or later.
+ */
+
+#if !defined( TBB_ARENA_INL )
+#define TBB_ARENA_INL
+#pragma once
+
+#if defined( ENABLE_TBB )
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/locks.hpp>
+#include "bolt/cl/bolt.h"
+
+#include "tbb/task_arena.h"
+#include "tbb/task_scheduler_observer.h"
+#include "tbb/enumerable_thread_specific.h"
+#include "tbb/partitioner.h"
+#include "tbb/parallel_for.h"
+#include "tbb/parallel_reduce.h"
+#include "tbb/parallel_scan.h"
+#include "tbb/parallel_sort.h"
+#include "tbb/task_group.h"
+#include "tbb/blocked_range.h"
+#include "tbb/atomic.h"
+
+#if defined( _WIN32 )
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+/* \brief Fewest elements a NUMA node is given a part of; smaller ranges stay on the first node */
+#define NUMA_MIN_NODE_ELEMENTS 4096
+
+namespace bolt {
+namespace cl {
+namespace detail {
+
+    //  The affinity a thread had before an arena observer pinned it
+    struct tbbThreadAffinity
+    {
+#if defined( _WIN32 )
+        DWORD_PTR mask;
+#else
+        cpu_set_t cpuSet;
+#endif
+    };
+
+    /*! \brief Restrict the calling thread to a set of logical CPUs, saving its affinity into \p previous
+     *  \details Returns false if the affinity was left alone; failures are otherwise ignored, pinning is only a hint.
+     */
+    inline bool tbb_pin_current_thread( const std::vector< int >& cpus, tbbThreadAffinity& previous )
+    {
+#if defined( _WIN32 )
+        DWORD_PTR mask = 0;
+        for( size_t i = 0; i < cpus.size( ); ++i )
+            mask |= static_cast< DWORD_PTR >( 1 ) << ( cpus[ i ] % ( 8 * sizeof( DWORD_PTR ) ) );
+        previous.mask = ::SetThreadAffinityMask( ::GetCurrentThread( ), mask );
+        return previous.mask != 0;
+#else
+        if( ::pthread_getaffinity_np( ::pthread_self( ), sizeof( cpu_set_t ), &previous.cpuSet ) != 0 )
+            return false;
+        cpu_set_t cpuSet;
+        CPU_ZERO( &cpuSet );
+        for( size_t i = 0; i < cpus.size( ); ++i )
+            CPU_SET( cpus[ i ] % CPU_SETSIZE, &cpuSet );
+        return ::pthread_setaffinity_np( ::pthread_self( ), sizeof( cpu_set_t ), &cpuSet ) == 0;
+#endif
+    }
+
+    //  Give the calling thread back the affinity tbb_pin_current_thread( ) saved
+    inline void tbb_restore_current_thread( const tbbThreadAffinity& previous )
+    {
+#if defined( _WIN32 )
+        ::SetThreadAffinityMask( ::GetCurrentThread( ), previous.mask );
+#else
+        ::pthread_setaffinity_np( ::pthread_self( ), sizeof( cpu_set_t ), &previous.cpuSet );
+#endif
+    }
+
+    /*! \brief Observer that binds the threads of an arena to a list of CPUs while they work in it
+     *  \details With \p pinEach set, each worker is given the next CPU of the list to itself, round robin, the first
+     *  time it enters the arena, and keeps that CPU on every later entry; otherwise every worker may float over the
+     *  whole list, which is what a NUMA node arena wants.  A thread gets its previous affinity back when it leaves,
+     *  since TBB moves workers between arenas.  The application threads that call into the arena are only bound to
+     *  the list of a NUMA node arena, for the time they work in it; with \p pinEach they are not pinned at all.
+     */
+    class tbbPinningObserver: public tbb::task_scheduler_observer
+    {
+        //  The CPU a thread was given, and the affinity to restore when it leaves
+        struct threadState
+        {
+            int cpu;
+            bool pinned;
+            tbbThreadAffinity previous;
+
+            threadState( ): cpu( -1 ), pinned( false )
+            {}
+        };
+
+        std::vector< int > m_cpus;
+        bool m_pinEach;
+        tbb::atomic< unsigned > m_next;
+        tbb::enumerable_thread_specific< threadState > m_threads;
+
+    public:
+        tbbPinningObserver( tbb::task_arena& arena, const std::vector< int >& cpus, bool pinEach ):
+            tbb::task_scheduler_observer( arena ), m_cpus( cpus ), m_pinEach( pinEach )
+        {
+            m_next = 0;
+            if( !m_cpus.empty( ) )
+                observe( true );
+        }
+
+        ~tbbPinningObserver( )
+        {
+            observe( false );
+        }
+
+        void on_scheduler_entry( bool isWorker )
+        {
+            if( !isWorker && m_pinEach )
+                return;
+
+            threadState& state = m_threads.local( );
+            if( m_pinEach )
+            {
+                if( state.cpu < 0 )
+                    state.cpu = m_cpus[ m_next++ % m_cpus.size( ) ];
+                state.pinned = tbb_pin_current_thread( std::vector< int >( 1, state.cpu ), state.previous );
+            }
+            else
+                state.pinned = tbb_pin_current_thread( m_cpus, state.previous );
+        }
+
+        void on_scheduler_exit( bool /* isWorker */ )
+        {
+            threadState& state = m_threads.local( );
+            if( state.pinned )
+                tbb_restore_current_thread( state.previous );
+            state.pinned = false;
+        }
+    };
+
+    /*! \brief One task arena, with the observer that keeps its threads on their CPUs
+     */
+    struct tbbArenaSlot
+    {
+        tbb::task_arena arena;
+        int concurrency;
+        boost::scoped_ptr< tbbPinningObserver > observer;
+
+        tbbArenaSlot( int _concurrency, const std::vector< int >& cpus, bool pinEach ):
+            arena( _concurrency > 0 ? _concurrency : static_cast< int >( tbb::task_arena::automatic ) ),
+            concurrency( _concurrency > 0 ? _concurrency : static_cast< int >( boost::thread::hardware_concurrency( ) ) )
+        {
+            if( !cpus.empty( ) )
+                observer.reset( new tbbPinningObserver( arena, cpus, pinEach ) );
+        }
+    };
+
+    /*! \brief The object cached in a control; a single arena, or one arena per NUMA node
+     */
+    struct tbbArenaHolder
+    {
+        std::vector< boost::shared_ptr< tbbArenaSlot > > arenas;
+    };
+
+    //  The arena cache is private to control; callers hold tbbArenaMutex
+    struct tbbArenaAccess
+    {
+        static boost::shared_ptr< tbbArenaHolder > get( const control& ctl )
+        {
+            return boost::static_pointer_cast< tbbArenaHolder >( ctl.m_tbbArena );
+        }
+
+        static void set( const control& ctl, const boost::shared_ptr< tbbArenaHolder >& holder )
+        {
+            ctl.m_tbbArena = holder;
+        }
+    };
+
+    //  Parse a sysfs cpu list such as "0-7,16-23"
+    inline std::vector< int > numa_parse_cpu_list( const std::string& list )
+    {
+        std::vector< int > cpus;
+        std::istringstream stream( list );
+        std::string token;
+        while( std::getline( stream, token, ',' ) )
+        {
+            int low = 0, high = 0;
+            char dash = 0;
+            std::istringstream range( token );
+            if( !( range >> low ) )
+                continue;
+            high = low;
+            if( range >> dash >> high ) {}
+            for( int cpu = low; cpu <= high; ++cpu )
+                cpus.push_back( cpu );
+        }
+        return cpus;
+    }
+
+    /*! \brief Return the logical CPUs of every NUMA node of the host, queried once
+     *  \details Falls back to a single node holding every CPU if the OS does not report a topology.
+     */
+    inline const std::vector< std::vector< int > >& numa_nodes( )
+    {
+        static std::vector< std::vector< int > > nodes;
+        static bool queried = false;
+
+        boost::lock_guard< boost::mutex > lock( tbbArenaMutex );
+        if( queried )
+            return nodes;
+        queried = true;
+
+#if defined( _WIN32 )
+        ULONG highestNode = 0;
+        if( ::GetNumaHighestNodeNumber( &highestNode ) )
+        {
+            for( ULONG node = 0; node <= highestNode; ++node )
+            {
+                ULONGLONG mask = 0;
+                if( !::GetNumaNodeProcessorMask( static_cast< UCHAR >( node ), &mask ) || mask == 0 )
+                    continue;
+                std::vector< int > cpus;
+                for( int cpu = 0; cpu < 64; ++cpu )
+                    if( mask & ( static_cast< ULONGLONG >( 1 ) << cpu ) )
+                        cpus.push_back( cpu );
+                nodes.push_back( cpus );
+            }
+        }
+#else
+        std::ifstream online( "/sys/devices/system/node/online" );
+        std::string onlineList;
+        if( online && std::getline( online, onlineList ) )
+        {
+            std::vector< int > nodeIds = numa_parse_cpu_list( onlineList );
+            for( size_t n = 0; n < nodeIds.size( ); ++n )
+            {
+                std::ostringstream path;
+                path << "/sys/devices/system/node/node" << nodeIds[ n ] << "/cpulist";
+                std::ifstream cpuFile( path.str( ).c_str( ) );
+                std::string cpuList;
+                if( cpuFile && std::getline( cpuFile, cpuList ) )
+                {
+                    std::vector< int > cpus = numa_parse_cpu_list( cpuList );
+                    if( !cpus.empty( ) )
+                        nodes.push_back( cpus );
+                }
+            }
+        }
+#endif
+
+        if( nodes.empty( ) )
+        {
+            std::vector< int > cpus;
+            int numCpus = static_cast< int >( boost::thread::hardware_concurrency( ) );
+            for( int cpu = 0; cpu < numCpus; ++cpu )
+                cpus.push_back( cpu );
+            nodes.push_back( cpus );
+        }
+
+        return nodes;
+    }
+
+    /*! \brief Return the arenas the MultiCoreCpu paths of \p ctl run in, creating them on first use.
+     *  \details Controls whose arena settings match the default control share the default control's arenas, so
+     *  temporary control objects do not spin up threads of their own.  The arenas are a cache, which is why a
+     *  const control is accepted.  The caller keeps the arenas alive by holding the returned pointer, even if
+     *  another thread changes the settings of the control meanwhile.
+     */
+    inline boost::shared_ptr< tbbArenaHolder > tbb_arena_holder( const control& ctl )
+    {
+        //  Query outside of the lock below; numa_nodes( ) takes the same mutex
+        const std::vector< std::vector< int > >& nodes = numa_nodes( );
+
+        const control& defaultCtl = control::getDefault( );
+        boost::lock_guard< boost::mutex > lock( tbbArenaMutex );
+        const control& owner = ( ctl.getTbbConcurrency( ) == defaultCtl.getTbbConcurrency( ) &&
+                                 ctl.getTbbPinThreads( ) == defaultCtl.getTbbPinThreads( ) &&
+                                 ctl.getNumaAware( ) == defaultCtl.getNumaAware( ) ) ? defaultCtl : ctl;
+
+        boost::shared_ptr< tbbArenaHolder > holder = tbbArenaAccess::get( owner );
+        if( !holder )
+        {
+            holder.reset( new tbbArenaHolder );
+            int concurrency = owner.getTbbConcurrency( );
+
+            if( owner.getNumaAware( ) )
+            {
+                //  One arena per node; a concurrency cap is shared out in proportion to the node sizes
+                size_t totalCpus = 0;
+                for( size_t n = 0; n < nodes.size( ); ++n )
+                    totalCpus += nodes[ n ].size( );
+
+                for( size_t n = 0; n < nodes.size( ); ++n )
+                {
+                    int nodeConcurrency = static_cast< int >( nodes[ n ].size( ) );
+                    if( concurrency > 0 )
+                        nodeConcurrency = std::max( 1, static_cast< int >( concurrency * nodes[ n ].size( ) / totalCpus ) );
+                    holder->arenas.push_back( boost::shared_ptr< tbbArenaSlot >(
+                        new tbbArenaSlot( nodeConcurrency, nodes[ n ], owner.getTbbPinThreads( ) ) ) );
+                }
+            }
+            else
+            {
+                std::vector< int > pinCpus;
+                if( owner.getTbbPinThreads( ) )
+                {
+                    int numCpus = static_cast< int >( boost::thread::hardware_concurrency( ) );
+                    for( int cpu = 0; cpu < numCpus; ++cpu )
+                        pinCpus.push_back( cpu );
+                }
+                holder->arenas.push_back( boost::shared_ptr< tbbArenaSlot >(
+                    new tbbArenaSlot( concurrency, pinCpus, true ) ) );
+            }
+
+            tbbArenaAccess::set( owner, holder );
+        }
+
+        return holder;
+    }
+
+    //  Arena tasks; task_arena::execute takes a functor, so each parallel algorithm gets a small wrapper
+
+    template< typename Range, typename Body >
+    struct tbbParallelForTask
+    {
+        const Range& range;
+        const Body& body;
+        control::e_TbbPartitioner partitioner;
+
+        tbbParallelForTask( const Range& _range, const Body& _body, control::e_TbbPartitioner _partitioner ):
+            range( _range ), body( _body ), partitioner( _partitioner )
+        {}
+
+        void operator( )( ) const
+        {
+            switch( partitioner )
+            {
+            case control::SimplePartitioner:
+                tbb::parallel_for( range, body, tbb::simple_partitioner( ) );
+                break;
+            case control::AffinityPartitioner:
+                {
+                    tbb::affinity_partitioner affinity;
+                    tbb::parallel_for( range, body, affinity );
+                }
+                break;
+            default:
+                tbb::parallel_for( range, body, tbb::auto_partitioner( ) );
+                break;
+            }
+        }
+    };
+
+    template< typename Range, typename Body >
+    struct tbbParallelReduceTask
+    {
+        const Range& range;
+        Body& body;
+        control::e_TbbPartitioner partitioner;
+
+        tbbParallelReduceTask( const Range& _range, Body& _body, control::e_TbbPartitioner _partitioner ):
+            range( _range ), body( _body ), partitioner( _partitioner )
+        {}
+
+        void operator( )( ) const
+        {
+            switch( partitioner )
+            {
+            case control::SimplePartitioner:
+                tbb::parallel_reduce( range, body, tbb::simple_partitioner( ) );
+                break;
+            case control::AffinityPartitioner:
+                {
+                    tbb::affinity_partitioner affinity;
+                    tbb::parallel_reduce( range, body, affinity );
+                }
+                break;
+            default:
+                tbb::parallel_reduce( range, body, tbb::auto_partitioner( ) );
+                break;
+            }
+        }
+    };
+
+    template< typename Range, typename Body >
+    struct tbbParallelScanTask
+    {
+        const Range& range;
+        Body& body;
+        control::e_TbbPartitioner partitioner;
+
+        tbbParallelScanTask( const Range& _range, Body& _body, control::e_TbbPartitioner _partitioner ):
+            range( _range ), body( _body ), partitioner( _partitioner )
+        {}
+
+        void operator( )( ) const
+        {
+            //  parallel_scan does not accept an affinity_partitioner
+            if( partitioner == control::SimplePartitioner )
+                tbb::parallel_scan( range, body, tbb::simple_partitioner( ) );
+            else
+                tbb::parallel_scan( range, body, tbb::auto_partitioner( ) );
+        }
+    };
+
+    template< typename RandomAccessIterator, typename StrictWeakOrdering >
+    struct tbbParallelSortTask
+    {
+        RandomAccessIterator first, last;
+        const StrictWeakOrdering& comp;
+
+        tbbParallelSortTask( RandomAccessIterator _first, RandomAccessIterator _last, const StrictWeakOrdering& _comp ):
+            first( _first ), last( _last ), comp( _comp )
+        {}
+
+        void operator( )( ) const
+        {
+            tbb::parallel_sort( first, last, comp );
+        }
+    };
+
+    //  Entry points used by the algorithms; the range is expected to carry the grain size from
+    //  control::getTbbPartitioner( ) for the calling algorithm.
+
+    template< typename Range, typename Body >
+    void tbb_parallel_for( const control& ctl, const Range& range, const Body& body, control::e_TbbPartitioner partitioner )
+    {
+        tbb_arena_holder( ctl )->arenas.front( )->arena.execute( tbbParallelForTask< Range, Body >( range, body, partitioner ) );
+    }
+
+    template< typename Range, typename Body >
+    void tbb_parallel_reduce( const control& ctl, const Range& range, Body& body, control::e_TbbPartitioner partitioner )
+    {
+        tbb_arena_holder( ctl )->arenas.front( )->arena.execute( tbbParallelReduceTask< Range, Body >( range, body, partitioner ) );
+    }
+
+    template< typename Range, typename Body >
+    void tbb_parallel_scan( const control& ctl, const Range& range, Body& body, control::e_TbbPartitioner partitioner )
+    {
+        tbb_arena_holder( ctl )->arenas.front( )->arena.execute( tbbParallelScanTask< Range, Body >( range, body, partitioner ) );
+    }
+
+    template< typename RandomAccessIterator, typename StrictWeakOrdering >
+    void tbb_parallel_sort( const control& ctl, RandomAccessIterator first, RandomAccessIterator last,
+        const StrictWeakOrdering& comp )
+    {
+        tbb_arena_holder( ctl )->arenas.front( )->arena.execute( tbbParallelSortTask< RandomAccessIterator, StrictWeakOrdering >( first, last, comp ) );
+    }
+
+
+    //  NUMA-aware execution.  A range of n elements is cut into one contiguous part per node, in proportion to the
+    //  node arenas' concurrency; the first-touch helpers use the same cut, so each node later reads pages it owns.
+    //  The cut depends on n and the arenas only, never on an algorithm's grain size, so it is the same for every
+    //  algorithm and for the first touch; the grain size only splits the work within a node.
+
+    /*! \brief Compute the [ offsets[ i ], offsets[ i + 1 ] ) part of n elements that node i processes
+     *  \details Ranges too small to give every node at least NUMA_MIN_NODE_ELEMENTS elements stay on the first node.
+     */
+    inline std::vector< size_t > numa_split( const tbbArenaHolder& holder, size_t n )
+    {
+        size_t numNodes = holder.arenas.size( );
+        if( n < numNodes * NUMA_MIN_NODE_ELEMENTS )
+            numNodes = 1;
+
+        size_t totalConcurrency = 0;
+        for( size_t i = 0; i < numNodes; ++i )
+            totalConcurrency += holder.arenas[ i ]->concurrency;
+
+        std::vector< size_t > offsets( numNodes + 1, 0 );
+        size_t accumulated = 0;
+        for( size_t i = 0; i < numNodes; ++i )
+        {
+            accumulated += holder.arenas[ i ]->concurrency;
+            offsets[ i + 1 ] = ( i + 1 == numNodes ) ? n :
+                static_cast< size_t >( static_cast< double >( n ) * accumulated / totalConcurrency );
+        }
+        return offsets;
+    }
+
+    //  Runs NodeBody( node, first, last ) for one node's part; queued into that node's arena
+    template< typename NodeBody >
+    struct tbbNumaNodeWork
+    {
+        const NodeBody* body;
+        size_t node, first, last;
+
+        tbbNumaNodeWork( const NodeBody& _body, size_t _node, size_t _first, size_t _last ):
+            body( &_body ), node( _node ), first( _first ), last( _last )
+        {}
+
+        void operator( )( ) const
+        {
+            ( *body )( node, first, last );
+        }
+    };
+
+    template< typename NodeBody >
+    struct tbbNumaSpawnTask
+    {
+        tbb::task_group& group;
+        tbbNumaNodeWork< NodeBody > work;
+
+        tbbNumaSpawnTask( tbb::task_group& _group, const tbbNumaNodeWork< NodeBody >& _work ): group( _group ), work( _work )
+        {}
+
+        void operator( )( ) const
+        {
+            group.run( work );
+        }
+    };
+
+    struct tbbNumaWaitTask
+    {
+        tbb::task_group& group;
+
+        tbbNumaWaitTask( tbb::task_group& _group ): group( _group )
+        {}
+
+        void operator( )( ) const
+        {
+            group.wait( );
+        }
+    };
+
+    /*! \brief Call body( node, first, last ) for each node's part of [ 0, n ), each inside its node's arena
+     *  \details The parts are started in every arena first and then waited on, so the nodes run concurrently.
+     */
+    template< typename NodeBody >
+    void tbb_numa_for( const control& ctl, size_t n, const NodeBody& body )
+    {
+        boost::shared_ptr< tbbArenaHolder > holderPtr = tbb_arena_holder( ctl );
+        const tbbArenaHolder& holder = *holderPtr;
+        std::vector< size_t > offsets = numa_split( holder, n );
+        size_t numNodes = offsets.size( ) - 1;
+
+        if( numNodes == 1 )
+        {
+            holder.arenas.front( )->arena.execute( tbbNumaNodeWork< NodeBody >( body, 0, 0, n ) );
+            return;
+        }
+
+        std::vector< boost::shared_ptr< tbb::task_group > > groups;
+        for( size_t i = 0; i < numNodes; ++i )
+        {
+            groups.push_back( boost::shared_ptr< tbb::task_group >( new tbb::task_group ) );
+            holder.arenas[ i ]->arena.execute( tbbNumaSpawnTask< NodeBody >( *groups[ i ],
+                tbbNumaNodeWork< NodeBody >( body, i, offsets[ i ], offsets[ i + 1 ] ) ) );
+        }
+        for( size_t i = 0; i < numNodes; ++i )
+            holder.arenas[ i ]->arena.execute( tbbNumaWaitTask( *groups[ i ] ) );
+    }
+
+    //  Node body for parallel_reduce over T*; each node reduces into its own body
+    template< typename T, typename Body >
+    struct tbbNumaReduceNode
+    {
+        T* first;
+        const std::vector< Body* >& bodies;
+        control::tbbPartitionDesc part;
+
+        tbbNumaReduceNode( T* _first, const std::vector< Body* >& _bodies, const control::tbbPartitionDesc& _part ):
+            first( _first ), bodies( _bodies ), part( _part )
+        {}
+
+        void operator( )( size_t node, size_t begin, size_t end ) const
+        {
+            tbb::blocked_range< T* > range( first + begin, first + end, part.grainSize );
+            tbbParallelReduceTask< tbb::blocked_range< T* >, Body >( range, *bodies[ node ], part.partitioner )( );
+        }
+    };
+
+    /*! \brief NUMA-aware parallel_reduce over [ first, last ); the per-node results are joined into \p body in
+     *  range order, so the reduction operator only needs to be associative.
+     */
+    template< typename T, typename Body >
+    void tbb_numa_parallel_reduce( const control& ctl, T* first, T* last, Body& body,
+        const control::tbbPartitionDesc& part )
+    {
+        size_t n = static_cast< size_t >( last - first );
+        size_t numNodes = numa_split( *tbb_arena_holder( ctl ), n ).size( ) - 1;
+
+        std::vector< Body > splitBodies;
+        splitBodies.reserve( numNodes );
+        for( size_t i = 1; i < numNodes; ++i )
+            splitBodies.push_back( Body( body, tbb::split( ) ) );
+
+        std::vector< Body* > bodies( 1, &body );
+        for( size_t i = 0; i < splitBodies.size( ); ++i )
+            bodies.push_back( &splitBodies[ i ] );
+
+        tbb_numa_for( ctl, n, tbbNumaReduceNode< T, Body >( first, bodies, part ) );
+
+        for( size_t i = 1; i < bodies.size( ); ++i )
+            body.join( *bodies[ i ] );
+    }
+
+    //  Node body that writes a value or copies a sequence into a node's part, so that the node touches its pages first
+    template< typename InputIterator, typename T >
+    struct tbbFirstTouchNode
+    {
+        InputIterator input;
+        bool fill;
+        T value;
+        T* output;
+
+        struct rangeBody
+        {
+            const tbbFirstTouchNode* parent;
+            void operator( )( const tbb::blocked_range< size_t >& r ) const
+            {
+                for( size_t i = r.begin( ); i != r.end( ); ++i )
+                    parent->output[ i ] = parent->fill ? parent->value : static_cast< T >( parent->input[ i ] );
+            }
+        };
+
+        tbbFirstTouchNode( InputIterator _input, bool _fill, const T& _value, T* _output ):
+            input( _input ), fill( _fill ), value( _value ), output( _output )
+        {}
+
+        void operator( )( size_t node, size_t begin, size_t end ) const
+        {
+            rangeBody body = { this };
+            tbb::parallel_for( tbb::blocked_range< size_t >( begin, end, 4096 ), body );
+        }
+    };
+
+    /*! \brief Fill n elements at \p output with \p value, each node writing the part it will later process
+     */
+    template< typename T >
+    void numa_first_touch_fill( const control& ctl, T* output, size_t n, const T& value )
+    {
+        tbb_numa_for( ctl, n,
+            tbbFirstTouchNode< const T*, T >( static_cast< const T* >( NULL ), true, value, output ) );
+    }
+
+    /*! \brief Copy n elements from \p input to \p output, each node writing the part it will later process
+     */
+    template< typename InputIterator, typename T >
+    void numa_first_touch_copy( const control& ctl, InputIterator input, size_t n, T* output )
+    {
+        tbb_numa_for( ctl, n,
+            tbbFirstTouchNode< InputIterator, T >( input, false, T( ), output ) );
+    }
+
+}; // namespace detail
+}; // namespace cl
+}; // namespace bolt
+
+#endif // ENABLE_TBB
+
+#endif // TBB_ARENA_INL
@@ -0,0 +1,281 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+/*  Parallel stable merge sort for the MultiCoreCpu paths of stable_sort and stable_sort_by_key, and the key/value
+ *  zip sort that sort_by_key and stable_sort_by_key share.  The range is cut into chunks that are stable sorted in
+ *  parallel, then sorted runs are merged pairwise until one run is left.  Every merge round is split into blocks of
+ *  output of the chunk size; each block finds where it starts in both input runs with a binary search along the
+ *  merge path, so a round is as parallel as the chunk sort however few runs are left.  Merges take from the left
+ *  run on ties, which keeps the sort stable.
+ */
+
+#if !defined( BOLT_CL_TBB_MERGE_SORT_INL )
+#define BOLT_CL_TBB_MERGE_SORT_INL
+#pragma once
+
+#if defined( ENABLE_TBB )
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include "bolt/cl/detail/tbb_arena.inl"
+
+/* \brief - Fewest elements in a chunk of the parallel stable sort, and in a block of output of its merges */
+#define TBB_MERGE_SORT_MIN_CHUNK 4096
+
+namespace bolt {
+namespace cl {
+namespace detail {
+
+    //  Stable sorts every chunk of the range
+    template< typename T, typename StrictWeakOrdering >
+    struct tbbMergeSortChunks
+    {
+        T* first;
+        size_t length;
+        size_t chunkSize;
+        StrictWeakOrdering comp;
+
+        tbbMergeSortChunks( T* _first, size_t _length, size_t _chunkSize, const StrictWeakOrdering& _comp ):
+            first( _first ), length( _length ), chunkSize( _chunkSize ), comp( _comp )
+        {}
+
+        void operator( )( const tbb::blocked_range< size_t >& chunks ) const
+        {
+            StrictWeakOrdering localComp( comp );
+            for( size_t chunk = chunks.begin( ); chunk != chunks.end( ); ++chunk )
+            {
+                size_t begin = chunk * chunkSize;
+                std::stable_sort( first + begin, first + std::min( begin + chunkSize, length ), localComp );
+            }
+        }
+    };
+
+    /*! \brief Number of elements of \p a among the first \p diagonal outputs of the stable merge of \p a and \p b
+     */
+    template< typename T, typename StrictWeakOrdering >
+    size_t tbb_merge_path( const T* a, size_t aLength, const T* b, size_t bLength, size_t diagonal,
+                           StrictWeakOrdering comp )
+    {
+        size_t low = ( diagonal > bLength ) ? diagonal - bLength : 0;
+        size_t high = std::min( diagonal, aLength );
+        while( low < high )
+        {
+            size_t mid = low + ( high - low ) / 2;
+            if( comp( b[ diagonal - mid - 1 ], a[ mid ] ) )
+                high = mid;
+            else
+                low = mid + 1;
+        }
+        return low;
+    }
+
+    //  One merge round: merges runs of runWidth from src into runs of twice that in dst, blockSize outputs at a time
+    template< typename T, typename StrictWeakOrdering >
+    struct tbbMergeSortRound
+    {
+        const T* src;
+        T* dst;
+        size_t length;
+        size_t runWidth;
+        size_t blockSize;
+        StrictWeakOrdering comp;
+
+        tbbMergeSortRound( const T* _src, T* _dst, size_t _length, size_t _runWidth, size_t _blockSize,
+                           const StrictWeakOrdering& _comp ):
+            src( _src ), dst( _dst ), length( _length ), runWidth( _runWidth ), blockSize( _blockSize ), comp( _comp )
+        {}
+
+        void operator( )( const tbb::blocked_range< size_t >& blocks ) const
+        {
+            StrictWeakOrdering localComp( comp );
+            for( size_t block = blocks.begin( ); block != blocks.end( ); ++block )
+            {
+                // runWidth is a multiple of blockSize, so a block never straddles two merges
+                size_t outBegin = block * blockSize;
+                size_t outEnd = std::min( outBegin + blockSize, length );
+                size_t left = ( outBegin / ( 2 * runWidth ) ) * 2 * runWidth;
+                size_t middle = std::min( left + runWidth, length );
+                size_t right = std::min( left + 2 * runWidth, length );
+
+                const T* a = src + left;
+                const T* b = src + middle;
+                size_t aBegin = tbb_merge_path( a, middle - left, b, right - middle, outBegin - left, localComp );
+                size_t aEnd = tbb_merge_path( a, middle - left, b, right - middle, outEnd - left, localComp );
+                size_t bBegin = outBegin - left - aBegin;
+                size_t bEnd = outEnd - left - aEnd;
+
+                std::merge( a + aBegin, a + aEnd, b + bBegin, b + bEnd, dst + outBegin, localComp );
+            }
+        }
+    };
+
+    template< typename T >
+    struct tbbMergeSortCopy
+    {
+        const T* src;
+        T* dst;
+
+        tbbMergeSortCopy( const T* _src, T* _dst ): src( _src ), dst( _dst )
+        {}
+
+        void operator( )( const tbb::blocked_range< size_t >& range ) const
+        {
+            std::copy( src + range.begin( ), src + range.end( ), dst + range.begin( ) );
+        }
+    };
+
+    /*! \brief Stable sorts [first, last) with the TBB merge sort, in the arena of \p ctl
+     *  \details Uses a buffer the size of the range.  The chunk size is the grain size of the "stable_sort"
+     *  partitioner, but no smaller than TBB_MERGE_SORT_MIN_CHUNK.
+     */
+    template< typename T, typename StrictWeakOrdering >
+    void tbb_parallel_stable_sort( const control& ctl, T* first, T* last, const StrictWeakOrdering& comp )
+    {
+        size_t length = static_cast< size_t >( last - first );
+        control::tbbPartitionDesc part = ctl.getTbbPartitioner( "stable_sort" );
+        size_t chunkSize = std::max< size_t >( part.grainSize, TBB_MERGE_SORT_MIN_CHUNK );
+        if( length <= chunkSize )
+        {
+            std::stable_sort( first, last, comp );
+            return;
+        }
+
+        size_t numChunks = ( length + chunkSize - 1 ) / chunkSize;
+        tbb_parallel_for( ctl, tbb::blocked_range< size_t >( 0, numChunks ),
+                          tbbMergeSortChunks< T, StrictWeakOrdering >( first, length, chunkSize, comp ),
+                          part.partitioner );
+
+        std::vector< T > buffer( first, last );
+        T* src = first;
+        T* dst = &buffer[ 0 ];
+        for( size_t runWidth = chunkSize; runWidth < length; runWidth *= 2 )
+        {
+            tbb_parallel_for( ctl, tbb::blocked_range< size_t >( 0, numChunks ),
+                              tbbMergeSortRound< T, StrictWeakOrdering >( src, dst, length, runWidth, chunkSize, comp ),
+                              part.partitioner );
+            std::swap( src, dst );
+        }
+
+        if( src != first )
+        {
+            tbb_parallel_for( ctl, tbb::blocked_range< size_t >( 0, length, chunkSize ),
+                              tbbMergeSortCopy< T >( src, first ), part.partitioner );
+        }
+    }
+
+    //  Orders key/value pairs by their keys only
+    template< typename Key, typename Value, typename StrictWeakOrdering >
+    struct tbbKeyValueCompare
+    {
+        mutable StrictWeakOrdering comp;
+
+        tbbKeyValueCompare( const StrictWeakOrdering& _comp ): comp( _comp )
+        {}
+
+        bool operator( )( const std::pair< Key, Value >& lhs, const std::pair< Key, Value >& rhs ) const
+        {
+            return comp( lhs.first, rhs.first );
+        }
+    };
+
+    //  Moves keys and values into pairs, or back out of them
+    template< typename Key, typename Value >
+    struct tbbKeyValueZip
+    {
+        Key* keys;
+        Value* values;
+        std::pair< Key, Value >* pairs;
+        bool unzip;
+
+        tbbKeyValueZip( Key* _keys, Value* _values, std::pair< Key, Value >* _pairs, bool _unzip ):
+            keys( _keys ), values( _values ), pairs( _pairs ), unzip( _unzip )
+        {}
+
+        void operator( )( const tbb::blocked_range< size_t >& range ) const
+        {
+            for( size_t i = range.begin( ); i != range.end( ); ++i )
+            {
+                if( unzip )
+                {
+                    keys[ i ] = pairs[ i ].first;
+                    values[ i ] = pairs[ i ].second;
+                }
+                else
+                {
+                    pairs[ i ].first = keys[ i ];
+                    pairs[ i ].second = values[ i ];
+                }
+            }
+        }
+    };
+
+    /*! \brief Sorts the keys in [keysFirst, keysLast), moving the values with them
+     *  \details The keys and values are zipped into pairs, so that the sort moves a key and its value together, and
+     *  unzipped afterwards; both copies run in parallel.  The pairs are sorted with the TBB merge sort when \p stable
+     *  is set, and with tbb::parallel_sort otherwise.
+     */
+    template< typename Key, typename Value, typename StrictWeakOrdering >
+    void tbb_key_value_sort( const control& ctl, Key* keysFirst, Key* keysLast, Value* valuesFirst,
+                             const StrictWeakOrdering& comp, bool stable )
+    {
+        size_t length = static_cast< size_t >( keysLast - keysFirst );
+        if( length < 2 )
+            return;
+
+        control::tbbPartitionDesc part = ctl.getTbbPartitioner( stable ? "stable_sort" : "sort" );
+        size_t grainSize = std::max< size_t >( part.grainSize, TBB_MERGE_SORT_MIN_CHUNK );
+
+        std::vector< std::pair< Key, Value > > pairs( length );
+        tbb_parallel_for( ctl, tbb::blocked_range< size_t >( 0, length, grainSize ),
+                          tbbKeyValueZip< Key, Value >( keysFirst, valuesFirst, &pairs[ 0 ], false ),
+                          part.partitioner );
+
+        tbbKeyValueCompare< Key, Value, StrictWeakOrdering > pairComp( comp );
+        if( stable )
+            tbb_parallel_stable_sort( ctl, &pairs[ 0 ], &pairs[ 0 ] + length, pairComp );
+        else
+            tbb_parallel_sort( ctl, pairs.begin( ), pairs.end( ), pairComp );
+
+        tbb_parallel_for( ctl, tbb::blocked_range< size_t >( 0, length, grainSize ),
+                          tbbKeyValueZip< Key, Value >( keysFirst, valuesFirst, &pairs[ 0 ], true ),
+                          part.partitioner );
+    }
+
+    //! Stable sorts the keys in [keysFirst, keysLast) with the TBB merge sort, moving the values with them
+    template< typename Key, typename Value, typename StrictWeakOrdering >
+    void tbb_parallel_stable_sort_by_key( const control& ctl, Key* keysFirst, Key* keysLast, Value* valuesFirst,
+                                          const StrictWeakOrdering& comp )
+    {
+        tbb_key_value_sort( ctl, keysFirst, keysLast, valuesFirst, comp, true );
+    }
+
+    //! Sorts the keys in [keysFirst, keysLast) with tbb::parallel_sort, moving the values with them
+    template< typename Key, typename Value, typename StrictWeakOrdering >
+    void tbb_parallel_sort_by_key( const control& ctl, Key* keysFirst, Key* keysLast, Value* valuesFirst,
+                                   const StrictWeakOrdering& comp )
+    {
+        tbb_key_value_sort( ctl, keysFirst, keysLast, valuesFirst, comp, false );
+    }
+
+}
+}
+}
+
+#endif
+
+#endif
@@ -0,0 +1,298 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+/*  Parallel selection for the MultiCoreCpu paths of nth_element, partial_sort and top_k.  The range is cut into
+ *  chunks and every chunk keeps its k smallest elements in parallel; the k smallest of the whole range are among
+ *  these candidates, so the answer, or the pivot of rank k - 1, is found in a buffer of numChunks * k elements
+ *  rather than in the range.  An in place selection then partitions the range around the pivot: the chunks count
+ *  their elements less than, equal to and greater than it in parallel, and scatter them to a buffer in parallel.
+ *  When k is not small next to the chunk size, the candidates would not be much smaller than the range, and the
+ *  work goes to the parallel sort, or to std::nth_element, instead.
+ */
+
+#if !defined( BOLT_CL_TBB_SELECT_INL )
+#define BOLT_CL_TBB_SELECT_INL
+#pragma once
+
+#if defined( ENABLE_TBB )
+
+#include <vector>
+#include <algorithm>
+#include "bolt/cl/detail/tbb_arena.inl"
+#include "bolt/cl/detail/tbb_merge_sort.inl"
+
+/* \brief - Fewest elements in a chunk of the parallel selection */
+#define TBB_SELECT_MIN_CHUNK 4096
+
+namespace bolt {
+namespace cl {
+namespace detail {
+
+    //  Copies the k smallest elements of every chunk, in order, to k slots per chunk of candidates
+    template< typename T, typename StrictWeakOrdering >
+    struct tbbSelectCandidates
+    {
+        const T* first;
+        size_t length;
+        size_t chunkSize;
+        size_t k;
+        T* candidates;
+        StrictWeakOrdering comp;
+
+        tbbSelectCandidates( const T* _first, size_t _length, size_t _chunkSize, size_t _k, T* _candidates,
+                             const StrictWeakOrdering& _comp ):
+            first( _first ), length( _length ), chunkSize( _chunkSize ), k( _k ), candidates( _candidates ),
+            comp( _comp )
+        {}
+
+        void operator( )( const tbb::blocked_range< size_t >& chunks ) const
+        {
+            StrictWeakOrdering localComp( comp );
+            for( size_t chunk = chunks.begin( ); chunk != chunks.end( ); ++chunk )
+            {
+                size_t begin = chunk * chunkSize;
+                size_t end = std::min( begin + chunkSize, length );
+                T* out = candidates + chunk * k;
+                std::partial_sort_copy( first + begin, first + end, out, out + std::min( k, end - begin ), localComp );
+            }
+        }
+    };
+
+    //  Counts the elements of every chunk that are less than, equal to and greater than the pivot
+    template< typename T, typename StrictWeakOrdering >
+    struct tbbSelectCount
+    {
+        const T* first;
+        size_t length;
+        size_t chunkSize;
+        T pivot;
+        size_t* counts;
+        StrictWeakOrdering comp;
+
+        tbbSelectCount( const T* _first, size_t _length, size_t _chunkSize, const T& _pivot, size_t* _counts,
+                        const StrictWeakOrdering& _comp ):
+            first( _first ), length( _length ), chunkSize( _chunkSize ), pivot( _pivot ), counts( _counts ),
+            comp( _comp )
+        {}
+
+        void operator( )( const tbb::blocked_range< size_t >& chunks ) const
+        {
+            StrictWeakOrdering localComp( comp );
+            for( size_t chunk = chunks.begin( ); chunk != chunks.end( ); ++chunk )
+            {
+                size_t less = 0, greater = 0;
+                size_t begin = chunk * chunkSize;
+                size_t end = std::min( begin + chunkSize, length );
+                for( size_t i = begin; i != end; ++i )
+                {
+                    if( localComp( first[ i ], pivot ) )
+                        ++less;
+                    else if( localComp( pivot, first[ i ] ) )
+                        ++greater;
+                }
+                counts[ 3 * chunk ] = less;
+                counts[ 3 * chunk + 1 ] = end - begin - less - greater;
+                counts[ 3 * chunk + 2 ] = greater;
+            }
+        }
+    };
+
+    //  Writes the elements of every chunk to dst, starting at the chunk's position in each of the three parts
+    template< typename T, typename StrictWeakOrdering >
+    struct tbbSelectScatter
+    {
+        const T* src;
+        T* dst;
+        size_t length;
+        size_t chunkSize;
+        T pivot;
+        const size_t* starts;
+        StrictWeakOrdering comp;
+
+        tbbSelectScatter( const T* _src, T* _dst, size_t _length, size_t _chunkSize, const T& _pivot,
+                          const size_t* _starts, const StrictWeakOrdering& _comp ):
+            src( _src ), dst( _dst ), length( _length ), chunkSize( _chunkSize ), pivot( _pivot ), starts( _starts ),
+            comp( _comp )
+        {}
+
+        void operator( )( const tbb::blocked_range< size_t >& chunks ) const
+        {
+            StrictWeakOrdering localComp( comp );
+            for( size_t chunk = chunks.begin( ); chunk != chunks.end( ); ++chunk )
+            {
+                size_t less = starts[ 3 * chunk ];
+                size_t equal = starts[ 3 * chunk + 1 ];
+                size_t greater = starts[ 3 * chunk + 2 ];
+                size_t begin = chunk * chunkSize;
+                size_t end = std::min( begin + chunkSize, length );
+                for( size_t i = begin; i != end; ++i )
+                {
+                    if( localComp( src[ i ], pivot ) )
+                        dst[ less++ ] = src[ i ];
+                    else if( localComp( pivot, src[ i ] ) )
+                        dst[ greater++ ] = src[ i ];
+                    else
+                        dst[ equal++ ] = src[ i ];
+                }
+            }
+        }
+    };
+
+    //  The chunk size of the parallel selection of \p k elements out of \p length, or 0 if k is too large for it
+    inline size_t tbb_select_chunk_size( const control& ctl, size_t length, size_t k )
+    {
+        control::tbbPartitionDesc part = ctl.getTbbPartitioner( "partial_sort" );
+        size_t chunkSize = std::max< size_t >( part.grainSize, TBB_SELECT_MIN_CHUNK );
+        if( length <= chunkSize || 4 * k > chunkSize )
+            return 0;
+        return chunkSize;
+    }
+
+    /*! \brief Fills candidates with the k smallest elements of every chunk of [first, first + length)
+     *  \details Only the last chunk can hold fewer than k elements, so the candidates are contiguous.
+     */
+    template< typename T, typename StrictWeakOrdering >
+    void tbb_select_candidates( const control& ctl, const T* first, size_t length, size_t chunkSize, size_t k,
+                                const StrictWeakOrdering& comp, std::vector< T >& candidates )
+    {
+        control::tbbPartitionDesc part = ctl.getTbbPartitioner( "partial_sort" );
+        size_t numChunks = ( length + chunkSize - 1 ) / chunkSize;
+        size_t lastChunk = length - ( numChunks - 1 ) * chunkSize;
+        candidates.resize( ( numChunks - 1 ) * k + std::min( k, lastChunk ) );
+        tbb_parallel_for( ctl, tbb::blocked_range< size_t >( 0, numChunks ),
+                          tbbSelectCandidates< T, StrictWeakOrdering >( first, length, chunkSize, k, &candidates[ 0 ],
+                                                                        comp ),
+                          part.partitioner );
+    }
+
+    /*! \brief Reorders [first, first + length) into the elements less than pivot, those equal to it, and those
+     *  greater than it
+     */
+    template< typename T, typename StrictWeakOrdering >
+    void tbb_select_partition( const control& ctl, T* first, size_t length, size_t chunkSize, const T& pivot,
+                               const StrictWeakOrdering& comp )
+    {
+        control::tbbPartitionDesc part = ctl.getTbbPartitioner( "partial_sort" );
+        size_t numChunks = ( length + chunkSize - 1 ) / chunkSize;
+
+        std::vector< size_t > counts( 3 * numChunks );
+        tbb_parallel_for( ctl, tbb::blocked_range< size_t >( 0, numChunks ),
+                          tbbSelectCount< T, StrictWeakOrdering >( first, length, chunkSize, pivot, &counts[ 0 ], comp ),
+                          part.partitioner );
+
+        //  Turn the counts into the first position of every chunk in each part
+        size_t running = 0;
+        for( size_t kind = 0; kind < 3; ++kind )
+        {
+            for( size_t chunk = 0; chunk < numChunks; ++chunk )
+            {
+                size_t count = counts[ 3 * chunk + kind ];
+                counts[ 3 * chunk + kind ] = running;
+                running += count;
+            }
+        }
+
+        std::vector< T > buffer( length );
+        tbb_parallel_for( ctl, tbb::blocked_range< size_t >( 0, numChunks ),
+                          tbbSelectScatter< T, StrictWeakOrdering >( first, &buffer[ 0 ], length, chunkSize, pivot,
+                                                                     &counts[ 0 ], comp ),
+                          part.partitioner );
+        tbb_parallel_for( ctl, tbb::blocked_range< size_t >( 0, length, chunkSize ),
+                          tbbMergeSortCopy< T >( &buffer[ 0 ], first ), part.partitioner );
+    }
+
+    //! Copies the k smallest elements of [first, last), in order, to out
+    template< typename T, typename StrictWeakOrdering >
+    void tbb_parallel_top_k( const control& ctl, const T* first, const T* last, size_t k, T* out,
+                             const StrictWeakOrdering& comp )
+    {
+        size_t length = static_cast< size_t >( last - first );
+        k = std::min( k, length );
+        if( k == 0 )
+            return;
+
+        size_t chunkSize = tbb_select_chunk_size( ctl, length, k );
+        if( chunkSize == 0 )
+        {
+            std::vector< T > sorted( first, last );
+            tbb_parallel_sort( ctl, sorted.begin( ), sorted.end( ), comp );
+            std::copy( sorted.begin( ), sorted.begin( ) + k, out );
+            return;
+        }
+
+        std::vector< T > candidates;
+        tbb_select_candidates( ctl, first, length, chunkSize, k, comp, candidates );
+        std::partial_sort_copy( candidates.begin( ), candidates.end( ), out, out + k, comp );
+    }
+
+    //! Sorts the k smallest elements of [first, last) into [first, middle); the rest follow in no particular order
+    template< typename T, typename StrictWeakOrdering >
+    void tbb_parallel_partial_sort( const control& ctl, T* first, T* middle, T* last, const StrictWeakOrdering& comp )
+    {
+        size_t length = static_cast< size_t >( last - first );
+        size_t k = static_cast< size_t >( middle - first );
+        if( k == 0 )
+            return;
+
+        size_t chunkSize = tbb_select_chunk_size( ctl, length, k );
+        if( chunkSize == 0 )
+        {
+            tbb_parallel_sort( ctl, first, last, comp );
+            return;
+        }
+
+        std::vector< T > candidates;
+        tbb_select_candidates( ctl, first, length, chunkSize, k, comp, candidates );
+        std::nth_element( candidates.begin( ), candidates.begin( ) + ( k - 1 ), candidates.end( ), comp );
+        T pivot = candidates[ k - 1 ];
+
+        tbb_select_partition( ctl, first, length, chunkSize, pivot, comp );
+        std::sort( first, middle, comp );
+    }
+
+    //! Puts the element of rank nth - first at nth, with no greater element before it and no lesser one after it
+    template< typename T, typename StrictWeakOrdering >
+    void tbb_parallel_nth_element( const control& ctl, T* first, T* nth, T* last, const StrictWeakOrdering& comp )
+    {
+        size_t length = static_cast< size_t >( last - first );
+        size_t k = static_cast< size_t >( nth - first ) + 1;
+        if( k > length )
+            return;
+
+        size_t chunkSize = tbb_select_chunk_size( ctl, length, k );
+        if( chunkSize == 0 )
+        {
+            std::nth_element( first, nth, last, comp );
+            return;
+        }
+
+        std::vector< T > candidates;
+        tbb_select_candidates( ctl, first, length, chunkSize, k, comp, candidates );
+        std::nth_element( candidates.begin( ), candidates.begin( ) + ( k - 1 ), candidates.end( ), comp );
+        T pivot = candidates[ k - 1 ];
+
+        //  Element nth - first has the pivot's rank, so it lands among the elements equal to the pivot
+        tbb_select_partition( ctl, first, length, chunkSize, pivot, comp );
+    }
+
+}
+}
+}
+
+#endif
+
+#endif
@@ -28,6 +28,9 @@
 #endif
 
 #include "bolt/cl/bolt.h"
+#include "bolt/cl/detail/tbb_arena.inl"
+#include "bolt/cl/detail/heterogeneous.inl"
+#include "bolt/cl/detail/index_type.inl"
 #include "bolt/cl/device_vector.h"
 #include "bolt/cl/iterator/iterator_traits.h"
 
@@ -99,7 +102,7 @@ public:
             + binaryTransformKernels[transform_DVInputIterator2] + " B_iter,\n"
             "global " + binaryTransformKernels[transform_oTypeB] + "* Z_ptr,\n"
             + binaryTransformKernels[transform_DVOutputIteratorB] + " Z_iter,\n"
-                "const uint length,\n"
+                "const indexType length,\n"
             "global " + binaryTransformKernels[transform_BinaryFunction] + "* userFunctor);\n\n"
 
                 "// Host generates this instantiation string with user-specified value type and functor\n"
@@ -111,7 +114,7 @@ public:
             + binaryTransformKernels[transform_DVInputIterator2] + " B_iter,\n"
             "global " + binaryTransformKernels[transform_oTypeB] + "* Z_ptr,\n"
             + binaryTransformKernels[transform_DVOutputIteratorB] + " Z_iter,\n"
-                "const uint length,\n"
+                "const indexType length,\n"
             "global " + binaryTransformKernels[transform_BinaryFunction] + "* userFunctor);\n\n";
 
             return templateSpecializationString;
@@ -137,7 +140,7 @@ public:
             + unaryTransformKernels[transform_DVInputIterator] + " A_iter,\n"
             "global " + unaryTransformKernels[transform_oTypeU] + "* Z,\n"
             + unaryTransformKernels[transform_DVOutputIteratorU] + " Z_iter,\n"
-            "const uint length,\n"
+            "const indexType length,\n"
             "global " + unaryTransformKernels[transform_UnaryFunction] + "* userFunctor);\n\n"
 
             "// Host generates this instantiation string with user-specified value type and functor\n"
@@ -147,7 +150,7 @@ public:
             + unaryTransformKernels[transform_DVInputIterator] + " A_iter,\n"
             "global " + unaryTransformKernels[transform_oTypeU] + "* Z,\n"
             + unaryTransformKernels[transform_DVOutputIteratorU] + " Z_iter,\n"
-            "const uint length,\n"
+            "const indexType length,\n"
             "global " +unaryTransformKernels[transform_UnaryFunction] + "* userFunctor);\n\n";
 
             return templateSpecializationString;
@@ -193,6 +196,47 @@ public:
              std::iterator_traits< InputIterator >::iterator_category( ) );
     };
 
+    //  Chunk bodies for the Heterogeneous run mode; each chunk is a regular transform on the worker's control
+    template< typename InputIterator1, typename InputIterator2, typename OutputIterator, typename BinaryFunction >
+    struct heteroTransformBinaryChunk
+    {
+        heteroTransformBinaryChunk( const InputIterator1& first1, const InputIterator2& first2,
+            const OutputIterator& result, const BinaryFunction& f, const std::string& user_code ):
+            m_first1( first1 ), m_first2( first2 ), m_result( result ), m_f( f ), m_userCode( user_code )
+        {}
+
+        void operator( )( control& worker, size_t chunk, size_t first, size_t last )
+        {
+            bolt::cl::transform( worker, m_first1 + first, m_first1 + last, m_first2 + first, m_result + first, m_f,
+                m_userCode );
+        }
+
+        InputIterator1 m_first1;
+        InputIterator2 m_first2;
+        OutputIterator m_result;
+        BinaryFunction m_f;
+        std::string m_userCode;
+    };
+
+    template< typename InputIterator, typename OutputIterator, typename UnaryFunction >
+    struct heteroTransformUnaryChunk
+    {
+        heteroTransformUnaryChunk( const InputIterator& first, const OutputIterator& result, const UnaryFunction& f,
+            const std::string& user_code ):
+            m_first( first ), m_result( result ), m_f( f ), m_userCode( user_code )
+        {}
+
+        void operator( )( control& worker, size_t chunk, size_t first, size_t last )
+        {
+            bolt::cl::transform( worker, m_first + first, m_first + last, m_result + first, m_f, m_userCode );
+        }
+
+        InputIterator m_first;
+        OutputIterator m_result;
+        UnaryFunction m_f;
+        std::string m_userCode;
+    };
+
 #if defined( ENABLE_TBB )
     template< typename tbbInputIterator1, typename tbbInputIterator2, typename tbbOutputIterator, typename tbbFunctor >
     struct transformBinaryRange
@@ -201,7 +245,7 @@ public:
         tbbInputIterator2 first2;
         tbbOutputIterator result;
         tbbFunctor func;
-        static const size_t divSize = 1024;
+        size_t grainSize;
         typedef typename std::iterator_traits< tbbInputIterator1 >::value_type T_input1;
         typedef typename std::iterator_traits< tbbInputIterator2 >::value_type T_input2;
         typedef typename std::iterator_traits< tbbOutputIterator >::value_type T_output;
@@ -212,19 +256,19 @@ public:
 
         bool is_divisible( ) const
         {
-            return (std::distance( first1, last1 ) > divSize);
+            return (std::distance( first1, last1 ) > static_cast< std::ptrdiff_t >( grainSize ));
         }
 
         transformBinaryRange( tbbInputIterator1 begin1, tbbInputIterator1 end1, tbbInputIterator2 begin2,
-            tbbOutputIterator out, tbbFunctor func1 ):
+            tbbOutputIterator out, tbbFunctor func1, size_t grain = 1024 ):
             first1( begin1 ), last1( end1 ),
-            first2( begin2 ), result( out ), func( func1 )
+            first2( begin2 ), result( out ), func( func1 ), grainSize( grain )
         {}
 
         transformBinaryRange( transformBinaryRange& r, tbb::split ): first1( r.first1 ), last1( r.last1 ), first2( r.first2 ),
-            result( r.result ), func( r.func )
+            result( r.result ), func( r.func ), grainSize( r.grainSize )
         {
-            int halfSize = static_cast<int>(std::distance( r.first1, r.last1 ) >> 1);
+            std::ptrdiff_t halfSize = std::distance( r.first1, r.last1 ) >> 1;
             r.last1 = r.first1 + halfSize;
 
             first1 = r.last1;
@@ -239,7 +283,7 @@ public:
         tbbInputIterator1 first1, last1;
         tbbOutputIterator result;
         tbbFunctor func;
-        static const size_t divSize = 1024;
+        size_t grainSize;
 
         bool empty( ) const
         {
@@ -248,17 +292,18 @@ public:
 
         bool is_divisible( ) const
         {
-            return (std::distance( first1, last1 ) > divSize);
+            return (std::distance( first1, last1 ) > static_cast< std::ptrdiff_t >( grainSize ));
         }
 
-        transformUnaryRange( tbbInputIterator1 begin1, tbbInputIterator1 end1, tbbOutputIterator out, tbbFunctor func1 ):
-            first1( begin1 ), last1( end1 ), result( out ), func( func1 )
+        transformUnaryRange( tbbInputIterator1 begin1, tbbInputIterator1 end1, tbbOutputIterator out, tbbFunctor func1,
+            size_t grain = 1024 ):
+            first1( begin1 ), last1( end1 ), result( out ), func( func1 ), grainSize( grain )
         {}
 
         transformUnaryRange( transformUnaryRange& r, tbb::split ): first1( r.first1 ), last1( r.last1 ),
-             result( r.result ), func( r.func )
+             result( r.result ), func( r.func ), grainSize( r.grainSize )
         {
-            int halfSize = static_cast<int>(std::distance( r.first1, r.last1 ) >> 1);
+            std::ptrdiff_t halfSize = std::distance( r.first1, r.last1 ) >> 1;
             r.last1 = r.first1 + halfSize;
 
             first1 = r.last1;
@@ -296,6 +341,94 @@ public:
 #endif
         }
     };
+
+    //  Runs one NUMA node's part of a binary transform inside that node's arena
+    template< typename tbbInputIterator1, typename tbbInputIterator2, typename tbbOutputIterator, typename tbbFunctor >
+    struct transformBinaryNumaNode
+    {
+        tbbInputIterator1 first1;
+        tbbInputIterator2 first2;
+        tbbOutputIterator result;
+        tbbFunctor func;
+        control::tbbPartitionDesc part;
+
+        transformBinaryNumaNode( tbbInputIterator1 begin1, tbbInputIterator2 begin2, tbbOutputIterator out,
+            tbbFunctor func1, const control::tbbPartitionDesc& _part ):
+            first1( begin1 ), first2( begin2 ), result( out ), func( func1 ), part( _part )
+        {}
+
+        void operator( )( size_t node, size_t begin, size_t end ) const
+        {
+            typedef transformBinaryRange< tbbInputIterator1, tbbInputIterator2, tbbOutputIterator, tbbFunctor > rangeType;
+            typedef transformBinaryRangeBody< tbbInputIterator1, tbbInputIterator2, tbbOutputIterator, tbbFunctor > bodyType;
+            rangeType range( first1 + begin, first1 + end, first2 + begin, result + begin, func, part.grainSize );
+            tbbParallelForTask< rangeType, bodyType >( range, bodyType( ), part.partitioner )( );
+        }
+    };
+
+    //  Runs one NUMA node's part of a unary transform inside that node's arena
+    template< typename tbbInputIterator1, typename tbbOutputIterator, typename tbbFunctor >
+    struct transformUnaryNumaNode
+    {
+        tbbInputIterator1 first1;
+        tbbOutputIterator result;
+        tbbFunctor func;
+        control::tbbPartitionDesc part;
+
+        transformUnaryNumaNode( tbbInputIterator1 begin1, tbbOutputIterator out, tbbFunctor func1,
+            const control::tbbPartitionDesc& _part ):
+            first1( begin1 ), result( out ), func( func1 ), part( _part )
+        {}
+
+        void operator( )( size_t node, size_t begin, size_t end ) const
+        {
+            typedef transformUnaryRange< tbbInputIterator1, tbbOutputIterator, tbbFunctor > rangeType;
+            typedef transformUnaryRangeBody< tbbInputIterator1, tbbOutputIterator, tbbFunctor > bodyType;
+            rangeType range( first1 + begin, first1 + end, result + begin, func, part.grainSize );
+            tbbParallelForTask< rangeType, bodyType >( range, bodyType( ), part.partitioner )( );
+        }
+    };
+
+    //  MultiCoreCpu binary transform; splits the range across NUMA nodes if the control asks for it
+    template< typename tbbInputIterator1, typename tbbInputIterator2, typename tbbOutputIterator, typename tbbFunctor >
+    void transform_binary_tbb( control& ctl, const tbbInputIterator1& first1, const tbbInputIterator1& last1,
+        const tbbInputIterator2& first2, const tbbOutputIterator& result, const tbbFunctor& f )
+    {
+        control::tbbPartitionDesc part = ctl.getTbbPartitioner( "transform" );
+        if( ctl.getNumaAware( ) )
+        {
+            detail::tbb_numa_for( ctl, static_cast< size_t >( std::distance( first1, last1 ) ),
+                transformBinaryNumaNode< tbbInputIterator1, tbbInputIterator2, tbbOutputIterator, tbbFunctor >(
+                    first1, first2, result, f, part ) );
+        }
+        else
+        {
+            detail::tbb_parallel_for( ctl,
+                transformBinaryRange< tbbInputIterator1, tbbInputIterator2, tbbOutputIterator, tbbFunctor >(
+                    first1, last1, first2, result, f, part.grainSize ),
+                transformBinaryRangeBody< tbbInputIterator1, tbbInputIterator2, tbbOutputIterator, tbbFunctor >( ),
+                part.partitioner );
+        }
+    }
+
+    //  MultiCoreCpu unary transform; splits the range across NUMA nodes if the control asks for it
+    template< typename tbbInputIterator1, typename tbbOutputIterator, typename tbbFunctor >
+    void transform_unary_tbb( control& ctl, const tbbInputIterator1& first1, const tbbInputIterator1& last1,
+        const tbbOutputIterator& result, const tbbFunctor& f )
+    {
+        control::tbbPartitionDesc part = ctl.getTbbPartitioner( "transform" );
+        if( ctl.getNumaAware( ) )
+        {
+            detail::tbb_numa_for( ctl, static_cast< size_t >( std::distance( first1, last1 ) ),
+                transformUnaryNumaNode< tbbInputIterator1, tbbOutputIterator, tbbFunctor >( first1, result, f, part ) );
+        }
+        else
+        {
+            detail::tbb_parallel_for( ctl,
+                transformUnaryRange< tbbInputIterator1, tbbOutputIterator, tbbFunctor >( first1, last1, result, f, part.grainSize ),
+                transformUnaryRangeBody< tbbInputIterator1, tbbOutputIterator, tbbFunctor >( ), part.partitioner );
+        }
+    }
 #endif
 
     /*! \brief This template function overload is used to seperate device_vector iterators from all other iterators
@@ -320,6 +453,13 @@ public:
         {
            runMode = ctl.getDefaultPathToRun();
         }
+        if( runMode == bolt::cl::control::Heterogeneous )
+        {
+            heteroTransformBinaryChunk< InputIterator1, InputIterator2, OutputIterator, BinaryFunction >
+                body( first1, first2, result, f, user_code );
+            hetero_for( ctl, sz, body );
+            return;
+        }
         if( runMode == bolt::cl::control::SerialCpu )
         {
             std::transform( first1, last1, first2, result, f );
@@ -328,11 +468,7 @@ public:
         else if( runMode == bolt::cl::control::MultiCoreCpu )
         {
 #if defined( ENABLE_TBB )
-                tbb::parallel_for(
-                    transformBinaryRange< InputIterator1, InputIterator2, OutputIterator, BinaryFunction >(
-                        first1, last1, first2, result, f ),
-                    transformBinaryRangeBody< InputIterator1, InputIterator2, OutputIterator, BinaryFunction >( ),
-                    tbb::simple_partitioner( ) );
+                transform_binary_tbb( ctl, first1, last1, first2, result, f );
 #else
                 //std::cout << "The MultiCoreCpu version of Transform is not enabled. " << std ::endl;
                 throw ::cl::Error( CL_INVALID_OPERATION, "The MultiCoreCpu version of transform is not enabled to be built." );
@@ -373,6 +509,13 @@ public:
         {
            runMode = ctl.getDefaultPathToRun();
         }
+        if( runMode == bolt::cl::control::Heterogeneous )
+        {
+            heteroTransformBinaryChunk< InputIterator1, InputIterator2, OutputIterator, BinaryFunction >
+                body( first1, fancyIter, result, f, user_code );
+            hetero_for( ctl, sz, body );
+            return;
+        }
         if( runMode == bolt::cl::control::SerialCpu )
         {
             std::transform( first1, last1, fancyIter, result, f );
@@ -381,11 +524,7 @@ public:
         else if( runMode == bolt::cl::control::MultiCoreCpu )
         {
 #if defined( ENABLE_TBB )
-                tbb::parallel_for(
-                    transformBinaryRange< InputIterator1, InputIterator2, OutputIterator, BinaryFunction >(
-                        first1, last1, fancyIter, result, f ),
-                    transformBinaryRangeBody< InputIterator1, InputIterator2, OutputIterator, BinaryFunction >( ),
-                    tbb::simple_partitioner( ) );
+                transform_binary_tbb( ctl, first1, last1, fancyIter, result, f );
 #else
                 //std::cout << "The MultiCoreCpu version of Transform is not enabled. " << std ::endl;
                 throw ::cl::Error( CL_INVALID_OPERATION, "The MultiCoreCpu version of transform is not enabled to be built." );
@@ -426,6 +565,13 @@ public:
         {
            runMode = ctl.getDefaultPathToRun();
         }
+        if( runMode == bolt::cl::control::Heterogeneous )
+        {
+            heteroTransformBinaryChunk< InputIterator1, InputIterator2, OutputIterator, BinaryFunction >
+                body( fancyIterfirst, first2, result, f, user_code );
+            hetero_for( ctl, sz, body );
+            return;
+        }
         if( runMode == bolt::cl::control::SerialCpu )
         {
             std::transform( fancyIterfirst, fancyIterlast, first2, result, f );
@@ -434,11 +580,7 @@ public:
         else if( runMode == bolt::cl::control::MultiCoreCpu )
         {
 #if defined( ENABLE_TBB )
-                tbb::parallel_for(
-                    transformBinaryRange< InputIterator1, InputIterator2, OutputIterator, BinaryFunction >(
-                        fancyIterfirst, fancyIterlast, first2, result, f ),
-                    transformBinaryRangeBody< InputIterator1, InputIterator2, OutputIterator, BinaryFunction >( ),
-                    tbb::simple_partitioner( ) );
+                transform_binary_tbb( ctl, fancyIterfirst, fancyIterlast, first2, result, f );
 #else
                 //std::cout << "The MultiCoreCpu version of Transform is not enabled. " << std ::endl;
                 throw ::cl::Error( CL_INVALID_OPERATION, "The MultiCoreCpu version of transform is not enabled to be built." );
@@ -503,11 +645,7 @@ public:
             bolt::cl::device_vector< oType >::pointer resPtr =  result.getContainer( ).data( );
 
 #if defined( ENABLE_TBB )
-            tbb::parallel_for(
-                transformBinaryRange< iType1*, iType2*, oType*, BinaryFunction >(
-                    &firstPtr[ first1.m_Index ], &firstPtr[ sz ], &secPtr[ 0 ], &resPtr[ 0 ], f ),
-                transformBinaryRangeBody< iType1*, iType2*, oType*, BinaryFunction >( ),
-                tbb::simple_partitioner( ) );
+            transform_binary_tbb( ctl, &firstPtr[ first1.m_Index ], &firstPtr[ sz ], &secPtr[ 0 ], &resPtr[ 0 ], f );
 #else
              //std::cout << "The MultiCoreCpu version of Transform is not enabled. " << std ::endl;
              throw ::cl::Error( CL_INVALID_OPERATION, "The MultiCoreCpu version of transform is not enabled to be built." );
@@ -560,11 +698,7 @@ public:
             bolt::cl::device_vector< oType >::pointer resPtr =  result.getContainer( ).data( );
 
 #if defined( ENABLE_TBB )
-            tbb::parallel_for(
-                transformBinaryRange< iType1*, DVInputIterator2, oType*, BinaryFunction >(
-                    &firstPtr[ first1.m_Index ], &firstPtr[ sz ], fancyIter, &resPtr[ 0 ], f ),
-                transformBinaryRangeBody< iType1*, DVInputIterator2, oType*, BinaryFunction >( ),
-                tbb::simple_partitioner( ) );
+            transform_binary_tbb( ctl, &firstPtr[ first1.m_Index ], &firstPtr[ sz ], fancyIter, &resPtr[ 0 ], f );
 #else
              //std::cout << "The MultiCoreCpu version of Transform is not enabled. " << std ::endl;
              throw ::cl::Error( CL_INVALID_OPERATION, "The MultiCoreCpu version of transform is not enabled to be built." );
@@ -598,6 +732,12 @@ public:
         {
            runMode = ctl.getDefaultPathToRun();
         }
+        if( runMode == bolt::cl::control::Heterogeneous )
+        {
+            heteroTransformUnaryChunk< InputIterator, OutputIterator, UnaryFunction > body( first, result, f, user_code );
+            hetero_for( ctl, sz, body );
+            return;
+        }
         if( runMode == bolt::cl::control::SerialCpu )
         {
             std::transform( first, last, result, f );
@@ -606,10 +746,7 @@ public:
         else if( runMode == bolt::cl::control::MultiCoreCpu )
         {
 #if defined( ENABLE_TBB )
-            tbb::parallel_for(
-                transformUnaryRange< InputIterator, OutputIterator, UnaryFunction >( first, last, result, f ),
-                transformUnaryRangeBody< InputIterator, OutputIterator, UnaryFunction >( ),
-                tbb::simple_partitioner( ) );
+            transform_unary_tbb( ctl, first, last, result, f );
 #else
              //std::cout << "The MultiCoreCpu version of Transform is not enabled. " << std ::endl;
              throw ::cl::Error( CL_INVALID_OPERATION, "The MultiCoreCpu version of transform is not enabled to be built." );
@@ -673,11 +810,7 @@ public:
             bolt::cl::device_vector< oType >::pointer resPtr = result.getContainer( ).data( );
 
 #if defined( ENABLE_TBB )
-            tbb::parallel_for(
-                transformUnaryRange< iType*, oType*, UnaryFunction >(
-                    &firstPtr[ first.m_Index ], &firstPtr[ sz ], &resPtr[ 0 ], f ),
-                transformUnaryRangeBody< iType*, oType*, UnaryFunction >( ),
-                tbb::simple_partitioner( ) );
+            transform_unary_tbb( ctl, &firstPtr[ first.m_Index ], &firstPtr[ sz ], &resPtr[ 0 ], f );
 #else
              //std::cout << "The MultiCoreCpu version of Transform is not enabled. " << std ::endl;
              throw ::cl::Error( CL_INVALID_OPERATION, "The MultiCoreCpu version of transform is not enabled to be built." );
@@ -698,7 +831,7 @@ public:
         typedef std::iterator_traits<DVInputIterator2>::value_type iType2;
         typedef std::iterator_traits<DVOutputIterator>::value_type oType;
 
-        cl_uint distVec = static_cast< cl_uint >(  first1.distance_to(last1) );
+        size_t distVec = static_cast< size_t >( first1.distance_to( last1 ) );
         if( distVec == 0 )
             return;
 
@@ -765,6 +898,7 @@ public:
         std::string compileOptions;
         std::ostringstream oss;
         oss << " -DKERNELWORKGROUPSIZE=" << kernel_WgSize;
+        oss << index_compile_options( wgMultiple );
         compileOptions = oss.str();
 
         /**********************************************************************************
@@ -791,7 +925,7 @@ public:
         kernels[boundsCheck].setArg( 3, first2.gpuPayloadSize( ), &first2.gpuPayload( ) );
         kernels[boundsCheck].setArg( 4, result.getBuffer( ) );
         kernels[boundsCheck].setArg( 5, result.gpuPayloadSize( ), &result.gpuPayload( ) );
-        kernels[boundsCheck].setArg( 6, distVec );
+        index_set_arg( kernels[boundsCheck], 6, distVec, wgMultiple );
         kernels[boundsCheck].setArg( 7, *userFunctor);
 
         ::cl::Event transformEvent;
@@ -804,7 +938,7 @@ public:
             &transformEvent );
         V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for transform() kernel" );
 
-        ::bolt::cl::wait(ctl, transformEvent);
+        ::bolt::cl::wait(ctl, transformEvent, "transform");
 
         if( 0 )
         {
@@ -826,7 +960,7 @@ public:
         typedef std::iterator_traits<DVInputIterator>::value_type iType;
         typedef std::iterator_traits<DVOutputIterator>::value_type oType;
 
-        cl_uint distVec = static_cast< cl_uint >( std::distance( first, last ) );
+        size_t distVec = static_cast< size_t >( std::distance( first, last ) );
         if( distVec == 0 )
             return;
 
@@ -888,6 +1022,7 @@ public:
         std::string compileOptions;
         std::ostringstream oss;
         oss << " -DKERNELWORKGROUPSIZE=" << kernel_WgSize;
+        oss << index_compile_options( wgMultiple );
         compileOptions = oss.str();
 
         /**********************************************************************************
@@ -913,7 +1048,7 @@ public:
         kernels[boundsCheck].setArg(1, first.gpuPayloadSize( ), &first.gpuPayload( ) );
         kernels[boundsCheck].setArg(2, result.getBuffer( ) );
         kernels[boundsCheck].setArg(3, result.gpuPayloadSize( ), &result.gpuPayload( ) );
-        kernels[boundsCheck].setArg(4, distVec );
+        index_set_arg( kernels[boundsCheck], 4, distVec, wgMultiple );
         kernels[boundsCheck].setArg(5, *userFunctor);
         //k.setArg(3, numElementsPerThread );
 
@@ -927,7 +1062,7 @@ public:
             &transformEvent );
         V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for transform() kernel" );
 
-        ::bolt::cl::wait(ctl, transformEvent);
+        ::bolt::cl::wait(ctl, transformEvent, "transform");
 
         if( 0 )
         {
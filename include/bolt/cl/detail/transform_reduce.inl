@@ -26,12 +26,14 @@
 #include <numeric>
 
 #include "bolt/cl/bolt.h"
+#include "bolt/cl/detail/heterogeneous.inl"
+#include "bolt/cl/detail/index_type.inl"
 
 #ifdef ENABLE_TBB
 //TBB Includes
 #include "tbb/parallel_reduce.h"
 #include "tbb/blocked_range.h"
-#include "tbb/task_scheduler_init.h"
+#include "bolt/cl/detail/tbb_arena.inl"
 #endif
 
 
@@ -60,11 +62,29 @@ namespace cl {
             std::iterator_traits< InputIterator >::iterator_category( ) );
     };
 
+    template<typename InputIterator, typename OutputIterator, typename UnaryFunction, typename T, typename BinaryFunction>
+    void transform_reduce_into( control& ctl, InputIterator first, InputIterator last, OutputIterator result,
+        UnaryFunction transform_op,
+        T init,  BinaryFunction reduce_op, const std::string& user_code )
+    {
+        detail::transform_reduce_into_pick_output( ctl, first, last, result, transform_op, init, reduce_op, user_code,
+            std::iterator_traits< OutputIterator >::iterator_category( ) );
+    };
+
+    template<typename InputIterator, typename OutputIterator, typename UnaryFunction, typename T, typename BinaryFunction>
+    void transform_reduce_into( InputIterator first, InputIterator last, OutputIterator result,
+        UnaryFunction transform_op,
+        T init,  BinaryFunction reduce_op, const std::string& user_code )
+    {
+        detail::transform_reduce_into_pick_output( control::getDefault(), first, last, result, transform_op, init,
+            reduce_op, user_code, std::iterator_traits< OutputIterator >::iterator_category( ) );
+    };
+
 
 namespace  detail {
 
     enum transformReduceTypes {tr_iType, tr_iIterType, tr_oType, tr_UnaryFunction,
-    tr_BinaryFunction, tr_end };
+    tr_BinaryFunction, tr_rType, tr_end };
 
     class TransformReduce_KernelTemplateSpecializer : public KernelTemplateSpecializer
     {
@@ -72,6 +92,7 @@ namespace  detail {
        TransformReduce_KernelTemplateSpecializer() : KernelTemplateSpecializer()
         {
             addKernelName("transform_reduceTemplate");
+            addKernelName("transform_reduceFinal");
         }
 
         const ::std::string operator() ( const ::std::vector<::std::string>& typeNames ) const
@@ -90,6 +111,19 @@ namespace  detail {
                 "global " + typeNames[tr_BinaryFunction] + "* reduceFunctor,\n"
                 "global " + typeNames[tr_oType] + "* result,\n"
                 "local " + typeNames[tr_oType] + "* scratch\n"
+                ");\n\n"
+
+                "// Host generates this instantiation string with user-specified value type and functor\n"
+                "template __attribute__((mangled_name("+name(1)+"Instantiated)))\n"
+                "__attribute__((reqd_work_group_size(64,1,1)))\n"
+                "kernel void "+name(1)+"(\n"
+                "global " + typeNames[tr_oType] + "* partials,\n"
+                "const int numPartials,\n"
+                "const " + typeNames[tr_oType] + " init,\n"
+                "global " + typeNames[tr_BinaryFunction] + "* reduceFunctor,\n"
+                "global " + typeNames[tr_rType] + "* result,\n"
+                "const uint resultIndex,\n"
+                "local " + typeNames[tr_oType] + "* scratch\n"
                 ");\n\n";
                 return templateSpecializationString;
         }
@@ -137,6 +171,95 @@ namespace  detail {
             };
 #endif
 
+        //  Chunk body for the Heterogeneous run mode.  Each chunk is seeded with its own first transformed element,
+        //  so no identity value is needed; the partial results are combined with init in range order afterwards.
+        template<typename InputIterator, typename UnaryFunction, typename T, typename BinaryFunction>
+        struct heteroTransformReduceChunk
+        {
+            heteroTransformReduceChunk( const InputIterator& first, const UnaryFunction& transform_op,
+                const BinaryFunction& reduce_op, const std::string& user_code, std::vector< T >& partials ):
+                m_first( first ), m_transform( transform_op ), m_reduce( reduce_op ), m_userCode( user_code ),
+                m_partials( partials )
+            {}
+
+            void operator( )( control& worker, size_t chunk, size_t first, size_t last )
+            {
+                T seed = m_transform( *( m_first + first ) );
+                m_partials[ chunk ] = bolt::cl::transform_reduce( worker, m_first + first + 1, m_first + last,
+                    m_transform, seed, m_reduce, m_userCode );
+            }
+
+            InputIterator m_first;
+            UnaryFunction m_transform;
+            BinaryFunction m_reduce;
+            std::string m_userCode;
+            std::vector< T >& m_partials;
+        };
+
+
+        //  transform_reduce_into with a host result: reduce, then store the value
+        template<typename InputIterator, typename OutputIterator, typename UnaryFunction, typename T,
+            typename BinaryFunction>
+        void transform_reduce_into_pick_output( control& ctl, const InputIterator& first, const InputIterator& last,
+            const OutputIterator& result, const UnaryFunction& transform_op, const T& init,
+            const BinaryFunction& reduce_op, const std::string& user_code, std::random_access_iterator_tag )
+        {
+            *result = bolt::cl::transform_reduce( ctl, first, last, transform_op, init, reduce_op, user_code );
+        };
+
+        //  transform_reduce_into with a device_vector result: on the OpenCL device the result is written by the second
+        //  stage of the reduction and never read back
+        template<typename InputIterator, typename DVOutputIterator, typename UnaryFunction, typename T,
+            typename BinaryFunction>
+        void transform_reduce_into_pick_output( control& ctl, const InputIterator& first, const InputIterator& last,
+            const DVOutputIterator& result, const UnaryFunction& transform_op, const T& init,
+            const BinaryFunction& reduce_op, const std::string& user_code, bolt::cl::device_vector_tag )
+        {
+            bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
+            if(runMode == bolt::cl::control::Automatic)
+            {
+                runMode = ctl.getDefaultPathToRun();
+            }
+            if( first == last || runMode != bolt::cl::control::OpenCL )
+            {
+                *result = bolt::cl::transform_reduce( ctl, first, last, transform_op, init, reduce_op, user_code );
+                return;
+            }
+            transform_reduce_into_pick_input( ctl, first, last, result, transform_op, init, reduce_op, user_code,
+                std::iterator_traits< InputIterator >::iterator_category( ) );
+        };
+
+        //  The host input is only borrowed by the device, so the reduction completes before returning
+        template<typename InputIterator, typename DVOutputIterator, typename UnaryFunction, typename T,
+            typename BinaryFunction>
+        void transform_reduce_into_pick_input( control& ctl, const InputIterator& first, const InputIterator& last,
+            const DVOutputIterator& result, const UnaryFunction& transform_op, const T& init,
+            const BinaryFunction& reduce_op, const std::string& user_code, std::random_access_iterator_tag )
+        {
+            typedef std::iterator_traits<InputIterator>::value_type iType;
+            device_vector< iType > dvInput( first, last, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, ctl );
+            ::cl::Event reduceEvent = transform_reduce_enqueue_into( ctl, dvInput.begin( ), dvInput.end( ), transform_op,
+                init, reduce_op, result, user_code );
+            bolt::cl::wait( ctl, reduceEvent, "transform_reduce" );
+        };
+
+        template<typename DVInputIterator, typename DVOutputIterator, typename UnaryFunction, typename T,
+            typename BinaryFunction>
+        void transform_reduce_into_pick_input( control& ctl, const DVInputIterator& first, const DVInputIterator& last,
+            const DVOutputIterator& result, const UnaryFunction& transform_op, const T& init,
+            const BinaryFunction& reduce_op, const std::string& user_code, bolt::cl::device_vector_tag )
+        {
+            transform_reduce_enqueue_into( ctl, first, last, transform_op, init, reduce_op, result, user_code );
+        };
+
+        template<typename DVInputIterator, typename DVOutputIterator, typename UnaryFunction, typename T,
+            typename BinaryFunction>
+        void transform_reduce_into_pick_input( control& ctl, const DVInputIterator& first, const DVInputIterator& last,
+            const DVOutputIterator& result, const UnaryFunction& transform_op, const T& init,
+            const BinaryFunction& reduce_op, const std::string& user_code, bolt::cl::fancy_iterator_tag )
+        {
+            transform_reduce_enqueue_into( ctl, first, last, transform_op, init, reduce_op, result, user_code );
+        };
 
         //  The following two functions disallow non-random access functions
         // Wrapper that uses default control class, iterator interface
@@ -183,7 +306,15 @@ namespace  detail {
             {
                 runMode = c.getDefaultPathToRun();
             }
-            if (runMode == bolt::cl::control::SerialCpu)
+            if (runMode == bolt::cl::control::Heterogeneous)
+            {
+                std::vector< oType > partials( hetero_num_chunks( c, szElements ) );
+                heteroTransformReduceChunk< InputIterator, UnaryFunction, oType, BinaryFunction >
+                    body( first, transform_op, reduce_op, user_code, partials );
+                hetero_for( c, szElements, body );
+                return hetero_combine( init, partials, reduce_op );
+            }
+            else if (runMode == bolt::cl::control::SerialCpu)
             {
                 //Create a temporary array to store the transform result;
                 std::vector<oType> output(szElements);
@@ -194,9 +325,10 @@ namespace  detail {
             } else if (runMode == bolt::cl::control::MultiCoreCpu) {
 
 #ifdef ENABLE_TBB
-                    tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
+                    control::tbbPartitionDesc part = c.getTbbPartitioner( "transform_reduce" );
                     Transform_Reduce<oType, UnaryFunction, BinaryFunction> transform_reduce_op(transform_op, reduce_op, init);
-                    tbb::parallel_reduce( tbb::blocked_range<iType*>( &*first, (iType*)&*(last-1) + 1), transform_reduce_op );
+                    detail::tbb_parallel_reduce( c, tbb::blocked_range<iType*>( &*first, (iType*)&*(last-1) + 1, part.grainSize ),
+                        transform_reduce_op, part.partitioner );
                     return transform_reduce_op.value;
 #else
                     //std::cout << "The MultiCoreCpu version of this function is not enabled." << std ::endl;
@@ -260,9 +392,10 @@ namespace  detail {
                                    CL_MAP_READ, 0, sizeof(iType) * szElements, NULL, &multiCoreCPUEvent, &l_Error );
                 multiCoreCPUEvent.wait();
 
-                tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
+                control::tbbPartitionDesc part = c.getTbbPartitioner( "transform_reduce" );
                 Transform_Reduce<oType, UnaryFunction, BinaryFunction> transform_reduce_op(transform_op, reduce_op, init);
-                tbb::parallel_reduce( tbb::blocked_range<iType*>(trans_reduceInputBuffer, (trans_reduceInputBuffer + szElements)), transform_reduce_op );
+                detail::tbb_parallel_reduce( c, tbb::blocked_range<iType*>(trans_reduceInputBuffer, (trans_reduceInputBuffer + szElements),
+                    part.grainSize ), transform_reduce_op, part.partitioner );
                 c.getCommandQueue().enqueueUnmapMemObject(first.getBuffer(), trans_reduceInputBuffer);
                 return transform_reduce_op.value;
 #else
@@ -274,19 +407,27 @@ namespace  detail {
             return  transform_reduce_enqueue( c, first, last, transform_op, init, reduce_op, user_code );
         };
 
-        template<typename DVInputIterator, typename UnaryFunction, typename oType, typename BinaryFunction>
-        oType transform_reduce_enqueue(
+        //  Enqueues both stages of the reduction, the second of which writes the value to result; returns the event of
+        //  the second stage
+        template<typename DVInputIterator, typename UnaryFunction, typename oType, typename BinaryFunction,
+            typename DVOutputIterator>
+        ::cl::Event transform_reduce_enqueue_into(
             control& ctl,
             const DVInputIterator& first,
             const DVInputIterator& last,
             const UnaryFunction& transform_op,
             const oType& init,
             const BinaryFunction& reduce_op,
+            const DVOutputIterator& result,
             const std::string& user_code="")
         {
             unsigned debugMode = 0; //FIXME, use control
+            index_require_32( std::max( static_cast< size_t >( std::distance( first, last ) ),
+                static_cast< size_t >( result.m_Index ) + 1 ),
+                "The OpenCL path of transform_reduce() takes ranges of fewer than 2^31 elements" );
 
             typedef std::iterator_traits< DVInputIterator  >::value_type iType;
+            typedef std::iterator_traits< DVOutputIterator >::value_type rType;
 
             /**********************************************************************************
              * Type Names - used in KernelTemplateSpecializer
@@ -297,6 +438,7 @@ namespace  detail {
             typeNames[tr_oType] = TypeName< oType >::get( );
             typeNames[tr_UnaryFunction] = TypeName< UnaryFunction >::get( );
             typeNames[tr_BinaryFunction] = TypeName< BinaryFunction >::get();
+            typeNames[tr_rType] = TypeName< rType >::get( );
 
             /**********************************************************************************
              * Type Definitions - directrly concatenated into kernel string
@@ -307,6 +449,7 @@ namespace  detail {
             PUSH_BACK_UNIQUE( typeDefinitions, ClCode< oType >::get() )
             PUSH_BACK_UNIQUE( typeDefinitions, ClCode< UnaryFunction >::get() )
             PUSH_BACK_UNIQUE( typeDefinitions, ClCode< BinaryFunction  >::get() )
+            PUSH_BACK_UNIQUE( typeDefinitions, ClCode< rType >::get() )
 
             /**********************************************************************************
              * Calculate Work Size
@@ -346,13 +489,17 @@ namespace  detail {
             // kernels returned in same order as added in KernelTemplaceSpecializer constructor
 
 
-            // Create Buffer wrappers so we can access the host functors, for read or writing in the kernel
+            // The functors are copied into their buffers, because the kernels may run after this function returns
             ALIGNED( 256 ) UnaryFunction aligned_unary( transform_op );
             ALIGNED( 256 ) BinaryFunction aligned_binary( reduce_op );
 
-            control::buffPointer transformFunctor = ctl.acquireBuffer( sizeof( aligned_unary ), CL_MEM_USE_HOST_PTR|CL_MEM_READ_ONLY, &aligned_unary );
-            control::buffPointer reduceFunctor = ctl.acquireBuffer( sizeof( aligned_binary ), CL_MEM_USE_HOST_PTR|CL_MEM_READ_ONLY, &aligned_binary );
-            control::buffPointer result = ctl.acquireBuffer( sizeof( oType ) * numWG, CL_MEM_ALLOC_HOST_PTR|CL_MEM_WRITE_ONLY );
+            ::cl::Buffer transformFunctor( ctl.getContext( ), CL_MEM_COPY_HOST_PTR|CL_MEM_READ_ONLY,
+                sizeof( aligned_unary ), &aligned_unary, &l_Error );
+            V_OPENCL( l_Error, "Error creating the transform functor buffer of transform_reduce()" );
+            ::cl::Buffer reduceFunctor( ctl.getContext( ), CL_MEM_COPY_HOST_PTR|CL_MEM_READ_ONLY,
+                sizeof( aligned_binary ), &aligned_binary, &l_Error );
+            V_OPENCL( l_Error, "Error creating the reduce functor buffer of transform_reduce()" );
+            control::buffPointer partials = ctl.acquireBuffer( sizeof( oType ) * numWG, CL_MEM_READ_WRITE );
 
             cl_uint szElements = static_cast< cl_uint >( std::distance( first, last ) );
 
@@ -366,10 +513,10 @@ namespace  detail {
             V_OPENCL( kernels[0].setArg( 0, first.getBuffer( ) ), "Error setting kernel argument" );
             V_OPENCL( kernels[0].setArg( 1, first.gpuPayloadSize( ), &first.gpuPayload( ) ), "Error setting kernel argument" );
             V_OPENCL( kernels[0].setArg( 2, szElements), "Error setting kernel argument" );
-            V_OPENCL( kernels[0].setArg( 3, *transformFunctor), "Error setting kernel argument" );
+            V_OPENCL( kernels[0].setArg( 3, transformFunctor), "Error setting kernel argument" );
             V_OPENCL( kernels[0].setArg( 4, init), "Error setting kernel argument" );
-            V_OPENCL( kernels[0].setArg( 5, *reduceFunctor), "Error setting kernel argument" );
-            V_OPENCL( kernels[0].setArg( 6, *result), "Error setting kernel argument" );
+            V_OPENCL( kernels[0].setArg( 5, reduceFunctor), "Error setting kernel argument" );
+            V_OPENCL( kernels[0].setArg( 6, *partials), "Error setting kernel argument" );
 
             ::cl::LocalSpaceArg loc;
             loc.size_ = wgSize*sizeof(oType);
@@ -382,22 +529,57 @@ namespace  detail {
                 ::cl::NDRange(wgSize) );
             V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for transform_reduce() kernel" );
 
-            ::cl::Event l_mapEvent;
-            oType *h_result = (oType*)ctl.getCommandQueue().enqueueMapBuffer(*result, false, CL_MAP_READ, 0, sizeof(oType)*numWG, NULL, &l_mapEvent, &l_Error );
-            V_OPENCL( l_Error, "Error calling map on the result buffer" );
-
-            //  Finish the tail end of the reduction on host side; the compute device reduces within the workgroups, with one result per workgroup
+            //  Finish the tail end of the reduction in a single work group; the first kernel reduces within the
+            //  workgroups, with one result per workgroup
             size_t ceilNumWG = static_cast< size_t >( std::ceil( static_cast< float >( szElements ) / wgSize) );
             bolt::cl::minimum< size_t >  min_size_t;
-            size_t numTailReduce = min_size_t( ceilNumWG, numWG );
+            cl_int numTailReduce = static_cast< cl_int >( min_size_t( ceilNumWG, numWG ) );
+            cl_uint resultIndex = static_cast< cl_uint >( result.m_Index );
+
+            V_OPENCL( kernels[1].setArg( 0, *partials), "Error setting kernel argument" );
+            V_OPENCL( kernels[1].setArg( 1, numTailReduce), "Error setting kernel argument" );
+            V_OPENCL( kernels[1].setArg( 2, init), "Error setting kernel argument" );
+            V_OPENCL( kernels[1].setArg( 3, reduceFunctor), "Error setting kernel argument" );
+            V_OPENCL( kernels[1].setArg( 4, result.getBuffer( ) ), "Error setting kernel argument" );
+            V_OPENCL( kernels[1].setArg( 5, resultIndex), "Error setting kernel argument" );
+            V_OPENCL( kernels[1].setArg( 6, loc ), "Error setting kernel argument" );
+
+            ::cl::Event finalEvent;
+            l_Error = ctl.getCommandQueue().enqueueNDRangeKernel(
+                kernels[1],
+                ::cl::NullRange,
+                ::cl::NDRange(wgSize),
+                ::cl::NDRange(wgSize),
+                NULL,
+                &finalEvent );
+            V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for the final transform_reduce() kernel" );
 
-            bolt::cl::wait(ctl, l_mapEvent);
+            return finalEvent;
+        };
 
-            oType acc = static_cast< oType >( init );
-            for(int i = 0; i < numTailReduce; ++i)
-            {
-                acc = reduce_op( acc, h_result[ i ] );
-            }
+        template<typename DVInputIterator, typename UnaryFunction, typename oType, typename BinaryFunction>
+        oType transform_reduce_enqueue(
+            control& ctl,
+            const DVInputIterator& first,
+            const DVInputIterator& last,
+            const UnaryFunction& transform_op,
+            const oType& init,
+            const BinaryFunction& reduce_op,
+            const std::string& user_code="")
+        {
+            control::buffPointer resultBuffer = ctl.acquireBuffer( sizeof( oType ),
+                CL_MEM_ALLOC_HOST_PTR|CL_MEM_READ_WRITE );
+            device_vector< oType > dvResult( *resultBuffer, ctl );
+            transform_reduce_enqueue_into( ctl, first, last, transform_op, init, reduce_op, dvResult.begin( ),
+                user_code );
+
+            //  Only the final value is read back
+            oType acc;
+            ::cl::Event l_readEvent;
+            cl_int l_Error = ctl.getCommandQueue().enqueueReadBuffer( *resultBuffer, CL_FALSE, 0, sizeof( oType ),
+                &acc, NULL, &l_readEvent );
+            V_OPENCL( l_Error, "Error reading the result of transform_reduce()" );
+            bolt::cl::wait(ctl, l_readEvent, "transform_reduce");
 
             return acc;
         };
@@ -36,6 +36,15 @@
 
 #include "bolt/cl/transform.h"
 #include "bolt/cl/bolt.h"
+#include "bolt/cl/detail/scan_lookback.inl"
+#include "bolt/cl/detail/index_type.inl"
+
+#ifdef ENABLE_TBB
+//TBB Includes
+#include "tbb/parallel_scan.h"
+#include "tbb/blocked_range.h"
+#include "bolt/cl/detail/tbb_arena.inl"
+#endif
 
 namespace bolt
 {
@@ -232,6 +241,162 @@ public:
     }
 };
 
+//  The single pass transform scan of scan_lookback_kernels.cl, for devices where scan_lookback_enabled holds
+class TransformScanLookback_KernelTemplateSpecializer : public KernelTemplateSpecializer
+{
+public:
+    TransformScanLookback_KernelTemplateSpecializer() : KernelTemplateSpecializer()
+    {
+        addKernelName("singlePassTransformScan");
+    }
+
+    const ::std::string operator() ( const ::std::vector<::std::string>& typeNames ) const
+    {
+        const std::string templateSpecializationString =
+            "// Dynamic specialization of generic template definition, using user supplied types\n"
+            "template __attribute__((mangled_name(" + name(0) + "Instantiated)))\n"
+            "__attribute__((reqd_work_group_size(SCAN_LOOKBACK_WGSIZE,1,1)))\n"
+            "__kernel void " + name(0) + "(\n"
+            "global " + typeNames[transformScan_oValueType] + "* output_ptr,\n"
+            ""        + typeNames[transformScan_oIterType] + " output_iter,\n"
+            "global " + typeNames[transformScan_iValueType] + "* input_ptr,\n"
+            ""        + typeNames[transformScan_iIterType] + " input_iter,\n"
+            ""        + typeNames[transformScan_initType] + " identity,\n"
+            "const uint vecSize,\n"
+            "local "  + typeNames[transformScan_oValueType] + "* lds,\n"
+            "global " + typeNames[transformScan_UnaryFunction] + "* unaryOp,\n"
+            "global " + typeNames[transformScan_BinaryFunction] + "* binaryOp,\n"
+            "global uint* tileStatus,\n"
+            "global " + typeNames[transformScan_oValueType] + "* tileValues,\n"
+            "int exclusive\n"
+            ");\n\n";
+
+        return templateSpecializationString;
+    }
+};
+
+/*! \brief Scans unary_op of [first, first + numElements) into result on the host
+*   \details Every input is read before its output is written, so result may alias first.
+*/
+template< typename iType, typename oType, typename UnaryFunction, typename BinaryFunction >
+void transform_scan_serial( const iType* first, size_t numElements, oType* result, const UnaryFunction& unary_op,
+    const oType& init, bool inclusive, const BinaryFunction& binary_op )
+{
+    if( inclusive )
+    {
+        oType sum = unary_op( first[ 0 ] );
+        result[ 0 ] = sum;
+        for( size_t i = 1; i < numElements; ++i )
+        {
+            sum = binary_op( sum, unary_op( first[ i ] ) );
+            result[ i ] = sum;
+        }
+    }
+    else
+    {
+        oType sum = init;
+        for( size_t i = 0; i < numElements; ++i )
+        {
+            oType value = unary_op( first[ i ] );
+            result[ i ] = sum;
+            sum = binary_op( sum, value );
+        }
+    }
+}
+
+#ifdef ENABLE_TBB
+/*! \brief tbb::parallel_scan body of transform_scan, with unary_op applied as the elements are scanned
+*   \details The pre scan and the final scan both transform their elements, so no transformed copy of the input is
+*   stored.  sum holds the scan of everything left of the body's ranges, and is empty until the body has seen an
+*   element.  An exclusive scan folds init in at element 0 only, which keeps it out of the partial sums joined later.
+*/
+template< typename iType, typename oType, typename UnaryFunction, typename BinaryFunction >
+struct TransformScan_tbb
+{
+    const iType* input;
+    oType* output;
+    UnaryFunction unary_op;
+    BinaryFunction binary_op;
+    oType init;
+    bool inclusive;
+    oType sum;
+    bool empty;
+
+    TransformScan_tbb( const iType* _input, oType* _output, const UnaryFunction& _unary_op,
+        const BinaryFunction& _binary_op, const oType& _init, bool _inclusive ) :
+        input( _input ), output( _output ), unary_op( _unary_op ), binary_op( _binary_op ), init( _init ),
+        inclusive( _inclusive ), sum( _init ), empty( true )
+    {}
+
+    TransformScan_tbb( TransformScan_tbb& b, tbb::split ) :
+        input( b.input ), output( b.output ), unary_op( b.unary_op ), binary_op( b.binary_op ), init( b.init ),
+        inclusive( b.inclusive ), sum( b.init ), empty( true )
+    {}
+
+    template< typename Tag >
+    void operator( )( const tbb::blocked_range< size_t >& r, Tag )
+    {
+        oType temp = sum;
+        bool tempEmpty = empty;
+        if( tempEmpty && !inclusive && r.begin( ) == 0 )
+        {
+            temp = init;
+            tempEmpty = false;
+        }
+
+        for( size_t i = r.begin( ); i < r.end( ); ++i )
+        {
+            oType value = unary_op( input[ i ] );
+            if( Tag::is_final_scan( ) && !inclusive )
+                output[ i ] = temp;
+            temp = tempEmpty ? value : binary_op( temp, value );
+            tempEmpty = false;
+            if( Tag::is_final_scan( ) && inclusive )
+                output[ i ] = temp;
+        }
+        sum = temp;
+        empty = tempEmpty;
+    }
+
+    //  a holds the elements left of this body's
+    void reverse_join( TransformScan_tbb& a )
+    {
+        if( !a.empty )
+            sum = empty ? a.sum : binary_op( a.sum, sum );
+        empty = empty && a.empty;
+    }
+
+    void assign( TransformScan_tbb& b )
+    {
+        sum = b.sum;
+        empty = b.empty;
+    }
+};
+#endif
+
+/*! \brief Runs transform_scan on the host, serially or with TBB, for the SerialCpu and MultiCoreCpu modes
+*/
+template< typename iType, typename oType, typename UnaryFunction, typename BinaryFunction >
+void transform_scan_cpu( control &ctl, bolt::cl::control::e_RunMode runMode, const iType* first, size_t numElements,
+    oType* result, const UnaryFunction& unary_op, const oType& init, bool inclusive, const BinaryFunction& binary_op )
+{
+    if( runMode == bolt::cl::control::SerialCpu )
+    {
+        transform_scan_serial( first, numElements, result, unary_op, init, inclusive, binary_op );
+        return;
+    }
+
+#ifdef ENABLE_TBB
+    control::tbbPartitionDesc part = ctl.getTbbPartitioner( "transform_scan" );
+    TransformScan_tbb< iType, oType, UnaryFunction, BinaryFunction > body( first, result, unary_op, binary_op, init,
+        inclusive );
+    detail::tbb_parallel_scan( ctl, tbb::blocked_range< size_t >( 0, numElements, part.grainSize ), body,
+        part.partitioner );
+#else
+    throw ::cl::Error( CL_INVALID_OPERATION, "The MultiCoreCpu version of transform_scan function is not enabled to be built." );
+#endif
+}
+
 
 template<
     typename InputIterator,
@@ -315,15 +480,10 @@ transform_scan_pick_iterator(
         runMode = ctl.getDefaultPathToRun();
     }
 
-    if( runMode == bolt::cl::control::SerialCpu )
-    {
-        // TODO fix this
-        std::partial_sum( first, last, result, binary_op );
-        return result;
-    }
-    else if( runMode == bolt::cl::control::MultiCoreCpu )
+    if( runMode == bolt::cl::control::SerialCpu || runMode == bolt::cl::control::MultiCoreCpu )
     {
-        throw ::cl::Error( CL_INVALID_OPERATION, "The MultiCoreCpu version of transform_scan function is not enabled to be built." );
+        transform_scan_cpu( ctl, runMode, &*first, numElements, &*result, unary_op, static_cast< oType >( init ),
+            inclusive, binary_op );
     }
     else
     {
@@ -380,17 +540,23 @@ transform_scan_pick_iterator(
         runMode = ctl.getDefaultPathToRun();
     }
 
-    if( runMode == bolt::cl::control::SerialCpu )
+    if( runMode == bolt::cl::control::SerialCpu || runMode == bolt::cl::control::MultiCoreCpu )
     {
-        //  TODO:  Need access to the device_vector .data method to get a host pointer
-        throw ::cl::Error( CL_INVALID_DEVICE, "Scan device_vector CPU device not implemented" );
-        return result;
-    }
-    else if( runMode == bolt::cl::control::MultiCoreCpu )
-    {
-        //  TODO:  Need access to the device_vector .data method to get a host pointer
-        throw ::cl::Error( CL_INVALID_DEVICE, "Scan device_vector CPU device not implemented" );
-        return result;
+        //  An in place scan maps its buffer once; two mappings of one buffer would each be written back on unmap
+        typename device_vector< oType >::pointer resultPtr = result.getContainer( ).data( );
+        typename device_vector< iType >::pointer inputPtr;
+        const iType* input;
+        if( first.getBuffer( )( ) == result.getBuffer( )( ) )
+            input = reinterpret_cast< const iType* >( resultPtr.get( ) ) + first.m_Index;
+        else
+        {
+            inputPtr = first.getContainer( ).data( );
+            input = inputPtr.get( ) + first.m_Index;
+        }
+
+        transform_scan_cpu( ctl, runMode, input, numElements, resultPtr.get( ) + result.m_Index, unary_op,
+            static_cast< oType >( init ), inclusive, binary_op );
+        return result + numElements;
     }
 
     //Now call the actual cl algorithm
@@ -428,6 +594,9 @@ aProfiler.set(AsyncProfiler::device, control::SerialCpu);
 size_t k0_stepNum, k1_stepNum, k2_stepNum;
 #endif
     cl_int l_Error;
+    index_require_32( static_cast< size_t >( std::distance( first, last ) ),
+        "The OpenCL path of transform_inclusive_scan() and transform_exclusive_scan() takes ranges of fewer than 2^31 "
+        "elements" );
 
     /**********************************************************************************
      * Type Names - used in KernelTemplateSpecializer
@@ -455,6 +624,56 @@ size_t k0_stepNum, k1_stepNum, k2_stepNum;
     PUSH_BACK_UNIQUE( typeDefinitions, ClCode< UnaryFunction >::get() )
     PUSH_BACK_UNIQUE( typeDefinitions, ClCode< BinaryFunction >::get() )
 
+    /**********************************************************************************
+     * Single Pass Scan
+     *********************************************************************************/
+    if( scan_lookback_enabled( ctl, sizeof( oType ) ) )
+    {
+        cl_uint vecSize = static_cast< cl_uint >( std::distance( first, last ) );
+        if( vecSize == 0 )
+            return;
+        cl_uint numTiles = scan_lookback_tiles( vecSize );
+
+        TransformScanLookback_KernelTemplateSpecializer lookback_kts;
+        std::vector< ::cl::Kernel > lookbackKernels = bolt::cl::getKernels(
+            ctl,
+            typeNames,
+            &lookback_kts,
+            typeDefinitions,
+            scan_lookback_kernels,
+            scan_lookback_compile_options( ) );
+
+        ALIGNED( 256 ) UnaryFunction aligned_unary_op( unary_op );
+        control::buffPointer unaryBuffer = ctl.acquireBuffer( sizeof( aligned_unary_op ),
+            CL_MEM_USE_HOST_PTR|CL_MEM_READ_ONLY, &aligned_unary_op );
+        ALIGNED( 256 ) BinaryFunction aligned_binary_op( binary_op );
+        control::buffPointer binaryBuffer = ctl.acquireBuffer( sizeof( aligned_binary_op ),
+            CL_MEM_USE_HOST_PTR|CL_MEM_READ_ONLY, &aligned_binary_op );
+        control::buffPointer tileStatus = scan_lookback_status( ctl, numTiles );
+        control::buffPointer tileValues = ctl.acquireBuffer( 2 * numTiles * sizeof( oType ) );
+        cl_uint ldsSize = static_cast< cl_uint >( scan_lookback_lds_size( sizeof( oType ) ) );
+        cl_uint doExclusiveScan = inclusive ? 0 : 1;
+
+        ::cl::Kernel& lookbackKernel = lookbackKernels[ 0 ];
+        V_OPENCL( lookbackKernel.setArg( 0, result.getBuffer( ) ), "Error setArg lookbackKernel" );
+        V_OPENCL( lookbackKernel.setArg( 1, result.gpuPayloadSize( ), &result.gpuPayload( ) ),
+                  "Error setArg lookbackKernel" );
+        V_OPENCL( lookbackKernel.setArg( 2, first.getBuffer( ) ), "Error setArg lookbackKernel" );
+        V_OPENCL( lookbackKernel.setArg( 3, first.gpuPayloadSize( ), &first.gpuPayload( ) ),
+                  "Error setArg lookbackKernel" );
+        V_OPENCL( lookbackKernel.setArg( 4, init_T ), "Error setArg lookbackKernel" );
+        V_OPENCL( lookbackKernel.setArg( 5, vecSize ), "Error setArg lookbackKernel" );
+        V_OPENCL( lookbackKernel.setArg( 6, ldsSize, NULL ), "Error setArg lookbackKernel" );
+        V_OPENCL( lookbackKernel.setArg( 7, *unaryBuffer ), "Error setArg lookbackKernel" );
+        V_OPENCL( lookbackKernel.setArg( 8, *binaryBuffer ), "Error setArg lookbackKernel" );
+        V_OPENCL( lookbackKernel.setArg( 9, *tileStatus ), "Error setArg lookbackKernel" );
+        V_OPENCL( lookbackKernel.setArg( 10, *tileValues ), "Error setArg lookbackKernel" );
+        V_OPENCL( lookbackKernel.setArg( 11, doExclusiveScan ), "Error setArg lookbackKernel" );
+
+        scan_lookback_run( ctl, lookbackKernel, numTiles, "transform_scan" );
+        return;
+    }
+
     /**********************************************************************************
      * Compile Options
      *********************************************************************************/
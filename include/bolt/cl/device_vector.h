@@ -27,6 +27,7 @@
 #include <numeric>
 #include "bolt/cl/bolt.h"
 #include "bolt/cl/iterator/iterator_traits.h"
+#include "bolt/cl/detail/tbb_arena.inl"
 
 #include <boost/iterator/iterator_facade.hpp>
 #include <boost/iterator/reverse_iterator.hpp>
@@ -192,20 +193,21 @@ namespace cl
             *   \bug operator[] with device_vector iterators result in a compile-time error when accessed for reading.
             *   Writing with operator[] appears to be OK.  Workarounds: either use the operator[] on the device_vector
             *   container, or use iterator arithmetic instead, such as *(iter + 5) for reading from the iterator.
-        *   \note The difference_type for this iterator has been explicitely set to a 32-bit int, because m_Index 
-        *   is used in clSetKernelArg(), which does not accept size_t parameters
+        *   \note The difference_type for this iterator is ptrdiff_t, so ranges may pass 2^31 elements; m_Index is
+        *   cast to the width of a kernel argument before it reaches clSetKernelArg()
             */
             template< typename Container >
         class iterator_base: public boost::iterator_facade< iterator_base< Container >, value_type, device_vector_tag, 
-            typename device_vector::reference, int >
+            typename device_vector::reference, ptrdiff_t >
             {
             public:
                 typedef typename iterator_facade::difference_type difference_type;
 
+            //  Mirrors the device side iterator in deviceVectorIteratorTemplate, whose fields are 64 bit on any device
             struct Payload
             {
-                typename iterator_facade::difference_type m_Index;
-                typename iterator_facade::difference_type m_Ptr;        // This is a pseudo 32bit pointer stub
+                cl_ulong m_Index;
+                cl_ulong m_Ptr;        // This is a pseudo pointer stub, wide enough for a 64bit device pointer
             };
 
                 //  Basic constructor requires a reference to the container and a positional element
@@ -268,7 +270,7 @@ namespace cl
 
             Payload gpuPayload( ) const
             {
-                Payload payload = { m_Index, 0 };
+                Payload payload = { static_cast< cl_ulong >( m_Index ), 0 };
                 return payload;
             }
 
@@ -336,7 +338,7 @@ namespace cl
             */
             
             template< typename Container >
-            class reverse_iterator_base: public boost::iterator_facade< reverse_iterator_base< Container >, value_type, std::random_access_iterator_tag, typename device_vector::reference, int >
+            class reverse_iterator_base: public boost::iterator_facade< reverse_iterator_base< Container >, value_type, std::random_access_iterator_tag, typename device_vector::reference, ptrdiff_t >
             {
             public:
 
@@ -480,6 +482,20 @@ namespace cl
                 {
                     m_devMemory = ::cl::Buffer( l_Context, m_Flags, m_Size * sizeof( value_type ) );
 
+#if defined( ENABLE_TBB )
+                    if( init && numaFirstTouch( ctl ) )
+                    {
+                        naked_pointer pointer = static_cast< naked_pointer >( m_commQueue.enqueueMapBuffer(
+                            m_devMemory, CL_TRUE, CL_MAP_WRITE_INVALIDATE_REGION, 0, m_Size * sizeof( value_type ), 0, 0, &l_Error ) );
+                        V_OPENCL( l_Error, "enqueueMapBuffer failed in device_vector constructor" );
+                        detail::numa_first_touch_fill( ctl, pointer, m_Size, value );
+                        ::cl::Event unmapEvent;
+                        l_Error = m_commQueue.enqueueUnmapMemObject( m_devMemory, pointer, 0, &unmapEvent );
+                        V_OPENCL( l_Error, "enqueueUnmapMemObject failed in device_vector constructor" );
+                        V_OPENCL( unmapEvent.wait( ), "failed to wait for unmap event" );
+                        init = false;
+                    }
+#endif
                     if( init )
                     {
                         std::vector< ::cl::Event > fillEvent( 1 );
@@ -553,6 +569,10 @@ namespace cl
                         naked_pointer pointer = static_cast< naked_pointer >( m_commQueue.enqueueMapBuffer( 
                             m_devMemory, CL_TRUE, CL_MEM_WRITE_ONLY, 0, byteSize, 0, 0, &l_Error) );
                         V_OPENCL( l_Error, "enqueueMapBuffer failed in device_vector constructor" );
+#if defined( ENABLE_TBB )
+                        if( !numaFirstTouchCopy( ctl, begin, m_Size, pointer,
+                                typename std::iterator_traits< InputIterator >::iterator_category( ) ) )
+#endif
 #if (_WIN32)
                         std::copy( begin, begin + m_Size, stdext::checked_array_iterator< naked_pointer >( pointer, m_Size ) );
 #else
@@ -601,6 +621,10 @@ namespace cl
                     naked_pointer pointer = static_cast< naked_pointer >( m_commQueue.enqueueMapBuffer( 
                         m_devMemory, CL_TRUE, CL_MEM_WRITE_ONLY, 0, byteSize, 0, 0, &l_Error) );
                     V_OPENCL( l_Error, "enqueueMapBuffer failed in device_vector constructor" );
+#if defined( ENABLE_TBB )
+                    if( !numaFirstTouchCopy( ctl, begin, m_Size, pointer,
+                            typename std::iterator_traits< InputIterator >::iterator_category( ) ) )
+#endif
 #if (_WIN32)
                     std::copy( begin, end, stdext::checked_array_iterator< naked_pointer >( pointer, m_Size ) );
 #else
@@ -1478,6 +1502,39 @@ namespace cl
             }
 
         private:
+#if defined( ENABLE_TBB )
+            //  A NUMA-aware control on a CPU device has each node first-touch the part of the buffer it later processes
+            static bool numaFirstTouch( const control& ctl )
+            {
+                return ctl.getNumaAware( ) && ( ctl.getDevice( ).getInfo< CL_DEVICE_TYPE >( ) & CL_DEVICE_TYPE_CPU ) != 0;
+            }
+
+            //  Only plain random access host iterators are copied in parallel; returns false if the caller must copy
+            template< typename InputIterator >
+            static bool numaFirstTouchCopy( const control& ctl, const InputIterator& begin, size_type n,
+                naked_pointer pointer, std::random_access_iterator_tag )
+            {
+                if( !numaFirstTouch( ctl ) )
+                    return false;
+                detail::numa_first_touch_copy( ctl, begin, n, pointer );
+                return true;
+            }
+
+            template< typename InputIterator >
+            static bool numaFirstTouchCopy( const control& ctl, const InputIterator& begin, size_type n,
+                naked_pointer pointer, std::input_iterator_tag )
+            {
+                return false;
+            }
+
+            template< typename InputIterator >
+            static bool numaFirstTouchCopy( const control& ctl, const InputIterator& begin, size_type n,
+                naked_pointer pointer, device_vector_tag )
+            {
+                return false;
+            }
+#endif
+
             ::cl::Buffer m_devMemory;
             ::cl::CommandQueue m_commQueue;
             size_type m_Size;
@@ -1519,7 +1576,7 @@ namespace cl
                     return m_Ptr[ m_StartIndex + threadID ]; \n
                 } \n
 
-                size_type m_StartIndex; \n
+                ulong m_StartIndex; \n
                 global value_type* m_Ptr; \n
             }; \n
         }; \n
@@ -1534,5 +1591,6 @@ BOLT_CREATE_CLCODE( bolt::cl::device_vector< int >::iterator, bolt::cl::deviceVe
 BOLT_TEMPLATE_REGISTER_NEW_ITERATOR( bolt::cl::device_vector, int, unsigned int );
 BOLT_TEMPLATE_REGISTER_NEW_ITERATOR( bolt::cl::device_vector, int, float );
 BOLT_TEMPLATE_REGISTER_NEW_ITERATOR( bolt::cl::device_vector, int, double );
+BOLT_TEMPLATE_REGISTER_NEW_ITERATOR( bolt::cl::device_vector, int, cl_ulong );
 
 #endif
@@ -18,7 +18,7 @@ __kernel
 void fill_kernel(
     const T src,
     global Type * dst,
-    const uint numElements )
+    const indexType numElements )
 {
     size_t gloId = get_global_id( 0 );
     if( gloId >= numElements ) return; // on SI this doesn't mess-up barriers
@@ -54,6 +54,14 @@ struct negate
 }; 
 );
 
+static const std::string identityFunctor = BOLT_HOST_DEVICE_DEFINITION(
+template< typename T >
+struct identity
+{
+    T operator()(const T& x) const {return x;}
+};
+);
+
 /******************************************************************************
  * Binary Operators
  *****************************************************************************/
@@ -232,6 +240,9 @@ BOLT_CREATE_CLCODE( bolt::cl::cube< int >, bolt::cl::cubeFunctor );
 BOLT_CREATE_TYPENAME( bolt::cl::negate< int > );
 BOLT_CREATE_CLCODE( bolt::cl::negate< int >, bolt::cl::negateFunctor );
 
+BOLT_CREATE_TYPENAME( bolt::cl::identity< int > );
+BOLT_CREATE_CLCODE( bolt::cl::identity< int >, bolt::cl::identityFunctor );
+
 BOLT_CREATE_TYPENAME( bolt::cl::plus< int > );
 BOLT_CREATE_CLCODE( bolt::cl::plus< int >, bolt::cl::plusFunctor );
 
@@ -301,9 +312,14 @@ BOLT_TEMPLATE_REGISTER_NEW_TYPE( bolt::cl::negate, int, unsigned int );
 BOLT_TEMPLATE_REGISTER_NEW_TYPE( bolt::cl::negate, int, float );
 BOLT_TEMPLATE_REGISTER_NEW_TYPE( bolt::cl::negate, int, double );
 
+BOLT_TEMPLATE_REGISTER_NEW_TYPE( bolt::cl::identity, int, unsigned int );
+BOLT_TEMPLATE_REGISTER_NEW_TYPE( bolt::cl::identity, int, float );
+BOLT_TEMPLATE_REGISTER_NEW_TYPE( bolt::cl::identity, int, double );
+
 BOLT_TEMPLATE_REGISTER_NEW_TYPE( bolt::cl::plus, int, unsigned int );
 BOLT_TEMPLATE_REGISTER_NEW_TYPE( bolt::cl::plus, int, float );
 BOLT_TEMPLATE_REGISTER_NEW_TYPE( bolt::cl::plus, int, double );
+BOLT_TEMPLATE_REGISTER_NEW_TYPE( bolt::cl::plus, int, cl_ulong );
 
 BOLT_TEMPLATE_REGISTER_NEW_TYPE( bolt::cl::minus, int, unsigned int );
 BOLT_TEMPLATE_REGISTER_NEW_TYPE( bolt::cl::minus, int, float );
@@ -22,10 +22,10 @@ template <typename oType, typename Generator>
 __kernel
 void generate_I(
     global oType * restrict dst,
-    const int numElements,
+    const indexType numElements,
     global Generator * restrict genPtr)
 {
-    int gloIdx = get_global_id(0);
+    indexType gloIdx = get_global_id(0);
 #if BOUNDARY_CHECK
     if (gloIdx < numElements)
 #endif
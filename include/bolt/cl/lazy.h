@@ -0,0 +1,370 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#if !defined( BOLT_CL_LAZY_H )
+#define BOLT_CL_LAZY_H
+#pragma once
+
+#include <bolt/cl/bolt.h>
+#include <bolt/cl/transform.h>
+#include <bolt/cl/transform_reduce.h>
+#include <bolt/cl/transform_scan.h>
+
+#include <string>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+
+/*! \file bolt/cl/lazy.h
+    \brief Lazy transform pipelines that fuse chained transforms into the following reduce or scan.
+*/
+
+namespace bolt {
+    namespace cl {
+
+        /*! \brief Function object that applies \p Inner, then \p Outer.
+         *  \details The same definition is compiled for the host and the device, so the object can be copied into
+         *  a kernel argument like any other Bolt functor.  The intermediate value only lives in a register.
+         */
+        static const std::string lazyComposeFunctor = BOLT_HOST_DEVICE_DEFINITION(
+        template< typename Outer, typename Inner, typename Argument, typename Intermediate, typename Result >
+        struct lazy_compose
+        {
+            Inner inner;
+            Outer outer;
+
+            Result operator( )( const Argument& x )
+            {
+                Intermediate y = inner( x );
+                return outer( y );
+            }
+        };
+        );
+
+    namespace detail {
+
+        //  The value type produced by calling Function on an Argument
+        template< typename Function, typename Argument >
+        struct lazy_result
+        {
+            static Function& function( );
+            static const Argument& argument( );
+
+            typedef typename std::remove_cv< typename std::remove_reference<
+                decltype( function( )( argument( ) ) ) >::type >::type type;
+        };
+
+        inline void lazy_push_code( std::vector< std::string >& definitions, const std::string& code )
+        {
+            if( !code.empty( ) && std::find( definitions.begin( ), definitions.end( ), code ) == definitions.end( ) )
+                definitions.push_back( code );
+        }
+
+        //  Collects the device code of a pipeline functor; a composition contributes the code of every stage and of
+        //  every intermediate type once, so a functor that appears in several stages is not defined twice in the
+        //  kernel.  The argument and result types of the whole pipeline are left to the algorithm, which defines them
+        template< typename Function >
+        struct lazy_code
+        {
+            static void collect( std::vector< std::string >& definitions )
+            {
+                lazy_push_code( definitions, ClCode< Function >::get( ) );
+            }
+        };
+
+        template< typename Outer, typename Inner, typename Argument, typename Intermediate, typename Result >
+        struct lazy_code< lazy_compose< Outer, Inner, Argument, Intermediate, Result > >
+        {
+            static void collect( std::vector< std::string >& definitions )
+            {
+                lazy_push_code( definitions, ClCode< Intermediate >::get( ) );
+                lazy_code< Inner >::collect( definitions );
+                lazy_code< Outer >::collect( definitions );
+                lazy_push_code( definitions, lazyComposeFunctor );
+            }
+        };
+
+    };
+
+    namespace lazy {
+
+        /*! \addtogroup algorithms
+         */
+
+        /*! \addtogroup CL-lazy
+        *   \ingroup algorithms
+        *   \{
+        */
+
+        template< typename UnaryFunction >
+        struct transform_stage
+        {
+            transform_stage( const UnaryFunction& f ): function( f ) {}
+
+            UnaryFunction function;
+        };
+
+        template< typename T, typename BinaryFunction >
+        struct reduce_stage
+        {
+            reduce_stage( const T& i, const BinaryFunction& op ): init( i ), reduce_op( op ) {}
+
+            T init;
+            BinaryFunction reduce_op;
+        };
+
+        template< typename OutputIterator, typename BinaryFunction >
+        struct inclusive_scan_stage
+        {
+            inclusive_scan_stage( OutputIterator r, const BinaryFunction& op ): result( r ), scan_op( op ) {}
+
+            OutputIterator result;
+            BinaryFunction scan_op;
+        };
+
+        template< typename OutputIterator, typename T, typename BinaryFunction >
+        struct exclusive_scan_stage
+        {
+            exclusive_scan_stage( OutputIterator r, const T& i, const BinaryFunction& op ):
+                result( r ), init( i ), scan_op( op ) {}
+
+            OutputIterator result;
+            T init;
+            BinaryFunction scan_op;
+        };
+
+        template< typename OutputIterator >
+        struct copy_stage
+        {
+            copy_stage( OutputIterator r ): result( r ) {}
+
+            OutputIterator result;
+        };
+
+        /*! \brief An unevaluated transform over an input range.
+         *  \details No kernel runs and no memory is touched until the expression is piped into a terminal stage
+         *  (reduce, inclusive_scan, exclusive_scan or copy).  Piping into another transform composes the two
+         *  functors, so however many transforms are chained, the terminal stage launches the single
+         *  transform_reduce, transform_scan or transform kernel it would launch for one transform.
+         */
+        template< typename InputIterator, typename UnaryFunction >
+        class transform_expression
+        {
+        public:
+            typedef typename std::iterator_traits< InputIterator >::value_type input_type;
+            typedef typename detail::lazy_result< UnaryFunction, input_type >::type value_type;
+
+            transform_expression( control& ctl, InputIterator first, InputIterator last, const UnaryFunction& f,
+                const std::string& user_code ):
+                m_ctl( &ctl ), m_first( first ), m_last( last ), m_function( f ), m_userCode( user_code )
+            {}
+
+            control& ctl( ) const { return *m_ctl; }
+            InputIterator first( ) const { return m_first; }
+            InputIterator last( ) const { return m_last; }
+            const UnaryFunction& function( ) const { return m_function; }
+            const std::string& user_code( ) const { return m_userCode; }
+
+        private:
+            control* m_ctl;
+            InputIterator m_first;
+            InputIterator m_last;
+            UnaryFunction m_function;
+            std::string m_userCode;
+        };
+
+        /*! \brief Starts a lazy pipeline that applies \p f to every element of [\p first, \p last).
+         *
+         * \param ctl \b Optional Control structure used by the kernel the pipeline finally launches.
+         * \param first The beginning of the input sequence.
+         * \param last The end of the input sequence.
+         * \param f A unary function object with a TypeName and ClCode trait.
+         * \param user_code Optional OpenCL&tm; code to be passed to the OpenCL compiler.
+         * \return An unevaluated expression; pipe it with \p operator| into further stages.
+         *
+         *  \code
+         *  #include <bolt/cl/lazy.h>
+         *  #include <bolt/cl/functional.h>
+         *
+         *  bolt::cl::device_vector< int > input( 1024, 3 );
+         *
+         *  // One kernel; the negated and squared values are never written to memory
+         *  int sum = bolt::cl::lazy::transform( input.begin( ), input.end( ), bolt::cl::negate< int >( ) )
+         *          | bolt::cl::lazy::transform( bolt::cl::square< int >( ) )
+         *          | bolt::cl::lazy::reduce( 0, bolt::cl::plus< int >( ) );
+         *
+         *  // sum is 9216
+         *  \endcode
+         */
+        template< typename InputIterator, typename UnaryFunction >
+        transform_expression< InputIterator, UnaryFunction >
+        transform( control& ctl, InputIterator first, InputIterator last, UnaryFunction f,
+            const std::string& user_code = "" )
+        {
+            return transform_expression< InputIterator, UnaryFunction >( ctl, first, last, f, user_code );
+        }
+
+        template< typename InputIterator, typename UnaryFunction >
+        transform_expression< InputIterator, UnaryFunction >
+        transform( InputIterator first, InputIterator last, UnaryFunction f, const std::string& user_code = "" )
+        {
+            return transform_expression< InputIterator, UnaryFunction >( control::getDefault( ), first, last, f,
+                user_code );
+        }
+
+        /*! \brief A transform stage to append to a pipeline; it is applied after the stages before it. */
+        template< typename UnaryFunction >
+        transform_stage< UnaryFunction > transform( UnaryFunction f )
+        {
+            return transform_stage< UnaryFunction >( f );
+        }
+
+        /*! \brief Terminal stage that reduces the transformed values with \p reduce_op, starting from \p init.
+         *  Runs as a single bolt::cl::transform_reduce.
+         */
+        template< typename T, typename BinaryFunction >
+        reduce_stage< T, BinaryFunction > reduce( T init, BinaryFunction reduce_op )
+        {
+            return reduce_stage< T, BinaryFunction >( init, reduce_op );
+        }
+
+        /*! \brief Terminal stage that writes the inclusive scan of the transformed values to \p result.
+         *  Runs as a single bolt::cl::transform_inclusive_scan.
+         */
+        template< typename OutputIterator, typename BinaryFunction >
+        inclusive_scan_stage< OutputIterator, BinaryFunction > inclusive_scan( OutputIterator result,
+            BinaryFunction scan_op )
+        {
+            return inclusive_scan_stage< OutputIterator, BinaryFunction >( result, scan_op );
+        }
+
+        /*! \brief Terminal stage that writes the exclusive scan of the transformed values to \p result.
+         *  Runs as a single bolt::cl::transform_exclusive_scan.
+         */
+        template< typename OutputIterator, typename T, typename BinaryFunction >
+        exclusive_scan_stage< OutputIterator, T, BinaryFunction > exclusive_scan( OutputIterator result, T init,
+            BinaryFunction scan_op )
+        {
+            return exclusive_scan_stage< OutputIterator, T, BinaryFunction >( result, init, scan_op );
+        }
+
+        /*! \brief Terminal stage that writes the transformed values to \p result.
+         *  Runs as a single bolt::cl::transform.
+         */
+        template< typename OutputIterator >
+        copy_stage< OutputIterator > copy( OutputIterator result )
+        {
+            return copy_stage< OutputIterator >( result );
+        }
+
+        /*! \brief Composes a transform stage onto the pipeline; still nothing is evaluated. */
+        template< typename InputIterator, typename UnaryFunction, typename NextFunction >
+        transform_expression< InputIterator, lazy_compose< NextFunction, UnaryFunction,
+            typename transform_expression< InputIterator, UnaryFunction >::input_type,
+            typename transform_expression< InputIterator, UnaryFunction >::value_type,
+            typename detail::lazy_result< NextFunction,
+                typename transform_expression< InputIterator, UnaryFunction >::value_type >::type > >
+        operator|( const transform_expression< InputIterator, UnaryFunction >& expr,
+            const transform_stage< NextFunction >& stage )
+        {
+            typedef transform_expression< InputIterator, UnaryFunction > expression_type;
+            typedef lazy_compose< NextFunction, UnaryFunction,
+                typename expression_type::input_type,
+                typename expression_type::value_type,
+                typename detail::lazy_result< NextFunction, typename expression_type::value_type >::type > composed;
+
+            composed f = { expr.function( ), stage.function };
+            return transform_expression< InputIterator, composed >( expr.ctl( ), expr.first( ), expr.last( ), f,
+                expr.user_code( ) );
+        }
+
+        template< typename InputIterator, typename UnaryFunction, typename T, typename BinaryFunction >
+        T operator|( const transform_expression< InputIterator, UnaryFunction >& expr,
+            const reduce_stage< T, BinaryFunction >& stage )
+        {
+            return ::bolt::cl::transform_reduce( expr.ctl( ), expr.first( ), expr.last( ), expr.function( ),
+                stage.init, stage.reduce_op, expr.user_code( ) );
+        }
+
+        template< typename InputIterator, typename UnaryFunction, typename OutputIterator, typename BinaryFunction >
+        OutputIterator operator|( const transform_expression< InputIterator, UnaryFunction >& expr,
+            const inclusive_scan_stage< OutputIterator, BinaryFunction >& stage )
+        {
+            return ::bolt::cl::transform_inclusive_scan( expr.ctl( ), expr.first( ), expr.last( ), stage.result,
+                expr.function( ), stage.scan_op, expr.user_code( ) );
+        }
+
+        template< typename InputIterator, typename UnaryFunction, typename OutputIterator, typename T,
+            typename BinaryFunction >
+        OutputIterator operator|( const transform_expression< InputIterator, UnaryFunction >& expr,
+            const exclusive_scan_stage< OutputIterator, T, BinaryFunction >& stage )
+        {
+            return ::bolt::cl::transform_exclusive_scan( expr.ctl( ), expr.first( ), expr.last( ), stage.result,
+                expr.function( ), stage.init, stage.scan_op, expr.user_code( ) );
+        }
+
+        template< typename InputIterator, typename UnaryFunction, typename OutputIterator >
+        void operator|( const transform_expression< InputIterator, UnaryFunction >& expr,
+            const copy_stage< OutputIterator >& stage )
+        {
+            ::bolt::cl::transform( expr.ctl( ), expr.first( ), expr.last( ), stage.result, expr.function( ),
+                expr.user_code( ) );
+        }
+
+        /*!   \}  */
+
+    };
+    };
+};
+
+//  A composition is named after its stages, so every distinct pipeline compiles to its own kernel once and is then
+//  found in the program cache like any other functor
+template< typename Outer, typename Inner, typename Argument, typename Intermediate, typename Result >
+struct TypeName< bolt::cl::lazy_compose< Outer, Inner, Argument, Intermediate, Result > >
+{
+    static std::string get( )
+    {
+        return "bolt::cl::lazy_compose< " + TypeName< Outer >::get( ) + ", " + TypeName< Inner >::get( ) + ", " +
+            TypeName< Argument >::get( ) + ", " + TypeName< Intermediate >::get( ) + ", " +
+            TypeName< Result >::get( ) + " >";
+    }
+};
+
+template< typename Outer, typename Inner, typename Argument, typename Intermediate, typename Result >
+struct ClCode< bolt::cl::lazy_compose< Outer, Inner, Argument, Intermediate, Result > >
+{
+    static std::string get( )
+    {
+        //  The algorithm running the pipeline defines the argument and result types itself, so an intermediate
+        //  type equal to either is skipped as well
+        std::vector< std::string > definitions;
+        bolt::cl::detail::lazy_push_code( definitions, ClCode< Argument >::get( ) );
+        bolt::cl::detail::lazy_push_code( definitions, ClCode< Result >::get( ) );
+        size_t algorithmDefinitions = definitions.size( );
+        bolt::cl::detail::lazy_code< bolt::cl::lazy_compose< Outer, Inner, Argument, Intermediate, Result > >::
+            collect( definitions );
+
+        std::string code;
+        for( std::vector< std::string >::const_iterator i = definitions.begin( ) + algorithmDefinitions;
+            i != definitions.end( ); ++i )
+            code += *i;
+        return code;
+    }
+};
+
+#endif
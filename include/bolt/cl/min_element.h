@@ -25,6 +25,7 @@
 
 #include <string>
 #include <iostream>
+#include <utility>
 
 /*! \file bolt/cl/min_element.h
     \brief min_element returns the location of the first minimum element in the specified range.
@@ -131,6 +132,60 @@ namespace bolt {
             const std::string& cl_code="")  ;
 
 
+        /*! \brief The minmax_element returns the locations of the first minimum element and of the last maximum
+        * element in the specified range, found together in one pass over it.
+        *
+        * \details As with std::minmax_element, ties go to the first of the smallest elements and to the last of the
+        * largest ones.  Both are found in the same reduction on every backend, so the range is read once instead of
+        * once for \p min_element and again for \p max_element.  An empty range returns last twice.
+        *
+        * \param ctl \b Optional Control structure to control command-queue, debug, tuning, etc. See bolt::cl::control.
+        * \param first A forward iterator addressing the position of the first element in the range to be searched
+        * \param last  A forward iterator addressing the position one past the final element in the range to be
+        * searched
+        * \param binary_op  The ordering of the elements.   By default, the binary operation is less<>().
+        * \param cl_code Optional OpenCL(TM) code to be passed to the OpenCL compiler. The cl_code is inserted first in
+        * the generated code, before the cl_code trait.
+        * \tparam ForwardIterator An iterator that can be dereferenced for an object, and can be incremented to get to
+        * the next element in a sequence.
+        * \tparam BinaryPredicate A strict weak ordering of the elements.
+        * \return The positions of the minimum and of the maximum element.
+        *
+        * \code
+        * #include <bolt/cl/min_element.h>
+        *
+        * int a[10] = {4, 8, 6, 1, 5, 3, 10, 2, 9, 10};
+        *
+        * std::pair< int*, int* > pos = bolt::cl::minmax_element(a, a+10);
+        * // pos.first = a+3, pos.second = a+9
+        *  \endcode
+        * \sa http://en.cppreference.com/w/cpp/algorithm/minmax_element
+        */
+
+        template<typename ForwardIterator>
+        std::pair<ForwardIterator, ForwardIterator> minmax_element(bolt::cl::control &ctl,
+            ForwardIterator first,
+            ForwardIterator last,
+            const std::string& cl_code="");
+
+        template<typename ForwardIterator>
+        std::pair<ForwardIterator, ForwardIterator> minmax_element(ForwardIterator first,
+            ForwardIterator last,
+            const std::string& cl_code="");
+
+        template<typename ForwardIterator, typename BinaryPredicate>
+        std::pair<ForwardIterator, ForwardIterator> minmax_element(bolt::cl::control &ctl,
+            ForwardIterator first,
+            ForwardIterator last,
+            BinaryPredicate binary_op,
+            const std::string& cl_code="");
+
+        template<typename ForwardIterator, typename BinaryPredicate>
+        std::pair<ForwardIterator, ForwardIterator> minmax_element(ForwardIterator first,
+            ForwardIterator last,
+            BinaryPredicate binary_op,
+            const std::string& cl_code="");
+
 
         /*!   \}  */
 
@@ -93,3 +93,90 @@ kernel void min_elementTemplate(
         result[get_group_id(0)] = scratch_index[0];        
     }
 };
+
+//  Ties go to the lower index for the smallest element and to the higher index for the largest, as in
+//  std::minmax_element; the elements a work item holds are not all left of those of higher work items
+#define _MINMAX_STEP(_LENGTH, _IDX, _W) \
+    if ((_IDX < _W) && ((_IDX + _W) < _LENGTH)) {\
+      iTypePtr mine = scratch_min[_IDX];\
+      iTypePtr other = scratch_min[_IDX + _W];\
+      int otherIndex = scratch_min_index[_IDX + _W];\
+      if ((*userFunctor)(other, mine) || (!(*userFunctor)(mine, other) && otherIndex < scratch_min_index[_IDX])) {\
+        scratch_min[_IDX] = other;\
+        scratch_min_index[_IDX] = otherIndex;\
+      }\
+      mine = scratch_max[_IDX];\
+      other = scratch_max[_IDX + _W];\
+      otherIndex = scratch_max_index[_IDX + _W];\
+      if ((*userFunctor)(mine, other) || (!(*userFunctor)(other, mine) && otherIndex > scratch_max_index[_IDX])) {\
+        scratch_max[_IDX] = other;\
+        scratch_max_index[_IDX] = otherIndex;\
+      }\
+    }\
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+template< typename iTypePtr, typename iTypeIter, typename binary_function >
+kernel void minmax_elementTemplate(
+    global iTypePtr*    input_ptr,
+    iTypeIter input_iter,
+    const int length,
+    global binary_function* userFunctor,
+    global int*    result,
+    local iTypePtr*     scratch_min,
+    local int*     scratch_min_index,
+    local iTypePtr*     scratch_max,
+    local int*     scratch_max_index
+)
+{
+    int gx = get_global_id (0);
+    int gloId = gx;
+
+    input_iter.init( input_ptr );
+
+    //  Both accumulators start from the first element of the work item, and the smallest and the largest are
+    //  tracked in the same sweep over the input
+    iTypePtr minimum, maximum;
+    int minIndex = gx, maxIndex = gx;
+    if(gloId < length){
+       minimum = input_iter[gx];
+       maximum = minimum;
+       gx += get_global_size(0);
+    }
+
+    while (gx < length)
+    {
+        iTypePtr element = input_iter[gx];
+        if ((*userFunctor)(element, minimum)) {
+            minimum = element;
+            minIndex = gx;
+        }
+        if (!(*userFunctor)(element, maximum)) {
+            maximum = element;
+            maxIndex = gx;
+        }
+        gx += get_global_size(0);
+    }
+
+    int local_index = get_local_id(0);
+    scratch_min[local_index] = minimum;
+    scratch_min_index[local_index] = minIndex;
+    scratch_max[local_index] = maximum;
+    scratch_max_index[local_index] = maxIndex;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    //  Tail stops the last workgroup from reading past the end of the input vector
+    uint tail = length - (get_group_id(0) * get_local_size(0));
+
+    _MINMAX_STEP(tail, local_index, 32);
+    _MINMAX_STEP(tail, local_index, 16);
+    _MINMAX_STEP(tail, local_index,  8);
+    _MINMAX_STEP(tail, local_index,  4);
+    _MINMAX_STEP(tail, local_index,  2);
+    _MINMAX_STEP(tail, local_index,  1);
+
+    if (local_index == 0)
+    {
+        result[2 * get_group_id(0)] = scratch_min_index[0];
+        result[2 * get_group_id(0) + 1] = scratch_max_index[0];
+    }
+};
@@ -0,0 +1,266 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#if !defined( OCL_PARTIAL_SORT_H )
+#define OCL_PARTIAL_SORT_H
+#pragma once
+
+#include <bolt/cl/bolt.h>
+#include <bolt/cl/functional.h>
+#include <string>
+
+/*! \file bolt/cl/partial_sort.h
+    \brief Selection algorithms: nth_element, partial_sort and top_k.
+*/
+
+namespace bolt {
+    namespace cl {
+
+        /*! \addtogroup algorithms
+         */
+
+        /*! \addtogroup sorting
+        *   \ingroup algorithms
+        */
+
+        /*! \addtogroup CL-partial_sort
+        *   \ingroup sorting
+        *   \{
+        *
+        *   For arithmetic types compared with bolt::cl::less or bolt::cl::greater, the OpenCL path finds the
+        *   element of the wanted rank with a radix select: one pass over the keys per 8-bit digit, that only counts,
+        *   followed by one pass that moves the selected elements.  Only the k selected elements are sorted, so for a
+        *   k much smaller than the range the work is a small fraction of a full sort.  Other types and comparators
+        *   are sorted in full.  The MultiCoreCpu path selects the k smallest elements of every chunk of the range in
+        *   parallel.
+        */
+
+        /*! \brief \p nth_element rearranges [first, last) so that the element at \p nth is the one that would be
+        * there if the range were sorted, no element before it is greater and no element after it is less.
+        *
+        * \details The operation is analogous to std::nth_element; see http://www.sgi.com/tech/stl/nth_element.html.
+        *
+        * \param ctl \b Optional Control structure to control command-queue, debug, tuning, etc. See bolt::cl::control.
+        * \param first The first position in the sequence.
+        * \param nth   The position of the element to select.
+        * \param last  The last position in the sequence.
+        * \param cl_code Optional OpenCL(TM) code to be passed to the OpenCL compiler. The cl_code is inserted first in
+        * the generated code, before the cl_code traits. This can be used for any extra cl code that is to be passed
+        * when compiling the OpenCl Kernel.
+        * \return The range is rearranged in place.
+        *
+        *  \tparam RandomAccessIterator Is a model of http://www.sgi.com/tech/stl/RandomAccessIterator.html
+        *
+        * \code
+        * #include <bolt/cl/partial_sort.h>
+        *
+        * int a[8] = {7, 2, 9, 4, 1, 8, 3, 6};
+        *
+        * bolt::cl::nth_element(a, a+3, a+8);
+        *
+        * // a[3] => 4; a[0], a[1] and a[2] are 1, 2 and 3 in some order
+        *  \endcode
+        */
+        template<typename RandomAccessIterator>
+        void nth_element(bolt::cl::control &ctl,
+            RandomAccessIterator first,
+            RandomAccessIterator nth,
+            RandomAccessIterator last,
+            const std::string& cl_code="");
+
+        template<typename RandomAccessIterator>
+        void nth_element(RandomAccessIterator first,
+            RandomAccessIterator nth,
+            RandomAccessIterator last,
+            const std::string& cl_code="");
+
+        /*! \brief \p nth_element rearranges [first, last) using \p comp to compare elements, so that the element at
+        * \p nth is the one that would be there if the range were sorted.
+        *
+        * \param ctl \b Optional Control structure to control command-queue, debug, tuning, etc. See bolt::cl::control.
+        * \param first The first position in the sequence.
+        * \param nth   The position of the element to select.
+        * \param last  The last position in the sequence.
+        * \param comp  The comparison operation used to compare two values.
+        * \param cl_code Optional OpenCL(TM) code to be passed to the OpenCL compiler.
+        * \return The range is rearranged in place.
+        *
+        *  \tparam RandomAccessIterator Is a model of http://www.sgi.com/tech/stl/RandomAccessIterator.html
+        *  \tparam StrictWeakOrdering Is a model of http://www.sgi.com/tech/stl/StrictWeakOrdering.html.
+        */
+        template<typename RandomAccessIterator, typename StrictWeakOrdering>
+        void nth_element(bolt::cl::control &ctl,
+            RandomAccessIterator first,
+            RandomAccessIterator nth,
+            RandomAccessIterator last,
+            StrictWeakOrdering comp,
+            const std::string& cl_code="");
+
+        template<typename RandomAccessIterator, typename StrictWeakOrdering>
+        void nth_element(RandomAccessIterator first,
+            RandomAccessIterator nth,
+            RandomAccessIterator last,
+            StrictWeakOrdering comp,
+            const std::string& cl_code="");
+
+        /*! \brief \p partial_sort puts the middle - first smallest elements of [first, last), in ascending order,
+        * in [first, middle); the other elements follow in no particular order.
+        *
+        * \details The operation is analogous to std::partial_sort; see
+        * http://www.sgi.com/tech/stl/partial_sort.html.
+        *
+        * \param ctl \b Optional Control structure to control command-queue, debug, tuning, etc. See bolt::cl::control.
+        * \param first  The first position in the sequence.
+        * \param middle The end of the sorted part.
+        * \param last   The last position in the sequence.
+        * \param cl_code Optional OpenCL(TM) code to be passed to the OpenCL compiler.
+        * \return The range is rearranged in place.
+        *
+        *  \tparam RandomAccessIterator Is a model of http://www.sgi.com/tech/stl/RandomAccessIterator.html
+        *
+        * \code
+        * #include <bolt/cl/partial_sort.h>
+        *
+        * int a[8] = {7, 2, 9, 4, 1, 8, 3, 6};
+        *
+        * bolt::cl::partial_sort(a, a+3, a+8);
+        *
+        * // a[0], a[1], a[2] => 1, 2, 3
+        *  \endcode
+        */
+        template<typename RandomAccessIterator>
+        void partial_sort(bolt::cl::control &ctl,
+            RandomAccessIterator first,
+            RandomAccessIterator middle,
+            RandomAccessIterator last,
+            const std::string& cl_code="");
+
+        template<typename RandomAccessIterator>
+        void partial_sort(RandomAccessIterator first,
+            RandomAccessIterator middle,
+            RandomAccessIterator last,
+            const std::string& cl_code="");
+
+        /*! \brief \p partial_sort puts the middle - first first elements of [first, last) in the order of \p comp,
+        * sorted, in [first, middle); the other elements follow in no particular order.
+        *
+        * \param ctl \b Optional Control structure to control command-queue, debug, tuning, etc. See bolt::cl::control.
+        * \param first  The first position in the sequence.
+        * \param middle The end of the sorted part.
+        * \param last   The last position in the sequence.
+        * \param comp   The comparison operation used to compare two values.
+        * \param cl_code Optional OpenCL(TM) code to be passed to the OpenCL compiler.
+        * \return The range is rearranged in place.
+        *
+        *  \tparam RandomAccessIterator Is a model of http://www.sgi.com/tech/stl/RandomAccessIterator.html
+        *  \tparam StrictWeakOrdering Is a model of http://www.sgi.com/tech/stl/StrictWeakOrdering.html.
+        */
+        template<typename RandomAccessIterator, typename StrictWeakOrdering>
+        void partial_sort(bolt::cl::control &ctl,
+            RandomAccessIterator first,
+            RandomAccessIterator middle,
+            RandomAccessIterator last,
+            StrictWeakOrdering comp,
+            const std::string& cl_code="");
+
+        template<typename RandomAccessIterator, typename StrictWeakOrdering>
+        void partial_sort(RandomAccessIterator first,
+            RandomAccessIterator middle,
+            RandomAccessIterator last,
+            StrictWeakOrdering comp,
+            const std::string& cl_code="");
+
+        /*! \brief \p top_k copies the \p k smallest elements of [first, last), in ascending order, to \p result,
+        * leaving the input unchanged.  Pass bolt::cl::greater to get the k largest.
+        *
+        * \param ctl \b Optional Control structure to control command-queue, debug, tuning, etc. See bolt::cl::control.
+        * \param first  The first position in the sequence.
+        * \param last   The last position in the sequence.
+        * \param k      The number of elements to copy; at most last - first are copied.
+        * \param result The beginning of the output, which must not overlap the input.
+        * \param cl_code Optional OpenCL(TM) code to be passed to the OpenCL compiler.
+        * \return The end of the output.
+        *
+        *  \tparam RandomAccessIterator Is a model of http://www.sgi.com/tech/stl/RandomAccessIterator.html
+        *  \tparam OutputIterator Is a mutable model of http://www.sgi.com/tech/stl/RandomAccessIterator.html
+        *
+        * \code
+        * #include <bolt/cl/partial_sort.h>
+        *
+        * int a[8] = {7, 2, 9, 4, 1, 8, 3, 6};
+        * int largest[3];
+        *
+        * bolt::cl::top_k(a, a+8, 3, largest, bolt::cl::greater<int>());
+        *
+        * // largest => {9, 8, 7}
+        *  \endcode
+        */
+        template<typename RandomAccessIterator, typename OutputIterator>
+        OutputIterator top_k(bolt::cl::control &ctl,
+            RandomAccessIterator first,
+            RandomAccessIterator last,
+            size_t k,
+            OutputIterator result,
+            const std::string& cl_code="");
+
+        template<typename RandomAccessIterator, typename OutputIterator>
+        OutputIterator top_k(RandomAccessIterator first,
+            RandomAccessIterator last,
+            size_t k,
+            OutputIterator result,
+            const std::string& cl_code="");
+
+        /*! \brief \p top_k copies the first \p k elements of [first, last) in the order of \p comp, sorted, to
+        * \p result, leaving the input unchanged.
+        *
+        * \param ctl \b Optional Control structure to control command-queue, debug, tuning, etc. See bolt::cl::control.
+        * \param first  The first position in the sequence.
+        * \param last   The last position in the sequence.
+        * \param k      The number of elements to copy; at most last - first are copied.
+        * \param result The beginning of the output, which must not overlap the input.
+        * \param comp   The comparison operation used to compare two values.
+        * \param cl_code Optional OpenCL(TM) code to be passed to the OpenCL compiler.
+        * \return The end of the output.
+        *
+        *  \tparam RandomAccessIterator Is a model of http://www.sgi.com/tech/stl/RandomAccessIterator.html
+        *  \tparam OutputIterator Is a mutable model of http://www.sgi.com/tech/stl/RandomAccessIterator.html
+        *  \tparam StrictWeakOrdering Is a model of http://www.sgi.com/tech/stl/StrictWeakOrdering.html.
+        */
+        template<typename RandomAccessIterator, typename OutputIterator, typename StrictWeakOrdering>
+        OutputIterator top_k(bolt::cl::control &ctl,
+            RandomAccessIterator first,
+            RandomAccessIterator last,
+            size_t k,
+            OutputIterator result,
+            StrictWeakOrdering comp,
+            const std::string& cl_code="");
+
+        template<typename RandomAccessIterator, typename OutputIterator, typename StrictWeakOrdering>
+        OutputIterator top_k(RandomAccessIterator first,
+            RandomAccessIterator last,
+            size_t k,
+            OutputIterator result,
+            StrictWeakOrdering comp,
+            const std::string& cl_code="");
+
+        /*!   \}  */
+
+    }// end of bolt::cl namespace
+}// end of bolt namespace
+
+#include <bolt/cl/detail/partial_sort.inl>
+#endif
@@ -216,6 +216,58 @@ namespace bolt {
             BinaryFunction binary_op, 
             const std::string& cl_code="")  ;
 
+        /*! \brief \p reduce_into combines all the elements in the specified range using binary_op, like \p reduce,
+        * and stores the result at \p result instead of returning it.
+        *
+        * \details When \p result is a device_vector iterator and the reduction runs on the OpenCL device, both
+        * stages of the reduction run on the device and the call returns as soon as they are enqueued; the host
+        * never waits for the result.  A following Bolt call on the same control reads the result in order, so
+        * reductions that feed each other, such as a mean and then a variance, run without round trips to the host.
+        * Reading the result through the device_vector waits for it.  Other results, and the CPU run modes, reduce
+        * as \p reduce does and then store the value.
+        *
+        * \param ctl \b Optional Control structure to control command-queue, debug, tuning, etc.
+        * \param first The first position in the sequence to be reduced.
+        * \param last  The last position in the sequence to be reduced.
+        * \param result The position the result is stored at.
+        * \param init  The initial value for the accumulator.
+        * \param binary_op  The binary operation used to combine two values.
+        * \param cl_code Optional OpenCL(TM) code to be passed to the OpenCL compiler. The cl_code is inserted first in
+        * the generated code, before the cl_code trait.
+        * \tparam InputIterator An iterator that can be dereferenced for an object, and can be incremented to get to
+        * the next element in a sequence.
+        * \tparam OutputIterator A mutable iterator; a device_vector iterator keeps the result on the device.
+        * \tparam BinaryFunction A function object defining an operation that is applied to consecutive elements in the
+        * sequence.
+        *
+        * \code
+        * #include <bolt/cl/reduce.h>
+        *
+        * bolt::cl::device_vector< int > input( 1024, 1 );
+        * bolt::cl::device_vector< int > sums( 2 );
+        *
+        * bolt::cl::reduce_into( input.begin( ), input.end( ), sums.begin( ), 0, bolt::cl::plus< int >( ) );
+        * bolt::cl::reduce_into( input.begin( ), input.end( ), sums.begin( ) + 1, 0, bolt::cl::maximum< int >( ) );
+        * // sums => {1024, 1}, read back only when accessed
+        *  \endcode
+        */
+        template<typename InputIterator, typename OutputIterator, typename T, typename BinaryFunction>
+        void reduce_into(bolt::cl::control &ctl,
+            InputIterator first,
+            InputIterator last,
+            OutputIterator result,
+            T init,
+            BinaryFunction binary_op,
+            const std::string& cl_code="");
+
+        template<typename InputIterator, typename OutputIterator, typename T, typename BinaryFunction>
+        void reduce_into(InputIterator first,
+            InputIterator last,
+            OutputIterator result,
+            T init,
+            BinaryFunction binary_op,
+            const std::string& cl_code="");
+
         /*!   \}  */
 
     };
@@ -29,14 +29,14 @@ template< typename iTypePtr, typename iTypeIter, typename binary_function >
 kernel void reduceTemplate(
     global iTypePtr*    input_ptr, 
     iTypeIter input_iter,
-    const int length,
+    const indexType length,
     global binary_function* userFunctor,
     global iTypePtr*    result,
     local iTypePtr*     scratch
 )
 {
-    int gx = get_global_id (0);
-    int gloId = gx;
+    indexType gx = get_global_id (0);
+    indexType gloId = gx;
     input_iter.init( input_ptr );
 
     //  Initialize the accumulator private variable with data from the input array
@@ -62,7 +62,7 @@ kernel void reduceTemplate(
     barrier(CLK_LOCAL_MEM_FENCE);
 
     //  Tail stops the last workgroup from reading past the end of the input vector
-    uint tail = length - (get_group_id(0) * get_local_size(0));
+    indexType tail = length - (get_group_id(0) * get_local_size(0));
 
     // Parallel reduction within a given workgroup using local data store
     // to share values between workitems
@@ -82,3 +82,106 @@ kernel void reduceTemplate(
         result[get_group_id(0)] = scratch[0];
     }
 };
+
+//  Second stage of a reduction: one work group folds the per work group results of reduceTemplate, then init, and
+//  writes the value to result[ resultIndex ], so the result can stay on the device
+template< typename iTypePtr, typename rType, typename binary_function >
+kernel void reduceFinal(
+    global iTypePtr*    partials,
+    const int numPartials,
+    const iTypePtr init,
+    global binary_function* userFunctor,
+    global rType*       result,
+    const indexType resultIndex,
+    local iTypePtr*     scratch
+)
+{
+    int local_index = get_local_id(0);
+
+    iTypePtr accumulator;
+    if(local_index < numPartials)
+        accumulator = partials[local_index];
+    for(int i = local_index + get_local_size(0); i < numPartials; i += get_local_size(0))
+        accumulator = (*userFunctor)(accumulator, partials[i]);
+
+    scratch[local_index] = accumulator;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    uint tail = min(numPartials, (int)get_local_size(0));
+    _REDUCE_STEP(tail, local_index, 32);
+    _REDUCE_STEP(tail, local_index, 16);
+    _REDUCE_STEP(tail, local_index,  8);
+    _REDUCE_STEP(tail, local_index,  4);
+    _REDUCE_STEP(tail, local_index,  2);
+    _REDUCE_STEP(tail, local_index,  1);
+
+    if (local_index == 0) {
+        result[resultIndex] = (*userFunctor)(init, scratch[0]);
+    }
+};
+
+#if defined( REDUCE_VECTOR_PLUS )
+#define REDUCE_VECTOR_OP( a, b ) ( ( a ) + ( b ) )
+#elif defined( REDUCE_VECTOR_MULTIPLIES )
+#define REDUCE_VECTOR_OP( a, b ) ( ( a ) * ( b ) )
+#elif defined( REDUCE_VECTOR_MAXIMUM )
+#define REDUCE_VECTOR_OP( a, b ) max( ( a ), ( b ) )
+#elif defined( REDUCE_VECTOR_MINIMUM )
+#define REDUCE_VECTOR_OP( a, b ) min( ( a ), ( b ) )
+#endif
+
+#if defined( REDUCE_VECTOR_OP )
+//  First stage of a reduction of a built-in scalar type with a built-in operator.  Every work item keeps
+//  REDUCE_UNROLL four wide accumulators, loaded a whole grid apart so that the loads of a wavefront are contiguous,
+//  and folds them only once the input is consumed; the elements past the last whole vector are picked up by the first
+//  work items.  Work items without elements hold identity.
+template< typename iTypePtr, typename vTypePtr >
+kernel void reduceVector(
+    global iTypePtr*    input_ptr,
+    const indexType offset,
+    const indexType length,
+    const iTypePtr identity,
+    global iTypePtr*    result,
+    local iTypePtr*     scratch
+)
+{
+    global iTypePtr* input = input_ptr + offset;
+    indexType gloId = get_global_id( 0 );
+    indexType gloSize = get_global_size( 0 );
+    indexType numVectors = length / 4;
+
+    vTypePtr acc[ REDUCE_UNROLL ];
+    for( int u = 0; u < REDUCE_UNROLL; ++u )
+        acc[ u ] = ( vTypePtr )( identity );
+
+    indexType i = gloId;
+    for( ; i + ( REDUCE_UNROLL - 1 ) * gloSize < numVectors; i += REDUCE_UNROLL * gloSize )
+    {
+        for( int u = 0; u < REDUCE_UNROLL; ++u )
+            acc[ u ] = REDUCE_VECTOR_OP( acc[ u ], vload4( i + u * gloSize, input ) );
+    }
+    for( ; i < numVectors; i += gloSize )
+        acc[ 0 ] = REDUCE_VECTOR_OP( acc[ 0 ], vload4( i, input ) );
+    for( int u = 1; u < REDUCE_UNROLL; ++u )
+        acc[ 0 ] = REDUCE_VECTOR_OP( acc[ 0 ], acc[ u ] );
+
+    iTypePtr accumulator = REDUCE_VECTOR_OP( REDUCE_VECTOR_OP( acc[ 0 ].x, acc[ 0 ].y ),
+                                             REDUCE_VECTOR_OP( acc[ 0 ].z, acc[ 0 ].w ) );
+    indexType tailIndex = numVectors * 4 + gloId;
+    if( tailIndex < length )
+        accumulator = REDUCE_VECTOR_OP( accumulator, input[ tailIndex ] );
+
+    uint local_index = get_local_id( 0 );
+    scratch[ local_index ] = accumulator;
+    barrier( CLK_LOCAL_MEM_FENCE );
+    for( uint w = REDUCE_VECTOR_WGSIZE / 2; w > 0; w >>= 1 )
+    {
+        if( local_index < w )
+            scratch[ local_index ] = REDUCE_VECTOR_OP( scratch[ local_index ], scratch[ local_index + w ] );
+        barrier( CLK_LOCAL_MEM_FENCE );
+    }
+
+    if( local_index == 0 )
+        result[ get_group_id( 0 ) ] = scratch[ 0 ];
+};
+#endif
@@ -0,0 +1,183 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#if !defined( OCL_REDUCE_MULTI_H )
+#define OCL_REDUCE_MULTI_H
+#pragma once
+
+#include <bolt/cl/bolt.h>
+#include <bolt/cl/functional.h>
+#include <bolt/cl/device_vector.h>
+
+#include <string>
+#include <tuple>
+
+/*! \file bolt/cl/reduce_multi.h
+    \brief Computes several transform_reduce results over one range in a single pass.
+*/
+
+namespace bolt {
+    namespace cl {
+
+        /*! \addtogroup algorithms
+         */
+
+        /*! \addtogroup reductions
+        *   \ingroup algorithms
+        */
+
+        /*! \addtogroup CL-reduce_multi
+        *   \ingroup reductions
+        *   \{
+        */
+
+        /*! \brief One of the reductions computed by \p reduce_multi: every element is transformed with
+        * \p transform_op, and the transformed values are combined, with \p init, using \p reduce_op, as in
+        * \p transform_reduce.
+        */
+        template< typename UnaryFunction, typename T, typename BinaryFunction >
+        struct reduction
+        {
+            typedef UnaryFunction transform_type;
+            typedef T value_type;
+            typedef BinaryFunction reduce_type;
+
+            reduction( const UnaryFunction& _transform_op, const T& _init, const BinaryFunction& _reduce_op ):
+                transform_op( _transform_op ), init( _init ), reduce_op( _reduce_op )
+            {}
+
+            UnaryFunction transform_op;
+            T init;
+            BinaryFunction reduce_op;
+        };
+
+        /*! \brief Makes a \p reduction, deducing its types from the arguments.
+        */
+        template< typename UnaryFunction, typename T, typename BinaryFunction >
+        reduction< UnaryFunction, T, BinaryFunction > make_reduction( UnaryFunction transform_op, T init,
+            BinaryFunction reduce_op )
+        {
+            return reduction< UnaryFunction, T, BinaryFunction >( transform_op, init, reduce_op );
+        }
+
+        /*! \brief \p reduce_multi computes two to four reductions of the same range in a single pass over it, and
+        * returns their results as a tuple in the order the reductions are given.
+        *
+        * \details Every reduction is a \p transform_reduce of its own: it transforms each element with its
+        * transform_op and combines the transformed values and its init with its reduce_op.  All of them are
+        * computed together, with one accumulator that holds a value for each reduction, so the input is read once
+        * instead of once per reduction.  As with \p reduce, the reduce_op of every reduction must be commutative
+        * and the order the values are combined in is not deterministic.
+        *
+        * \param ctl \b Optional Control structure to control command-queue, debug, tuning, etc.
+        * \param first The first position in the sequence to be reduced.
+        * \param last  The last position in the sequence to be reduced.
+        * \param r0 The first reduction, usually made with \p make_reduction.
+        * \param r1 The second reduction.
+        * \param cl_code Optional OpenCL(TM) code to be passed to the OpenCL compiler. The cl_code is inserted first in
+        * the generated code, before the cl_code trait.
+        * \tparam InputIterator An iterator that can be dereferenced for an object, and can be incremented to get to
+        * the next element in a sequence.
+        * \tparam Reduction0 A \p reduction whose transform_op accepts the value type of InputIterator.
+        * \return A std::tuple of the results of the reductions.
+        *
+        * \details The following code example computes the sum, the minimum, the maximum and the sum of the squares
+        * of a device_vector with one read of it.
+        * \code
+        * #include <bolt/cl/reduce_multi.h>
+        *
+        * bolt::cl::device_vector< float > column( 1024, 2.0f );
+        *
+        * std::tuple< float, float, float, float > stats = bolt::cl::reduce_multi( column.begin( ), column.end( ),
+        *     bolt::cl::make_reduction( bolt::cl::identity< float >( ), 0.0f, bolt::cl::plus< float >( ) ),
+        *     bolt::cl::make_reduction( bolt::cl::identity< float >( ), FLT_MAX, bolt::cl::minimum< float >( ) ),
+        *     bolt::cl::make_reduction( bolt::cl::identity< float >( ), -FLT_MAX, bolt::cl::maximum< float >( ) ),
+        *     bolt::cl::make_reduction( bolt::cl::square< float >( ), 0.0f, bolt::cl::plus< float >( ) ) );
+        * // stats => ( 2048.0f, 2.0f, 2.0f, 4096.0f )
+        *  \endcode
+        * \sa transform_reduce
+        */
+        template< typename InputIterator, typename Reduction0, typename Reduction1 >
+        std::tuple< typename Reduction0::value_type, typename Reduction1::value_type >
+            reduce_multi( bolt::cl::control& ctl,
+            InputIterator first,
+            InputIterator last,
+            const Reduction0& r0,
+            const Reduction1& r1,
+            const std::string& cl_code="" );
+
+        template< typename InputIterator, typename Reduction0, typename Reduction1 >
+        std::tuple< typename Reduction0::value_type, typename Reduction1::value_type >
+            reduce_multi( InputIterator first,
+            InputIterator last,
+            const Reduction0& r0,
+            const Reduction1& r1,
+            const std::string& cl_code="" );
+
+        template< typename InputIterator, typename Reduction0, typename Reduction1, typename Reduction2 >
+        std::tuple< typename Reduction0::value_type, typename Reduction1::value_type,
+            typename Reduction2::value_type >
+            reduce_multi( bolt::cl::control& ctl,
+            InputIterator first,
+            InputIterator last,
+            const Reduction0& r0,
+            const Reduction1& r1,
+            const Reduction2& r2,
+            const std::string& cl_code="" );
+
+        template< typename InputIterator, typename Reduction0, typename Reduction1, typename Reduction2 >
+        std::tuple< typename Reduction0::value_type, typename Reduction1::value_type,
+            typename Reduction2::value_type >
+            reduce_multi( InputIterator first,
+            InputIterator last,
+            const Reduction0& r0,
+            const Reduction1& r1,
+            const Reduction2& r2,
+            const std::string& cl_code="" );
+
+        template< typename InputIterator, typename Reduction0, typename Reduction1, typename Reduction2,
+            typename Reduction3 >
+        std::tuple< typename Reduction0::value_type, typename Reduction1::value_type,
+            typename Reduction2::value_type, typename Reduction3::value_type >
+            reduce_multi( bolt::cl::control& ctl,
+            InputIterator first,
+            InputIterator last,
+            const Reduction0& r0,
+            const Reduction1& r1,
+            const Reduction2& r2,
+            const Reduction3& r3,
+            const std::string& cl_code="" );
+
+        template< typename InputIterator, typename Reduction0, typename Reduction1, typename Reduction2,
+            typename Reduction3 >
+        std::tuple< typename Reduction0::value_type, typename Reduction1::value_type,
+            typename Reduction2::value_type, typename Reduction3::value_type >
+            reduce_multi( InputIterator first,
+            InputIterator last,
+            const Reduction0& r0,
+            const Reduction1& r1,
+            const Reduction2& r2,
+            const Reduction3& r3,
+            const std::string& cl_code="" );
+
+        /*!   \}  */
+
+    };
+};
+
+#include <bolt/cl/detail/reduce_multi.inl>
+#endif
@@ -0,0 +1,168 @@
+/***************************************************************************                                                                                     
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.                                     
+*                                                                                    
+*   Licensed under the Apache License, Version 2.0 (the "License");   
+*   you may not use this file except in compliance with the License.                 
+*   You may obtain a copy of the License at                                          
+*                                                                                    
+*       http://www.apache.org/licenses/LICENSE-2.0                      
+*                                                                                    
+*   Unless required by applicable law or agreed to in writing, software              
+*   distributed under the License is distributed on an "AS IS" BASIS,              
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.         
+*   See the License for the specific language governing permissions and              
+*   limitations under the License.                                                   
+
+***************************************************************************/                                                                                     
+
+//  Kernels of bolt::cl::reduce_multi.  The accumulator is a struct with one field per reduction, so every element is
+//  read once however many reductions are taken.  REDUCE_MULTI_SLOTS is the number of reductions in use, 2 to 4; the
+//  host pads the unused slots, which are never transformed nor combined.
+
+template< typename T0, typename T1, typename T2, typename T3 >
+struct reduceMultiValue
+{
+    T0 v0;
+    T1 v1;
+    T2 v2;
+    T3 v3;
+};
+
+template< typename U0, typename B0, typename U1, typename B1, typename U2, typename B2, typename U3, typename B3 >
+struct reduceMultiOps
+{
+    U0 transform0;
+    B0 reduce0;
+    U1 transform1;
+    B1 reduce1;
+    U2 transform2;
+    B2 reduce2;
+    U3 transform3;
+    B3 reduce3;
+};
+
+template< typename valueType, typename opsType, typename iNakedType >
+valueType reduceMultiTransform( opsType ops, iNakedType element )
+{
+    valueType result;
+    result.v0 = ops.transform0( element );
+    result.v1 = ops.transform1( element );
+#if REDUCE_MULTI_SLOTS > 2
+    result.v2 = ops.transform2( element );
+#endif
+#if REDUCE_MULTI_SLOTS > 3
+    result.v3 = ops.transform3( element );
+#endif
+    return result;
+}
+
+template< typename valueType, typename opsType >
+valueType reduceMultiCombine( opsType ops, valueType lhs, valueType rhs )
+{
+    valueType result;
+    result.v0 = ops.reduce0( lhs.v0, rhs.v0 );
+    result.v1 = ops.reduce1( lhs.v1, rhs.v1 );
+#if REDUCE_MULTI_SLOTS > 2
+    result.v2 = ops.reduce2( lhs.v2, rhs.v2 );
+#endif
+#if REDUCE_MULTI_SLOTS > 3
+    result.v3 = ops.reduce3( lhs.v3, rhs.v3 );
+#endif
+    return result;
+}
+
+#define _REDUCE_MULTI_STEP(_LENGTH, _IDX, _W) \
+    if ((_IDX < _W) && ((_IDX + _W) < _LENGTH)) {\
+      valueType mine = scratch[_IDX];\
+      valueType other = scratch[_IDX + _W];\
+      scratch[_IDX] = reduceMultiCombine< valueType, opsType >( ops, mine, other ); \
+    }\
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+//  First stage: every work group reduces its part of the input to one accumulator in partials
+template< typename iNakedType, typename iIterType, typename valueType, typename opsType >
+kernel void reduceMultiTemplate(
+    global iNakedType* input_ptr,
+    iIterType input_iter,
+    const int length,
+    global opsType* opsPtr,
+    global valueType* partials,
+    local valueType* scratch
+)
+{
+    int gx = get_global_id( 0 );
+    input_iter.init( input_ptr );
+    opsType ops = *opsPtr;
+
+    //  Work items past the end of the input leave their accumulator unset; tail keeps it out of the tree below,
+    //  and they stay to the end so that every barrier is reached by the whole work group
+    valueType accumulator;
+    if( gx < length )
+    {
+        accumulator = reduceMultiTransform< valueType, opsType, iNakedType >( ops, input_iter[ gx ] );
+        gx += get_global_size( 0 );
+    }
+
+    while( gx < length )
+    {
+        valueType element = reduceMultiTransform< valueType, opsType, iNakedType >( ops, input_iter[ gx ] );
+        accumulator = reduceMultiCombine< valueType, opsType >( ops, accumulator, element );
+        gx += get_global_size( 0 );
+    }
+
+    int local_index = get_local_id( 0 );
+    scratch[ local_index ] = accumulator;
+    barrier( CLK_LOCAL_MEM_FENCE );
+
+    //  Tail stops the last workgroup from reading past the end of the input vector
+    uint tail = length - ( get_group_id( 0 ) * get_local_size( 0 ) );
+
+    _REDUCE_MULTI_STEP( tail, local_index, 32 );
+    _REDUCE_MULTI_STEP( tail, local_index, 16 );
+    _REDUCE_MULTI_STEP( tail, local_index,  8 );
+    _REDUCE_MULTI_STEP( tail, local_index,  4 );
+    _REDUCE_MULTI_STEP( tail, local_index,  2 );
+    _REDUCE_MULTI_STEP( tail, local_index,  1 );
+
+    if( local_index == 0 )
+    {
+        partials[ get_group_id( 0 ) ] = scratch[ 0 ];
+    }
+};
+
+//  Second stage: one work group folds the partials of reduceMultiTemplate, then the initial values, into result
+template< typename valueType, typename opsType >
+kernel void reduceMultiFinal(
+    global valueType* partials,
+    const int numPartials,
+    const valueType init,
+    global opsType* opsPtr,
+    global valueType* result,
+    local valueType* scratch
+)
+{
+    int local_index = get_local_id( 0 );
+    opsType ops = *opsPtr;
+
+    valueType accumulator;
+    if( local_index < numPartials )
+        accumulator = partials[ local_index ];
+    for( int i = local_index + get_local_size( 0 ); i < numPartials; i += get_local_size( 0 ) )
+        accumulator = reduceMultiCombine< valueType, opsType >( ops, accumulator, partials[ i ] );
+
+    scratch[ local_index ] = accumulator;
+    barrier( CLK_LOCAL_MEM_FENCE );
+
+    uint tail = min( numPartials, (int)get_local_size( 0 ) );
+    _REDUCE_MULTI_STEP( tail, local_index, 32 );
+    _REDUCE_MULTI_STEP( tail, local_index, 16 );
+    _REDUCE_MULTI_STEP( tail, local_index,  8 );
+    _REDUCE_MULTI_STEP( tail, local_index,  4 );
+    _REDUCE_MULTI_STEP( tail, local_index,  2 );
+    _REDUCE_MULTI_STEP( tail, local_index,  1 );
+
+    if( local_index == 0 )
+    {
+        result[ 0 ] = reduceMultiCombine< valueType, opsType >( ops, init, scratch[ 0 ] );
+    }
+};
@@ -82,7 +82,7 @@ kernel void perBlockAddition(
                 global iPtrType* output_ptr,
                 iIterType    output_iter, 
                 global iPtrType* postSumArray_ptr,
-                const uint vecSize,
+                const indexType vecSize,
     global BinaryFunction* binaryOp )
 {
     // BinaryFunction bf = *binaryOp;
@@ -214,7 +214,7 @@ kernel void intraBlockInclusiveScan(
                 global iPtrType* postSumArray,
                 global iPtrType* preSumArray, 
                 initType identity,
-                const uint vecSize,
+                const indexType vecSize,
                 local iPtrType* lds,
                 const uint workPerThread,
                 global BinaryFunction* binaryOp
@@ -223,7 +223,7 @@ kernel void intraBlockInclusiveScan(
     size_t gloId = get_global_id( 0 );
     size_t locId = get_local_id( 0 );
     size_t wgSize = get_local_size( 0 );
-    uint mapId  = gloId * workPerThread;
+    indexType mapId  = gloId * workPerThread;
 
     // do offset of zero manually
     uint offset;
@@ -297,7 +297,7 @@ kernel void perBlockInclusiveScan(
                 global iPtrType* input_ptr,
                 iIterType    input_iter, 
                 initType identity,
-                const uint vecSize,
+                const indexType vecSize,
                 local oPtrType* lds,
                 global BinaryFunction* binaryOp,
                 global oPtrType* scanBuffer,
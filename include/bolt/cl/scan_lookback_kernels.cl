@@ -0,0 +1,393 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+// #pragma OPENCL EXTENSION cl_amd_printf : enable
+
+/* Single pass chained scans with decoupled look-back, for scan, transform_scan and scan_by_key.  Every work group
+ * takes the next tile of SCAN_LOOKBACK_TILE elements from an atomic counter, so the tiles before it belong to groups
+ * that are already running, and scans it in local memory.  It then publishes the tile's aggregate, walks back over
+ * the status of the tiles before it, combining their aggregates until it finds one whose inclusive prefix is known,
+ * and publishes its own inclusive prefix.  The input is read once and the output written once.  scan_by_key also
+ * stops looking back once the tiles it has combined start a segment, as the tiles before those cannot reach it.
+ *
+ * tileStatus[ 0 ] is the tile counter and tileStatus[ 1 + tile ] the status of a tile; tileValues[ 2 * tile ] holds
+ * its aggregate and tileValues[ 2 * tile + 1 ] its inclusive prefix.  A value is written before the fence and the
+ * atomic store of the status that announces it, and read, past the non coherent caches, after the status.
+ *
+ * lds holds the tile, then SCAN_LOOKBACK_WGSIZE work item totals, then the exclusive prefix of the tile.
+ */
+
+#define SCAN_LOOKBACK_TILE ( SCAN_LOOKBACK_WGSIZE * SCAN_LOOKBACK_ITEMS )
+#define SCAN_LOOKBACK_PREFIX_SLOT ( SCAN_LOOKBACK_TILE + SCAN_LOOKBACK_WGSIZE )
+
+#define SCAN_LOOKBACK_NOT_READY 0
+#define SCAN_LOOKBACK_AGGREGATE 1
+#define SCAN_LOOKBACK_PREFIX 2
+
+//  The user's binary function, as used by scanLookbackTile
+template< typename T, typename BinaryFunction >
+struct scanLookbackOp
+{
+    global BinaryFunction* binaryOp;
+
+    T operator( )( const T& lhs, const T& rhs ) const
+    {
+        return ( *binaryOp )( lhs, rhs );
+    }
+
+    //  Whether the tiles before prefix can still change it
+    bool complete( const T& prefix ) const
+    {
+        return false;
+    }
+};
+
+//  An element or a run of elements of scan_by_key; bit 0 of head is set when a segment starts in the run, and
+//  bit 1 when one starts at its last element
+template< typename T >
+struct scanLookbackSegment
+{
+    uint head;
+    T value;
+};
+
+//  Combines two runs of scan_by_key: the later one starts over when a segment starts in it
+template< typename T, typename BinaryFunction >
+struct scanLookbackSegmentOp
+{
+    global BinaryFunction* binaryOp;
+
+    scanLookbackSegment< T > operator( )( const scanLookbackSegment< T >& lhs,
+                                          const scanLookbackSegment< T >& rhs ) const
+    {
+        scanLookbackSegment< T > result;
+        result.head = ( lhs.head & 1 ) | rhs.head;
+        result.value = ( rhs.head & 1 ) ? rhs.value : ( *binaryOp )( lhs.value, rhs.value );
+        return result;
+    }
+
+    //  A run that starts a segment is complete
+    bool complete( const scanLookbackSegment< T >& prefix ) const
+    {
+        return ( prefix.head & 1 ) != 0;
+    }
+};
+
+//  Reads a value that another work group published, with volatile loads so that no stale cache line is used
+template< typename T >
+inline T scanLookbackLoad( global T* slot )
+{
+    T value;
+    global volatile uint* srcWords = ( global volatile uint* )slot;
+    uint* dstWords = ( uint* )&value;
+    uint numWords = sizeof( T ) / sizeof( uint );
+    for( uint i = 0; i < numWords; ++i )
+        dstWords[ i ] = srcWords[ i ];
+
+    global volatile uchar* srcBytes = ( global volatile uchar* )slot;
+    uchar* dstBytes = ( uchar* )&value;
+    for( uint i = numWords * sizeof( uint ); i < sizeof( T ); ++i )
+        dstBytes[ i ] = srcBytes[ i ];
+    return value;
+}
+
+//  Writes value to slot and then announces it with status
+template< typename T >
+inline void scanLookbackPublish( global uint* tileStatus, global T* tileValues, uint tile, uint status, T value )
+{
+    tileValues[ 2 * tile + ( status == SCAN_LOOKBACK_PREFIX ? 1 : 0 ) ] = value;
+    mem_fence( CLK_GLOBAL_MEM_FENCE );
+    atomic_xchg( &tileStatus[ 1 + tile ], status );
+}
+
+//  Spins until the tile has published something, and returns its status
+inline uint scanLookbackWait( global uint* tileStatus, uint tile )
+{
+    uint status;
+    do
+    {
+        status = atomic_add( &tileStatus[ 1 + tile ], 0 );
+    } while( status == SCAN_LOOKBACK_NOT_READY );
+    mem_fence( CLK_GLOBAL_MEM_FENCE );
+    return status;
+}
+
+//  The next tile to scan, in the order the work groups started
+inline uint scanLookbackAcquireTile( global uint* tileStatus, local uint* tileId )
+{
+    if( get_local_id( 0 ) == 0 )
+        *tileId = atomic_inc( &tileStatus[ 0 ] );
+    barrier( CLK_LOCAL_MEM_FENCE );
+    return *tileId;
+}
+
+/*  Turns lds[ 0, count ) into the inclusive scan of the whole input up to every element; lds[ SCAN_LOOKBACK_PREFIX_SLOT ]
+ *  is left holding the combination of all the tiles before this one, for tiles other than the first.
+ */
+template< typename T, typename ScanOp >
+void scanLookbackTile( local T* lds, uint tile, uint count, global uint* tileStatus, global T* tileValues,
+                       ScanOp scanOp )
+{
+    uint locId = get_local_id( 0 );
+    local T* totals = lds + SCAN_LOOKBACK_TILE;
+    barrier( CLK_LOCAL_MEM_FENCE );
+
+    //  Every work item scans its own consecutive elements
+    uint first = locId * SCAN_LOOKBACK_ITEMS;
+    uint last = min( first + SCAN_LOOKBACK_ITEMS, count );
+    T sum;
+    if( first < count )
+    {
+        sum = lds[ first ];
+        for( uint i = first + 1; i < last; ++i )
+        {
+            sum = scanOp( sum, lds[ i ] );
+            lds[ i ] = sum;
+        }
+        totals[ locId ] = sum;
+    }
+
+    //  Scan the work item totals; only the work items holding elements take part, and they come first
+    for( uint offset = 1; offset < SCAN_LOOKBACK_WGSIZE; offset *= 2 )
+    {
+        barrier( CLK_LOCAL_MEM_FENCE );
+        T y;
+        bool active = ( first < count ) && ( locId >= offset );
+        if( active )
+            y = totals[ locId - offset ];
+        barrier( CLK_LOCAL_MEM_FENCE );
+        if( active )
+        {
+            sum = scanOp( y, sum );
+            totals[ locId ] = sum;
+        }
+    }
+    barrier( CLK_LOCAL_MEM_FENCE );
+
+    //  One work item publishes the tile and looks back for its prefix
+    if( locId == 0 )
+    {
+        T aggregate = totals[ ( count - 1 ) / SCAN_LOOKBACK_ITEMS ];
+        if( tile == 0 )
+        {
+            scanLookbackPublish( tileStatus, tileValues, tile, SCAN_LOOKBACK_PREFIX, aggregate );
+        }
+        else
+        {
+            scanLookbackPublish( tileStatus, tileValues, tile, SCAN_LOOKBACK_AGGREGATE, aggregate );
+
+            uint previous = tile - 1;
+            uint status = scanLookbackWait( tileStatus, previous );
+            T prefix = scanLookbackLoad( tileValues + 2 * previous + ( status == SCAN_LOOKBACK_PREFIX ? 1 : 0 ) );
+            while( status != SCAN_LOOKBACK_PREFIX && !scanOp.complete( prefix ) )
+            {
+                --previous;
+                status = scanLookbackWait( tileStatus, previous );
+                T y = scanLookbackLoad( tileValues + 2 * previous + ( status == SCAN_LOOKBACK_PREFIX ? 1 : 0 ) );
+                prefix = scanOp( y, prefix );
+            }
+
+            scanLookbackPublish( tileStatus, tileValues, tile, SCAN_LOOKBACK_PREFIX, scanOp( prefix, aggregate ) );
+            lds[ SCAN_LOOKBACK_PREFIX_SLOT ] = prefix;
+        }
+    }
+    barrier( CLK_LOCAL_MEM_FENCE );
+
+    //  Add what comes before every work item's elements
+    if( first < count )
+    {
+        for( uint i = first; i < last; ++i )
+        {
+            T value = lds[ i ];
+            if( locId > 0 )
+                value = scanOp( totals[ locId - 1 ], value );
+            if( tile > 0 )
+                value = scanOp( lds[ SCAN_LOOKBACK_PREFIX_SLOT ], value );
+            lds[ i ] = value;
+        }
+    }
+    barrier( CLK_LOCAL_MEM_FENCE );
+}
+
+/******************************************************************************
+ *  scan
+ *****************************************************************************/
+//  An exclusive scan is written as init combined with the inclusive scan up to the element before, which the tile
+//  has in local memory or as its prefix, so no tile reads an element another tile may already have overwritten
+template< typename iPtrType, typename iIterType, typename oPtrType, typename oIterType, typename initType,
+          typename BinaryFunction >
+kernel void singlePassScan(
+                global oPtrType* output_ptr,
+                oIterType    output_iter,
+                global iPtrType* input_ptr,
+                iIterType    input_iter,
+                initType identity,
+                const uint vecSize,
+                local oPtrType* lds,
+                global BinaryFunction* binaryOp,
+                global uint* tileStatus,
+                global oPtrType* tileValues,
+                int exclusive )
+{
+    local uint tileId;
+    uint locId = get_local_id( 0 );
+    output_iter.init( output_ptr );
+    input_iter.init( input_ptr );
+
+    uint tile = scanLookbackAcquireTile( tileStatus, &tileId );
+    uint tileFirst = tile * SCAN_LOOKBACK_TILE;
+    uint count = min( ( uint )SCAN_LOOKBACK_TILE, vecSize - tileFirst );
+
+    for( uint i = locId; i < count; i += SCAN_LOOKBACK_WGSIZE )
+    {
+        oPtrType val = input_iter[ tileFirst + i ];
+        lds[ i ] = val;
+    }
+
+    scanLookbackOp< oPtrType, BinaryFunction > scanOp;
+    scanOp.binaryOp = binaryOp;
+    scanLookbackTile( lds, tile, count, tileStatus, tileValues, scanOp );
+
+    for( uint i = locId; i < count; i += SCAN_LOOKBACK_WGSIZE )
+    {
+        if( exclusive )
+        {
+            oPtrType val = identity;
+            if( tileFirst + i > 0 )
+                val = scanOp( val, ( i > 0 ) ? lds[ i - 1 ] : lds[ SCAN_LOOKBACK_PREFIX_SLOT ] );
+            output_iter[ tileFirst + i ] = val;
+        }
+        else
+            output_iter[ tileFirst + i ] = lds[ i ];
+    }
+}
+
+/******************************************************************************
+ *  transform_scan
+ *****************************************************************************/
+template< typename iPtrType, typename iIterType, typename oPtrType, typename oIterType, typename initType,
+          typename UnaryFunction, typename BinaryFunction >
+kernel void singlePassTransformScan(
+                global oPtrType* output_ptr,
+                oIterType    output_iter,
+                global iPtrType* input_ptr,
+                iIterType    input_iter,
+                initType identity,
+                const uint vecSize,
+                local oPtrType* lds,
+                global UnaryFunction* unaryOp,
+                global BinaryFunction* binaryOp,
+                global uint* tileStatus,
+                global oPtrType* tileValues,
+                int exclusive )
+{
+    local uint tileId;
+    uint locId = get_local_id( 0 );
+    output_iter.init( output_ptr );
+    input_iter.init( input_ptr );
+
+    uint tile = scanLookbackAcquireTile( tileStatus, &tileId );
+    uint tileFirst = tile * SCAN_LOOKBACK_TILE;
+    uint count = min( ( uint )SCAN_LOOKBACK_TILE, vecSize - tileFirst );
+
+    for( uint i = locId; i < count; i += SCAN_LOOKBACK_WGSIZE )
+    {
+        iPtrType inVal = input_iter[ tileFirst + i ];
+        lds[ i ] = ( oPtrType )( *unaryOp )( inVal );
+    }
+
+    scanLookbackOp< oPtrType, BinaryFunction > scanOp;
+    scanOp.binaryOp = binaryOp;
+    scanLookbackTile( lds, tile, count, tileStatus, tileValues, scanOp );
+
+    for( uint i = locId; i < count; i += SCAN_LOOKBACK_WGSIZE )
+    {
+        if( exclusive )
+        {
+            oPtrType val = identity;
+            if( tileFirst + i > 0 )
+                val = scanOp( val, ( i > 0 ) ? lds[ i - 1 ] : lds[ SCAN_LOOKBACK_PREFIX_SLOT ] );
+            output_iter[ tileFirst + i ] = val;
+        }
+        else
+            output_iter[ tileFirst + i ] = lds[ i ];
+    }
+}
+
+/******************************************************************************
+ *  scan_by_key
+ *****************************************************************************/
+//  An element starts a segment when binaryPred does not hold between its key and the key before it; an exclusive
+//  scan writes init at the start of every segment
+template< typename kType, typename vType, typename oType, typename initType, typename BinaryPredicate,
+          typename BinaryFunction >
+kernel void singlePassScanByKey(
+                global kType* keys,
+                global vType* vals,
+                global oType* output,
+                initType init,
+                const uint vecSize,
+                local scanLookbackSegment< oType >* lds,
+                global BinaryPredicate* binaryPred,
+                global BinaryFunction* binaryFunct,
+                global uint* tileStatus,
+                global scanLookbackSegment< oType >* tileValues,
+                int exclusive )
+{
+    local uint tileId;
+    uint locId = get_local_id( 0 );
+
+    uint tile = scanLookbackAcquireTile( tileStatus, &tileId );
+    uint tileFirst = tile * SCAN_LOOKBACK_TILE;
+    uint count = min( ( uint )SCAN_LOOKBACK_TILE, vecSize - tileFirst );
+
+    for( uint i = locId; i < count; i += SCAN_LOOKBACK_WGSIZE )
+    {
+        uint index = tileFirst + i;
+        scanLookbackSegment< oType > element;
+        element.head = 3;
+        if( index > 0 )
+        {
+            kType curKey = keys[ index ];
+            kType preKey = keys[ index - 1 ];
+            if( ( *binaryPred )( curKey, preKey ) )
+                element.head = 0;
+        }
+        element.value = vals[ index ];
+        lds[ i ] = element;
+    }
+
+    scanLookbackSegmentOp< oType, BinaryFunction > scanOp;
+    scanOp.binaryOp = binaryFunct;
+    scanLookbackTile( lds, tile, count, tileStatus, tileValues, scanOp );
+
+    for( uint i = locId; i < count; i += SCAN_LOOKBACK_WGSIZE )
+    {
+        if( exclusive )
+        {
+            oType val = init;
+            if( !( lds[ i ].head & 2 ) )
+            {
+                oType before = ( i > 0 ) ? lds[ i - 1 ].value : lds[ SCAN_LOOKBACK_PREFIX_SLOT ].value;
+                val = ( *binaryFunct )( val, before );
+            }
+            output[ tileFirst + i ] = val;
+        }
+        else
+            output[ tileFirst + i ] = lds[ i ].value;
+    }
+}
@@ -0,0 +1,180 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+#if !defined( OCL_SCAN_STREAM_H )
+#define OCL_SCAN_STREAM_H
+#pragma once
+
+#include <bolt/cl/bolt.h>
+#include <bolt/cl/functional.h>
+#include <bolt/cl/device_vector.h>
+#include <string>
+
+/*! \file bolt/cl/scan_stream.h
+    \brief Scans a sequence that arrives in chunks, carrying the running total from one chunk to the next.
+*/
+
+namespace bolt {
+    namespace cl {
+
+        namespace detail {
+            template< typename K, typename T, typename BinaryPredicate, typename BinaryFunction >
+            class scanStreamState;
+        };
+
+        /*! \addtogroup algorithms
+         */
+
+        /*! \addtogroup PrefixSums Prefix Sums
+        *   \ingroup algorithms
+        */
+
+        /*! \addtogroup CL-scan_stream
+        *   \ingroup PrefixSums
+        *   \{
+        */
+
+        /*! \brief \p scan_stream scans successive chunks of one sequence, as if they were scanned together.
+        *
+        * Every call scans a chunk into its result, starting from the total of the chunks before it.  On the OpenCL
+        * path the total stays on the device between calls: a chunk held in a device_vector is scanned in one pass,
+        * and the call returns without waiting for it.  The kernels and the temporary buffers are kept by the
+        * stream and reused from chunk to chunk.  On the CPU run modes, the chunks are scanned on the host.
+        *
+        * \tparam T The type of the values and of the results; chunks hold values of type T.
+        * \tparam BinaryFunction An associative binary function object, by default plus<T>.
+        *
+        * \details The following code example computes the running total of three chunks.
+        * \code
+        * #include <bolt/cl/scan_stream.h>
+        *
+        * int a[4] = {1, 2, 3, 4};
+        * int out[4];
+        *
+        * bolt::cl::scan_stream< int > running;
+        * running(a, a+4, out);  // out => {1, 3, 6, 10}
+        * running(a, a+4, out);  // out => {11, 13, 16, 20}
+        * running(a, a+2, out);  // out => {21, 23}
+        * int total = running.carry( );  // total => 23
+        *  \endcode
+        */
+        template< typename T, typename BinaryFunction = bolt::cl::plus< T > >
+        class scan_stream
+        {
+        public:
+            /*! \brief A stream scanned with binary_op
+            *   \param inclusive Whether a result includes its own value; an exclusive stream starts from \p init.
+            *   \param init The first result of an exclusive stream.
+            *   \param binary_op The binary operation used to combine two values.
+            *   \param cl_code Optional OpenCL(TM) code to be passed to the OpenCL compiler.
+            */
+            scan_stream( bool inclusive = true, const T& init = T( ),
+                         const BinaryFunction& binary_op = BinaryFunction( ), const std::string& cl_code = "" );
+
+            scan_stream( control& ctl, bool inclusive = true, const T& init = T( ),
+                         const BinaryFunction& binary_op = BinaryFunction( ), const std::string& cl_code = "" );
+
+            /*! \brief Scans the chunk [first, last) into \p result
+            *   \return The end of the results.
+            */
+            template< typename InputIterator, typename OutputIterator >
+            OutputIterator operator( )( InputIterator first, InputIterator last, OutputIterator result );
+
+            /*! \brief The total of the chunks scanned so far, or \p init before the first; waits for the last chunk
+            */
+            T carry( );
+
+            /*! \brief Starts the stream over; the next chunk is scanned as the first
+            */
+            void reset( );
+
+        private:
+            detail::scanStreamState< int, T, bolt::cl::equal_to< int >, BinaryFunction > m_state;
+        };
+
+        /*! \brief \p scan_by_key_stream scans successive chunks of one sequence by key, as if they were scanned
+        * together.
+        *
+        * Like \p scan_by_key, consecutive values whose keys \p binary_pred finds equal form a segment, and every
+        * segment is scanned on its own.  A segment may run on from one chunk into the next: the last key and the
+        * total of its segment are kept, on the device on the OpenCL path, and the first key of the next chunk is
+        * compared with that key.
+        *
+        * \tparam K The type of the keys.
+        * \tparam T The type of the values and of the results.
+        * \tparam BinaryPredicate A binary predicate that tells whether two keys are in one segment.
+        * \tparam BinaryFunction An associative binary function object, by default plus<T>.
+        *
+        * \code
+        * #include <bolt/cl/scan_stream.h>
+        *
+        * int keys[4] = {1, 1, 2, 2};
+        * int vals[4] = {1, 1, 1, 1};
+        * int more[2] = {2, 3};
+        * int out[4];
+        *
+        * bolt::cl::scan_by_key_stream< int, int > running;
+        * running(keys, keys+4, vals, out);  // out => {1, 2, 1, 2}
+        * running(more, more+2, vals, out);  // out => {3, 1}
+        *  \endcode
+        */
+        template< typename K, typename T, typename BinaryPredicate = bolt::cl::equal_to< K >,
+                  typename BinaryFunction = bolt::cl::plus< T > >
+        class scan_by_key_stream
+        {
+        public:
+            /*! \brief A stream scanned by key with binary_op
+            *   \param inclusive Whether a result includes its own value; an exclusive segment starts from \p init.
+            *   \param init The first result of every segment of an exclusive stream.
+            *   \param binary_pred The binary predicate that tells whether two keys are in one segment.
+            *   \param binary_op The binary operation used to combine two values.
+            *   \param cl_code Optional OpenCL(TM) code to be passed to the OpenCL compiler.
+            */
+            scan_by_key_stream( bool inclusive = true, const T& init = T( ),
+                                const BinaryPredicate& binary_pred = BinaryPredicate( ),
+                                const BinaryFunction& binary_op = BinaryFunction( ), const std::string& cl_code = "" );
+
+            scan_by_key_stream( control& ctl, bool inclusive = true, const T& init = T( ),
+                                const BinaryPredicate& binary_pred = BinaryPredicate( ),
+                                const BinaryFunction& binary_op = BinaryFunction( ), const std::string& cl_code = "" );
+
+            /*! \brief Scans the values of the chunk of keys [keys_first, keys_last) into \p result
+            *   \return The end of the results.
+            */
+            template< typename InputIterator1, typename InputIterator2, typename OutputIterator >
+            OutputIterator operator( )( InputIterator1 keys_first, InputIterator1 keys_last,
+                                        InputIterator2 values_first, OutputIterator result );
+
+            /*! \brief The total of the segment the chunks so far end in, or \p init before the first; waits for the
+            *   last chunk
+            */
+            T carry( );
+
+            /*! \brief Starts the stream over; the next chunk is scanned as the first
+            */
+            void reset( );
+
+        private:
+            detail::scanStreamState< K, T, BinaryPredicate, BinaryFunction > m_state;
+        };
+
+        /*!   \}  */
+
+    };
+};
+
+#include <bolt/cl/detail/scan_stream.inl>
+#endif
@@ -0,0 +1,159 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+#if !defined( OCL_SEGMENTED_REDUCE_H )
+#define OCL_SEGMENTED_REDUCE_H
+#pragma once
+
+#include <bolt/cl/bolt.h>
+#include <bolt/cl/functional.h>
+#include <bolt/cl/device_vector.h>
+#include <string>
+
+/*! \file bolt/cl/segmented_reduce.h
+    \brief Reduces every segment of a range to a single value.
+*/
+
+namespace bolt {
+    namespace cl {
+
+        /*! \addtogroup algorithms
+         */
+
+        /*! \addtogroup reductions
+        *   \ingroup algorithms
+        */
+
+        /*! \addtogroup CL-segmented_reduce
+        *   \ingroup reductions
+        *   \{
+        */
+
+        /*! \brief \p segmented_reduce reduces each segment of [first, last) to one value, stored in order from
+        * \p result.
+        *
+        * The segments are given by the offsets, relative to \p first, at which they begin: segment i is
+        * [first + offsets[i], first + offsets[i+1]), and the last segment ends at \p last.  The offsets must be in
+        * ascending order and no greater than the length of the range.  An empty segment reduces to \p init; elements
+        * before the first offset belong to no segment and are ignored.
+        *
+        * \details Unlike \p reduce_by_key, no keys are compared.  On the OpenCL path the offsets are turned into a
+        * bitmap of segment heads, one bit an element, and the values are scanned by segment under it, so any number
+        * of segments of any lengths is reduced by the same four kernel launches.  \p binary_op must be associative.
+        *
+        * \param ctl \b Optional Control structure to control command-queue, debug, tuning, etc. See bolt::cl::control.
+        * \param first The first position in the sequence to be reduced.
+        * \param last  The last position in the sequence to be reduced.
+        * \param offsets_first The offset of the first segment.
+        * \param offsets_last  The end of the offsets.
+        * \param result The first position the reductions are stored at, one for every offset.
+        * \param init  The initial value of every segment's reduction.
+        * \param binary_op  The binary operation used to combine two values.
+        * \param cl_code Optional OpenCL(TM) code to be passed to the OpenCL compiler. The cl_code is inserted first in
+        * the generated code, before the cl_code traits.
+        * \return The end of the reductions, \p result plus the number of offsets.
+        *
+        *  \tparam InputIterator Is a model of http://www.sgi.com/tech/stl/InputIterator.html
+        *  \tparam OffsetIterator Is a model of http://www.sgi.com/tech/stl/RandomAccessIterator.html over an integral
+        *  type; a device_vector iterator is mapped to the host once.
+        *  \tparam OutputIterator Is a model of http://www.sgi.com/tech/stl/OutputIterator.html
+        *  \tparam BinaryFunction Is a model of http://www.sgi.com/tech/stl/BinaryFunction.html
+        *
+        * \details The following code example finds the largest element of three lists held in one array.
+        * \code
+        * #include <bolt/cl/segmented_reduce.h>
+        *
+        * int a[10] = {5, 2, 9, 7, 1, 3, 8, 6, 0, 4};
+        * int offsets[3] = {0, 3, 4};
+        * int maxima[3];
+        *
+        * bolt::cl::segmented_reduce(a, a+10, offsets, offsets+3, maxima, -1, bolt::cl::maximum<int>());
+        *
+        * // maxima => {9, 7, 8}
+        *  \endcode
+        */
+        template<typename InputIterator, typename OffsetIterator, typename OutputIterator, typename T,
+                 typename BinaryFunction>
+        OutputIterator segmented_reduce(bolt::cl::control &ctl,
+            InputIterator first,
+            InputIterator last,
+            OffsetIterator offsets_first,
+            OffsetIterator offsets_last,
+            OutputIterator result,
+            T init,
+            BinaryFunction binary_op,
+            const std::string& cl_code="");
+
+        template<typename InputIterator, typename OffsetIterator, typename OutputIterator, typename T,
+                 typename BinaryFunction>
+        OutputIterator segmented_reduce(InputIterator first,
+            InputIterator last,
+            OffsetIterator offsets_first,
+            OffsetIterator offsets_last,
+            OutputIterator result,
+            T init,
+            BinaryFunction binary_op,
+            const std::string& cl_code="");
+
+        /*! \brief \p segmented_reduce sums each segment of [first, last), starting from a value initialized
+        * element.
+        *
+        * \param ctl \b Optional Control structure to control command-queue, debug, tuning, etc. See bolt::cl::control.
+        * \param first The first position in the sequence to be reduced.
+        * \param last  The last position in the sequence to be reduced.
+        * \param offsets_first The offset of the first segment.
+        * \param offsets_last  The end of the offsets.
+        * \param result The first position the sums are stored at, one for every offset.
+        * \param cl_code Optional OpenCL(TM) code to be passed to the OpenCL compiler. The cl_code is inserted first in
+        * the generated code, before the cl_code traits.
+        * \return The end of the sums, \p result plus the number of offsets.
+        *
+        * \code
+        * #include <bolt/cl/segmented_reduce.h>
+        *
+        * int a[6] = {1, 2, 3, 4, 5, 6};
+        * int offsets[3] = {0, 2, 2};
+        * int sums[3];
+        *
+        * bolt::cl::segmented_reduce(a, a+6, offsets, offsets+3, sums);
+        *
+        * // sums => {3, 0, 18}
+        *  \endcode
+        */
+        template<typename InputIterator, typename OffsetIterator, typename OutputIterator>
+        OutputIterator segmented_reduce(bolt::cl::control &ctl,
+            InputIterator first,
+            InputIterator last,
+            OffsetIterator offsets_first,
+            OffsetIterator offsets_last,
+            OutputIterator result,
+            const std::string& cl_code="");
+
+        template<typename InputIterator, typename OffsetIterator, typename OutputIterator>
+        OutputIterator segmented_reduce(InputIterator first,
+            InputIterator last,
+            OffsetIterator offsets_first,
+            OffsetIterator offsets_last,
+            OutputIterator result,
+            const std::string& cl_code="");
+
+        /*!   \}  */
+
+    };
+};
+
+#include <bolt/cl/detail/segmented_reduce.inl>
+#endif
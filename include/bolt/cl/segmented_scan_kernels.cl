@@ -0,0 +1,321 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+/*  The segmented scan engine shared by scan_by_key, reduce_by_key and segmented_reduce.  Segments are described by a
+ *  bitmap of head flags, one bit an element: bit j of flags[ w ] is set when element 32 * w + j starts a segment.
+ *  The keys are compared once, by segmentedHeadFlags; the scan kernels only read the bitmap, whatever the key type.
+ *
+ *  The scan is the three kernel scan of scan_kernels.cl with a head flag carried next to every value: a flagged
+ *  element does not take the values before it, and a block passes its total on only to the elements before its first
+ *  head.  Values are combined as binaryFunct( earlier, later ).  Element counts, offsets and the head counts are
+ *  indexType, of the width the host compiled for; the flag words stay 32 bit.
+ */
+
+#define SEGMENTED_HEAD( flags, index ) ( ( ( flags )[ ( index ) >> 5 ] >> ( ( index ) & 31 ) ) & 1 )
+
+/******************************************************************************
+ *  Head flags
+ *****************************************************************************/
+//  An element starts a segment when binaryPred does not hold between its key and the key before it.  Every work item
+//  compares one key with the one before it, and the work group packs its SEGMENTED_WGSIZE flags into words.
+//  counts[ w ] is the number of heads in flags[ w ]; its inclusive scan numbers the segments.  The first key starts a
+//  segment unless hasPrevKey is set and it continues the segment of prevKey, the last key of the chunk before.
+template< typename kType, typename BinaryPredicate >
+kernel void segmentedHeadFlags(
+    global kType* keys,
+    const indexType keyOffset,
+    const indexType vecSize,
+    global BinaryPredicate* binaryPred,
+    global uint* flags,
+    global indexType* counts,
+    global kType* prevKey,
+    int hasPrevKey )
+{
+    local uint ldsFlags[ SEGMENTED_WGSIZE / 32 ];
+
+    indexType gloId = get_global_id( 0 );
+    uint locId = get_local_id( 0 );
+
+    if( locId < SEGMENTED_WGSIZE / 32 )
+        ldsFlags[ locId ] = 0;
+    barrier( CLK_LOCAL_MEM_FENCE );
+
+    if( gloId < vecSize )
+    {
+        bool head = true;
+        if( gloId > 0 )
+        {
+            kType curKey = keys[ keyOffset + gloId ];
+            kType preKey = keys[ keyOffset + gloId - 1 ];
+            head = !( *binaryPred )( curKey, preKey );
+        }
+        else if( hasPrevKey )
+        {
+            kType curKey = keys[ keyOffset ];
+            kType preKey = prevKey[ 0 ];
+            head = !( *binaryPred )( curKey, preKey );
+        }
+        if( head )
+            atomic_or( &ldsFlags[ locId >> 5 ], 1u << ( locId & 31 ) );
+    }
+    barrier( CLK_LOCAL_MEM_FENCE );
+
+    indexType word = get_group_id( 0 ) * ( SEGMENTED_WGSIZE / 32 ) + locId;
+    if( locId < SEGMENTED_WGSIZE / 32 && word * 32 < vecSize )
+    {
+        uint bits = ldsFlags[ locId ];
+        flags[ word ] = bits;
+        counts[ word ] = popcount( bits );
+    }
+}
+
+/******************************************************************************
+ *  Segmented scan
+ *****************************************************************************/
+//  Inclusive scan of the work group's values and flags in lds; value and head are the work item's own on entry and its
+//  scan on return
+template< typename oType, typename BinaryFunction >
+void segmentedScanLds(
+    local oType* ldsVals,
+    local uint* ldsFlags,
+    oType* value,
+    uint* head,
+    global BinaryFunction* binaryFunct )
+{
+    uint locId = get_local_id( 0 );
+    ldsVals[ locId ] = *value;
+    ldsFlags[ locId ] = *head;
+
+    for( uint offset = 1; offset < SEGMENTED_WGSIZE; offset *= 2 )
+    {
+        barrier( CLK_LOCAL_MEM_FENCE );
+        oType before;
+        uint beforeHead;
+        if( locId >= offset )
+        {
+            before = ldsVals[ locId - offset ];
+            beforeHead = ldsFlags[ locId - offset ];
+        }
+        barrier( CLK_LOCAL_MEM_FENCE );
+        if( locId >= offset )
+        {
+            if( !*head )
+                *value = ( *binaryFunct )( before, *value );
+            *head |= beforeHead;
+            ldsVals[ locId ] = *value;
+            ldsFlags[ locId ] = *head;
+        }
+    }
+    barrier( CLK_LOCAL_MEM_FENCE );
+}
+
+//  Scans every block of SEGMENTED_WGSIZE elements on its own.  An exclusive scan shifts the values by one within each
+//  segment and starts every segment with init, so its inclusive scan is the exclusive scan of the input.  The block
+//  total and flag go to blockVals and blockFlags, and the index of the first head of the block, or SEGMENTED_WGSIZE,
+//  to blockFirstHead.  When hasCarry is set, a first element that is not a head continues the segment the carry ends,
+//  the total of a chunk scanned before; it then starts from the carry and heads the scan of the chunk.  The first
+//  element of a block shifts in the value segmentedScanBoundaries saved, as the block before may already have
+//  overwritten it when the output is the values themselves.
+template< typename vType, typename oType, typename initType, typename BinaryFunction >
+kernel void segmentedScanPerBlock(
+    global vType* vals,
+    const indexType valOffset,
+    global uint* flags,
+    global oType* output,
+    const indexType outOffset,
+    initType init,
+    const indexType vecSize,
+    local oType* ldsVals,
+    global BinaryFunction* binaryFunct,
+    global oType* blockVals,
+    global uint* blockFlags,
+    global uint* blockFirstHead,
+    int exclusive,
+    global oType* carry,
+    int hasCarry,
+    global vType* blockBoundaries )
+{
+    local uint ldsFlags[ SEGMENTED_WGSIZE ];
+
+    indexType gloId = get_global_id( 0 );
+    indexType groId = get_group_id( 0 );
+    uint locId = get_local_id( 0 );
+
+    //  Work items past the end start segments of their own, so they never reach the elements before them
+    uint head = 1;
+    oType value;
+    if( gloId < vecSize )
+    {
+        head = SEGMENTED_HEAD( flags, gloId );
+        if( !exclusive )
+            value = vals[ valOffset + gloId ];
+        else if( head || gloId == 0 )
+            value = init;
+        else if( locId == 0 )
+            value = blockBoundaries[ groId ];
+        else
+            value = vals[ valOffset + gloId - 1 ];
+
+        if( gloId == 0 && hasCarry && !head )
+        {
+            oType carryValue = carry[ 0 ];
+            value = exclusive ? carryValue : ( *binaryFunct )( carryValue, value );
+            head = 1;
+        }
+    }
+
+    segmentedScanLds( ldsVals, ldsFlags, &value, &head, binaryFunct );
+
+    if( gloId < vecSize )
+        output[ outOffset + gloId ] = value;
+
+    if( head && ( locId == 0 || !ldsFlags[ locId - 1 ] ) )
+        blockFirstHead[ groId ] = locId;
+    if( locId == SEGMENTED_WGSIZE - 1 )
+    {
+        if( !head )
+            blockFirstHead[ groId ] = SEGMENTED_WGSIZE;
+        blockVals[ groId ] = value;
+        blockFlags[ groId ] = head;
+    }
+}
+
+//  Saves the last value of every block but the last to blockBoundaries[ b + 1 ], ahead of an exclusive
+//  segmentedScanPerBlock
+template< typename vType >
+kernel void segmentedScanBoundaries(
+    global vType* vals,
+    const indexType valOffset,
+    const indexType numBlocks,
+    global vType* blockBoundaries )
+{
+    indexType block = get_global_id( 0 );
+    if( block == 0 || block >= numBlocks )
+        return;
+
+    blockBoundaries[ block ] = vals[ valOffset + block * SEGMENTED_WGSIZE - 1 ];
+}
+
+//  One work group scans the block totals in place; every work item scans workPerThread consecutive blocks serially
+//  first.  blockVals[ b ] then holds the value the elements of block b + 1 before its first head continue from.
+template< typename oType, typename BinaryFunction >
+kernel void segmentedScanBlocks(
+    global oType* blockVals,
+    global uint* blockFlags,
+    const indexType numBlocks,
+    const indexType workPerThread,
+    local oType* ldsVals,
+    global BinaryFunction* binaryFunct )
+{
+    local uint ldsFlags[ SEGMENTED_WGSIZE ];
+
+    uint locId = get_local_id( 0 );
+    indexType first = min( locId * workPerThread, numBlocks );
+    indexType last = min( first + workPerThread, numBlocks );
+
+    uint head = 1;
+    oType value;
+    if( first < last )
+    {
+        head = blockFlags[ first ];
+        value = blockVals[ first ];
+        for( indexType b = first + 1; b < last; ++b )
+        {
+            uint blockHead = blockFlags[ b ];
+            oType blockValue = blockVals[ b ];
+            value = blockHead ? blockValue : ( *binaryFunct )( value, blockValue );
+            head |= blockHead;
+            blockVals[ b ] = value;
+        }
+    }
+
+    segmentedScanLds( ldsVals, ldsFlags, &value, &head, binaryFunct );
+
+    if( locId > 0 && first < last )
+    {
+        oType before = ldsVals[ locId - 1 ];
+        for( indexType b = first; b < last && !blockFlags[ b ]; ++b )
+            blockVals[ b ] = ( *binaryFunct )( before, blockVals[ b ] );
+    }
+}
+
+//  Adds the scanned total of the blocks before to the elements of a block that come before its first head
+template< typename oType, typename BinaryFunction >
+kernel void segmentedScanAddition(
+    global oType* output,
+    const indexType outOffset,
+    const indexType vecSize,
+    global oType* blockVals,
+    global uint* blockFirstHead,
+    global BinaryFunction* binaryFunct )
+{
+    indexType gloId = get_global_id( 0 );
+    indexType groId = get_group_id( 0 );
+
+    if( groId == 0 || gloId >= vecSize || get_local_id( 0 ) >= blockFirstHead[ groId ] )
+        return;
+
+    oType before = blockVals[ groId - 1 ];
+    output[ outOffset + gloId ] = ( *binaryFunct )( before, output[ outOffset + gloId ] );
+}
+
+//  The total a stream chunk hands on to the next: its last output, and for an exclusive scan the last value too.
+//  lastValue holds a copy of the last value taken before the scan, since the scan may overwrite it.
+template< typename vType, typename oType, typename BinaryFunction >
+kernel void segmentedScanCarryOut(
+    global oType* output,
+    const indexType outOffset,
+    const indexType vecSize,
+    global vType* lastValue,
+    global BinaryFunction* binaryFunct,
+    global oType* carry,
+    int exclusive )
+{
+    oType value = output[ outOffset + vecSize - 1 ];
+    if( exclusive )
+    {
+        vType last = lastValue[ 0 ];
+        value = ( *binaryFunct )( value, last );
+    }
+    carry[ 0 ] = value;
+}
+
+/******************************************************************************
+ *  segmented_reduce
+ *****************************************************************************/
+//  The reduction of segment s is the inclusive segmented scan at its last element; empty segments get init
+template< typename oType, typename initType, typename BinaryFunction >
+kernel void segmentedReduceGather(
+    global oType* scanned,
+    global indexType* offsets,
+    const indexType numSegments,
+    initType init,
+    global BinaryFunction* binaryFunct,
+    global oType* output,
+    const indexType outOffset )
+{
+    indexType segment = get_global_id( 0 );
+    if( segment >= numSegments )
+        return;
+
+    indexType first = offsets[ segment ];
+    indexType last = offsets[ segment + 1 ];
+    oType value = init;
+    if( first < last )
+        value = ( *binaryFunct )( value, scanned[ last - 1 ] );
+    output[ outOffset + segment ] = value;
+}
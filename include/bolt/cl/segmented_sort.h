@@ -0,0 +1,243 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#if !defined( OCL_SEGMENTED_SORT_H )
+#define OCL_SEGMENTED_SORT_H
+#pragma once
+
+#include <bolt/cl/bolt.h>
+#include <bolt/cl/functional.h>
+#include <string>
+
+/*! \file bolt/cl/segmented_sort.h
+    \brief Sorts every segment of a range on its own.
+*/
+
+namespace bolt {
+    namespace cl {
+
+        /*! \addtogroup algorithms
+         */
+
+        /*! \addtogroup sorting
+        *   \ingroup algorithms
+        */
+
+        /*! \addtogroup CL-segmented_sort
+        *   \ingroup sorting
+        *   \{
+        */
+
+        /*! \brief \p segmented_sort sorts each segment of [first, last) independently, in ascending order.
+        *
+        * The segments are given by the offsets, relative to \p first, at which they begin: segment i is
+        * [first + offsets[i], first + offsets[i+1]), and the last segment ends at \p last.  The offsets must be in
+        * ascending order and no greater than the length of the range; empty segments are allowed.  Elements before
+        * the first offset, if any, form a segment of their own.
+        *
+        * On the OpenCL path, segments that fit in a work group's tile are packed together and sorted in local
+        * memory by a single kernel launch, however many of them there are; each longer segment is sorted by the
+        * regular device sort.  The order of equal elements is not preserved.
+        *
+        * \param ctl \b Optional Control structure to control command-queue, debug, tuning, etc. See bolt::cl::control.
+        * \param first The first position in the sequence to be sorted.
+        * \param last  The last position in the sequence to be sorted.
+        * \param offsets_first The offset of the first segment.
+        * \param offsets_last  The end of the offsets.
+        * \param cl_code Optional OpenCL(TM) code to be passed to the OpenCL compiler. The cl_code is inserted first in
+        * the generated code, before the cl_code traits. This can be used for any extra cl code that is to be passed
+        * when compiling the OpenCl Kernel.
+        * \return The segments are sorted in place.
+        *
+        *  \tparam RandomAccessIterator Is a model of http://www.sgi.com/tech/stl/RandomAccessIterator.html
+        *  \tparam OffsetIterator Is a model of http://www.sgi.com/tech/stl/RandomAccessIterator.html over an integral
+        *  type; a device_vector iterator is mapped to the host once.
+        *
+        * \details The following code example sorts three lists held in one array.
+        * \code
+        * #include <bolt/cl/segmented_sort.h>
+        *
+        * int a[10] = {5, 2, 9, 7, 1, 3, 8, 6, 0, 4};
+        * int offsets[3] = {0, 3, 4};
+        *
+        * bolt::cl::segmented_sort(a, a+10, offsets, offsets+3);
+        *
+        * // a => {2, 5, 9, 7, 0, 1, 3, 4, 6, 8}
+        *  \endcode
+        */
+        template<typename RandomAccessIterator, typename OffsetIterator>
+        void segmented_sort(bolt::cl::control &ctl,
+            RandomAccessIterator first,
+            RandomAccessIterator last,
+            OffsetIterator offsets_first,
+            OffsetIterator offsets_last,
+            const std::string& cl_code="");
+
+        template<typename RandomAccessIterator, typename OffsetIterator>
+        void segmented_sort(RandomAccessIterator first,
+            RandomAccessIterator last,
+            OffsetIterator offsets_first,
+            OffsetIterator offsets_last,
+            const std::string& cl_code="");
+
+        /*! \brief \p segmented_sort sorts each segment of [first, last) independently, using \p comp to compare
+        * elements.
+        *
+        * \param ctl \b Optional Control structure to control command-queue, debug, tuning, etc. See bolt::cl::control.
+        * \param first The first position in the sequence to be sorted.
+        * \param last  The last position in the sequence to be sorted.
+        * \param offsets_first The offset of the first segment.
+        * \param offsets_last  The end of the offsets.
+        * \param comp  The comparison operation used to compare two values.
+        * \param cl_code Optional OpenCL(TM) code to be passed to the OpenCL compiler. The cl_code is inserted first in
+        * the generated code, before the cl_code traits. This can be used for any extra cl code that is to be passed
+        * when compiling the OpenCl Kernel.
+        * \return The segments are sorted in place.
+        *
+        *  \tparam RandomAccessIterator Is a model of http://www.sgi.com/tech/stl/RandomAccessIterator.html
+        *  \tparam OffsetIterator Is a model of http://www.sgi.com/tech/stl/RandomAccessIterator.html
+        *  \tparam StrictWeakOrdering Is a model of http://www.sgi.com/tech/stl/StrictWeakOrdering.html.
+        *
+        * \details The following code example sorts three lists held in one array in descending order.
+        * \code
+        * #include <bolt/cl/segmented_sort.h>
+        *
+        * int a[10] = {5, 2, 9, 7, 1, 3, 8, 6, 0, 4};
+        * int offsets[3] = {0, 3, 4};
+        *
+        * bolt::cl::segmented_sort(a, a+10, offsets, offsets+3, bolt::cl::greater<int>());
+        *
+        * // a => {9, 5, 2, 7, 8, 6, 4, 3, 1, 0}
+        *  \endcode
+        */
+        template<typename RandomAccessIterator, typename OffsetIterator, typename StrictWeakOrdering>
+        void segmented_sort(bolt::cl::control &ctl,
+            RandomAccessIterator first,
+            RandomAccessIterator last,
+            OffsetIterator offsets_first,
+            OffsetIterator offsets_last,
+            StrictWeakOrdering comp,
+            const std::string& cl_code="");
+
+        template<typename RandomAccessIterator, typename OffsetIterator, typename StrictWeakOrdering>
+        void segmented_sort(RandomAccessIterator first,
+            RandomAccessIterator last,
+            OffsetIterator offsets_first,
+            OffsetIterator offsets_last,
+            StrictWeakOrdering comp,
+            const std::string& cl_code="");
+
+        /*! \brief \p segmented_sort_by_key sorts the keys of each segment independently, and moves every value
+        * with its key.
+        *
+        * The segments are given by offsets exactly as for \p segmented_sort.  The order of equal keys is not
+        * preserved.
+        *
+        * \param ctl \b Optional Control structure to control command-queue, debug, tuning, etc. See bolt::cl::control.
+        * \param keys_first The first position in the key sequence to be sorted.
+        * \param keys_last  The last position in the key sequence to be sorted.
+        * \param values_first  The first position in the value sequence.
+        * \param offsets_first The offset of the first segment.
+        * \param offsets_last  The end of the offsets.
+        * \param cl_code Optional OpenCL(TM) code to be passed to the OpenCL compiler. The cl_code is inserted first in
+        * the generated code, before the cl_code traits. This can be used for any extra cl code that is to be passed
+        * when compiling the OpenCl Kernel.
+        * \return The segments of keys and values are sorted in place.
+        *
+        *  \tparam RandomAccessIterator1 Is a model of http://www.sgi.com/tech/stl/RandomAccessIterator.html
+        *  \tparam RandomAccessIterator2 Is a model of http://www.sgi.com/tech/stl/RandomAccessIterator.html
+        *  \tparam OffsetIterator Is a model of http://www.sgi.com/tech/stl/RandomAccessIterator.html
+        *
+        * \details The following code example sorts two lists of keys, with their values.
+        * \code
+        * #include <bolt/cl/segmented_sort.h>
+        *
+        * int keys[6] = {3, 1, 2, 9, 7, 8};
+        * int values[6] = {30, 10, 20, 90, 70, 80};
+        * int offsets[2] = {0, 3};
+        *
+        * bolt::cl::segmented_sort_by_key(keys, keys+6, values, offsets, offsets+2);
+        *
+        * // keys => {1, 2, 3, 7, 8, 9}
+        * // values => {10, 20, 30, 70, 80, 90}
+        *  \endcode
+        */
+        template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OffsetIterator>
+        void segmented_sort_by_key(const bolt::cl::control &ctl,
+            RandomAccessIterator1 keys_first,
+            RandomAccessIterator1 keys_last,
+            RandomAccessIterator2 values_first,
+            OffsetIterator offsets_first,
+            OffsetIterator offsets_last,
+            const std::string& cl_code="");
+
+        template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OffsetIterator>
+        void segmented_sort_by_key(RandomAccessIterator1 keys_first,
+            RandomAccessIterator1 keys_last,
+            RandomAccessIterator2 values_first,
+            OffsetIterator offsets_first,
+            OffsetIterator offsets_last,
+            const std::string& cl_code="");
+
+        /*! \brief \p segmented_sort_by_key sorts the keys of each segment independently using \p comp, and moves
+        * every value with its key.
+        *
+        * \param ctl \b Optional Control structure to control command-queue, debug, tuning, etc. See bolt::cl::control.
+        * \param keys_first The first position in the key sequence to be sorted.
+        * \param keys_last  The last position in the key sequence to be sorted.
+        * \param values_first  The first position in the value sequence.
+        * \param offsets_first The offset of the first segment.
+        * \param offsets_last  The end of the offsets.
+        * \param comp  The comparison operation used to compare two keys.
+        * \param cl_code Optional OpenCL(TM) code to be passed to the OpenCL compiler. The cl_code is inserted first in
+        * the generated code, before the cl_code traits. This can be used for any extra cl code that is to be passed
+        * when compiling the OpenCl Kernel.
+        * \return The segments of keys and values are sorted in place.
+        *
+        *  \tparam RandomAccessIterator1 Is a model of http://www.sgi.com/tech/stl/RandomAccessIterator.html
+        *  \tparam RandomAccessIterator2 Is a model of http://www.sgi.com/tech/stl/RandomAccessIterator.html
+        *  \tparam OffsetIterator Is a model of http://www.sgi.com/tech/stl/RandomAccessIterator.html
+        *  \tparam StrictWeakOrdering Is a model of http://www.sgi.com/tech/stl/StrictWeakOrdering.html.
+        */
+        template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OffsetIterator,
+                 typename StrictWeakOrdering>
+        void segmented_sort_by_key(const bolt::cl::control &ctl,
+            RandomAccessIterator1 keys_first,
+            RandomAccessIterator1 keys_last,
+            RandomAccessIterator2 values_first,
+            OffsetIterator offsets_first,
+            OffsetIterator offsets_last,
+            StrictWeakOrdering comp,
+            const std::string& cl_code="");
+
+        template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OffsetIterator,
+                 typename StrictWeakOrdering>
+        void segmented_sort_by_key(RandomAccessIterator1 keys_first,
+            RandomAccessIterator1 keys_last,
+            RandomAccessIterator2 values_first,
+            OffsetIterator offsets_first,
+            OffsetIterator offsets_last,
+            StrictWeakOrdering comp,
+            const std::string& cl_code="");
+
+        /*!   \}  */
+
+    }// end of bolt::cl namespace
+}// end of bolt namespace
+
+#include <bolt/cl/detail/segmented_sort.inl>
+#endif
@@ -0,0 +1,173 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+// #pragma OPENCL EXTENSION cl_amd_printf : enable
+
+/* Sorts many short segments in one launch.  The host packs consecutive whole segments into tiles of at most
+ * 2 * local size elements; tiles[ 2 * group ] and tiles[ 2 * group + 1 ] are the first and the end segment of the
+ * work group's tile, and offsets[ s ] is where segment s starts.  The tile is loaded into local memory with the
+ * segment of every element next to it, and a bitonic network sorts it by segment first and key second.  The
+ * segments of a tile are already in ascending order, so every element stays inside its own segment.
+ */
+
+//  The compare-exchange pair of threadId in pass passOfStage of stage; the first pass of a stage compares mirrored
+//  positions, so the positions past the end of the tile act as elements greater than any other and are skipped
+inline void segmentedSortPair( uint threadId, uint stage, uint passOfStage, uint* leftId, uint* rightId )
+{
+    uint pairDistance = 1 << (stage - passOfStage);
+    uint blockWidth   = 2 * pairDistance;
+    uint offset = threadId & (pairDistance - 1);
+    *leftId = offset + (threadId >> (stage - passOfStage) ) * blockWidth;
+    *rightId = (passOfStage == 0) ? *leftId + blockWidth - 1 - 2 * offset : *leftId + pairDistance;
+}
+
+//  The segment in [segFirst, segLast) that holds element index; empty segments are passed over
+inline uint segmentedSortSegmentOf( global uint* offsets, uint segFirst, uint segLast, uint index )
+{
+    uint low = segFirst + 1;
+    uint high = segLast;
+    while( low < high )
+    {
+        uint mid = ( low + high ) / 2;
+        if( offsets[ mid ] <= index )
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low - 1;
+}
+
+template <typename kPtrType, typename kIterType, typename Compare>
+kernel
+void segmentedSortTemplate(
+                    global kPtrType *keys_ptr,
+                    kIterType       keys_iter,
+                    global uint *offsets,
+                    global uint *tiles,
+                    global Compare *userComp,
+                    local kPtrType *tileKeys,
+                    local uint *tileSegments)
+{
+    uint localId = get_local_id(0);
+    uint tileSize = 2 * get_local_size(0);
+    uint segFirst = tiles[ 2 * get_group_id(0) ];
+    uint segLast = tiles[ 2 * get_group_id(0) + 1 ];
+    uint tileStart = offsets[ segFirst ];
+    uint tileLength = offsets[ segLast ] - tileStart;
+
+    keys_iter.init( keys_ptr );
+
+    for(uint index = localId; index < tileLength; index += get_local_size(0))
+    {
+        tileKeys[index] = keys_iter[tileStart + index];
+        tileSegments[index] = segmentedSortSegmentOf( offsets, segFirst, segLast, tileStart + index );
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for(uint stage = 0; (2u << stage) <= tileSize; ++stage)
+    {
+        for(uint pass = 0; pass <= stage; ++pass)
+        {
+            uint leftId, rightId;
+            segmentedSortPair(localId, stage, pass, &leftId, &rightId);
+            if(rightId < tileLength)
+            {
+                uint leftSegment = tileSegments[leftId];
+                uint rightSegment = tileSegments[rightId];
+                kPtrType leftKey = tileKeys[leftId];
+                kPtrType rightKey = tileKeys[rightId];
+                if( rightSegment < leftSegment || ( rightSegment == leftSegment && (*userComp)(rightKey, leftKey) ) )
+                {
+                    tileKeys[leftId] = rightKey;
+                    tileKeys[rightId] = leftKey;
+                    tileSegments[leftId] = rightSegment;
+                    tileSegments[rightId] = leftSegment;
+                }
+            }
+            barrier(CLK_LOCAL_MEM_FENCE);
+        }
+    }
+
+    for(uint index = localId; index < tileLength; index += get_local_size(0))
+        keys_iter[tileStart + index] = tileKeys[index];
+}
+
+template <typename kPtrType, typename kIterType, typename vPtrType, typename vIterType, typename Compare>
+kernel
+void segmentedSortByKeyTemplate(
+                    global kPtrType *keys_ptr,
+                    kIterType       keys_iter,
+                    global vPtrType *values_ptr,
+                    vIterType       values_iter,
+                    global uint *offsets,
+                    global uint *tiles,
+                    global Compare *userComp,
+                    local kPtrType *tileKeys,
+                    local vPtrType *tileValues,
+                    local uint *tileSegments)
+{
+    uint localId = get_local_id(0);
+    uint tileSize = 2 * get_local_size(0);
+    uint segFirst = tiles[ 2 * get_group_id(0) ];
+    uint segLast = tiles[ 2 * get_group_id(0) + 1 ];
+    uint tileStart = offsets[ segFirst ];
+    uint tileLength = offsets[ segLast ] - tileStart;
+
+    keys_iter.init( keys_ptr );
+    values_iter.init( values_ptr );
+
+    for(uint index = localId; index < tileLength; index += get_local_size(0))
+    {
+        tileKeys[index] = keys_iter[tileStart + index];
+        tileValues[index] = values_iter[tileStart + index];
+        tileSegments[index] = segmentedSortSegmentOf( offsets, segFirst, segLast, tileStart + index );
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for(uint stage = 0; (2u << stage) <= tileSize; ++stage)
+    {
+        for(uint pass = 0; pass <= stage; ++pass)
+        {
+            uint leftId, rightId;
+            segmentedSortPair(localId, stage, pass, &leftId, &rightId);
+            if(rightId < tileLength)
+            {
+                uint leftSegment = tileSegments[leftId];
+                uint rightSegment = tileSegments[rightId];
+                kPtrType leftKey = tileKeys[leftId];
+                kPtrType rightKey = tileKeys[rightId];
+                if( rightSegment < leftSegment || ( rightSegment == leftSegment && (*userComp)(rightKey, leftKey) ) )
+                {
+                    vPtrType leftValue = tileValues[leftId];
+                    tileKeys[leftId] = rightKey;
+                    tileKeys[rightId] = leftKey;
+                    tileValues[leftId] = tileValues[rightId];
+                    tileValues[rightId] = leftValue;
+                    tileSegments[leftId] = rightSegment;
+                    tileSegments[rightId] = leftSegment;
+                }
+            }
+            barrier(CLK_LOCAL_MEM_FENCE);
+        }
+    }
+
+    for(uint index = localId; index < tileLength; index += get_local_size(0))
+    {
+        keys_iter[tileStart + index] = tileKeys[index];
+        values_iter[tileStart + index] = tileValues[index];
+    }
+}
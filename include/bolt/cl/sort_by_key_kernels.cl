@@ -29,6 +29,19 @@
     // bool operator()(const T &lhs, const T &rhs) const  {return (lhs < rhs);}
 // };
 
+/* Bitonic merge network over the next power of 2 of length, as in sort_kernels.cl: every stage merges ascending, so
+ * positions at or past length act as keys greater than any other and are never loaded or stored.
+ */
+inline void bitonicSortByKeyPair(uint threadId, uint stage, uint passOfStage, uint* leftId, uint* rightId)
+{
+    uint pairDistance = 1 << (stage - passOfStage);
+    uint blockWidth   = 2 * pairDistance;
+    uint offset = threadId & (pairDistance - 1);
+    *leftId = offset + (threadId >> (stage - passOfStage) ) * blockWidth;
+    *rightId = (passOfStage == 0) ? *leftId + blockWidth - 1 - 2 * offset : *leftId + pairDistance;
+}
+
+//  One pass of the network, for the passes whose pairs are too far apart to fit in a work group's tile
 template<typename iKeysType, typename iKeysIter, typename iValType, typename iValIter, typename Compare >
 kernel
 void BitonicSortByKeyTemplate(
@@ -38,48 +51,93 @@ void BitonicSortByKeyTemplate(
         iValIter         values_iter, 
         const uint stage,
         const uint passOfStage,
+        const uint length,
         global Compare* userComp)
 {
-    uint threadId = get_global_id(0);
-    uint pairDistance = 1 << (stage - passOfStage);
-    uint blockWidth   = 2 * pairDistance;
-    uint temp;
-    uint leftId = (threadId % pairDistance) 
-                       + (threadId / pairDistance) * blockWidth;
-    bool compareResult;
-    uint rightId = leftId + pairDistance;
-    
+    uint leftId, rightId;
+    bitonicSortByKeyPair(get_global_id(0), stage, passOfStage, &leftId, &rightId);
+
+    if(rightId >= length)
+        return;
+
     keys_iter.init( keys_ptr );
     values_iter.init( values_ptr );
-    
+
     iKeysType leftElement = keys_iter[leftId];
     iKeysType rightElement = keys_iter[rightId];
-    iValType leftValue = values_iter[leftId];
-    iValType rightValue = values_iter[rightId];
 
-    uint sameDirectionBlockWidth = 1 << stage;
-    
-    if((threadId/sameDirectionBlockWidth) % 2 == 1)
+    if((*userComp)(rightElement, leftElement))
     {
-        temp = rightId;
-        rightId = leftId;
-        leftId = temp;
+        iValType leftValue = values_iter[leftId];
+        iValType rightValue = values_iter[rightId];
+        keys_iter[leftId]  = rightElement;
+        keys_iter[rightId] = leftElement;
+        values_iter[leftId]  = rightValue;
+        values_iter[rightId] = leftValue;
     }
+}
 
-    compareResult = (*userComp)(leftElement, rightElement);
+/* Every pass from (stage, passOfStage) up to the end of lastStage, in local memory.  A work group of W items owns
+ * the keys and values of the tile of 2W elements starting at 2W * group.
+ */
+template<typename iKeysType, typename iKeysIter, typename iValType, typename iValIter, typename Compare >
+kernel
+void BitonicSortByKeyLocalTemplate(
+        global iKeysType* keys_ptr, 
+        iKeysIter        keys_iter, 
+        global iValType* values_ptr, 
+        iValIter         values_iter, 
+        const uint stage,
+        const uint passOfStage,
+        const uint lastStage,
+        const uint length,
+        global Compare* userComp,
+        local iKeysType* tileKeys,
+        local iValType* tileValues)
+{
+    uint localId = get_local_id(0);
+    uint tileSize = 2 * get_local_size(0);
+    uint tileStart = get_group_id(0) * tileSize;
+    uint tileLength = (length > tileStart) ? min(tileSize, length - tileStart) : 0;
+
+    keys_iter.init( keys_ptr );
+    values_iter.init( values_ptr );
 
-    if(compareResult)
+    for(uint index = localId; index < tileLength; index += get_local_size(0))
     {
-        keys_iter[rightId] = rightElement;
-        keys_iter[leftId]  = leftElement;
-        values_iter[rightId] = rightValue;
-        values_iter[leftId]  = leftValue;
+        tileKeys[index] = keys_iter[tileStart + index];
+        tileValues[index] = values_iter[tileStart + index];
     }
-    else
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    uint pass = passOfStage;
+    for(uint s = stage; s <= lastStage; ++s)
     {
-        keys_iter[rightId] = leftElement;
-        keys_iter[leftId]  = rightElement;
-        values_iter[rightId] = leftValue;
-        values_iter[leftId]  = rightValue;
+        for(; pass <= s; ++pass)
+        {
+            uint leftId, rightId;
+            bitonicSortByKeyPair(localId, s, pass, &leftId, &rightId);
+            if(rightId < tileLength)
+            {
+                iKeysType leftElement = tileKeys[leftId];
+                iKeysType rightElement = tileKeys[rightId];
+                if((*userComp)(rightElement, leftElement))
+                {
+                    iValType leftValue = tileValues[leftId];
+                    tileKeys[leftId]  = rightElement;
+                    tileKeys[rightId] = leftElement;
+                    tileValues[leftId]  = tileValues[rightId];
+                    tileValues[rightId] = leftValue;
+                }
+            }
+            barrier(CLK_LOCAL_MEM_FENCE);
+        }
+        pass = 0;
+    }
+
+    for(uint index = localId; index < tileLength; index += get_local_size(0))
+    {
+        keys_iter[tileStart + index] = tileKeys[index];
+        values_iter[tileStart + index] = tileValues[index];
     }
 }
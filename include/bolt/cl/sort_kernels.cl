@@ -18,116 +18,23 @@
 // #pragma OPENCL EXTENSION cl_amd_printf : enable
 // #pragma OPENCL EXTENSION cl_khr_fp64 : enable 
 
-template <typename T, typename Compare>
-kernel
-void selectionSortLocalTemplate(global const T * in, 
-                           global T       * out, 
-                           global Compare * userComp, 
-                           local  T       * scratch, 
-                           const int        buffSize)
-{
-  int          i  = get_local_id(0); // index in workgroup
-  int numOfGroups = get_num_groups(0); // index in workgroup
-  int groupID     = get_group_id(0);
-  int         wg  = get_local_size(0); // workgroup size = block size
-  int n;
-  
-  int offset = groupID * wg;
-  int same=0;
-  in  += offset; 
-  out += offset;
-  n = (groupID == (numOfGroups-1))? (buffSize - wg*(numOfGroups-1)) : wg;
-  T iData, jData;
-  if(i < n)
-  {
-      iData = in[i];
-      scratch[i] = iData;
-      barrier(CLK_LOCAL_MEM_FENCE);
-  
-      int pos = 0;
-      for (int j=0;j<n;j++)
-      {
-          jData = scratch[j];
-          if((*userComp)(jData, iData)) 
-              pos++;
-          else 
-          {
-              if((*userComp)(iData, jData))
-                  continue;
-              else 
-              {
-                  // iData and jData are same
-                  same++;
-              }
-          }
-      }
-      for (int j=0; j< same; j++)      
-         out[pos + j] = iData;
-  }
-  return;
-}
-
-template <typename T, typename Compare>
-kernel
-void selectionSortFinalTemplate(global const T * in, 
-                           global T       * out, 
-                           global Compare * userComp,
-                           local  T       * scratch, 
-                           const int        buffSize)
+/* Bitonic merge network over the next power of 2 of length.  Every stage merges ascending: the first pass of
+ * a stage compares mirrored positions of its block, the later passes are plain half-cleaners.  With every block
+ * ascending, the positions at or past length can be treated as elements greater than anything else; any pair
+ * that reaches one of them is already in order and the thread does nothing, so odd lengths cost no more than
+ * the padded power of 2 and never touch memory outside the range.
+ */
+//  The compare-exchange pair of thread threadId in pass passOfStage of stage; rightId is always past leftId
+inline void bitonicSortPair(uint threadId, uint stage, uint passOfStage, uint* leftId, uint* rightId)
 {
-  int          i  = get_local_id(0); // index in workgroup
-  int numOfGroups = get_num_groups(0); // index in workgroup
-  int groupID     = get_group_id(0);
-  int         wg  = get_local_size(0); // workgroup size = block size
-  int pos = 0, same = 0;
-  int remainder;
-  int offset = get_group_id(0) * wg;
-  T iData, jData;
-  iData = in[groupID*wg + i];
-  if((offset + i ) >= buffSize)
-      return;
-  
-  remainder = buffSize - wg*(numOfGroups-1);
-  
-  for(int j=0; j<numOfGroups-1; j++ )
-  {
-     for(int k=0; k<wg; k++)
-     {
-        jData = in[j*wg + k];
-        if(((*userComp)(iData, jData)))
-           break;
-        else
-        {
-           //Increment only if the value is not the same. 
-           //Two elements are same if (*userComp)(jData, iData)  and (*userComp)(iData, jData) are both false
-           if( ((*userComp)(jData, iData)) )
-              pos++;
-           else 
-              same++;
-        }
-     }
-  }
-  
-  for(int k=0; k<remainder; k++)
-  {
-     jData = in[(numOfGroups-1)*wg + k];
-        if(((*userComp)(iData, jData)))
-           break;
-        else
-        {
-           //Don't increment if the value is the same. 
-           //Two elements are same if (*userComp)(jData, iData)  and (*userComp)(iData, jData) are both false
-           if(((*userComp)(jData, iData)))
-              pos++;
-           else 
-              same++;
-        }
-  }  
-  for (int j=0; j< same; j++)      
-      out[pos + j] = iData;  
+    uint pairDistance = 1 << (stage - passOfStage);
+    uint blockWidth   = 2 * pairDistance;
+    uint offset = threadId & (pairDistance - 1);
+    *leftId = offset + (threadId >> (stage - passOfStage) ) * blockWidth;
+    *rightId = (passOfStage == 0) ? *leftId + blockWidth - 1 - 2 * offset : *leftId + pairDistance;
 }
 
-
+//  One pass of the network, for the passes whose pairs are too far apart to fit in a work group's tile
 template <typename iPtrType, typename iIterType, typename Compare>
 kernel
 void BitonicSortTemplate(
@@ -135,39 +42,77 @@ void BitonicSortTemplate(
                     iIterType       input_iter,
                  const uint stage,
                  const uint passOfStage,
+                 const uint length,
                  global Compare *userComp)
 {
-    uint threadId = get_global_id(0);
-    uint pairDistance = 1 << (stage - passOfStage);
-    uint blockWidth   = 2 * pairDistance;
-    uint temp;
-    uint leftId = (threadId & (pairDistance -1)) 
-                       + (threadId >> (stage - passOfStage) ) * blockWidth;
-    bool compareResult;
+    uint leftId, rightId;
+    bitonicSortPair(get_global_id(0), stage, passOfStage, &leftId, &rightId);
+
+    if(rightId >= length)
+        return;
+
     input_iter.init( input_ptr );
-    
-    uint rightId = leftId + pairDistance;
-    
-    iPtrType greater, lesser;
-	iPtrType leftElement, rightElement;
+
+    iPtrType leftElement, rightElement;
     leftElement = input_iter[leftId];
     rightElement = input_iter[rightId];
-    
-    uint sameDirectionBlockWidth = threadId >> stage;
-    uint sameDirection = sameDirectionBlockWidth & 0x1;
-    
-    temp    = sameDirection?rightId:temp;
-    rightId = sameDirection?leftId:rightId;
-    leftId  = sameDirection?temp:leftId;
 
-    compareResult = (*userComp)(leftElement, rightElement);
+    if((*userComp)(rightElement, leftElement))
+    {
+        input_iter[leftId]  = rightElement;
+        input_iter[rightId] = leftElement;
+    }
+}
 
-    greater = compareResult?rightElement:leftElement;
-    lesser  = compareResult?leftElement:rightElement;
+/* Every pass from (stage, passOfStage) up to the end of lastStage, in local memory.  A work group of W items owns
+ * the tile of 2W elements starting at 2W * group, which holds every pair of a pass whose pairs are at most W apart,
+ * so the host runs each stage's last passes, and all of the first stages, in one launch each.
+ */
+template <typename iPtrType, typename iIterType, typename Compare>
+kernel
+void BitonicSortLocalTemplate(
+                    global iPtrType *input_ptr,
+                    iIterType       input_iter,
+                 const uint stage,
+                 const uint passOfStage,
+                 const uint lastStage,
+                 const uint length,
+                 global Compare *userComp,
+                 local iPtrType *tile)
+{
+    uint localId = get_local_id(0);
+    uint tileSize = 2 * get_local_size(0);
+    uint tileStart = get_group_id(0) * tileSize;
+    uint tileLength = (length > tileStart) ? min(tileSize, length - tileStart) : 0;
 
-    input_iter[leftId]  = lesser;
-    input_iter[rightId] = greater;
+    input_iter.init( input_ptr );
 
-}
+    for(uint index = localId; index < tileLength; index += get_local_size(0))
+        tile[index] = input_iter[tileStart + index];
+    barrier(CLK_LOCAL_MEM_FENCE);
 
+    uint pass = passOfStage;
+    for(uint s = stage; s <= lastStage; ++s)
+    {
+        for(; pass <= s; ++pass)
+        {
+            uint leftId, rightId;
+            bitonicSortPair(localId, s, pass, &leftId, &rightId);
+            if(rightId < tileLength)
+            {
+                iPtrType leftElement = tile[leftId];
+                iPtrType rightElement = tile[rightId];
+                if((*userComp)(rightElement, leftElement))
+                {
+                    tile[leftId]  = rightElement;
+                    tile[rightId] = leftElement;
+                }
+            }
+            barrier(CLK_LOCAL_MEM_FENCE);
+        }
+        pass = 0;
+    }
 
+    for(uint index = localId; index < tileLength; index += get_local_size(0))
+        input_iter[tileStart + index] = tile[index];
+}
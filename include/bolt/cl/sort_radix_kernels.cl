@@ -0,0 +1,446 @@
+/***************************************************************************                                                                                     
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.                                     
+*                                                                                    
+*   Licensed under the Apache License, Version 2.0 (the "License");   
+*   you may not use this file except in compliance with the License.                 
+*   You may obtain a copy of the License at                                          
+*                                                                                    
+*       http://www.apache.org/licenses/LICENSE-2.0                      
+*                                                                                    
+*   Unless required by applicable law or agreed to in writing, software              
+*   distributed under the License is distributed on an "AS IS" BASIS,              
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.         
+*   See the License for the specific language governing permissions and              
+*   limitations under the License.                                                   
+
+***************************************************************************/          
+
+/* LSD radix sort for keys of 8, 16, 32 and 64 bits, one 8-bit digit per pass.  The kernels read the raw bits of
+ * the key as the unsigned type K of the same width, and map them to an unsigned value with the same order as the
+ * key before taking a digit, so the keys themselves are moved unchanged and no encode or decode pass is needed.
+ *
+ * A pass is three kernels over a fixed number of work groups, each owning a contiguous run of tiles:
+ *   upsweep   - every group counts the digits of its run in local memory
+ *   spine     - one group scans the counts into the first output position of every digit of every group
+ *   downsweep - every group sorts each tile by digit in local memory, then writes runs of equal digits to
+ *               consecutive addresses
+ */
+#pragma OPENCL EXTENSION cl_khr_byte_addressable_store : enable
+
+//  Kinds of key, these match radixKeyKind on the host
+#define RADIX_KEY_UNSIGNED 0
+#define RADIX_KEY_SIGNED   1
+#define RADIX_KEY_FLOATING 2
+
+//  These match RADIX_SORT_BITS and RADIX_SORT_WGSIZE on the host; a work group has a work item per digit value
+#define RADIX_KEY_BITS     8
+#define RADIX_KEY_RADICES  (1 << RADIX_KEY_BITS)
+#define RADIX_KEY_MASK     (RADIX_KEY_RADICES - 1)
+#define RADIX_KEY_WGSIZE   RADIX_KEY_RADICES
+
+/* Signed integers flip the sign bit; IEEE floating point flips every bit of a negative value and only the sign bit
+ * of a positive one.  A descending sort inverts the whole key.
+ */
+template <typename K>
+inline K radixKeyOrdered(K bits, uint keyKind, uint descending)
+{
+    const K signBit = ((K)1) << (sizeof(K) * 8 - 1);
+
+    if(keyKind == RADIX_KEY_FLOATING)
+        bits = (bits & signBit) ? (K)(~bits) : (K)(bits | signBit);
+    else if(keyKind == RADIX_KEY_SIGNED)
+        bits = (K)(bits ^ signBit);
+
+    if(descending)
+        bits = (K)(~bits);
+
+    return bits;
+}
+
+template <typename K>
+inline uint radixKeyDigit(K bits, uint keyKind, uint descending, uint shiftCount)
+{
+    return (uint)(radixKeyOrdered(bits, keyKind, descending) >> shiftCount) & RADIX_KEY_MASK;
+}
+
+/* Ors together the bits in which every key differs from the first one.  A digit that is zero in the result is the
+ * same for every key, and the host skips its pass.  The result is two uints, low word first, and must be zero on
+ * entry.
+ */
+template <typename K>
+kernel
+void radixKeyDifferenceTemplate(global const K* keys,
+               global uint* differentBits,
+               uint keyKind,
+               uint descending,
+               uint length)
+{
+    local uint localBits[2];
+    K firstKey = radixKeyOrdered(keys[0], keyKind, descending);
+    K difference = 0;
+
+    if(get_local_id(0) < 2)
+        localBits[get_local_id(0)] = 0;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for(uint index = get_global_id(0); index < length; index += get_global_size(0))
+        difference |= radixKeyOrdered(keys[index], keyKind, descending) ^ firstKey;
+
+    if(difference)
+    {
+        atomic_or(&localBits[0], (uint)difference);
+        atomic_or(&localBits[1], (uint)(((ulong)difference) >> 32));
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if(get_local_id(0) == 0)
+    {
+        atomic_or(&differentBits[0], localBits[0]);
+        atomic_or(&differentBits[1], localBits[1]);
+    }
+}
+
+//  Each group counts the digits of keys [group * elementsPerGroup, (group + 1) * elementsPerGroup)
+template <typename K>
+kernel
+void radixKeyUpsweepTemplate(global const K* unsortedData,
+               global uint* counts,
+               uint shiftCount,
+               uint keyKind,
+               uint descending,
+               uint length,
+               uint elementsPerGroup)
+{
+    local uint histogram[RADIX_KEY_RADICES];
+    uint localId = get_local_id(0);
+    uint groupId = get_group_id(0);
+
+    histogram[localId] = 0;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    uint begin = groupId * elementsPerGroup;
+    uint end   = min(begin + elementsPerGroup, length);
+    for(uint index = begin + localId; index < end; index += RADIX_KEY_WGSIZE)
+        atomic_inc(&histogram[radixKeyDigit(unsortedData[index], keyKind, descending, shiftCount)]);
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    counts[groupId * RADIX_KEY_RADICES + localId] = histogram[localId];
+}
+
+/* Run by a single work group, with a work item per digit.  Replaces the count of every (group, digit) with the
+ * number of keys of that digit in the earlier groups, and writes the first output position of every digit to the
+ * row after the last group.  Templated only so that it is instantiated along with the other kernels.
+ */
+template <typename K>
+kernel
+void radixKeySpineTemplate(global uint* counts,
+               uint numGroups)
+{
+    local uint digitTotals[RADIX_KEY_RADICES];
+    uint digit = get_local_id(0);
+
+    uint running = 0;
+    for(uint group = 0; group < numGroups; ++group)
+    {
+        uint count = counts[group * RADIX_KEY_RADICES + digit];
+        counts[group * RADIX_KEY_RADICES + digit] = running;
+        running += count;
+    }
+    digitTotals[digit] = running;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for(uint offset = 1; offset < RADIX_KEY_RADICES; offset <<= 1)
+    {
+        uint addend = (digit >= offset) ? digitTotals[digit - offset] : 0;
+        barrier(CLK_LOCAL_MEM_FENCE);
+        digitTotals[digit] += addend;
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    counts[numGroups * RADIX_KEY_RADICES + digit] = digitTotals[digit] - running;
+}
+
+/* Exclusive scan of one value per work item of the group; buffer holds RADIX_KEY_WGSIZE uints.  Returns the sum of
+ * the values of the lower work items, and the sum over the group in total.
+ */
+inline uint radixKeyTileScan(uint value, local uint* buffer, uint localId, uint* total)
+{
+    buffer[localId] = value;
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for(uint offset = 1; offset < RADIX_KEY_WGSIZE; offset <<= 1)
+    {
+        uint addend = (localId >= offset) ? buffer[localId - offset] : 0;
+        barrier(CLK_LOCAL_MEM_FENCE);
+        buffer[localId] += addend;
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+    *total = buffer[RADIX_KEY_WGSIZE - 1];
+    uint inclusive = buffer[localId];
+    barrier(CLK_LOCAL_MEM_FENCE);
+    return inclusive - value;
+}
+
+/* Each group walks its run one tile at a time.  A tile is stably sorted by digit in local memory two bits per round:
+ * the counts of 2-bit values 0, 1 and 2 are packed in 10-bit fields of one uint, so a single scan ranks all four.
+ * After the local sort, work items holding the same digit are adjacent and write to consecutive addresses.
+ * Positions past the end of the input get the largest digit; being last in the tile, the stable sort keeps them
+ * after every real key.
+ *
+ * A sort by key also moves the original position of every key along with it, so that the values can be gathered
+ * once after the last pass.  indexMode is RADIX_INDEX_NONE for a sort of keys alone, RADIX_INDEX_IDENTITY for the
+ * first pass of a sort by key, and RADIX_INDEX_READ for the passes after it.
+ */
+#define RADIX_INDEX_NONE     0
+#define RADIX_INDEX_IDENTITY 1
+#define RADIX_INDEX_READ     2
+
+template <typename K>
+inline void radixKeyDownsweep(global const K* unsortedData,
+               global const uint* unsortedIndices,
+               global const uint* counts,
+               uint shiftCount,
+               uint keyKind,
+               uint descending,
+               uint length,
+               uint elementsPerGroup,
+               uint numGroups,
+               uint indexMode,
+               global K* sortedData,
+               global uint* sortedIndices,
+               local K* tileKeys,
+               local uint* tileDigits,
+               local uint* tileIndices,
+               local uint* scanBuffer,
+               local uint* digitCursor,
+               local uint* runStart)
+{
+    uint localId = get_local_id(0);
+    uint groupId = get_group_id(0);
+
+    digitCursor[localId] = counts[groupId * RADIX_KEY_RADICES + localId]
+                         + counts[numGroups * RADIX_KEY_RADICES + localId];
+
+    uint begin = groupId * elementsPerGroup;
+    uint end   = min(begin + elementsPerGroup, length);
+    for(uint tile = begin; tile < end; tile += RADIX_KEY_WGSIZE)
+    {
+        uint validCount = min((uint)RADIX_KEY_WGSIZE, end - tile);
+        K key = 0;
+        uint digit = RADIX_KEY_MASK;
+        uint index = 0;
+        if(localId < validCount)
+        {
+            key = unsortedData[tile + localId];
+            digit = radixKeyDigit(key, keyKind, descending, shiftCount);
+            if(indexMode == RADIX_INDEX_IDENTITY)
+                index = tile + localId;
+            else if(indexMode == RADIX_INDEX_READ)
+                index = unsortedIndices[tile + localId];
+        }
+
+        for(uint bit = 0; bit < RADIX_KEY_BITS; bit += 2)
+        {
+            uint value = (digit >> bit) & 0x3;
+            uint packed = (value < 3) ? (1u << (10 * value)) : 0;
+            uint packedTotal;
+            uint packedBefore = radixKeyTileScan(packed, scanBuffer, localId, &packedTotal);
+
+            uint before0 = packedBefore & 0x3FF, before1 = (packedBefore >> 10) & 0x3FF, before2 = packedBefore >> 20;
+            uint total0  = packedTotal  & 0x3FF, total1  = (packedTotal  >> 10) & 0x3FF, total2  = packedTotal  >> 20;
+            uint position;
+            if(value == 0)
+                position = before0;
+            else if(value == 1)
+                position = total0 + before1;
+            else if(value == 2)
+                position = total0 + total1 + before2;
+            else
+                position = total0 + total1 + total2 + (localId - before0 - before1 - before2);
+
+            tileKeys[position] = key;
+            tileDigits[position] = digit;
+            if(indexMode != RADIX_INDEX_NONE)
+                tileIndices[position] = index;
+            barrier(CLK_LOCAL_MEM_FENCE);
+            key = tileKeys[localId];
+            digit = tileDigits[localId];
+            if(indexMode != RADIX_INDEX_NONE)
+                index = tileIndices[localId];
+            barrier(CLK_LOCAL_MEM_FENCE);
+        }
+
+        //  tileDigits is sorted now; find where the run of every digit starts
+        if(localId == 0 || tileDigits[localId - 1] != digit)
+            runStart[digit] = localId;
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        if(localId < validCount)
+        {
+            uint destination = digitCursor[digit] + localId - runStart[digit];
+            sortedData[destination] = key;
+            if(indexMode != RADIX_INDEX_NONE)
+                sortedIndices[destination] = index;
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        if(localId < validCount && (localId == validCount - 1 || tileDigits[localId + 1] != digit))
+            digitCursor[digit] += localId + 1 - runStart[digit];
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+}
+
+template <typename K>
+kernel
+void radixKeyDownsweepTemplate(global const K* unsortedData,
+               global const uint* counts,
+               uint shiftCount,
+               uint keyKind,
+               uint descending,
+               uint length,
+               uint elementsPerGroup,
+               uint numGroups,
+               global K* sortedData)
+{
+    local K    tileKeys[RADIX_KEY_WGSIZE];
+    local uint tileDigits[RADIX_KEY_WGSIZE];
+    local uint scanBuffer[RADIX_KEY_WGSIZE];
+    local uint digitCursor[RADIX_KEY_RADICES];
+    local uint runStart[RADIX_KEY_RADICES];
+
+    radixKeyDownsweep(unsortedData, (global const uint*)0, counts, shiftCount, keyKind, descending, length,
+                      elementsPerGroup, numGroups, RADIX_INDEX_NONE, sortedData, (global uint*)0,
+                      tileKeys, tileDigits, (local uint*)0, scanBuffer, digitCursor, runStart);
+}
+
+//  The downsweep of a sort by key; unsortedIndices is not read on the first pass
+template <typename K>
+kernel
+void radixKeyDownsweepByKeyTemplate(global const K* unsortedData,
+               global const uint* unsortedIndices,
+               global const uint* counts,
+               uint shiftCount,
+               uint keyKind,
+               uint descending,
+               uint length,
+               uint elementsPerGroup,
+               uint numGroups,
+               uint indexMode,
+               global K* sortedData,
+               global uint* sortedIndices)
+{
+    local K    tileKeys[RADIX_KEY_WGSIZE];
+    local uint tileDigits[RADIX_KEY_WGSIZE];
+    local uint tileIndices[RADIX_KEY_WGSIZE];
+    local uint scanBuffer[RADIX_KEY_WGSIZE];
+    local uint digitCursor[RADIX_KEY_RADICES];
+    local uint runStart[RADIX_KEY_RADICES];
+
+    radixKeyDownsweep(unsortedData, unsortedIndices, counts, shiftCount, keyKind, descending, length,
+                      elementsPerGroup, numGroups, indexMode, sortedData, sortedIndices,
+                      tileKeys, tileDigits, tileIndices, scanBuffer, digitCursor, runStart);
+}
+
+//  Moves every value to the position its key was sorted to: sortedValues[valueOffset + i] = unsortedValues[permutation[i]]
+template <typename V>
+kernel
+void radixGatherTemplate(global const V* unsortedValues,
+               global const uint* permutation,
+               uint length,
+               uint valueOffset,
+               global V* sortedValues)
+{
+    for(uint index = get_global_id(0); index < length; index += get_global_size(0))
+        sortedValues[valueOffset + index] = unsortedValues[permutation[index]];
+}
+
+/* Radix select, for nth_element, partial_sort and top_k.  The key of a given rank is found one digit at a time from
+ * the most significant: every pass counts the digits of only the keys whose higher digits match the ones found so
+ * far, and the host picks the digit the rank falls in.  prefix holds the digits found so far, in the ordered bits of
+ * radixKeyOrdered, and prefixMask their bits.  histogram holds RADIX_KEY_RADICES uints and must be zero on entry.
+ */
+template <typename K>
+kernel
+void radixSelectHistogramTemplate(global const K* keys,
+               uint first,
+               uint length,
+               K prefix,
+               K prefixMask,
+               uint shiftCount,
+               uint keyKind,
+               uint descending,
+               global uint* histogram)
+{
+    local uint localHistogram[RADIX_KEY_RADICES];
+    uint localId = get_local_id(0);
+
+    localHistogram[localId] = 0;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for(uint index = get_global_id(0); index < length; index += get_global_size(0))
+    {
+        K bits = radixKeyOrdered(keys[first + index], keyKind, descending);
+        if((K)(bits & prefixMask) == prefix)
+            atomic_inc(&localHistogram[(uint)(bits >> shiftCount) & RADIX_KEY_MASK]);
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if(localHistogram[localId])
+        atomic_add(&histogram[localId], localHistogram[localId]);
+}
+
+/* Writes the keys less than the pivot to output[outputFirst + 0, lessCount), then the first keepEqual keys equal to
+ * it, then, when keepGreater is set, the keys greater than it.  pivot is in ordered bits.  The order within each
+ * part is not kept.  cursors holds three uints, zero on entry; every tile claims its places in each part with one
+ * global atomic.
+ */
+template <typename K>
+kernel
+void radixSelectPartitionTemplate(global const K* keys,
+               uint first,
+               uint length,
+               K pivot,
+               uint keyKind,
+               uint descending,
+               uint lessCount,
+               uint keepEqual,
+               uint keepGreater,
+               global uint* cursors,
+               uint outputFirst,
+               global K* output)
+{
+    local uint tileCounts[3];
+    local uint tileStarts[3];
+    uint localId = get_local_id(0);
+
+    for(uint tile = get_group_id(0) * RADIX_KEY_WGSIZE; tile < length; tile += get_global_size(0))
+    {
+        if(localId < 3)
+            tileCounts[localId] = 0;
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        uint index = tile + localId;
+        K key = 0;
+        uint part = 3;
+        uint slot = 0;
+        if(index < length)
+        {
+            key = keys[first + index];
+            K bits = radixKeyOrdered(key, keyKind, descending);
+            part = (bits < pivot) ? 0 : ((bits == pivot) ? 1 : 2);
+            slot = atomic_inc(&tileCounts[part]);
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        if(localId < 3)
+            tileStarts[localId] = atomic_add(&cursors[localId], tileCounts[localId]);
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        if(part == 0)
+            output[outputFirst + tileStarts[0] + slot] = key;
+        else if(part == 1 && tileStarts[1] + slot < keepEqual)
+            output[outputFirst + lessCount + tileStarts[1] + slot] = key;
+        else if(part == 2 && keepGreater)
+            output[outputFirst + lessCount + keepEqual + tileStarts[2] + slot] = key;
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+}
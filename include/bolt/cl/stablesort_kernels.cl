@@ -27,224 +27,195 @@
 
 // #pragma OPENCL EXTENSION cl_amd_printf : enable
 
-//  This implements a linear search routine to look for an 'insertion point' in a sequence, denoted
-//  by a base pointer and a left and right index, with a  candidate value.  The comparison operator is 
-//  passed as a functor parameter lessOp
-//  This function returns an index that would be the appropriate index to use to insert the value
-template< typename sType, typename StrictWeakOrdering >
-uint lowerBoundLinear( global sType* data, uint left, uint right, sType searchVal, global StrictWeakOrdering* lessOp )
+/* The sort runs in tiles of tileSize = local size * itemsPerThread elements.  blockSortTemplate sorts every tile
+ * in local memory, then every launch of mergeTemplate merges pairs of sorted runs into runs of twice the width.
+ * Each work group of a merge owns one tile of the output: it finds where its tile starts and ends in both input
+ * runs by a binary search along the merge path, loads exactly those elements into local memory with coalesced
+ * reads, merges them there and writes them back out coalesced.  Every work group does the same amount of work,
+ * however the two runs interleave.
+ */
+
+//  The compare-exchange pair of pairId in pass passOfStage of stage of a bitonic network; rightId is past leftId.
+//  The first pass of a stage compares mirrored positions, so positions past the end of the tile behave as
+//  elements greater than any other, and the pairs that reach them are skipped
+inline void stableSortPair( uint pairId, uint stage, uint passOfStage, uint* leftId, uint* rightId )
 {
-    //  The values firstIndex and lastIndex get modified within the loop, narrowing down the potential sequence
-    uint firstIndex = left;
-    uint lastIndex = right;
-    
-    //  This loops through [firstIndex, lastIndex)
-    //  Since firstIndex and lastIndex will be different for every thread depending on the nested branch,
-    //  this while loop will be divergent within a wavefront
-    while( firstIndex < lastIndex )
-    {
-        sType dataVal = data[ firstIndex ];
-        
-        //  This branch will create divergent wavefronts
-        if( (*lessOp)( dataVal, searchVal ) )
-        {
-            firstIndex = firstIndex+1;
-        }
-        else
-        {
-            break;
-        }
-    }
-    
-    return firstIndex;
+    uint pairDistance = 1 << (stage - passOfStage);
+    uint blockWidth   = 2 * pairDistance;
+    uint offset = pairId & (pairDistance - 1);
+    *leftId = offset + (pairId >> (stage - passOfStage) ) * blockWidth;
+    *rightId = (passOfStage == 0) ? *leftId + blockWidth - 1 - 2 * offset : *leftId + pairDistance;
 }
 
-//  This implements a binary search routine to look for an 'insertion point' in a sequence, denoted
-//  by a base pointer and left and right index for a particular candidate value.  The comparison operator is 
-//  passed as a functor parameter lessOp
-//  This function returns an index that is the first index whos value would be equal to the searched value
-template< typename sType, typename StrictWeakOrdering >
-uint lowerBoundBinary( global sType* data, uint left, uint right, sType searchVal, global StrictWeakOrdering* lessOp )
+//  Number of elements of run A among the first diagonal outputs of the stable merge of runs A and B, which both
+//  live in the global sequence iter at aStart and bStart
+template< typename sIterType, typename StrictWeakOrdering >
+uint mergePathGlobal( sIterType iter, uint aStart, uint aLength, uint bStart, uint bLength, uint diagonal,
+                      global StrictWeakOrdering* lessOp )
 {
-    //  The values firstIndex and lastIndex get modified within the loop, narrowing down the potential sequence
-    uint firstIndex = left;
-    uint lastIndex = right;
-    
-    //  This loops through [firstIndex, lastIndex)
-    //  Since firstIndex and lastIndex will be different for every thread depending on the nested branch,
-    //  this while loop will be divergent within a wavefront
-    while( firstIndex < lastIndex )
+    uint low = ( diagonal > bLength ) ? diagonal - bLength : 0;
+    uint high = min( diagonal, aLength );
+    while( low < high )
     {
-        //  midIndex is the average of first and last, rounded down
-        uint midIndex = ( firstIndex + lastIndex ) / 2;
-        sType midValue = data[ midIndex ];
-        
-        //  This branch will create divergent wavefronts
-        if( (*lessOp)( midValue, searchVal ) )
-        {
-            firstIndex = midIndex+1;
-            // printf( "lowerBound: lastIndex[ %i ]=%i\n", get_local_id( 0 ), lastIndex );
-        }
+        uint mid = low + ( high - low ) / 2;
+        if( (*lessOp)( iter[ bStart + diagonal - mid - 1 ], iter[ aStart + mid ] ) )
+            high = mid;
         else
-        {
-            lastIndex = midIndex;
-            // printf( "lowerBound: firstIndex[ %i ]=%i\n", get_local_id( 0 ), firstIndex );
-        }
+            low = mid + 1;
     }
-    
-    return firstIndex;
+    return low;
 }
 
-//  This implements a binary search routine to look for an 'insertion point' in a sequence, denoted
-//  by a base pointer and left and right index for a particular candidate value.  The comparison operator is 
-//  passed as a functor parameter lessOp
-//  This function returns an index that is the first index whos value would be greater than the searched value
-//  If the search value is not found in the sequence, upperbound returns the same result as lowerbound
+//  The same search, over two runs held in local memory
 template< typename sType, typename StrictWeakOrdering >
-uint upperBoundBinary( global sType* data, uint left, uint right, sType searchVal, global StrictWeakOrdering* lessOp )
+uint mergePathLocal( local sType* a, uint aLength, local sType* b, uint bLength, uint diagonal,
+                     global StrictWeakOrdering* lessOp )
 {
-    uint upperBound = lowerBoundBinary( data, left, right, searchVal, lessOp );
-    
-    // printf( "upperBoundBinary: upperBound[ %i, %i ]= %i\n", left, right, upperBound );
-    //  If upperBound == right, then  searchVal was not found in the sequence.  Just return.
-    if( upperBound != right )
+    uint low = ( diagonal > bLength ) ? diagonal - bLength : 0;
+    uint high = min( diagonal, aLength );
+    while( low < high )
     {
-        //  While the values are equal i.e. !(x < y) && !(y < x) increment the index
-        sType upperValue = data[ upperBound ];
-        while( !(*lessOp)( upperValue, searchVal ) && !(*lessOp)( searchVal, upperValue) && (upperBound != right) )
-        {
-            upperBound++;
-            upperValue = data[ upperBound ];
-        }
+        uint mid = low + ( high - low ) / 2;
+        if( (*lessOp)( b[ diagonal - mid - 1 ], a[ mid ] ) )
+            high = mid;
+        else
+            low = mid + 1;
     }
-    
-    return upperBound;
+    return low;
 }
 
-//  This kernel implements merging of blocks of sorted data.  The input to this kernel most likely is
-//  the output of blockInsertionSortTemplate.  It is expected that the source array contains multiple
-//  blocks, each block is independently sorted.  The goal is to write into the output buffer half as 
-//  many blocks, of double the size.  The even and odd blocks are stably merged together to form
-//  a new sorted block of twice the size.  The algorithm is out-of-place.
-template< typename sPtrType, typename dIterType, typename StrictWeakOrdering >
+//  This kernel stably merges pairs of sorted runs of srcBlockSize elements from source into runs of twice that
+//  width in result.  srcBlockSize is a multiple of the tile size, so an output tile never straddles two merges.
+//  The algorithm is out-of-place.
+template< typename sPtrType, typename sIterType, typename StrictWeakOrdering >
 kernel void mergeTemplate( 
                 global sPtrType* source_ptr,
-                dIterType    source_iter, 
+                sIterType    source_iter, 
                 global sPtrType* result_ptr,
-                dIterType    result_iter, 
+                sIterType    result_iter, 
                 const uint srcVecSize,
-                const uint srcLogicalBlockSize,
+                const uint srcBlockSize,
+                const uint itemsPerThread,
                 local sPtrType* lds,
+                local uint* coRank,
                 global StrictWeakOrdering* lessOp
             )
 {
-    size_t globalID     = get_global_id( 0 );
-    size_t groupID      = get_group_id( 0 );
-    size_t localID      = get_local_id( 0 );
-    size_t wgSize       = get_local_size( 0 );
-
-    //  Abort threads that are passed the end of the input vector
-    if( globalID >= srcVecSize )
-        return; // on SI this doesn't mess-up barriers
-
-    //  For an element in sequence A, find the lowerbound index for it in sequence B
-    uint srcBlockNum = globalID / srcLogicalBlockSize;
-    uint srcBlockIndex = globalID % srcLogicalBlockSize;
-    
-    // printf( "mergeTemplate: srcBlockNum[%i]=%i\n", srcBlockNum, srcBlockIndex );
-
-    //  Pairs of even-odd blocks will be merged together 
-    //  An even block should search for an insertion point in the next odd block, 
-    //  and the odd block should look for an insertion point in the corresponding previous even block
-    uint dstLogicalBlockSize = srcLogicalBlockSize<<1;
-    uint leftBlockIndex = globalID & ~((dstLogicalBlockSize) - 1 );
-    leftBlockIndex += (srcBlockNum & 0x1) ? 0 : srcLogicalBlockSize;
-    leftBlockIndex = min( leftBlockIndex, srcVecSize );
-    uint rightBlockIndex = min( leftBlockIndex + srcLogicalBlockSize, srcVecSize );
-    
-    // if( localID == 0 )
-    // {
-        // printf( "mergeTemplate: wavefront[ %i ] logicalBlock[ %i ] logicalIndex[ %i ] leftBlockIndex[ %i ] <=> rightBlockIndex[ %i ]\n", groupID, srcBlockNum, srcBlockIndex, leftBlockIndex, rightBlockIndex );
-    // }
-    
-    //  For a particular element in the input array, find the lowerbound index for it in the search sequence given by leftBlockIndex & rightBlockIndex
-    // uint insertionIndex = lowerBoundLinear( source_ptr, leftBlockIndex, rightBlockIndex, source_ptr[ globalID ], lessOp ) - leftBlockIndex;
-    uint insertionIndex = 0;
-    if( (srcBlockNum & 0x1) == 0 )
+    uint localId    = get_local_id( 0 );
+    uint wgSize     = get_local_size( 0 );
+    uint tileSize   = wgSize * itemsPerThread;
+    uint outBegin   = get_group_id( 0 ) * tileSize;
+    uint outEnd     = min( outBegin + tileSize, srcVecSize );
+    uint tileLength = outEnd - outBegin;
+
+    source_iter.init( source_ptr );
+    result_iter.init( result_ptr );
+
+    //  The pair of runs this tile of output comes from
+    uint left   = ( outBegin / ( 2 * srcBlockSize ) ) * 2 * srcBlockSize;
+    uint middle = min( left + srcBlockSize, srcVecSize );
+    uint right  = min( middle + srcBlockSize, srcVecSize );
+
+    //  Where the tile starts and ends in the left run; the right run supplies the rest
+    if( localId < 2 )
+    {
+        uint diagonal = ( ( localId == 0 ) ? outBegin : outEnd ) - left;
+        coRank[ localId ] = mergePathGlobal( source_iter, left, middle - left, middle, right - middle, diagonal, lessOp );
+    }
+    barrier( CLK_LOCAL_MEM_FENCE );
+
+    uint aBegin = left + coRank[ 0 ];
+    uint aCount = coRank[ 1 ] - coRank[ 0 ];
+    uint bBegin = middle + ( outBegin - left ) - coRank[ 0 ];
+    uint bCount = tileLength - aCount;
+
+    //  Both pieces side by side in the first half of lds; the merged tile goes to the second half
+    for( uint index = localId; index < tileLength; index += wgSize )
     {
-        insertionIndex = lowerBoundBinary( source_ptr, leftBlockIndex, rightBlockIndex, source_ptr[ globalID ], lessOp ) - leftBlockIndex;
+        lds[ index ] = ( index < aCount ) ? source_iter[ aBegin + index ] : source_iter[ bBegin + index - aCount ];
     }
-    else
+    barrier( CLK_LOCAL_MEM_FENCE );
+
+    //  Each work item merges itemsPerThread consecutive outputs, taking from the left run on ties
+    uint diagonal = min( localId * itemsPerThread, tileLength );
+    uint diagonalEnd = min( diagonal + itemsPerThread, tileLength );
+    uint a = mergePathLocal( lds, aCount, lds + aCount, bCount, diagonal, lessOp );
+    uint b = diagonal - a;
+    local sPtrType* merged = lds + tileSize;
+    for( uint index = diagonal; index < diagonalEnd; ++index )
+    {
+        bool takeB = ( b < bCount ) && ( ( a >= aCount ) || (*lessOp)( lds[ aCount + b ], lds[ a ] ) );
+        if( takeB )
+            merged[ index ] = lds[ aCount + b++ ];
+        else
+            merged[ index ] = lds[ a++ ];
+    }
+    barrier( CLK_LOCAL_MEM_FENCE );
+
+    for( uint index = localId; index < tileLength; index += wgSize )
     {
-        insertionIndex = upperBoundBinary( source_ptr, leftBlockIndex, rightBlockIndex, source_ptr[ globalID ], lessOp ) - leftBlockIndex;
+        result_iter[ outBegin + index ] = merged[ index ];
     }
-    
-    //  The index of an element in the result sequence is the summation of it's indixes in the two input 
-    //  sequences
-    uint dstBlockIndex = srcBlockIndex + insertionIndex;
-    uint dstBlockNum = srcBlockNum/2;
-    
-    // if( (dstBlockNum*dstLogicalBlockSize)+dstBlockIndex == 395 )
-    // {
-        // printf( "mergeTemplate: (dstBlockNum[ %i ] * dstLogicalBlockSize[ %i ]) + dstBlockIndex[ %i ] = srcBlockIndex[ %i ] + insertionIndex[ %i ]\n", dstBlockNum, dstLogicalBlockSize, dstBlockIndex, srcBlockIndex, insertionIndex );
-        // printf( "mergeTemplate: dstBlockIndex[ %i ] = source_ptr[ %i ] ( %i )\n", (dstBlockNum*dstLogicalBlockSize)+dstBlockIndex, globalID, source_ptr[ globalID ] );
-    // }
-    result_ptr[ (dstBlockNum*dstLogicalBlockSize)+dstBlockIndex ] = source_ptr[ globalID ];
-    // printf( "mergeTemplate: leftResultIndex[ %i ]=%i + %i\n", leftResultIndex, srcBlockIndex, leftInsertionIndex );
 }
 
+//  This kernel stably sorts every tile of the vector in local memory with a bitonic network.  Equal elements are
+//  ordered by their position in the tile, which is carried alongside them in ldsIndex, so the network's swaps
+//  keep the sort stable.
 template< typename dPtrType, typename dIterType, typename StrictWeakOrdering >
-kernel void blockInsertionSortTemplate( 
+kernel void blockSortTemplate( 
                 global dPtrType* data_ptr,
                 dIterType    data_iter, 
                 const uint vecSize,
+                const uint itemsPerThread,
                 local dPtrType* lds,
+                local uint* ldsIndex,
                 global StrictWeakOrdering* lessOp
             )
 {
-    size_t gloId    = get_global_id( 0 );
-    size_t groId    = get_group_id( 0 );
-    size_t locId    = get_local_id( 0 );
-    size_t wgSize   = get_local_size( 0 );
-
-    //  Abort threads that are passed the end of the input vector
-    if (gloId >= vecSize) return; // on SI this doesn't mess-up barriers
+    uint localId    = get_local_id( 0 );
+    uint wgSize     = get_local_size( 0 );
+    uint tileSize   = wgSize * itemsPerThread;
+    uint tileStart  = get_group_id( 0 ) * tileSize;
+    uint tileLength = min( tileSize, vecSize - tileStart );
 
     data_iter.init( data_ptr );
 
-    //  Make a copy of the entire input array into fast local memory
-    dPtrType val = data_iter[ gloId ];
-    lds[ locId ] = val;
+    for( uint index = localId; index < tileLength; index += wgSize )
+    {
+        lds[ index ] = data_iter[ tileStart + index ];
+        ldsIndex[ index ] = index;
+    }
     barrier( CLK_LOCAL_MEM_FENCE );
 
-    //  Sorts a workgroup using a naive insertion sort
-    //  The sort uses one thread within a workgroup to sort the entire workgroup
-    if( locId == 0 )
+    for( uint stage = 0; ( 2u << stage ) <= tileSize; ++stage )
     {
-        //  The last workgroup may have an irregular size, so we calculate a per-block endIndex
-        //  endIndex is essentially emulating a mod operator with subtraction and multiply
-        size_t endIndex = vecSize - ( groId * wgSize );
-        endIndex = min( endIndex, wgSize );
-
-        // printf( "Debug: endIndex[%i]=%i\n", groId, endIndex );
-
-        //  Indices are signed because the while loop will generate a -1 index inside of the max function
-        for( int currIndex = 1; currIndex < endIndex; ++currIndex )
+        for( uint pass = 0; pass <= stage; ++pass )
         {
-            val = lds[ currIndex ];
-            int scanIndex = currIndex;
-            dPtrType ldsVal = lds[scanIndex - 1];
-            while( scanIndex > 0 && (*lessOp)( val, ldsVal ) )
+            for( uint pairId = localId; pairId < tileSize / 2; pairId += wgSize )
             {
-                lds[ scanIndex ] = ldsVal;
-                scanIndex = scanIndex - 1;
-                ldsVal = lds[ max(0, scanIndex - 1) ];  // scanIndex-1 may be -1
+                uint leftId, rightId;
+                stableSortPair( pairId, stage, pass, &leftId, &rightId );
+                if( rightId < tileLength )
+                {
+                    dPtrType leftVal = lds[ leftId ];
+                    dPtrType rightVal = lds[ rightId ];
+                    uint leftIndex = ldsIndex[ leftId ];
+                    uint rightIndex = ldsIndex[ rightId ];
+                    if( (*lessOp)( rightVal, leftVal ) || ( !(*lessOp)( leftVal, rightVal ) && rightIndex < leftIndex ) )
+                    {
+                        lds[ leftId ] = rightVal;
+                        lds[ rightId ] = leftVal;
+                        ldsIndex[ leftId ] = rightIndex;
+                        ldsIndex[ rightId ] = leftIndex;
+                    }
+                }
             }
-            lds[ scanIndex ] = val;
+            barrier( CLK_LOCAL_MEM_FENCE );
         }
     }
-    barrier( CLK_LOCAL_MEM_FENCE );
 
-    val = lds[ locId ];
-    data_iter[ gloId ] = val;
+    for( uint index = localId; index < tileLength; index += wgSize )
+    {
+        data_iter[ tileStart + index ] = lds[ index ];
+    }
 }
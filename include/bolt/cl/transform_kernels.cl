@@ -25,10 +25,10 @@ void transformTemplate (
             iIterType2 B_iter,
             global oNakedType* Z_ptr,
             oIterType Z_iter,
-			const uint length,
+			const indexType length,
             global binary_function* userFunctor )
 {
-    int gx = get_global_id( 0 );
+    indexType gx = get_global_id( 0 );
 	if (gx >= length)
 		return;
 
@@ -52,10 +52,10 @@ void transformNoBoundsCheckTemplate (
             iIterType2 B_iter,
             global oNakedType* Z_ptr,
             oIterType Z_iter,
-			const uint length,
+			const indexType length,
             global binary_function* userFunctor)
 {
-    int gx = get_global_id( 0 );
+    indexType gx = get_global_id( 0 );
     A_iter.init( A_ptr );
     B_iter.init( B_ptr );
     Z_iter.init( Z_ptr );
@@ -73,10 +73,10 @@ void unaryTransformTemplate(
             iIterType A_iter,
             global oNakedType* Z_ptr,
             oIterType Z_iter,
-			const uint length,
+			const indexType length,
             global unary_function* userFunctor)
 {
-    int gx = get_global_id( 0 );
+    indexType gx = get_global_id( 0 );
 	if (gx >= length)
 		return;
 
@@ -94,10 +94,10 @@ void unaryTransformNoBoundsCheckTemplate(
             iIterType A_iter,
             global oNakedType* Z_ptr,
             oIterType Z_iter,
-			const uint length,
+			const indexType length,
             global unary_function* userFunctor)
 {
-    int gx = get_global_id( 0 );
+    indexType gx = get_global_id( 0 );
 
     A_iter.init( A_ptr );
     Z_iter.init( Z_ptr );
@@ -107,6 +107,59 @@ namespace bolt {
             BinaryFunction reduce_op,
             const std::string& user_code="" );
 
+        /*! \brief \p transform_reduce_into is \p transform_reduce that stores the result at \p result instead of
+         *  returning it.
+         *  \details With a device_vector iterator as \p result and the OpenCL device running the reduction, the
+         *  result is written by the device and never read back, and the call returns once the kernels are enqueued.
+         *  Later Bolt calls on the same control see it in order.  See bolt::cl::reduce_into.
+         *
+         * \param ctl \b Optional Control structure to control command-queue, debug, tuning, etc.See bolt::cl::control.
+         * \param first The beginning of the input sequence.
+         * \param last The end of the input sequence.
+         * \param result The position the result is stored at.
+         * \param transform_op A unary tranformation operation.
+         * \param init  The initial value for the accumulator.
+         * \param reduce_op  The binary operation used to combine two values.
+         * \param user_code Optional OpenCL&tm; code to be passed to the OpenCL compiler.
+         *
+         *  \code
+         *  #include <bolt/cl/reduce.h>
+         *  #include <bolt/cl/transform_reduce.h>
+         *  #include <bolt/cl/functional.h>
+         *
+         *  bolt::cl::device_vector< float > input( 1024, 2.0f );
+         *  bolt::cl::device_vector< float > moments( 2 );
+         *
+         *  bolt::cl::reduce_into( input.begin( ), input.end( ), moments.begin( ), 0.0f, bolt::cl::plus< float >( ) );
+         *  bolt::cl::transform_reduce_into( input.begin( ), input.end( ), moments.begin( ) + 1,
+         *      bolt::cl::square< float >( ), 0.0f, bolt::cl::plus< float >( ) );
+         *
+         *  // moments => {2048, 4096}; both sums are read back together
+         *  \endcode
+         */
+        template<typename InputIterator, typename OutputIterator, typename UnaryFunction, typename T,
+            typename BinaryFunction>
+        void transform_reduce_into(
+            control& ctl,
+            InputIterator first,
+            InputIterator last,
+            OutputIterator result,
+            UnaryFunction transform_op,
+            T init,
+            BinaryFunction reduce_op,
+            const std::string& user_code="" );
+
+        template<typename InputIterator, typename OutputIterator, typename UnaryFunction, typename T,
+            typename BinaryFunction>
+        void transform_reduce_into(
+            InputIterator first,
+            InputIterator last,
+            OutputIterator result,
+            UnaryFunction transform_op,
+            T init,
+            BinaryFunction reduce_op,
+            const std::string& user_code="" );
+
 
         /*!   \}  */
 
@@ -96,3 +96,41 @@ kernel void transform_reduceTemplate(
         result_ptr[ get_group_id( 0 ) ] = scratch[ 0 ];
     }
 };
+
+//  Second stage of a transform_reduce: one work group folds the per work group results of transform_reduceTemplate,
+//  then init, and writes the value to result_ptr[ resultIndex ], so the result can stay on the device
+template< typename oNakedType, typename rType, typename binary_function >
+kernel void transform_reduceFinal(
+    global oNakedType* partials,
+    const int numPartials,
+    const oNakedType init,
+    global binary_function* reduceFunctor,
+    global rType* result_ptr,
+    const uint resultIndex,
+    local oNakedType* scratch
+)
+{
+    int local_index = get_local_id( 0 );
+
+    oNakedType accumulator;
+    if( local_index < numPartials )
+        accumulator = partials[ local_index ];
+    for( int i = local_index + get_local_size( 0 ); i < numPartials; i += get_local_size( 0 ) )
+        accumulator = (*reduceFunctor)( accumulator, partials[ i ] );
+
+    scratch[ local_index ] = accumulator;
+    barrier( CLK_LOCAL_MEM_FENCE );
+
+    uint tail = min( numPartials, (int)get_local_size( 0 ) );
+    _REDUCE_STEP( tail, local_index, 32 );
+    _REDUCE_STEP( tail, local_index, 16 );
+    _REDUCE_STEP( tail, local_index,  8 );
+    _REDUCE_STEP( tail, local_index,  4 );
+    _REDUCE_STEP( tail, local_index,  2 );
+    _REDUCE_STEP( tail, local_index,  1 );
+
+    if( local_index == 0 )
+    {
+        result_ptr[ resultIndex ] = (*reduceFunctor)( init, scratch[ 0 ] );
+    }
+};
@@ -24,6 +24,12 @@
 #include "bolt/cl/functional.h"
 #include "bolt/cl/device_vector.h"
 #include "bolt/cl/scan.h"
+#include "bolt/cl/reduce.h"
+#include "bolt/cl/transform.h"
+#include "bolt/cl/transform_reduce.h"
+#include "bolt/cl/count.h"
+#include "bolt/cl/fill.h"
+#include "bolt/cl/generate.h"
 
 #include "bolt/unicode.h"
 #include "bolt/miniDump.h"
@@ -31,6 +37,7 @@
 
 #include <gtest/gtest.h>
 #include <boost/program_options.hpp>
+#include <boost/thread/thread.hpp>
 namespace po = boost::program_options;
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -432,6 +439,223 @@ TEST_F( CopyControlTest, ScanIntegerVector )
     EXPECT_EQ( 2049, internalBuffSize );
 }
 
+TEST_F( CopyControlTest, defaultWaitMode )
+{
+    EXPECT_EQ( bolt::cl::control::BalancedWait, myControl.getWaitMode( ) );
+}
+
+TEST_F( CopyControlTest, ReduceEveryWaitMode )
+{
+    bolt::cl::control::e_WaitMode waitModes[ ] = { bolt::cl::control::BalancedWait, bolt::cl::control::NiceWait,
+                                                   bolt::cl::control::BusyWait, bolt::cl::control::ClFinish };
+    std::vector< int > stdInput( 1024 );
+    for( size_t i = 0; i < stdInput.size( ); ++i )
+        stdInput[ i ] = static_cast< int >( i );
+    bolt::cl::device_vector< int > boltInput( stdInput.begin( ), stdInput.end( ) );
+    int stdSum = std::accumulate( stdInput.begin( ), stdInput.end( ), 0 );
+
+    for( size_t mode = 0; mode < countOf( waitModes ); ++mode )
+    {
+        myControl.setWaitMode( waitModes[ mode ] );
+
+        //  Repeat the call so that BalancedWait runs both with and without completion history
+        for( int repeat = 0; repeat < 4; ++repeat )
+        {
+            int boltSum = bolt::cl::reduce( myControl, boltInput.begin( ), boltInput.end( ), 0 );
+            EXPECT_EQ( stdSum, boltSum ) << _T( "Where mode = " ) << mode;
+        }
+    }
+}
+
+TEST_F( CopyControlTest, TbbPartitionerOverride )
+{
+    bolt::cl::control::tbbPartitionDesc transformDesc = myControl.getTbbPartitioner( "transform" );
+    EXPECT_EQ( bolt::cl::control::SimplePartitioner, transformDesc.partitioner );
+    EXPECT_EQ( 1024, transformDesc.grainSize );
+
+    myControl.setTbbPartitioner( bolt::cl::control::AffinityPartitioner, 4096, "reduce" );
+    bolt::cl::control::tbbPartitionDesc reduceDesc = myControl.getTbbPartitioner( "reduce" );
+    EXPECT_EQ( bolt::cl::control::AffinityPartitioner, reduceDesc.partitioner );
+    EXPECT_EQ( 4096, reduceDesc.grainSize );
+
+    //  Algorithms without an override pick up the default
+    bolt::cl::control::tbbPartitionDesc countDesc = myControl.getTbbPartitioner( "count" );
+    EXPECT_EQ( myControl.getTbbPartitioner( ).partitioner, countDesc.partitioner );
+
+    //  Copies keep the overrides
+    bolt::cl::control copyControl( myControl );
+    EXPECT_EQ( bolt::cl::control::AffinityPartitioner, copyControl.getTbbPartitioner( "reduce" ).partitioner );
+}
+
+#if defined( ENABLE_TBB )
+TEST_F( CopyControlTest, ReduceMultiCoreEveryPartitioner )
+{
+    bolt::cl::control::e_TbbPartitioner partitioners[ ] = { bolt::cl::control::AutoPartitioner,
+        bolt::cl::control::SimplePartitioner, bolt::cl::control::AffinityPartitioner };
+    std::vector< int > stdInput( 1 << 16 );
+    for( size_t i = 0; i < stdInput.size( ); ++i )
+        stdInput[ i ] = static_cast< int >( i % 127 );
+    int stdSum = std::accumulate( stdInput.begin( ), stdInput.end( ), 0 );
+
+    myControl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+    myControl.setTbbConcurrency( 2 );
+    myControl.setTbbPinThreads( true );
+
+    for( size_t p = 0; p < countOf( partitioners ); ++p )
+    {
+        myControl.setTbbPartitioner( partitioners[ p ], 512 );
+        int boltSum = bolt::cl::reduce( myControl, stdInput.begin( ), stdInput.end( ), 0 );
+        EXPECT_EQ( stdSum, boltSum ) << _T( "Where partitioner = " ) << p;
+    }
+}
+
+//  Reduces with a control shared between threads, while another thread keeps changing its arena settings
+struct ConcurrentArenaReduce
+{
+    const bolt::cl::control* ctl;
+    const std::vector< int >* input;
+    int expected;
+    int mismatches;
+
+    void operator( )( )
+    {
+        for( int i = 0; i < 16; ++i )
+            if( bolt::cl::reduce( *ctl, input->begin( ), input->end( ), 0 ) != expected )
+                ++mismatches;
+    }
+};
+
+TEST_F( CopyControlTest, ArenaSharedBetweenThreads )
+{
+    std::vector< int > stdInput( 1 << 16 );
+    for( size_t i = 0; i < stdInput.size( ); ++i )
+        stdInput[ i ] = static_cast< int >( i % 127 );
+    int stdSum = std::accumulate( stdInput.begin( ), stdInput.end( ), 0 );
+
+    myControl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+    ConcurrentArenaReduce reducers[ 2 ] = { { &myControl, &stdInput, stdSum, 0 }, { &myControl, &stdInput, stdSum, 0 } };
+    boost::thread first( boost::ref( reducers[ 0 ] ) );
+    boost::thread second( boost::ref( reducers[ 1 ] ) );
+    for( int i = 0; i < 16; ++i )
+    {
+        myControl.setTbbConcurrency( 1 + i % 3 );
+        myControl.setTbbPinThreads( ( i & 1 ) != 0 );
+    }
+    first.join( );
+    second.join( );
+
+    EXPECT_EQ( 0, reducers[ 0 ].mismatches );
+    EXPECT_EQ( 0, reducers[ 1 ].mismatches );
+}
+
+TEST_F( CopyControlTest, NumaAwareTransformReduce )
+{
+    const size_t length = 1 << 20;
+    std::vector< int > stdInput( length );
+    for( size_t i = 0; i < length; ++i )
+        stdInput[ i ] = static_cast< int >( i % 1021 );
+    std::vector< int > stdOutput( length );
+    std::transform( stdInput.begin( ), stdInput.end( ), stdOutput.begin( ), std::negate< int >( ) );
+    int stdSum = std::accumulate( stdInput.begin( ), stdInput.end( ), 0 );
+
+    myControl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+    myControl.setNumaAware( true );
+
+    //  Host iterators
+    std::vector< int > boltOutput( length );
+    bolt::cl::transform( myControl, stdInput.begin( ), stdInput.end( ), boltOutput.begin( ), bolt::cl::negate< int >( ) );
+    cmpArrays( stdOutput, boltOutput );
+    EXPECT_EQ( stdSum, bolt::cl::reduce( myControl, stdInput.begin( ), stdInput.end( ), 0 ) );
+
+    //  device_vector, first-touched by the node arenas on CPU devices
+    bolt::cl::device_vector< int > dvInput( stdInput.begin( ), stdInput.end( ), CL_MEM_READ_WRITE, myControl );
+    bolt::cl::device_vector< int > dvOutput( length, 0, CL_MEM_READ_WRITE, true, myControl );
+    bolt::cl::transform( myControl, dvInput.begin( ), dvInput.end( ), dvOutput.begin( ), bolt::cl::negate< int >( ) );
+    cmpArrays( stdOutput, dvOutput );
+    EXPECT_EQ( stdSum, bolt::cl::reduce( myControl, dvInput.begin( ), dvInput.end( ), 0 ) );
+}
+#endif
+
+BOLT_FUNCTOR( HeteroGenConst,
+struct HeteroGenConst
+{
+    int operator( )( )
+    {
+        return 7;
+    }
+};
+);  // end BOLT_FUNCTOR
+
+class HeterogeneousControlTest: public ::testing::TestWithParam< bolt::cl::control::e_UseHostMode >
+{
+public:
+    HeterogeneousControlTest( ): myControl( bolt::cl::control::getDefault( ) ), length( 100003 ),
+        stdInput( length ), stdOutput( length )
+    {
+        for( size_t i = 0; i < length; ++i )
+            stdInput[ i ] = static_cast< int >( i % 1021 );
+        std::transform( stdInput.begin( ), stdInput.end( ), stdOutput.begin( ), std::negate< int >( ) );
+
+        myControl.setForceRunMode( bolt::cl::control::Heterogeneous );
+        myControl.setUseHost( GetParam( ) );
+        //  A small chunk so every worker gets several chunks of the range
+        myControl.setHeterogeneousChunkSize( 4096 );
+    }
+
+    //  Runs every algorithm with a Heterogeneous path and compares against the std result
+    void checkAlgorithms( )
+    {
+        std::vector< int > boltOutput( length );
+        bolt::cl::transform( myControl, stdInput.begin( ), stdInput.end( ), boltOutput.begin( ), bolt::cl::negate< int >( ) );
+        cmpArrays( stdOutput, boltOutput );
+
+        int stdSum = std::accumulate( stdInput.begin( ), stdInput.end( ), 0 );
+        EXPECT_EQ( stdSum, bolt::cl::reduce( myControl, stdInput.begin( ), stdInput.end( ), 0 ) );
+
+        int stdNegSum = std::accumulate( stdOutput.begin( ), stdOutput.end( ), 0 );
+        EXPECT_EQ( stdNegSum, bolt::cl::transform_reduce( myControl, stdInput.begin( ), stdInput.end( ),
+            bolt::cl::negate< int >( ), 0, bolt::cl::plus< int >( ) ) );
+
+        std::iterator_traits< std::vector< int >::iterator >::difference_type stdCount =
+            std::count( stdInput.begin( ), stdInput.end( ), 5 );
+        EXPECT_EQ( stdCount, bolt::cl::count( myControl, stdInput.begin( ), stdInput.end( ), 5 ) );
+
+        std::vector< int > stdFill( length, 3 );
+        bolt::cl::fill( myControl, boltOutput.begin( ), boltOutput.end( ), 3 );
+        cmpArrays( stdFill, boltOutput );
+
+        std::vector< int > stdGen( length, 7 );
+        bolt::cl::generate( myControl, boltOutput.begin( ), boltOutput.end( ), HeteroGenConst( ) );
+        cmpArrays( stdGen, boltOutput );
+    }
+
+protected:
+    bolt::cl::control myControl;
+    size_t length;
+    std::vector< int > stdInput;
+    std::vector< int > stdOutput;
+};
+
+//  Every device in the context of the control's queue
+TEST_P( HeterogeneousControlTest, ContextDevices )
+{
+    checkAlgorithms( );
+}
+
+//  Two queues on the same device still split the range between two workers
+TEST_P( HeterogeneousControlTest, ExplicitQueues )
+{
+    std::vector< ::cl::CommandQueue > queues;
+    queues.push_back( myControl.getCommandQueue( ) );
+    queues.push_back( ::cl::CommandQueue( myControl.getContext( ), myControl.getDevice( ) ) );
+    myControl.setHeterogeneousQueues( queues );
+
+    checkAlgorithms( );
+}
+
+INSTANTIATE_TEST_CASE_P( UseHost, HeterogeneousControlTest,
+    ::testing::Values( bolt::cl::control::UseHost, bolt::cl::control::NoUseHost ) );
+
 int _tmain(int argc, _TCHAR* argv[])
 {
     ::testing::InitGoogleTest( &argc, &argv[ 0 ] );
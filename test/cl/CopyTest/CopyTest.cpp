@@ -599,6 +599,25 @@ TEST (copyStructOdd, BufferTestHostToDevice)
 
 }
 
+//  The kernel built with 64 bit indices, copying between offsets into device_vectors
+TEST( Copy, WideIndexKernels )
+{
+    const int length = 100003;
+    std::vector< int > ref( length );
+    for( int i = 0; i < length; ++i )
+        ref[ i ] = rand( );
+    bolt::cl::device_vector< int > source( ref.begin( ), ref.end( ) );
+    bolt::cl::device_vector< int > destination( length, 0 );
+
+    bolt::cl::detail::index_force_64( true );
+    bolt::cl::copy( source.begin( ) + 7, source.end( ), destination.begin( ) + 3 );
+    bolt::cl::detail::index_force_64( false );
+
+    std::vector< int > expected( length, 0 );
+    std::copy( ref.begin( ) + 7, ref.end( ), expected.begin( ) + 3 );
+    cmpArrays( expected, destination );
+}
+
 int main(int argc, char* argv[])
 {
     //  Register our minidump generating logic
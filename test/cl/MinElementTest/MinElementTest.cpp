@@ -29,6 +29,7 @@
 
 #include "bolt/cl/iterator/counting_iterator.h"
 #include "bolt/cl/min_element.h"
+#include "bolt/cl/max_element.h"
 #include "bolt/cl/functional.h"
 #include "bolt/cl/control.h"
 #include "stdafx.h"
@@ -461,6 +462,64 @@ TEST( MinEUDD , UDDPlusOperatorInts )
 
 }
 
+TEST( MinMaxElement, StdVectorWithTies )
+{
+    //  Few distinct values, so the first smallest and the last largest are checked as well
+    const int length = 100003;
+    std::vector< int > input( length );
+    for( int i = 0; i < length; ++i )
+        input[ i ] = rand( ) % 100;
+
+    std::pair< std::vector< int >::iterator, std::vector< int >::iterator > boltMinMax =
+        bolt::cl::minmax_element( input.begin( ), input.end( ) );
+
+    EXPECT_EQ( std::min_element( input.begin( ), input.end( ) ) - input.begin( ), boltMinMax.first - input.begin( ) );
+    std::vector< int >::reverse_iterator lastMax = std::max_element( input.rbegin( ), input.rend( ) );
+    EXPECT_EQ( input.rend( ) - lastMax - 1, boltMinMax.second - input.begin( ) );
+}
+
+TEST( MinMaxElement, DeviceVectorCpuRunModes )
+{
+    const int length = 65537;
+    std::vector< float > input( length );
+    for( int i = 0; i < length; ++i )
+        input[ i ] = static_cast< float >( rand( ) % 1000 ) - 500.0f;
+    bolt::cl::device_vector< float > dvInput( input.begin( ), input.end( ) );
+
+    int minIndex = static_cast< int >( std::min_element( input.begin( ), input.end( ) ) - input.begin( ) );
+    int firstMaxIndex = static_cast< int >( std::max_element( input.begin( ), input.end( ) ) - input.begin( ) );
+    int lastMaxIndex = static_cast< int >( input.rend( ) - std::max_element( input.rbegin( ), input.rend( ) ) - 1 );
+
+    std::vector< bolt::cl::control::e_RunMode > runModes;
+    runModes.push_back( bolt::cl::control::SerialCpu );
+#if defined( ENABLE_TBB )
+    runModes.push_back( bolt::cl::control::MultiCoreCpu );
+#endif
+    for( size_t m = 0; m < runModes.size( ); ++m )
+    {
+        bolt::cl::control ctl = bolt::cl::control::getDefault( );
+        ctl.setForceRunMode( runModes[ m ] );
+
+        bolt::cl::device_vector< float >::iterator boltMin =
+            bolt::cl::min_element( ctl, dvInput.begin( ), dvInput.end( ) );
+        bolt::cl::device_vector< float >::iterator boltMax =
+            bolt::cl::max_element( ctl, dvInput.begin( ), dvInput.end( ) );
+        std::pair< bolt::cl::device_vector< float >::iterator, bolt::cl::device_vector< float >::iterator >
+            boltMinMax = bolt::cl::minmax_element( ctl, dvInput.begin( ), dvInput.end( ) );
+
+        EXPECT_EQ( minIndex, boltMin - dvInput.begin( ) ) << _T( "Where mode = " ) << runModes[ m ];
+        EXPECT_EQ( firstMaxIndex, boltMax - dvInput.begin( ) ) << _T( "Where mode = " ) << runModes[ m ];
+        EXPECT_EQ( minIndex, boltMinMax.first - dvInput.begin( ) ) << _T( "Where mode = " ) << runModes[ m ];
+        EXPECT_EQ( lastMaxIndex, boltMinMax.second - dvInput.begin( ) ) << _T( "Where mode = " ) << runModes[ m ];
+    }
+
+    //  The OpenCL path, from the same device_vector
+    std::pair< bolt::cl::device_vector< float >::iterator, bolt::cl::device_vector< float >::iterator >
+        boltMinMax = bolt::cl::minmax_element( dvInput.begin( ), dvInput.end( ) );
+    EXPECT_EQ( minIndex, boltMinMax.first - dvInput.begin( ) );
+    EXPECT_EQ( lastMaxIndex, boltMinMax.second - dvInput.begin( ) );
+}
+
 INSTANTIATE_TYPED_TEST_CASE_P( Integer, MinEArrayTest, IntegerTests );
 INSTANTIATE_TYPED_TEST_CASE_P( Float, MinEArrayTest, FloatTests );
 
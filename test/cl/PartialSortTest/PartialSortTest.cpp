@@ -0,0 +1,309 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#include "common/stdafx.h"
+#include "common/myocl.h"
+
+#include <bolt/cl/partial_sort.h>
+#include <bolt/cl/device_vector.h>
+#include <bolt/miniDump.h>
+#include <bolt/unicode.h>
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <algorithm>
+
+//  Orders ints by their last three decimal digits only, so the radix select cannot be used
+BOLT_FUNCTOR(lessLastDigits,
+struct lessLastDigits
+{
+    bool operator()(const int &lhs, const int &rhs) const
+    {
+        return (lhs % 1000) < (rhs % 1000);
+    }
+};
+);
+
+//  Checks that result is an nth_element of input: the right element at nth, none greater before it, none less after
+//  it, and nothing lost
+template< typename T, typename StrictWeakOrdering >
+::testing::AssertionResult checkNthElement( std::vector< T > input, const std::vector< T >& result, size_t nth,
+                                            StrictWeakOrdering comp )
+{
+    std::sort( input.begin( ), input.end( ), comp );
+    EXPECT_EQ( input[ nth ], result[ nth ] );
+    for( size_t i = 0; i < result.size( ); ++i )
+    {
+        if( i < nth )
+            EXPECT_FALSE( comp( result[ nth ], result[ i ] ) ) << _T( "Where i = " ) << i;
+        else if( i > nth )
+            EXPECT_FALSE( comp( result[ i ], result[ nth ] ) ) << _T( "Where i = " ) << i;
+    }
+    std::vector< T > sortedResult( result );
+    std::sort( sortedResult.begin( ), sortedResult.end( ), comp );
+    EXPECT_TRUE( input == sortedResult );
+
+    return ::testing::AssertionSuccess( );
+}
+
+TEST( TopK, SmallestStdVector )
+{
+    const int length = 100003;
+    const size_t k = 100;
+    std::vector< int > input( length );
+    for( int i = 0; i < length; ++i )
+        input[ i ] = rand( ) - RAND_MAX / 2;
+    std::vector< int > unchanged( input );
+    std::vector< int > result( k );
+
+    std::vector< int >::iterator resultEnd = bolt::cl::top_k( input.begin( ), input.end( ), k, result.begin( ) );
+
+    std::vector< int > ref( input );
+    std::partial_sort( ref.begin( ), ref.begin( ) + k, ref.end( ) );
+    EXPECT_TRUE( resultEnd == result.end( ) );
+    EXPECT_TRUE( input == unchanged );
+    for( size_t i = 0; i < k; ++i )
+        EXPECT_EQ( ref[ i ], result[ i ] ) << _T( "Where i = " ) << i;
+}
+
+TEST( TopK, LargestDeviceVectorWithTies )
+{
+    //  Few distinct values, so the pivot has many copies and only some of them are kept
+    const int length = 65537;
+    const size_t k = 1000;
+    std::vector< float > input( length );
+    for( int i = 0; i < length; ++i )
+        input[ i ] = static_cast< float >( rand( ) % 50 ) - 10.5f;
+    bolt::cl::device_vector< float > dvInput( input.begin( ), input.end( ) );
+    bolt::cl::device_vector< float > dvResult( k );
+
+    bolt::cl::top_k( dvInput.begin( ), dvInput.end( ), k, dvResult.begin( ), bolt::cl::greater< float >( ) );
+
+    std::partial_sort( input.begin( ), input.begin( ) + k, input.end( ), std::greater< float >( ) );
+    for( size_t i = 0; i < k; ++i )
+        EXPECT_FLOAT_EQ( input[ i ], dvResult[ i ] ) << _T( "Where i = " ) << i;
+}
+
+//  The radix path writing to host memory, so the selected keys are sorted in a buffer over the caller's vector;
+//  the keys are distinct, so every one of the k - 1 keys before the pivot goes through that sort
+TEST( TopK, HostResultRadixSort )
+{
+    const int length = 70001;
+    const size_t k = 777;
+    std::vector< int > input( length );
+    for( int i = 0; i < length; ++i )
+        input[ i ] = ( i * 7919 ) % length - length / 2;
+    bolt::cl::device_vector< int > dvInput( input.begin( ), input.end( ) );
+    std::vector< int > result( k );
+    std::vector< int > dvToHostResult( k );
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::OpenCL );
+    bolt::cl::top_k( ctl, input.begin( ), input.end( ), k, result.begin( ) );
+    bolt::cl::top_k( ctl, dvInput.begin( ), dvInput.end( ), k, dvToHostResult.begin( ) );
+
+    std::partial_sort( input.begin( ), input.begin( ) + k, input.end( ) );
+    for( size_t i = 0; i < k; ++i )
+    {
+        EXPECT_EQ( input[ i ], result[ i ] ) << _T( "Where i = " ) << i;
+        EXPECT_EQ( input[ i ], dvToHostResult[ i ] ) << _T( "Where i = " ) << i;
+    }
+}
+
+TEST( TopK, KPastTheEnd )
+{
+    std::vector< int > input( 300 );
+    for( size_t i = 0; i < input.size( ); ++i )
+        input[ i ] = rand( );
+    std::vector< int > result( 500, -1 );
+
+    std::vector< int >::iterator resultEnd = bolt::cl::top_k( input.begin( ), input.end( ), 500, result.begin( ) );
+
+    std::sort( input.begin( ), input.end( ) );
+    EXPECT_TRUE( resultEnd == result.begin( ) + input.size( ) );
+    for( size_t i = 0; i < input.size( ); ++i )
+        EXPECT_EQ( input[ i ], result[ i ] ) << _T( "Where i = " ) << i;
+    EXPECT_EQ( -1, result[ input.size( ) ] );
+}
+
+TEST( NthElement, DeviceVectorSubRange )
+{
+    const int length = 40000;
+    const int offset = 31;
+    const size_t nth = 12345;
+    std::vector< int > input( length );
+    for( int i = 0; i < length; ++i )
+        input[ i ] = rand( ) % 5000;
+    bolt::cl::device_vector< int > dvInput( input.begin( ), input.end( ) );
+
+    bolt::cl::nth_element( dvInput.begin( ) + offset, dvInput.begin( ) + offset + nth, dvInput.end( ) - offset );
+
+    std::vector< int > range( input.begin( ) + offset, input.end( ) - offset );
+    std::vector< int > result( range.size( ) );
+    for( size_t i = 0; i < range.size( ); ++i )
+        result[ i ] = dvInput[ offset + i ];
+    checkNthElement( range, result, nth, std::less< int >( ) );
+    for( int i = 0; i < offset; ++i )
+    {
+        EXPECT_EQ( input[ i ], dvInput[ i ] ) << _T( "Where i = " ) << i;
+        EXPECT_EQ( input[ length - 1 - i ], dvInput[ length - 1 - i ] ) << _T( "Where i = " ) << length - 1 - i;
+    }
+}
+
+TEST( PartialSort, UnsignedStdVector )
+{
+    const int length = 70001;
+    const int k = 777;
+    std::vector< unsigned int > input( length );
+    for( int i = 0; i < length; ++i )
+        input[ i ] = static_cast< unsigned int >( rand( ) ) * 7919u;
+    std::vector< unsigned int > ref( input );
+
+    bolt::cl::partial_sort( input.begin( ), input.begin( ) + k, input.end( ) );
+
+    std::sort( ref.begin( ), ref.end( ) );
+    for( int i = 0; i < k; ++i )
+        EXPECT_EQ( ref[ i ], input[ i ] ) << _T( "Where i = " ) << i;
+    std::sort( input.begin( ), input.end( ) );
+    EXPECT_TRUE( ref == input );
+}
+
+TEST( PartialSort, CustomComparator )
+{
+    //  Not radix selectable; the whole range is sorted instead
+    const int length = 5000;
+    const int k = 50;
+    std::vector< int > input( length );
+    for( int i = 0; i < length; ++i )
+        input[ i ] = rand( );
+    std::vector< int > ref( input );
+
+    bolt::cl::partial_sort( input.begin( ), input.begin( ) + k, input.end( ), lessLastDigits( ) );
+
+    std::sort( ref.begin( ), ref.end( ), lessLastDigits( ) );
+    for( int i = 0; i < k; ++i )
+        EXPECT_EQ( ref[ i ] % 1000, input[ i ] % 1000 ) << _T( "Where i = " ) << i;
+}
+
+TEST( PartialSortSerialCpu, TopKAndNthElement )
+{
+    const int length = 10000;
+    std::vector< int > input( length );
+    for( int i = 0; i < length; ++i )
+        input[ i ] = rand( );
+    std::vector< int > result( 10 );
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::SerialCpu );
+    bolt::cl::top_k( ctl, input.begin( ), input.end( ), 10, result.begin( ), bolt::cl::greater< int >( ) );
+
+    std::vector< int > nth( input );
+    bolt::cl::nth_element( ctl, nth.begin( ), nth.begin( ) + length / 2, nth.end( ) );
+    checkNthElement( input, nth, length / 2, std::less< int >( ) );
+
+    std::sort( input.begin( ), input.end( ), std::greater< int >( ) );
+    for( int i = 0; i < 10; ++i )
+        EXPECT_EQ( input[ i ], result[ i ] ) << _T( "Where i = " ) << i;
+}
+
+#if defined( ENABLE_TBB )
+TEST( PartialSortMultiCore, TopKDeviceVector )
+{
+    //  Enough chunks for the candidates of every chunk to be selected from
+    const int length = 500001;
+    const size_t k = 64;
+    std::vector< int > input( length );
+    for( int i = 0; i < length; ++i )
+        input[ i ] = rand( ) % 100000;
+    bolt::cl::device_vector< int > dvInput( input.begin( ), input.end( ) );
+    bolt::cl::device_vector< int > dvResult( k );
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+    bolt::cl::top_k( ctl, dvInput.begin( ), dvInput.end( ), k, dvResult.begin( ) );
+
+    std::partial_sort( input.begin( ), input.begin( ) + k, input.end( ) );
+    for( size_t i = 0; i < k; ++i )
+        EXPECT_EQ( input[ i ], dvResult[ i ] ) << _T( "Where i = " ) << i;
+}
+
+TEST( PartialSortMultiCore, PartialSortAndNthElement )
+{
+    const int length = 500001;
+    const int k = 100;
+    std::vector< int > input( length );
+    for( int i = 0; i < length; ++i )
+        input[ i ] = rand( ) % 3000;
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+
+    std::vector< int > partial( input );
+    bolt::cl::partial_sort( ctl, partial.begin( ), partial.begin( ) + k, partial.end( ), bolt::cl::greater< int >( ) );
+    std::vector< int > ref( input );
+    std::sort( ref.begin( ), ref.end( ), std::greater< int >( ) );
+    for( int i = 0; i < k; ++i )
+        EXPECT_EQ( ref[ i ], partial[ i ] ) << _T( "Where i = " ) << i;
+
+    //  A small rank goes through the parallel partition, the median through std::nth_element
+    std::vector< int > nth( input );
+    bolt::cl::nth_element( ctl, nth.begin( ), nth.begin( ) + k, nth.end( ) );
+    checkNthElement( input, nth, k, std::less< int >( ) );
+
+    std::vector< int > median( input );
+    bolt::cl::nth_element( ctl, median.begin( ), median.begin( ) + length / 2, median.end( ) );
+    checkNthElement( input, median, length / 2, std::less< int >( ) );
+}
+#endif
+
+int main(int argc, char* argv[])
+{
+    ::testing::InitGoogleTest( &argc, &argv[ 0 ] );
+
+    //  Register our minidump generating logic
+    bolt::miniDumpSingleton::enableMiniDumps( );
+
+    int retVal = RUN_ALL_TESTS( );
+
+    //  Reflection code to inspect how many tests failed in gTest
+    ::testing::UnitTest& unitTest = *::testing::UnitTest::GetInstance( );
+
+    unsigned int failedTests = 0;
+    for( int i = 0; i < unitTest.total_test_case_count( ); ++i )
+    {
+        const ::testing::TestCase& testCase = *unitTest.GetTestCase( i );
+        for( int j = 0; j < testCase.total_test_count( ); ++j )
+        {
+            const ::testing::TestInfo& testInfo = *testCase.GetTestInfo( j );
+            if( testInfo.result( )->Failed( ) )
+                ++failedTests;
+        }
+    }
+
+    //  Print helpful message at termination if we detect errors, to help users figure out what to do next
+    if( failedTests )
+    {
+        bolt::tout << _T( "\nFailed tests detected in test pass; please run test again with:" ) << std::endl;
+        bolt::tout << _T( "\t--gtest_filter=<XXX> to select a specific failing test of interest" ) << std::endl;
+        bolt::tout << _T( "\t--gtest_catch_exceptions=0 to generate minidump of failing test, or" ) << std::endl;
+        bolt::tout << _T( "\t--gtest_break_on_failure to debug interactively with debugger" ) << std::endl;
+        bolt::tout << _T( "\t    (only on googletest assertion failures, not SEH exceptions)" ) << std::endl;
+    }
+    std::cout << "Test Completed. Press Enter to exit.\n .... ";
+    getchar();
+    return retVal;
+}
@@ -430,8 +430,117 @@ TEST(ReduceByKeyBasic, IntegerTestOddSizes)
     
 }
 
+TEST(ReduceByKeyBasic, SegmentCountAcrossWorkGroups)
+{
+    //  From one key per segment up to segments that span work groups; the end of the output must match the number of
+    //  segments counted on the device
+    for( int segmentLength = 1; segmentLength <= 1000; segmentLength = segmentLength * 4 + 3 )
+    {
+        int length = 100000 + segmentLength;
+        std::vector< int > keys( length );
+        std::vector< int > input( length );
+        for( int i = 0; i < length; i++ )
+        {
+            keys[ i ] = i / segmentLength;
+            input[ i ] = std::rand( ) % 4;
+        }
+        int numSegments = keys[ length - 1 ] + 1;
+
+        std::vector< int > koutput( length, -1 );
+        std::vector< int > voutput( length, -1 );
+        std::vector< int > krefOutput( length, -1 );
+        std::vector< int > vrefOutput( length, -1 );
+
+        auto p = bolt::cl::reduce_by_key( keys.begin( ), keys.end( ), input.begin( ), koutput.begin( ),
+                                          voutput.begin( ) );
+        gold_reduce_by_key( keys.begin( ), keys.end( ), input.begin( ), krefOutput.begin( ), vrefOutput.begin( ),
+                            std::plus< int >( ) );
+
+        EXPECT_EQ( numSegments, p.first - koutput.begin( ) );
+        EXPECT_EQ( numSegments, p.second - voutput.begin( ) );
+        cmpArrays( krefOutput, koutput );
+        cmpArrays( vrefOutput, voutput );
+    }
+}
+
+
+
+
+//  The kernels built with 64 bit indices, and 64 bit segment counts, on a range small enough for 32
+TEST(ReduceByKeyBasic, WideIndexKernels)
+{
+    int length = 100003;
+    std::vector< int > keys( length );
+    std::vector< int > input( length );
+    for( int i = 0; i < length; i++ )
+    {
+        keys[ i ] = i / 37;
+        input[ i ] = std::rand( ) % 4;
+    }
+    int numSegments = keys[ length - 1 ] + 1;
+
+    std::vector< int > koutput( length, -1 );
+    std::vector< int > voutput( length, -1 );
+    std::vector< int > krefOutput( length, -1 );
+    std::vector< int > vrefOutput( length, -1 );
+
+    bolt::cl::detail::index_force_64( true );
+    auto p = bolt::cl::reduce_by_key( keys.begin( ), keys.end( ), input.begin( ), koutput.begin( ),
+                                      voutput.begin( ) );
+    bolt::cl::detail::index_force_64( false );
+    gold_reduce_by_key( keys.begin( ), keys.end( ), input.begin( ), krefOutput.begin( ), vrefOutput.begin( ),
+                        std::plus< int >( ) );
+
+    EXPECT_EQ( numSegments, p.first - koutput.begin( ) );
+    EXPECT_EQ( numSegments, p.second - voutput.begin( ) );
+    cmpArrays( krefOutput, koutput );
+    cmpArrays( vrefOutput, voutput );
+}
 
+TEST(ReduceByKeyCpu, DeviceVectorSerialAndMultiCore)
+{
+    //  Segments from one key up to several TBB chunks long, so segments cross chunk boundaries
+    int length = 300007;
+    std::vector< int > keys( length );
+    std::vector< int > input( length );
+    int key = 0;
+    for( int i = 0; i < length; i++ )
+    {
+        if( std::rand( ) % ( ( i / 50000 ) % 2 ? 20000 : 3 ) == 0 )
+            key++;
+        keys[ i ] = key;
+        input[ i ] = std::rand( ) % 4;
+    }
+    std::vector< int > krefOutput( length, -1 );
+    std::vector< int > vrefOutput( length, -1 );
+    gold_reduce_by_key( keys.begin( ), keys.end( ), input.begin( ), krefOutput.begin( ), vrefOutput.begin( ),
+                        std::plus< int >( ) );
+    int numSegments = keys[ length - 1 ] + 1;
+
+    bolt::cl::control::e_RunMode runModes[] = { bolt::cl::control::SerialCpu, bolt::cl::control::MultiCoreCpu };
+    for( int m = 0; m < 2; m++ )
+    {
+#if !defined( ENABLE_TBB )
+        if( runModes[ m ] == bolt::cl::control::MultiCoreCpu )
+            continue;
+#endif
+        bolt::cl::control ctl = bolt::cl::control::getDefault( );
+        ctl.setForceRunMode( runModes[ m ] );
+
+        bolt::cl::device_vector< int > dvKeys( keys.begin( ), keys.end( ) );
+        bolt::cl::device_vector< int > dvInput( input.begin( ), input.end( ) );
+        bolt::cl::device_vector< int > dvKOutput( length, -1 );
+        bolt::cl::device_vector< int > dvVOutput( length, -1 );
 
+        auto p = bolt::cl::reduce_by_key( ctl, dvKeys.begin( ), dvKeys.end( ), dvInput.begin( ), dvKOutput.begin( ),
+                                          dvVOutput.begin( ), bolt::cl::equal_to< int >( ), bolt::cl::plus< int >( ) );
+
+        EXPECT_EQ( numSegments, p.first - dvKOutput.begin( ) );
+        EXPECT_EQ( numSegments, p.second - dvVOutput.begin( ) );
+        cmpArrays( krefOutput, dvKOutput );
+        cmpArrays( vrefOutput, dvVOutput );
+    }
+}
 
 BOLT_FUNCTOR(uddfltint,
 struct uddfltint
@@ -22,6 +22,7 @@
 #include "stdafx.h"
 #include <bolt/cl/iterator/counting_iterator.h>
 #include <bolt/cl/reduce.h>
+#include <bolt/cl/reduce_multi.h>
 #include <bolt/cl/functional.h>
 #include <bolt/cl/control.h>
 
@@ -1056,6 +1057,216 @@ TEST( ReduceUDD , UDDPlusOperatorInts )
 }
 
 
+//  Several results left on the device, then read back together
+TEST( ReduceInto, DeviceVectorResults )
+{
+    const int length = 100003;
+    std::vector< int > refInput( length );
+    for( int i = 0; i < length; ++i )
+        refInput[ i ] = rand( ) % 1000 - 500;
+    bolt::cl::device_vector< int > input( refInput.begin( ), refInput.end( ) );
+    bolt::cl::device_vector< int > results( 4, 0 );
+
+    bolt::cl::reduce_into( input.begin( ), input.end( ), results.begin( ) + 1, 7, bolt::cl::plus< int >( ) );
+    bolt::cl::reduce_into( input.begin( ), input.end( ), results.begin( ) + 2, -1000, bolt::cl::maximum< int >( ) );
+    bolt::cl::reduce_into( refInput.begin( ), refInput.end( ), results.begin( ) + 3, 1000, bolt::cl::minimum< int >( ) );
+
+    EXPECT_EQ( 0, results[ 0 ] );
+    EXPECT_EQ( std::accumulate( refInput.begin( ), refInput.end( ), 7 ), results[ 1 ] );
+    EXPECT_EQ( *std::max_element( refInput.begin( ), refInput.end( ) ), results[ 2 ] );
+    EXPECT_EQ( *std::min_element( refInput.begin( ), refInput.end( ) ), results[ 3 ] );
+
+    //  A host result and the CPU run modes reduce and store the value
+    int hostResult = 0;
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::SerialCpu );
+    bolt::cl::reduce_into( ctl, input.begin( ), input.end( ), &hostResult, 0, bolt::cl::plus< int >( ) );
+    bolt::cl::reduce_into( ctl, input.begin( ), input.end( ), results.begin( ), 0, bolt::cl::plus< int >( ) );
+    EXPECT_EQ( std::accumulate( refInput.begin( ), refInput.end( ), 0 ), hostResult );
+    EXPECT_EQ( hostResult, results[ 0 ] );
+}
+
+//  The vectorized reduction of built-in types: misaligned sub-ranges, lengths around whole vectors and unrolled loads
+TEST( ReduceVector, BuiltInOperators )
+{
+    const int lengths[] = { 1, 3, 4, 5, 1023, 65537, ( 1 << 20 ) + 3 };
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setUnroll( 4 );
+
+    for( int l = 0; l < sizeof( lengths ) / sizeof( lengths[ 0 ] ); ++l )
+    {
+        const int length = lengths[ l ];
+        std::vector< int > refInt( length + 2 );
+        std::vector< unsigned int > refUint( length + 2 );
+        std::vector< float > refFloat( length + 2 );
+        for( int i = 0; i < length + 2; ++i )
+        {
+            refInt[ i ] = rand( ) % 2001 - 1000;
+            refUint[ i ] = 2u * static_cast< unsigned int >( rand( ) ) + 1u;
+            refFloat[ i ] = static_cast< float >( rand( ) % 1000 ) - 500.5f;
+        }
+        bolt::cl::device_vector< int > dvInt( refInt.begin( ), refInt.end( ) );
+        bolt::cl::device_vector< unsigned int > dvUint( refUint.begin( ), refUint.end( ) );
+        bolt::cl::device_vector< float > dvFloat( refFloat.begin( ), refFloat.end( ) );
+
+        //  Skip the first element, so the vectors start off their natural alignment
+        EXPECT_EQ( std::accumulate( refInt.begin( ) + 1, refInt.end( ) - 1, 5 ),
+            bolt::cl::reduce( ctl, dvInt.begin( ) + 1, dvInt.end( ) - 1, 5, bolt::cl::plus< int >( ) ) )
+            << "Where length = " << length;
+        EXPECT_EQ( *std::max_element( refInt.begin( ) + 1, refInt.end( ) - 1 ),
+            bolt::cl::reduce( ctl, dvInt.begin( ) + 1, dvInt.end( ) - 1, -5000, bolt::cl::maximum< int >( ) ) )
+            << "Where length = " << length;
+        EXPECT_EQ( std::accumulate( refUint.begin( ) + 1, refUint.end( ) - 1, 1u, std::multiplies< unsigned int >( ) ),
+            bolt::cl::reduce( ctl, dvUint.begin( ) + 1, dvUint.end( ) - 1, 1u, bolt::cl::multiplies< unsigned int >( ) ) )
+            << "Where length = " << length;
+        EXPECT_FLOAT_EQ( *std::min_element( refFloat.begin( ) + 1, refFloat.end( ) - 1 ),
+            bolt::cl::reduce( ctl, dvFloat.begin( ) + 1, dvFloat.end( ) - 1, 1.0e9f, bolt::cl::minimum< float >( ) ) )
+            << "Where length = " << length;
+    }
+}
+
+//  Infinities pass through the vectorized maximum and minimum, whose unused lanes hold the identity
+TEST( ReduceVector, Infinities )
+{
+    const int length = 1027;
+    const float infinity = std::numeric_limits< float >::infinity( );
+    bolt::cl::device_vector< float > dvNegative( length, -infinity );
+    bolt::cl::device_vector< float > dvPositive( length, infinity );
+
+    EXPECT_EQ( -infinity, bolt::cl::reduce( dvNegative.begin( ), dvNegative.end( ), -infinity,
+        bolt::cl::maximum< float >( ) ) );
+    EXPECT_EQ( infinity, bolt::cl::reduce( dvPositive.begin( ), dvPositive.end( ), infinity,
+        bolt::cl::minimum< float >( ) ) );
+}
+
+//  Builds and runs the vectorized first stage of one value type with each of its operators
+template< typename T >
+void checkReduceVectorOperators( const std::vector< T >& ref )
+{
+    bolt::cl::device_vector< T > dvInput( ref.begin( ), ref.end( ) );
+
+    EXPECT_EQ( std::accumulate( ref.begin( ), ref.end( ), T( 3 ) ),
+        bolt::cl::reduce( dvInput.begin( ), dvInput.end( ), T( 3 ), bolt::cl::plus< T >( ) ) );
+    EXPECT_EQ( std::accumulate( ref.begin( ), ref.end( ), T( 1 ), std::multiplies< T >( ) ),
+        bolt::cl::reduce( dvInput.begin( ), dvInput.end( ), T( 1 ), bolt::cl::multiplies< T >( ) ) );
+    EXPECT_EQ( *std::max_element( ref.begin( ), ref.end( ) ),
+        bolt::cl::reduce( dvInput.begin( ), dvInput.end( ), T( 0 ), bolt::cl::maximum< T >( ) ) );
+    EXPECT_EQ( *std::min_element( ref.begin( ), ref.end( ) ),
+        bolt::cl::reduce( dvInput.begin( ), dvInput.end( ), T( 100 ), bolt::cl::minimum< T >( ) ) );
+}
+
+//  Every value type and operator reduce_vector_enabled accepts instantiates reduceVector with its own vector type
+TEST( ReduceVector, EveryTypeAndOperator )
+{
+    //  Small values, and a run of ones, so the products stay exact in every type
+    const int length = 4099;
+    std::vector< int > refInt( length, 1 );
+    std::vector< unsigned int > refUint( length, 1u );
+    std::vector< float > refFloat( length, 1.0f );
+    for( int i = 0; i < length; i += 409 )
+    {
+        refInt[ i ] = rand( ) % 3 + 1;
+        refUint[ i ] = static_cast< unsigned int >( rand( ) % 3 + 1 );
+        refFloat[ i ] = static_cast< float >( rand( ) % 3 + 1 );
+    }
+
+    checkReduceVectorOperators( refInt );
+    checkReduceVectorOperators( refUint );
+    checkReduceVectorOperators( refFloat );
+}
+
+//  The kernels built with 64 bit indices, on a range small enough for 32; vectorized from an offset, and generic
+TEST( ReduceVector, WideIndexKernels )
+{
+    const int length = 100003;
+    std::vector< int > refInt( length );
+    std::vector< float > refFloat( length );
+    for( int i = 0; i < length; ++i )
+    {
+        refInt[ i ] = rand( ) % 2001 - 1000;
+        refFloat[ i ] = static_cast< float >( rand( ) % 1000 );
+    }
+    bolt::cl::device_vector< int > dvInt( refInt.begin( ), refInt.end( ) );
+
+    bolt::cl::detail::index_force_64( true );
+    int boltSum = bolt::cl::reduce( dvInt.begin( ) + 5, dvInt.end( ), 0, bolt::cl::plus< int >( ) );
+    float boltMax = bolt::cl::reduce( refFloat.begin( ), refFloat.end( ), -1.0f, bolt::cl::maximum< float >( ) );
+    bolt::cl::detail::index_force_64( false );
+
+    EXPECT_EQ( std::accumulate( refInt.begin( ) + 5, refInt.end( ), 0 ), boltSum );
+    EXPECT_FLOAT_EQ( *std::max_element( refFloat.begin( ), refFloat.end( ) ), boltMax );
+}
+
+TEST( ReduceMulti, SumMinMaxSumOfSquares )
+{
+    //  Values within +-100, so that even the largest sum of squares, 100003 * 100 * 100, fits an int
+    const int length = 100003;
+    std::vector< int > ref( length );
+    for( int i = 0; i < length; ++i )
+        ref[ i ] = rand( ) % 201 - 100;
+    bolt::cl::device_vector< int > dvInput( ref.begin( ), ref.end( ) );
+
+    int sum = std::accumulate( ref.begin( ), ref.end( ), 0 );
+    int minimum = *std::min_element( ref.begin( ), ref.end( ) );
+    int maximum = *std::max_element( ref.begin( ), ref.end( ) );
+    int sumOfSquares = std::inner_product( ref.begin( ), ref.end( ), ref.begin( ), 0 );
+
+    bolt::cl::control::e_RunMode runModes[] = { bolt::cl::control::OpenCL, bolt::cl::control::SerialCpu,
+        bolt::cl::control::MultiCoreCpu };
+    for( int m = 0; m < sizeof( runModes ) / sizeof( runModes[ 0 ] ); ++m )
+    {
+#if !defined( ENABLE_TBB )
+        if( runModes[ m ] == bolt::cl::control::MultiCoreCpu )
+            continue;
+#endif
+        bolt::cl::control ctl = bolt::cl::control::getDefault( );
+        ctl.setForceRunMode( runModes[ m ] );
+
+        std::tuple< int, int, int, int > stats = bolt::cl::reduce_multi( ctl, dvInput.begin( ), dvInput.end( ),
+            bolt::cl::make_reduction( bolt::cl::identity< int >( ), 0, bolt::cl::plus< int >( ) ),
+            bolt::cl::make_reduction( bolt::cl::identity< int >( ), 5000, bolt::cl::minimum< int >( ) ),
+            bolt::cl::make_reduction( bolt::cl::identity< int >( ), -5000, bolt::cl::maximum< int >( ) ),
+            bolt::cl::make_reduction( bolt::cl::square< int >( ), 0, bolt::cl::plus< int >( ) ) );
+        EXPECT_EQ( sum, std::get< 0 >( stats ) ) << "Where runMode = " << runModes[ m ];
+        EXPECT_EQ( minimum, std::get< 1 >( stats ) ) << "Where runMode = " << runModes[ m ];
+        EXPECT_EQ( maximum, std::get< 2 >( stats ) ) << "Where runMode = " << runModes[ m ];
+        EXPECT_EQ( sumOfSquares, std::get< 3 >( stats ) ) << "Where runMode = " << runModes[ m ];
+
+        //  Fewer reductions, of mixed value types, over a host vector
+        std::tuple< float, int > mixed = bolt::cl::reduce_multi( ctl, ref.begin( ), ref.end( ),
+            bolt::cl::make_reduction( bolt::cl::identity< float >( ), 0.0f, bolt::cl::maximum< float >( ) ),
+            bolt::cl::make_reduction( bolt::cl::negate< int >( ), 7, bolt::cl::plus< int >( ) ) );
+        EXPECT_FLOAT_EQ( static_cast< float >( maximum ), std::get< 0 >( mixed ) ) << "Where runMode = " << runModes[ m ];
+        EXPECT_EQ( 7 - sum, std::get< 1 >( mixed ) ) << "Where runMode = " << runModes[ m ];
+    }
+}
+
+//  Lengths that leave the last work group part full, and fewer elements than one work group
+TEST( ReduceMulti, ShortLengths )
+{
+    const int lengths[] = { 1, 5, 63, 65, 100, 1000 };
+    for( int l = 0; l < sizeof( lengths ) / sizeof( lengths[ 0 ] ); ++l )
+    {
+        std::vector< int > ref( lengths[ l ] );
+        for( int i = 0; i < lengths[ l ]; ++i )
+            ref[ i ] = rand( ) % 201 - 100;
+        bolt::cl::device_vector< int > dvInput( ref.begin( ), ref.end( ) );
+
+        bolt::cl::control ctl = bolt::cl::control::getDefault( );
+        ctl.setForceRunMode( bolt::cl::control::OpenCL );
+        std::tuple< int, int, int > stats = bolt::cl::reduce_multi( ctl, dvInput.begin( ), dvInput.end( ),
+            bolt::cl::make_reduction( bolt::cl::identity< int >( ), 0, bolt::cl::plus< int >( ) ),
+            bolt::cl::make_reduction( bolt::cl::identity< int >( ), 5000, bolt::cl::minimum< int >( ) ),
+            bolt::cl::make_reduction( bolt::cl::identity< int >( ), -5000, bolt::cl::maximum< int >( ) ) );
+        EXPECT_EQ( std::accumulate( ref.begin( ), ref.end( ), 0 ), std::get< 0 >( stats ) )
+            << "Where length = " << lengths[ l ];
+        EXPECT_EQ( *std::min_element( ref.begin( ), ref.end( ) ), std::get< 1 >( stats ) )
+            << "Where length = " << lengths[ l ];
+        EXPECT_EQ( *std::max_element( ref.begin( ), ref.end( ) ), std::get< 2 >( stats ) )
+            << "Where length = " << lengths[ l ];
+    }
+}
+
 //  Temporarily disabling this test because we have a known issue running on the CPU device with our 
 //  Bolt iterators
 TEST( Reduceint , DISABLED_KcacheTest )
@@ -22,6 +22,7 @@
 //#include "bolt/cl/scan.h"
 #include "bolt/cl/functional.h"
 #include "bolt/cl/scan_by_key.h"
+#include "bolt/cl/scan_stream.h"
 #include "bolt/unicode.h"
 #include "bolt/miniDump.h"
 
@@ -1233,6 +1234,181 @@ TEST(ExclusiveScanByKey, CLscanbykeyExclUDD)
 // paste from above
 #endif
 
+//  Many tiles of the single pass scan by key: segments longer than several tiles, so the look-back walks over tiles
+//  without a head, and short ones, so it stops at a head before reaching a tile with its prefix
+TEST(ScanByKey, ManyTilesLookback)
+{
+    const int length = 1024 * 400 + 13;
+    std::vector< int > keys( length ), values( length );
+    int key = 0;
+    for( int i = 0; i < length; ++i )
+    {
+        if( ( i < length / 2 ) ? ( rand( ) % 5000 == 0 ) : ( rand( ) % 50 == 0 ) )
+            ++key;
+        keys[ i ] = key;
+        values[ i ] = rand( ) % 10 - 4;
+    }
+    bolt::cl::device_vector< int > dvKeys( keys.begin( ), keys.end( ) );
+    bolt::cl::device_vector< int > dvValues( values.begin( ), values.end( ) );
+    bolt::cl::device_vector< int > dvInclusive( length );
+    bolt::cl::device_vector< int > dvExclusive( length );
+
+    bolt::cl::inclusive_scan_by_key( dvKeys.begin( ), dvKeys.end( ), dvValues.begin( ), dvInclusive.begin( ) );
+    bolt::cl::exclusive_scan_by_key( dvKeys.begin( ), dvKeys.end( ), dvValues.begin( ), dvExclusive.begin( ), 2 );
+
+    std::vector< int > refInclusive( length ), refExclusive( length );
+    int sum = 0, exclusiveSum = 2;
+    for( int i = 0; i < length; ++i )
+    {
+        if( i == 0 || keys[ i ] != keys[ i - 1 ] )
+        {
+            sum = 0;
+            exclusiveSum = 2;
+        }
+        sum += values[ i ];
+        refInclusive[ i ] = sum;
+        refExclusive[ i ] = exclusiveSum;
+        exclusiveSum += values[ i ];
+    }
+    cmpArrays( refInclusive, dvInclusive );
+    cmpArrays( refExclusive, dvExclusive );
+}
+
+//  The kernels built with 64 bit indices, on a range small enough for 32
+TEST(ScanByKey, WideIndexKernels)
+{
+    const int length = 256 * 200 + 11;
+    std::vector< int > keys( length ), values( length );
+    int key = 0;
+    for( int i = 0; i < length; ++i )
+    {
+        if( rand( ) % 500 == 0 )
+            ++key;
+        keys[ i ] = key;
+        values[ i ] = rand( ) % 10 - 4;
+    }
+    bolt::cl::device_vector< int > dvKeys( keys.begin( ), keys.end( ) );
+    bolt::cl::device_vector< int > dvValues( values.begin( ), values.end( ) );
+    bolt::cl::device_vector< int > dvInclusive( length );
+    bolt::cl::device_vector< int > dvExclusive( length );
+
+    bolt::cl::detail::index_force_64( true );
+    bolt::cl::inclusive_scan_by_key( dvKeys.begin( ), dvKeys.end( ), dvValues.begin( ), dvInclusive.begin( ) );
+    bolt::cl::exclusive_scan_by_key( dvKeys.begin( ), dvKeys.end( ), dvValues.begin( ), dvExclusive.begin( ), 3 );
+    bolt::cl::detail::index_force_64( false );
+
+    std::vector< int > refInclusive( length ), refExclusive( length );
+    int sum = 0, exclusiveSum = 3;
+    for( int i = 0; i < length; ++i )
+    {
+        if( i == 0 || keys[ i ] != keys[ i - 1 ] )
+        {
+            sum = 0;
+            exclusiveSum = 3;
+        }
+        sum += values[ i ];
+        refInclusive[ i ] = sum;
+        refExclusive[ i ] = exclusiveSum;
+        exclusiveSum += values[ i ];
+    }
+    cmpArrays( refInclusive, dvInclusive );
+    cmpArrays( refExclusive, dvExclusive );
+}
+
+//  Segments running across chunk boundaries, or starting right at one
+TEST(ScanByKeyStream, SegmentsAcrossChunks)
+{
+    const int chunkSizes[ 3 ] = { 70001, 512, 3000 };
+    bolt::cl::scan_by_key_stream< int, int > running;
+    bolt::cl::scan_by_key_stream< int, int > exclusiveRunning( false, 1 );
+
+    int key = 0, sum = 0, exclusiveSum = 1, prevKey = -1;
+    for( int c = 0; c < 3; ++c )
+    {
+        std::vector< int > keys( chunkSizes[ c ] ), values( chunkSizes[ c ] );
+        for( size_t i = 0; i < keys.size( ); ++i )
+        {
+            if( rand( ) % 300 == 0 )
+                ++key;
+            keys[ i ] = key;
+            values[ i ] = rand( ) % 10;
+        }
+        if( c == 2 )
+            keys[ 0 ] = ++key;
+        bolt::cl::device_vector< int > dvKeys( keys.begin( ), keys.end( ) );
+        bolt::cl::device_vector< int > dvValues( values.begin( ), values.end( ) );
+        bolt::cl::device_vector< int > dvOutput( keys.size( ) );
+        std::vector< int > exclusiveOutput( keys.size( ) );
+
+        running( dvKeys.begin( ), dvKeys.end( ), dvValues.begin( ), dvOutput.begin( ) );
+        exclusiveRunning( keys.begin( ), keys.end( ), values.begin( ), exclusiveOutput.begin( ) );
+
+        std::vector< int > refOutput( keys.size( ) ), refExclusive( keys.size( ) );
+        for( size_t i = 0; i < keys.size( ); ++i )
+        {
+            if( keys[ i ] != prevKey )
+            {
+                sum = 0;
+                exclusiveSum = 1;
+            }
+            sum += values[ i ];
+            refOutput[ i ] = sum;
+            refExclusive[ i ] = exclusiveSum;
+            exclusiveSum += values[ i ];
+            prevKey = keys[ i ];
+        }
+        cmpArrays( refOutput, dvOutput );
+        cmpArrays( refExclusive, exclusiveOutput );
+    }
+    EXPECT_EQ( sum, running.carry( ) );
+    EXPECT_EQ( exclusiveSum, exclusiveRunning.carry( ) );
+}
+
+//  The MultiCoreCpu path scans each chunk in parallel from the carry, and matches the SerialCpu path
+TEST(ScanByKeyStream, MultiCoreMatchesSerial)
+{
+    const int chunkSizes[ 3 ] = { 100003, 1, 40000 };
+    bolt::cl::control serialCtl = bolt::cl::control::getDefault( );
+    serialCtl.setForceRunMode( bolt::cl::control::SerialCpu );
+    bolt::cl::control multiCoreCtl = bolt::cl::control::getDefault( );
+    multiCoreCtl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+    multiCoreCtl.setTbbPartitioner( bolt::cl::control::SimplePartitioner, 1000 );
+
+    for( int inclusive = 0; inclusive < 2; ++inclusive )
+    {
+        bolt::cl::scan_by_key_stream< int, int > serialKeyed( serialCtl, inclusive != 0, 2 );
+        bolt::cl::scan_by_key_stream< int, int > multiCoreKeyed( multiCoreCtl, inclusive != 0, 2 );
+        bolt::cl::scan_stream< int > serialRunning( serialCtl, inclusive != 0, 2 );
+        bolt::cl::scan_stream< int > multiCoreRunning( multiCoreCtl, inclusive != 0, 2 );
+
+        int key = 0;
+        for( int c = 0; c < 3; ++c )
+        {
+            std::vector< int > keys( chunkSizes[ c ] ), values( chunkSizes[ c ] );
+            for( size_t i = 0; i < keys.size( ); ++i )
+            {
+                if( rand( ) % 3000 == 0 )
+                    ++key;
+                keys[ i ] = key;
+                values[ i ] = rand( ) % 10 - 4;
+            }
+            std::vector< int > serialOutput( keys.size( ) ), multiCoreOutput( keys.size( ) );
+
+            serialKeyed( keys.begin( ), keys.end( ), values.begin( ), serialOutput.begin( ) );
+            multiCoreKeyed( keys.begin( ), keys.end( ), values.begin( ), multiCoreOutput.begin( ) );
+            cmpArrays( serialOutput, multiCoreOutput );
+
+            //  In place
+            std::vector< int > serialValues( values ), multiCoreValues( values );
+            serialRunning( serialValues.begin( ), serialValues.end( ), serialValues.begin( ) );
+            multiCoreRunning( multiCoreValues.begin( ), multiCoreValues.end( ), multiCoreValues.begin( ) );
+            cmpArrays( serialValues, multiCoreValues );
+        }
+        EXPECT_EQ( serialKeyed.carry( ), multiCoreKeyed.carry( ) ) << "Where inclusive = " << inclusive;
+        EXPECT_EQ( serialRunning.carry( ), multiCoreRunning.carry( ) ) << "Where inclusive = " << inclusive;
+    }
+}
+
 int _tmain(int argc, _TCHAR* argv[])
 {
     //  Register our minidump generating logic
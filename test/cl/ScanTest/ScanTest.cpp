@@ -21,6 +21,7 @@
 #include <array>
 
 #include "bolt/cl/scan.h"
+#include "bolt/cl/scan_stream.h"
 #include "bolt/unicode.h"
 #include "bolt/miniDump.h"
 
@@ -1194,6 +1195,167 @@ INSTANTIATE_TYPED_TEST_CASE_P( Integer, ScanArrayTest, IntegerTests );
 INSTANTIATE_TYPED_TEST_CASE_P( Float, ScanArrayTest, FloatTests );
 //here
 
+//  Many tiles of the single pass scan, with a partial last tile; in place, so no tile may read another's input late
+TEST(Scan, ManyTilesExclusiveInPlace)
+{
+    const int length = 1024 * 300 + 17;
+    std::vector< int > stdInput( length );
+    for( int i = 0; i < length; ++i )
+        stdInput[ i ] = rand( ) % 10 - 4;
+    bolt::cl::device_vector< int > dvInput( stdInput.begin( ), stdInput.end( ) );
+    int init = 7;
+
+    bolt::cl::exclusive_scan( dvInput.begin( ), dvInput.end( ), dvInput.begin( ), init );
+
+    std::vector< int > stdResult( length );
+    int sum = init;
+    for( int i = 0; i < length; ++i )
+    {
+        stdResult[ i ] = sum;
+        sum += stdInput[ i ];
+    }
+    cmpArrays( stdResult, dvInput );
+}
+
+//  64 bit sums, which pass 2^32 after the first few blocks
+TEST(Scan, ULongSumsPastThirtyTwoBits)
+{
+    const int length = 1024 * 40 + 5;
+    std::vector< cl_ulong > stdInput( length );
+    for( int i = 0; i < length; ++i )
+        stdInput[ i ] = 0xFFFFFFFFull + rand( ) % 10;
+    bolt::cl::device_vector< cl_ulong > dvInput( stdInput.begin( ), stdInput.end( ) );
+
+    bolt::cl::inclusive_scan( dvInput.begin( ), dvInput.end( ), dvInput.begin( ), bolt::cl::plus< cl_ulong >( ) );
+
+    std::vector< cl_ulong > stdResult( length );
+    std::partial_sum( stdInput.begin( ), stdInput.end( ), stdResult.begin( ) );
+    cmpArrays( stdResult, dvInput );
+}
+
+//  The kernels built with 64 bit indices, on a range small enough for 32; from an offset into the vectors
+TEST(Scan, WideIndexKernels)
+{
+    const int length = 256 * 300 + 9;
+    std::vector< int > stdInput( length );
+    for( int i = 0; i < length; ++i )
+        stdInput[ i ] = rand( ) % 10 - 4;
+    bolt::cl::device_vector< int > dvInput( stdInput.begin( ), stdInput.end( ) );
+    bolt::cl::device_vector< int > dvInclusive( length + 3 );
+    bolt::cl::device_vector< int > dvExclusive( length );
+
+    bolt::cl::detail::index_force_64( true );
+    bolt::cl::inclusive_scan( dvInput.begin( ) + 1, dvInput.end( ), dvInclusive.begin( ) + 3 );
+    bolt::cl::exclusive_scan( dvInput.begin( ), dvInput.end( ), dvExclusive.begin( ), 5 );
+    bolt::cl::detail::index_force_64( false );
+
+    std::vector< int > stdInclusive( length - 1 );
+    std::partial_sum( stdInput.begin( ) + 1, stdInput.end( ), stdInclusive.begin( ) );
+    std::vector< int > stdExclusive( length );
+    int sum = 5;
+    for( int i = 0; i < length; ++i )
+    {
+        stdExclusive[ i ] = sum;
+        sum += stdInput[ i ];
+    }
+    bolt::cl::device_vector< int >::pointer inclusivePtr = dvInclusive.data( );
+    for( int i = 0; i < length - 1; ++i )
+        EXPECT_EQ( stdInclusive[ i ], inclusivePtr[ i + 3 ] ) << "Where i = " << i;
+    cmpArrays( stdExclusive, dvExclusive );
+}
+
+//  Chunks of many blocks and of one partial block, with the carry taken from one to the next on the device
+TEST(ScanStream, DeviceVectorChunksInclusive)
+{
+    const int chunkSizes[ 4 ] = { 100000, 37, 256 * 257 + 3, 1 };
+    bolt::cl::scan_stream< int > running;
+
+    int sum = 0;
+    for( int c = 0; c < 4; ++c )
+    {
+        std::vector< int > stdInput( chunkSizes[ c ] );
+        for( size_t i = 0; i < stdInput.size( ); ++i )
+            stdInput[ i ] = rand( ) % 10 - 4;
+        bolt::cl::device_vector< int > dvInput( stdInput.begin( ), stdInput.end( ) );
+        bolt::cl::device_vector< int > dvOutput( stdInput.size( ) );
+
+        running( dvInput.begin( ), dvInput.end( ), dvOutput.begin( ) );
+
+        std::vector< int > stdResult( stdInput.size( ) );
+        for( size_t i = 0; i < stdInput.size( ); ++i )
+        {
+            sum += stdInput[ i ];
+            stdResult[ i ] = sum;
+        }
+        cmpArrays( stdResult, dvOutput );
+    }
+    EXPECT_EQ( sum, running.carry( ) );
+}
+
+//  Exclusive chunks of many blocks scanned in place on the device; no block may read the value before it late
+TEST(ScanStream, DeviceVectorChunksExclusiveInPlace)
+{
+    const int chunkSizes[ 3 ] = { 256 * 391 + 5, 256, 256 * 64 };
+    const int init = -2;
+    bolt::cl::scan_stream< int > running( false, init );
+
+    int sum = init;
+    for( int c = 0; c < 3; ++c )
+    {
+        std::vector< int > stdInput( chunkSizes[ c ] );
+        for( size_t i = 0; i < stdInput.size( ); ++i )
+            stdInput[ i ] = rand( ) % 10 - 4;
+        bolt::cl::device_vector< int > dvInput( stdInput.begin( ), stdInput.end( ) );
+
+        running( dvInput.begin( ), dvInput.end( ), dvInput.begin( ) );
+
+        std::vector< int > stdResult( stdInput.size( ) );
+        for( size_t i = 0; i < stdInput.size( ); ++i )
+        {
+            stdResult[ i ] = sum;
+            sum += stdInput[ i ];
+        }
+        cmpArrays( stdResult, dvInput );
+    }
+    EXPECT_EQ( sum, running.carry( ) );
+}
+
+TEST(ScanStream, HostChunksExclusiveInPlace)
+{
+    const int init = 3;
+    bolt::cl::scan_stream< int > running( false, init );
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::SerialCpu );
+    bolt::cl::scan_stream< int > serialRunning( ctl, false, init );
+
+    int sum = init;
+    for( int c = 0; c < 3; ++c )
+    {
+        std::vector< int > stdInput( 5000 + c * 1000 );
+        for( size_t i = 0; i < stdInput.size( ); ++i )
+            stdInput[ i ] = rand( ) % 10;
+        std::vector< int > boltInput( stdInput );
+        std::vector< int > serialInput( stdInput );
+
+        running( boltInput.begin( ), boltInput.end( ), boltInput.begin( ) );
+        serialRunning( serialInput.begin( ), serialInput.end( ), serialInput.begin( ) );
+
+        std::vector< int > stdResult( stdInput.size( ) );
+        for( size_t i = 0; i < stdInput.size( ); ++i )
+        {
+            stdResult[ i ] = sum;
+            sum += stdInput[ i ];
+        }
+        cmpArrays( stdResult, boltInput );
+        cmpArrays( stdResult, serialInput );
+    }
+    EXPECT_EQ( sum, running.carry( ) );
+    EXPECT_EQ( sum, serialRunning.carry( ) );
+
+    running.reset( );
+    EXPECT_EQ( init, running.carry( ) );
+}
+
 TEST(Scan, cpuQueue)
 {
 	MyOclContext ocl = initOcl(CL_DEVICE_TYPE_CPU, 0);
@@ -0,0 +1,213 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#include "common/stdafx.h"
+#include "common/myocl.h"
+
+#include <bolt/cl/segmented_reduce.h>
+#include <bolt/cl/device_vector.h>
+#include <bolt/miniDump.h>
+#include <bolt/unicode.h>
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <algorithm>
+
+//  Offsets of segments of random lengths, some empty, over a range of length elements
+std::vector< int > randomOffsets( int length, int maxSegment )
+{
+    std::vector< int > offsets;
+    int offset = rand( ) % 5;
+    while( offset <= length )
+    {
+        offsets.push_back( offset );
+        offset += rand( ) % maxSegment;
+    }
+    return offsets;
+}
+
+template< typename T, typename BinaryFunction >
+std::vector< T > referenceReduce( const std::vector< T >& input, const std::vector< int >& offsets, T init,
+                                  BinaryFunction binary_op )
+{
+    std::vector< T > ref( offsets.size( ) );
+    for( size_t s = 0; s < offsets.size( ); ++s )
+    {
+        int end = ( s + 1 < offsets.size( ) ) ? offsets[ s + 1 ] : static_cast< int >( input.size( ) );
+        T value = init;
+        for( int i = offsets[ s ]; i < end; ++i )
+            value = binary_op( value, input[ i ] );
+        ref[ s ] = value;
+    }
+    return ref;
+}
+
+TEST( SegmentedReduce, SumStdVector )
+{
+    //  Segments crossing many work group blocks, and many segments within one block
+    const int length = 300007;
+    std::vector< int > input( length );
+    for( int i = 0; i < length; ++i )
+        input[ i ] = rand( ) % 100 - 50;
+    std::vector< int > offsets = randomOffsets( length, 1000 );
+    std::vector< int > result( offsets.size( ), -1 );
+
+    std::vector< int >::iterator resultEnd = bolt::cl::segmented_reduce( input.begin( ), input.end( ),
+                                                                          offsets.begin( ), offsets.end( ),
+                                                                          result.begin( ) );
+
+    std::vector< int > ref = referenceReduce( input, offsets, 0, std::plus< int >( ) );
+    EXPECT_TRUE( resultEnd == result.end( ) );
+    for( size_t s = 0; s < ref.size( ); ++s )
+        EXPECT_EQ( ref[ s ], result[ s ] ) << _T( "Where s = " ) << s;
+}
+
+TEST( SegmentedReduce, MaximumDeviceVectorLongSegments )
+{
+    const int length = 1 << 20;
+    std::vector< float > input( length );
+    for( int i = 0; i < length; ++i )
+        input[ i ] = static_cast< float >( rand( ) );
+    std::vector< int > offsets;
+    offsets.push_back( 3 );
+    offsets.push_back( 100000 );
+    offsets.push_back( 100000 );
+    offsets.push_back( 700001 );
+    bolt::cl::device_vector< float > dvInput( input.begin( ), input.end( ) );
+    bolt::cl::device_vector< int > dvOffsets( offsets.begin( ), offsets.end( ) );
+    bolt::cl::device_vector< float > dvResult( offsets.size( ) );
+
+    bolt::cl::segmented_reduce( dvInput.begin( ), dvInput.end( ), dvOffsets.begin( ), dvOffsets.end( ),
+                                dvResult.begin( ), -1.0f, bolt::cl::maximum< float >( ) );
+
+    std::vector< float > ref = referenceReduce( input, offsets, -1.0f, bolt::cl::maximum< float >( ) );
+    for( size_t s = 0; s < ref.size( ); ++s )
+        EXPECT_FLOAT_EQ( ref[ s ], dvResult[ s ] ) << _T( "Where s = " ) << s;
+}
+
+//  The kernels built with 64 bit indices, on a range small enough for 32
+TEST( SegmentedReduce, WideIndexKernels )
+{
+    const int length = 100003;
+    std::vector< int > input( length );
+    for( int i = 0; i < length; ++i )
+        input[ i ] = rand( ) % 100 - 50;
+    std::vector< int > offsets = randomOffsets( length, 700 );
+    bolt::cl::device_vector< int > dvInput( input.begin( ), input.end( ) );
+    bolt::cl::device_vector< int > dvOffsets( offsets.begin( ), offsets.end( ) );
+    bolt::cl::device_vector< int > dvResult( offsets.size( ) );
+
+    bolt::cl::detail::index_force_64( true );
+    bolt::cl::segmented_reduce( dvInput.begin( ), dvInput.end( ), dvOffsets.begin( ), dvOffsets.end( ),
+                                dvResult.begin( ) );
+    bolt::cl::detail::index_force_64( false );
+
+    std::vector< int > ref = referenceReduce( input, offsets, 0, std::plus< int >( ) );
+    for( size_t s = 0; s < ref.size( ); ++s )
+        EXPECT_EQ( ref[ s ], dvResult[ s ] ) << _T( "Where s = " ) << s;
+}
+
+TEST( SegmentedReduce, DescendingOffsetsThrow )
+{
+    std::vector< int > input( 100, 1 );
+    std::vector< int > offsets( 2 );
+    offsets[ 0 ] = 50;
+    offsets[ 1 ] = 10;
+    std::vector< int > result( 2 );
+
+    EXPECT_THROW( bolt::cl::segmented_reduce( input.begin( ), input.end( ), offsets.begin( ), offsets.end( ),
+                                              result.begin( ) ), ::cl::Error );
+}
+
+TEST( SegmentedReduceSerialCpu, Sum )
+{
+    const int length = 10000;
+    std::vector< int > input( length );
+    for( int i = 0; i < length; ++i )
+        input[ i ] = rand( ) % 10;
+    std::vector< int > offsets = randomOffsets( length, 300 );
+    std::vector< int > result( offsets.size( ) );
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::SerialCpu );
+    bolt::cl::segmented_reduce( ctl, input.begin( ), input.end( ), offsets.begin( ), offsets.end( ), result.begin( ),
+                                7, bolt::cl::plus< int >( ) );
+
+    std::vector< int > ref = referenceReduce( input, offsets, 7, std::plus< int >( ) );
+    EXPECT_TRUE( ref == result );
+}
+
+#if defined( ENABLE_TBB )
+TEST( SegmentedReduceMultiCore, MinimumDeviceVector )
+{
+    const int length = 500001;
+    std::vector< int > input( length );
+    for( int i = 0; i < length; ++i )
+        input[ i ] = rand( );
+    std::vector< int > offsets = randomOffsets( length, 64 );
+    bolt::cl::device_vector< int > dvInput( input.begin( ), input.end( ) );
+    bolt::cl::device_vector< int > dvResult( offsets.size( ) );
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+    bolt::cl::segmented_reduce( ctl, dvInput.begin( ), dvInput.end( ), offsets.begin( ), offsets.end( ),
+                                dvResult.begin( ), RAND_MAX, bolt::cl::minimum< int >( ) );
+
+    std::vector< int > ref = referenceReduce( input, offsets, static_cast< int >( RAND_MAX ),
+                                              bolt::cl::minimum< int >( ) );
+    for( size_t s = 0; s < ref.size( ); ++s )
+        EXPECT_EQ( ref[ s ], dvResult[ s ] ) << _T( "Where s = " ) << s;
+}
+#endif
+
+int main(int argc, char* argv[])
+{
+    ::testing::InitGoogleTest( &argc, &argv[ 0 ] );
+
+    //  Register our minidump generating logic
+    bolt::miniDumpSingleton::enableMiniDumps( );
+
+    int retVal = RUN_ALL_TESTS( );
+
+    //  Reflection code to inspect how many tests failed in gTest
+    ::testing::UnitTest& unitTest = *::testing::UnitTest::GetInstance( );
+
+    unsigned int failedTests = 0;
+    for( int i = 0; i < unitTest.total_test_case_count( ); ++i )
+    {
+        const ::testing::TestCase& testCase = *unitTest.GetTestCase( i );
+        for( int j = 0; j < testCase.total_test_count( ); ++j )
+        {
+            const ::testing::TestInfo& testInfo = *testCase.GetTestInfo( j );
+            if( testInfo.result( )->Failed( ) )
+                ++failedTests;
+        }
+    }
+
+    //  Print helpful message at termination if we detect errors, to help users figure out what to do next
+    if( failedTests )
+    {
+        bolt::tout << _T( "\nFailed tests detected in test pass; please run test again with:" ) << std::endl;
+        bolt::tout << _T( "\t--gtest_filter=<XXX> to select a specific failing test of interest" ) << std::endl;
+        bolt::tout << _T( "\t--gtest_catch_exceptions=0 to generate minidump of failing test, or" ) << std::endl;
+        bolt::tout << _T( "\t--gtest_break_on_failure to debug interactively with debugger" ) << std::endl;
+        bolt::tout << _T( "\t    (only on googletest assertion failures, not SEH exceptions)" ) << std::endl;
+    }
+    std::cout << "Test Completed. Press Enter to exit.\n .... ";
+    getchar();
+    return retVal;
+}
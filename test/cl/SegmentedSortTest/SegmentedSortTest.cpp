@@ -0,0 +1,235 @@
+/***************************************************************************
+*   Copyright 2012 - 2013 Advanced Micro Devices, Inc.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#include "common/stdafx.h"
+#include "common/myocl.h"
+
+#include <bolt/cl/segmented_sort.h>
+#include <bolt/cl/device_vector.h>
+#include <bolt/miniDump.h>
+#include <bolt/unicode.h>
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <algorithm>
+
+//  Offsets of numSegments segments of random lengths below maxLength, some of them empty
+std::vector< int > randomOffsets( int numSegments, int maxLength, int& length )
+{
+    std::vector< int > offsets( numSegments );
+    length = 0;
+    for( int s = 0; s < numSegments; ++s )
+    {
+        offsets[ s ] = length;
+        length += rand( ) % maxLength;
+    }
+    return offsets;
+}
+
+//  The reference: every segment of ref sorted with std::sort
+template< typename T, typename StrictWeakOrdering >
+void referenceSegmentedSort( std::vector< T >& ref, const std::vector< int >& offsets, StrictWeakOrdering comp )
+{
+    for( size_t s = 0; s < offsets.size( ); ++s )
+    {
+        int end = ( s + 1 < offsets.size( ) ) ? offsets[ s + 1 ] : static_cast< int >( ref.size( ) );
+        std::sort( ref.begin( ) + offsets[ s ], ref.begin( ) + end, comp );
+    }
+}
+
+TEST( SegmentedSort, ManySmallSegments )
+{
+    int length = 0;
+    std::vector< int > offsets = randomOffsets( 5000, 40, length );
+    std::vector< int > input( length );
+    for( int i = 0; i < length; ++i )
+        input[ i ] = rand( );
+    std::vector< int > ref( input );
+
+    bolt::cl::segmented_sort( input.begin( ), input.end( ), offsets.begin( ), offsets.end( ) );
+    referenceSegmentedSort( ref, offsets, std::less< int >( ) );
+
+    for( int i = 0; i < length; ++i )
+        EXPECT_EQ( ref[ i ], input[ i ] ) << _T( "Where i = " ) << i;
+}
+
+TEST( SegmentedSort, LargeSegmentDeviceVectorSubRange )
+{
+    //  Small segments on both sides of one that is sorted by the regular device sort
+    const int offset = 13;
+    std::vector< int > offsets;
+    offsets.push_back( 0 );
+    offsets.push_back( 300 );
+    offsets.push_back( 301 );
+    offsets.push_back( 301 );
+    offsets.push_back( 20301 );
+    offsets.push_back( 20400 );
+    const int length = 21000;
+
+    std::vector< float > input( length + 2 * offset );
+    for( size_t i = 0; i < input.size( ); ++i )
+        input[ i ] = static_cast< float >( rand( ) % 1000 ) / 10.0f;
+    bolt::cl::device_vector< float > dvInput( input.begin( ), input.end( ) );
+
+    bolt::cl::segmented_sort( dvInput.begin( ) + offset, dvInput.end( ) - offset, offsets.begin( ), offsets.end( ),
+                              bolt::cl::greater< float >( ) );
+
+    std::vector< float > ref( input.begin( ) + offset, input.end( ) - offset );
+    referenceSegmentedSort( ref, offsets, std::greater< float >( ) );
+
+    for( int i = 0; i < length + 2 * offset; ++i )
+    {
+        bool inRange = ( i >= offset ) && ( i < length + offset );
+        EXPECT_FLOAT_EQ( inRange ? ref[ i - offset ] : input[ i ], dvInput[ i ] ) << _T( "Where i = " ) << i;
+    }
+}
+
+TEST( SegmentedSort, FirstOffsetPastZero )
+{
+    //  The elements before the first offset form a segment of their own
+    int input[ 10 ] = { 5, 2, 9, 7, 1, 3, 8, 6, 0, 4 };
+    int expected[ 10 ] = { 2, 5, 7, 9, 0, 1, 3, 4, 6, 8 };
+    int offsets[ 1 ] = { 4 };
+
+    bolt::cl::segmented_sort( input, input + 10, offsets, offsets + 1 );
+
+    for( int i = 0; i < 10; ++i )
+        EXPECT_EQ( expected[ i ], input[ i ] ) << _T( "Where i = " ) << i;
+}
+
+TEST( SegmentedSort, OffsetsOutOfOrder )
+{
+    std::vector< int > input( 100, 1 );
+    int offsets[ 3 ] = { 0, 50, 20 };
+
+    EXPECT_THROW( bolt::cl::segmented_sort( input.begin( ), input.end( ), offsets, offsets + 3 ), ::cl::Error );
+}
+
+TEST( SegmentedSortByKey, DeviceVector )
+{
+    int length = 0;
+    std::vector< int > offsets = randomOffsets( 3000, 70, length );
+    offsets.push_back( length );
+    length += 5000;
+
+    std::vector< int > keys( length ), values( length );
+    for( int i = 0; i < length; ++i )
+    {
+        keys[ i ] = rand( ) % 100000;
+        values[ i ] = 3 * keys[ i ];
+    }
+    bolt::cl::device_vector< int > dvKeys( keys.begin( ), keys.end( ) );
+    bolt::cl::device_vector< int > dvValues( values.begin( ), values.end( ) );
+    bolt::cl::device_vector< int > dvOffsets( offsets.begin( ), offsets.end( ) );
+
+    bolt::cl::segmented_sort_by_key( dvKeys.begin( ), dvKeys.end( ), dvValues.begin( ), dvOffsets.begin( ),
+                                     dvOffsets.end( ) );
+    referenceSegmentedSort( keys, offsets, std::less< int >( ) );
+
+    for( int i = 0; i < length; ++i )
+    {
+        EXPECT_EQ( keys[ i ], dvKeys[ i ] ) << _T( "Where i = " ) << i;
+        EXPECT_EQ( 3 * keys[ i ], dvValues[ i ] ) << _T( "Where i = " ) << i;
+    }
+}
+
+TEST( SegmentedSortSerialCpu, SortByKey )
+{
+    int length = 0;
+    std::vector< int > offsets = randomOffsets( 1000, 50, length );
+    std::vector< int > keys( length ), values( length );
+    for( int i = 0; i < length; ++i )
+    {
+        keys[ i ] = rand( ) % 1000;
+        values[ i ] = 3 * keys[ i ];
+    }
+    std::vector< int > ref( keys );
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::SerialCpu );
+    bolt::cl::segmented_sort_by_key( ctl, keys.begin( ), keys.end( ), values.begin( ), offsets.begin( ),
+                                     offsets.end( ), bolt::cl::greater< int >( ) );
+    referenceSegmentedSort( ref, offsets, std::greater< int >( ) );
+
+    for( int i = 0; i < length; ++i )
+    {
+        EXPECT_EQ( ref[ i ], keys[ i ] ) << _T( "Where i = " ) << i;
+        EXPECT_EQ( 3 * keys[ i ], values[ i ] ) << _T( "Where i = " ) << i;
+    }
+}
+
+#if defined( ENABLE_TBB )
+TEST( SegmentedSortMultiCore, SmallAndLargeSegments )
+{
+    //  Many short segments shared out among the workers, and one long enough for the parallel sort
+    int length = 0;
+    std::vector< int > offsets = randomOffsets( 4000, 30, length );
+    offsets.push_back( length );
+    length += 3 * SEGMENTED_SORT_CPU_LARGE;
+
+    std::vector< int > input( length );
+    for( int i = 0; i < length; ++i )
+        input[ i ] = rand( );
+    bolt::cl::device_vector< int > dvInput( input.begin( ), input.end( ) );
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+    bolt::cl::segmented_sort( ctl, dvInput.begin( ), dvInput.end( ), offsets.begin( ), offsets.end( ) );
+    referenceSegmentedSort( input, offsets, std::less< int >( ) );
+
+    for( int i = 0; i < length; ++i )
+        EXPECT_EQ( input[ i ], dvInput[ i ] ) << _T( "Where i = " ) << i;
+}
+#endif
+
+int main(int argc, char* argv[])
+{
+    ::testing::InitGoogleTest( &argc, &argv[ 0 ] );
+
+    //  Register our minidump generating logic
+    bolt::miniDumpSingleton::enableMiniDumps( );
+
+    int retVal = RUN_ALL_TESTS( );
+
+    //  Reflection code to inspect how many tests failed in gTest
+    ::testing::UnitTest& unitTest = *::testing::UnitTest::GetInstance( );
+
+    unsigned int failedTests = 0;
+    for( int i = 0; i < unitTest.total_test_case_count( ); ++i )
+    {
+        const ::testing::TestCase& testCase = *unitTest.GetTestCase( i );
+        for( int j = 0; j < testCase.total_test_count( ); ++j )
+        {
+            const ::testing::TestInfo& testInfo = *testCase.GetTestInfo( j );
+            if( testInfo.result( )->Failed( ) )
+                ++failedTests;
+        }
+    }
+
+    //  Print helpful message at termination if we detect errors, to help users figure out what to do next
+    if( failedTests )
+    {
+        bolt::tout << _T( "\nFailed tests detected in test pass; please run test again with:" ) << std::endl;
+        bolt::tout << _T( "\t--gtest_filter=<XXX> to select a specific failing test of interest" ) << std::endl;
+        bolt::tout << _T( "\t--gtest_catch_exceptions=0 to generate minidump of failing test, or" ) << std::endl;
+        bolt::tout << _T( "\t--gtest_break_on_failure to debug interactively with debugger" ) << std::endl;
+        bolt::tout << _T( "\t    (only on googletest assertion failures, not SEH exceptions)" ) << std::endl;
+    }
+    std::cout << "Test Completed. Press Enter to exit.\n .... ";
+    getchar();
+    return retVal;
+}
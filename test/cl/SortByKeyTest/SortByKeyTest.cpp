@@ -854,6 +854,258 @@ TEST_P( SortDoubleNakedPointer, Inplace )
     cmpArrays( stdKeys, boltKeys, endIndex );
 }
 #endif
+//  Keys with many duplicates, so that the values show whether the sort kept equal keys in order
+class SortByKeyRadixVector: public ::testing::TestWithParam< int >
+{
+public:
+    SortByKeyRadixVector( ): stdPairs( GetParam( ) ), boltKeys( GetParam( ) ), boltValues( GetParam( ) )
+    {
+        for( int i = 0; i < GetParam( ); ++i )
+        {
+            stdPairs[ i ].first = ( rand( ) % 201 ) - 100;
+            stdPairs[ i ].second = i;
+            boltKeys[ i ] = stdPairs[ i ].first;
+            boltValues[ i ] = stdPairs[ i ].second;
+        }
+    }
+
+    static bool lessKey( const std::pair< int, int >& lhs, const std::pair< int, int >& rhs )
+    {
+        return lhs.first < rhs.first;
+    }
+    static bool greaterKey( const std::pair< int, int >& lhs, const std::pair< int, int >& rhs )
+    {
+        return lhs.first > rhs.first;
+    }
+
+    void cmpPairs( const std::vector< int >& keys, const std::vector< int >& values, size_t offset = 0 )
+    {
+        for( size_t i = 0; i < stdPairs.size( ); ++i )
+        {
+            EXPECT_EQ( stdPairs[ i ].first, keys[ offset + i ] ) << _T( "Where i = " ) << i;
+            EXPECT_EQ( stdPairs[ i ].second, values[ offset + i ] ) << _T( "Where i = " ) << i;
+        }
+    }
+
+protected:
+    std::vector< std::pair< int, int > > stdPairs;
+    std::vector< int > boltKeys, boltValues;
+};
+
+TEST_P( SortByKeyRadixVector, LessFunction )
+{
+    std::stable_sort( stdPairs.begin( ), stdPairs.end( ), lessKey );
+    bolt::cl::sort_by_key( boltKeys.begin( ), boltKeys.end( ), boltValues.begin( ), bolt::cl::less< int >( ) );
+
+    cmpPairs( boltKeys, boltValues );
+}
+
+TEST_P( SortByKeyRadixVector, GreaterFunction )
+{
+    std::stable_sort( stdPairs.begin( ), stdPairs.end( ), greaterKey );
+    bolt::cl::sort_by_key( boltKeys.begin( ), boltKeys.end( ), boltValues.begin( ), bolt::cl::greater< int >( ) );
+
+    cmpPairs( boltKeys, boltValues );
+}
+
+TEST_P( SortByKeyRadixVector, DeviceVectorSubRange )
+{
+    //  Sort only the middle of the buffers, starting at different offsets for keys and values
+    std::vector< int > keys( boltKeys.size( ) + 7, 1000 ), values( boltValues.size( ) + 5, 1000 );
+    std::copy( boltKeys.begin( ), boltKeys.end( ), keys.begin( ) + 3 );
+    std::copy( boltValues.begin( ), boltValues.end( ), values.begin( ) + 1 );
+    bolt::cl::device_vector< int > dvKeys( keys.begin( ), keys.end( ) );
+    bolt::cl::device_vector< int > dvValues( values.begin( ), values.end( ) );
+
+    std::stable_sort( stdPairs.begin( ), stdPairs.end( ), lessKey );
+    bolt::cl::sort_by_key( dvKeys.begin( ) + 3, dvKeys.begin( ) + 3 + boltKeys.size( ), dvValues.begin( ) + 1 );
+
+    std::vector< int > sortedKeys( dvKeys.begin( ), dvKeys.end( ) );
+    std::vector< int > sortedValues( dvValues.begin( ), dvValues.end( ) );
+    EXPECT_EQ( 1000, sortedKeys[ 0 ] );
+    EXPECT_EQ( 1000, sortedKeys[ sortedKeys.size( ) - 1 ] );
+    EXPECT_EQ( 1000, sortedValues[ 0 ] );
+    EXPECT_EQ( 1000, sortedValues[ sortedValues.size( ) - 1 ] );
+    for( size_t i = 0; i < stdPairs.size( ); ++i )
+    {
+        EXPECT_EQ( stdPairs[ i ].first, sortedKeys[ 3 + i ] ) << _T( "Where i = " ) << i;
+        EXPECT_EQ( stdPairs[ i ].second, sortedValues[ 1 + i ] ) << _T( "Where i = " ) << i;
+    }
+}
+
+TEST( SortByKeyRadix, FloatKeysDoubleValues )
+{
+    //  Not a power of 2, and more than one radix tile
+    const int length = 70001;
+    std::vector< std::pair< float, double > > stdPairs( length );
+    std::vector< float > boltKeys( length );
+    std::vector< double > boltValues( length );
+    for( int i = 0; i < length; ++i )
+    {
+        stdPairs[ i ].first = static_cast< float >( ( rand( ) % 2001 ) - 1000 ) / 8.0f;
+        stdPairs[ i ].second = i * 0.5;
+        boltKeys[ i ] = stdPairs[ i ].first;
+        boltValues[ i ] = stdPairs[ i ].second;
+    }
+
+    std::stable_sort( stdPairs.begin( ), stdPairs.end( ), std::less< std::pair< float, double > >( ) );
+    bolt::cl::sort_by_key( boltKeys.begin( ), boltKeys.end( ), boltValues.begin( ) );
+
+    for( int i = 0; i < length; ++i )
+    {
+        EXPECT_FLOAT_EQ( stdPairs[ i ].first, boltKeys[ i ] ) << _T( "Where i = " ) << i;
+        EXPECT_DOUBLE_EQ( stdPairs[ i ].second, boltValues[ i ] ) << _T( "Where i = " ) << i;
+    }
+}
+
+//  Orders ints by their last three decimal digits only, so the radix sort cannot be used
+BOLT_FUNCTOR(lessLastDigits,
+struct lessLastDigits
+{
+    bool operator()(const int &lhs, const int &rhs) const
+    {
+        return (lhs % 1000) < (rhs % 1000);
+    }
+};
+);
+
+TEST( SortByKeyBitonic, CustomComparatorOddLength )
+{
+    //  Long enough that the widest passes of the network do not fit in one work group's tile
+    const int length = 100003;
+    std::vector< int > keys( length ), values( length );
+    for( int i = 0; i < length; ++i )
+    {
+        keys[ i ] = rand( ) % 100000;
+        values[ i ] = 3 * keys[ i ];
+    }
+    std::vector< int > stdKeys( keys );
+
+    bolt::cl::sort_by_key( keys.begin( ), keys.end( ), values.begin( ), lessLastDigits( ) );
+
+    //  Equal keys may come out in any order, but every value must stay with its key
+    for( int i = 0; i < length; ++i )
+    {
+        EXPECT_EQ( 3 * keys[ i ], values[ i ] ) << _T( "Where i = " ) << i;
+        if( i > 0 )
+            EXPECT_LE( keys[ i - 1 ] % 1000, keys[ i ] % 1000 ) << _T( "Where i = " ) << i;
+    }
+    std::sort( stdKeys.begin( ), stdKeys.end( ) );
+    std::sort( keys.begin( ), keys.end( ) );
+    EXPECT_TRUE( stdKeys == keys );
+}
+
+//  Checks that keys are ordered by lessLastDigits, that every value is still 3 times its key, and that no key was lost
+::testing::AssertionResult checkLastDigitsByKey( std::vector< int > refKeys, std::vector< int > keys,
+                                                 const std::vector< int >& values )
+{
+    for( size_t i = 0; i < keys.size( ); ++i )
+    {
+        EXPECT_EQ( 3 * keys[ i ], values[ i ] ) << _T( "Where i = " ) << i;
+        if( i > 0 )
+            EXPECT_LE( keys[ i - 1 ] % 1000, keys[ i ] % 1000 ) << _T( "Where i = " ) << i;
+    }
+    std::sort( refKeys.begin( ), refKeys.end( ) );
+    std::sort( keys.begin( ), keys.end( ) );
+    EXPECT_TRUE( refKeys == keys );
+
+    return ::testing::AssertionSuccess( );
+}
+
+TEST( SortByKeySerialCpu, StdVector )
+{
+    const int length = 20001;
+    std::vector< int > keys( length ), values( length );
+    for( int i = 0; i < length; ++i )
+    {
+        keys[ i ] = rand( ) % 100000;
+        values[ i ] = 3 * keys[ i ];
+    }
+    std::vector< int > refKeys( keys );
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::SerialCpu );
+    bolt::cl::sort_by_key( ctl, keys.begin( ), keys.end( ), values.begin( ), lessLastDigits( ) );
+
+    checkLastDigitsByKey( refKeys, keys, values );
+}
+
+TEST( SortByKeySerialCpu, DeviceVectorSubRange )
+{
+    const int length = 20001;
+    const int offset = 17;
+    std::vector< int > keys( length ), values( length );
+    for( int i = 0; i < length; ++i )
+    {
+        keys[ i ] = rand( ) % 100000;
+        values[ i ] = 3 * keys[ i ];
+    }
+    bolt::cl::device_vector< int > dvKeys( keys.begin( ), keys.end( ) );
+    bolt::cl::device_vector< int > dvValues( values.begin( ), values.end( ) );
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::SerialCpu );
+    bolt::cl::sort_by_key( ctl, dvKeys.begin( ) + offset, dvKeys.end( ) - offset, dvValues.begin( ) + offset,
+                           bolt::cl::greater< int >( ) );
+
+    std::vector< std::pair< int, int > > refPairs( length - 2 * offset );
+    for( int i = offset; i < length - offset; ++i )
+        refPairs[ i - offset ] = std::make_pair( keys[ i ], values[ i ] );
+    std::sort( refPairs.begin( ), refPairs.end( ), std::greater< std::pair< int, int > >( ) );
+
+    for( int i = 0; i < length; ++i )
+    {
+        bool inRange = ( i >= offset ) && ( i < length - offset );
+        EXPECT_EQ( inRange ? refPairs[ i - offset ].first : keys[ i ], dvKeys[ i ] ) << _T( "Where i = " ) << i;
+        EXPECT_EQ( 3 * dvKeys[ i ], dvValues[ i ] ) << _T( "Where i = " ) << i;
+    }
+}
+
+#if defined( ENABLE_TBB )
+TEST( SortByKeyMultiCore, StdVector )
+{
+    //  Several grains of the parallel zip and sort
+    const int length = 100003;
+    std::vector< int > keys( length ), values( length );
+    for( int i = 0; i < length; ++i )
+    {
+        keys[ i ] = rand( ) % 100000;
+        values[ i ] = 3 * keys[ i ];
+    }
+    std::vector< int > refKeys( keys );
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+    bolt::cl::sort_by_key( ctl, keys.begin( ), keys.end( ), values.begin( ), lessLastDigits( ) );
+
+    checkLastDigitsByKey( refKeys, keys, values );
+}
+
+TEST( SortByKeyMultiCore, DeviceVector )
+{
+    const int length = 100003;
+    std::vector< int > keys( length ), values( length );
+    for( int i = 0; i < length; ++i )
+    {
+        keys[ i ] = rand( ) % 100000;
+        values[ i ] = 3 * keys[ i ];
+    }
+    bolt::cl::device_vector< int > dvKeys( keys.begin( ), keys.end( ) );
+    bolt::cl::device_vector< int > dvValues( values.begin( ), values.end( ) );
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+    bolt::cl::sort_by_key( ctl, dvKeys.begin( ), dvKeys.end( ), dvValues.begin( ) );
+    std::sort( keys.begin( ), keys.end( ) );
+
+    for( int i = 0; i < length; ++i )
+    {
+        EXPECT_EQ( keys[ i ], dvKeys[ i ] ) << _T( "Where i = " ) << i;
+        EXPECT_EQ( 3 * keys[ i ], dvValues[ i ] ) << _T( "Where i = " ) << i;
+    }
+}
+#endif
+
 std::array<int, 15> TestValues = {2,4,8,16,32,64,128,256,512,1024,2048,4096,8192,16384,32768};
 
 //Test lots of consecutive numbers, but small range, suitable for integers because they overflow easier
@@ -881,6 +1133,8 @@ INSTANTIATE_TEST_CASE_P( SortValues, SortFloatNakedPointer, ::testing::ValuesIn(
 //INSTANTIATE_TEST_CASE_P( SortRange, SortDoubleNakedPointer, ::testing::Range( 0, 1024, 13) );
 INSTANTIATE_TEST_CASE_P( Sort, SortDoubleNakedPointer, ::testing::ValuesIn( TestValues.begin(), TestValues.end() ) );
 #endif
+INSTANTIATE_TEST_CASE_P( SortRange, SortByKeyRadixVector, ::testing::Range( 1, 2000, 97 ) );
+INSTANTIATE_TEST_CASE_P( SortValues, SortByKeyRadixVector, ::testing::ValuesIn( TestValues.begin(), TestValues.end() ) );
 /*
 typedef ::testing::Types<
     std::tuple< int, TypeValue< 1 > >,
@@ -1082,6 +1082,103 @@ INSTANTIATE_TYPED_TEST_CASE_P( Double, SortArrayTest, DoubleTests );
 REGISTER_TYPED_TEST_CASE_P( SortUDDArrayTest,  Normal);
 INSTANTIATE_TYPED_TEST_CASE_P( UDDTest, SortUDDArrayTest, UDDTests );
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Keys that are radix sorted when the comparator is bolt::cl::less or bolt::cl::greater
+template< typename T >
+T radixTestValue( )
+{
+    //  Wraps around into negative values for the signed types
+    cl_ulong bits = ( static_cast< cl_ulong >( rand( ) ) << 42 ) ^ ( static_cast< cl_ulong >( rand( ) ) << 21 ) ^ rand( );
+    return static_cast< T >( bits );
+}
+
+template< >
+float radixTestValue< float >( )
+{
+    return ( rand( ) - RAND_MAX / 2 ) / 7.0f;
+}
+
+template< >
+double radixTestValue< double >( )
+{
+    return ( rand( ) - RAND_MAX / 2 ) / 7.0 + rand( ) * 1.0e-9;
+}
+
+template< typename T >
+class SortRadixKeyTest: public ::testing::Test
+{
+public:
+    //  Not a multiple of the 256 keys a radix work group handles
+    SortRadixKeyTest( ): stdInput( 65536 + 77 )
+    {
+        std::generate( stdInput.begin( ), stdInput.end( ), radixTestValue< T > );
+    }
+
+protected:
+    std::vector< T > stdInput;
+};
+
+typedef ::testing::Types< cl_char, cl_uchar, cl_short, cl_ushort, cl_long, cl_ulong, float
+#if (TEST_DOUBLE == 1)
+    , double
+#endif
+> RadixKeyTypes;
+
+TYPED_TEST_CASE( SortRadixKeyTest, RadixKeyTypes );
+
+TYPED_TEST( SortRadixKeyTest, AscendingVector )
+{
+    std::vector< TypeParam > boltInput( this->stdInput );
+    std::sort( this->stdInput.begin( ), this->stdInput.end( ) );
+    bolt::cl::sort( boltInput.begin( ), boltInput.end( ) );
+
+    cmpArrays( this->stdInput, boltInput );
+}
+
+TYPED_TEST( SortRadixKeyTest, DescendingVector )
+{
+    std::vector< TypeParam > boltInput( this->stdInput );
+    std::sort( this->stdInput.begin( ), this->stdInput.end( ), std::greater< TypeParam >( ) );
+    bolt::cl::sort( boltInput.begin( ), boltInput.end( ), bolt::cl::greater< TypeParam >( ) );
+
+    cmpArrays( this->stdInput, boltInput );
+}
+
+//  A range that starts inside its device_vector, and leaves the elements around it alone
+TYPED_TEST( SortRadixKeyTest, DeviceVectorSubRange )
+{
+    bolt::cl::device_vector< TypeParam > boltInput( this->stdInput.begin( ), this->stdInput.end( ) );
+    std::sort( this->stdInput.begin( ) + 13, this->stdInput.end( ) - 5 );
+    bolt::cl::sort( boltInput.begin( ) + 13, boltInput.end( ) - 5 );
+
+    cmpArrays( this->stdInput, boltInput );
+}
+
+//  Only the low digit of these keys varies, so every other radix pass is skipped
+TEST( SortRadixKey, ConstantHighDigits )
+{
+    std::vector< cl_ulong > stdInput( 100000 );
+    for( size_t i = 0; i < stdInput.size( ); ++i )
+        stdInput[ i ] = 0x0123456789AB0000ULL + ( rand( ) & 0xFF );
+    std::vector< cl_ulong > boltInput( stdInput );
+
+    std::sort( stdInput.begin( ), stdInput.end( ) );
+    bolt::cl::sort( boltInput.begin( ), boltInput.end( ) );
+
+    cmpArrays( stdInput, boltInput );
+}
+
+//  Every pass is skipped; the keys must come back untouched
+TEST( SortRadixKey, AllKeysEqual )
+{
+    std::vector< unsigned int > stdInput( 4097, 42 );
+    bolt::cl::device_vector< unsigned int > boltInput( stdInput.begin( ), stdInput.end( ) );
+
+    bolt::cl::sort( boltInput.begin( ), boltInput.end( ), bolt::cl::greater< unsigned int >( ) );
+
+    cmpArrays( stdInput, boltInput );
+}
+
 class withStdVect: public ::testing::TestWithParam<int>{
 protected:
 	int sizeOfInputBuffer;
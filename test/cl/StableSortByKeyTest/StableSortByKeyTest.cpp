@@ -239,6 +239,106 @@ TEST(SortUDD, GPUAddDouble4)
     cmpArrays(refInput, input);
 }
 
+// Unsigned keys with many duplicates, so that the order of the values shows whether the sort is stable
+bool lessKeyD4( const std::pair< unsigned int, uddtD4 >& lhs, const std::pair< unsigned int, uddtD4 >& rhs )
+{
+    return lhs.first < rhs.first;
+}
+
+TEST(StableSortByKeyRadix, UDDValues)
+{
+    //setup containers
+    int length = 3001;
+    std::vector< unsigned int > keys( length );
+    std::vector< uddtD4 > values( length );
+    std::vector< std::pair< unsigned int, uddtD4 > > refPairs( length );
+    for( int i = 0; i < length; ++i )
+    {
+        uddtD4 value = { 1.0 * i, 2.0 * i, 3.0 * i, 4.0 * i };
+        keys[ i ] = ( rand( ) % 17 ) << 20;
+        values[ i ] = value;
+        refPairs[ i ] = std::make_pair( keys[ i ], value );
+    }
+    bolt::cl::device_vector< unsigned int > dvKeys( keys.begin( ), keys.end( ) );
+    bolt::cl::device_vector< uddtD4 > dvValues( values.begin( ), values.end( ) );
+
+    // call sort
+    bolt::cl::stable_sort_by_key( dvKeys.begin( ), dvKeys.end( ), dvValues.begin( ) );
+    std::stable_sort( refPairs.begin( ), refPairs.end( ), lessKeyD4 );
+
+    // compare results
+    for( int i = 0; i < length; ++i )
+    {
+        EXPECT_EQ( refPairs[ i ].first, dvKeys[ i ] ) << _T( "Where i = " ) << i;
+        EXPECT_EQ( refPairs[ i ].second, dvValues[ i ] ) << _T( "Where i = " ) << i;
+    }
+}
+
+#if defined( ENABLE_TBB )
+bool lessKeyInt( const std::pair< int, int >& lhs, const std::pair< int, int >& rhs )
+{
+    return lhs.first < rhs.first;
+}
+
+bool greaterKeyInt( const std::pair< int, int >& lhs, const std::pair< int, int >& rhs )
+{
+    return lhs.first > rhs.first;
+}
+
+TEST(StableSortByKeyMultiCore, StdVector)
+{
+    // Several chunks of the merge sort, and a length that is not a multiple of the chunk size
+    int length = 100003;
+    std::vector< int > keys( length ), values( length );
+    std::vector< std::pair< int, int > > refPairs( length );
+    for( int i = 0; i < length; ++i )
+    {
+        keys[ i ] = rand( ) % 100;
+        values[ i ] = i;
+        refPairs[ i ] = std::make_pair( keys[ i ], values[ i ] );
+    }
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+    bolt::cl::stable_sort_by_key( ctl, keys.begin( ), keys.end( ), values.begin( ), bolt::cl::greater< int >( ) );
+    std::stable_sort( refPairs.begin( ), refPairs.end( ), greaterKeyInt );
+
+    for( int i = 0; i < length; ++i )
+    {
+        EXPECT_EQ( refPairs[ i ].first, keys[ i ] ) << _T( "Where i = " ) << i;
+        EXPECT_EQ( refPairs[ i ].second, values[ i ] ) << _T( "Where i = " ) << i;
+    }
+}
+
+TEST(StableSortByKeyMultiCore, DeviceVectorUDDValues)
+{
+    int length = 20001;
+    std::vector< int > keys( length );
+    std::vector< uddtD4 > values( length );
+    std::vector< std::pair< int, int > > refPairs( length );
+    for( int i = 0; i < length; ++i )
+    {
+        uddtD4 value = { 1.0 * i, 2.0 * i, 3.0 * i, 4.0 * i };
+        keys[ i ] = rand( ) % 100;
+        values[ i ] = value;
+        refPairs[ i ] = std::make_pair( keys[ i ], i );
+    }
+    bolt::cl::device_vector< int > dvKeys( keys.begin( ), keys.end( ) );
+    bolt::cl::device_vector< uddtD4 > dvValues( values.begin( ), values.end( ) );
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+    bolt::cl::stable_sort_by_key( ctl, dvKeys.begin( ), dvKeys.end( ), dvValues.begin( ) );
+    std::stable_sort( refPairs.begin( ), refPairs.end( ), lessKeyInt );
+
+    for( int i = 0; i < length; ++i )
+    {
+        EXPECT_EQ( refPairs[ i ].first, dvKeys[ i ] ) << _T( "Where i = " ) << i;
+        EXPECT_EQ( values[ refPairs[ i ].second ], dvValues[ i ] ) << _T( "Where i = " ) << i;
+    }
+}
+#endif
+
 TYPED_TEST_P( SortArrayTest, Normal )
 {
     typedef std::array< ArrayType, ArraySize > ArrayCont;
@@ -192,6 +192,87 @@ TEST(SortUDD, GPUAddDouble4)
     cmpArrays(refInput, input);
 }
 
+// Orders ints by their last decimal digit only, so equal keys show whether the sort kept them in order
+BOLT_FUNCTOR(lessLastDigit,
+struct lessLastDigit
+{
+    bool operator()(const int &lhs, const int &rhs) const
+    {
+        return (lhs % 10) < (rhs % 10);
+    }
+};
+);
+
+TEST(StableSortMergePath, DeviceVectorSubRange)
+{
+    // Many merge passes, a length that is not a multiple of the tile, and a range that starts inside the vector
+    int length = 100003;
+    std::vector< int > input( length + 10 ), refInput( length + 10 );
+    for( int i = 0; i < length + 10; ++i )
+        input[ i ] = refInput[ i ] = rand( );
+    bolt::cl::device_vector< int > dvInput( input.begin( ), input.end( ) );
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::OpenCL );
+    bolt::cl::stable_sort( ctl, dvInput.begin( ) + 5, dvInput.begin( ) + 5 + length, lessLastDigit( ) );
+    std::stable_sort( refInput.begin( ) + 5, refInput.begin( ) + 5 + length, lessLastDigit( ) );
+
+    cmpArrays( refInput, dvInput );
+}
+
+TEST(StableSortMergePath, UDDEqualSums)
+{
+    // Elements with equal sums compare equal under AddD4 but differ field by field
+    int length = 20001;
+    std::vector< uddtD4 > input( length ), refInput( length );
+    for( int i = 0; i < length; ++i )
+    {
+        uddtD4 value = { 1.0 * ( rand( ) % 16 ), 1.0 * i, -1.0 * i, 0.5 };
+        input[ i ] = refInput[ i ] = value;
+    }
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::OpenCL );
+    bolt::cl::stable_sort( ctl, input.begin( ), input.end( ), AddD4( ) );
+    std::stable_sort( refInput.begin( ), refInput.end( ), AddD4( ) );
+
+    cmpArrays( refInput, input );
+}
+
+#if defined( ENABLE_TBB )
+TEST(StableSortMultiCore, StdVector)
+{
+    // Several chunks of the merge sort, and a length that is not a multiple of the chunk size
+    int length = 100003;
+    std::vector< int > input( length ), refInput( length );
+    for( int i = 0; i < length; ++i )
+        input[ i ] = refInput[ i ] = rand( );
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+    bolt::cl::stable_sort( ctl, input.begin( ), input.end( ), lessLastDigit( ) );
+    std::stable_sort( refInput.begin( ), refInput.end( ), lessLastDigit( ) );
+
+    cmpArrays( refInput, input );
+}
+
+TEST(StableSortMultiCore, DeviceVectorSubRange)
+{
+    int length = 50001;
+    std::vector< int > input( length + 10 ), refInput( length + 10 );
+    for( int i = 0; i < length + 10; ++i )
+        input[ i ] = refInput[ i ] = rand( );
+    bolt::cl::device_vector< int > dvInput( input.begin( ), input.end( ) );
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+    bolt::cl::stable_sort( ctl, dvInput.begin( ) + 5, dvInput.begin( ) + 5 + length, lessLastDigit( ) );
+    std::stable_sort( refInput.begin( ) + 5, refInput.begin( ) + 5 + length, lessLastDigit( ) );
+
+    cmpArrays( refInput, dvInput );
+}
+#endif
+
 TYPED_TEST_P( SortArrayTest, Normal )
 {
     typedef std::array< ArrayType, ArraySize > ArrayCont;
@@ -27,6 +27,7 @@
 #include "common/myocl.h"
 
 #include <bolt/cl/transform_reduce.h>
+#include <bolt/cl/lazy.h>
 #include <bolt/cl/functional.h>
 #include <bolt/miniDump.h>
 
@@ -1410,6 +1411,26 @@ TEST(TransformReduce, DeviceVectorInt)
   
 } 
 
+//  The sum of squares written next to a value already on the device
+TEST(TransformReduce, IntoDeviceVector)
+{
+    const int length = 70001;
+    std::vector< int > refInput( length );
+    for( int i = 0; i < length; ++i )
+        refInput[ i ] = rand( ) % 100 - 50;
+    bolt::cl::device_vector< int > input( refInput.begin( ), refInput.end( ) );
+    bolt::cl::device_vector< int > results( 2, 42 );
+
+    bolt::cl::transform_reduce_into( input.begin( ), input.end( ), results.begin( ) + 1, bolt::cl::square< int >( ),
+        3, bolt::cl::plus< int >( ) );
+
+    int stdReduce = 3;
+    for( int i = 0; i < length; ++i )
+        stdReduce += refInput[ i ] * refInput[ i ];
+    EXPECT_EQ( 42, results[ 0 ] );
+    EXPECT_EQ( stdReduce, results[ 1 ] );
+}
+
 TEST(TransformReduce, DeviceVectorFloat)
 {
    
@@ -1535,6 +1556,123 @@ TEST (cl_outputType_transform_reduce_sq_max, epr__all_raised){
   EXPECT_EQ(9, result);
 }
 
+TEST( LazyPipeline, TransformTransformReduce )
+{
+    int length = 1<<16;
+    std::vector< int > refInput( length );
+    for( int i = 0; i < length; i++ )
+        refInput[ i ] = ( i % 17 ) - 8;
+    bolt::cl::device_vector< int > input( refInput.begin( ), refInput.end( ) );
+
+    //  negate and square are fused into the transform_reduce kernel; no intermediate vector is created
+    int boltReduce = bolt::cl::lazy::transform( input.begin( ), input.end( ), bolt::cl::negate< int >( ) )
+                   | bolt::cl::lazy::transform( bolt::cl::square< int >( ) )
+                   | bolt::cl::lazy::reduce( 0, bolt::cl::plus< int >( ) );
+
+    int stdReduce = 0;
+    for( int i = 0; i < length; i++ )
+        stdReduce += refInput[ i ] * refInput[ i ];
+
+    EXPECT_EQ( stdReduce, boltReduce );
+}
+
+TEST( LazyPipeline, RepeatedStageStdVector )
+{
+    int length = 1<<12;
+    std::vector< int > input( length );
+    for( int i = 0; i < length; i++ )
+        input[ i ] = i % 5;
+
+    //  The same functor in two stages must only be defined once in the generated kernel
+    int boltReduce = bolt::cl::lazy::transform( input.begin( ), input.end( ), bolt::cl::square< int >( ) )
+                   | bolt::cl::lazy::transform( bolt::cl::negate< int >( ) )
+                   | bolt::cl::lazy::transform( bolt::cl::square< int >( ) )
+                   | bolt::cl::lazy::reduce( 0, bolt::cl::maximum< int >( ) );
+
+    EXPECT_EQ( 256, boltReduce );
+}
+
+TEST( LazyPipeline, TransformInclusiveScan )
+{
+    int length = 1<<14;
+    std::vector< float > refInput( length, 2.0f );
+    std::vector< float > refOutput( length );
+    bolt::cl::device_vector< float > input( refInput.begin( ), refInput.end( ) );
+    bolt::cl::device_vector< float > output( length );
+
+    bolt::cl::lazy::transform( input.begin( ), input.end( ), bolt::cl::negate< float >( ) )
+        | bolt::cl::lazy::transform( bolt::cl::square< float >( ) )
+        | bolt::cl::lazy::inclusive_scan( output.begin( ), bolt::cl::plus< float >( ) );
+
+    std::transform( refInput.begin( ), refInput.end( ), refOutput.begin( ), bolt::cl::square< float >( ) );
+    std::partial_sum( refOutput.begin( ), refOutput.end( ), refOutput.begin( ) );
+
+    cmpArrays( refOutput, output );
+}
+
+TEST( LazyPipeline, SerialAndMultiCore )
+{
+    int length = 1<<16;
+    std::vector< int > input( length );
+    std::vector< int > output( length );
+    std::vector< int > refOutput( length );
+    for( int i = 0; i < length; i++ )
+        input[ i ] = i % 101;
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::SerialCpu );
+    int boltReduce = bolt::cl::lazy::transform( ctl, input.begin( ), input.end( ), bolt::cl::square< int >( ) )
+                   | bolt::cl::lazy::transform( bolt::cl::negate< int >( ) )
+                   | bolt::cl::lazy::reduce( 0, bolt::cl::plus< int >( ) );
+
+    int stdReduce = 0;
+    for( int i = 0; i < length; i++ )
+        stdReduce -= input[ i ] * input[ i ];
+    EXPECT_EQ( stdReduce, boltReduce );
+
+#if defined( ENABLE_TBB )
+    ctl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+    bolt::cl::lazy::transform( ctl, input.begin( ), input.end( ), bolt::cl::square< int >( ) )
+        | bolt::cl::lazy::transform( bolt::cl::negate< int >( ) )
+        | bolt::cl::lazy::copy( output.begin( ) );
+
+    for( int i = 0; i < length; i++ )
+        refOutput[ i ] = -input[ i ] * input[ i ];
+    cmpArrays( refOutput, output );
+#endif
+}
+
+TEST( LazyPipeline, UDDStages )
+{
+    int length = 1<<12;
+    std::vector< UDD > refInput( length );
+    for( int i = 0; i < length; i++ )
+        refInput[ i ] = UDD( i % 7 + 1 );
+    bolt::cl::device_vector< UDD > input( refInput.begin( ), refInput.end( ) );
+    bolt::cl::device_vector< UDD > output( length );
+
+    //  UDD is the argument, an intermediate and the result of the pipelines; the kernel must define it once
+    float boltReduce = bolt::cl::lazy::transform( input.begin( ), input.end( ), negateUDD( ) )
+                     | bolt::cl::lazy::transform( negateUDD( ) )
+                     | bolt::cl::lazy::transform( DivUDD( ) )
+                     | bolt::cl::lazy::reduce( 0.0f, bolt::cl::plus< float >( ) );
+
+    bolt::cl::lazy::transform( input.begin( ), input.end( ), negateUDD( ) )
+        | bolt::cl::lazy::transform( negateUDD( ) )
+        | bolt::cl::lazy::transform( negateUDD( ) )
+        | bolt::cl::lazy::copy( output.begin( ) );
+
+    float stdReduce = 0.0f;
+    std::vector< UDD > refOutput( length );
+    for( int i = 0; i < length; i++ )
+    {
+        stdReduce += DivUDD( )( refInput[ i ] );
+        refOutput[ i ] = negateUDD( )( refInput[ i ] );
+    }
+    EXPECT_NEAR( stdReduce, boltReduce, 1.0e-3f * stdReduce );
+    cmpArrays( refOutput, output );
+}
+
 int main(int argc, char* argv[])
 {
  
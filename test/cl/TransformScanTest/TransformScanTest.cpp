@@ -687,6 +687,80 @@ TEST(MultiCoreCPU, NegPlusInt)
     cmpArrays(refOutput, output);
 }
 
+TEST(CpuRunModes, DeviceVectorExclusiveAndInclusive)
+{
+    bolt::cl::negate<int> unary_op;
+    bolt::cl::plus<int> binary_op;
+    int length = (1<<16)+23;
+    int init = 7;
+
+    std::vector< int > refInput( length );
+    for( int i = 0; i < length; ++i )
+        refInput[ i ] = rand( ) % 100;
+    std::vector< int > refIntermediate( length );
+    std::vector< int > refInclusive( length );
+    std::vector< int > refExclusive( length );
+    ::std::transform(   refInput.begin(), refInput.end(),  refIntermediate.begin(), unary_op);
+    ::std::partial_sum( refIntermediate.begin(), refIntermediate.end(), refInclusive.begin(), binary_op);
+    refExclusive[ 0 ] = init;
+    for( int i = 1; i < length; ++i )
+        refExclusive[ i ] = refExclusive[ i - 1 ] + refIntermediate[ i - 1 ];
+
+    std::vector< bolt::cl::control::e_RunMode > runModes;
+    runModes.push_back( bolt::cl::control::SerialCpu );
+#if defined( ENABLE_TBB )
+    runModes.push_back( bolt::cl::control::MultiCoreCpu );
+#endif
+    for( size_t m = 0; m < runModes.size( ); ++m )
+    {
+        bolt::cl::control ctrl = bolt::cl::control::getDefault( );
+        ctrl.setForceRunMode( runModes[ m ] );
+
+        bolt::cl::device_vector< int > input( refInput.begin( ), refInput.end( ) );
+        bolt::cl::device_vector< int > output( length );
+        bolt::cl::transform_exclusive_scan( ctrl, input.begin(), input.end(), output.begin(), unary_op, init, binary_op );
+        cmpArrays(refExclusive, output);
+
+        //  In place, over the same device_vector
+        bolt::cl::transform_inclusive_scan( ctrl, input.begin(), input.end(), input.begin(), unary_op, binary_op );
+        cmpArrays(refInclusive, input);
+
+        std::vector< int > hostOutput( length );
+        bolt::cl::transform_inclusive_scan( ctrl, refInput.begin(), refInput.end(), hostOutput.begin(), unary_op, binary_op );
+        cmpArrays(refInclusive, hostOutput);
+    }
+}
+
+//  Many tiles of the single pass scan, each looking back over the ones before it; in place, with a partial last tile
+TEST(TransformScan, ManyTilesLookback)
+{
+    bolt::cl::negate<int> unary_op;
+    bolt::cl::plus<int> binary_op;
+    int length = 1024 * 500 + 37;
+    int init = -3;
+
+    std::vector< int > refInput( length );
+    for( int i = 0; i < length; ++i )
+        refInput[ i ] = rand( ) % 10 - 4;
+    std::vector< int > refInclusive( length );
+    std::vector< int > refExclusive( length );
+    int sum = 0;
+    for( int i = 0; i < length; ++i )
+    {
+        refExclusive[ i ] = init + sum;
+        sum -= refInput[ i ];
+        refInclusive[ i ] = sum;
+    }
+
+    bolt::cl::device_vector< int > input( refInput.begin( ), refInput.end( ) );
+    bolt::cl::device_vector< int > output( length );
+    bolt::cl::transform_exclusive_scan( input.begin(), input.end(), output.begin(), unary_op, init, binary_op );
+    cmpArrays(refExclusive, output);
+
+    bolt::cl::transform_inclusive_scan( input.begin(), input.end(), input.begin(), unary_op, binary_op );
+    cmpArrays(refInclusive, input);
+}
+
 int _tmain(int argc, _TCHAR* argv[])
 {
     //  Register our minidump generating logic
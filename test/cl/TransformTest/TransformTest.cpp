@@ -1388,6 +1388,30 @@ TEST( TransformDeviceVector, OutOfPlaceTransform)
 }
 
 
+//  The unary and binary kernels built with 64 bit indices
+TEST( TransformDeviceVector, WideIndexKernels )
+{
+    const int length = 100003;
+    std::vector< int > hA( length ), hB( length ), hO( length );
+    for( int i = 0; i < length; ++i )
+    {
+        hA[ i ] = rand( ) % 1000;
+        hB[ i ] = rand( ) % 1000;
+    }
+    bolt::cl::device_vector< int > dA( hA.begin( ), hA.end( ) ), dB( hB.begin( ), hB.end( ) );
+    bolt::cl::device_vector< int > dO( length, 0 ), dN( length, 0 );
+
+    bolt::cl::detail::index_force_64( true );
+    bolt::cl::transform( dA.begin( ), dA.end( ), dB.begin( ), dO.begin( ), bolt::cl::plus< int >( ) );
+    bolt::cl::transform( dA.begin( ), dA.end( ), dN.begin( ), bolt::cl::negate< int >( ) );
+    bolt::cl::detail::index_force_64( false );
+
+    std::transform( hA.begin( ), hA.end( ), hB.begin( ), hO.begin( ), std::plus< int >( ) );
+    cmpArrays( hO, dO );
+    std::transform( hA.begin( ), hA.end( ), hO.begin( ), std::negate< int >( ) );
+    cmpArrays( hO, dN );
+}
+
 int main(int argc, char* argv[])
 {
     //  Register our minidump generating logic